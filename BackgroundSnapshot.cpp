@@ -0,0 +1,307 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   BackgroundSnapshot.cpp
+//! \brief  The CBackgroundSnapshot class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "BackgroundSnapshot.hpp"
+#include "MDB.hpp"
+#include "MDBException.hpp"
+#include <WCL/IOutputStream.hpp>
+#include <process.h>
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor. The tables are captured on the calling thread and then written
+//! by the worker thread.
+
+CBackgroundSnapshot::CBackgroundSnapshot(CMDB& oMDB, WCL::IOutputStream& rStream)
+	: m_rStream(rStream)
+	, m_vTables()
+	, m_mRows()
+	, m_oValues()
+	, m_oValueStream(m_oValues)
+	, m_bFinished(false)
+	, m_bFailed(false)
+	, m_strError()
+	, m_setInserted()
+	, m_hThread(NULL)
+{
+	::InitializeCriticalSection(&m_oLock);
+
+	m_oValueStream.Create();
+
+	Capture(oMDB);
+
+	uintptr_t hThread = ::_beginthreadex(nullptr, 0, ThreadFn, this, 0, nullptr);
+
+	ASSERT(hThread != 0);
+
+	m_hThread = reinterpret_cast<HANDLE>(hThread);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. Waits for the worker, any failure is ignored.
+
+CBackgroundSnapshot::~CBackgroundSnapshot()
+{
+	Finish();
+
+	m_oValueStream.Close();
+
+	::DeleteCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the worker has finished writing.
+
+bool CBackgroundSnapshot::Finished() const
+{
+	return (m_hThread == NULL) || (::WaitForSingleObject(m_hThread, 0) == WAIT_OBJECT_0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Wait for the snapshot to be written and detach it from the tables. If the
+//! worker failed a CMDBException is thrown.
+
+void CBackgroundSnapshot::Wait()
+{
+	Finish();
+
+	if (m_bFailed)
+		throw CMDBException(CMDBException::E_BG_WRITE, m_strError);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Track a row inserted after the capture, so that it is not preserved or
+//! retained. The row status cannot be used for this as the capture leaves it
+//! alone. Only the modifying thread uses the set and so it is not locked.
+
+void CBackgroundSnapshot::InsertedRow(const CRow& oRow)
+{
+	m_setInserted.insert(&oRow);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Preserve the values of a row that is about to be modified. This is only
+//! done the first time a captured row is modified.
+
+void CBackgroundSnapshot::PreserveRow(const CRow& oRow)
+{
+	// Inserted since the capture?
+	if (m_setInserted.find(&oRow) != m_setInserted.end())
+		return;
+
+	::EnterCriticalSection(&m_oLock);
+
+	if ( (!m_bFinished) && (m_mRows.find(&oRow) == m_mRows.end()) )
+	{
+		RowImage oImage = { nullptr, m_oValues.Size(), 0 };
+
+		oRow.WriteValues(m_oValueStream);
+
+		oImage.m_nSize = m_oValues.Size() - oImage.m_nOffset;
+
+		m_mRows.insert(std::make_pair(&oRow, oImage));
+	}
+
+	::LeaveCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Take ownership of a row that is about to be deleted. If the row has already
+//! been written or preserved it is not needed and false is returned, in which
+//! case the caller must delete it.
+
+bool CBackgroundSnapshot::RetainRow(CRow& oRow)
+{
+	// Inserted since the capture? The row will be freed.
+	if (m_setInserted.erase(&oRow) != 0)
+		return false;
+
+	bool bRetained = false;
+
+	::EnterCriticalSection(&m_oLock);
+
+	if ( (!m_bFinished) && (m_mRows.find(&oRow) == m_mRows.end()) )
+	{
+		RowImage oImage = { &oRow, 0, 0 };
+
+		m_mRows.insert(std::make_pair(&oRow, oImage));
+
+		bRetained = true;
+	}
+
+	::LeaveCriticalSection(&m_oLock);
+
+	return bRetained;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Capture the tables rows. The modified flags are left for a SQL source.
+
+void CBackgroundSnapshot::Capture(CMDB& oMDB)
+{
+	size_t nTables = oMDB.TableCount();
+
+	m_vTables.reserve(nTables);
+
+	// For all tables.
+	for (size_t t = 0; t < nTables; ++t)
+	{
+		CTable& oTable = oMDB.Table(t);
+
+		// Ignore if a temporary table.
+		if (oTable.Transient())
+			continue;
+
+		ASSERT(oTable.m_pBackground == nullptr);
+
+		m_vTables.push_back(TableImage());
+
+		TableImage& oImage = m_vTables.back();
+		size_t      nRows  = oTable.RowCount();
+
+		oImage.m_pTable    = &oTable;
+		oImage.m_nColumns  = static_cast<uint32>(oTable.ColumnCount());
+		oImage.m_nIdentVal = oTable.m_nIdentVal;
+		oImage.m_pMapping  = oTable.m_pSnapshot;
+		oImage.m_vRows.reserve(nRows);
+
+		for (size_t r = 0; r < nRows; ++r)
+			oImage.m_vRows.push_back(&oTable[r]);
+
+		oTable.m_pBackground = this;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the captured tables to the stream in the CMDB::Write() format.
+
+void CBackgroundSnapshot::WriteTables()
+{
+	CBuffer    oBlock;
+	CMemStream oBlockStream(oBlock);
+
+	// For all tables.
+	for (size_t t = 0; t < m_vTables.size(); ++t)
+	{
+		const TableImage& oTable = m_vTables[t];
+		uint32            nRows  = static_cast<uint32>(oTable.m_vRows.size());
+
+		// Write the column and row counts.
+		m_rStream << oTable.m_nColumns;
+		m_rStream << nRows;
+
+		// Write the rows, a block at a time.
+		for (size_t r = 0; r < nRows; r += BLOCK_SIZE)
+		{
+			oBlockStream.Create();
+
+			WriteBlock(oTable, r, std::min<size_t>(r + BLOCK_SIZE, nRows), oBlockStream);
+
+			oBlockStream.Close();
+
+			m_rStream.Write(oBlock.Buffer(), oBlock.Size());
+		}
+
+		// Write the identity value.
+		m_rStream.Write(&oTable.m_nIdentVal, sizeof(oTable.m_nIdentVal));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Serialise a block of rows into the buffer. The lock is held so that a row
+//! cannot be modified whilst it is being copied.
+
+void CBackgroundSnapshot::WriteBlock(const TableImage& oTable, size_t nFirst, size_t nLast, WCL::IOutputStream& rBlock)
+{
+	::EnterCriticalSection(&m_oLock);
+
+	try
+	{
+		const byte* pValues = static_cast<const byte*>(m_oValues.Buffer());
+
+		for (size_t r = nFirst; r != nLast; ++r)
+		{
+			const CRow*               pRow = oTable.m_vRows[r];
+			RowImages::const_iterator it   = m_mRows.find(pRow);
+
+			// Unchanged since the capture?
+			if (it == m_mRows.end())
+				pRow->WriteValues(rBlock);
+			// Deleted since the capture?
+			else if (it->second.m_pRetained != nullptr)
+				it->second.m_pRetained->WriteValues(rBlock);
+			// Updated since the capture.
+			else
+				rBlock.Write(pValues + it->second.m_nOffset, it->second.m_nSize);
+		}
+	}
+	catch (...)
+	{
+		::LeaveCriticalSection(&m_oLock);
+		throw;
+	}
+
+	::LeaveCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Wait for the worker, detach from the tables and release the rows that were
+//! retained. This must be done on the thread modifying the tables.
+
+void CBackgroundSnapshot::Finish()
+{
+	// Already finished?
+	if (m_hThread == NULL)
+		return;
+
+	::WaitForSingleObject(m_hThread, INFINITE);
+	::CloseHandle(m_hThread);
+
+	m_hThread = NULL;
+
+	for (size_t t = 0; t < m_vTables.size(); ++t)
+	{
+		m_vTables[t].m_pTable->m_pBackground = nullptr;
+		m_vTables[t].m_pMapping.reset();
+	}
+
+	for (RowImages::iterator it = m_mRows.begin(); it != m_mRows.end(); ++it)
+		delete it->second.m_pRetained;
+
+	m_mRows.clear();
+	m_vTables.clear();
+	m_setInserted.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The worker thread entry point.
+
+unsigned __stdcall CBackgroundSnapshot::ThreadFn(void* pParam)
+{
+	CBackgroundSnapshot* pSnapshot = static_cast<CBackgroundSnapshot*>(pParam);
+
+	try
+	{
+		pSnapshot->WriteTables();
+	}
+	catch (const Core::Exception& e)
+	{
+		pSnapshot->m_bFailed  = true;
+		pSnapshot->m_strError = e.twhat();
+	}
+	catch (...)
+	{
+		pSnapshot->m_bFailed  = true;
+		pSnapshot->m_strError = TXT("Unexpected exception");
+	}
+
+	// Stop preserving rows.
+	::EnterCriticalSection(&pSnapshot->m_oLock);
+	pSnapshot->m_bFinished = true;
+	::LeaveCriticalSection(&pSnapshot->m_oLock);
+
+	return 0;
+}
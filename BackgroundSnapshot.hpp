@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   BackgroundSnapshot.hpp
+//! \brief  The CBackgroundSnapshot class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_BACKGROUNDSNAPSHOT_HPP
+#define MDBL_BACKGROUNDSNAPSHOT_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "FwdDecls.hpp"
+#include "Snapshot.hpp"
+#include <WCL/Buffer.hpp>
+#include <WCL/MemStream.hpp>
+#include <vector>
+#include <map>
+#include <set>
+
+////////////////////////////////////////////////////////////////////////////////
+//! Writes a point-in-time copy of the database to a stream on a worker thread
+//! whilst the tables continue to be modified. The output is the same as that
+//! of CMDB::Write() and can be read back with CMDB::Read().
+//!
+//! The constructor captures the row pointers of each table, which is the only
+//! pause seen by the modifying thread. Unlike CMDB::Write() the row and table
+//! modified flags are left alone, so that any changes pending for a SQL source
+//! can still be written to it. After that the rows are copied-on-write: the
+//! first time a captured row is updated its current values are preserved and
+//! captured rows that are deleted are kept alive until the snapshot is done.
+//! Rows inserted after the capture are tracked, see InsertedRow(), and ignored. The worker serialises the rows
+//! in blocks of BLOCK_SIZE, only holding the lock whilst copying a block into
+//! memory, so a writer is never blocked for longer than that.
+//!
+//! The tables must only be modified by a single thread (or be externally
+//! synchronised) and must not be destroyed or reloaded before Wait() returns.
+
+class CBackgroundSnapshot /*: private NotCopyable*/
+{
+public:
+	//! Constructor.
+	CBackgroundSnapshot(CMDB& oMDB, WCL::IOutputStream& rStream);
+
+	//! Destructor.
+	~CBackgroundSnapshot();
+
+	//
+	// Properties.
+	//
+
+	//! Query if the worker has finished writing.
+	bool Finished() const;
+
+	//
+	// Methods.
+	//
+
+	//! Wait for the snapshot to be written and detach it from the tables.
+	void Wait();
+
+	//
+	// Copy-on-write hooks.
+	//
+
+	//! Track a row inserted after the capture.
+	void InsertedRow(const CRow& oRow);
+
+	//! Preserve the values of a row that is about to be modified.
+	void PreserveRow(const CRow& oRow);
+
+	//! Take ownership of a row that is about to be deleted.
+	bool RetainRow(CRow& oRow);
+
+	//! The number of rows serialised per lock acquisition.
+	static const size_t BLOCK_SIZE = 1024;
+
+private:
+	//! The rows captured from a table.
+	struct TableImage
+	{
+		CTable*				m_pTable;		//!< The table.
+		uint32				m_nColumns;		//!< The number of columns.
+		int					m_nIdentVal;	//!< The identity value.
+		std::vector<CRow*>	m_vRows;		//!< The rows.
+		CSnapshotPtr		m_pMapping;		//!< Keeps mapped rows alive.
+	};
+
+	//! The preserved state of a captured row.
+	struct RowImage
+	{
+		CRow*				m_pRetained;	//!< The deleted row, if retained.
+		size_t				m_nOffset;		//!< The offset of the values.
+		size_t				m_nSize;		//!< The size of the values.
+	};
+
+	//! The collection of captured tables.
+	typedef std::vector<TableImage> TableImages;
+
+	//! The map of row to its preserved state.
+	typedef std::map<const CRow*, RowImage> RowImages;
+
+	//! The set of rows inserted after the capture.
+	typedef std::set<const CRow*> RowSet;
+
+	//
+	// Members.
+	//
+	WCL::IOutputStream&	m_rStream;		//!< The output stream.
+	TableImages			m_vTables;		//!< The captured tables.
+	CRITICAL_SECTION	m_oLock;		//!< The lock for the members below.
+	RowImages			m_mRows;		//!< The preserved rows.
+	CBuffer				m_oValues;		//!< The preserved row values.
+	CMemStream			m_oValueStream;	//!< The stream used to fill m_oValues.
+	bool				m_bFinished;	//!< Has the worker finished?
+	bool				m_bFailed;		//!< Did the worker fail?
+	CString				m_strError;		//!< The reason for the failure.
+	RowSet				m_setInserted;	//!< The rows inserted since the capture.
+	HANDLE				m_hThread;		//!< The worker thread.
+
+	//
+	// Internal methods.
+	//
+
+	//! Capture the tables rows.
+	void Capture(CMDB& oMDB);
+
+	//! Write the captured tables to the stream.
+	void WriteTables();
+
+	//! Serialise a block of rows into the buffer.
+	void WriteBlock(const TableImage& oTable, size_t nFirst, size_t nLast, WCL::IOutputStream& rBlock);
+
+	//! Wait for the worker and release the captured rows.
+	void Finish();
+
+	//! The worker thread entry point.
+	static unsigned __stdcall ThreadFn(void* pParam);
+
+private:
+	// NotCopyable.
+	CBackgroundSnapshot(const CBackgroundSnapshot&);
+	CBackgroundSnapshot& operator=(const CBackgroundSnapshot&);
+};
+
+#endif // MDBL_BACKGROUNDSNAPSHOT_HPP
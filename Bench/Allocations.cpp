@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Allocations.cpp
+//! \brief  The global operator new and delete used to count heap allocations.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Allocations.hpp"
+#include <new>
+#include <malloc.h>
+
+namespace
+{
+
+//! The number of allocations.
+static volatile LONG s_nAllocations = 0;
+
+//! The number of bytes allocated.
+static volatile LONG s_nBytes = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Allocate a block and count it.
+
+void* allocate(size_t nBytes)
+{
+	::InterlockedIncrement(&s_nAllocations);
+	::InterlockedExchangeAdd(&s_nBytes, static_cast<LONG>(nBytes));
+
+	void* pBlock = ::malloc((nBytes != 0) ? nBytes : 1);
+
+	if (pBlock == nullptr)
+		throw std::bad_alloc();
+
+	return pBlock;
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of calls to operator new since the process started.
+
+LONG AllocationCount()
+{
+	return s_nAllocations;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of bytes requested from operator new since the process
+//! started.
+
+LONG AllocatedBytes()
+{
+	return s_nBytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Allocate a single object.
+
+void* operator new(size_t nBytes) throw(std::bad_alloc)
+{
+	return allocate(nBytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Allocate an array of objects.
+
+void* operator new[](size_t nBytes) throw(std::bad_alloc)
+{
+	return allocate(nBytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Free a single object.
+
+void operator delete(void* pBlock) throw()
+{
+	::free(pBlock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Free an array of objects.
+
+void operator delete[](void* pBlock) throw()
+{
+	::free(pBlock);
+}
@@ -0,0 +1,25 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Allocations.hpp
+//! \brief  The heap allocation counters.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_ALLOCATIONS_HPP
+#define APP_ALLOCATIONS_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of calls to operator new since the process started.
+
+LONG AllocationCount();
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of bytes requested from operator new since the process
+//! started. The count wraps, so only the difference should be used.
+
+LONG AllocatedBytes();
+
+#endif // APP_ALLOCATIONS_HPP
@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Bench.cpp
+//! \brief  The benchmark harness entry point.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Benchmarks.hpp"
+#include <Core/Algorithm.hpp>
+#include <tchar.h>
+#include <stdio.h>
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The command line options.
+
+struct Options
+{
+	size_t			m_nRows;		//!< The number of rows in the main table.
+	size_t			m_nColumns;		//!< The number of columns in the main table.
+	size_t			m_nRuns;		//!< The number of timed runs of each benchmark.
+	bool			m_bCSV;			//!< Write the results as CSV?
+	const tchar*	m_pszFilter;	//!< Only run benchmarks whose name contains this.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Display the program usage.
+
+void showUsage()
+{
+	_tprintf(TXT("USAGE: Bench [--rows N] [--columns N] [--runs N] [--csv] [--filter NAME]\n"));
+	_tprintf(TXT("\n"));
+	_tprintf(TXT("--rows N       The number of rows in the main table (default 100000)\n"));
+	_tprintf(TXT("--columns N    The number of columns in the main table, at least 3 (default 8)\n"));
+	_tprintf(TXT("--runs N       The number of timed runs of each benchmark (default 20)\n"));
+	_tprintf(TXT("--csv          Write the results as CSV for regression tracking\n"));
+	_tprintf(TXT("--filter NAME  Only run the benchmarks whose name contains NAME\n"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse the command line. Returns false if the usage should be shown.
+
+bool parseCmdLine(int argc, _TCHAR* argv[], Options& oOptions)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const tchar* pszSwitch = argv[i];
+		const tchar* pszValue  = (i+1 < argc) ? argv[i+1] : nullptr;
+
+		if (_tcscmp(pszSwitch, TXT("--csv")) == 0)
+		{
+			oOptions.m_bCSV = true;
+			continue;
+		}
+
+		if (pszValue == nullptr)
+			return false;
+
+		if (_tcscmp(pszSwitch, TXT("--rows")) == 0)
+			oOptions.m_nRows = _tcstoul(pszValue, nullptr, 10);
+		else if (_tcscmp(pszSwitch, TXT("--columns")) == 0)
+			oOptions.m_nColumns = _tcstoul(pszValue, nullptr, 10);
+		else if (_tcscmp(pszSwitch, TXT("--runs")) == 0)
+			oOptions.m_nRuns = _tcstoul(pszValue, nullptr, 10);
+		else if (_tcscmp(pszSwitch, TXT("--filter")) == 0)
+			oOptions.m_pszFilter = pszValue;
+		else
+			return false;
+
+		++i;
+	}
+
+	return (oOptions.m_nRows != 0) && (oOptions.m_nColumns >= CDataSet::MIN_COLUMNS) && (oOptions.m_nRuns != 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the header for the results.
+
+void writeHeader(const Options& oOptions)
+{
+	if (oOptions.m_bCSV)
+	{
+		_tprintf(TXT("benchmark,rows,columns,runs,ops_per_run,ops_per_sec,run_p50_ns_per_op,run_p90_ns_per_op,run_p99_ns_per_op,run_max_ns_per_op,news_per_op,new_bytes_per_op,table_bytes_per_op\n"));
+	}
+	else
+	{
+		_tprintf(TXT("Rows: %u, Columns: %u, Runs: %u\n\n"), static_cast<uint>(oOptions.m_nRows),
+					static_cast<uint>(oOptions.m_nColumns), static_cast<uint>(oOptions.m_nRuns));
+		_tprintf(TXT("The ns/op percentiles are of the mean for each run, not of single operations.\n"));
+		_tprintf(TXT("The new columns count operator new, the table column the change in MemoryUsage().\n\n"));
+		_tprintf(TXT("%-14s %14s %14s %14s %14s %14s %10s %10s %10s\n"), TXT("Benchmark"), TXT("Ops/sec"),
+					TXT("Run p50 ns/op"), TXT("Run p90 ns/op"), TXT("Run p99 ns/op"), TXT("Run max ns/op"),
+					TXT("New/op"), TXT("New B/op"), TXT("Table B/op"));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the results of a single benchmark.
+
+void writeResult(const Options& oOptions, const CBenchmark& oBenchmark, const Measurement& oResult)
+{
+	if (oOptions.m_bCSV)
+	{
+		_tprintf(TXT("%s,%u,%u,%u,%u,%.1f,%.1f,%.1f,%.1f,%.1f,%.2f,%.1f,%.1f\n"), oBenchmark.Name(),
+					static_cast<uint>(oOptions.m_nRows), static_cast<uint>(oOptions.m_nColumns),
+					static_cast<uint>(oResult.m_nRuns), static_cast<uint>(oResult.m_nOperations),
+					oResult.m_dOpsPerSec, oResult.m_dP50, oResult.m_dP90, oResult.m_dP99, oResult.m_dMax,
+					oResult.m_dNewsPerOp, oResult.m_dNewBytesPerOp, oResult.m_dTableBytesPerOp);
+	}
+	else
+	{
+		_tprintf(TXT("%-14s %14.1f %14.1f %14.1f %14.1f %14.1f %10.2f %10.1f %10.1f\n"), oBenchmark.Name(),
+					oResult.m_dOpsPerSec, oResult.m_dP50, oResult.m_dP90, oResult.m_dP99, oResult.m_dMax,
+					oResult.m_dNewsPerOp, oResult.m_dNewBytesPerOp, oResult.m_dTableBytesPerOp);
+	}
+
+	fflush(stdout);
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The entry point.
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+	Options oOptions = { 100000, 8, 20, false, nullptr };
+
+	if (!parseCmdLine(argc, argv, oOptions))
+	{
+		showUsage();
+		return EXIT_FAILURE;
+	}
+
+	try
+	{
+		CDataSet   oData(oOptions.m_nRows, oOptions.m_nColumns);
+		Benchmarks vBenchmarks;
+
+		CreateBenchmarks(oData, vBenchmarks);
+
+		writeHeader(oOptions);
+
+		for (size_t i = 0; i != vBenchmarks.size(); ++i)
+		{
+			CBenchmark& oBenchmark = *vBenchmarks[i];
+
+			if ( (oOptions.m_pszFilter != nullptr) && (_tcsstr(oBenchmark.Name(), oOptions.m_pszFilter) == nullptr) )
+				continue;
+
+			Measurement oResult;
+
+			Measure(oBenchmark, oOptions.m_nRuns, oResult);
+
+			writeResult(oOptions, oBenchmark, oResult);
+		}
+
+		Core::deleteAll(vBenchmarks);
+	}
+	catch (const Core::Exception& e)
+	{
+		_ftprintf(stderr, TXT("ERROR: %s\n"), e.twhat());
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Benchmark.cpp
+//! \brief  The benchmark timing functions.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Benchmark.hpp"
+#include "Allocations.hpp"
+#include <algorithm>
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the value at a percentile of a sorted list.
+
+double percentile(const std::vector<double>& vSorted, size_t nPercent)
+{
+	ASSERT(!vSorted.empty());
+
+	size_t nIndex = ((vSorted.size() * nPercent) + 99) / 100;
+
+	return vSorted[(nIndex != 0) ? (nIndex-1) : 0];
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time a number of runs of a benchmark. A single untimed run is made first
+//! to warm the caches and heap.
+
+void Measure(CBenchmark& oBenchmark, size_t nRuns, Measurement& oResult)
+{
+	ASSERT(nRuns != 0);
+	ASSERT(oBenchmark.Operations() != 0);
+
+	LARGE_INTEGER oFrequency;
+
+	::QueryPerformanceFrequency(&oFrequency);
+
+	const double dNsPerTick = 1.0e9 / static_cast<double>(oFrequency.QuadPart);
+	const size_t nOps       = oBenchmark.Operations();
+
+	oBenchmark.Setup();
+	oBenchmark.Run();
+	oBenchmark.Teardown();
+
+	std::vector<double> vLatencies;
+	double              dTotalNs = 0.0;
+	double              dAllocs  = 0.0;
+	double              dBytes   = 0.0;
+	double              dTable   = 0.0;
+
+	vLatencies.reserve(nRuns);
+
+	for (size_t i = 0; i != nRuns; ++i)
+	{
+		oBenchmark.Setup();
+
+		size_t        nTable  = oBenchmark.MemoryUsage().Total();
+		LONG          nAllocs = AllocationCount();
+		LONG          nBytes  = AllocatedBytes();
+		LARGE_INTEGER oStart, oEnd;
+
+		::QueryPerformanceCounter(&oStart);
+
+		oBenchmark.Run();
+
+		::QueryPerformanceCounter(&oEnd);
+
+		dAllocs += static_cast<double>(AllocationCount() - nAllocs);
+		dBytes  += static_cast<double>(static_cast<ULONG>(AllocatedBytes() - nBytes));
+		dTable  += static_cast<double>(oBenchmark.MemoryUsage().Total()) - static_cast<double>(nTable);
+
+		oBenchmark.Teardown();
+
+		double dRunNs = static_cast<double>(oEnd.QuadPart - oStart.QuadPart) * dNsPerTick;
+
+		dTotalNs += dRunNs;
+		vLatencies.push_back(dRunNs / nOps);
+	}
+
+	std::sort(vLatencies.begin(), vLatencies.end());
+
+	const double dTotalOps = static_cast<double>(nRuns * nOps);
+
+	oResult.m_nRuns            = nRuns;
+	oResult.m_nOperations      = nOps;
+	oResult.m_dOpsPerSec       = (dTotalNs > 0.0) ? (dTotalOps * 1.0e9 / dTotalNs) : 0.0;
+	oResult.m_dP50             = percentile(vLatencies, 50);
+	oResult.m_dP90             = percentile(vLatencies, 90);
+	oResult.m_dP99             = percentile(vLatencies, 99);
+	oResult.m_dMax             = vLatencies.back();
+	oResult.m_dNewsPerOp       = dAllocs / dTotalOps;
+	oResult.m_dNewBytesPerOp   = dBytes / dTotalOps;
+	oResult.m_dTableBytesPerOp = dTable / dTotalOps;
+}
@@ -0,0 +1,133 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Benchmark.hpp
+//! \brief  The CBenchmark class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_BENCHMARK_HPP
+#define APP_BENCHMARK_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <MDBL/MemoryUsage.hpp>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//! The base class for a benchmark of a single operation. Each run performs
+//! the operation a fixed number of times and only Run() is timed, so that the
+//! data it needs can be built, and torn down, around it. A benchmark that
+//! changes tables reports their MemoryUsage() so that the memory the rows
+//! allocate from the CRT heap, which operator new does not see, is measured.
+
+class CBenchmark /*: private NotCopyable*/
+{
+public:
+	//! Destructor.
+	virtual ~CBenchmark();
+
+	//! Get the name of the benchmark.
+	const tchar* Name() const;
+
+	//! Get the number of operations performed by each run.
+	virtual size_t Operations() const = 0;
+
+	//! Prepare for a run.
+	virtual void Setup();
+
+	//! Perform a run.
+	virtual void Run() = 0;
+
+	//! Clean up after a run.
+	virtual void Teardown();
+
+	//! Get the memory used by the tables the benchmark changes.
+	virtual CMemoryUsage MemoryUsage() const;
+
+protected:
+	//! Constructor.
+	CBenchmark(const tchar* pszName);
+
+private:
+	//
+	// Members.
+	//
+	const tchar*	m_pszName;		//!< The name.
+
+	// NotCopyable.
+	CBenchmark(const CBenchmark&);
+	CBenchmark& operator=(const CBenchmark&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The measurements of a benchmark. Each run is timed as a whole, so the
+//! latencies are the mean time per operation of a run and the percentiles are
+//! across the runs, not across individual operations. The allocations are the
+//! calls to operator new only. The table bytes are the change in the tables'
+//! MemoryUsage(), which includes the row buffers allocated from the CRT heap.
+
+struct Measurement
+{
+	size_t	m_nRuns;			//!< The number of runs.
+	size_t	m_nOperations;		//!< The number of operations per run.
+	double	m_dOpsPerSec;		//!< The operations per second over all runs.
+	double	m_dP50;				//!< The median run's ns per operation.
+	double	m_dP90;				//!< The 90th percentile run's ns per operation.
+	double	m_dP99;				//!< The 99th percentile run's ns per operation.
+	double	m_dMax;				//!< The slowest run's ns per operation.
+	double	m_dNewsPerOp;		//!< The calls to operator new per operation.
+	double	m_dNewBytesPerOp;	//!< The bytes requested from operator new per operation.
+	double	m_dTableBytesPerOp;	//!< The change in table memory per operation.
+};
+
+//! Time a number of runs of a benchmark.
+void Measure(CBenchmark& oBenchmark, size_t nRuns, Measurement& oResult);
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+inline CBenchmark::CBenchmark(const tchar* pszName)
+	: m_pszName(pszName)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+inline CBenchmark::~CBenchmark()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the name of the benchmark.
+
+inline const tchar* CBenchmark::Name() const
+{
+	return m_pszName;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Prepare for a run. This is not timed.
+
+inline void CBenchmark::Setup()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Clean up after a run. This is not timed.
+
+inline void CBenchmark::Teardown()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the memory used by the tables the benchmark changes. This is sampled
+//! either side of Run() and defaults to none.
+
+inline CMemoryUsage CBenchmark::MemoryUsage() const
+{
+	return CMemoryUsage();
+}
+
+#endif // APP_BENCHMARK_HPP
@@ -0,0 +1,670 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Benchmarks.cpp
+//! \brief  The MDBL benchmarks.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Benchmarks.hpp"
+#include <MDBL/ResultSet.hpp>
+#include <MDBL/GroupSet.hpp>
+#include <MDBL/ValueSet.hpp>
+#include <MDBL/JoinedSet.hpp>
+#include <MDBL/Join.hpp>
+#include <MDBL/WhereCmp.hpp>
+#include <MDBL/LocalSource.hpp>
+#include <MDBL/BulkLoader.hpp>
+
+namespace
+{
+
+//! The snapshot file used by the snapshot benchmarks.
+static const tchar* SNAPSHOT_FILE = TXT("Bench.snp");
+
+//! The number of rows in a block of the InsertRow benchmark.
+static const size_t INSERT_BLOCK = 1000;
+
+//! The number of lookups in each run of the SelectRow benchmark.
+static const size_t LOOKUPS = 1000;
+
+//! A prime used to visit the rows in a scattered order.
+static const size_t STRIDE = 7919;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Insert blocks of rows into an empty table.
+
+class InsertRowBench : public CBenchmark
+{
+public:
+	InsertRowBench(const CDataSet& oData)
+		: CBenchmark(TXT("InsertRow")), m_oData(oData), m_oTable(TXT("Insert"))
+	{
+		CDataSet::CreateSchema(m_oTable, oData.m_nColumns);
+	}
+
+	virtual size_t Operations() const
+	{
+		return INSERT_BLOCK;
+	}
+
+	virtual void Run()
+	{
+		for (size_t i = 0; i != INSERT_BLOCK; ++i)
+		{
+			CRow& oRow = m_oTable.CreateRow();
+
+			CDataSet::FillRow(oRow, m_oTable.RowCount());
+
+			m_oTable.InsertRow(oRow);
+		}
+	}
+
+	virtual void Teardown()
+	{
+		// Keep the table about the size of the data set.
+		if (m_oTable.RowCount() >= m_oData.m_nRows)
+			m_oTable.Truncate();
+	}
+
+	virtual CMemoryUsage MemoryUsage() const
+	{
+		return m_oTable.MemoryUsage();
+	}
+
+private:
+	const CDataSet&	m_oData;
+	CTable			m_oTable;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find rows by their unique ID.
+
+class SelectRowBench : public CBenchmark
+{
+public:
+	SelectRowBench(const CDataSet& oData)
+		: CBenchmark(TXT("SelectRow")), m_oData(oData), m_nNext(0)
+	{ }
+
+	virtual size_t Operations() const
+	{
+		return LOOKUPS;
+	}
+
+	virtual void Run()
+	{
+		for (size_t i = 0; i != LOOKUPS; ++i)
+		{
+			m_nNext = (m_nNext + STRIDE) % m_oData.m_nRows;
+
+			CRow* pRow = m_oData.m_oTable.SelectRow(CDataSet::ID_COLUMN, static_cast<int>(m_nNext));
+
+			ASSERT(pRow != nullptr);
+			DEBUG_USE_ONLY(pRow);
+		}
+	}
+
+private:
+	const CDataSet&	m_oData;
+	size_t			m_nNext;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Scan the table for the rows of a single group.
+
+class SelectBench : public CBenchmark
+{
+public:
+	SelectBench(const CDataSet& oData)
+		: CBenchmark(TXT("Select")), m_oData(oData)
+	{ }
+
+	virtual size_t Operations() const
+	{
+		return 1;
+	}
+
+	virtual void Run()
+	{
+		CResultSet oRS = m_oData.m_oTable.Select(CWhereCmp(CDataSet::GROUP_COLUMN, CWhereCmp::EQUALS, 42));
+
+		ASSERT(oRS.Count() != 0);
+	}
+
+private:
+	const CDataSet&	m_oData;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Sort all the rows by name.
+
+class OrderByBench : public CBenchmark
+{
+public:
+	OrderByBench(const CDataSet& oData)
+		: CBenchmark(TXT("OrderBy")), m_oData(oData), m_pRS(nullptr)
+	{ }
+
+	virtual ~OrderByBench()
+	{
+		delete m_pRS;
+	}
+
+	virtual size_t Operations() const
+	{
+		return 1;
+	}
+
+	virtual void Setup()
+	{
+		m_pRS = new CResultSet(m_oData.m_oTable.SelectAll());
+	}
+
+	virtual void Run()
+	{
+		m_pRS->OrderBy(CDataSet::NAME_COLUMN, CSortColumns::ASC);
+	}
+
+	virtual void Teardown()
+	{
+		delete m_pRS;
+		m_pRS = nullptr;
+	}
+
+private:
+	const CDataSet&	m_oData;
+	CResultSet*		m_pRS;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Group all the rows by their group ID.
+
+class GroupByBench : public CBenchmark
+{
+public:
+	GroupByBench(const CDataSet& oData)
+		: CBenchmark(TXT("GroupBy")), m_oRS(oData.m_oTable.SelectAll())
+	{ }
+
+	virtual size_t Operations() const
+	{
+		return 1;
+	}
+
+	virtual void Run()
+	{
+		CGroupSet oGroups = m_oRS.GroupBy(CDataSet::GROUP_COLUMN);
+
+		ASSERT(oGroups.Count() != 0);
+	}
+
+private:
+	CResultSet	m_oRS;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the distinct group IDs of all the rows.
+
+class DistinctBench : public CBenchmark
+{
+public:
+	DistinctBench(const CDataSet& oData)
+		: CBenchmark(TXT("Distinct")), m_oRS(oData.m_oTable.SelectAll())
+	{ }
+
+	virtual size_t Operations() const
+	{
+		return 1;
+	}
+
+	virtual void Run()
+	{
+		CValueSet oValues = m_oRS.Distinct(CDataSet::GROUP_COLUMN);
+
+		ASSERT(oValues.Count() != 0);
+	}
+
+private:
+	CResultSet	m_oRS;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Join every row onto its group.
+
+class JoinBench : public CBenchmark
+{
+public:
+	JoinBench(CDataSet& oData)
+		: CBenchmark(TXT("Join")), m_oData(oData)
+		, m_nTable(oData.m_oMDB.FindTable(oData.m_oTable.Name()))
+		, m_nGroups(oData.m_oMDB.FindTable(oData.m_oGroups.Name()))
+	{ }
+
+	virtual size_t Operations() const
+	{
+		return 1;
+	}
+
+	virtual void Run()
+	{
+		CJoin oJoin(m_nTable);
+
+		oJoin.Add(m_nGroups, CDataSet::GROUP_COLUMN, INNER_JOIN, CDataSet::ID_COLUMN);
+
+		CJoinedSet oJS = m_oData.m_oMDB.Select(oJoin);
+
+		ASSERT(oJS.Count() == m_oData.m_nRows);
+	}
+
+private:
+	const CDataSet&	m_oData;
+	size_t			m_nTable;
+	size_t			m_nGroups;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the database to a snapshot.
+
+class WriteSnapshotBench : public CBenchmark
+{
+public:
+	WriteSnapshotBench(CDataSet& oData)
+		: CBenchmark(TXT("WriteSnapshot")), m_oData(oData)
+	{ }
+
+	virtual ~WriteSnapshotBench()
+	{
+		::DeleteFile(SNAPSHOT_FILE);
+	}
+
+	virtual size_t Operations() const
+	{
+		return 1;
+	}
+
+	virtual void Run()
+	{
+		m_oData.m_oMDB.WriteSnapshot(SNAPSHOT_FILE);
+	}
+
+private:
+	CDataSet&	m_oData;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read the database from a snapshot into empty tables.
+
+class ReadSnapshotBench : public CBenchmark
+{
+public:
+	ReadSnapshotBench(CDataSet& oData)
+		: CBenchmark(TXT("ReadSnapshot")), m_oData(oData), m_pGroups(nullptr), m_pTable(nullptr), m_pMDB(nullptr)
+	{
+		m_oData.m_oMDB.WriteSnapshot(SNAPSHOT_FILE);
+	}
+
+	virtual ~ReadSnapshotBench()
+	{
+		Teardown();
+		::DeleteFile(SNAPSHOT_FILE);
+	}
+
+	virtual size_t Operations() const
+	{
+		return 1;
+	}
+
+	virtual void Setup()
+	{
+		m_pGroups = new CTable(m_oData.m_oGroups.Name());
+		m_pTable  = new CTable(m_oData.m_oTable.Name());
+		m_pMDB    = new CMDB;
+
+		CDataSet::CreateGroupsSchema(*m_pGroups);
+		CDataSet::CreateSchema(*m_pTable, m_oData.m_nColumns);
+
+		m_pMDB->AddTable(*m_pGroups);
+		m_pMDB->AddTable(*m_pTable);
+	}
+
+	virtual void Run()
+	{
+		m_pMDB->ReadSnapshot(SNAPSHOT_FILE);
+
+		ASSERT(m_pTable->RowCount() == m_oData.m_nRows);
+	}
+
+	virtual void Teardown()
+	{
+		delete m_pMDB;
+		delete m_pTable;
+		delete m_pGroups;
+
+		m_pMDB    = nullptr;
+		m_pTable  = nullptr;
+		m_pGroups = nullptr;
+	}
+
+	virtual CMemoryUsage MemoryUsage() const
+	{
+		return m_pMDB->MemoryUsage();
+	}
+
+private:
+	CDataSet&	m_oData;
+	CTable*		m_pGroups;
+	CTable*		m_pTable;
+	CMDB*		m_pMDB;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Fill a table with the same rows as the main table, marked as inserted.
+
+void fillTable(CTable& oTable, size_t nRows)
+{
+	for (size_t i = 0; i != nRows; ++i)
+	{
+		CRow& oRow = oTable.CreateRow();
+
+		CDataSet::FillRow(oRow, i);
+
+		oTable.InsertRow(oRow);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the inserted rows to an in-memory local SQL source. The rows are
+//! written within a transaction that is rolled back after each run.
+
+class WriteSQLBench : public CBenchmark
+{
+public:
+	WriteSQLBench(const CDataSet& oData)
+		: CBenchmark(TXT("WriteSQL")), m_oData(oData), m_oTable(oData.m_oTable.Name()), m_oSource(TXT(""))
+	{
+		CDataSet::CreateSchema(m_oTable, oData.m_nColumns);
+		fillTable(m_oTable, oData.m_nRows);
+
+		m_oSource.CreateTable(m_oTable);
+	}
+
+	virtual size_t Operations() const
+	{
+		return m_oData.m_nRows;
+	}
+
+	virtual void Setup()
+	{
+		m_oSource.BeginTrans();
+	}
+
+	virtual void Run()
+	{
+		m_oTable.Write(m_oSource, CTable::INSERTED);
+	}
+
+	virtual void Teardown()
+	{
+		if (m_oSource.InTrans())
+			m_oSource.RollbackTrans();
+	}
+
+private:
+	const CDataSet&	m_oData;
+	CTable			m_oTable;
+	CLocalSource	m_oSource;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read the rows from an in-memory local SQL source into an empty table.
+
+class ReadSQLBench : public CBenchmark
+{
+public:
+	ReadSQLBench(const CDataSet& oData)
+		: CBenchmark(TXT("ReadSQL")), m_oData(oData), m_pTable(nullptr), m_oSource(TXT(""))
+	{
+		CTable oTable(oData.m_oTable.Name());
+
+		CDataSet::CreateSchema(oTable, oData.m_nColumns);
+		fillTable(oTable, oData.m_nRows);
+
+		m_oSource.CreateTable(oTable);
+		m_oSource.BeginTrans();
+		oTable.Write(m_oSource, CTable::INSERTED);
+		m_oSource.CommitTrans();
+	}
+
+	virtual ~ReadSQLBench()
+	{
+		Teardown();
+	}
+
+	virtual size_t Operations() const
+	{
+		return m_oData.m_nRows;
+	}
+
+	virtual void Setup()
+	{
+		m_pTable = new CTable(m_oData.m_oTable.Name());
+
+		CDataSet::CreateSchema(*m_pTable, m_oData.m_nColumns);
+	}
+
+	virtual void Run()
+	{
+		m_pTable->Read(m_oSource);
+
+		ASSERT(m_pTable->RowCount() == m_oData.m_nRows);
+	}
+
+	virtual void Teardown()
+	{
+		delete m_pTable;
+
+		m_pTable = nullptr;
+	}
+
+	virtual CMemoryUsage MemoryUsage() const
+	{
+		return m_pTable->MemoryUsage();
+	}
+
+private:
+	const CDataSet&	m_oData;
+	CTable*			m_pTable;
+	CLocalSource	m_oSource;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Load the rows from comma separated text into an empty table.
+
+class BulkLoadBench : public CBenchmark
+{
+public:
+	BulkLoadBench(const CDataSet& oData)
+		: CBenchmark(TXT("BulkLoad")), m_oData(oData), m_pTable(nullptr)
+	{
+		const CTable& oTable = oData.m_oTable;
+
+		for (size_t r = 0; r != oTable.RowCount(); ++r)
+		{
+			for (size_t c = 0; c != oTable.ColumnCount(); ++c)
+			{
+				const CField& oField = oTable[r][c];
+
+				if (c != 0)
+					m_strText += TXT(',');
+
+				switch (oTable.Column(c).ColType())
+				{
+					case MDCT_INT:		m_strText += Core::fmt(TXT("%d"), oField.GetInt()).c_str();								break;
+					case MDCT_INT64:	m_strText += Core::fmt(TXT("%.0f"), static_cast<double>(oField.GetInt64())).c_str();	break;
+					case MDCT_DOUBLE:	m_strText += Core::fmt(TXT("%.17g"), oField.GetDouble()).c_str();						break;
+					default:			m_strText += oField.GetString();														break;
+				}
+			}
+
+			m_strText += TXT('\n');
+		}
+	}
+
+	virtual ~BulkLoadBench()
+	{
+		Teardown();
+	}
+
+	virtual size_t Operations() const
+	{
+		return m_oData.m_nRows;
+	}
+
+	virtual void Setup()
+	{
+		m_pTable = new CTable(m_oData.m_oTable.Name());
+
+		CDataSet::CreateSchema(*m_pTable, m_oData.m_nColumns);
+	}
+
+	virtual void Run()
+	{
+		CBulkLoader().Load(m_strText.c_str(), m_strText.length(), *m_pTable);
+
+		ASSERT(m_pTable->RowCount() == m_oData.m_nRows);
+	}
+
+	virtual void Teardown()
+	{
+		delete m_pTable;
+
+		m_pTable = nullptr;
+	}
+
+	virtual CMemoryUsage MemoryUsage() const
+	{
+		return m_pTable->MemoryUsage();
+	}
+
+private:
+	const CDataSet&	m_oData;
+	CTable*			m_pTable;
+	tstring			m_strText;
+};
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor. This builds and fills the tables.
+
+CDataSet::CDataSet(size_t nRows, size_t nColumns)
+	: m_nRows(nRows)
+	, m_nColumns(std::max(nColumns, MIN_COLUMNS))
+	, m_oGroups(TXT("Groups"))
+	, m_oTable(TXT("Rows"))
+	, m_oMDB()
+{
+	ASSERT(nRows != 0);
+
+	CreateGroupsSchema(m_oGroups);
+	CreateSchema(m_oTable, m_nColumns);
+
+	for (size_t i = 0; i != GROUPS; ++i)
+	{
+		CRow& oRow = m_oGroups.CreateRow();
+
+		oRow[0] = static_cast<int>(i);
+		oRow[1] = Core::fmt(TXT("Group %u"), static_cast<uint>(i)).c_str();
+
+		m_oGroups.InsertRow(oRow);
+	}
+
+	for (size_t i = 0; i != m_nRows; ++i)
+	{
+		CRow& oRow = m_oTable.CreateRow();
+
+		FillRow(oRow, i);
+
+		m_oTable.InsertRow(oRow);
+	}
+
+	m_oMDB.AddTable(m_oGroups);
+	m_oMDB.AddTable(m_oTable);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+CDataSet::~CDataSet()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create the main table's columns.
+
+void CDataSet::CreateSchema(CTable& oTable, size_t nColumns)
+{
+	oTable.AddColumn(TXT("ID"),      MDCT_INT,    0,  CColumn::UNIQUE);
+	oTable.AddColumn(TXT("GroupID"), MDCT_INT,    0,  CColumn::DEFAULTS);
+	oTable.AddColumn(TXT("Name"),    MDCT_VARSTR, 32, CColumn::DEFAULTS);
+
+	for (size_t i = MIN_COLUMNS; i < nColumns; ++i)
+	{
+		CString strName = Core::fmt(TXT("Column%u"), static_cast<uint>(i)).c_str();
+
+		switch (i % 3)
+		{
+			case 0:		oTable.AddColumn(strName, MDCT_INT64,  0,  CColumn::DEFAULTS);	break;
+			case 1:		oTable.AddColumn(strName, MDCT_DOUBLE, 0,  CColumn::DEFAULTS);	break;
+			default:	oTable.AddColumn(strName, MDCT_VARSTR, 32, CColumn::DEFAULTS);	break;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create the groups table's columns.
+
+void CDataSet::CreateGroupsSchema(CTable& oTable)
+{
+	oTable.AddColumn(TXT("ID"),   MDCT_INT,    0,  CColumn::UNIQUE);
+	oTable.AddColumn(TXT("Name"), MDCT_VARSTR, 32, CColumn::DEFAULTS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Fill in a row of the main table. The names are scattered so that sorting
+//! does real work.
+
+void CDataSet::FillRow(CRow& oRow, size_t nRow)
+{
+	oRow[ID_COLUMN]    = static_cast<int>(nRow);
+	oRow[GROUP_COLUMN] = static_cast<int>(nRow % GROUPS);
+	oRow[NAME_COLUMN]  = Core::fmt(TXT("Name %08u"), static_cast<uint>((nRow * STRIDE) % 100000000)).c_str();
+
+	for (size_t i = MIN_COLUMNS; i < oRow.Table().ColumnCount(); ++i)
+	{
+		switch (i % 3)
+		{
+			case 0:		oRow[i] = static_cast<int64>(nRow) * 1000;				break;
+			case 1:		oRow[i] = static_cast<double>(nRow) / 8.0;				break;
+			default:	oRow[i] = Core::fmt(TXT("Value %u"), static_cast<uint>(nRow)).c_str();	break;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create the benchmarks to run against the data.
+
+void CreateBenchmarks(CDataSet& oData, Benchmarks& vBenchmarks)
+{
+	vBenchmarks.push_back(new InsertRowBench(oData));
+	vBenchmarks.push_back(new SelectRowBench(oData));
+	vBenchmarks.push_back(new SelectBench(oData));
+	vBenchmarks.push_back(new OrderByBench(oData));
+	vBenchmarks.push_back(new GroupByBench(oData));
+	vBenchmarks.push_back(new DistinctBench(oData));
+	vBenchmarks.push_back(new JoinBench(oData));
+	vBenchmarks.push_back(new WriteSnapshotBench(oData));
+	vBenchmarks.push_back(new ReadSnapshotBench(oData));
+	vBenchmarks.push_back(new WriteSQLBench(oData));
+	vBenchmarks.push_back(new ReadSQLBench(oData));
+	vBenchmarks.push_back(new BulkLoadBench(oData));
+}
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Benchmarks.hpp
+//! \brief  The MDBL benchmarks.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_BENCHMARKS_HPP
+#define APP_BENCHMARKS_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "Benchmark.hpp"
+#include <MDBL/MDB.hpp>
+#include <MDBL/Table.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+//! The synthetic data the benchmarks are run against. The main table has an
+//! ID column, the ID of a row in the groups table, a name and then as many
+//! extra int64, double and string columns as needed for the width.
+
+class CDataSet /*: private NotCopyable*/
+{
+public:
+	//! Constructor.
+	CDataSet(size_t nRows, size_t nColumns);
+
+	//! Destructor.
+	~CDataSet();
+
+	//! Create the main table's columns.
+	static void CreateSchema(CTable& oTable, size_t nColumns);
+
+	//! Create the groups table's columns.
+	static void CreateGroupsSchema(CTable& oTable);
+
+	//! Fill in a row of the main table.
+	static void FillRow(CRow& oRow, size_t nRow);
+
+	//
+	// Constants.
+	//
+
+	//! The number of groups.
+	static const size_t GROUPS = 100;
+
+	//! The main table column with the unique ID.
+	static const size_t ID_COLUMN = 0;
+
+	//! The main table column with the group ID.
+	static const size_t GROUP_COLUMN = 1;
+
+	//! The main table column with the name.
+	static const size_t NAME_COLUMN = 2;
+
+	//! The minimum number of columns.
+	static const size_t MIN_COLUMNS = 3;
+
+	//
+	// Members.
+	//
+	size_t		m_nRows;		//!< The number of rows.
+	size_t		m_nColumns;		//!< The number of columns.
+	CTable		m_oGroups;		//!< The groups table.
+	CTable		m_oTable;		//!< The main table.
+	CMDB		m_oMDB;			//!< The database holding both tables.
+
+private:
+	// NotCopyable.
+	CDataSet(const CDataSet&);
+	CDataSet& operator=(const CDataSet&);
+};
+
+//! A collection of benchmarks.
+typedef std::vector<CBenchmark*> Benchmarks;
+
+//! Create the benchmarks to run against the data.
+void CreateBenchmarks(CDataSet& oData, Benchmarks& vBenchmarks);
+
+#endif // APP_BENCHMARKS_HPP
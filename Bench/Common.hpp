@@ -0,0 +1,17 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Common.hpp
+//! \brief  File to include the most commonly used headers.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_COMMON_HPP
+#define APP_COMMON_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <MDBL/Common.hpp>
+#include <iostream>
+
+#endif // APP_COMMON_HPP
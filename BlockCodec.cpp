@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   BlockCodec.cpp
+//! \brief  The CBlockCodec class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "BlockCodec.hpp"
+#include "MDBException.hpp"
+#include <algorithm>
+#include <limits.h>
+
+namespace
+{
+
+//! The number of bits used to hash the next MIN_MATCH bytes.
+static const size_t HASH_BITS = 12;
+
+//! The value of a nibble which means that more length bytes follow.
+static const size_t MORE_LENGTH = 15;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Hash the MIN_MATCH bytes at the given position.
+
+inline size_t hashAt(const byte* pData)
+{
+	uint32 nValue;
+
+	memcpy(&nValue, pData, sizeof(nValue));
+
+	return (nValue * 2654435761U) >> (32 - HASH_BITS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the remainder of a length that did not fit in its nibble.
+
+void writeLength(std::vector<byte>& vOutput, size_t nLength)
+{
+	for (; nLength >= 255; nLength -= 255)
+		vOutput.push_back(255);
+
+	vOutput.push_back(static_cast<byte>(nLength));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read the remainder of a length that did not fit in its nibble.
+
+size_t readLength(const byte*& pInput, const byte* pEnd)
+{
+	size_t nLength = 0;
+	byte   bValue  = 255;
+
+	while (bValue == 255)
+	{
+		if (pInput == pEnd)
+			throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("The block is truncated"));
+
+		bValue   = *pInput++;
+		nLength += bValue;
+	}
+
+	return nLength;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a sequence of literals optionally followed by a back-reference. The
+//! final sequence has no back-reference and is marked by a zero length.
+
+void writeSequence(std::vector<byte>& vOutput, const byte* pLiterals, size_t nLiterals, size_t nOffset, size_t nLength)
+{
+	size_t nMatch = (nLength != 0) ? (nLength - CBlockCodec::MIN_MATCH) : 0;
+	byte   bToken = static_cast<byte>((std::min(nLiterals, MORE_LENGTH) << 4) | std::min(nMatch, MORE_LENGTH));
+
+	vOutput.push_back(bToken);
+
+	if (nLiterals >= MORE_LENGTH)
+		writeLength(vOutput, nLiterals - MORE_LENGTH);
+
+	vOutput.insert(vOutput.end(), pLiterals, pLiterals + nLiterals);
+
+	// Final sequence?
+	if (nLength == 0)
+		return;
+
+	vOutput.push_back(static_cast<byte>(nOffset & 0xFF));
+	vOutput.push_back(static_cast<byte>(nOffset >> 8));
+
+	if (nMatch >= MORE_LENGTH)
+		writeLength(vOutput, nMatch - MORE_LENGTH);
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compress a block of data. The output replaces the contents of the vector.
+
+void CBlockCodec::Compress(const byte* pInput, size_t nInput, std::vector<byte>& vOutput)
+{
+	ASSERT(nInput <= UINT_MAX);
+
+	// The position of the last occurence of each hash, plus one.
+	std::vector<uint32> vPositions(1 << HASH_BITS, 0);
+
+	vOutput.clear();
+	vOutput.reserve(nInput + (nInput / 255) + 16);
+
+	size_t nAnchor = 0;
+	size_t nPos    = 0;
+
+	while ((nPos + MIN_MATCH) <= nInput)
+	{
+		size_t nHash      = hashAt(pInput + nPos);
+		size_t nCandidate = vPositions[nHash];
+
+		vPositions[nHash] = static_cast<uint32>(nPos + 1);
+
+		// Not a match?
+		if ( (nCandidate == 0) || ((nPos - (nCandidate-1)) > MAX_OFFSET)
+		  || (memcmp(pInput + nCandidate-1, pInput + nPos, MIN_MATCH) != 0) )
+		{
+			++nPos;
+			continue;
+		}
+
+		size_t nMatch  = nCandidate - 1;
+		size_t nLength = MIN_MATCH;
+
+		// Extend the match.
+		while ( ((nPos + nLength) < nInput) && (pInput[nMatch + nLength] == pInput[nPos + nLength]) )
+			++nLength;
+
+		writeSequence(vOutput, pInput + nAnchor, nPos - nAnchor, nPos - nMatch, nLength);
+
+		nPos   += nLength;
+		nAnchor = nPos;
+	}
+
+	// Write the trailing literals.
+	writeSequence(vOutput, pInput + nAnchor, nInput - nAnchor, 0, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Decompress a block of data into a buffer of the original size. The input
+//! is validated and a CMDBException thrown if it is corrupt.
+
+void CBlockCodec::Decompress(const byte* pInput, size_t nInput, byte* pOutput, size_t nOutput)
+{
+	const byte* pEnd    = pInput + nInput;
+	byte*       pNext   = pOutput;
+	byte*       pOutEnd = pOutput + nOutput;
+
+	for (;;)
+	{
+		if (pInput == pEnd)
+			throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("The block is truncated"));
+
+		byte   bToken    = *pInput++;
+		size_t nLiterals = bToken >> 4;
+
+		if (nLiterals == MORE_LENGTH)
+			nLiterals += readLength(pInput, pEnd);
+
+		if ( (nLiterals > static_cast<size_t>(pEnd - pInput)) || (nLiterals > static_cast<size_t>(pOutEnd - pNext)) )
+			throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("A literal run overflows the block"));
+
+		memcpy(pNext, pInput, nLiterals);
+
+		pInput += nLiterals;
+		pNext  += nLiterals;
+
+		// Final sequence?
+		if (pInput == pEnd)
+			break;
+
+		if ((pEnd - pInput) < 2)
+			throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("The block is truncated"));
+
+		size_t nOffset = pInput[0] | (pInput[1] << 8);
+		size_t nLength = bToken & 0x0F;
+
+		pInput += 2;
+
+		if (nLength == MORE_LENGTH)
+			nLength += readLength(pInput, pEnd);
+
+		nLength += MIN_MATCH;
+
+		if ( (nOffset == 0) || (nOffset > static_cast<size_t>(pNext - pOutput))
+		  || (nLength > static_cast<size_t>(pOutEnd - pNext)) )
+			throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("A back-reference is out of range"));
+
+		const byte* pMatch = pNext - nOffset;
+
+		// Byte by byte as the ranges may overlap.
+		for (size_t i = 0; i != nLength; ++i)
+			pNext[i] = pMatch[i];
+
+		pNext += nLength;
+	}
+
+	if (pNext != pOutEnd)
+		throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("The block is shorter than expected"));
+}
@@ -0,0 +1,42 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   BlockCodec.hpp
+//! \brief  The CBlockCodec class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_BLOCKCODEC_HPP
+#define MDBL_BLOCKCODEC_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A fast LZ77 style compressor for blocks of up to 4 GB. The output is a
+//! series of sequences, each of which is a token byte, a run of literals and
+//! then a back-reference of at least MIN_MATCH bytes within the previous 64 KB.
+//! The token holds the literal count in the high nibble and the match length
+//! (less MIN_MATCH) in the low one, with a nibble of 15 meaning that further
+//! length bytes follow. The final sequence has no back-reference. It trades
+//! ratio for speed and relies on the column encodings, see CRowBlock, to have
+//! already removed most of the redundancy.
+
+class CBlockCodec
+{
+public:
+	//! Compress a block of data.
+	static void Compress(const byte* pInput, size_t nInput, std::vector<byte>& vOutput);
+
+	//! Decompress a block of data into a buffer of the original size.
+	static void Decompress(const byte* pInput, size_t nInput, byte* pOutput, size_t nOutput);
+
+	//! The shortest back-reference.
+	static const size_t MIN_MATCH = 4;
+
+	//! The largest back-reference offset.
+	static const size_t MAX_OFFSET = 65535;
+};
+
+#endif // MDBL_BLOCKCODEC_HPP
@@ -0,0 +1,1068 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   BulkLoader.cpp
+//! \brief  The CBulkLoader class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "BulkLoader.hpp"
+#include "MDBException.hpp"
+#include "Table.hpp"
+#include "Row.hpp"
+#include "Index.hpp"
+#include "VersionStore.hpp"
+#include "TimeStamp.hpp"
+#include "WorkerPool.hpp"
+#include "Trace.hpp"
+#include <tchar.h>
+#include <limits>
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! A read-only view of an entire file.
+
+class FileView /*: private NotCopyable*/
+{
+public:
+	//! Constructor.
+	FileView(const tchar* pszFile)
+		: m_hFile(::CreateFile(pszFile, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL))
+		, m_hMapping(NULL)
+		, m_pBase(nullptr)
+		, m_nSize(0)
+	{
+		if (m_hFile == INVALID_HANDLE_VALUE)
+			throw CMDBException(CMDBException::E_LOAD_IO, Core::fmt(TXT("Failed to open '%s'"), pszFile).c_str());
+
+		LARGE_INTEGER liSize;
+
+		if (!::GetFileSizeEx(m_hFile, &liSize))
+		{
+			Close();
+			throw CMDBException(CMDBException::E_LOAD_IO, Core::fmt(TXT("Failed to query the size of '%s'"), pszFile).c_str());
+		}
+
+		m_nSize = static_cast<size_t>(liSize.QuadPart);
+
+		// An empty file cannot be mapped.
+		if (m_nSize == 0)
+			return;
+
+		m_hMapping = ::CreateFileMapping(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (m_hMapping == NULL)
+		{
+			Close();
+			throw CMDBException(CMDBException::E_LOAD_IO, Core::fmt(TXT("Failed to map '%s'"), pszFile).c_str());
+		}
+
+		m_pBase = static_cast<const byte*>(::MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+
+		if (m_pBase == nullptr)
+		{
+			Close();
+			throw CMDBException(CMDBException::E_LOAD_IO, Core::fmt(TXT("Failed to map a view of '%s'"), pszFile).c_str());
+		}
+	}
+
+	//! Destructor.
+	~FileView()
+	{
+		Close();
+	}
+
+	//! Release the view and handles.
+	void Close()
+	{
+		if (m_pBase != nullptr)
+			::UnmapViewOfFile(m_pBase);
+
+		if (m_hMapping != NULL)
+			::CloseHandle(m_hMapping);
+
+		if (m_hFile != INVALID_HANDLE_VALUE)
+			::CloseHandle(m_hFile);
+
+		m_pBase    = nullptr;
+		m_hMapping = NULL;
+		m_hFile    = INVALID_HANDLE_VALUE;
+	}
+
+	//
+	// Members.
+	//
+	HANDLE		m_hFile;		//!< The file handle.
+	HANDLE		m_hMapping;		//!< The file mapping handle.
+	const byte*	m_pBase;		//!< The start of the view.
+	size_t		m_nSize;		//!< The size of the file.
+
+private:
+	// NotCopyable.
+	FileView(const FileView&);
+	FileView& operator=(const FileView&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert an ASCII letter to lower case.
+
+inline tchar lower(tchar cChar)
+{
+	return ((cChar >= TXT('A')) && (cChar <= TXT('Z'))) ? static_cast<tchar>(cChar + (TXT('a') - TXT('A'))) : cChar;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Check if the text is a word, ignoring case.
+
+bool isWord(const tchar* psz, const tchar* pszEnd, const tchar* pszWord)
+{
+	for (; (psz != pszEnd) && (*pszWord != TXT('\0')); ++psz, ++pszWord)
+	{
+		if (lower(*psz) != *pszWord)
+			return false;
+	}
+
+	return (psz == pszEnd) && (*pszWord == TXT('\0'));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse an unsigned number of a fixed number of digits.
+
+bool parseDigits(const tchar*& psz, const tchar* pszEnd, size_t nDigits, int& nValue)
+{
+	if (static_cast<size_t>(pszEnd - psz) < nDigits)
+		return false;
+
+	nValue = 0;
+
+	for (size_t i = 0; i != nDigits; ++i, ++psz)
+	{
+		if ( (*psz < TXT('0')) || (*psz > TXT('9')) )
+			return false;
+
+		nValue = (nValue * 10) + (*psz - TXT('0'));
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a signed 64-bit integer.
+
+bool parseInt64(const tchar* psz, const tchar* pszEnd, int64& nValue)
+{
+	bool bNegative = false;
+
+	if ( (psz != pszEnd) && ((*psz == TXT('-')) || (*psz == TXT('+'))) )
+		bNegative = (*psz++ == TXT('-'));
+
+	if (psz == pszEnd)
+		return false;
+
+	const uint64 nMax   = static_cast<uint64>(std::numeric_limits<int64>::max());
+	const uint64 nLimit = bNegative ? (nMax + 1) : nMax;
+	uint64       nTotal = 0;
+
+	for (; psz != pszEnd; ++psz)
+	{
+		if ( (*psz < TXT('0')) || (*psz > TXT('9')) )
+			return false;
+
+		uint nDigit = static_cast<uint>(*psz - TXT('0'));
+
+		if (nTotal > ((nLimit - nDigit) / 10))
+			return false;
+
+		nTotal = (nTotal * 10) + nDigit;
+	}
+
+	nValue = bNegative ? static_cast<int64>(0 - nTotal) : static_cast<int64>(nTotal);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a floating-point number.
+
+bool parseDouble(const tchar* psz, const tchar* pszEnd, double& dValue)
+{
+	tchar  szValue[64];
+	size_t nChars = pszEnd - psz;
+
+	if ( (nChars == 0) || (nChars >= ARRAY_SIZE(szValue)) )
+		return false;
+
+	std::copy(psz, pszEnd, szValue);
+	szValue[nChars] = TXT('\0');
+
+	tchar* pszRest = nullptr;
+
+	dValue = _tcstod(szValue, &pszRest);
+
+	return (pszRest == szValue + nChars);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a date and optional time in the format YYYY-MM-DD[ HH:MM[:SS[.fff]]].
+
+bool parseTimeStamp(const tchar* psz, const tchar* pszEnd, CTimeStamp& tsValue)
+{
+	int nYear, nMonth, nDay, nHour = 0, nMinute = 0, nSecond = 0;
+	uint nFraction = 0;
+
+	if (!parseDigits(psz, pszEnd, 4, nYear) || (psz == pszEnd) || (*psz++ != TXT('-'))
+	 || !parseDigits(psz, pszEnd, 2, nMonth) || (psz == pszEnd) || (*psz++ != TXT('-'))
+	 || !parseDigits(psz, pszEnd, 2, nDay))
+		return false;
+
+	if (psz != pszEnd)
+	{
+		if ( ((*psz != TXT(' ')) && (*psz != TXT('T'))) || !parseDigits(++psz, pszEnd, 2, nHour)
+		  || (psz == pszEnd) || (*psz++ != TXT(':')) || !parseDigits(psz, pszEnd, 2, nMinute) )
+			return false;
+
+		if ( (psz != pszEnd) && (*psz == TXT(':')) )
+		{
+			if (!parseDigits(++psz, pszEnd, 2, nSecond))
+				return false;
+
+			// Fraction, in nanoseconds?
+			if ( (psz != pszEnd) && (*psz == TXT('.')) )
+			{
+				uint nScale = 100000000;
+
+				if (++psz == pszEnd)
+					return false;
+
+				for (; psz != pszEnd; ++psz, nScale /= 10)
+				{
+					if ( (*psz < TXT('0')) || (*psz > TXT('9')) )
+						return false;
+
+					nFraction += static_cast<uint>(*psz - TXT('0')) * nScale;
+				}
+			}
+		}
+	}
+
+	if ( (psz != pszEnd) || (nMonth < 1) || (nMonth > 12) || (nDay < 1) || (nDay > 31)
+	  || (nHour > 23) || (nMinute > 59) || (nSecond > 59) )
+		return false;
+
+	tsValue = CTimeStamp(static_cast<SQLSMALLINT>(nYear), static_cast<SQLUSMALLINT>(nMonth), static_cast<SQLUSMALLINT>(nDay),
+						 static_cast<SQLUSMALLINT>(nHour), static_cast<SQLUSMALLINT>(nMinute), static_cast<SQLUSMALLINT>(nSecond),
+						 nFraction);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Orders the values of a unique column the same way as its index, i.e. the
+//! strings are compared case sensitively.
+
+class UniqueLess
+{
+public:
+	//! Constructor.
+	UniqueLess(bool bString)
+		: m_bString(bString)
+	{ }
+
+	//! Compare two values.
+	bool operator()(const CField* pLHS, const CField* pRHS) const
+	{
+		if (m_bString)
+			return (tstrcmp(pLHS->GetString(), pRHS->GetString()) < 0);
+
+		return (pLHS->GetInt() < pRHS->GetInt());
+	}
+
+private:
+	bool	m_bString;	//!< Compare as strings?
+};
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The task used to parse a chunk of the file into rows.
+
+class CBulkLoader::ParseTask : public CWorkerTask
+{
+public:
+	//! Default constructor.
+	ParseTask()
+		: m_pTable(nullptr), m_pFields(nullptr), m_cDelimiter(TXT(',')), m_nColumns(0), m_nRowSize(0), m_nStrings(0)
+		, m_pszBegin(nullptr), m_pszEnd(nullptr), m_vRows(), m_pszError(nullptr), m_pszReason(nullptr)
+	{ }
+
+	//! Parse the rows in the chunk. Parsing stops at the first error.
+	virtual void Run()
+	{
+		std::vector<byte>         vNulls(m_nColumns, true);
+		std::vector<byte>         vData(std::max<size_t>(m_nRowSize, 1), 0);
+		std::vector<tstring>      vStrings(m_nStrings);
+		std::vector<const tchar*> vStrPtrs(std::max<size_t>(m_nStrings, 1), TXT(""));
+
+		try
+		{
+			for (const tchar* psz = m_pszBegin; psz != m_pszEnd; )
+			{
+				// Skip empty lines.
+				if ( (*psz == TXT('\n')) || (*psz == TXT('\r')) )
+				{
+					++psz;
+					continue;
+				}
+
+				psz = ParseRow(psz, vNulls, vData, vStrings);
+
+				if (m_pszError != nullptr)
+					return;
+
+				for (size_t s = 0; s != m_nStrings; ++s)
+					vStrPtrs[s] = vStrings[s].c_str();
+
+				CRow& oRow = m_pTable->CTable::CreateRow();
+
+				m_vRows.push_back(&oRow);
+
+				oRow.Read(reinterpret_cast<const bool*>(&vNulls[0]), &vData[0], &vStrPtrs[0]);
+			}
+		}
+		catch (...)
+		{
+			DeleteRows();
+			throw;
+		}
+	}
+
+	//! Delete the parsed rows.
+	void DeleteRows()
+	{
+		for (size_t r = 0; r != m_vRows.size(); ++r)
+			delete m_vRows[r];
+
+		m_vRows.clear();
+	}
+
+	//
+	// Members.
+	//
+	CTable*					m_pTable;		//!< The table.
+	const Fields*			m_pFields;		//!< The value to column mapping.
+	tchar					m_cDelimiter;	//!< The value separator.
+	size_t					m_nColumns;		//!< The number of table columns.
+	size_t					m_nRowSize;		//!< The size of a row's data region.
+	size_t					m_nStrings;		//!< The number of MDCT_VARSTR columns.
+	const tchar*			m_pszBegin;		//!< The start of the chunk.
+	const tchar*			m_pszEnd;		//!< The end of the chunk.
+	std::vector<CRow*>		m_vRows;		//!< The parsed rows.
+	const tchar*			m_pszError;		//!< The position of the error, if one.
+	const tchar*			m_pszReason;	//!< The reason for the error, if one.
+
+private:
+	//
+	// Internal methods.
+	//
+
+	//! Parse a line into the row buffers. Returns the start of the next line.
+	const tchar* ParseRow(const tchar* psz, std::vector<byte>& vNulls, std::vector<byte>& vData, std::vector<tstring>& vStrings)
+	{
+		const Fields& vFields = *m_pFields;
+		tstring       strValue;
+
+		for (size_t f = 0; f != vFields.size(); ++f)
+		{
+			const Field& oField = vFields[f];
+
+			if (f != 0)
+			{
+				if ( (psz == m_pszEnd) || (*psz != m_cDelimiter) )
+					return Error(psz, TXT("The line has too few values"));
+
+				++psz;
+			}
+
+			const tchar* pszField = psz;
+			const tchar* pszValue = psz;
+			const tchar* pszEnd   = psz;
+			bool         bQuoted  = false;
+
+			// Quoted value?
+			if ( (psz != m_pszEnd) && (*psz == QUOTE) )
+			{
+				bool bEscaped = false;
+
+				bQuoted  = true;
+				pszValue = ++psz;
+
+				for (;;)
+				{
+					if (psz == m_pszEnd)
+						return Error(pszField, TXT("The quoted value is not terminated"));
+
+					if (*psz == QUOTE)
+					{
+						if ( ((psz+1) == m_pszEnd) || (*(psz+1) != QUOTE) )
+							break;
+
+						bEscaped = true;
+						++psz;
+					}
+
+					++psz;
+				}
+
+				pszEnd = psz++;
+
+				// Remove the escaping?
+				if (bEscaped)
+				{
+					strValue.clear();
+
+					for (const tchar* pszChar = pszValue; pszChar != pszEnd; ++pszChar)
+					{
+						strValue += *pszChar;
+
+						if (*pszChar == QUOTE)
+							++pszChar;
+					}
+
+					pszValue = strValue.data();
+					pszEnd   = pszValue + strValue.size();
+				}
+			}
+			else
+			{
+				while ( (psz != m_pszEnd) && (*psz != m_cDelimiter) && (*psz != TXT('\n')) && (*psz != TXT('\r')) )
+				{
+					if (*psz == QUOTE)
+						return Error(psz, TXT("An unquoted value contains a quote"));
+
+					++psz;
+				}
+
+				pszEnd = psz;
+			}
+
+			if (!Convert(oField, pszValue, pszEnd, bQuoted, vNulls, vData, vStrings))
+				return Error(pszField, m_pszReason);
+		}
+
+		// Skip the line ending.
+		if ( (psz != m_pszEnd) && (*psz == TXT('\r')) )
+			++psz;
+
+		if (psz != m_pszEnd)
+		{
+			if (*psz != TXT('\n'))
+				return Error(psz, (*psz == m_cDelimiter) ? TXT("The line has too many values") : TXT("The value is followed by other characters"));
+
+			++psz;
+		}
+
+		return psz;
+	}
+
+	//! Convert a value to the column's storage type.
+	bool Convert(const Field& oField, const tchar* psz, const tchar* pszEnd, bool bQuoted,
+				 std::vector<byte>& vNulls, std::vector<byte>& vData, std::vector<tstring>& vStrings)
+	{
+		bool bString = (oField.m_eType == MDCT_FXDSTR) || (oField.m_eType == MDCT_VARSTR);
+		bool bNull   = (psz == pszEnd) && (!bQuoted || !bString);
+
+		vNulls[oField.m_nColumn] = bNull;
+
+		if (bNull)
+		{
+			if (!oField.m_bNullable)
+				return Failed(TXT("The column cannot be NULL"));
+
+			if (oField.m_eType == MDCT_VARSTR)
+				vStrings[oField.m_nString].clear();
+
+			return true;
+		}
+
+		byte* pValue = &vData[oField.m_nOffset];
+
+		switch (oField.m_eType)
+		{
+			case MDCT_INT:
+			case MDCT_IDENTITY:
+			{
+				int64 nValue;
+
+				if (!parseInt64(psz, pszEnd, nValue) || (nValue < std::numeric_limits<int>::min()) || (nValue > std::numeric_limits<int>::max()))
+					return Failed(TXT("The value is not a valid integer"));
+
+				int nInt = static_cast<int>(nValue);
+				memcpy(pValue, &nInt, sizeof(nInt));
+			}
+			break;
+
+			case MDCT_INT64:
+			{
+				int64 nValue;
+
+				if (!parseInt64(psz, pszEnd, nValue))
+					return Failed(TXT("The value is not a valid integer"));
+
+				memcpy(pValue, &nValue, sizeof(nValue));
+			}
+			break;
+
+			case MDCT_DOUBLE:
+			{
+				double dValue;
+
+				if (!parseDouble(psz, pszEnd, dValue))
+					return Failed(TXT("The value is not a valid number"));
+
+				memcpy(pValue, &dValue, sizeof(dValue));
+			}
+			break;
+
+			case MDCT_CHAR:
+			{
+				if ((pszEnd - psz) != 1)
+					return Failed(TXT("The value is not a single character"));
+
+				memcpy(pValue, psz, sizeof(tchar));
+			}
+			break;
+
+			case MDCT_FXDSTR:
+			{
+				size_t nChars = pszEnd - psz;
+
+				if (nChars > oField.m_nLength)
+					return Failed(TXT("The value is too long for the column"));
+
+				memset(pValue, 0, Core::numBytes<tchar>(oField.m_nLength+1));
+				memcpy(pValue, psz, Core::numBytes<tchar>(nChars));
+			}
+			break;
+
+			case MDCT_VARSTR:
+			{
+				vStrings[oField.m_nString].assign(psz, pszEnd);
+			}
+			break;
+
+			case MDCT_BOOL:
+			{
+				bool bValue;
+
+				if (isWord(psz, pszEnd, TXT("1")) || isWord(psz, pszEnd, TXT("true")))
+					bValue = true;
+				else if (isWord(psz, pszEnd, TXT("0")) || isWord(psz, pszEnd, TXT("false")))
+					bValue = false;
+				else
+					return Failed(TXT("The value is not a valid boolean"));
+
+				memcpy(pValue, &bValue, sizeof(bValue));
+			}
+			break;
+
+			case MDCT_DATETIME:
+			case MDCT_DATE:
+			case MDCT_TIME:
+			{
+				CTimeStamp tsValue;
+
+				if (!parseTimeStamp(psz, pszEnd, tsValue))
+					return Failed(TXT("The value is not a valid date/time"));
+
+				int64 nValue = tsValue.ToTimeT();
+				memcpy(pValue, &nValue, sizeof(nValue));
+			}
+			break;
+
+			case MDCT_TIMESTAMP:
+			{
+				CTimeStamp tsValue;
+
+				if (!parseTimeStamp(psz, pszEnd, tsValue))
+					return Failed(TXT("The value is not a valid date/time"));
+
+				memcpy(pValue, &tsValue, sizeof(tsValue));
+			}
+			break;
+
+			default:
+			{
+				ASSERT_FALSE();
+			}
+			break;
+		}
+
+		return true;
+	}
+
+	//! Record the reason for a conversion failure.
+	bool Failed(const tchar* pszReason)
+	{
+		m_pszReason = pszReason;
+
+		return false;
+	}
+
+	//! Record an error at a position in the chunk.
+	const tchar* Error(const tchar* psz, const tchar* pszReason)
+	{
+		m_pszError  = psz;
+		m_pszReason = pszReason;
+
+		return m_pszEnd;
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+CBulkLoader::CBulkLoader(tchar cDelimiter, uint nFlags, size_t nChunkSize)
+	: m_cDelimiter(cDelimiter)
+	, m_nFlags(nFlags)
+	, m_nChunkSize(nChunkSize)
+{
+	ASSERT( (cDelimiter != QUOTE) && (cDelimiter != TXT('\n')) && (cDelimiter != TXT('\r')) );
+	ASSERT(nChunkSize != 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Load a table from a delimited file, replacing any existing rows. Returns the
+//! number of rows loaded.
+
+size_t CBulkLoader::Load(const tchar* pszFile, CTable& oTable) const
+{
+	FileView oView(pszFile);
+
+	if ((oView.m_nSize % sizeof(tchar)) != 0)
+		throw CMDBException(CMDBException::E_BAD_LOAD, Core::fmt(TXT("The file '%s' is not in the expected character set"), pszFile).c_str());
+
+	const tchar* pszText = reinterpret_cast<const tchar*>(oView.m_pBase);
+
+	return Load(pszText, oView.m_nSize / sizeof(tchar), oTable, pszFile);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Load a table from a buffer of delimited text, replacing any existing rows.
+//! The table is unchanged if the text cannot be parsed. Returns the number of
+//! rows loaded. As with a snapshot the rows are not marked as inserted.
+
+size_t CBulkLoader::Load(const tchar* pszText, size_t nChars, CTable& oTable, const tchar* pszSource) const
+{
+	CTraceScope oTrace(CTraceSink::TABLE_READ, oTable.Name().c_str());
+
+	const tchar* pszBegin = pszText;
+	const tchar* pszEnd   = pszText + nChars;
+
+	// Skip any byte order mark.
+#ifdef _UNICODE
+	if ( (pszText != pszEnd) && (*pszText == 0xFEFF) )
+		++pszText;
+#else
+	if ( (nChars >= 3) && (memcmp(pszText, "\xEF\xBB\xBF", 3) == 0) )
+		pszText += 3;
+#endif
+
+	Fields vFields;
+
+	MapFields(oTable, pszText, pszEnd, pszBegin, vFields);
+
+	std::vector<const tchar*> vBounds;
+
+	SplitChunks(pszText, pszEnd, vBounds);
+
+	size_t                 nColumns = oTable.ColumnCount();
+	size_t                 nStrings = 0;
+	std::vector<ParseTask> vTasks(vBounds.size()-1);
+
+	for (size_t c = 0; c != nColumns; ++c)
+	{
+		if (oTable.Column(c).ColType() == MDCT_VARSTR)
+			++nStrings;
+	}
+
+	for (size_t i = 0; i != vTasks.size(); ++i)
+	{
+		ParseTask& oTask = vTasks[i];
+
+		oTask.m_pTable     = &oTable;
+		oTask.m_pFields    = &vFields;
+		oTask.m_cDelimiter = m_cDelimiter;
+		oTask.m_nColumns   = nColumns;
+		oTask.m_nRowSize   = oTable.m_vColumns.AllocSize();
+		oTask.m_nStrings   = nStrings;
+		oTask.m_pszBegin   = vBounds[i];
+		oTask.m_pszEnd     = vBounds[i+1];
+	}
+
+	try
+	{
+		if ( (m_nFlags & SERIAL) || (vTasks.size() == 1) )
+		{
+			for (size_t i = 0; i != vTasks.size(); ++i)
+				vTasks[i].Run();
+		}
+		else
+		{
+			std::vector<CWorkerTask*> vTaskPtrs(vTasks.size());
+
+			for (size_t i = 0; i != vTasks.size(); ++i)
+				vTaskPtrs[i] = &vTasks[i];
+
+			CWorkerPool::Default().Execute(&vTaskPtrs[0], vTaskPtrs.size());
+		}
+
+		// Report the first error.
+		for (size_t i = 0; i != vTasks.size(); ++i)
+		{
+			if (vTasks[i].m_pszError != nullptr)
+				ParseError(pszBegin, vTasks[i].m_pszError, pszSource, vTasks[i].m_pszReason);
+		}
+
+		CheckUnique(oTable, vTasks, pszSource);
+	}
+	catch (...)
+	{
+		for (size_t i = 0; i != vTasks.size(); ++i)
+			vTasks[i].DeleteRows();
+
+		throw;
+	}
+
+	size_t nRows = AppendRows(oTable, vTasks);
+
+	oTrace.Size(nRows);
+
+	return nRows;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Map the values to the table columns, either in order of the persistent
+//! columns, or by the names on the header line, which is then skipped.
+
+void CBulkLoader::MapFields(CTable& oTable, const tchar*& pszText, const tchar* pszEnd, const tchar* pszSource, Fields& vFields) const
+{
+	size_t              nColumns = oTable.ColumnCount();
+	std::vector<size_t> vOffsets(nColumns);
+	std::vector<size_t> vStrings(nColumns, Core::npos);
+	std::vector<bool>   vMapped(nColumns, false);
+	size_t              nOffset  = 0;
+	size_t              nString  = 0;
+
+	// Find where each column lives in a row.
+	for (size_t c = 0; c != nColumns; ++c)
+	{
+		const CColumn& oColumn = oTable.Column(c);
+
+		vOffsets[c] = nOffset;
+		nOffset += oColumn.AllocSize();
+
+		if (oColumn.ColType() == MDCT_VARSTR)
+			vStrings[c] = nString++;
+	}
+
+	std::vector<size_t> vColumns;
+
+	if (m_nFlags & HEADER)
+	{
+		const tchar* psz = pszText;
+
+		while (psz != pszEnd)
+		{
+			const tchar* pszName = psz;
+
+			while ( (psz != pszEnd) && (*psz != m_cDelimiter) && (*psz != TXT('\n')) && (*psz != TXT('\r')) )
+				++psz;
+
+			tstring strName(pszName, psz);
+
+			// Strip any quotes.
+			if ( (strName.size() >= 2) && (strName[0] == QUOTE) && (strName[strName.size()-1] == QUOTE) )
+				strName = strName.substr(1, strName.size()-2);
+
+			size_t nColumn = Core::npos;
+
+			for (size_t c = 0; (c != nColumns) && (nColumn == Core::npos); ++c)
+			{
+				if (tstricmp(oTable.Column(c).Name(), strName.c_str()) == 0)
+					nColumn = c;
+			}
+
+			if (nColumn == Core::npos)
+				throw CMDBException(CMDBException::E_BAD_LOAD, Core::fmt(TXT("The column '%s' in '%s' is not in the table '%s'"), strName.c_str(), pszSource, oTable.Name().c_str()).c_str());
+
+			vColumns.push_back(nColumn);
+
+			if ( (psz == pszEnd) || (*psz != m_cDelimiter) )
+				break;
+
+			++psz;
+		}
+
+		// Skip the line ending.
+		if ( (psz != pszEnd) && (*psz == TXT('\r')) )
+			++psz;
+
+		if ( (psz != pszEnd) && (*psz == TXT('\n')) )
+			++psz;
+
+		pszText = psz;
+	}
+	else
+	{
+		for (size_t c = 0; c != nColumns; ++c)
+		{
+			const CColumn& oColumn = oTable.Column(c);
+
+			if (!oColumn.Transient() && (oColumn.StgType() != MDST_POINTER))
+				vColumns.push_back(c);
+		}
+	}
+
+	for (size_t i = 0; i != vColumns.size(); ++i)
+	{
+		const CColumn& oColumn = oTable.Column(vColumns[i]);
+		Field          oField;
+
+		if (vMapped[vColumns[i]] || (oColumn.StgType() == MDST_POINTER))
+			throw CMDBException(CMDBException::E_BAD_LOAD, Core::fmt(TXT("The column '%s' cannot be loaded from '%s'"), oColumn.Name().c_str(), pszSource).c_str());
+
+		oField.m_nColumn   = vColumns[i];
+		oField.m_eType     = oColumn.ColType();
+		oField.m_nLength   = oColumn.Length();
+		oField.m_bNullable = oColumn.Nullable();
+		oField.m_nOffset   = vOffsets[vColumns[i]];
+		oField.m_nString   = vStrings[vColumns[i]];
+
+		vMapped[vColumns[i]] = true;
+		vFields.push_back(oField);
+	}
+
+	// Any other column must allow a NULL.
+	for (size_t c = 0; c != nColumns; ++c)
+	{
+		const CColumn& oColumn = oTable.Column(c);
+
+		if (!vMapped[c] && !oColumn.Nullable() && !oColumn.Transient() && (oColumn.StgType() != MDST_POINTER))
+			throw CMDBException(CMDBException::E_BAD_LOAD, Core::fmt(TXT("The column '%s' is not in '%s' and cannot be NULL"), oColumn.Name().c_str(), pszSource).c_str());
+	}
+
+	if (vFields.empty())
+		throw CMDBException(CMDBException::E_BAD_LOAD, Core::fmt(TXT("There are no columns to load into the table '%s'"), oTable.Name().c_str()).c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Split the text into chunks of roughly the chunk size that start at the
+//! beginning of a line, i.e. not within a quoted value. As a quote can only
+//! start or end a value the quotes are counted to find if a line break is
+//! within a value.
+
+void CBulkLoader::SplitChunks(const tchar* pszText, const tchar* pszEnd, std::vector<const tchar*>& vBounds) const
+{
+	const tchar* psz     = pszText;
+	bool         bQuoted = false;
+
+	vBounds.push_back(pszText);
+
+	if (!(m_nFlags & SERIAL))
+	{
+		while (static_cast<size_t>(pszEnd - psz) > m_nChunkSize)
+		{
+			const tchar* pszTarget = psz + m_nChunkSize;
+
+			for (; psz != pszTarget; ++psz)
+			{
+				if (*psz == QUOTE)
+					bQuoted = !bQuoted;
+			}
+
+			for (; psz != pszEnd; ++psz)
+			{
+				if (*psz == QUOTE)
+					bQuoted = !bQuoted;
+				else if ( (*psz == TXT('\n')) && !bQuoted )
+					break;
+			}
+
+			if (psz == pszEnd)
+				break;
+
+			vBounds.push_back(++psz);
+		}
+	}
+
+	vBounds.push_back(pszEnd);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Check the parsed rows for duplicate values in the unique columns, before any
+//! of the existing rows are discarded. NULLs are not duplicates.
+
+void CBulkLoader::CheckUnique(const CTable& oTable, const std::vector<ParseTask>& vTasks, const tchar* pszSource)
+{
+	std::vector<const CField*> vValues;
+
+	for (size_t c = 0; c != oTable.ColumnCount(); ++c)
+	{
+		const CColumn& oColumn = oTable.Column(c);
+
+		if ( (oColumn.Index() == nullptr) || (!oColumn.Unique()) )
+			continue;
+
+		vValues.clear();
+
+		for (size_t t = 0; t != vTasks.size(); ++t)
+		{
+			const std::vector<CRow*>& vRows = vTasks[t].m_vRows;
+
+			for (size_t r = 0; r != vRows.size(); ++r)
+			{
+				const CField& oField = (*vRows[r])[c];
+
+				if (oField != null)
+					vValues.push_back(&oField);
+			}
+		}
+
+		UniqueLess oLess(oColumn.StgType() == MDST_STRING);
+
+		std::sort(vValues.begin(), vValues.end(), oLess);
+
+		for (size_t i = 1; i < vValues.size(); ++i)
+		{
+			if (!oLess(vValues[i-1], vValues[i]))
+				throw CMDBException(CMDBException::E_BAD_LOAD, Core::fmt(TXT("The column '%s' has a duplicate value in '%s'"), oColumn.Name().c_str(), pszSource).c_str());
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Replace the table's rows with the parsed ones and build the indexes in the
+//! same pass. The existing rows are removed as with a Truncate() and the reload
+//! is logged, as a reload from a stream is.
+
+size_t CBulkLoader::AppendRows(CTable& oTable, std::vector<ParseTask>& vTasks)
+{
+	size_t nColumns = oTable.ColumnCount();
+	size_t nRows    = 0;
+	int    nIdent   = 0;
+
+	for (size_t i = 0; i != vTasks.size(); ++i)
+		nRows += vTasks[i].m_vRows.size();
+
+	CReadWriteLock::WriteGuard oGuard(oTable.m_oLock, oTable.Concurrent());
+
+	// Replace the rows as a single change for any read views.
+	CVersionStore::UpdateGuard oUpdate(oTable.m_pVersions);
+
+	// Remove all existing rows.
+	oTable.ReleaseRows();
+	oTable.m_pPending.reset();
+
+	// Prepare any indexes.
+	for (size_t c = 0; c != nColumns; ++c)
+	{
+		CIndex* pIndex = oTable.m_vColumns[c].Index();
+
+		if (pIndex != nullptr)
+			pIndex->Capacity(nRows);
+	}
+
+	size_t t = 0;
+
+	try
+	{
+		for (; t != vTasks.size(); ++t)
+		{
+			std::vector<CRow*>& vRows = vTasks[t].m_vRows;
+
+			for (size_t r = 0; r != vRows.size(); ++r)
+			{
+				CRow& oRow = *vRows[r];
+
+#ifdef _DEBUG
+				// Check row nulls and fkeys.
+				oTable.CheckRow(oRow, false);
+#endif //_DEBUG
+
+				// Update any indexes.
+				for (size_t c = 0; c != nColumns; ++c)
+				{
+					CIndex* pIndex = oTable.m_vColumns[c].Index();
+
+					if (pIndex != nullptr)
+						pIndex->AddRow(oRow);
+				}
+
+				// Stamp it with the next version.
+				if (oTable.m_pVersions != nullptr)
+					oTable.m_pVersions->Inserting(oRow);
+
+				oTable.m_vRows.Add(oRow);
+				oTable.TrackVersion(oRow);
+				vRows[r] = nullptr;
+
+				if ( (oTable.m_nIdentCol != Core::npos) && (oRow[oTable.m_nIdentCol].GetInt() > nIdent) )
+					nIdent = oRow[oTable.m_nIdentCol].GetInt();
+			}
+
+			vRows.clear();
+		}
+	}
+	catch (...)
+	{
+		// Discard the partially loaded table. The rows may have been found
+		// without the lock, so they're unlinked and retired.
+		oTable.TruncateIndexes();
+
+		for (size_t r = 0; r != oTable.m_vRows.Count(); ++r)
+			oTable.FreeRow(oTable.m_vRows[r]);
+
+		oTable.m_vRows.RemoveAll();
+
+		for (; t != vTasks.size(); ++t)
+		{
+			std::vector<CRow*>& vRows = vTasks[t].m_vRows;
+
+			for (size_t r = 0; r != vRows.size(); ++r)
+				delete vRows[r];
+
+			vRows.clear();
+		}
+
+		throw;
+	}
+
+#ifdef _DEBUG
+	// Check index sizes.
+	oTable.CheckIndexes();
+#endif //_DEBUG
+
+	oTable.m_nIdentVal = nIdent;
+
+	oTable.LogReload();
+
+	// Reset modified flags.
+	oTable.m_nInsertions = 0;
+	oTable.m_nUpdates    = 0;
+	oTable.m_nDeletions  = 0;
+	oTable.m_nRefreshes  = 0;
+	oTable.m_vDeletedKeys.DeleteAll();
+
+	return nRows;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Throw an exception for an error at a position in the text. The line number
+//! is only calculated when there is an error.
+
+void CBulkLoader::ParseError(const tchar* pszText, const tchar* pszError, const tchar* pszSource, const tchar* pszReason)
+{
+	size_t nLine = 1 + std::count(pszText, pszError, TXT('\n'));
+
+	throw CMDBException(CMDBException::E_BAD_LOAD, Core::fmt(TXT("%s at line %u of '%s'"), pszReason, static_cast<uint>(nLine), pszSource).c_str());
+}
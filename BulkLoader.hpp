@@ -0,0 +1,120 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   BulkLoader.hpp
+//! \brief  The CBulkLoader class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_BULKLOADER_HPP
+#define MDBL_BULKLOADER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "FwdDecls.hpp"
+#include "MDBLTypes.hpp"
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A loader for tables held in delimited text files, such as CSV files. The
+//! file is mapped into memory and split into chunks at line boundaries which
+//! are parsed concurrently, see CWorkerPool. Each value is converted straight
+//! into the row's storage layout, as described by the table's columns, and the
+//! rows are then appended and the indexes built in a single pass, in the same
+//! way as a snapshot is loaded.
+//!
+//! Each line holds a row and the values are separated by the delimiter. A value
+//! can be enclosed in double quotes, in which case it may contain delimiters
+//! and line breaks and a quote is written as two. An empty value is NULL,
+//! unless quoted when it is an empty string. Empty lines are ignored. Boolean
+//! values are 1, 0, true or false and date/time values are in the ISO format
+//! "YYYY-MM-DD[ HH:MM[:SS[.fff]]]". The file must be in the build's character
+//! set, as with a snapshot, although a leading byte order mark is skipped.
+//!
+//! The values map to the table's persistent columns in order or, if the file
+//! has a header line, to the columns named by it. Any other column is NULL.
+//!
+//! If the text is invalid, or has duplicate values in a unique column, the
+//! table is left unchanged. Otherwise the existing rows are removed as with a
+//! Truncate() and, if the table has a change log, the reload is logged.
+
+class CBulkLoader /*: private NotCopyable*/
+{
+public:
+	//! The loader options.
+	enum Flags
+	{
+		DEFAULTS   = 0x0000,	//!< No header and parse concurrently.
+		HEADER     = 0x0001,	//!< The first line holds the column names.
+		SERIAL     = 0x0002,	//!< Parse on the calling thread only.
+	};
+
+	//! Constructor.
+	CBulkLoader(tchar cDelimiter = TXT(','), uint nFlags = DEFAULTS, size_t nChunkSize = DEFAULT_CHUNK_SIZE);
+
+	//
+	// Methods.
+	//
+
+	//! Load a table from a delimited file, replacing any existing rows.
+	size_t Load(const tchar* pszFile, CTable& oTable) const;
+
+	//! Load a table from a buffer of delimited text, replacing any existing rows.
+	size_t Load(const tchar* pszText, size_t nChars, CTable& oTable, const tchar* pszSource = TXT("text")) const;
+
+	//
+	// Constants.
+	//
+
+	//! The default size of the chunks parsed concurrently, in characters.
+	static const size_t DEFAULT_CHUNK_SIZE = 1024 * 1024;
+
+	//! The character used to quote a value.
+	static const tchar QUOTE = TXT('"');
+
+private:
+	//! The mapping of a value in the file to a column.
+	struct Field
+	{
+		size_t	m_nColumn;		//!< The table column.
+		COLTYPE	m_eType;		//!< The column type.
+		size_t	m_nLength;		//!< The column length.
+		bool	m_bNullable;	//!< Can the column be NULL?
+		size_t	m_nOffset;		//!< The offset of the value in the data region.
+		size_t	m_nString;		//!< The MDCT_VARSTR value, if one.
+	};
+
+	//! The collection of fields.
+	typedef std::vector<Field> Fields;
+
+	//! The task used to parse a chunk of the file.
+	class ParseTask;
+
+	//
+	// Members.
+	//
+	tchar	m_cDelimiter;	//!< The value separator.
+	uint	m_nFlags;		//!< The loader options.
+	size_t	m_nChunkSize;	//!< The size of the chunks parsed concurrently.
+
+	//
+	// Internal methods.
+	//
+
+	//! Map the values to the table columns.
+	void MapFields(CTable& oTable, const tchar*& pszText, const tchar* pszEnd, const tchar* pszSource, Fields& vFields) const;
+
+	//! Split the text into chunks that start at a line boundary.
+	void SplitChunks(const tchar* pszText, const tchar* pszEnd, std::vector<const tchar*>& vBounds) const;
+
+	//! Check the parsed rows for duplicate values in the unique columns.
+	static void CheckUnique(const CTable& oTable, const std::vector<ParseTask>& vTasks, const tchar* pszSource);
+
+	//! Append the parsed rows to the table and build the indexes.
+	static size_t AppendRows(CTable& oTable, std::vector<ParseTask>& vTasks);
+
+	//! Throw an exception for an error at a position in the text.
+	static void ParseError(const tchar* pszText, const tchar* pszError, const tchar* pszSource, const tchar* pszReason);
+};
+
+#endif // MDBL_BULKLOADER_HPP
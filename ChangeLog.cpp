@@ -0,0 +1,841 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ChangeLog.cpp
+//! \brief  The CChangeLog class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "ChangeLog.hpp"
+#include "MDBException.hpp"
+#include "MDB.hpp"
+#include "Table.hpp"
+#include "Row.hpp"
+#include <process.h>
+#include <string.h>
+
+namespace
+{
+
+//! The file signature.
+const char SIGNATURE[8] = { 'M', 'D', 'B', 'L', 'W', 'L', 'O', 'G' };
+
+//! The size of the record frame, i.e. the payload length and checksum.
+const size_t FRAME_SIZE = 2 * sizeof(uint32);
+
+////////////////////////////////////////////////////////////////////////////////
+//! Calculate the checksum of a record payload (32-bit FNV-1a).
+
+uint32 checksum(const byte* pData, size_t nBytes)
+{
+	uint32 nHash = 2166136261u;
+
+	for (size_t i = 0; i != nBytes; ++i)
+	{
+		nHash ^= pData[i];
+		nHash *= 16777619u;
+	}
+
+	return nHash;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a block of data to a buffer.
+
+void appendBytes(std::vector<byte>& vBuffer, const void* pData, size_t nBytes)
+{
+	const byte* pBytes = static_cast<const byte*>(pData);
+
+	vBuffer.insert(vBuffer.end(), pBytes, pBytes + nBytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a value to a buffer.
+
+template<typename T>
+void append(std::vector<byte>& vBuffer, const T& tValue)
+{
+	appendBytes(vBuffer, &tValue, sizeof(T));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the entire block of data to the file.
+
+bool writeAll(HANDLE hFile, const byte* pData, size_t nBytes)
+{
+	while (nBytes != 0)
+	{
+		DWORD dwChunk   = static_cast<DWORD>(std::min<size_t>(nBytes, 0x10000000));
+		DWORD dwWritten = 0;
+
+		if (!::WriteFile(hFile, pData, dwChunk, &dwWritten, nullptr) || (dwWritten != dwChunk))
+			return false;
+
+		pData  += dwChunk;
+		nBytes -= dwChunk;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read the entire contents of the file.
+
+void readAll(HANDLE hFile, const tchar* pszFile, std::vector<byte>& vFile)
+{
+	LARGE_INTEGER liSize, liStart;
+
+	liStart.QuadPart = 0;
+
+	if (!::GetFileSizeEx(hFile, &liSize) || !::SetFilePointerEx(hFile, liStart, nullptr, FILE_BEGIN))
+		throw CMDBException(CMDBException::E_CHANGELOG_IO, Core::fmt(TXT("Failed to query the size of '%s'"), pszFile).c_str());
+
+	vFile.resize(static_cast<size_t>(liSize.QuadPart));
+
+	size_t nOffset = 0;
+
+	while (nOffset != vFile.size())
+	{
+		DWORD dwChunk = static_cast<DWORD>(std::min<size_t>(vFile.size() - nOffset, 0x10000000));
+		DWORD dwRead  = 0;
+
+		if (!::ReadFile(hFile, &vFile[nOffset], dwChunk, &dwRead, nullptr) || (dwRead == 0))
+			throw CMDBException(CMDBException::E_CHANGELOG_IO, Core::fmt(TXT("Failed to read from '%s'"), pszFile).c_str());
+
+		nOffset += dwRead;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Validate the file header.
+
+void checkHeader(const tchar* pszFile, const std::vector<byte>& vFile)
+{
+	CChangeLog::FileHeader oHeader;
+
+	if (vFile.size() < sizeof(oHeader))
+		throw CMDBException(CMDBException::E_BAD_CHANGELOG, Core::fmt(TXT("The file '%s' is truncated"), pszFile).c_str());
+
+	memcpy(&oHeader, &vFile[0], sizeof(oHeader));
+
+	if (memcmp(oHeader.m_achMagic, SIGNATURE, sizeof(SIGNATURE)) != 0)
+		throw CMDBException(CMDBException::E_BAD_CHANGELOG, Core::fmt(TXT("The file '%s' is not a change log"), pszFile).c_str());
+
+	if ( (oHeader.m_nVersion != CChangeLog::VERSION) || (oHeader.m_nCharSize != sizeof(tchar)) )
+		throw CMDBException(CMDBException::E_BAD_CHANGELOG, Core::fmt(TXT("The change log '%s' is an unsupported version"), pszFile).c_str());
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! A bounds checked reader for a single record payload.
+
+class CChangeLog::RecordReader
+{
+public:
+	//! Constructor.
+	RecordReader(const byte* pData, size_t nBytes)
+		: m_pData(pData)
+		, m_pEnd(pData + nBytes)
+	{
+	}
+
+	//! Get the number of unread bytes.
+	size_t Remaining() const
+	{
+		return m_pEnd - m_pData;
+	}
+
+	//! Read a block of data.
+	void ReadBytes(void* pBuffer, size_t nBytes)
+	{
+		if (nBytes > Remaining())
+			throw CMDBException(CMDBException::E_BAD_CHANGELOG, TXT("A change log record is truncated"));
+
+		memcpy(pBuffer, m_pData, nBytes);
+		m_pData += nBytes;
+	}
+
+	//! Read a value.
+	template<typename T>
+	T Read()
+	{
+		T tValue;
+
+		ReadBytes(&tValue, sizeof(T));
+
+		return tValue;
+	}
+
+private:
+	//
+	// Members.
+	//
+	const byte*	m_pData;	//!< The next byte to read.
+	const byte*	m_pEnd;		//!< The end of the payload.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor. The log file is created if it doesn't exist, otherwise any
+//! trailing uncommitted records are discarded and new ones are appended.
+
+CChangeLog::CChangeLog(const tchar* pszFile, DWORD dwFlushInterval)
+	: m_strPath(pszFile)
+	, m_hFile(OpenFile(pszFile))
+	, m_dwInterval(dwFlushInterval)
+	, m_vPending()
+	, m_nAppended(0)
+	, m_nDurable(0)
+	, m_nWaiters(0)
+	, m_bFailed(false)
+	, m_hWake(::CreateEvent(nullptr, FALSE, FALSE, nullptr))
+	, m_hFlushed(::CreateSemaphore(nullptr, 0, LONG_MAX, nullptr))
+	, m_hThread(NULL)
+	, m_nStop(FALSE)
+{
+	ASSERT(m_hWake != NULL);
+	ASSERT(m_hFlushed != NULL);
+
+	::InitializeCriticalSection(&m_oFileLock);
+	::InitializeCriticalSection(&m_oLock);
+
+	uintptr_t hThread = ::_beginthreadex(nullptr, 0, ThreadFn, this, 0, nullptr);
+
+	ASSERT(hThread != 0);
+
+	m_hThread = reinterpret_cast<HANDLE>(hThread);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. Any pending records are written before the log is closed.
+
+CChangeLog::~CChangeLog()
+{
+	// Signal the flusher to stop and wake it.
+	::InterlockedExchange(&m_nStop, TRUE);
+	::SetEvent(m_hWake);
+
+	::WaitForSingleObject(m_hThread, INFINITE);
+	::CloseHandle(m_hThread);
+
+	ASSERT(m_nWaiters == 0);
+
+	::DeleteCriticalSection(&m_oLock);
+	::DeleteCriticalSection(&m_oFileLock);
+
+	::CloseHandle(m_hFlushed);
+	::CloseHandle(m_hWake);
+	::CloseHandle(m_hFile);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Open the file and discard any uncommitted records. These must be removed as
+//! any new commit marker would otherwise apply to them as well.
+
+HANDLE CChangeLog::OpenFile(const tchar* pszFile)
+{
+	HANDLE hFile = ::CreateFile(pszFile, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		throw CMDBException(CMDBException::E_CHANGELOG_IO, Core::fmt(TXT("Failed to open '%s'"), pszFile).c_str());
+
+	try
+	{
+		Buffer vFile;
+
+		readAll(hFile, pszFile, vFile);
+
+		LARGE_INTEGER liEnd;
+
+		// New file?
+		if (vFile.empty())
+		{
+			FileHeader oHeader;
+
+			memset(&oHeader, 0, sizeof(oHeader));
+			memcpy(oHeader.m_achMagic, SIGNATURE, sizeof(SIGNATURE));
+
+			oHeader.m_nVersion  = VERSION;
+			oHeader.m_nCharSize = sizeof(tchar);
+
+			if (!writeAll(hFile, reinterpret_cast<const byte*>(&oHeader), sizeof(oHeader)) || !::FlushFileBuffers(hFile))
+				throw CMDBException(CMDBException::E_CHANGELOG_IO, Core::fmt(TXT("Failed to write to '%s'"), pszFile).c_str());
+
+			liEnd.QuadPart = sizeof(oHeader);
+		}
+		else
+		{
+			checkHeader(pszFile, vFile);
+
+			liEnd.QuadPart = CommittedLength(vFile);
+		}
+
+		if (!::SetFilePointerEx(hFile, liEnd, nullptr, FILE_BEGIN) || !::SetEndOfFile(hFile))
+			throw CMDBException(CMDBException::E_CHANGELOG_IO, Core::fmt(TXT("Failed to truncate '%s'"), pszFile).c_str());
+	}
+	catch (...)
+	{
+		::CloseHandle(hFile);
+		throw;
+	}
+
+	return hFile;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Log a row insertion. All the field values are recorded.
+
+void CChangeLog::LogInsert(const CRow& oRow)
+{
+	const CTable& oTable = oRow.Table();
+	Buffer        vRecord;
+
+	BeginRecord(vRecord, INSERT_ROW, oTable);
+
+	for (size_t c = 0; c != oTable.ColumnCount(); ++c)
+		WriteField(vRecord, oRow[c]);
+
+	Append(vRecord);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Log a field update. The row is identified by its key column.
+
+void CChangeLog::LogUpdate(const CRow& oRow, size_t nColumn)
+{
+	const CTable& oTable = oRow.Table();
+	Buffer        vRecord;
+
+	BeginRecord(vRecord, UPDATE_FIELD, oTable);
+	WriteField(vRecord, oRow[KeyColumn(oTable)]);
+	append(vRecord, static_cast<uint16>(nColumn));
+	WriteField(vRecord, oRow[nColumn]);
+
+	Append(vRecord);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Log a row deletion. The row is identified by its key column.
+
+void CChangeLog::LogDelete(const CRow& oRow)
+{
+	const CTable& oTable = oRow.Table();
+	Buffer        vRecord;
+
+	BeginRecord(vRecord, DELETE_ROW, oTable);
+	WriteField(vRecord, oRow[KeyColumn(oTable)]);
+
+	Append(vRecord);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Log a table truncation.
+
+void CChangeLog::LogTruncate(const CTable& oTable)
+{
+	Buffer vRecord;
+
+	BeginRecord(vRecord, TRUNCATE, oTable);
+
+	Append(vRecord);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Mark the end of a set of changes. If bWait is true the call blocks until the
+//! changes are on disk, otherwise they are written on the next periodic flush.
+//! Throws a CMDBException if the log can no longer be written.
+
+void CChangeLog::Commit(bool bWait)
+{
+	Buffer vRecord(1, static_cast<byte>(COMMIT));
+
+	uint64 nTarget = Append(vRecord);
+
+	if (bWait)
+		::SetEvent(m_hWake);
+
+	::EnterCriticalSection(&m_oLock);
+
+	// Wait for a flush that covers our commit.
+	while ( (bWait) && (m_nDurable < nTarget) && (!m_bFailed) )
+	{
+		++m_nWaiters;
+
+		::LeaveCriticalSection(&m_oLock);
+		::WaitForSingleObject(m_hFlushed, INFINITE);
+		::EnterCriticalSection(&m_oLock);
+	}
+
+	bool bFailed = m_bFailed;
+
+	::LeaveCriticalSection(&m_oLock);
+
+	if (bFailed)
+		throw CMDBException(CMDBException::E_CHANGELOG_IO, Core::fmt(TXT("Failed to write to '%s'"), m_strPath.c_str()).c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard the contents of the log. This is used once a snapshot has been taken
+//! and so no changes must be made between writing the snapshot and calling this.
+
+void CChangeLog::Truncate()
+{
+	::EnterCriticalSection(&m_oFileLock);
+	::EnterCriticalSection(&m_oLock);
+
+	// Anything pending is now in the snapshot.
+	m_vPending.clear();
+	m_nDurable = m_nAppended;
+
+	uint nWaiters = m_nWaiters;
+	m_nWaiters = 0;
+
+	::LeaveCriticalSection(&m_oLock);
+
+	LARGE_INTEGER liEnd;
+
+	liEnd.QuadPart = sizeof(FileHeader);
+
+	bool bOK = ::SetFilePointerEx(m_hFile, liEnd, nullptr, FILE_BEGIN) && ::SetEndOfFile(m_hFile)
+	        && ::FlushFileBuffers(m_hFile);
+
+	if (!bOK)
+	{
+		::EnterCriticalSection(&m_oLock);
+		m_bFailed = true;
+		::LeaveCriticalSection(&m_oLock);
+	}
+
+	::LeaveCriticalSection(&m_oFileLock);
+
+	if (nWaiters != 0)
+		::ReleaseSemaphore(m_hFlushed, nWaiters, nullptr);
+
+	if (!bOK)
+		throw CMDBException(CMDBException::E_CHANGELOG_IO, Core::fmt(TXT("Failed to truncate '%s'"), m_strPath.c_str()).c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a record to the pending buffer. Returns the log position of the end
+//! of the record. Once a write has failed records are discarded.
+
+uint64 CChangeLog::Append(const Buffer& vRecord)
+{
+	ASSERT(!vRecord.empty());
+
+	uint32 nLength   = static_cast<uint32>(vRecord.size());
+	uint32 nChecksum = checksum(&vRecord[0], vRecord.size());
+
+	::EnterCriticalSection(&m_oLock);
+
+	if (!m_bFailed)
+	{
+		append(m_vPending, nLength);
+		append(m_vPending, nChecksum);
+		m_vPending.insert(m_vPending.end(), vRecord.begin(), vRecord.end());
+
+		m_nAppended += FRAME_SIZE + nLength;
+	}
+
+	uint64 nPosition = m_nAppended;
+
+	::LeaveCriticalSection(&m_oLock);
+
+	return nPosition;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the pending records and flush the file. Every thread waiting at the
+//! time is then released to check whether its commit is now durable.
+
+void CChangeLog::Flush()
+{
+	Buffer vRecords;
+
+	::EnterCriticalSection(&m_oFileLock);
+	::EnterCriticalSection(&m_oLock);
+
+	vRecords.swap(m_vPending);
+	uint64 nPosition = m_nAppended;
+
+	::LeaveCriticalSection(&m_oLock);
+
+	bool bOK = true;
+
+	if (!vRecords.empty())
+		bOK = writeAll(m_hFile, &vRecords[0], vRecords.size()) && ::FlushFileBuffers(m_hFile);
+
+	::EnterCriticalSection(&m_oLock);
+
+	if (bOK)
+		m_nDurable = nPosition;
+	else
+		m_bFailed = true;
+
+	uint nWaiters = m_nWaiters;
+	m_nWaiters = 0;
+
+	::LeaveCriticalSection(&m_oLock);
+	::LeaveCriticalSection(&m_oFileLock);
+
+	if (nWaiters != 0)
+		::ReleaseSemaphore(m_hFlushed, nWaiters, nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start a record with its type and the name of the table.
+
+void CChangeLog::BeginRecord(Buffer& vRecord, RecordType eType, const CTable& oTable)
+{
+	const CString& strName = oTable.Name();
+	uint16         nChars  = static_cast<uint16>(strName.Length());
+
+	vRecord.push_back(static_cast<byte>(eType));
+	append(vRecord, nChars);
+	appendBytes(vRecord, strName.c_str(), Core::numBytes<tchar>(nChars));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a field value to a record. Pointer values are not persistent and are
+//! always written as NULL.
+
+void CChangeLog::WriteField(Buffer& vRecord, const CField& oField)
+{
+	const CColumn& oColumn = oField.Column();
+	bool           bNull   = (oField.m_bNull) || (oColumn.StgType() == MDST_POINTER);
+
+	vRecord.push_back(static_cast<byte>(bNull));
+
+	if (bNull)
+		return;
+
+	if (oColumn.ColType() == MDCT_VARSTR)
+	{
+		uint32 nChars = static_cast<uint32>(tstrlen(oField.m_pString));
+
+		append(vRecord, nChars);
+		appendBytes(vRecord, oField.m_pString, Core::numBytes<tchar>(nChars));
+	}
+	else
+	{
+		appendBytes(vRecord, oField.m_pVoidPtr, oColumn.AllocSize());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a field value from a record directly into the field.
+
+void CChangeLog::ReadField(RecordReader& oReader, CField& oField)
+{
+	const CColumn& oColumn = oField.Column();
+	bool           bNull   = (oReader.Read<byte>() != 0);
+
+	if (oColumn.StgType() == MDST_POINTER)
+		return;
+
+	if ( (bNull) && (!oColumn.Nullable()) )
+		throw CMDBException(CMDBException::E_BAD_CHANGELOG, Core::fmt(TXT("The column '%s' cannot be NULL"), oColumn.Name().c_str()).c_str());
+
+	oField.m_bNull = bNull;
+
+	if (bNull)
+		return;
+
+	if (oColumn.ColType() == MDCT_VARSTR)
+	{
+		ASSERT(!oField.Row().Mapped());
+
+		size_t nChars = oReader.Read<uint32>();
+
+		if (Core::numBytes<tchar>(nChars) > oReader.Remaining())
+			throw CMDBException(CMDBException::E_BAD_CHANGELOG, TXT("A change log record is truncated"));
+
+		oField.ResizeString(nChars);
+
+		oReader.ReadBytes(oField.m_pString, Core::numBytes<tchar>(nChars));
+
+		oField.m_pString[nChars] = TXT('\0');
+	}
+	else
+	{
+		oReader.ReadBytes(oField.m_pVoidPtr, oColumn.AllocSize());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the key column used to identify a tables rows, see CTable::KeyColumn().
+//! Throws a CMDBException if the table has none.
+
+size_t CChangeLog::KeyColumn(const CTable& oTable)
+{
+	size_t nKey = oTable.KeyColumn();
+
+	if (nKey == Core::npos)
+		throw CMDBException(CMDBException::E_NO_KEY_COLUMN, Core::fmt(TXT("The table '%s' has no indexed unique column"), oTable.Name().c_str()).c_str());
+
+	return nKey;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the end of the last committed record. The scan stops at the first torn
+//! or corrupt record.
+
+size_t CChangeLog::CommittedLength(const Buffer& vFile)
+{
+	ASSERT(vFile.size() >= sizeof(FileHeader));
+
+	size_t nOffset    = sizeof(FileHeader);
+	size_t nCommitted = nOffset;
+
+	while ((vFile.size() - nOffset) >= FRAME_SIZE)
+	{
+		uint32 nLength, nChecksum;
+
+		memcpy(&nLength,   &vFile[nOffset],                  sizeof(nLength));
+		memcpy(&nChecksum, &vFile[nOffset + sizeof(uint32)], sizeof(nChecksum));
+
+		if ( (nLength == 0) || (nLength > (vFile.size() - nOffset - FRAME_SIZE)) )
+			break;
+
+		const byte* pPayload = &vFile[nOffset + FRAME_SIZE];
+
+		if (checksum(pPayload, nLength) != nChecksum)
+			break;
+
+		nOffset += FRAME_SIZE + nLength;
+
+		if (pPayload[0] == COMMIT)
+			nCommitted = nOffset;
+	}
+
+	return nCommitted;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Replay the committed changes in a log file. The database should have just
+//! been loaded from the snapshot the log was started from. Any logs attached to
+//! the tables are detached while the changes are applied. Returns the number of
+//! changes applied, a missing log file is treated as an empty one.
+
+size_t CChangeLog::Replay(const tchar* pszFile, CMDB& oMDB)
+{
+	HANDLE hFile = ::CreateFile(pszFile, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+	{
+		if (::GetLastError() == ERROR_FILE_NOT_FOUND)
+			return 0;
+
+		throw CMDBException(CMDBException::E_CHANGELOG_IO, Core::fmt(TXT("Failed to open '%s'"), pszFile).c_str());
+	}
+
+	Buffer vFile;
+
+	try
+	{
+		readAll(hFile, pszFile, vFile);
+	}
+	catch (...)
+	{
+		::CloseHandle(hFile);
+		throw;
+	}
+
+	::CloseHandle(hFile);
+
+	if (vFile.empty())
+		return 0;
+
+	checkHeader(pszFile, vFile);
+
+	size_t nEnd     = CommittedLength(vFile);
+	size_t nOffset  = sizeof(FileHeader);
+	size_t nChanges = 0;
+
+	std::vector<CChangeLog*> vLogs(oMDB.TableCount());
+
+	// Stop the changes being logged again.
+	for (size_t t = 0; t != oMDB.TableCount(); ++t)
+	{
+		vLogs[t] = oMDB[t].m_pChangeLog;
+		oMDB[t].m_pChangeLog = nullptr;
+	}
+
+	try
+	{
+		while (nOffset != nEnd)
+		{
+			uint32 nLength;
+
+			memcpy(&nLength, &vFile[nOffset], sizeof(nLength));
+
+			const byte* pPayload = &vFile[nOffset + FRAME_SIZE];
+
+			if (pPayload[0] != COMMIT)
+			{
+				RecordReader oReader(pPayload, nLength);
+
+				ApplyRecord(oReader, oMDB);
+				++nChanges;
+			}
+
+			nOffset += FRAME_SIZE + nLength;
+		}
+	}
+	catch (...)
+	{
+		for (size_t t = 0; t != vLogs.size(); ++t)
+			oMDB[t].m_pChangeLog = vLogs[t];
+
+		throw;
+	}
+
+	for (size_t t = 0; t != vLogs.size(); ++t)
+		oMDB[t].m_pChangeLog = vLogs[t];
+
+	return nChanges;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Apply a single record to the database. Inserted rows are given the identity
+//! value they were originally assigned.
+
+void CChangeLog::ApplyRecord(RecordReader& oReader, CMDB& oMDB)
+{
+	RecordType eType  = static_cast<RecordType>(oReader.Read<byte>());
+	size_t     nChars = oReader.Read<uint16>();
+
+	std::vector<tchar> vName(nChars+1);
+
+	oReader.ReadBytes(&vName[0], Core::numBytes<tchar>(nChars));
+	vName[nChars] = TXT('\0');
+
+	size_t nTable = oMDB.FindTable(&vName[0]);
+
+	if (nTable == Core::npos)
+		throw CMDBException(CMDBException::E_BAD_CHANGELOG, Core::fmt(TXT("The table '%s' does not exist"), &vName[0]).c_str());
+
+	CTable& oTable = oMDB[nTable];
+
+	switch (eType)
+	{
+		case INSERT_ROW:
+		{
+			CRow& oRow = oTable.CreateRow();
+
+			try
+			{
+				for (size_t c = 0; c != oTable.ColumnCount(); ++c)
+					ReadField(oReader, oRow[c]);
+
+				// Restore the original identity value.
+				if (oTable.m_nIdentCol != Core::npos)
+					oTable.m_nIdentVal = oRow[oTable.m_nIdentCol].GetInt() - 1;
+
+				oTable.InsertRow(oRow);
+			}
+			catch (...)
+			{
+				delete &oRow;
+				throw;
+			}
+		}
+		break;
+
+		case UPDATE_FIELD:
+		{
+			CRow&  oRow    = FindRow(oReader, oTable);
+			size_t nColumn = oReader.Read<uint16>();
+
+			if (nColumn >= oTable.ColumnCount())
+				throw CMDBException(CMDBException::E_BAD_CHANGELOG, Core::fmt(TXT("The table '%s' has no column %u"), oTable.Name().c_str(), static_cast<uint>(nColumn)).c_str());
+
+			CField& oField = oRow[nColumn];
+
+			// Keep the current value for any read views.
+			oField.Updating();
+
+			try
+			{
+				ReadField(oReader, oField);
+			}
+			catch (...)
+			{
+				oField.Updated();
+				throw;
+			}
+
+			oField.Updated();
+		}
+		break;
+
+		case DELETE_ROW:
+		{
+			oTable.DeleteRow(FindRow(oReader, oTable));
+		}
+		break;
+
+		case TRUNCATE:
+		{
+			oTable.Truncate();
+		}
+		break;
+
+		case COMMIT:
+		default:
+		{
+			throw CMDBException(CMDBException::E_BAD_CHANGELOG, Core::fmt(TXT("Invalid record type %u"), static_cast<uint>(eType)).c_str());
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a key value from a record and find the row in the table. Throws a
+//! CMDBException if no row has the key.
+
+CRow& CChangeLog::FindRow(RecordReader& oReader, CTable& oTable)
+{
+	size_t nKey = KeyColumn(oTable);
+	CRow&  oKey = oTable.CTable::CreateRow();
+	CRow*  pRow = nullptr;
+
+	try
+	{
+		ReadField(oReader, oKey[nKey]);
+
+		if (oKey[nKey] != null)
+			pRow = oTable.SelectRow(nKey, oKey[nKey].ToValue());
+	}
+	catch (...)
+	{
+		delete &oKey;
+		throw;
+	}
+
+	delete &oKey;
+
+	if (pRow == nullptr)
+		throw CMDBException(CMDBException::E_BAD_CHANGELOG, Core::fmt(TXT("A logged row is missing from the table '%s'"), oTable.Name().c_str()).c_str());
+
+	return *pRow;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The flusher thread entry point. The pending records are written whenever a
+//! waiting commit signals or the flush interval expires, and once more when the
+//! log is closed.
+
+unsigned __stdcall CChangeLog::ThreadFn(void* pParam)
+{
+	CChangeLog* pLog = static_cast<CChangeLog*>(pParam);
+
+	while (pLog->m_nStop == FALSE)
+	{
+		::WaitForSingleObject(pLog->m_hWake, pLog->m_dwInterval);
+
+		pLog->Flush();
+	}
+
+	// Write anything appended since.
+	pLog->Flush();
+
+	return 0;
+}
@@ -0,0 +1,179 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ChangeLog.hpp
+//! \brief  The CChangeLog class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_CHANGELOG_HPP
+#define MDBL_CHANGELOG_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "FwdDecls.hpp"
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//! An append-only write-ahead log of the changes made to a set of tables. Once
+//! attached to a table, see CTable::ChangeLog(), every InsertRow(), DeleteRow(),
+//! Truncate() and field update is appended as a compact binary record. Rows are
+//! identified by the value of their key column, which is the PRIMARY_KEY column
+//! or else the first UNIQUE one.
+//!
+//! Records are buffered in memory and written by a background thread. Commit()
+//! appends a commit marker and optionally waits for it to be flushed to disk;
+//! concurrent commits are batched so that a single FlushFileBuffers() call
+//! makes all of them durable (group commit).
+//!
+//! Recovery consists of loading the last snapshot and then replaying the log,
+//! see CMDB::Recover(). Only committed changes are replayed, any trailing
+//! uncommitted or torn records are ignored. After a new snapshot has been taken
+//! the log can be emptied with Truncate(), see CMDB::Checkpoint().
+
+class CChangeLog /*: private NotCopyable*/
+{
+public:
+	//! Constructor.
+	CChangeLog(const tchar* pszFile, DWORD dwFlushInterval = DEFAULT_FLUSH_INTERVAL);
+
+	//! Destructor.
+	~CChangeLog();
+
+	//
+	// Properties.
+	//
+
+	//! Get the path of the log file.
+	const CString& Path() const;
+
+	//
+	// Logging methods.
+	//
+
+	//! Log a row insertion.
+	void LogInsert(const CRow& oRow);
+
+	//! Log a field update.
+	void LogUpdate(const CRow& oRow, size_t nColumn);
+
+	//! Log a row deletion.
+	void LogDelete(const CRow& oRow);
+
+	//! Log a table truncation.
+	void LogTruncate(const CTable& oTable);
+
+	//! Mark the end of a set of changes.
+	void Commit(bool bWait = true);
+
+	//! Discard the contents of the log.
+	void Truncate();
+
+	//
+	// Class methods.
+	//
+
+	//! Replay the committed changes in a log file.
+	static size_t Replay(const tchar* pszFile, CMDB& oMDB);
+
+	//! Get the key column used to identify a tables rows.
+	static size_t KeyColumn(const CTable& oTable);
+
+	//! The default interval between flushes in ms.
+	static const DWORD DEFAULT_FLUSH_INTERVAL = 50;
+
+	//! The format version.
+	static const uint32 VERSION = 1;
+
+	//! The header at the start of the file.
+	struct FileHeader
+	{
+		char		m_achMagic[8];		//!< The file signature.
+		uint32		m_nVersion;			//!< The format version.
+		uint32		m_nCharSize;		//!< The size of a tchar.
+	};
+
+private:
+	//! The record types.
+	enum RecordType
+	{
+		INSERT_ROW   = 1,	//!< A row was inserted.
+		UPDATE_FIELD = 2,	//!< A field was updated.
+		DELETE_ROW   = 3,	//!< A row was deleted.
+		TRUNCATE     = 4,	//!< A table was truncated.
+		COMMIT       = 5,	//!< The end of a set of changes.
+	};
+
+	//! The type of a record buffer.
+	typedef std::vector<byte> Buffer;
+
+	//! The record payload reader.
+	class RecordReader;
+
+	//
+	// Members.
+	//
+	CString				m_strPath;		//!< The path of the log file.
+	HANDLE				m_hFile;		//!< The log file handle.
+	DWORD				m_dwInterval;	//!< The interval between flushes.
+	CRITICAL_SECTION	m_oFileLock;	//!< The lock for writing to the file.
+	CRITICAL_SECTION	m_oLock;		//!< The lock for the members below.
+	Buffer				m_vPending;		//!< The records waiting to be written.
+	uint64				m_nAppended;	//!< The log position of the last record.
+	uint64				m_nDurable;		//!< The log position flushed to disk.
+	uint				m_nWaiters;		//!< The number of threads waiting on a flush.
+	bool				m_bFailed;		//!< Has a write failed?
+	HANDLE				m_hWake;		//!< Wakes the flusher thread.
+	HANDLE				m_hFlushed;		//!< Releases the waiting threads.
+	HANDLE				m_hThread;		//!< The flusher thread.
+	volatile LONG		m_nStop;		//!< Flag to stop the flusher thread.
+
+	//
+	// Internal methods.
+	//
+
+	//! Open the file and discard any uncommitted records.
+	static HANDLE OpenFile(const tchar* pszFile);
+
+	//! Append a record to the pending buffer.
+	uint64 Append(const Buffer& vRecord);
+
+	//! Write the pending records and flush the file.
+	void Flush();
+
+	//! Start a record.
+	static void BeginRecord(Buffer& vRecord, RecordType eType, const CTable& oTable);
+
+	//! Write a field value to a record.
+	static void WriteField(Buffer& vRecord, const CField& oField);
+
+	//! Read a field value from a record.
+	static void ReadField(RecordReader& oReader, CField& oField);
+
+	//! Find the end of the last committed record.
+	static size_t CommittedLength(const Buffer& vFile);
+
+	//! Apply a single record to the database.
+	static void ApplyRecord(RecordReader& oReader, CMDB& oMDB);
+
+	//! Find the row identified by the key in a record.
+	static CRow& FindRow(RecordReader& oReader, CTable& oTable);
+
+	//! The flusher thread entry point.
+	static unsigned __stdcall ThreadFn(void* pParam);
+
+private:
+	// NotCopyable.
+	CChangeLog(const CChangeLog&);
+	CChangeLog& operator=(const CChangeLog&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the path of the log file.
+
+inline const CString& CChangeLog::Path() const
+{
+	return m_strPath;
+}
+
+#endif // MDBL_CHANGELOG_HPP
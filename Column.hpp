@@ -51,6 +51,7 @@ public:
 	bool    PrimaryKey() const;
 	bool    ReadOnly() const;
 	bool	Transient() const;
+	bool    RowVersion() const;
 	CTable* FKTable() const;
 	size_t  FKColumn() const;
 	CIndex* Index() const;
@@ -83,6 +84,9 @@ public:
 		PERSISTENT   = 0x0000,
 		TRANSIENT    = 0x0020,
 
+		NOT_VERSION  = 0x0000,
+		ROW_VERSION  = 0x0040,
+
 		// Type specific flags.
 		IGNORE_CASE  = 0x0000,
 		COMPARE_CASE = 0x0100,
@@ -193,6 +197,11 @@ inline bool CColumn::Transient() const
 	return (m_nFlags & TRANSIENT);
 }
 
+inline bool CColumn::RowVersion() const
+{
+	return (m_nFlags & ROW_VERSION);
+}
+
 inline CTable* CColumn::FKTable() const
 {
 	return m_pFKTable;
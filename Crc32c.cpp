@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Crc32c.cpp
+//! \brief  The CCrc32c class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Crc32c.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <nmmintrin.h>
+#endif
+
+namespace
+{
+
+//! The reversed Castagnoli polynomial.
+const uint32 POLYNOMIAL = 0x82F63B78;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The lookup table for the software implementation.
+
+struct LookupTable
+{
+	//! Constructor.
+	LookupTable()
+	{
+		for (uint32 i = 0; i != 256; ++i)
+		{
+			uint32 nValue = i;
+
+			for (int b = 0; b != 8; ++b)
+				nValue = (nValue & 1) ? ((nValue >> 1) ^ POLYNOMIAL) : (nValue >> 1);
+
+			m_anValues[i] = nValue;
+		}
+	}
+
+	//
+	// Members.
+	//
+	uint32	m_anValues[256];	//!< The CRC of each byte value.
+};
+
+//! The lookup table, built during static initialisation.
+const LookupTable s_oTable;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the processor supports the SSE 4.2 CRC32 instruction.
+
+bool detectHardware()
+{
+#ifdef _MSC_VER
+	int anInfo[4];
+
+	__cpuid(anInfo, 1);
+
+	return ((anInfo[2] & (1 << 20)) != 0);
+#else
+	return false;
+#endif
+}
+
+//! Whether the hardware implementation is available.
+const bool s_bHardware = detectHardware();
+
+////////////////////////////////////////////////////////////////////////////////
+//! The software implementation.
+
+uint32 softwareCrc(const byte* pData, size_t nBytes, uint32 nCrc)
+{
+	for (size_t i = 0; i != nBytes; ++i)
+		nCrc = (nCrc >> 8) ^ s_oTable.m_anValues[(nCrc ^ pData[i]) & 0xFF];
+
+	return nCrc;
+}
+
+#ifdef _MSC_VER
+
+////////////////////////////////////////////////////////////////////////////////
+//! The hardware implementation.
+
+uint32 hardwareCrc(const byte* pData, size_t nBytes, uint32 nCrc)
+{
+#ifdef _M_X64
+	uint64 nCrc64 = nCrc;
+
+	for (; nBytes >= sizeof(uint64); nBytes -= sizeof(uint64), pData += sizeof(uint64))
+		nCrc64 = _mm_crc32_u64(nCrc64, *reinterpret_cast<const uint64*>(pData));
+
+	nCrc = static_cast<uint32>(nCrc64);
+#else
+	for (; nBytes >= sizeof(uint32); nBytes -= sizeof(uint32), pData += sizeof(uint32))
+		nCrc = _mm_crc32_u32(nCrc, *reinterpret_cast<const uint32*>(pData));
+#endif
+
+	for (; nBytes != 0; --nBytes, ++pData)
+		nCrc = _mm_crc32_u8(nCrc, *pData);
+
+	return nCrc;
+}
+
+#endif
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Calculate the checksum of a block of data. To checksum data that is split
+//! across several blocks pass the result for the previous block as the
+//! initial value.
+
+uint32 CCrc32c::Calculate(const void* pData, size_t nBytes, uint32 nCrc)
+{
+	const byte* pBytes = static_cast<const byte*>(pData);
+
+	nCrc = ~nCrc;
+
+#ifdef _MSC_VER
+	if (s_bHardware)
+		return ~hardwareCrc(pBytes, nBytes, nCrc);
+#endif
+
+	return ~softwareCrc(pBytes, nBytes, nCrc);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the hardware implementation is being used.
+
+bool CCrc32c::HardwareSupport()
+{
+	return s_bHardware;
+}
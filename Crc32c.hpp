@@ -0,0 +1,29 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Crc32c.hpp
+//! \brief  The CCrc32c class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_CRC32C_HPP
+#define MDBL_CRC32C_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! Calculates the CRC-32C (Castagnoli) checksum of a block of data. The SSE 4.2
+//! CRC32 instruction is used when the processor supports it, otherwise a table
+//! driven implementation is used. Both produce the same result.
+
+class CCrc32c
+{
+public:
+	//! Calculate the checksum, optionally continuing a previous one.
+	static uint32 Calculate(const void* pData, size_t nBytes, uint32 nCrc = 0);
+
+	//! Query if the hardware implementation is being used.
+	static bool HardwareSupport();
+};
+
+#endif // MDBL_CRC32C_HPP
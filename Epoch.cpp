@@ -0,0 +1,75 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Epoch.cpp
+//! \brief  The CEpoch class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Epoch.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+CEpoch::CEpoch()
+	: m_nEpoch(0)
+{
+	memset(m_aoSlots, 0, sizeof(m_aoSlots));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+CEpoch::~CEpoch()
+{
+#ifdef _DEBUG
+	for (uint i = 0; i != SLOTS; ++i)
+		ASSERT((m_aoSlots[i].m_anReaders[0] == 0) && (m_aoSlots[i].m_anReaders[1] == 0));
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Wait until all reads started before the call have ended. The caller must
+//! have unlinked the memory it wants to free before calling this.
+
+void CEpoch::WaitForReaders()
+{
+	for (int nPass = 0; nPass != 2; ++nPass)
+	{
+		uint nPrevious = m_nEpoch & 1;
+
+		// Move new readers on to the other counters.
+		::InterlockedIncrement(&m_nEpoch);
+
+		for (uint i = 0; i != SLOTS; ++i)
+		{
+			while (m_aoSlots[i].m_anReaders[nPrevious] != 0)
+				::Sleep(0);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Move on to the next epoch, unless reads counted against the previous one
+//! remain, without waiting. The barrier orders the caller's unlinking of any
+//! memory before the counters are read.
+//!
+//! The first advance after some memory is unlinked in an epoch may have checked
+//! the counters before it was unlinked, so a reader that found it is only known
+//! to have left after two more, see Expired().
+
+bool CEpoch::TryAdvance()
+{
+	::MemoryBarrier();
+
+	LONG nEpoch    = m_nEpoch;
+	uint nPrevious = (nEpoch + 1) & 1;
+
+	for (uint i = 0; i != SLOTS; ++i)
+	{
+		if (m_aoSlots[i].m_anReaders[nPrevious] != 0)
+			return false;
+	}
+
+	::InterlockedIncrement(&m_nEpoch);
+
+	return true;
+}
@@ -0,0 +1,170 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Epoch.hpp
+//! \brief  The CEpoch class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_EPOCH_HPP
+#define MDBL_EPOCH_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! Tracks the readers of a lock-free structure so that its writer can tell when
+//! the memory it has unlinked is no longer referenced, see CHashIndex.
+//!
+//! A reader brackets each traversal with Enter() and Leave(), which count it
+//! against the current epoch in a slot chosen by its thread ID. The slots are
+//! on separate cache lines so that readers on different threads do not contend.
+//! Once the writer has unlinked some memory it calls WaitForReaders(), which
+//! moves on to the next epoch and waits for the readers counted against the
+//! previous one to leave. This is done twice as a reader may have read the old
+//! epoch just before it changed. Only one thread may call WaitForReaders() at a
+//! time.
+//!
+//! A writer that must not block, e.g. because it holds a lock that a reader may
+//! be waiting for, can instead tag the memory it unlinks with Current() and
+//! free it once Expired() says so. TryAdvance() moves on to the next epoch only
+//! if the readers of the previous one have left, and so never waits. The same
+//! epoch must not be advanced by both TryAdvance() and WaitForReaders().
+
+class CEpoch /*: private NotCopyable*/
+{
+public:
+	//! Default constructor.
+	CEpoch();
+
+	//! Destructor.
+	~CEpoch();
+
+	//
+	// Methods.
+	//
+
+	//! Start a read, returning the token to pass to Leave().
+	uint Enter();
+
+	//! End a read.
+	void Leave(uint nToken);
+
+	//! Wait until all reads started before the call have ended.
+	void WaitForReaders();
+
+	//! Get the current epoch, to tag the memory unlinked in it.
+	LONG Current() const;
+
+	//! Move on to the next epoch, unless reads from the previous one remain.
+	bool TryAdvance();
+
+	//! Query if no read can still refer to memory unlinked in the epoch.
+	bool Expired(LONG nEpoch) const;
+
+	//
+	// Guards.
+	//
+	class ReadGuard;
+
+private:
+	//! The number of reader slots.
+	static const uint SLOTS = 32;
+
+	//! The epochs that must pass before memory unlinked in one has expired.
+	static const ULONG GRACE_EPOCHS = 3;
+
+	//! The readers counted in a slot, padded to a cache line.
+	struct Slot
+	{
+		volatile LONG	m_anReaders[2];	//!< The readers in each epoch.
+		byte			m_abPadding[64 - 2*sizeof(LONG)];
+	};
+
+	//
+	// Members.
+	//
+	volatile LONG	m_nEpoch;		//!< The current epoch.
+	Slot			m_aoSlots[SLOTS];	//!< The reader slots.
+
+	// NotCopyable.
+	CEpoch(const CEpoch&);
+	CEpoch& operator=(const CEpoch&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Brackets a read of a lock-free structure for the lifetime of the guard.
+
+class CEpoch::ReadGuard /*: private NotCopyable*/
+{
+public:
+	//! Constructor.
+	ReadGuard(CEpoch& oEpoch);
+
+	//! Destructor.
+	~ReadGuard();
+
+private:
+	CEpoch&		m_oEpoch;		//!< The epoch.
+	uint		m_nToken;		//!< The token returned by Enter().
+
+	// NotCopyable.
+	ReadGuard(const ReadGuard&);
+	ReadGuard& operator=(const ReadGuard&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start a read. The interlocked increment is a full barrier so nothing read
+//! during the traversal can be read before the reader is counted.
+
+inline uint CEpoch::Enter()
+{
+	uint nSlot  = (::GetCurrentThreadId() >> 2) % SLOTS;
+	uint nEpoch = m_nEpoch & 1;
+
+	::InterlockedIncrement(&m_aoSlots[nSlot].m_anReaders[nEpoch]);
+
+	return (nSlot << 1) | nEpoch;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! End a read.
+
+inline void CEpoch::Leave(uint nToken)
+{
+	::InterlockedDecrement(&m_aoSlots[nToken >> 1].m_anReaders[nToken & 1]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the current epoch, to tag the memory unlinked in it.
+
+inline LONG CEpoch::Current() const
+{
+	return m_nEpoch;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if no read can still refer to memory unlinked in the epoch.
+
+inline bool CEpoch::Expired(LONG nEpoch) const
+{
+	return ((static_cast<ULONG>(m_nEpoch) - static_cast<ULONG>(nEpoch)) >= GRACE_EPOCHS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+inline CEpoch::ReadGuard::ReadGuard(CEpoch& oEpoch)
+	: m_oEpoch(oEpoch)
+	, m_nToken(oEpoch.Enter())
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+inline CEpoch::ReadGuard::~ReadGuard()
+{
+	m_oEpoch.Leave(m_nToken);
+}
+
+#endif // MDBL_EPOCH_HPP
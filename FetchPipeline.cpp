@@ -0,0 +1,185 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   FetchPipeline.cpp
+//! \brief  The CFetchPipeline class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "FetchPipeline.hpp"
+#include "SQLException.hpp"
+#include <process.h>
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+CFetchPipeline::CFetchPipeline(IFetchSource& oSource, size_t nBuffers)
+	: m_oSource(oSource)
+	, m_nBuffers(nBuffers)
+	, m_vResults(nBuffers, FINISHED)
+	, m_pError(nullptr)
+	, m_hThread(NULL)
+	, m_hFilled(NULL)
+	, m_hFree(NULL)
+	, m_nStop(FALSE)
+	, m_nNext(0)
+	, m_bHolding(false)
+	, m_bFinished(false)
+{
+	ASSERT(m_nBuffers != 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+CFetchPipeline::~CFetchPipeline()
+{
+	Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start the fetch thread. Every buffer is initially free.
+
+void CFetchPipeline::Start()
+{
+	ASSERT(!Running());
+
+	m_nStop     = FALSE;
+	m_nNext     = 0;
+	m_bHolding  = false;
+	m_bFinished = false;
+
+	const LONG nBuffers = static_cast<LONG>(m_nBuffers);
+
+	m_hFilled = ::CreateSemaphore(nullptr, 0, nBuffers, nullptr);
+	m_hFree   = ::CreateSemaphore(nullptr, nBuffers, nBuffers, nullptr);
+
+	ASSERT( (m_hFilled != NULL) && (m_hFree != NULL) );
+
+	uintptr_t hThread = ::_beginthreadex(nullptr, 0, FetchThread, this, 0, nullptr);
+
+	ASSERT(hThread != 0);
+
+	m_hThread = reinterpret_cast<HANDLE>(hThread);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Stop the fetch thread, if running, cancelling any fetch that is in progress.
+
+void CFetchPipeline::Stop()
+{
+	if (m_hThread != NULL)
+	{
+		::InterlockedExchange(&m_nStop, TRUE);
+
+		m_oSource.CancelFetch();
+
+		::ReleaseSemaphore(m_hFree, 1, nullptr);
+		::WaitForSingleObject(m_hThread, INFINITE);
+		::CloseHandle(m_hThread);
+
+		m_hThread = NULL;
+	}
+
+	if (m_hFilled != NULL)
+		::CloseHandle(m_hFilled);
+
+	if (m_hFree != NULL)
+		::CloseHandle(m_hFree);
+
+	delete m_pError;
+
+	m_hFilled = NULL;
+	m_hFree   = NULL;
+	m_pError  = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Hand back the buffer consumed and wait for the next one to be filled. This
+//! returns false once there are no more rows, or rethrows the error that ended
+//! the fetch.
+
+bool CFetchPipeline::NextBuffer(size_t& nBuffer)
+{
+	ASSERT(Running());
+
+	if (m_bFinished)
+		return false;
+
+	// Free the buffer just consumed.
+	if (m_bHolding)
+		::ReleaseSemaphore(m_hFree, 1, nullptr);
+
+	::WaitForSingleObject(m_hFilled, INFINITE);
+
+	nBuffer     = m_nNext;
+	m_nNext     = (m_nNext + 1) % m_nBuffers;
+	m_bHolding  = true;
+
+	const Result eResult = m_vResults[nBuffer];
+
+	if (eResult == FILLED)
+		return true;
+
+	m_bFinished = true;
+
+	if (eResult == FAILED)
+	{
+		if (m_pError != nullptr)
+			throw CSQLException(*m_pError);
+
+		throw CSQLException(CSQLException::E_FETCH_FAILED, TXT(""), TXT("The fetch thread threw an exception"));
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Fill a buffer and hand it to the consumer along with the outcome. This is
+//! invoked on the fetch thread.
+
+bool CFetchPipeline::FillBuffer(size_t nBuffer)
+{
+	Result eResult = FAILED;
+
+	try
+	{
+		eResult = (m_oSource.FetchBatch(nBuffer)) ? FILLED : FINISHED;
+	}
+	catch (const CSQLException& e)
+	{
+		// Unless caused by stopping.
+		if (m_nStop == FALSE)
+			m_pError = new CSQLException(e);
+	}
+	catch (...)
+	{
+	}
+
+	m_vResults[nBuffer] = eResult;
+
+	::ReleaseSemaphore(m_hFilled, 1, nullptr);
+
+	return (eResult == FILLED);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The fetch thread entry point. The buffers are filled in turn, each one as
+//! soon as the consumer has handed it back, until the end of the rows or an
+//! error.
+
+unsigned __stdcall CFetchPipeline::FetchThread(void* pParam)
+{
+	CFetchPipeline* pPipeline = static_cast<CFetchPipeline*>(pParam);
+
+	for (size_t nBuffer = 0; ; nBuffer = (nBuffer + 1) % pPipeline->m_nBuffers)
+	{
+		::WaitForSingleObject(pPipeline->m_hFree, INFINITE);
+
+		if (pPipeline->m_nStop != FALSE)
+			break;
+
+		if (!pPipeline->FillBuffer(nBuffer))
+			break;
+	}
+
+	return 0;
+}
@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   FetchPipeline.hpp
+//! \brief  The CFetchPipeline class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_FETCHPIPELINE_HPP
+#define MDBL_FETCHPIPELINE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <vector>
+
+// Forward declarations.
+class CSQLException;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The source of the batches of rows fetched by a CFetchPipeline.
+
+class IFetchSource
+{
+public:
+	//! Fetch the next batch of rows into a buffer. This is invoked on the fetch
+	//! thread and a failure is reported by throwing a CSQLException, so that
+	//! any diagnostics are read on the thread that used the statement.
+	virtual bool FetchBatch(size_t nBuffer) = 0;
+
+	//! Interrupt a FetchBatch() that is in progress. This is invoked on the
+	//! consuming thread.
+	virtual void CancelFetch() = 0;
+
+protected:
+	//! Destructor.
+	virtual ~IFetchSource() {}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Fetches batches of rows on a background thread into a fixed number of
+//! buffers whilst the caller consumes the previous batch from another, so that
+//! the latency of the fetch overlaps with the work done for each row, see
+//! CODBCCursor::Pipelined().
+//!
+//! The buffers are filled and consumed in turn. A semaphore counts the buffers
+//! filled and another the buffers consumed, so the fetch thread never gets more
+//! than the number of buffers ahead. The fetch thread stops at the end of the
+//! rows or on the first error, which is rethrown on the consuming thread once
+//! it reaches that batch.
+
+class CFetchPipeline /*: private NotCopyable*/
+{
+public:
+	//! Constructor.
+	CFetchPipeline(IFetchSource& oSource, size_t nBuffers);
+
+	//! Destructor.
+	~CFetchPipeline();
+
+	//
+	// Properties.
+	//
+
+	//! Query if the fetch thread has been started.
+	bool Running() const;
+
+	//
+	// Methods.
+	//
+
+	//! Start the fetch thread.
+	void Start();
+
+	//! Stop the fetch thread, cancelling any fetch in progress.
+	void Stop();
+
+	//! Hand back the buffer consumed and wait for the next one to be filled.
+	bool NextBuffer(size_t& nBuffer);
+
+private:
+	//! The outcome of filling a buffer.
+	enum Result
+	{
+		FILLED,		//!< The buffer holds rows.
+		FINISHED,	//!< There were no more rows.
+		FAILED,		//!< The fetch threw an exception.
+	};
+
+	//
+	// Members.
+	//
+	IFetchSource&		m_oSource;		//!< The source of the batches.
+	size_t				m_nBuffers;		//!< The number of buffers.
+	std::vector<Result>	m_vResults;		//!< The outcome for each buffer.
+	CSQLException*		m_pError;		//!< The fetch error, if a CSQLException.
+	HANDLE				m_hThread;		//!< The fetch thread.
+	HANDLE				m_hFilled;		//!< Counts the buffers filled.
+	HANDLE				m_hFree;		//!< Counts the buffers consumed.
+	volatile LONG		m_nStop;		//!< Flag to stop the fetch thread.
+	size_t				m_nNext;		//!< The next buffer to consume.
+	bool				m_bHolding;		//!< Consuming a buffer?
+	bool				m_bFinished;	//!< All buffers consumed?
+
+	//
+	// Internal methods.
+	//
+
+	//! Fill a buffer, capturing the outcome for the consumer.
+	bool FillBuffer(size_t nBuffer);
+
+	//! The fetch thread entry point.
+	static unsigned __stdcall FetchThread(void* pParam);
+
+private:
+	// NotCopyable.
+	CFetchPipeline(const CFetchPipeline&);
+	CFetchPipeline& operator=(const CFetchPipeline&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the fetch thread has been started.
+
+inline bool CFetchPipeline::Running() const
+{
+	return (m_hThread != NULL);
+}
+
+#endif // MDBL_FETCHPIPELINE_HPP
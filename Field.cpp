@@ -13,6 +13,9 @@
 #include "Row.hpp"
 #include "Table.hpp"
 #include "TimeStamp.hpp"
+#include "ChangeLog.hpp"
+#include "BackgroundSnapshot.hpp"
+#include "VersionStore.hpp"
 #include <time.h>
 #include <tchar.h>
 #include <Core/AnsiWide.hpp>
@@ -65,8 +68,9 @@ CField::CField(CRow& oRow, CColumn& oColumn, size_t nColumn, bool bNull, void* p
 	if (m_oColumn.StgType() == MDST_POINTER)
 		m_pVoidPtr = nullptr;
 
-	// VARSTR fields store their values in a separate buffer.
-	if (m_oColumn.ColType() == MDCT_VARSTR)
+	// VARSTR fields store their values in a separate buffer,
+	// unless the row refers to a snapshot mapping.
+	if ( (m_oColumn.ColType() == MDCT_VARSTR) && (!m_oRow.Mapped()) )
 		m_pString = static_cast<tchar*>(calloc(1, sizeof(tchar)));
 }
 
@@ -85,7 +89,7 @@ CField::CField(CRow& oRow, CColumn& oColumn, size_t nColumn, bool bNull, void* p
 CField::~CField()
 {
 	// VARSTR fields store their values in a separate block.
-	if (m_oColumn.ColType() == MDCT_VARSTR)
+	if ( (m_oColumn.ColType() == MDCT_VARSTR) && (!m_oRow.Mapped()) )
 		free(m_pString);
 }
 
@@ -280,6 +284,8 @@ void CField::SetNull()
 	if (m_bNull == true)
 		return;
 
+	Updating();
+
 	m_bNull = true;
 
 	Updated();
@@ -310,6 +316,8 @@ void CField::SetInt(int iValue)
 		m_oRow.Table().CheckColumn(m_oRow, m_nColumn, iValue, true);
 #endif //_DEBUG
 
+	Updating();
+
 	*m_pInt = iValue;
 	m_bNull = false;
 
@@ -341,6 +349,8 @@ void CField::SetInt64(int64 iValue)
 		m_oRow.Table().CheckColumn(m_oRow, m_nColumn, iValue, true);
 #endif //_DEBUG
 
+	Updating();
+
 	*m_pInt64 = iValue;
 	m_bNull   = false;
 
@@ -361,6 +371,8 @@ void CField::SetDouble(double dValue)
 		m_oRow.Table().CheckColumn(m_oRow, m_nColumn, dValue, true);
 #endif //_DEBUG
 
+	Updating();
+
 	*m_pDouble = dValue;
 	m_bNull = false;
 
@@ -381,6 +393,8 @@ void CField::SetChar(tchar cValue)
 		m_oRow.Table().CheckColumn(m_oRow, m_nColumn, cValue, true);
 #endif //_DEBUG
 
+	Updating();
+
 	*m_pChar = cValue;
 	m_bNull = false;
 
@@ -402,9 +416,11 @@ void CField::SetString(const tchar* sValue)
 		m_oRow.Table().CheckColumn(m_oRow, m_nColumn, sValue, true);
 #endif //_DEBUG
 
+	Updating();
+
 	// Variable buffer string?
 	if (m_oColumn.ColType() == MDCT_VARSTR)
-		m_pString = static_cast<tchar*>(realloc(m_pString, Core::numBytes<tchar>(tstrlen(sValue)+1)));
+		ResizeString(tstrlen(sValue));
 
 	tstrcpy(m_pString, sValue);
 	m_bNull = false;
@@ -426,6 +442,8 @@ void CField::SetBool(bool bValue)
 		m_oRow.Table().CheckColumn(m_oRow, m_nColumn, bValue, true);
 #endif //_DEBUG
 
+	Updating();
+
 	*m_pBool = bValue;
 	m_bNull = false;
 
@@ -446,6 +464,8 @@ void CField::SetTimeT(time_t tValue)
 		m_oRow.Table().CheckColumn(m_oRow, m_nColumn, static_cast<int64>(tValue), true);
 #endif //_DEBUG
 
+	Updating();
+
 	*m_pInt64 = tValue;
 	m_bNull = false;
 
@@ -466,6 +486,8 @@ void CField::SetTimeStamp(const CTimeStamp& tsValue)
 		m_oRow.Table().CheckColumn(m_oRow, m_nColumn, static_cast<int64>(tsValue.ToTimeT()), true);
 #endif //_DEBUG
 
+	Updating();
+
 	*m_pTimeStamp = tsValue;
 	m_bNull = false;
 
@@ -508,6 +530,8 @@ void CField::SetPtr(void* pValue)
 	if ( (m_bNull == false) && (m_pVoidPtr == pValue) )
 		return;
 
+	Updating();
+
 	m_pVoidPtr = pValue;
 	m_bNull = false;
 
@@ -523,6 +547,8 @@ void CField::SetRowPtr(CRow* pValue)
 	if ( (m_bNull == false) && (m_pRowPtr == pValue) )
 		return;
 
+	Updating();
+
 	m_pRowPtr  = pValue;
 	m_bNull = false;
 
@@ -538,6 +564,8 @@ void CField::SetRowSetPtr(CRow** pValue)
 	if ( (m_bNull == false) && (m_pRowSetPtr == pValue) )
 		return;
 
+	Updating();
+
 	m_pRowSetPtr  = pValue;
 	m_bNull = false;
 
@@ -582,7 +610,7 @@ void CField::SetRaw(const void* pValue)
 		const tchar* pszValue = static_cast<const tchar*>(pValue);
 		size_t       nChars   = tstrlen(pszValue);
 
-		m_pString = static_cast<tchar*>(realloc(m_pString, Core::numBytes<tchar>(nChars+1)));
+		ResizeString(nChars);
 
 		tstrncpy(m_pString, pszValue, nChars);
 
@@ -750,10 +778,84 @@ int CField::Compare(const CValue& oValue) const
 	return nCmp;
 }
 
+/******************************************************************************
+** Methods:		Updating()
+**
+** Description:	Called before the field value is changed. If a background
+**				snapshot of the table is running the row is preserved first
+**				so that the snapshot still sees the value it was taken with,
+**				and likewise for any read views, see CVersionStore. If the
+**				table is concurrent it is locked until Updated().
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CField::Updating()
+{
+	// Row is not part of a table?
+	if (m_oRow.InTable() == false)
+		return;
+
+	CTable& oTable = m_oRow.Table();
+
+	if (oTable.Concurrent())
+		oTable.m_oLock.AcquireExclusive();
+
+	try
+	{
+		// Table being written in the background?
+		if (oTable.m_pBackground != nullptr)
+			oTable.m_pBackground->PreserveRow(m_oRow);
+
+		// Keep the current version for any read views.
+		if (oTable.m_pVersions != nullptr)
+			oTable.m_pVersions->Updating(m_oRow);
+	}
+	catch (...)
+	{
+		if (oTable.Concurrent())
+			oTable.m_oLock.ReleaseExclusive();
+
+		throw;
+	}
+}
+
+/******************************************************************************
+** Method:		ResizeString()
+**
+** Description:	Resizes the buffer of an MDCT_VARSTR field to hold a string of
+**				the given length and updates the tables memory usage. The
+**				buffer contents are undefined afterwards.
+**
+** Parameters:	nChars	The string length, excluding the terminator.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CField::ResizeString(size_t nChars)
+{
+	ASSERT(m_oColumn.ColType() == MDCT_VARSTR);
+	ASSERT(!m_oRow.Mapped());
+
+	size_t nOldBytes = Core::numBytes<tchar>(tstrlen(m_pString)+1);
+	size_t nNewBytes = Core::numBytes<tchar>(nChars+1);
+
+	m_pString = static_cast<tchar*>(realloc(m_pString, nNewBytes));
+
+	m_oRow.Table().TrackStrings(static_cast<ptrdiff_t>(nNewBytes) - static_cast<ptrdiff_t>(nOldBytes));
+}
+
 /******************************************************************************
 ** Methods:		Updated()
 **
-** Description:	Sets the modified flag for the field and its parent row.
+** Description:	Sets the modified flag for the field and its parent row and
+**				releases the lock taken by Updating().
 **
 ** Parameters:	None.
 **
@@ -764,13 +866,40 @@ int CField::Compare(const CValue& oValue) const
 
 void CField::Updated()
 {
-	// Row is part of table AND is not a transient column?
-	if ( (m_oRow.InTable() == true) && (m_oColumn.Transient() == false))
+	// Row is not part of a table?
+	if (m_oRow.InTable() == false)
+		return;
+
+	CTable& oTable = m_oRow.Table();
+
+	try
 	{
-		m_bModified = true;
-		m_oRow.MarkUpdated();
-		++m_oRow.Table().m_nUpdates;
+		// Not a transient column?
+		if (m_oColumn.Transient() == false)
+		{
+			m_bModified = true;
+			m_oRow.MarkUpdated();
+			++oTable.m_nUpdates;
+
+			// May have lowered the highest row version.
+			if (m_nColumn == oTable.m_nVersionCol)
+				oTable.m_bMaxVersion = false;
+
+			// Log it.
+			if (oTable.m_pChangeLog != nullptr)
+				oTable.m_pChangeLog->LogUpdate(m_oRow, m_nColumn);
+		}
 	}
+	catch (...)
+	{
+		if (oTable.Concurrent())
+			oTable.m_oLock.ReleaseExclusive();
+
+		throw;
+	}
+
+	if (oTable.Concurrent())
+		oTable.m_oLock.ReleaseExclusive();
 }
 
 #if (__GNUC__ >= 10) // GCC 10.0+
@@ -159,6 +159,9 @@ union
 	// Friends.
 	//
 	friend class CRow;
+	friend class CSnapshot;
+	friend class CChangeLog;
+	friend class CRowBlock;
 
 private:
 	//
@@ -187,7 +190,9 @@ private:
 	//
 	// Internal methods.
 	//
+	void    Updating();
 	void    Updated();
+	void    ResizeString(size_t nChars);
 	CString FormatTimeT(const tchar* pszFormat) const;
 	CString FormatTimeStamp(const tchar* pszFormat) const;
 	CString FormatBool(const tchar* pszFormat) const;
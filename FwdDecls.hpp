@@ -24,14 +24,28 @@ class CRow;
 class CRowSet;
 class CTable;
 class CIndex;
+class CUniqIndex;
 class CMDB;
+class CChangeLog;
+class CBackgroundSnapshot;
+class CVersionStore;
+class CReadView;
+class CBulkLoader;
+class CPartitionKeys;
+class CPartitionedTable;
 class CResultSet;
+class CRowCursor;
 class CWhere;
 class CJoin;
 class CJoinedSet;
+class CQueryStats;
+class CTableStats;
 class CGroupSet;
 class CSQLSource;
 class CSQLParams;
 class CSQLCursor;
+class CLocalSource;
+class CLocalStmt;
+class CLocalParams;
 
 #endif // MDBL_FWDDECLS_HPP
@@ -51,6 +51,50 @@ CGroupSet::CGroupSet(const CGroupSet& oSet)
 	}
 }
 
+#ifdef MDBL_HAS_RVALUE_REFS
+
+/******************************************************************************
+** Method:		Move constructor.
+**
+** Description:	Takes ownership of the groups in the existing set.
+**
+** Parameters:	oSet	The set to move from.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CGroupSet::CGroupSet(CGroupSet&& oSet)
+	: m_oResSets()
+{
+	m_oResSets.swap(oSet.m_oResSets);
+}
+
+/******************************************************************************
+** Method:		Move assignment operator.
+**
+** Description:	Takes ownership of the groups in the set. The existing groups
+**				are destroyed along with the moved from set.
+**
+** Parameters:	oRHS	The set to move from.
+**
+** Returns:		itself.
+**
+*******************************************************************************
+*/
+
+CGroupSet& CGroupSet::operator=(CGroupSet&& oRHS)
+{
+	ASSERT(this != &oRHS);
+
+	m_oResSets.swap(oRHS.m_oResSets);
+
+	return *this;
+}
+
+#endif
+
 /******************************************************************************
 ** Method:		Destructor.
 **
@@ -70,3 +114,27 @@ CGroupSet::~CGroupSet()
 
 	m_oResSets.clear();
 }
+
+/******************************************************************************
+** Method:		Adopt()
+**
+** Description:	Adds a group by taking the rows from the result set instead of
+**				copying them. The result set is left empty.
+**
+** Parameters:	oRS		The result set to take the rows from.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CGroupSet::Adopt(CResultSet& oRS)
+{
+	m_oResSets.reserve(m_oResSets.size()+1);
+
+	CResultSet* pGroup = new CResultSet(oRS.Table());
+
+	pGroup->Swap(oRS);
+
+	m_oResSets.push_back(pGroup);
+}
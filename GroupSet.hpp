@@ -34,6 +34,11 @@ public:
 	CGroupSet();
 	CGroupSet(const CGroupSet& oSet);
 	~CGroupSet();
+
+#ifdef MDBL_HAS_RVALUE_REFS
+	CGroupSet(CGroupSet&& oSet);
+	CGroupSet& operator=(CGroupSet&& oRHS);
+#endif
 	
 	//
 	// Methods.
@@ -43,6 +48,8 @@ public:
 	CResultSet& operator[](size_t n) const;
 
 	void Add(const CResultSet& oRS);
+	void Adopt(CResultSet& oRS);
+	void Swap(CGroupSet& oRHS);
 
 protected:
 	// Template shorthands.
@@ -87,4 +94,9 @@ inline void CGroupSet::Add(const CResultSet& oRS)
 	m_oResSets.push_back(new CResultSet(oRS));
 }
 
+inline void CGroupSet::Swap(CGroupSet& oRHS)
+{
+	m_oResSets.swap(oRHS.m_oResSets);
+}
+
 #endif // GROUPSET_HPP
@@ -0,0 +1,334 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   HashIndex.cpp
+//! \brief  The CHashIndex class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "HashIndex.hpp"
+#include "Table.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+CHashIndex::CHashIndex(CTable& oTable, size_t nColumn)
+	: CUniqIndex(oTable, nColumn)
+	, m_bString(oTable.Column(nColumn).StgType() == MDST_STRING)
+	, m_pBuckets(CreateBuckets(MIN_BUCKETS))
+	, m_nRows(0)
+	, m_nKeyBytes(0)
+	, m_oEpoch()
+	, m_vRetired()
+	, m_vRetiredBuckets()
+{
+	ASSERT(m_oTable.Column(m_nColumn).Unique());
+	ASSERT( (m_oTable.Column(m_nColumn).StgType() == MDST_INT)
+		 || (m_oTable.Column(m_nColumn).StgType() == MDST_STRING) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. There can be no readers left by now.
+
+CHashIndex::~CHashIndex()
+{
+	for (size_t i = 0; i != m_vRetired.size(); ++i)
+		delete m_vRetired[i];
+
+	for (size_t i = 0; i != m_vRetiredBuckets.size(); ++i)
+		DeleteBuckets(m_vRetiredBuckets[i], false);
+
+	DeleteBuckets(m_pBuckets, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a row to the index. The entry is filled in before it is linked in at
+//! the head of its chain.
+
+void CHashIndex::AddRow(CRow& oRow)
+{
+	ASSERT(FindRow(oRow[m_nColumn].ToValue()) == nullptr);
+
+	if (m_nRows >= m_pBuckets->m_nCount)
+		Grow(m_pBuckets->m_nCount * 2);
+
+	Buckets*  pBuckets = m_pBuckets;
+	Node*     pNode    = CreateNode(oRow);
+	NodeLink& pHead    = pBuckets->m_apHeads[pNode->m_nHash & (pBuckets->m_nCount-1)];
+
+	pNode->m_pNext = pHead;
+
+	::InterlockedExchangePointer(reinterpret_cast<PVOID volatile*>(&pHead), pNode);
+
+	++m_nRows;
+
+	if (m_bString)
+		m_nKeyBytes += Core::numBytes<tchar>(tstrlen(oRow[m_nColumn].GetString())+1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove a row from the index. The entry is unlinked from its chain, but not
+//! freed until no reader can be looking at it.
+
+void CHashIndex::RemoveRow(CRow& oRow)
+{
+	const CField& oKey     = oRow[m_nColumn];
+	size_t        nHash    = (m_bString) ? Hash(oKey.GetString()) : Hash(oKey.GetInt());
+	Buckets*      pBuckets = m_pBuckets;
+	NodeLink*     ppLink   = &pBuckets->m_apHeads[nHash & (pBuckets->m_nCount-1)];
+
+	while ( (*ppLink != nullptr) && ((*ppLink)->m_pRow != &oRow) )
+		ppLink = &(*ppLink)->m_pNext;
+
+	Node* pNode = *ppLink;
+
+	if (pNode == nullptr)
+		return;
+
+	::InterlockedExchangePointer(reinterpret_cast<PVOID volatile*>(ppLink), pNode->m_pNext);
+
+	--m_nRows;
+
+	if (m_bString)
+		m_nKeyBytes -= Core::numBytes<tchar>(tstrlen(oKey.GetString())+1);
+
+	m_vRetired.push_back(pNode);
+
+	if (m_vRetired.size() >= MAX_RETIRED)
+		Reclaim();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove all rows from the index by swapping in an empty hash table.
+
+void CHashIndex::Truncate()
+{
+	Buckets* pOld = m_pBuckets;
+
+	::InterlockedExchangePointer(reinterpret_cast<PVOID volatile*>(&m_pBuckets), CreateBuckets(MIN_BUCKETS));
+
+	for (size_t i = 0; i != pOld->m_nCount; ++i)
+	{
+		for (Node* pNode = pOld->m_apHeads[i]; pNode != nullptr; pNode = pNode->m_pNext)
+			m_vRetired.push_back(pNode);
+	}
+
+	m_vRetiredBuckets.push_back(pOld);
+	m_nRows     = 0;
+	m_nKeyBytes = 0;
+
+	Reclaim();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the row with the value. This takes no lock, the reader is only counted
+//! whilst it walks the chain.
+
+CRow* CHashIndex::FindRow(const CValue& oValue) const
+{
+	if (m_bString)
+	{
+		ASSERT(oValue.m_eType == MDST_STRING);
+
+		return Find(Hash(oValue.m_sValue), 0, oValue.m_sValue);
+	}
+
+	ASSERT(oValue.m_eType == MDST_INT);
+
+	return Find(Hash(oValue.m_iValue), oValue.m_iValue, nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Size the index for the expected number of rows.
+
+void CHashIndex::Capacity(size_t nRows)
+{
+	size_t nBuckets = m_pBuckets->m_nCount;
+
+	while (nBuckets < nRows)
+		nBuckets *= 2;
+
+	if (nBuckets != m_pBuckets->m_nCount)
+		Grow(nBuckets);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the approximate number of bytes used by the index. This includes the
+//! entries that are waiting to be freed.
+
+size_t CHashIndex::MemoryUsage() const
+{
+	size_t nBytes = sizeof(Buckets) + (m_pBuckets->m_nCount * sizeof(NodeLink));
+
+	nBytes += (m_nRows + m_vRetired.size()) * sizeof(Node);
+	nBytes += m_nKeyBytes;
+
+	return nBytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create an entry for a row.
+
+CHashIndex::Node* CHashIndex::CreateNode(CRow& oRow) const
+{
+	const CField& oKey  = oRow[m_nColumn];
+	Node*         pNode = new Node;
+
+	if (m_bString)
+	{
+		pNode->m_nHash  = Hash(oKey.GetString());
+		pNode->m_nKey   = 0;
+		pNode->m_strKey = oKey.GetString();
+	}
+	else
+	{
+		pNode->m_nHash  = Hash(oKey.GetInt());
+		pNode->m_nKey   = oKey.GetInt();
+	}
+
+	pNode->m_pRow  = &oRow;
+	pNode->m_pNext = nullptr;
+
+	return pNode;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the row for a key. The entries can be freed as soon as the epoch is
+//! left, so the row is taken from the entry whilst still inside it.
+
+CRow* CHashIndex::Find(size_t nHash, int nKey, const tchar* pszKey) const
+{
+	CEpoch::ReadGuard oGuard(m_oEpoch);
+
+	const Buckets* pBuckets = m_pBuckets;
+	const Node*    pNode    = pBuckets->m_apHeads[nHash & (pBuckets->m_nCount-1)];
+
+	for (; pNode != nullptr; pNode = pNode->m_pNext)
+	{
+		if (pNode->m_nHash != nHash)
+			continue;
+
+		if ( (m_bString) ? (tstrcmp(pNode->m_strKey.c_str(), pszKey) == 0) : (pNode->m_nKey == nKey) )
+			return pNode->m_pRow;
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Rebuild the hash table with more buckets. The readers may still be walking
+//! the old chains so the new table gets its own entries and the old ones are
+//! retired along with it.
+
+void CHashIndex::Grow(size_t nBuckets)
+{
+	Buckets* pOld = m_pBuckets;
+	Buckets* pNew = CreateBuckets(nBuckets);
+
+	for (size_t i = 0; i != pOld->m_nCount; ++i)
+	{
+		for (Node* pNode = pOld->m_apHeads[i]; pNode != nullptr; pNode = pNode->m_pNext)
+		{
+			Node*     pCopy = new Node(*pNode);
+			NodeLink& pHead = pNew->m_apHeads[pCopy->m_nHash & (nBuckets-1)];
+
+			pCopy->m_pNext = pHead;
+			pHead = pCopy;
+
+			m_vRetired.push_back(pNode);
+		}
+	}
+
+	::InterlockedExchangePointer(reinterpret_cast<PVOID volatile*>(&m_pBuckets), pNew);
+
+	m_vRetiredBuckets.push_back(pOld);
+
+	Reclaim();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Free the unlinked entries and tables once the readers that may have seen
+//! them have finished.
+
+void CHashIndex::Reclaim()
+{
+	m_oEpoch.WaitForReaders();
+
+	for (size_t i = 0; i != m_vRetired.size(); ++i)
+		delete m_vRetired[i];
+
+	for (size_t i = 0; i != m_vRetiredBuckets.size(); ++i)
+		DeleteBuckets(m_vRetiredBuckets[i], false);
+
+	m_vRetired.clear();
+	m_vRetiredBuckets.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create an empty hash table.
+
+CHashIndex::Buckets* CHashIndex::CreateBuckets(size_t nBuckets)
+{
+	ASSERT((nBuckets & (nBuckets-1)) == 0);
+
+	Buckets* pBuckets = new Buckets;
+
+	pBuckets->m_nCount  = nBuckets;
+	pBuckets->m_apHeads = new NodeLink[nBuckets];
+
+	for (size_t i = 0; i != nBuckets; ++i)
+		pBuckets->m_apHeads[i] = nullptr;
+
+	return pBuckets;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Free a hash table, and optionally its entries.
+
+void CHashIndex::DeleteBuckets(Buckets* pBuckets, bool bNodes)
+{
+	if (bNodes)
+	{
+		for (size_t i = 0; i != pBuckets->m_nCount; ++i)
+		{
+			Node* pNode = pBuckets->m_apHeads[i];
+
+			while (pNode != nullptr)
+			{
+				Node* pNext = pNode->m_pNext;
+
+				delete pNode;
+				pNode = pNext;
+			}
+		}
+	}
+
+	delete[] pBuckets->m_apHeads;
+	delete pBuckets;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Calculate the hash of an int key. Multiplying by the golden ratio spreads
+//! the keys and folding in the high bits keeps keys with a common stride out
+//! of the same bucket.
+
+size_t CHashIndex::Hash(int nKey)
+{
+	uint nHash = static_cast<uint>(nKey) * 2654435761u;
+
+	return nHash ^ (nHash >> 16);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Calculate the hash of a string key, using FNV-1a.
+
+size_t CHashIndex::Hash(const tchar* pszKey)
+{
+	uint nHash = 2166136261u;
+
+	for (; *pszKey != TXT('\0'); ++pszKey)
+	{
+		nHash ^= static_cast<uint>(*pszKey);
+		nHash *= 16777619u;
+	}
+
+	return nHash;
+}
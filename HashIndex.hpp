@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   HashIndex.hpp
+//! \brief  The CHashIndex class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_HASHINDEX_HPP
+#define MDBL_HASHINDEX_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "UniqIndex.hpp"
+#include "Epoch.hpp"
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A unique index on an int or string column that can be searched without a
+//! lock whilst rows are added and removed. This is the index used for unique
+//! columns of CONCURRENT tables, see CTable::SelectRow().
+//!
+//! The index is a chained hash table. Each entry holds a copy of the key so
+//! that a search never touches a row. The writer, of which there is only one
+//! at a time as it holds the table lock, links entries in and out with single
+//! pointer writes, so a reader always sees a consistent chain. When the table
+//! grows a new one is built and swapped in whole. The entries and tables that
+//! have been unlinked are only freed once the readers that may still be using
+//! them have finished, see CEpoch.
+//!
+//! A row found by a search may still be deleted by the writer afterwards. The
+//! table retires its deleted rows in the same way, so a reader that needs the
+//! row to stay valid should hold a CTable::RowGuard whilst it uses it.
+
+class CHashIndex : public CUniqIndex
+{
+public:
+	//! Constructor.
+	CHashIndex(CTable& oTable, size_t nColumn);
+
+	//! Destructor.
+	virtual ~CHashIndex();
+
+	//
+	// Methods.
+	//
+
+	//! Get the number of rows indexed.
+	virtual size_t RowCount() const;
+
+	//! Add a row to the index.
+	virtual void AddRow(CRow& oRow);
+
+	//! Remove a row from the index.
+	virtual void RemoveRow(CRow& oRow);
+
+	//! Remove all rows from the index.
+	virtual void Truncate();
+
+	//! Find the row with the value.
+	virtual CRow* FindRow(const CValue& oValue) const;
+
+	//! Find the rows with the value.
+	virtual CResultSet FindRows(const CValue& oValue) const;
+
+	//! Size the index for the expected number of rows.
+	virtual void Capacity(size_t nRows);
+
+	//! Query if the index can be searched without the table lock.
+	virtual bool Concurrent() const;
+
+	//! Get the approximate number of bytes used by the index.
+	virtual size_t MemoryUsage() const;
+
+private:
+	//! An entry in the hash table.
+	struct Node
+	{
+		size_t			m_nHash;		//!< The hash of the key.
+		int				m_nKey;			//!< The key, if an int column.
+		CString			m_strKey;		//!< The key, if a string column.
+		CRow*			m_pRow;			//!< The row.
+		Node* volatile	m_pNext;		//!< The next entry in the chain.
+	};
+
+	//! A link in a chain.
+	typedef Node* volatile NodeLink;
+
+	//! The hash table.
+	struct Buckets
+	{
+		size_t			m_nCount;		//!< The number of buckets, a power of 2.
+		NodeLink*		m_apHeads;		//!< The head of each chain.
+	};
+
+	//! The number of buckets to start with.
+	static const size_t MIN_BUCKETS = 16;
+
+	//! The number of unlinked entries held before they are freed.
+	static const size_t MAX_RETIRED = 1024;
+
+	//
+	// Members.
+	//
+	bool				m_bString;		//!< Is the column a string?
+	Buckets* volatile	m_pBuckets;		//!< The current hash table.
+	size_t				m_nRows;		//!< The number of rows indexed.
+	size_t				m_nKeyBytes;	//!< The size of the string keys.
+	mutable CEpoch		m_oEpoch;		//!< The readers of the hash table.
+	std::vector<Node*>	m_vRetired;		//!< The unlinked entries.
+	std::vector<Buckets*> m_vRetiredBuckets; //!< The replaced hash tables.
+
+	//
+	// Internal methods.
+	//
+
+	//! Create an entry for a row.
+	Node* CreateNode(CRow& oRow) const;
+
+	//! Find the row for a key.
+	CRow* Find(size_t nHash, int nKey, const tchar* pszKey) const;
+
+	//! Rebuild the hash table with more buckets.
+	void Grow(size_t nBuckets);
+
+	//! Free the unlinked entries once the readers have finished with them.
+	void Reclaim();
+
+	//! Create an empty hash table.
+	static Buckets* CreateBuckets(size_t nBuckets);
+
+	//! Free a hash table, and optionally its entries.
+	static void DeleteBuckets(Buckets* pBuckets, bool bNodes);
+
+	//! Calculate the hash of an int key.
+	static size_t Hash(int nKey);
+
+	//! Calculate the hash of a string key.
+	static size_t Hash(const tchar* pszKey);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of rows indexed.
+
+inline size_t CHashIndex::RowCount() const
+{
+	return m_nRows;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the rows with the value.
+
+inline CResultSet CHashIndex::FindRows(const CValue& oValue) const
+{
+	return CResultSet(m_oTable, FindRow(oValue));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the index can be searched without the table lock.
+
+inline bool CHashIndex::Concurrent() const
+{
+	return true;
+}
+
+#endif // MDBL_HASHINDEX_HPP
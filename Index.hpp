@@ -41,7 +41,12 @@ public:
 
 	virtual void Capacity(size_t nRows) = 0;
 
+	virtual size_t MemoryUsage() const = 0;
+
 protected:
+	//! The approximate size of a std::map<> node, excluding the value.
+	static const size_t MAP_NODE_SIZE = 3*sizeof(void*) + 2*sizeof(char);
+
 	//
 	// Constructors/Destructor.
 	//
@@ -49,6 +49,8 @@ public:
 
 	virtual void Capacity(size_t nRows);
 
+	virtual size_t MemoryUsage() const;
+
 protected:
 	//! The underlying collection type.
 	typedef std::map<int, CRow*> IntRowMap;
@@ -117,4 +119,9 @@ inline void CIntMapIndex::Capacity(size_t /*nRows*/)
 	// std::map<> does not optimise based on expected size.
 }
 
+inline size_t CIntMapIndex::MemoryUsage() const
+{
+	return m_oMap.size() * (sizeof(IntRowMap::value_type) + MAP_NODE_SIZE);
+}
+
 #endif //INTMAPINDEX_HPP
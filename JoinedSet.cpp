@@ -54,6 +54,51 @@ CJoinedSet::CJoinedSet(const CJoinedSet& oJoinedSet)
 	pRHS->m_pResSets = nullptr;
 }
 
+#ifdef MDBL_HAS_RVALUE_REFS
+
+/******************************************************************************
+** Method:		Move constructor.
+**
+** Description:	Transfers ownership of the data.
+**
+** Parameters:	oJoinedSet	The set to move from.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CJoinedSet::CJoinedSet(CJoinedSet&& oJoinedSet)
+	: m_nTables(oJoinedSet.m_nTables)
+	, m_pResSets(oJoinedSet.m_pResSets)
+{
+	oJoinedSet.m_pResSets = nullptr;
+}
+
+/******************************************************************************
+** Method:		Move assignment operator.
+**
+** Description:	Transfers ownership of the data. The existing data is destroyed
+**				along with the moved from set.
+**
+** Parameters:	oRHS	The set to move from.
+**
+** Returns:		itself.
+**
+*******************************************************************************
+*/
+
+CJoinedSet& CJoinedSet::operator=(CJoinedSet&& oRHS)
+{
+	ASSERT(this != &oRHS);
+
+	Swap(oRHS);
+
+	return *this;
+}
+
+#endif
+
 /******************************************************************************
 ** Method:		Destructor.
 **
@@ -34,6 +34,11 @@ public:
 	CJoinedSet(const CJoinedSet& oJoinedSet);
 	~CJoinedSet();
 
+#ifdef MDBL_HAS_RVALUE_REFS
+	CJoinedSet(CJoinedSet&& oJoinedSet);
+	CJoinedSet& operator=(CJoinedSet&& oRHS);
+#endif
+
 	//
 	// Methods.
 	//
@@ -41,6 +46,8 @@ public:
 	CResultSet& ResultSet(size_t n) const;
 	CResultSet& operator[](size_t n) const;
 
+	void Swap(CJoinedSet& oRHS);
+
 protected:
 	//
 	// Members.
@@ -85,4 +92,10 @@ inline CResultSet& CJoinedSet::operator[](size_t n) const
 	return m_pResSets[n];
 }
 
+inline void CJoinedSet::Swap(CJoinedSet& oRHS)
+{
+	std::swap(m_nTables,  oRHS.m_nTables);
+	std::swap(m_pResSets, oRHS.m_pResSets);
+}
+
 #endif //JOINEDSET_HPP
@@ -0,0 +1,174 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   LocalCursor.cpp
+//! \brief  The CLocalCursor class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "LocalCursor.hpp"
+#include "SQLException.hpp"
+#include "Row.hpp"
+#include "Field.hpp"
+#include "TimeStamp.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor. The rows are taken from the caller.
+
+CLocalCursor::CLocalCursor(const CLocalTable::Columns& vColumns, CLocalTable::Rows& vRows)
+	: m_vColumns(vColumns)
+	, m_vRows()
+	, m_vTypes()
+	, m_nNext(0)
+{
+	m_vRows.swap(vRows);
+
+	for (size_t i = 0; i != m_vColumns.size(); ++i)
+		m_vTypes.push_back(m_vColumns[i].m_eMDBColType);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+CLocalCursor::~CLocalCursor()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of result set columns.
+
+size_t CLocalCursor::NumColumns() const
+{
+	return m_vColumns.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get a result set column's details.
+
+const SQLColumn& CLocalCursor::Column(size_t n) const
+{
+	ASSERT(n < m_vColumns.size());
+
+	return m_vColumns[n];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the mapping from result set column to table column. The values are
+//! converted to the table column type when fetched.
+
+void CLocalCursor::MapColumn(size_t sourceColumn, size_t destColumn, COLTYPE type, size_t size)
+{
+	ASSERT(sourceColumn < m_vColumns.size());
+
+	SQLColumn& column = m_vColumns[sourceColumn];
+
+	column.m_nDstColumn  = destColumn;
+	column.m_eMDBColType = type;
+	column.m_nSize       = size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Move to the next row, if any.
+
+bool CLocalCursor::Fetch()
+{
+	if (m_nNext == m_vRows.size())
+		return false;
+
+	++m_nNext;
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy the current row's values to the mapped table columns.
+
+void CLocalCursor::GetRow(CRow& oRow)
+{
+	ASSERT(m_nNext != 0);
+
+	const CLocalTable::Row& vRow = m_vRows[m_nNext-1];
+	LocalValue              oConverted;
+
+	for (size_t i = 0; i != m_vColumns.size(); ++i)
+	{
+		const LocalColumn& oColumn = m_vColumns[i];
+		const LocalValue*  pValue  = &vRow[i];
+		CField&            oField  = oRow[oColumn.m_nDstColumn];
+
+		// Is value null?
+		if (pValue->m_bNull)
+		{
+			oField = null;
+			continue;
+		}
+
+		// Requires conversion?
+		if (oColumn.m_eMDBColType != m_vTypes[i])
+		{
+			if (!CLocalTable::Convert(*pValue, m_vTypes[i], oColumn.m_eMDBColType, oConverted))
+				throw CSQLException(CSQLException::E_FETCH_FAILED, oColumn.m_strName, TXT("The value cannot be converted to the table column type"));
+
+			pValue = &oConverted;
+		}
+
+		switch (oColumn.m_eMDBColType)
+		{
+			case MDCT_INT:
+			case MDCT_IDENTITY:
+			{
+				int nValue = static_cast<int>(pValue->m_nValue);
+				oField.SetRaw(&nValue);
+			}
+			break;
+
+			case MDCT_CHAR:
+			{
+				tchar cValue = static_cast<tchar>(pValue->m_nValue);
+				oField.SetRaw(&cValue);
+			}
+			break;
+
+			case MDCT_BOOL:
+			{
+				bool bValue = (pValue->m_nValue != 0);
+				oField.SetRaw(&bValue);
+			}
+			break;
+
+			case MDCT_TIMESTAMP:
+			{
+				CTimeStamp tsValue;
+				tsValue.FromTimeT(static_cast<time_t>(pValue->m_nValue));
+				oField.SetRaw(&tsValue);
+			}
+			break;
+
+			case MDCT_DOUBLE:
+			{
+				oField.SetRaw(&pValue->m_dValue);
+			}
+			break;
+
+			case MDCT_FXDSTR:
+			case MDCT_VARSTR:
+			{
+				oField.SetRaw(pValue->m_strValue.c_str());
+			}
+			break;
+
+			case MDCT_INT64:
+			case MDCT_DATETIME:
+			case MDCT_DATE:
+			case MDCT_TIME:
+			{
+				oField.SetRaw(&pValue->m_nValue);
+			}
+			break;
+
+			default:
+			{
+				ASSERT_FALSE();
+			}
+			break;
+		}
+	}
+}
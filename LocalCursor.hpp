@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   LocalCursor.hpp
+//! \brief  The CLocalCursor class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_LOCALCURSOR_HPP
+#define MDBL_LOCALCURSOR_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "SQLCursor.hpp"
+#include "LocalTable.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! The SQL result set cursor used by the local SQL source. The whole result set
+//! is built by the query, so fetching never goes back to the source. Until a
+//! column is mapped, each result set column is copied to the same table column.
+
+class CLocalCursor : public CSQLCursor
+{
+public:
+	//! Constructor.
+	CLocalCursor(const CLocalTable::Columns& vColumns, CLocalTable::Rows& vRows);
+
+	//! Destructor.
+	virtual ~CLocalCursor();
+
+	//
+	// CSQLCursor interface.
+	//
+	virtual size_t NumColumns() const;
+	virtual const SQLColumn& Column(size_t n) const;
+	virtual void MapColumn(size_t sourceColumn, size_t destColumn, COLTYPE type, size_t size);
+	virtual bool Fetch();
+	virtual void GetRow(CRow& oRow);
+
+private:
+	//
+	// Members.
+	//
+	CLocalTable::Columns	m_vColumns;		//!< The result set columns.
+	CLocalTable::Rows		m_vRows;		//!< The result set rows.
+	std::vector<COLTYPE>	m_vTypes;		//!< The result set column types.
+	size_t					m_nNext;		//!< The next row to fetch.
+
+	// NotCopyable.
+	CLocalCursor(const CLocalCursor&);
+	CLocalCursor& operator=(const CLocalCursor&);
+};
+
+#endif // MDBL_LOCALCURSOR_HPP
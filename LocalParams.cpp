@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   LocalParams.cpp
+//! \brief  The CLocalParams class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "LocalParams.hpp"
+#include "Row.hpp"
+#include "Field.hpp"
+#include "TimeStamp.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+CLocalParams::CLocalParams(CLocalStmt::Ptr pStmt, size_t nParams)
+	: m_pStmt(pStmt)
+	, m_nParams(nParams)
+	, m_pParams(new SQLParam[nParams])
+	, m_vValues(nParams)
+{
+	ASSERT(m_pStmt.get() != nullptr);
+	ASSERT(nParams != 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+CLocalParams::~CLocalParams()
+{
+	delete[] m_pParams;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of parameters.
+
+size_t CLocalParams::NumParams() const
+{
+	return m_nParams;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get a parameter's details.
+
+SQLParam& CLocalParams::Param(size_t n) const
+{
+	ASSERT(n < m_nParams);
+
+	return m_pParams[n];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy the row values for the parameters. The date/time values are held as a
+//! time_t.
+
+void CLocalParams::SetRow(CRow& oRow)
+{
+	for (size_t i = 0; i != m_nParams; ++i)
+	{
+		const CField& oField = oRow[m_pParams[i].m_nSrcColumn];
+		LocalValue&   oValue = m_vValues[i];
+
+		oValue.m_bNull = (oField == null);
+
+		if (oValue.m_bNull)
+			continue;
+
+		switch (m_pParams[i].m_eMDBColType)
+		{
+			case MDCT_INT:
+			case MDCT_IDENTITY:		oValue.m_nValue   = oField.GetInt();							break;
+			case MDCT_INT64:		oValue.m_nValue   = oField.GetInt64();							break;
+			case MDCT_DOUBLE:		oValue.m_dValue   = oField.GetDouble();							break;
+			case MDCT_CHAR:			oValue.m_nValue   = oField.GetChar();							break;
+			case MDCT_FXDSTR:
+			case MDCT_VARSTR:		oValue.m_strValue = oField.GetString();							break;
+			case MDCT_BOOL:			oValue.m_nValue   = oField.GetBool() ? 1 : 0;					break;
+			case MDCT_DATETIME:
+			case MDCT_DATE:
+			case MDCT_TIME:			oValue.m_nValue   = oField.GetTimeT();							break;
+			case MDCT_TIMESTAMP:	oValue.m_nValue   = oField.GetTimeStamp().ToTimeT();			break;
+			default:				ASSERT_FALSE();													break;
+		}
+	}
+}
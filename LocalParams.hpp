@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   LocalParams.hpp
+//! \brief  The CLocalParams class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_LOCALPARAMS_HPP
+#define MDBL_LOCALPARAMS_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "SQLParams.hpp"
+#include "LocalStmt.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! The SQL statement parameters used by the local SQL source. The statement is
+//! parsed once when the parameters are created and the row values are copied
+//! by SetRow() ready for the next CLocalSource::ExecStmt().
+
+class CLocalParams : public CSQLParams
+{
+public:
+	//! Constructor.
+	CLocalParams(CLocalStmt::Ptr pStmt, size_t nParams);
+
+	//! Destructor.
+	virtual ~CLocalParams();
+
+	//
+	// Properties.
+	//
+
+	//! Get the parsed statement.
+	CLocalStmt& Stmt() const;
+
+	//! Get the value of a parameter.
+	const LocalValue& Value(size_t n) const;
+
+	//
+	// CSQLParams interface.
+	//
+	virtual size_t NumParams() const;
+	virtual SQLParam& Param(size_t n) const;
+	virtual void SetRow(CRow& oRow);
+
+private:
+	//
+	// Members.
+	//
+	CLocalStmt::Ptr			m_pStmt;		//!< The parsed statement.
+	size_t					m_nParams;		//!< The number of parameters.
+	SQLParam*				m_pParams;		//!< The parameter definitions.
+	CLocalTable::Row		m_vValues;		//!< The parameter values.
+
+	// NotCopyable.
+	CLocalParams(const CLocalParams&);
+	CLocalParams& operator=(const CLocalParams&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the parsed statement.
+
+inline CLocalStmt& CLocalParams::Stmt() const
+{
+	return *m_pStmt;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the value of a parameter, as copied by SetRow().
+
+inline const LocalValue& CLocalParams::Value(size_t n) const
+{
+	ASSERT(n < m_nParams);
+
+	return m_vValues[n];
+}
+
+#endif // MDBL_LOCALPARAMS_HPP
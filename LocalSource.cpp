@@ -0,0 +1,513 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   LocalSource.cpp
+//! \brief  The CLocalSource class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "LocalSource.hpp"
+#include "LocalStmt.hpp"
+#include "LocalParams.hpp"
+#include "LocalCursor.hpp"
+#include "SQLException.hpp"
+#include "Table.hpp"
+#include "Column.hpp"
+#include "Trace.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// Constants.
+
+//! The table file extension.
+const tchar* CLocalSource::FILE_EXT = TXT(".tsv");
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the entire block of data to the file.
+
+bool writeAll(HANDLE hFile, const byte* pData, size_t nBytes)
+{
+	while (nBytes != 0)
+	{
+		DWORD dwChunk   = static_cast<DWORD>(std::min<size_t>(nBytes, 0x10000000));
+		DWORD dwWritten = 0;
+
+		if (!::WriteFile(hFile, pData, dwChunk, &dwWritten, nullptr) || (dwWritten != dwChunk))
+			return false;
+
+		pData  += dwChunk;
+		nBytes -= dwChunk;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read the entire contents of the file.
+
+bool readAll(HANDLE hFile, std::vector<tchar>& vFile)
+{
+	LARGE_INTEGER liSize;
+
+	if (!::GetFileSizeEx(hFile, &liSize))
+		return false;
+
+	vFile.resize(static_cast<size_t>(liSize.QuadPart) / sizeof(tchar));
+
+	byte*  pData  = reinterpret_cast<byte*>(vFile.empty() ? nullptr : &vFile[0]);
+	size_t nBytes = vFile.size() * sizeof(tchar);
+
+	while (nBytes != 0)
+	{
+		DWORD dwChunk = static_cast<DWORD>(std::min<size_t>(nBytes, 0x10000000));
+		DWORD dwRead  = 0;
+
+		if (!::ReadFile(hFile, pData, dwChunk, &dwRead, nullptr) || (dwRead == 0))
+			return false;
+
+		pData  += dwRead;
+		nBytes -= dwRead;
+	}
+
+	return true;
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+CLocalSource::CLocalSource()
+	: m_bOpen(false)
+	, m_strFolder()
+	, m_bInTrans(false)
+	, m_mTables()
+	, m_mSaved()
+	, m_nNextID(1)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construct the source and open the connection.
+
+CLocalSource::CLocalSource(const tstring& connection)
+	: m_bOpen(false)
+	, m_strFolder()
+	, m_bInTrans(false)
+	, m_mTables()
+	, m_mSaved()
+	, m_nNextID(1)
+{
+	Open(connection);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. Any open transaction is discarded.
+
+CLocalSource::~CLocalSource()
+{
+	Close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create a table for the persistent columns of an MDB table.
+
+void CLocalSource::CreateTable(const CTable& oTable)
+{
+	CLocalTable::Columns vColumns;
+
+	for (size_t i = 0; i != oTable.ColumnCount(); ++i)
+	{
+		const CColumn& oColumn = oTable.Column(i);
+
+		if (oColumn.Transient())
+			continue;
+
+		uint nFlags = oColumn.Flags() & (CColumn::NULLABLE | CColumn::UNIQUE | CColumn::PRIMARY_KEY);
+
+		vColumns.push_back(LocalColumn(oColumn.Name(), oColumn.ColType(), oColumn.Length(), nFlags));
+	}
+
+	CLocalTable oDefinition(oTable.Name(), vColumns, 0);
+
+	ExecStmt(CString(TXT("CREATE TABLE ")) + oTable.Name() + TXT(" (") + oDefinition.Definition() + TXT(")"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the file that holds a table.
+
+CPath CLocalSource::TableFile(const tchar* pszTable) const
+{
+	ASSERT(!m_strFolder.Empty());
+
+	return CPath(m_strFolder) / (CString(pszTable) + FILE_EXT);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Open the connection. The connection string is the folder holding the table
+//! files, or empty for a source that is only held in memory.
+
+void CLocalSource::Open(const tchar* pszConnection)
+{
+	ASSERT(m_bInTrans == false);
+
+	CString strFolder = pszConnection;
+
+	if (!strFolder.Empty())
+	{
+		DWORD dwAttribs = ::GetFileAttributes(strFolder);
+
+		if ( (dwAttribs == INVALID_FILE_ATTRIBUTES) || ((dwAttribs & FILE_ATTRIBUTE_DIRECTORY) == 0) )
+			throw CSQLException(CSQLException::E_CONNECT_FAILED, pszConnection, TXT("The folder does not exist"));
+	}
+
+	m_mTables.clear();
+	m_mSaved.clear();
+
+	m_strFolder = strFolder;
+	m_bOpen     = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Close the connection. Any open transaction is discarded.
+
+void CLocalSource::Close()
+{
+	m_mTables.clear();
+	m_mSaved.clear();
+
+	m_bInTrans = false;
+	m_bOpen    = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the connection is open.
+
+bool CLocalSource::IsOpen() const
+{
+	return m_bOpen;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a statement for executing many times with different parameters.
+
+SQLParamsPtr CLocalSource::CreateParams(const tchar* pszStmt, size_t nParams)
+{
+	ASSERT(IsOpen());
+
+	CLocalStmt::Ptr pStmt(new CLocalStmt(pszStmt));
+
+	if (pStmt->NumParams() != nParams)
+		throw CSQLException(CSQLException::E_EXEC_FAILED, pszStmt, TXT("The number of parameters does not match the statement"));
+
+	return SQLParamsPtr(new CLocalParams(pStmt, nParams));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Execute a statement that has no parameters.
+
+void CLocalSource::ExecStmt(const tchar* pszStmt)
+{
+	ASSERT(IsOpen());
+
+	CTraceScope oTrace(CTraceSink::SQL_STMT, pszStmt);
+
+	CLocalStmt oStmt(pszStmt);
+
+	if (oStmt.NumParams() != 0)
+		throw CSQLException(CSQLException::E_EXEC_FAILED, pszStmt, TXT("The statement requires parameters"));
+
+	Execute(oStmt, pszStmt, nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Execute a statement with the parameters set from the last row.
+
+void CLocalSource::ExecStmt(const tchar* pszStmt, CSQLParams& oParams)
+{
+	ASSERT(IsOpen());
+
+	CTraceScope oTrace(CTraceSink::SQL_STMT, pszStmt);
+
+	CLocalParams& oLocalParams = static_cast<CLocalParams&>(oParams);
+
+	Execute(oLocalParams.Stmt(), pszStmt, &oLocalParams);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Execute a query. The whole result set is built before returning.
+
+SQLCursorPtr CLocalSource::ExecQuery(const tchar* pszQuery)
+{
+	ASSERT(IsOpen());
+
+	CTraceScope oTrace(CTraceSink::SQL_QUERY, pszQuery);
+
+	CLocalStmt oStmt(pszQuery);
+
+	if (oStmt.StmtType() != CLocalStmt::SELECT_STMT)
+		throw CSQLException(CSQLException::E_EXEC_FAILED, pszQuery, TXT("The statement is not a query"));
+
+	if (oStmt.NumParams() != 0)
+		throw CSQLException(CSQLException::E_EXEC_FAILED, pszQuery, TXT("The statement requires parameters"));
+
+	CLocalTable* pTable = FindTable(oStmt.TableName(), pszQuery);
+
+	if (pTable == nullptr)
+		throw CSQLException(CSQLException::E_EXEC_FAILED, pszQuery, CString(TXT("Invalid object name '")) + oStmt.TableName() + TXT("'"));
+
+	CLocalTable::Columns vColumns;
+	CLocalTable::Rows    vRows;
+
+	oStmt.Query(*pTable, vColumns, vRows);
+
+	return SQLCursorPtr(new CLocalCursor(vColumns, vRows));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a transaction is in progress.
+
+bool CLocalSource::InTrans()
+{
+	return m_bInTrans;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start a transaction. The tables are only written when it is committed.
+
+void CLocalSource::BeginTrans()
+{
+	ASSERT(IsOpen());
+	ASSERT(m_bInTrans == false);
+
+	m_bInTrans = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Commit the transaction by writing each table changed within it. The tables
+//! are written one at a time, so a failure can leave some of them written.
+
+void CLocalSource::CommitTrans()
+{
+	ASSERT(m_bInTrans == true);
+
+	Tables mSaved;
+
+	mSaved.swap(m_mSaved);
+	m_bInTrans = false;
+
+	for (Tables::const_iterator it = mSaved.begin(); it != mSaved.end(); ++it)
+	{
+		Tables::const_iterator itTable = m_mTables.find(it->first);
+
+		if (itTable == m_mTables.end())
+			continue;
+
+		try
+		{
+			WriteTable(*itTable->second);
+		}
+		catch (const CSQLException& e)
+		{
+			throw CSQLException(CSQLException::E_TRANS_FAILED, TXT("COMMIT"), e.twhat());
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Rollback the transaction by restoring each table changed within it.
+
+void CLocalSource::RollbackTrans()
+{
+	ASSERT(m_bInTrans == true);
+
+	for (Tables::const_iterator it = m_mSaved.begin(); it != m_mSaved.end(); ++it)
+	{
+		// Created within the transaction?
+		if (it->second.get() == nullptr)
+			m_mTables.erase(it->first);
+		else
+			m_mTables[it->first] = it->second;
+	}
+
+	m_mSaved.clear();
+	m_bInTrans = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Execute a parsed statement. Outside a transaction the table is written back
+//! to its file straight away.
+
+void CLocalSource::Execute(CLocalStmt& oStmt, const tchar* pszStmt, const CLocalParams* pParams)
+{
+	const CString& strTable = oStmt.TableName();
+
+	if (oStmt.StmtType() == CLocalStmt::SELECT_STMT)
+		throw CSQLException(CSQLException::E_EXEC_FAILED, pszStmt, TXT("A query cannot be executed as a statement"));
+
+	if (oStmt.StmtType() == CLocalStmt::CREATE_STMT)
+	{
+		if (FindTable(strTable, pszStmt) != nullptr)
+			throw CSQLException(CSQLException::E_EXEC_FAILED, pszStmt, CString(TXT("There is already an object named '")) + strTable + TXT("'"));
+
+		CLocalTable::Ptr pTable(new CLocalTable(strTable, oStmt.Definition(), m_nNextID++));
+
+		m_mTables[strTable] = pTable;
+
+		if (m_bInTrans)
+			m_mSaved[strTable] = CLocalTable::Ptr();
+		else
+			WriteTable(*pTable);
+
+		return;
+	}
+
+	CLocalTable& oTable = ChangeTable(strTable, pszStmt);
+
+	oStmt.Execute(oTable, pParams);
+
+	if (!m_bInTrans)
+		WriteTable(oTable);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find a table, reading it from its file if required. Returns nullptr if the
+//! table does not exist.
+
+CLocalTable* CLocalSource::FindTable(const CString& strTable, const tchar* pszStmt)
+{
+	Tables::const_iterator it = m_mTables.find(strTable);
+
+	if (it != m_mTables.end())
+		return it->second.get();
+
+	CLocalTable::Ptr pTable = ReadTable(strTable, pszStmt);
+
+	if (pTable.get() == nullptr)
+		return nullptr;
+
+	m_mTables[strTable] = pTable;
+
+	return pTable.get();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find a table that is about to be changed. Within a transaction a copy of the
+//! table is kept the first time it is changed, for a rollback.
+
+CLocalTable& CLocalSource::ChangeTable(const CString& strTable, const tchar* pszStmt)
+{
+	CLocalTable* pTable = FindTable(strTable, pszStmt);
+
+	if (pTable == nullptr)
+		throw CSQLException(CSQLException::E_EXEC_FAILED, pszStmt, CString(TXT("Invalid object name '")) + strTable + TXT("'"));
+
+	if (m_bInTrans && (m_mSaved.find(strTable) == m_mSaved.end()))
+		m_mSaved[strTable] = CLocalTable::Ptr(new CLocalTable(*pTable));
+
+	return *pTable;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a table from its file. The first line holds the column definitions
+//! and each subsequent line a row. Returns a null pointer if there is no file.
+
+CLocalTable::Ptr CLocalSource::ReadTable(const CString& strTable, const tchar* pszStmt)
+{
+	if (m_strFolder.Empty())
+		return CLocalTable::Ptr();
+
+	CPath strFile = TableFile(strTable);
+
+	if (::GetFileAttributes(strFile) == INVALID_FILE_ATTRIBUTES)
+		return CLocalTable::Ptr();
+
+	HANDLE hFile = ::CreateFile(strFile, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		throw CSQLException(CSQLException::E_EXEC_FAILED, pszStmt, Core::fmt(TXT("Failed to open '%s'"), strFile.c_str()).c_str());
+
+	std::vector<tchar> vFile;
+	bool               bRead = readAll(hFile, vFile);
+
+	::CloseHandle(hFile);
+
+	if (!bRead)
+		throw CSQLException(CSQLException::E_EXEC_FAILED, pszStmt, Core::fmt(TXT("Failed to read from '%s'"), strFile.c_str()).c_str());
+
+	const tchar* pszBegin = vFile.empty() ? nullptr : &vFile[0];
+	const tchar* pszEnd   = pszBegin + vFile.size();
+	const tchar* pszLine  = pszBegin;
+
+	CLocalTable::Ptr   pTable;
+	CLocalTable::Row   vRow;
+	size_t             nLine = 0;
+
+	while (pszLine != pszEnd)
+	{
+		const tchar* pszEOL = std::find(pszLine, pszEnd, TXT('\n'));
+		const tchar* pszNext = (pszEOL != pszEnd) ? pszEOL+1 : pszEnd;
+
+		if ( (pszEOL != pszLine) && (*(pszEOL-1) == TXT('\r')) )
+			--pszEOL;
+
+		++nLine;
+
+		if (pTable.get() == nullptr)
+		{
+			CLocalTable::Columns vColumns;
+
+			CLocalStmt::ParseColumns(tstring(pszLine, pszEOL).c_str(), vColumns);
+
+			pTable = CLocalTable::Ptr(new CLocalTable(strTable, vColumns, m_nNextID++));
+		}
+		else
+		{
+			if (!pTable->ReadRow(pszLine, pszEOL, vRow))
+				throw CSQLException(CSQLException::E_EXEC_FAILED, pszStmt, Core::fmt(TXT("Line %u of '%s' is invalid"), static_cast<uint>(nLine), strFile.c_str()).c_str());
+
+			pTable->Append(vRow);
+		}
+
+		pszLine = pszNext;
+	}
+
+	if (pTable.get() == nullptr)
+		throw CSQLException(CSQLException::E_EXEC_FAILED, pszStmt, Core::fmt(TXT("The file '%s' has no column definitions"), strFile.c_str()).c_str());
+
+	return pTable;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a table to its file, if the source has a folder. The file is replaced
+//! once the new contents have been written.
+
+void CLocalSource::WriteTable(const CLocalTable& oTable)
+{
+	if (m_strFolder.Empty())
+		return;
+
+	CPath   strFile = TableFile(oTable.m_strName);
+	CString strTemp = strFile + TXT(".tmp");
+	tstring strText = oTable.Definition().c_str();
+
+	strText += TXT('\n');
+
+	for (size_t i = 0; i != oTable.m_vRows.size(); ++i)
+		oTable.WriteRow(oTable.m_vRows[i], strText);
+
+	HANDLE hFile = ::CreateFile(strTemp, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		throw CSQLException(CSQLException::E_EXEC_FAILED, strFile, Core::fmt(TXT("Failed to create '%s'"), strTemp.c_str()).c_str());
+
+	bool bWritten = writeAll(hFile, reinterpret_cast<const byte*>(strText.data()), strText.size() * sizeof(tchar));
+
+	::CloseHandle(hFile);
+
+	if (!bWritten)
+		throw CSQLException(CSQLException::E_EXEC_FAILED, strFile, Core::fmt(TXT("Failed to write to '%s'"), strTemp.c_str()).c_str());
+
+	if (!::MoveFileEx(strTemp, strFile, MOVEFILE_REPLACE_EXISTING))
+		throw CSQLException(CSQLException::E_EXEC_FAILED, strFile, Core::fmt(TXT("Failed to replace '%s'"), strFile.c_str()).c_str());
+}
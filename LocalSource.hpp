@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   LocalSource.hpp
+//! \brief  The CLocalSource class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_LOCALSOURCE_HPP
+#define MDBL_LOCALSOURCE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "SQLSource.hpp"
+#include "LocalTable.hpp"
+#include <WCL/Path.hpp>
+
+// Forward declarations.
+class CLocalStmt;
+class CLocalParams;
+
+////////////////////////////////////////////////////////////////////////////////
+//! An in-process SQL source over a folder of local files, used to test and
+//! benchmark the table load and write-back paths without a database server.
+//! The connection string is the folder, which holds a tab separated text file
+//! per table (see TableFile()), or an empty string for a source that is only
+//! held in memory. The statements supported are described by CLocalStmt.
+//!
+//! Each table is read from its file when first used and is then held in memory.
+//! Outside a transaction each change is written back to the table's file
+//! immediately, so bulk writes should be done within a transaction, which only
+//! writes each changed table when committed. A rollback restores the tables
+//! from the copies taken when they were first changed.
+
+class CLocalSource : public CSQLSource
+{
+public:
+	//! Default constructor.
+	CLocalSource();
+
+	//! Construct the source and open the connection.
+	CLocalSource(const tstring& connection);
+
+	//! Destructor.
+	virtual ~CLocalSource();
+
+	//
+	// Methods.
+	//
+
+	//! Create a table for the persistent columns of an MDB table.
+	void CreateTable(const CTable& oTable);
+
+	//! Get the file that holds a table.
+	CPath TableFile(const tchar* pszTable) const;
+
+	//
+	// CSQLSource interface.
+	//
+	virtual void Open(const tchar* pszConnection);
+	using CSQLSource::Open; // throw(CSQLException)
+	virtual void Close();
+	virtual bool IsOpen() const;
+
+	virtual SQLParamsPtr CreateParams(const tchar* pszStmt, size_t nParams);
+	virtual void        ExecStmt(const tchar* pszStmt);
+	virtual void        ExecStmt(const tchar* pszStmt, CSQLParams& oParams);
+	virtual SQLCursorPtr ExecQuery(const tchar* pszQuery);
+	using CSQLSource::ExecQuery; // throw(CSQLException)
+
+	virtual bool InTrans();
+	virtual void BeginTrans();
+	virtual void CommitTrans();
+	virtual void RollbackTrans();
+
+	//
+	// Constants.
+	//
+
+	//! The table file extension.
+	static const tchar* FILE_EXT;
+
+private:
+	//! The tables by name.
+	typedef std::map<CString, CLocalTable::Ptr> Tables;
+
+	//
+	// Members.
+	//
+	bool	m_bOpen;		//!< Is the connection open?
+	CString	m_strFolder;	//!< The folder, if any.
+	bool	m_bInTrans;		//!< Are we inside a transaction?
+	Tables	m_mTables;		//!< The tables read or created.
+	Tables	m_mSaved;		//!< The tables changed in the transaction, as they were.
+	uint	m_nNextID;		//!< The ID of the next table schema.
+
+	//
+	// Internal methods.
+	//
+
+	//! Execute a parsed statement.
+	void Execute(CLocalStmt& oStmt, const tchar* pszStmt, const CLocalParams* pParams);
+
+	//! Find a table, reading it from its file if required.
+	CLocalTable* FindTable(const CString& strTable, const tchar* pszStmt);
+
+	//! Find a table that is about to be changed.
+	CLocalTable& ChangeTable(const CString& strTable, const tchar* pszStmt);
+
+	//! Read a table from its file.
+	CLocalTable::Ptr ReadTable(const CString& strTable, const tchar* pszStmt);
+
+	//! Write a table to its file.
+	void WriteTable(const CLocalTable& oTable);
+
+	// NotCopyable.
+	CLocalSource(const CLocalSource&);
+	CLocalSource& operator=(const CLocalSource&);
+};
+
+#endif // MDBL_LOCALSOURCE_HPP
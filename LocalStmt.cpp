@@ -0,0 +1,1032 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   LocalStmt.cpp
+//! \brief  The CLocalStmt class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "LocalStmt.hpp"
+#include "LocalParams.hpp"
+#include "SQLException.hpp"
+#include "Column.hpp"
+#include <algorithm>
+
+namespace
+{
+
+//! The symbols, of one or two characters and longest first.
+static const tchar* SYMBOLS[] = { TXT("<="), TXT(">="), TXT("<>"), TXT("!="), TXT(","), TXT("("), TXT(")"),
+								  TXT("*"), TXT("?"), TXT("="), TXT("<"), TXT(">"), TXT(";"), TXT("-") };
+
+//! The number of symbols.
+static const size_t NUM_SYMBOLS = sizeof(SYMBOLS) / sizeof(SYMBOLS[0]);
+
+////////////////////////////////////////////////////////////////////////////////
+//! Is the character valid within an identifier?
+
+inline bool isNameChar(tchar cChar)
+{
+	return ( (cChar >= TXT('a')) && (cChar <= TXT('z')) )
+		|| ( (cChar >= TXT('A')) && (cChar <= TXT('Z')) )
+		|| ( (cChar >= TXT('0')) && (cChar <= TXT('9')) )
+		|| (cChar == TXT('_')) || (cChar == TXT('#')) || (cChar == TXT('@')) || (cChar == TXT('$'));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Is the character a decimal digit?
+
+inline bool isDigit(tchar cChar)
+{
+	return (cChar >= TXT('0')) && (cChar <= TXT('9'));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The predicate used to order the rows of a table by a list of columns.
+
+class RowLess
+{
+public:
+	RowLess(const CLocalTable& oTable, const std::vector<size_t>& vColumns, const std::vector<bool>* pDescending)
+		: m_oTable(oTable), m_vColumns(vColumns), m_pDescending(pDescending)
+	{ }
+
+	//! Compare two rows, returning -1, 0 or 1.
+	int Compare(size_t nLHS, size_t nRHS) const
+	{
+		const CLocalTable::Row& vLHS = m_oTable.m_vRows[nLHS];
+		const CLocalTable::Row& vRHS = m_oTable.m_vRows[nRHS];
+
+		for (size_t i = 0; i != m_vColumns.size(); ++i)
+		{
+			size_t            nColumn = m_vColumns[i];
+			CLocalTable::Kind eKind   = CLocalTable::ValueKind(m_oTable.m_vColumns[nColumn].m_eMDBColType);
+			int               nResult = CLocalTable::Compare(eKind, vLHS[nColumn], vRHS[nColumn]);
+
+			if (nResult != 0)
+				return ( (m_pDescending != nullptr) && (*m_pDescending)[i] ) ? -nResult : nResult;
+		}
+
+		return 0;
+	}
+
+	bool operator()(size_t nLHS, size_t nRHS) const
+	{
+		return (Compare(nLHS, nRHS) < 0);
+	}
+
+private:
+	const CLocalTable&			m_oTable;
+	const std::vector<size_t>&	m_vColumns;
+	const std::vector<bool>*	m_pDescending;
+};
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor. The statement is parsed, but the column names are not resolved
+//! until it is executed against a table.
+
+CLocalStmt::CLocalStmt(const tchar* pszStmt)
+	: m_strStmt(pszStmt)
+	, m_eType(SELECT_STMT)
+	, m_strTable()
+	, m_nParams(0)
+	, m_bAllColumns(false)
+	, m_vNames()
+	, m_vValues()
+	, m_vWhere()
+	, m_nWhere(Core::npos)
+	, m_vGroupBy()
+	, m_vOrderBy()
+	, m_vDescending()
+	, m_vDefinition()
+	, m_nTableID(0)
+	, m_vColumns()
+	, m_vGroupCols()
+	, m_vOrderCols()
+	, m_vTokens()
+	, m_nToken(0)
+{
+	Tokenise();
+	Parse();
+
+	m_vTokens.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor used to parse a fragment.
+
+CLocalStmt::CLocalStmt()
+	: m_strStmt()
+	, m_eType(CREATE_STMT)
+	, m_strTable()
+	, m_nParams(0)
+	, m_bAllColumns(false)
+	, m_vNames()
+	, m_vValues()
+	, m_vWhere()
+	, m_nWhere(Core::npos)
+	, m_vGroupBy()
+	, m_vOrderBy()
+	, m_vDescending()
+	, m_vDefinition()
+	, m_nTableID(0)
+	, m_vColumns()
+	, m_vGroupCols()
+	, m_vOrderCols()
+	, m_vTokens()
+	, m_nToken(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a list of column definitions, as used by CREATE TABLE and the first
+//! line of a table file.
+
+void CLocalStmt::ParseColumns(const tchar* pszDefinition, CLocalTable::Columns& vColumns)
+{
+	CLocalStmt oStmt;
+
+	oStmt.m_strStmt = pszDefinition;
+	oStmt.Tokenise();
+	oStmt.ParseDefinition();
+
+	if (oStmt.Peek().m_eType != Token::END)
+		oStmt.Error(Core::fmt(TXT("Incorrect syntax near '%s'"), oStmt.Peek().m_strText.c_str()).c_str());
+
+	vColumns = oStmt.m_vDefinition;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Execute a SELECT statement. The result set is built in full.
+
+void CLocalStmt::Query(CLocalTable& oTable, CLocalTable::Columns& vColumns, CLocalTable::Rows& vRows)
+{
+	ASSERT(m_eType == SELECT_STMT);
+
+	Resolve(oTable);
+	Bind(oTable, nullptr);
+
+	Indexes vMatches;
+
+	FindRows(oTable, vMatches);
+
+	// Remove the duplicate groups.
+	if (!m_vGroupCols.empty())
+	{
+		RowLess oLess(oTable, m_vGroupCols, nullptr);
+		Indexes vGroups;
+
+		std::stable_sort(vMatches.begin(), vMatches.end(), oLess);
+
+		for (size_t i = 0; i != vMatches.size(); ++i)
+		{
+			if ( vGroups.empty() || (oLess.Compare(vGroups.back(), vMatches[i]) != 0) )
+				vGroups.push_back(vMatches[i]);
+		}
+
+		vMatches.swap(vGroups);
+	}
+
+	if (!m_vOrderCols.empty())
+		std::stable_sort(vMatches.begin(), vMatches.end(), RowLess(oTable, m_vOrderCols, &m_vDescending));
+
+	vColumns.clear();
+	vRows.clear();
+
+	for (size_t i = 0; i != m_vColumns.size(); ++i)
+	{
+		vColumns.push_back(oTable.m_vColumns[m_vColumns[i]]);
+		vColumns.back().m_nDstColumn = i;
+	}
+
+	vRows.resize(vMatches.size());
+
+	for (size_t r = 0; r != vMatches.size(); ++r)
+	{
+		const CLocalTable::Row& vSrcRow = oTable.m_vRows[vMatches[r]];
+		CLocalTable::Row&       vDstRow = vRows[r];
+
+		vDstRow.reserve(m_vColumns.size());
+
+		for (size_t i = 0; i != m_vColumns.size(); ++i)
+			vDstRow.push_back(vSrcRow[m_vColumns[i]]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Execute an INSERT, UPDATE or DELETE statement. Returns the number of rows
+//! affected. Only the NOT NULL column constraint is enforced.
+
+size_t CLocalStmt::Execute(CLocalTable& oTable, const CLocalParams* pParams)
+{
+	ASSERT( (m_eType == INSERT_STMT) || (m_eType == UPDATE_STMT) || (m_eType == DELETE_STMT) );
+
+	Resolve(oTable);
+	Bind(oTable, pParams);
+
+	// Append a row?
+	if (m_eType == INSERT_STMT)
+	{
+		CLocalTable::Row vRow(oTable.m_vColumns.size());
+
+		for (size_t i = 0; i != m_vColumns.size(); ++i)
+			vRow[m_vColumns[i]] = m_vValues[i].m_oValue;
+
+		for (size_t i = 0; i != vRow.size(); ++i)
+			CheckValue(oTable.m_vColumns[i], vRow[i]);
+
+		oTable.Append(vRow);
+
+		return 1;
+	}
+
+	Indexes vMatches;
+
+	FindRows(oTable, vMatches);
+
+	// Change the matching rows?
+	if (m_eType == UPDATE_STMT)
+	{
+		for (size_t i = 0; i != m_vColumns.size(); ++i)
+			CheckValue(oTable.m_vColumns[m_vColumns[i]], m_vValues[i].m_oValue);
+
+		for (size_t r = 0; r != vMatches.size(); ++r)
+		{
+			CLocalTable::Row& vRow = oTable.m_vRows[vMatches[r]];
+
+			for (size_t i = 0; i != m_vColumns.size(); ++i)
+				vRow[m_vColumns[i]] = m_vValues[i].m_oValue;
+		}
+
+		if (!vMatches.empty())
+		{
+			for (size_t i = 0; i != m_vColumns.size(); ++i)
+				oTable.ColumnChanged(m_vColumns[i]);
+		}
+
+		return vMatches.size();
+	}
+
+	// Remove the matching rows, keeping the order of the others.
+	if (!vMatches.empty())
+	{
+		CLocalTable::Rows& vRows = oTable.m_vRows;
+		size_t             nKept = 0;
+
+		for (size_t r = 0, m = 0; r != vRows.size(); ++r)
+		{
+			if ( (m != vMatches.size()) && (vMatches[m] == r) )
+			{
+				++m;
+				continue;
+			}
+
+			if (nKept != r)
+				vRows[nKept].swap(vRows[r]);
+
+			++nKept;
+		}
+
+		vRows.resize(nKept);
+		oTable.RowsRemoved(vMatches);
+	}
+
+	return vMatches.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Throw an exception for an error in the statement.
+
+void CLocalStmt::Error(const tchar* pszReason) const
+{
+	throw CSQLException(CSQLException::E_EXEC_FAILED, m_strStmt, pszReason);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Split the statement into tokens. Identifiers may be [quoted] and strings
+//! use single quotes, with two for a single quote within the string.
+
+void CLocalStmt::Tokenise()
+{
+	const tchar* psz = m_strStmt.c_str();
+
+	m_vTokens.clear();
+	m_nToken = 0;
+
+	for (;;)
+	{
+		while ( (*psz == TXT(' ')) || (*psz == TXT('\t')) || (*psz == TXT('\r')) || (*psz == TXT('\n')) )
+			++psz;
+
+		Token oToken;
+
+		if (*psz == TXT('\0'))
+		{
+			oToken.m_eType = Token::END;
+			m_vTokens.push_back(oToken);
+			break;
+		}
+
+		tstring strText;
+
+		// Quoted string?
+		if (*psz == TXT('\''))
+		{
+			for (++psz; ; ++psz)
+			{
+				if (*psz == TXT('\0'))
+					Error(TXT("Unclosed quotation mark"));
+
+				if (*psz == TXT('\''))
+				{
+					if (psz[1] != TXT('\''))
+						break;
+
+					++psz;
+				}
+
+				strText += *psz;
+			}
+
+			++psz;
+			oToken.m_eType = Token::STRING;
+		}
+		// Quoted identifier?
+		else if (*psz == TXT('['))
+		{
+			for (++psz; *psz != TXT(']'); ++psz)
+			{
+				if (*psz == TXT('\0'))
+					Error(TXT("Unclosed quoted identifier"));
+
+				strText += *psz;
+			}
+
+			++psz;
+			oToken.m_eType = Token::IDENTIFIER;
+		}
+		// Number?
+		else if ( isDigit(*psz) || ( (*psz == TXT('.')) && isDigit(psz[1]) ) )
+		{
+			while ( isDigit(*psz) || (*psz == TXT('.')) )
+				strText += *psz++;
+
+			if ( (*psz == TXT('e')) || (*psz == TXT('E')) )
+			{
+				strText += *psz++;
+
+				if ( (*psz == TXT('-')) || (*psz == TXT('+')) )
+					strText += *psz++;
+
+				while (isDigit(*psz))
+					strText += *psz++;
+			}
+
+			oToken.m_eType = Token::NUMBER;
+		}
+		// Identifier or keyword?
+		else if (isNameChar(*psz))
+		{
+			while (isNameChar(*psz))
+				strText += *psz++;
+
+			oToken.m_eType = Token::IDENTIFIER;
+		}
+		// Symbol?
+		else
+		{
+			size_t i = 0;
+
+			for (; i != NUM_SYMBOLS; ++i)
+			{
+				const tchar* pszSymbol = SYMBOLS[i];
+
+				if ( (psz[0] == pszSymbol[0]) && ( (pszSymbol[1] == TXT('\0')) || (psz[1] == pszSymbol[1]) ) )
+				{
+					strText = pszSymbol;
+					psz    += strText.size();
+					break;
+				}
+			}
+
+			if (i == NUM_SYMBOLS)
+				Error(Core::fmt(TXT("Incorrect syntax near '%c'"), *psz).c_str());
+
+			oToken.m_eType = Token::SYMBOL;
+		}
+
+		oToken.m_strText = strText.c_str();
+		m_vTokens.push_back(oToken);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse the whole statement.
+
+void CLocalStmt::Parse()
+{
+	if (Accept(TXT("SELECT")))
+	{
+		m_eType = SELECT_STMT;
+
+		if (Accept(TXT("*")))
+			m_bAllColumns = true;
+		else
+			ParseNames(m_vNames);
+
+		Expect(TXT("FROM"));
+		m_strTable = ExpectName();
+
+		if (Accept(TXT("WHERE")))
+			m_nWhere = ParseOr();
+
+		if (Accept(TXT("GROUP")))
+		{
+			Expect(TXT("BY"));
+			ParseNames(m_vGroupBy);
+		}
+
+		if (Accept(TXT("ORDER")))
+		{
+			Expect(TXT("BY"));
+
+			do
+			{
+				m_vOrderBy.push_back(ExpectName());
+
+				bool bDescending = Accept(TXT("DESC"));
+
+				if (!bDescending)
+					Accept(TXT("ASC"));
+
+				m_vDescending.push_back(bDescending);
+			}
+			while (Accept(TXT(",")));
+		}
+	}
+	else if (Accept(TXT("INSERT")))
+	{
+		m_eType = INSERT_STMT;
+
+		Expect(TXT("INTO"));
+		m_strTable = ExpectName();
+
+		if (Accept(TXT("(")))
+		{
+			ParseNames(m_vNames);
+			Expect(TXT(")"));
+		}
+		else
+		{
+			m_bAllColumns = true;
+		}
+
+		Expect(TXT("VALUES"));
+		Expect(TXT("("));
+
+		do
+		{
+			m_vValues.push_back(ParseOperand());
+		}
+		while (Accept(TXT(",")));
+
+		Expect(TXT(")"));
+	}
+	else if (Accept(TXT("UPDATE")))
+	{
+		m_eType = UPDATE_STMT;
+
+		m_strTable = ExpectName();
+		Expect(TXT("SET"));
+
+		do
+		{
+			m_vNames.push_back(ExpectName());
+			Expect(TXT("="));
+			m_vValues.push_back(ParseOperand());
+		}
+		while (Accept(TXT(",")));
+
+		if (Accept(TXT("WHERE")))
+			m_nWhere = ParseOr();
+	}
+	else if (Accept(TXT("DELETE")))
+	{
+		m_eType = DELETE_STMT;
+
+		Expect(TXT("FROM"));
+		m_strTable = ExpectName();
+
+		if (Accept(TXT("WHERE")))
+			m_nWhere = ParseOr();
+	}
+	else if (Accept(TXT("CREATE")))
+	{
+		m_eType = CREATE_STMT;
+
+		Expect(TXT("TABLE"));
+		m_strTable = ExpectName();
+
+		Expect(TXT("("));
+		ParseDefinition();
+		Expect(TXT(")"));
+	}
+	else
+	{
+		Error(Core::fmt(TXT("Unsupported statement '%s'"), Peek().m_strText.c_str()).c_str());
+	}
+
+	Accept(TXT(";"));
+
+	if (Peek().m_eType != Token::END)
+		Error(Core::fmt(TXT("Incorrect syntax near '%s'"), Peek().m_strText.c_str()).c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the next token without consuming it.
+
+const CLocalStmt::Token& CLocalStmt::Peek() const
+{
+	ASSERT(m_nToken < m_vTokens.size());
+
+	return m_vTokens[m_nToken];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Consume the next token if it is the keyword or symbol, ignoring case.
+
+bool CLocalStmt::Accept(const tchar* pszText)
+{
+	const Token& oToken = Peek();
+
+	if ( ( (oToken.m_eType != Token::IDENTIFIER) && (oToken.m_eType != Token::SYMBOL) )
+	  || (tstricmp(oToken.m_strText, pszText) != 0) )
+		return false;
+
+	++m_nToken;
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Consume the next token, which must be the keyword or symbol.
+
+void CLocalStmt::Expect(const tchar* pszText)
+{
+	if (!Accept(pszText))
+		Error(Core::fmt(TXT("Expected '%s' near '%s'"), pszText, Peek().m_strText.c_str()).c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Consume the next token, which must be an identifier.
+
+CString CLocalStmt::ExpectName()
+{
+	const Token& oToken = Peek();
+
+	if (oToken.m_eType != Token::IDENTIFIER)
+		Error(Core::fmt(TXT("Expected a name near '%s'"), oToken.m_strText.c_str()).c_str());
+
+	++m_nToken;
+
+	return oToken.m_strText;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a comma separated list of column names.
+
+void CLocalStmt::ParseNames(Names& vNames)
+{
+	do
+	{
+		vNames.push_back(ExpectName());
+	}
+	while (Accept(TXT(",")));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a literal value or parameter.
+
+CLocalStmt::Operand CLocalStmt::ParseOperand()
+{
+	Operand oOperand;
+
+	oOperand.m_bParam = false;
+	oOperand.m_nParam = 0;
+	oOperand.m_bNull  = false;
+
+	if (Accept(TXT("?")))
+	{
+		oOperand.m_bParam = true;
+		oOperand.m_nParam = m_nParams++;
+	}
+	else if (Accept(TXT("NULL")))
+	{
+		oOperand.m_bNull = true;
+	}
+	else
+	{
+		bool bNegative = Accept(TXT("-"));
+
+		const Token& oToken = Peek();
+
+		if ( (oToken.m_eType != Token::NUMBER) && ((oToken.m_eType != Token::STRING) || bNegative) )
+			Error(Core::fmt(TXT("Expected a value near '%s'"), oToken.m_strText.c_str()).c_str());
+
+		oOperand.m_strLiteral = (bNegative) ? (TXT("-") + oToken.m_strText) : oToken.m_strText;
+		++m_nToken;
+	}
+
+	return oOperand;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse an OR expression, returning the node.
+
+size_t CLocalStmt::ParseOr()
+{
+	size_t nNode = ParseAnd();
+
+	while (Accept(TXT("OR")))
+	{
+		Predicate oNode;
+
+		oNode.m_eOp     = Predicate::OR;
+		oNode.m_nLHS    = nNode;
+		oNode.m_nRHS    = ParseAnd();
+		oNode.m_nColumn = Core::npos;
+
+		m_vWhere.push_back(oNode);
+		nNode = m_vWhere.size()-1;
+	}
+
+	return nNode;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse an AND expression, returning the node.
+
+size_t CLocalStmt::ParseAnd()
+{
+	size_t nNode = ParseComparison();
+
+	while (Accept(TXT("AND")))
+	{
+		Predicate oNode;
+
+		oNode.m_eOp     = Predicate::AND;
+		oNode.m_nLHS    = nNode;
+		oNode.m_nRHS    = ParseComparison();
+		oNode.m_nColumn = Core::npos;
+
+		m_vWhere.push_back(oNode);
+		nNode = m_vWhere.size()-1;
+	}
+
+	return nNode;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a comparison or parenthesised expression, returning the node.
+
+size_t CLocalStmt::ParseComparison()
+{
+	if (Accept(TXT("(")))
+	{
+		size_t nNode = ParseOr();
+
+		Expect(TXT(")"));
+
+		return nNode;
+	}
+
+	Predicate oNode;
+
+	oNode.m_nLHS      = Core::npos;
+	oNode.m_nRHS      = Core::npos;
+	oNode.m_strColumn = ExpectName();
+	oNode.m_nColumn   = Core::npos;
+
+	if (Accept(TXT("IS")))
+	{
+		oNode.m_eOp = Accept(TXT("NOT")) ? Predicate::IS_NOT_NULL : Predicate::IS_NULL;
+		Expect(TXT("NULL"));
+	}
+	else
+	{
+		if      (Accept(TXT("=")))	oNode.m_eOp = Predicate::EQ;
+		else if (Accept(TXT("<>")))	oNode.m_eOp = Predicate::NE;
+		else if (Accept(TXT("!=")))	oNode.m_eOp = Predicate::NE;
+		else if (Accept(TXT("<=")))	oNode.m_eOp = Predicate::LE;
+		else if (Accept(TXT(">=")))	oNode.m_eOp = Predicate::GE;
+		else if (Accept(TXT("<")))	oNode.m_eOp = Predicate::LT;
+		else if (Accept(TXT(">")))	oNode.m_eOp = Predicate::GT;
+		else Error(Core::fmt(TXT("Expected a comparison near '%s'"), Peek().m_strText.c_str()).c_str());
+
+		oNode.m_oOperand = ParseOperand();
+	}
+
+	m_vWhere.push_back(oNode);
+
+	return m_vWhere.size()-1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a list of column definitions.
+
+void CLocalStmt::ParseDefinition()
+{
+	do
+	{
+		CString strName = ExpectName();
+		CString strType = ExpectName();
+		COLTYPE eType   = MDCT_INT;
+		size_t  nSize   = 0;
+		uint    nFlags  = CColumn::DEFAULTS;
+
+		if (!CLocalTable::FindType(strType, eType))
+			Error(Core::fmt(TXT("Unsupported column type '%s'"), strType.c_str()).c_str());
+
+		if (Accept(TXT("(")))
+		{
+			const Token& oToken = Peek();
+			LocalValue   oValue;
+
+			if ( (oToken.m_eType != Token::NUMBER) || !CLocalTable::FromText(oToken.m_strText, MDCT_INT64, oValue) )
+				Error(Core::fmt(TXT("Expected a column size near '%s'"), oToken.m_strText.c_str()).c_str());
+
+			nSize = static_cast<size_t>(oValue.m_nValue);
+			++m_nToken;
+
+			Expect(TXT(")"));
+		}
+		else if ( (eType == MDCT_FXDSTR) || (eType == MDCT_VARSTR) )
+		{
+			Error(Core::fmt(TXT("The column '%s' has no size"), strName.c_str()).c_str());
+		}
+
+		for (;;)
+		{
+			if (Accept(TXT("NULL")))
+			{
+				nFlags |= CColumn::NULLABLE;
+			}
+			else if (Accept(TXT("NOT")))
+			{
+				Expect(TXT("NULL"));
+				nFlags &= ~CColumn::NULLABLE;
+			}
+			else if (Accept(TXT("PRIMARY")))
+			{
+				Expect(TXT("KEY"));
+				nFlags |= (CColumn::PRIMARY_KEY | CColumn::UNIQUE);
+			}
+			else if (Accept(TXT("UNIQUE")))
+			{
+				nFlags |= CColumn::UNIQUE;
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		m_vDefinition.push_back(LocalColumn(strName, eType, nSize, nFlags));
+	}
+	while (Accept(TXT(",")));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Resolve the column names and literals for a table. This is only done the
+//! first time the statement is executed against the table's schema.
+
+void CLocalStmt::Resolve(const CLocalTable& oTable)
+{
+	if (m_nTableID == oTable.m_nID)
+		return;
+
+	m_vColumns.clear();
+	m_vGroupCols.clear();
+	m_vOrderCols.clear();
+
+	if (m_bAllColumns)
+	{
+		for (size_t i = 0; i != oTable.m_vColumns.size(); ++i)
+			m_vColumns.push_back(i);
+	}
+	else
+	{
+		for (size_t i = 0; i != m_vNames.size(); ++i)
+			m_vColumns.push_back(ResolveColumn(oTable, m_vNames[i]));
+	}
+
+	if ( (m_eType == INSERT_STMT) && (m_vColumns.size() != m_vValues.size()) )
+		Error(TXT("The number of values does not match the number of columns"));
+
+	for (size_t i = 0; i != m_vValues.size(); ++i)
+		ResolveLiteral(oTable.m_vColumns[m_vColumns[i]], m_vValues[i]);
+
+	for (size_t i = 0; i != m_vWhere.size(); ++i)
+	{
+		Predicate& oNode = m_vWhere[i];
+
+		if ( (oNode.m_eOp != Predicate::AND) && (oNode.m_eOp != Predicate::OR) )
+		{
+			oNode.m_nColumn = ResolveColumn(oTable, oNode.m_strColumn);
+
+			if ( (oNode.m_eOp != Predicate::IS_NULL) && (oNode.m_eOp != Predicate::IS_NOT_NULL) )
+				ResolveLiteral(oTable.m_vColumns[oNode.m_nColumn], oNode.m_oOperand);
+		}
+	}
+
+	for (size_t i = 0; i != m_vGroupBy.size(); ++i)
+		m_vGroupCols.push_back(ResolveColumn(oTable, m_vGroupBy[i]));
+
+	// Can only select the grouped columns.
+	for (size_t i = 0; (i != m_vColumns.size()) && !m_vGroupCols.empty(); ++i)
+	{
+		if (std::find(m_vGroupCols.begin(), m_vGroupCols.end(), m_vColumns[i]) == m_vGroupCols.end())
+			Error(Core::fmt(TXT("The column '%s' is not in the GROUP BY clause"), oTable.m_vColumns[m_vColumns[i]].m_strName.c_str()).c_str());
+	}
+
+	for (size_t i = 0; i != m_vOrderBy.size(); ++i)
+		m_vOrderCols.push_back(ResolveColumn(oTable, m_vOrderBy[i]));
+
+	m_nTableID = oTable.m_nID;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Resolve a column name.
+
+size_t CLocalStmt::ResolveColumn(const CLocalTable& oTable, const CString& strName) const
+{
+	size_t nColumn = oTable.FindColumn(strName);
+
+	if (nColumn == Core::npos)
+		Error(Core::fmt(TXT("Invalid column name '%s'"), strName.c_str()).c_str());
+
+	return nColumn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Resolve a literal for the column it is compared with or assigned to. The
+//! date/time types only accept a time_t.
+
+void CLocalStmt::ResolveLiteral(const LocalColumn& oColumn, Operand& oOperand) const
+{
+	if (oOperand.m_bParam)
+		return;
+
+	if (oOperand.m_bNull)
+	{
+		oOperand.m_oValue = LocalValue();
+		return;
+	}
+
+	if (!CLocalTable::FromText(oOperand.m_strLiteral, oColumn.m_eMDBColType, oOperand.m_oValue))
+		Error(Core::fmt(TXT("Conversion failed when converting '%s' for the column '%s'"), oOperand.m_strLiteral.c_str(), oColumn.m_strName.c_str()).c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the parameter values for the columns they are compared with or assigned
+//! to.
+
+void CLocalStmt::Bind(const CLocalTable& oTable, const CLocalParams* pParams)
+{
+	if (m_nParams == 0)
+		return;
+
+	if ( (pParams == nullptr) || (pParams->NumParams() != m_nParams) )
+		Error(TXT("The number of parameters supplied does not match the statement"));
+
+	for (size_t i = 0; i != m_vValues.size(); ++i)
+		BindParam(oTable.m_vColumns[m_vColumns[i]], *pParams, m_vValues[i]);
+
+	for (size_t i = 0; i != m_vWhere.size(); ++i)
+	{
+		Predicate& oNode = m_vWhere[i];
+
+		if (oNode.m_nColumn != Core::npos)
+			BindParam(oTable.m_vColumns[oNode.m_nColumn], *pParams, oNode.m_oOperand);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set a parameter value for the column it is compared with or assigned to.
+
+void CLocalStmt::BindParam(const LocalColumn& oColumn, const CLocalParams& oParams, Operand& oOperand) const
+{
+	if (!oOperand.m_bParam)
+		return;
+
+	COLTYPE eType = oParams.Param(oOperand.m_nParam).m_eMDBColType;
+
+	if (!CLocalTable::Convert(oParams.Value(oOperand.m_nParam), eType, oColumn.m_eMDBColType, oOperand.m_oValue))
+		Error(Core::fmt(TXT("Conversion failed for parameter %u of the column '%s'"), static_cast<uint>(oOperand.m_nParam+1), oColumn.m_strName.c_str()).c_str());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the rows that match the WHERE clause, in table order. If the clause
+//! requires an integer column to equal a value, only the rows found by the
+//! table's lookup index for the column are checked.
+
+void CLocalStmt::FindRows(CLocalTable& oTable, Indexes& vRows) const
+{
+	vRows.clear();
+
+	if (m_nWhere == Core::npos)
+	{
+		vRows.reserve(oTable.m_vRows.size());
+
+		for (size_t i = 0; i != oTable.m_vRows.size(); ++i)
+			vRows.push_back(i);
+
+		return;
+	}
+
+	Indexes vNodes(1, m_nWhere);
+
+	// Look for an integer equality that must hold.
+	while (!vNodes.empty())
+	{
+		const Predicate& oNode = m_vWhere[vNodes.back()];
+
+		vNodes.pop_back();
+
+		if (oNode.m_eOp == Predicate::AND)
+		{
+			vNodes.push_back(oNode.m_nRHS);
+			vNodes.push_back(oNode.m_nLHS);
+		}
+		else if ( (oNode.m_eOp == Predicate::EQ) && !oNode.m_oOperand.m_oValue.m_bNull
+			   && (CLocalTable::ValueKind(oTable.m_vColumns[oNode.m_nColumn].m_eMDBColType) == CLocalTable::INTEGER_VALUE) )
+		{
+			Indexes vCandidates;
+
+			oTable.Lookup(oNode.m_nColumn, oNode.m_oOperand.m_oValue.m_nValue, vCandidates);
+			std::sort(vCandidates.begin(), vCandidates.end());
+
+			for (size_t i = 0; i != vCandidates.size(); ++i)
+			{
+				if (Matches(oTable, oTable.m_vRows[vCandidates[i]], m_nWhere))
+					vRows.push_back(vCandidates[i]);
+			}
+
+			return;
+		}
+	}
+
+	for (size_t i = 0; i != oTable.m_vRows.size(); ++i)
+	{
+		if (Matches(oTable, oTable.m_vRows[i], m_nWhere))
+			vRows.push_back(i);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Check if a row matches a WHERE clause node. As with SQL, a comparison with
+//! a null value is never true.
+
+bool CLocalStmt::Matches(const CLocalTable& oTable, const CLocalTable::Row& vRow, size_t nNode) const
+{
+	const Predicate& oNode = m_vWhere[nNode];
+
+	switch (oNode.m_eOp)
+	{
+		case Predicate::AND:			return Matches(oTable, vRow, oNode.m_nLHS) && Matches(oTable, vRow, oNode.m_nRHS);
+		case Predicate::OR:				return Matches(oTable, vRow, oNode.m_nLHS) || Matches(oTable, vRow, oNode.m_nRHS);
+		case Predicate::IS_NULL:		return vRow[oNode.m_nColumn].m_bNull;
+		case Predicate::IS_NOT_NULL:	return !vRow[oNode.m_nColumn].m_bNull;
+		default:						break;
+	}
+
+	const LocalValue& oValue   = vRow[oNode.m_nColumn];
+	const LocalValue& oOperand = oNode.m_oOperand.m_oValue;
+
+	if (oValue.m_bNull || oOperand.m_bNull)
+		return false;
+
+	int nResult = CLocalTable::Compare(CLocalTable::ValueKind(oTable.m_vColumns[oNode.m_nColumn].m_eMDBColType), oValue, oOperand);
+
+	switch (oNode.m_eOp)
+	{
+		case Predicate::EQ:		return (nResult == 0);
+		case Predicate::NE:		return (nResult != 0);
+		case Predicate::LT:		return (nResult <  0);
+		case Predicate::LE:		return (nResult <= 0);
+		case Predicate::GT:		return (nResult >  0);
+		case Predicate::GE:		return (nResult >= 0);
+		default:				ASSERT_FALSE();	break;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Check a value being stored in a column.
+
+void CLocalStmt::CheckValue(const LocalColumn& oColumn, const LocalValue& oValue) const
+{
+	if (oValue.m_bNull && !(oColumn.m_nFlags & CColumn::NULLABLE))
+		Error(Core::fmt(TXT("Cannot insert the value NULL into the column '%s'"), oColumn.m_strName.c_str()).c_str());
+}
@@ -0,0 +1,253 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   LocalStmt.hpp
+//! \brief  The CLocalStmt class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_LOCALSTMT_HPP
+#define MDBL_LOCALSTMT_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "LocalTable.hpp"
+
+// Forward declarations.
+class CLocalParams;
+
+////////////////////////////////////////////////////////////////////////////////
+//! A statement parsed by the local SQL source, see CLocalSource. This supports
+//! the shapes of statement that MDBL generates plus DELETE and CREATE TABLE:
+//!
+//! SELECT * | c1, ... FROM t [WHERE p] [GROUP BY c1, ...] [ORDER BY c1 [ASC|DESC], ...]
+//! INSERT INTO t [(c1, ...)] VALUES (v1, ...)
+//! UPDATE t SET c1 = v1, ... [WHERE p]
+//! DELETE FROM t [WHERE p]
+//! CREATE TABLE t (c1 type[(size)] [NULL | NOT NULL] [PRIMARY KEY | UNIQUE], ...)
+//!
+//! A predicate is made of column comparisons with a literal or parameter (=,
+//! <>, !=, <, <=, >, >=), IS [NOT] NULL, AND, OR and parentheses. A GROUP BY
+//! can only select the grouped columns as there are no aggregate functions.
+//! The column types are the MDBL ones, e.g. INT, VARSTR(50) or DATETIME, and a
+//! column is NOT NULL unless declared otherwise, as with CColumn::DEFAULTS.
+
+class CLocalStmt /*: private NotCopyable*/
+{
+public:
+	//! The types of statement.
+	enum Type
+	{
+		SELECT_STMT,
+		INSERT_STMT,
+		UPDATE_STMT,
+		DELETE_STMT,
+		CREATE_STMT,
+	};
+
+	//! The default CLocalStmt smart pointer type.
+	typedef Core::SharedPtr<CLocalStmt> Ptr;
+
+	//! Constructor.
+	CLocalStmt(const tchar* pszStmt);
+
+	//
+	// Properties.
+	//
+
+	//! Get the type of statement.
+	Type StmtType() const;
+
+	//! Get the name of the table.
+	const CString& TableName() const;
+
+	//! Get the number of parameters.
+	size_t NumParams() const;
+
+	//! Get the columns of a CREATE TABLE statement.
+	const CLocalTable::Columns& Definition() const;
+
+	//
+	// Methods.
+	//
+
+	//! Execute a SELECT statement.
+	void Query(CLocalTable& oTable, CLocalTable::Columns& vColumns, CLocalTable::Rows& vRows);
+
+	//! Execute an INSERT, UPDATE or DELETE statement.
+	size_t Execute(CLocalTable& oTable, const CLocalParams* pParams);
+
+	//! Parse a list of column definitions, as used by CREATE TABLE.
+	static void ParseColumns(const tchar* pszDefinition, CLocalTable::Columns& vColumns);
+
+private:
+	//! A token of the statement.
+	struct Token
+	{
+		enum Type { IDENTIFIER, NUMBER, STRING, SYMBOL, END };
+
+		Type	m_eType;		//!< The type of token.
+		CString	m_strText;		//!< The text, unquoted.
+	};
+
+	//! A literal value or parameter.
+	struct Operand
+	{
+		bool		m_bParam;		//!< Is the value a parameter?
+		size_t		m_nParam;		//!< The parameter, if one.
+		bool		m_bNull;		//!< Is the literal NULL?
+		CString		m_strLiteral;	//!< The literal, if not a parameter.
+		LocalValue	m_oValue;		//!< The value for the column.
+	};
+
+	//! A node of the WHERE clause.
+	struct Predicate
+	{
+		enum Op { AND, OR, EQ, NE, LT, LE, GT, GE, IS_NULL, IS_NOT_NULL };
+
+		Op			m_eOp;			//!< The operator.
+		size_t		m_nLHS;			//!< The left node, if AND or OR.
+		size_t		m_nRHS;			//!< The right node, if AND or OR.
+		CString		m_strColumn;	//!< The column name, if a comparison.
+		size_t		m_nColumn;		//!< The column, once resolved.
+		Operand		m_oOperand;		//!< The value compared with.
+	};
+
+	//! The collection of tokens.
+	typedef std::vector<Token> Tokens;
+	//! The collection of column names.
+	typedef std::vector<CString> Names;
+	//! The collection of column indexes.
+	typedef std::vector<size_t> Indexes;
+
+	//
+	// Members.
+	//
+	CString					m_strStmt;		//!< The statement text.
+	Type					m_eType;		//!< The type of statement.
+	CString					m_strTable;		//!< The table name.
+	size_t					m_nParams;		//!< The number of parameters.
+	bool					m_bAllColumns;	//!< SELECT * or INSERT without a column list?
+	Names					m_vNames;		//!< The columns selected, inserted or updated.
+	std::vector<Operand>	m_vValues;		//!< The values inserted or updated.
+	std::vector<Predicate>	m_vWhere;		//!< The WHERE clause nodes.
+	size_t					m_nWhere;		//!< The WHERE clause root node, if any.
+	Names					m_vGroupBy;		//!< The GROUP BY columns.
+	Names					m_vOrderBy;		//!< The ORDER BY columns.
+	std::vector<bool>		m_vDescending;	//!< The ORDER BY directions.
+	CLocalTable::Columns	m_vDefinition;	//!< The CREATE TABLE columns.
+	uint					m_nTableID;		//!< The schema the columns are resolved for.
+	Indexes					m_vColumns;		//!< The resolved m_vNames.
+	Indexes					m_vGroupCols;	//!< The resolved m_vGroupBy.
+	Indexes					m_vOrderCols;	//!< The resolved m_vOrderBy.
+	Tokens					m_vTokens;		//!< The tokens, whilst parsing.
+	size_t					m_nToken;		//!< The next token, whilst parsing.
+
+	//
+	// Internal methods.
+	//
+
+	//! Constructor used to parse a fragment.
+	CLocalStmt();
+
+	//! Throw an exception for an error in the statement.
+	void Error(const tchar* pszReason) const;
+
+	//! Split the statement into tokens.
+	void Tokenise();
+
+	//! Parse the whole statement.
+	void Parse();
+
+	//! Get the next token without consuming it.
+	const Token& Peek() const;
+
+	//! Consume the next token if it is a keyword or symbol.
+	bool Accept(const tchar* pszText);
+
+	//! Consume the next token, which must be a keyword or symbol.
+	void Expect(const tchar* pszText);
+
+	//! Consume the next token, which must be an identifier.
+	CString ExpectName();
+
+	//! Parse a comma separated list of column names.
+	void ParseNames(Names& vNames);
+
+	//! Parse a literal value or parameter.
+	Operand ParseOperand();
+
+	//! Parse an OR expression.
+	size_t ParseOr();
+
+	//! Parse an AND expression.
+	size_t ParseAnd();
+
+	//! Parse a comparison or parenthesised expression.
+	size_t ParseComparison();
+
+	//! Parse a list of column definitions.
+	void ParseDefinition();
+
+	//! Resolve the column names and literals for a table.
+	void Resolve(const CLocalTable& oTable);
+
+	//! Resolve a column name.
+	size_t ResolveColumn(const CLocalTable& oTable, const CString& strName) const;
+
+	//! Resolve a literal for a column.
+	void ResolveLiteral(const LocalColumn& oColumn, Operand& oOperand) const;
+
+	//! Set the parameter values for a table.
+	void Bind(const CLocalTable& oTable, const CLocalParams* pParams);
+
+	//! Set a parameter value for a column.
+	void BindParam(const LocalColumn& oColumn, const CLocalParams& oParams, Operand& oOperand) const;
+
+	//! Find the rows that match the WHERE clause.
+	void FindRows(CLocalTable& oTable, Indexes& vRows) const;
+
+	//! Check if a row matches a WHERE clause node.
+	bool Matches(const CLocalTable& oTable, const CLocalTable::Row& vRow, size_t nNode) const;
+
+	//! Check a value being stored in a column.
+	void CheckValue(const LocalColumn& oColumn, const LocalValue& oValue) const;
+
+	// NotCopyable.
+	CLocalStmt(const CLocalStmt&);
+	CLocalStmt& operator=(const CLocalStmt&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the type of statement.
+
+inline CLocalStmt::Type CLocalStmt::StmtType() const
+{
+	return m_eType;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the name of the table.
+
+inline const CString& CLocalStmt::TableName() const
+{
+	return m_strTable;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of parameters.
+
+inline size_t CLocalStmt::NumParams() const
+{
+	return m_nParams;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the columns of a CREATE TABLE statement.
+
+inline const CLocalTable::Columns& CLocalStmt::Definition() const
+{
+	return m_vDefinition;
+}
+
+#endif // MDBL_LOCALSTMT_HPP
@@ -0,0 +1,521 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   LocalTable.cpp
+//! \brief  The CLocalTable class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "LocalTable.hpp"
+#include "Column.hpp"
+#include <tchar.h>
+#include <algorithm>
+
+namespace
+{
+
+//! The column type names, the first for each type is the one written.
+static const struct { const tchar* m_pszName; COLTYPE m_eType; } TYPE_NAMES[] =
+{
+	{ TXT("INT"),		MDCT_INT		},
+	{ TXT("INT64"),		MDCT_INT64		},
+	{ TXT("DOUBLE"),	MDCT_DOUBLE		},
+	{ TXT("CHAR"),		MDCT_CHAR		},
+	{ TXT("FXDSTR"),	MDCT_FXDSTR		},
+	{ TXT("VARSTR"),	MDCT_VARSTR		},
+	{ TXT("BOOL"),		MDCT_BOOL		},
+	{ TXT("IDENTITY"),	MDCT_IDENTITY	},
+	{ TXT("DATETIME"),	MDCT_DATETIME	},
+	{ TXT("DATE"),		MDCT_DATE		},
+	{ TXT("TIME"),		MDCT_TIME		},
+	{ TXT("TIMESTAMP"),	MDCT_TIMESTAMP	},
+	{ TXT("INTEGER"),	MDCT_INT		},
+	{ TXT("BIGINT"),	MDCT_INT64		},
+	{ TXT("FLOAT"),		MDCT_DOUBLE		},
+	{ TXT("VARCHAR"),	MDCT_VARSTR		},
+	{ TXT("BIT"),		MDCT_BOOL		},
+};
+
+//! The number of column type names.
+static const size_t NUM_TYPE_NAMES = sizeof(TYPE_NAMES) / sizeof(TYPE_NAMES[0]);
+
+//! The text used for a null value.
+static const tchar NULL_TEXT[] = TXT("\\N");
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append an integer as decimal text.
+
+void appendInt(tstring& strText, int64 nValue)
+{
+	tchar  szBuffer[24];
+	tchar* pszEnd = szBuffer + (sizeof(szBuffer) / sizeof(szBuffer[0]));
+	tchar* psz    = pszEnd;
+	uint64 nDigits = (nValue < 0) ? (0 - static_cast<uint64>(nValue)) : static_cast<uint64>(nValue);
+
+	do
+	{
+		*--psz   = static_cast<tchar>(TXT('0') + (nDigits % 10));
+		nDigits /= 10;
+	}
+	while (nDigits != 0);
+
+	if (nValue < 0)
+		*--psz = TXT('-');
+
+	strText.append(psz, pszEnd);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse decimal text as an integer.
+
+bool parseInt(const tchar* pszText, int64& nValue)
+{
+	bool bNegative = (*pszText == TXT('-'));
+
+	if ( (*pszText == TXT('-')) || (*pszText == TXT('+')) )
+		++pszText;
+
+	if (*pszText == TXT('\0'))
+		return false;
+
+	uint64 nDigits = 0;
+
+	for (; *pszText != TXT('\0'); ++pszText)
+	{
+		if ( (*pszText < TXT('0')) || (*pszText > TXT('9')) )
+			return false;
+
+		nDigits = (nDigits * 10) + (*pszText - TXT('0'));
+	}
+
+	nValue = static_cast<int64>(bNegative ? (0 - nDigits) : nDigits);
+
+	return true;
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor. The ID identifies the schema so that statements can cache the
+//! column indexes they resolve.
+
+CLocalTable::CLocalTable(const CString& strName, const Columns& vColumns, uint nID)
+	: m_strName(strName)
+	, m_vColumns(vColumns)
+	, m_vRows()
+	, m_nID(nID)
+	, m_mIndexes()
+{
+	for (size_t i = 0; i != m_vColumns.size(); ++i)
+		m_vColumns[i].m_nDstColumn = i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find a column by name, ignoring case. Returns Core::npos if not found.
+
+size_t CLocalTable::FindColumn(const tchar* pszName) const
+{
+	for (size_t i = 0; i != m_vColumns.size(); ++i)
+	{
+		if (tstricmp(m_vColumns[i].m_strName, pszName) == 0)
+			return i;
+	}
+
+	return Core::npos;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a row, updating any lookup indexes.
+
+void CLocalTable::Append(const Row& vRow)
+{
+	ASSERT(vRow.size() == m_vColumns.size());
+
+	size_t nRow = m_vRows.size();
+
+	m_vRows.push_back(vRow);
+
+	for (Indexes::iterator it = m_mIndexes.begin(); it != m_mIndexes.end(); ++it)
+	{
+		const LocalValue& oValue = vRow[it->first];
+
+		if (!oValue.m_bNull)
+			it->second.insert(std::make_pair(oValue.m_nValue, nRow));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the rows with an integer value in a column. The index for the column
+//! is built on first use so that the updates and deletes MDBL writes, which
+//! find each row by its key, do not each scan the table.
+
+void CLocalTable::Lookup(size_t nColumn, int64 nValue, std::vector<size_t>& vRows)
+{
+	ASSERT(ValueKind(m_vColumns[nColumn].m_eMDBColType) == INTEGER_VALUE);
+
+	Indexes::iterator itIndex = m_mIndexes.find(nColumn);
+
+	if (itIndex == m_mIndexes.end())
+	{
+		itIndex = m_mIndexes.insert(std::make_pair(nColumn, Index())).first;
+
+		for (size_t i = 0; i != m_vRows.size(); ++i)
+		{
+			const LocalValue& oValue = m_vRows[i][nColumn];
+
+			if (!oValue.m_bNull)
+				itIndex->second.insert(std::make_pair(oValue.m_nValue, i));
+		}
+	}
+
+	std::pair<Index::const_iterator, Index::const_iterator> itRange = itIndex->second.equal_range(nValue);
+
+	for (Index::const_iterator it = itRange.first; it != itRange.second; ++it)
+		vRows.push_back(it->second);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard the lookup index for a column after its values have changed.
+
+void CLocalTable::ColumnChanged(size_t nColumn)
+{
+	m_mIndexes.erase(nColumn);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the lookup indexes after rows have been removed. The removed rows,
+//! given in ascending order, are dropped from them and the rows after the
+//! first one are moved down by the number of rows removed before them.
+
+void CLocalTable::RowsRemoved(const std::vector<size_t>& vRemoved)
+{
+	if (vRemoved.empty())
+		return;
+
+	for (Indexes::iterator itIndex = m_mIndexes.begin(); itIndex != m_mIndexes.end(); ++itIndex)
+	{
+		Index& oIndex = itIndex->second;
+
+		for (Index::iterator it = oIndex.begin(); it != oIndex.end(); )
+		{
+			size_t nRow = it->second;
+
+			// Unmoved?
+			if (nRow < vRemoved.front())
+			{
+				++it;
+				continue;
+			}
+
+			std::vector<size_t>::const_iterator itPos = std::lower_bound(vRemoved.begin(), vRemoved.end(), nRow);
+
+			// Removed?
+			if ( (itPos != vRemoved.end()) && (*itPos == nRow) )
+			{
+				oIndex.erase(it++);
+				continue;
+			}
+
+			it->second = nRow - static_cast<size_t>(itPos - vRemoved.begin());
+			++it;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the column definitions, as used by CREATE TABLE and the table file.
+
+CString CLocalTable::Definition() const
+{
+	tstring strDefinition;
+
+	for (size_t i = 0; i != m_vColumns.size(); ++i)
+	{
+		const LocalColumn& oColumn = m_vColumns[i];
+
+		if (i != 0)
+			strDefinition += TXT(", ");
+
+		strDefinition += oColumn.m_strName.c_str();
+		strDefinition += TXT(' ');
+		strDefinition += TypeName(oColumn.m_eMDBColType);
+
+		if ( (oColumn.m_eMDBColType == MDCT_FXDSTR) || (oColumn.m_eMDBColType == MDCT_VARSTR) )
+		{
+			strDefinition += TXT('(');
+			appendInt(strDefinition, static_cast<int64>(oColumn.m_nSize));
+			strDefinition += TXT(')');
+		}
+
+		if (oColumn.m_nFlags & CColumn::NULLABLE)
+			strDefinition += TXT(" NULL");
+
+		if (oColumn.m_nFlags & CColumn::PRIMARY_KEY)
+			strDefinition += TXT(" PRIMARY KEY");
+		else if (oColumn.m_nFlags & CColumn::UNIQUE)
+			strDefinition += TXT(" UNIQUE");
+	}
+
+	return strDefinition.c_str();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a row of tab separated values. A null is written as \\N and a tab,
+//! newline, carriage return or backslash within a value is escaped with a
+//! backslash. Returns false if the row does not match the columns.
+
+bool CLocalTable::ReadRow(const tchar* pszLine, const tchar* pszEnd, Row& vRow) const
+{
+	tstring strValue;
+
+	vRow.resize(m_vColumns.size());
+
+	for (size_t i = 0; i != m_vColumns.size(); ++i)
+	{
+		if (i != 0)
+		{
+			if ( (pszLine == pszEnd) || (*pszLine != TXT('\t')) )
+				return false;
+
+			++pszLine;
+		}
+
+		const tchar* pszValue = pszLine;
+
+		while ( (pszLine != pszEnd) && (*pszLine != TXT('\t')) )
+			++pszLine;
+
+		LocalValue& oValue = vRow[i];
+
+		// Null?
+		if ( ((pszLine - pszValue) == 2) && (pszValue[0] == TXT('\\')) && (pszValue[1] == TXT('N')) )
+		{
+			oValue = LocalValue();
+			continue;
+		}
+
+		strValue.clear();
+
+		for (const tchar* psz = pszValue; psz != pszLine; ++psz)
+		{
+			if ( (*psz == TXT('\\')) && ((psz+1) != pszLine) )
+			{
+				switch (*++psz)
+				{
+					case TXT('t'):	strValue += TXT('\t');	break;
+					case TXT('n'):	strValue += TXT('\n');	break;
+					case TXT('r'):	strValue += TXT('\r');	break;
+					default:		strValue += *psz;		break;
+				}
+			}
+			else
+			{
+				strValue += *psz;
+			}
+		}
+
+		if (!FromText(strValue.c_str(), m_vColumns[i].m_eMDBColType, oValue))
+			return false;
+	}
+
+	return (pszLine == pszEnd);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a row of tab separated values, terminated by a newline.
+
+void CLocalTable::WriteRow(const Row& vRow, tstring& strText) const
+{
+	ASSERT(vRow.size() == m_vColumns.size());
+
+	tstring strValue;
+
+	for (size_t i = 0; i != vRow.size(); ++i)
+	{
+		if (i != 0)
+			strText += TXT('\t');
+
+		if (vRow[i].m_bNull)
+		{
+			strText += NULL_TEXT;
+			continue;
+		}
+
+		strValue.clear();
+		ToText(vRow[i], m_vColumns[i].m_eMDBColType, strValue);
+
+		for (size_t c = 0; c != strValue.size(); ++c)
+		{
+			switch (strValue[c])
+			{
+				case TXT('\t'):	strText += TXT("\\t");	break;
+				case TXT('\n'):	strText += TXT("\\n");	break;
+				case TXT('\r'):	strText += TXT("\\r");	break;
+				case TXT('\\'):	strText += TXT("\\\\");	break;
+				default:		strText += strValue[c];	break;
+			}
+		}
+	}
+
+	strText += TXT('\n');
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the kind of value held for a column type.
+
+CLocalTable::Kind CLocalTable::ValueKind(COLTYPE eType)
+{
+	switch (eType)
+	{
+		case MDCT_DOUBLE:	return REAL_VALUE;
+		case MDCT_FXDSTR:	return STRING_VALUE;
+		case MDCT_VARSTR:	return STRING_VALUE;
+		default:			return INTEGER_VALUE;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compare two values of the same kind. A null compares less than any value.
+
+int CLocalTable::Compare(Kind eKind, const LocalValue& oLHS, const LocalValue& oRHS)
+{
+	if (oLHS.m_bNull || oRHS.m_bNull)
+		return (oRHS.m_bNull ? 1 : 0) - (oLHS.m_bNull ? 1 : 0);
+
+	switch (eKind)
+	{
+		case INTEGER_VALUE:	return (oLHS.m_nValue < oRHS.m_nValue) ? -1 : ((oLHS.m_nValue > oRHS.m_nValue) ? 1 : 0);
+		case REAL_VALUE:	return (oLHS.m_dValue < oRHS.m_dValue) ? -1 : ((oLHS.m_dValue > oRHS.m_dValue) ? 1 : 0);
+		case STRING_VALUE:	return tstricmp(oLHS.m_strValue, oRHS.m_strValue);
+		default:		ASSERT_FALSE();	break;
+	}
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a non-null value to its text form for a column type. The date/time
+//! types are written as a time_t.
+
+void CLocalTable::ToText(const LocalValue& oValue, COLTYPE eType, tstring& strText)
+{
+	ASSERT(!oValue.m_bNull);
+
+	switch (eType)
+	{
+		case MDCT_CHAR:		strText += static_cast<tchar>(oValue.m_nValue);						break;
+		case MDCT_BOOL:		strText += (oValue.m_nValue != 0) ? TXT('1') : TXT('0');			break;
+		case MDCT_DOUBLE:	strText += Core::fmt(TXT("%.17g"), oValue.m_dValue).c_str();		break;
+		case MDCT_FXDSTR:	strText += oValue.m_strValue.c_str();								break;
+		case MDCT_VARSTR:	strText += oValue.m_strValue.c_str();								break;
+		default:			appendInt(strText, oValue.m_nValue);								break;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert the text form of a value for a column type. Returns false if the
+//! text is not a valid value.
+
+bool CLocalTable::FromText(const tchar* pszText, COLTYPE eType, LocalValue& oValue)
+{
+	oValue.m_bNull = false;
+
+	switch (eType)
+	{
+		case MDCT_CHAR:
+		{
+			oValue.m_nValue = pszText[0];
+
+			return (pszText[0] != TXT('\0')) && (pszText[1] == TXT('\0'));
+		}
+
+		case MDCT_BOOL:
+		{
+			oValue.m_nValue = (pszText[0] == TXT('1')) ? 1 : 0;
+
+			return ( (pszText[0] == TXT('0')) || (pszText[0] == TXT('1')) ) && (pszText[1] == TXT('\0'));
+		}
+
+		case MDCT_DOUBLE:
+		{
+			tchar* pszEnd = nullptr;
+
+			oValue.m_dValue = _tcstod(pszText, &pszEnd);
+
+			return (pszText[0] != TXT('\0')) && (*pszEnd == TXT('\0'));
+		}
+
+		case MDCT_FXDSTR:
+		case MDCT_VARSTR:
+		{
+			oValue.m_strValue = pszText;
+
+			return true;
+		}
+
+		case MDCT_VOIDPTR:
+		case MDCT_ROWPTR:
+		case MDCT_ROWSETPTR:
+		{
+			return false;
+		}
+
+		default:
+		{
+			return parseInt(pszText, oValue.m_nValue);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a value held for one column type to another, e.g. a parameter to
+//! the column it is compared with or assigned to. Values of the same kind are
+//! copied, otherwise they are converted via their text form. Returns false if
+//! the value cannot be converted.
+
+bool CLocalTable::Convert(const LocalValue& oValue, COLTYPE eFrom, COLTYPE eTo, LocalValue& oResult)
+{
+	if ( oValue.m_bNull || (eFrom == eTo) || ( (ValueKind(eFrom) == ValueKind(eTo)) && (eFrom != MDCT_CHAR) && (eTo != MDCT_CHAR) ) )
+	{
+		oResult = oValue;
+		return true;
+	}
+
+	tstring strText;
+
+	ToText(oValue, eFrom, strText);
+
+	return FromText(strText.c_str(), eTo, oResult);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the name of a column type, as used by CREATE TABLE.
+
+const tchar* CLocalTable::TypeName(COLTYPE eType)
+{
+	for (size_t i = 0; i != NUM_TYPE_NAMES; ++i)
+	{
+		if (TYPE_NAMES[i].m_eType == eType)
+			return TYPE_NAMES[i].m_pszName;
+	}
+
+	ASSERT_FALSE();
+
+	return TXT("");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find a column type by name, ignoring case. The pointer types are not
+//! supported.
+
+bool CLocalTable::FindType(const tchar* pszName, COLTYPE& eType)
+{
+	for (size_t i = 0; i != NUM_TYPE_NAMES; ++i)
+	{
+		if (tstricmp(TYPE_NAMES[i].m_pszName, pszName) == 0)
+		{
+			eType = TYPE_NAMES[i].m_eType;
+			return true;
+		}
+	}
+
+	return false;
+}
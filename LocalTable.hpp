@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   LocalTable.hpp
+//! \brief  The CLocalTable class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_LOCALTABLE_HPP
+#define MDBL_LOCALTABLE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "SQLCursor.hpp"
+#include <vector>
+#include <map>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A value held by the local SQL source. Only the member for the kind of value
+//! held by the column is used, see CLocalTable::ValueKind().
+
+struct LocalValue
+{
+	bool	m_bNull;		//!< Is the value null?
+	int64	m_nValue;		//!< The value, if an INTEGER_VALUE.
+	double	m_dValue;		//!< The value, if a REAL_VALUE.
+	CString	m_strValue;		//!< The value, if a STRING_VALUE.
+
+	LocalValue()
+	 : m_bNull(true), m_nValue(0), m_dValue(0.0), m_strValue()
+	{}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! A column of a table held by the local SQL source.
+
+struct LocalColumn : public SQLColumn
+{
+	LocalColumn(const CString& strName, COLTYPE eType, size_t nSize, uint nFlags)
+	 : SQLColumn(0, strName, eType, nSize, nFlags)
+	{}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! A table held by the local SQL source, see CLocalSource. The values are held
+//! by kind rather than by their exact column type, e.g. all the integer and
+//! date/time types are held as an int64 with the latter as a time_t. Strings
+//! are compared ignoring case, like the default SQL Server collation.
+
+class CLocalTable
+{
+public:
+	//! The kinds of value held.
+	enum Kind
+	{
+		INTEGER_VALUE,	//!< The integer, char, bool and date/time types.
+		REAL_VALUE,		//!< MDCT_DOUBLE.
+		STRING_VALUE,	//!< MDCT_FXDSTR and MDCT_VARSTR.
+	};
+
+	//! The collection of columns.
+	typedef std::vector<LocalColumn> Columns;
+	//! The values of a row.
+	typedef std::vector<LocalValue> Row;
+	//! The collection of rows.
+	typedef std::vector<Row> Rows;
+	//! The default CLocalTable smart pointer type.
+	typedef Core::SharedPtr<CLocalTable> Ptr;
+
+	//! Constructor.
+	CLocalTable(const CString& strName, const Columns& vColumns, uint nID);
+
+	//! Find a column by name.
+	size_t FindColumn(const tchar* pszName) const;
+
+	//! Append a row.
+	void Append(const Row& vRow);
+
+	//! Find the rows with an integer value in a column.
+	void Lookup(size_t nColumn, int64 nValue, std::vector<size_t>& vRows);
+
+	//! Discard the lookup index for a column after its values have changed.
+	void ColumnChanged(size_t nColumn);
+
+	//! Update the lookup indexes after rows have been removed.
+	void RowsRemoved(const std::vector<size_t>& vRemoved);
+
+	//! Get the column definitions, as used by CREATE TABLE.
+	CString Definition() const;
+
+	//! Parse a row of tab separated values.
+	bool ReadRow(const tchar* pszLine, const tchar* pszEnd, Row& vRow) const;
+
+	//! Append a row of tab separated values.
+	void WriteRow(const Row& vRow, tstring& strText) const;
+
+	//
+	// Class methods.
+	//
+
+	//! Get the kind of value held for a column type.
+	static Kind ValueKind(COLTYPE eType);
+
+	//! Compare two values of the same kind, nulls first.
+	static int Compare(Kind eKind, const LocalValue& oLHS, const LocalValue& oRHS);
+
+	//! Convert a value to its text form for a column type.
+	static void ToText(const LocalValue& oValue, COLTYPE eType, tstring& strText);
+
+	//! Convert the text form of a value for a column type.
+	static bool FromText(const tchar* pszText, COLTYPE eType, LocalValue& oValue);
+
+	//! Convert a value held for one column type to another.
+	static bool Convert(const LocalValue& oValue, COLTYPE eFrom, COLTYPE eTo, LocalValue& oResult);
+
+	//! Get the name of a column type, as used by CREATE TABLE.
+	static const tchar* TypeName(COLTYPE eType);
+
+	//! Find a column type by name.
+	static bool FindType(const tchar* pszName, COLTYPE& eType);
+
+	//
+	// Members.
+	//
+	CString	m_strName;		//!< The table name.
+	Columns	m_vColumns;		//!< The columns.
+	Rows	m_vRows;		//!< The rows.
+	uint	m_nID;			//!< The ID of the table's schema.
+
+private:
+	//! The lookup index for an INTEGER_VALUE column.
+	typedef std::multimap<int64, size_t> Index;
+	//! The lookup indexes by column.
+	typedef std::map<size_t, Index> Indexes;
+
+	//
+	// Members.
+	//
+	Indexes	m_mIndexes;		//!< The lookup indexes built so far.
+};
+
+#endif // MDBL_LOCALTABLE_HPP
@@ -14,8 +14,13 @@
 #include "SQLException.hpp"
 #include "JoinedSet.hpp"
 #include "Join.hpp"
+#include "ChangeLog.hpp"
+#include "WorkerPool.hpp"
+#include "Trace.hpp"
+#include "MDBException.hpp"
 #include <malloc.h>
 #include <Core/UniquePtr.hpp>
+#include <algorithm>
 
 /******************************************************************************
 ** Method:		Constructor.
@@ -31,6 +36,7 @@
 
 CMDB::CMDB()
 	: m_vTables()
+	, m_oVersions()
 {
 }
 
@@ -116,6 +122,8 @@ size_t CMDB::AddTable(CTable& oTable)
 {
 	ASSERT(FindTable(oTable.Name()) == Core::npos);
 
+	m_oVersions.Attach(oTable);
+
 	return m_vTables.Add(oTable);
 }
 
@@ -167,15 +175,106 @@ CJoinedSet CMDB::Select(const CJoin& oQuery) const
 	for (size_t i = 0; i != nJoins; ++i)
 		apTables[i] = &Table(oQuery[i].m_nTable);;
 
+	CTraceScope oTrace(CTraceSink::JOIN, apTables[0]->Name().c_str());
+
 	// Create the joined result set.
 	CJoinedSet oJS(nJoins, apTables);
 
 	// Run the query.
-	DoJoin(oQuery, 0, *(static_cast<CRow*>(nullptr)), oJS);
+	DoJoin(oQuery, 0, *(static_cast<CRow*>(nullptr)), oJS, nullptr);
+
+	oTrace.Size(oJS.Count());
+
+	return oJS;
+}
+
+/******************************************************************************
+** Method:		Select()
+**
+** Description:	Executes a query involving a join across tables, as above, and
+**				adds the rows scanned, comparisons and elapsed time to the
+**				counters.
+**
+** Parameters:	oQuery	The join query.
+**				oStats	The counters to add to.
+**
+** Returns:		The result set.
+**
+*******************************************************************************
+*/
+
+CJoinedSet CMDB::Select(const CJoin& oQuery, CQueryStats& oStats) const
+{
+	ASSERT(oQuery.Count() > 1);
+
+	size_t nJoins = oQuery.Count();
+
+	// Create the table list.
+	CTable** apTables = static_cast<CTable**>(_alloca(sizeof(CTable*) * nJoins));
+
+	for (size_t i = 0; i != nJoins; ++i)
+		apTables[i] = &Table(oQuery[i].m_nTable);
+
+	CTraceScope oTrace(CTraceSink::JOIN, apTables[0]->Name().c_str());
+
+	CQueryStats oJoin;
+	CJoinedSet  oJS(nJoins, apTables);
+
+	// Run and time the query.
+	{
+		CQueryStats::Timer oTimer(oJoin);
+
+		DoJoin(oQuery, 0, *(static_cast<CRow*>(nullptr)), oJS, &oJoin);
+
+		oJoin.m_nRowsMatched = oJS.Count();
+	}
+
+	oStats += oJoin;
+
+	oTrace.Size(oJS.Count());
 
 	return oJS;
 }
 
+/******************************************************************************
+** Method:		Explain()
+**
+** Description:	Describes how Select() would run the join query. Each join is
+**				a nested loop which scans the whole of the joined table for
+**				every row of the tables before it.
+**
+** Parameters:	oQuery	The join query.
+**
+** Returns:		The plan, one step per line.
+**
+*******************************************************************************
+*/
+
+CString CMDB::Explain(const CJoin& oQuery) const
+{
+	ASSERT(oQuery.Count() > 1);
+
+	const CTable& oFirst = Table(oQuery[0].m_nTable);
+
+	CString strPlan = Core::fmt(TXT("SCAN %s (%u rows)"), oFirst.Name().c_str(), static_cast<uint>(oFirst.RowCount())).c_str();
+
+	for (size_t i = 1; i != oQuery.Count(); ++i)
+	{
+		const CJoinTable& oJoin   = oQuery[i];
+		const CTable&     oLHS    = Table(oQuery[i-1].m_nTable);
+		const CTable&     oRHS    = Table(oJoin.m_nTable);
+		const tchar*      pszType = (oJoin.m_eJoinType == OUTER_JOIN) ? TXT("OUTER") : TXT("INNER");
+
+		strPlan += Core::fmt(TXT("\n  NESTED LOOP %s JOIN %s ON %s.%s = %s.%s (%u rows per outer row)"),
+								pszType, oRHS.Name().c_str(), oLHS.Name().c_str(),
+								oLHS.Column(oJoin.m_nLHSColumn).Name().c_str(), oRHS.Name().c_str(),
+								oRHS.Column(oJoin.m_nRHSColumn).Name().c_str(),
+								static_cast<uint>(oRHS.RowCount())).c_str();
+	}
+
+	return strPlan;
+}
+
 /******************************************************************************
 ** Method:		DoJoin()
 **
@@ -184,13 +283,14 @@ CJoinedSet CMDB::Select(const CJoin& oQuery) const
 ** Parameters:	oQuery	The join query.
 **				nJoin	The join to perform.
 **				oJS		The result set to append to.
+**				pStats	The counters to update or nullptr.
 **
 ** Returns:		The number of rows appended.
 **
 *******************************************************************************
 */
 
-size_t CMDB::DoJoin(const CJoin& oQuery, size_t nJoin, const CRow& oLHSRow, CJoinedSet& oJS) const
+size_t CMDB::DoJoin(const CJoin& oQuery, size_t nJoin, const CRow& oLHSRow, CJoinedSet& oJS, CQueryStats* pStats) const
 {
 	// Get the table to join on.
 	CTable& oRHSTable = Table(oQuery[nJoin].m_nTable);
@@ -207,6 +307,15 @@ size_t CMDB::DoJoin(const CJoin& oQuery, size_t nJoin, const CRow& oLHSRow, CJoi
 		// Get the row.
 		CRow& oRHSRow = oRHSTable[r];
 
+		// Counting?
+		if (pStats != nullptr)
+		{
+			++pStats->m_nRowsScanned;
+
+			if (nJoin != 0)
+				++pStats->m_nComparisons;
+		}
+
 		// Scanning first table OR this row matches?
 		if ( (nJoin == 0) || (oRHSRow[nRHSColumn] == oLHSRow[nLHSColumn]) )
 		{
@@ -214,7 +323,7 @@ size_t CMDB::DoJoin(const CJoin& oQuery, size_t nJoin, const CRow& oLHSRow, CJoi
 
 			// More joins to process?
 			if (nJoin < (oQuery.Count()-1))
-				nRows = DoJoin(oQuery, nJoin+1, oRHSRow, oJS);
+				nRows = DoJoin(oQuery, nJoin+1, oRHSRow, oJS, pStats);
 
 			// Join succesful?
 			if (nRows > 0)
@@ -245,6 +354,54 @@ size_t CMDB::DoJoin(const CJoin& oQuery, size_t nJoin, const CRow& oLHSRow, CJoi
 	return nMatches;
 }
 
+/******************************************************************************
+** Method:		MemoryUsage()
+**
+** Description:	Gets the heap memory used by all the tables, by category. See
+**				CTable::MemoryUsage() for the usage of each table.
+**
+** Parameters:	None.
+**
+** Returns:		The usage.
+**
+*******************************************************************************
+*/
+
+CMemoryUsage CMDB::MemoryUsage() const
+{
+	CMemoryUsage oUsage;
+
+	for (size_t i = 0; i < m_vTables.Count(); ++i)
+		oUsage += m_vTables[i].MemoryUsage();
+
+	return oUsage;
+}
+
+/******************************************************************************
+** Methods:		BeginUpdate()
+**				EndUpdate()
+**
+** Description:	Groups the changes made to the tables between the calls into a
+**				single update. Read views opened before EndUpdate() see none of
+**				the changes, see CReadView. The calls can be nested.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CMDB::BeginUpdate()
+{
+	m_oVersions.BeginUpdate();
+}
+
+void CMDB::EndUpdate()
+{
+	m_oVersions.EndUpdate();
+}
+
 /******************************************************************************
 ** Method:		Modified()
 **
@@ -296,6 +453,88 @@ void CMDB::Write(WCL::IOutputStream& rStream)
 		m_vTables[i].Write(rStream);
 }
 
+/******************************************************************************
+** Methods:		ReadDelta()
+**				WriteDelta()
+**
+** Description:	Read/write only the changes made since the last full or delta
+**				write from/to a stream. See CTable::WriteDelta().
+**
+** Parameters:	rStream		The stream.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CMDB::ReadDelta(WCL::IInputStream& rStream)
+{
+	// For all tables.
+	for (size_t i = 0; i < m_vTables.Count(); ++i)
+		m_vTables[i].ReadDelta(rStream);
+}
+
+void CMDB::WriteDelta(WCL::IOutputStream& rStream)
+{
+	// For all tables.
+	for (size_t i = 0; i < m_vTables.Count(); ++i)
+		m_vTables[i].WriteDelta(rStream);
+}
+
+/******************************************************************************
+** Methods:		ReadCompressed()
+**				WriteCompressed()
+**
+** Description:	Read/write the data from/to a stream in the compressed format.
+**				See CTable::WriteCompressed().
+**
+** Parameters:	rStream		The stream.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CMDB::ReadCompressed(WCL::IInputStream& rStream)
+{
+	// For all tables.
+	for (size_t i = 0; i < m_vTables.Count(); ++i)
+		m_vTables[i].ReadCompressed(rStream);
+}
+
+void CMDB::WriteCompressed(WCL::IOutputStream& rStream)
+{
+	// For all tables.
+	for (size_t i = 0; i < m_vTables.Count(); ++i)
+		m_vTables[i].WriteCompressed(rStream);
+}
+
+/******************************************************************************
+** Method:		MergeDeltas()
+**
+** Description:	Merges a series of deltas into a full stream to create a new
+**				base. The database is used as the schema and is left holding
+**				the merged data.
+**
+** Parameters:	rBase		The full stream the deltas were written after.
+**				vDeltas		The deltas, in the order they were written.
+**				rOutput		The stream to write the merged data to.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CMDB::MergeDeltas(WCL::IInputStream& rBase, const InputStreams& vDeltas, WCL::IOutputStream& rOutput)
+{
+	Read(rBase);
+
+	for (size_t i = 0; i < vDeltas.size(); ++i)
+		ReadDelta(*vDeltas[i]);
+
+	Write(rOutput);
+}
+
 /******************************************************************************
 ** Methods:		Read()
 **				Write()
@@ -348,6 +587,238 @@ void CMDB::Write(CSQLSource& rSource, CTable::RowTypes eRows)
 	}
 }
 
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The task used to read tables from a shared list over a single connection.
+
+class SQLReadTask : public CWorkerTask
+{
+public:
+	//! Default constructor.
+	SQLReadTask()
+		: m_pSource(nullptr), m_pTables(nullptr), m_pNext(nullptr), m_strError()
+	{ }
+
+	//! Read tables until there are none left.
+	virtual void Run()
+	{
+		for (;;)
+		{
+			size_t nTable = static_cast<size_t>(::InterlockedIncrement(m_pNext) - 1);
+
+			if (nTable >= m_pTables->size())
+				break;
+
+			CTable& oTable = *(*m_pTables)[nTable];
+
+			try
+			{
+				oTable.Read(*m_pSource);
+			}
+			catch (const Core::Exception& e)
+			{
+				m_strError = Core::fmt(TXT("Failed to read the table '%s':\n\n%s"), oTable.Name().c_str(), e.twhat()).c_str();
+				break;
+			}
+		}
+	}
+
+	//
+	// Members.
+	//
+	CSQLSource*					m_pSource;		//!< The connection.
+	const CTableSet::Tables*	m_pTables;		//!< The tables to read.
+	volatile LONG*				m_pNext;		//!< The next table to read.
+	CString						m_strError;		//!< The first error, if one.
+};
+
+}
+
+/******************************************************************************
+** Method:		Read()
+**
+** Description:	Reads the tables from a Database concurrently, using one
+**				connection per table being read. Tables are read in order of
+**				their foreign key dependencies, see
+**				CTableSet::DependencyLevels(), so a table is only read once
+**				the tables it refers to have been.
+**
+** Parameters:	vSources	The open connections.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CMDB::Read(const SQLSources& vSources)
+{
+	ASSERT(!vSources.empty());
+
+	// Nothing to gain?
+	if (vSources.size() == 1)
+	{
+		Read(*vSources[0]);
+		return;
+	}
+
+	// Discard any rows deferred by a lazy snapshot load, serially as the
+	// snapshot reference count isn't thread-safe.
+	for (size_t i = 0; i < m_vTables.Count(); ++i)
+		m_vTables[i].m_pPending.reset();
+
+	CTableSet::Levels vLevels;
+
+	m_vTables.DependencyLevels(vLevels);
+
+	std::vector<SQLReadTask>  vTasks(vSources.size());
+	std::vector<CWorkerTask*> vTaskPtrs(vSources.size());
+
+	for (size_t i = 0; i != vSources.size(); ++i)
+	{
+		ASSERT(vSources[i]->IsOpen());
+
+		vTasks[i].m_pSource = vSources[i];
+		vTaskPtrs[i]        = &vTasks[i];
+	}
+
+	// For all levels.
+	for (size_t l = 0; l != vLevels.size(); ++l)
+	{
+		volatile LONG nNext  = 0;
+		size_t        nTasks = std::min(vTasks.size(), vLevels[l].size());
+
+		for (size_t i = 0; i != nTasks; ++i)
+		{
+			vTasks[i].m_pTables = &vLevels[l];
+			vTasks[i].m_pNext   = &nNext;
+		}
+
+		CWorkerPool::Default().Execute(&vTaskPtrs[0], nTasks);
+
+		for (size_t i = 0; i != nTasks; ++i)
+		{
+			if (!vTasks[i].m_strError.Empty())
+				throw CMDBException(CMDBException::E_TASK_FAILED, vTasks[i].m_strError);
+		}
+	}
+}
+
+/******************************************************************************
+** Methods:		ReadSnapshot()
+**				WriteSnapshot()
+**
+** Description:	Read/write the data from/to a memory-mapped snapshot file. See
+**				CSnapshot for the format. READ_ONLY tables use the mapped data
+**				in place rather than copying it. The tables are read and
+**				written concurrently. The rows of LAZY_LOAD tables are only
+**				read when they are first accessed, see CTable::Load(). A subset
+**				of the tables can be read by name, the other tables are left
+**				untouched, in which case the subset should include the tables
+**				that they refer to.
+**
+** Parameters:	pszFile		The snapshot file path.
+**				astrTables	The names of the tables to read.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CMDB::ReadSnapshot(const tchar* pszFile)
+{
+	CSnapshotPtr pSnapshot = CSnapshot::Open(pszFile);
+
+	CSnapshot::Read(pSnapshot, m_vTables);
+}
+
+void CMDB::ReadSnapshot(const tchar* pszFile, const CStrArray& astrTables)
+{
+	CTableSet oTables;
+
+	for (size_t i = 0; i < astrTables.Size(); ++i)
+	{
+		size_t nTable = FindTable(astrTables[i].c_str());
+
+		ASSERT(nTable != Core::npos);
+
+		oTables.Add(m_vTables[nTable]);
+	}
+
+	CSnapshotPtr pSnapshot = CSnapshot::Open(pszFile);
+
+	CSnapshot::Read(pSnapshot, oTables);
+}
+
+void CMDB::WriteSnapshot(const tchar* pszFile)
+{
+	CSnapshot::Write(pszFile, m_vTables);
+}
+
+/******************************************************************************
+** Method:		ChangeLog()
+**
+** Description:	Attaches the change log to all tables, or detaches it if NULL.
+**				See CTable::ChangeLog().
+**
+** Parameters:	pLog	The change log or NULL.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CMDB::ChangeLog(CChangeLog* pLog)
+{
+	// For all tables.
+	for (size_t i = 0; i < m_vTables.Count(); ++i)
+		m_vTables[i].ChangeLog(pLog);
+}
+
+/******************************************************************************
+** Method:		Recover()
+**
+** Description:	Restores the database after a crash by reading the last
+**				snapshot and then replaying the committed changes in the log.
+**
+** Parameters:	pszSnapshot		The snapshot file path.
+**				pszLog			The change log file path.
+**
+** Returns:		The number of changes replayed.
+**
+*******************************************************************************
+*/
+
+size_t CMDB::Recover(const tchar* pszSnapshot, const tchar* pszLog)
+{
+	ReadSnapshot(pszSnapshot);
+
+	return CChangeLog::Replay(pszLog, *this);
+}
+
+/******************************************************************************
+** Method:		Checkpoint()
+**
+** Description:	Writes a new snapshot and then discards the change log as its
+**				contents are now in the snapshot. No changes must be made
+**				whilst the checkpoint is taken.
+**
+** Parameters:	pszSnapshot		The snapshot file path.
+**				oLog			The change log.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CMDB::Checkpoint(const tchar* pszSnapshot, CChangeLog& oLog)
+{
+	WriteSnapshot(pszSnapshot);
+
+	oLog.Truncate();
+}
+
 /******************************************************************************
 ** Method:		ResetRowFlags()
 **
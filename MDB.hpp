@@ -17,6 +17,8 @@
 
 #include "Table.hpp"
 #include "TableSet.hpp"
+#include "VersionStore.hpp"
+#include <vector>
 
 /******************************************************************************
 ** 
@@ -27,6 +29,17 @@
 
 class CMDB
 {
+public:
+	//
+	// Types.
+	//
+
+	//! A collection of input streams.
+	typedef std::vector<WCL::IInputStream*> InputStreams;
+
+	//! A collection of SQL connections.
+	typedef std::vector<CSQLSource*> SQLSources;
+
 public:
 	//
 	// Constructors/Destructor.
@@ -50,6 +63,21 @@ public:
 	// Query methods.
 	//
 	virtual CJoinedSet Select(const CJoin& oQuery) const;
+	virtual CJoinedSet Select(const CJoin& oQuery, CQueryStats& oStats) const;
+	virtual CString    Explain(const CJoin& oQuery) const;
+
+	//
+	// Memory accounting methods.
+	//
+	virtual CMemoryUsage MemoryUsage() const;
+
+	//
+	// Version methods.
+	//
+	virtual void BeginUpdate();
+	virtual void EndUpdate();
+
+	const CVersionStore& Versions() const;
 
 	//
 	// Persistance methods.
@@ -59,9 +87,26 @@ public:
 	virtual void Read (WCL::IInputStream&  rStream);
 	virtual void Write(WCL::IOutputStream& rStream);
 
+	virtual void ReadDelta (WCL::IInputStream&  rStream);
+	virtual void WriteDelta(WCL::IOutputStream& rStream);
+
+	virtual void ReadCompressed (WCL::IInputStream&  rStream);
+	virtual void WriteCompressed(WCL::IOutputStream& rStream);
+
+	virtual void MergeDeltas(WCL::IInputStream& rBase, const InputStreams& vDeltas, WCL::IOutputStream& rOutput);
+
 	virtual void Read(CSQLSource& rSource);
+	virtual void Read(const SQLSources& vSources);
 	virtual void Write(CSQLSource& rSource, CTable::RowTypes eRows = CTable::ALL);
 
+	virtual void ReadSnapshot(const tchar* pszFile);
+	virtual void ReadSnapshot(const tchar* pszFile, const CStrArray& astrTables);
+	virtual void WriteSnapshot(const tchar* pszFile);
+
+	virtual void   ChangeLog(CChangeLog* pLog);
+	virtual size_t Recover(const tchar* pszSnapshot, const tchar* pszLog);
+	virtual void   Checkpoint(const tchar* pszSnapshot, CChangeLog& oLog);
+
 	virtual void ResetRowFlags();
 
 	//
@@ -74,11 +119,17 @@ protected:
 	// Members.
 	//
 	CTableSet	m_vTables;		// The tables.
+	CVersionStore m_oVersions;	// The old row versions for read views.
+
+	//
+	// Friends.
+	//
+	friend class CReadView;
 
 	//
 	// Internal methods.
 	//
-	size_t DoJoin(const CJoin& oQuery, size_t nJoin, const CRow& oLHSRow, CJoinedSet& oJS) const;
+	size_t DoJoin(const CJoin& oQuery, size_t nJoin, const CRow& oLHSRow, CJoinedSet& oJS, CQueryStats* pStats) const;
 };
 
 /******************************************************************************
@@ -103,4 +154,9 @@ inline CTable& CMDB::operator[](size_t n) const
 	return m_vTables.Table(n);
 }
 
+inline const CVersionStore& CMDB::Versions() const
+{
+	return m_oVersions;
+}
+
 #endif //MDB_HPP
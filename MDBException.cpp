@@ -0,0 +1,66 @@
+/******************************************************************************
+**
+** MODULE:		MDBEXCEPTION.CPP
+** COMPONENT:	Memory Database Library.
+** DESCRIPTION:	CMDBException class definition.
+**
+*******************************************************************************
+*/
+
+#include "Common.hpp"
+#include "MDBException.hpp"
+
+/******************************************************************************
+** Method:		Constructor.
+**
+** Description:	.
+**
+** Parameters:	eErrCode	The error code.
+**				pszDetails	The specific details of the error.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CMDBException::CMDBException(int eErrCode, const tchar* pszDetails)
+	: Exception()
+	, m_eError(eErrCode)
+{
+	// Convert error to string.
+	switch(eErrCode)
+	{
+		case E_TASK_FAILED:		m_details = TXT("A parallel task failed:\n\n");		break;
+		case E_SNAPSHOT_IO:		m_details = TXT("Snapshot file I/O failed:\n\n");	break;
+		case E_BAD_SNAPSHOT:	m_details = TXT("Invalid snapshot file:\n\n");		break;
+		case E_CHANGELOG_IO:	m_details = TXT("Change log file I/O failed:\n\n");	break;
+		case E_BAD_CHANGELOG:	m_details = TXT("Invalid change log file:\n\n");	break;
+		case E_NO_KEY_COLUMN:	m_details = TXT("Table has no key column:\n\n");	break;
+		case E_BAD_DELTA:		m_details = TXT("Invalid delta snapshot:\n\n");	break;
+		case E_BG_WRITE:		m_details = TXT("Background snapshot failed:\n\n");	break;
+		case E_BAD_BLOCK:		m_details = TXT("Invalid compressed block:\n\n");	break;
+		case E_NO_PARTITION:	m_details = TXT("No partition for key:\n\n");	break;
+		case E_LOAD_IO:			m_details = TXT("Bulk load file I/O failed:\n\n");	break;
+		case E_BAD_LOAD:		m_details = TXT("Invalid bulk load file:\n\n");	break;
+		default:				ASSERT_FALSE();										break;
+	}
+
+	// Append details.
+	m_details += pszDetails;
+}
+
+/******************************************************************************
+** Method:		Destructor.
+**
+** Description:	.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CMDBException::~CMDBException() throw()
+{
+}
@@ -0,0 +1,59 @@
+/******************************************************************************
+**
+** MODULE:		MDBEXCEPTION.HPP
+** COMPONENT:	Memory Database Library.
+** DESCRIPTION:	The CMDBException class declaration.
+**
+*******************************************************************************
+*/
+
+// Check for previous inclusion
+#ifndef MDBEXCEPTION_HPP
+#define MDBEXCEPTION_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+/******************************************************************************
+**
+** This is the exception class thrown for errors within the database itself.
+**
+*******************************************************************************
+*/
+
+class CMDBException : public Core::Exception
+{
+public:
+	//
+	// Constructors/Destructor.
+	//
+	CMDBException(int eErrCode, const tchar* pszDetails);
+	virtual ~CMDBException() throw();
+
+	//
+	// Exception codes (10 - 29).
+	//
+	enum
+	{
+		E_TASK_FAILED   = 10,	// A parallel task failed.
+		E_SNAPSHOT_IO   = 11,	// Failed to read or write a snapshot file.
+		E_BAD_SNAPSHOT  = 12,	// The snapshot file is invalid.
+		E_CHANGELOG_IO  = 13,	// Failed to read or write a change log file.
+		E_BAD_CHANGELOG = 14,	// The change log file is invalid.
+		E_NO_KEY_COLUMN = 15,	// The table has no indexed key column.
+		E_BAD_DELTA     = 16,	// The delta does not match the table.
+		E_BG_WRITE      = 17,	// A background snapshot failed.
+		E_BAD_BLOCK     = 18,	// A compressed block is invalid.
+		E_NO_PARTITION  = 19,	// No partition holds the key.
+		E_LOAD_IO       = 20,	// Failed to read a bulk load file.
+		E_BAD_LOAD      = 21,	// The bulk load file is invalid.
+	};
+
+	//
+	// Members.
+	//
+	int		m_eError;		// Error code.
+};
+
+#endif //MDBEXCEPTION_HPP
@@ -61,6 +61,18 @@ enum COLTYPE
 	MDCT_ROWSETPTR,	// MDST_POINTER (using CRow*[]).
 };
 
+/******************************************************************************
+**
+** Compiler feature detection.
+**
+*******************************************************************************
+*/
+
+// Does the compiler support rvalue references (move semantics)?
+#if (defined(_MSC_VER) && (_MSC_VER >= 1600)) || (__cplusplus >= 201103L)
+#define MDBL_HAS_RVALUE_REFS
+#endif
+
 /******************************************************************************
 **
 ** Special data type to represent a NULL value.
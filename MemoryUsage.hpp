@@ -0,0 +1,76 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   MemoryUsage.hpp
+//! \brief  The CMemoryUsage class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_MEMORYUSAGE_HPP
+#define MDBL_MEMORYUSAGE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! The heap memory used by one or more tables, by category, see
+//! CTable::MemoryUsage() and CMDB::MemoryUsage(). The sizes are of the blocks
+//! requested and so exclude the heap's own overhead. Rows that refer to a
+//! snapshot mapping only count their field headers.
+
+class CMemoryUsage
+{
+public:
+	//! Default constructor.
+	CMemoryUsage();
+
+	//! Get the total number of bytes.
+	size_t Total() const;
+
+	//! Add the usage of another table.
+	CMemoryUsage& operator+=(const CMemoryUsage& oRHS);
+
+	//
+	// Members.
+	//
+	size_t	m_nFixedData;		//!< The row buffers for the fixed size values.
+	size_t	m_nFieldOverhead;	//!< The row and field headers and the row list.
+	size_t	m_nStrings;			//!< The MDCT_VARSTR value buffers.
+	size_t	m_nIndexes;			//!< The index entries.
+	size_t	m_nNullRows;		//!< The null rows used for OUTER joins.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+inline CMemoryUsage::CMemoryUsage()
+	: m_nFixedData(0)
+	, m_nFieldOverhead(0)
+	, m_nStrings(0)
+	, m_nIndexes(0)
+	, m_nNullRows(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the total number of bytes.
+
+inline size_t CMemoryUsage::Total() const
+{
+	return m_nFixedData + m_nFieldOverhead + m_nStrings + m_nIndexes + m_nNullRows;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add the usage of another table.
+
+inline CMemoryUsage& CMemoryUsage::operator+=(const CMemoryUsage& oRHS)
+{
+	m_nFixedData     += oRHS.m_nFixedData;
+	m_nFieldOverhead += oRHS.m_nFieldOverhead;
+	m_nStrings       += oRHS.m_nStrings;
+	m_nIndexes       += oRHS.m_nIndexes;
+	m_nNullRows      += oRHS.m_nNullRows;
+
+	return *this;
+}
+
+#endif // MDBL_MEMORYUSAGE_HPP
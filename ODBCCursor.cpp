@@ -14,6 +14,7 @@
 #include "Column.hpp"
 #include "Row.hpp"
 #include "TimeStamp.hpp"
+#include "Trace.hpp"
 
 /******************************************************************************
 ** Method:		Constructor.
@@ -41,6 +42,11 @@ CODBCCursor::CODBCCursor(CODBCSource& oSource)
 	, m_bDoneBind(false)
 	, m_nFetched(0)
 	, m_nCurRow(static_cast<SQLUINTEGER>(-1))
+	, m_bPipelined(false)
+	, m_nFetchSize(FETCH_SIZE)
+	, m_nBatchRow(0)
+	, m_nBindOffset(0)
+	, m_pPipeline()
 {
 
 }
@@ -169,6 +175,9 @@ void CODBCCursor::Open(const tchar* pszStmt, SQLHSTMT hStmt)
 
 void CODBCCursor::Close()
 {
+	// Stop fetching first, it uses the statement.
+	m_pPipeline.reset();
+
 	// Free statement handle.
 	if (m_hStmt != SQL_NULL_HSTMT)
 		::SQLFreeHandle(SQL_HANDLE_STMT, m_hStmt);
@@ -191,6 +200,10 @@ void CODBCCursor::Close()
 	m_bDoneBind  = false;
 	m_nFetched   = 0;
 	m_nCurRow    = static_cast<SQLUINTEGER>(-1);
+	m_nBatchRow  = 0;
+
+	for (size_t i = 0; i < PIPELINE_DEPTH; ++i)
+		m_apRowError[i].reset();
 }
 
 /******************************************************************************
@@ -210,6 +223,35 @@ bool CODBCCursor::IsOpen() const
 	return (m_hStmt != SQL_NULL_HSTMT);
 }
 
+/******************************************************************************
+** Methods:		Pipelined()
+**
+** Description:	Gets or sets whether the rows are fetched on a background
+**				thread. When set, batches of rows are fetched into one buffer
+**				whilst the caller is consuming the previous batch from
+**				another, so that the network latency of the fetch overlaps with
+**				the work done for each row. It must be set before the first
+**				Fetch().
+**
+** Parameters:	bPipelined	Fetch on a background thread?
+**
+** Returns:		true or false.
+**
+*******************************************************************************
+*/
+
+bool CODBCCursor::Pipelined() const
+{
+	return m_bPipelined;
+}
+
+void CODBCCursor::Pipelined(bool bPipelined)
+{
+	ASSERT(!m_bDoneBind);
+
+	m_bPipelined = bPipelined;
+}
+
 /******************************************************************************
 ** Method:		NumColumns()
 **
@@ -294,20 +336,29 @@ void CODBCCursor::Bind()
 		m_nRowLen += m_pColumns[i].m_nSize;
 	}
 
+	// Use larger batches, one per buffer, if pipelined.
+	m_nFetchSize = (m_bPipelined) ? PIPELINED_FETCH_SIZE : FETCH_SIZE;
+
+	size_t nBatches = (m_bPipelined) ? PIPELINE_DEPTH : 1;
+
 	// Calculate the total buffer length.
-	m_nTotalLen = m_nRowLen * FETCH_SIZE;
+	m_nTotalLen = m_nRowLen * m_nFetchSize * nBatches;
 
 	// Allocate row buffers.
 	m_pOffsets   = new size_t[m_nColumns];
 	m_pRowData   = new byte[m_nTotalLen];
-	m_pRowStatus = new SQLUSMALLINT[FETCH_SIZE];
+	m_pRowStatus = new SQLUSMALLINT[m_nFetchSize * nBatches];
 
 	// Setup for bulk row fetching.
 	rc = ::SQLSetStmtAttr(m_hStmt, SQL_ATTR_ROW_BIND_TYPE,    reinterpret_cast<SQLPOINTER>(m_nRowLen),    0);
-	rc = ::SQLSetStmtAttr(m_hStmt, SQL_ATTR_ROW_ARRAY_SIZE,   reinterpret_cast<SQLPOINTER>(FETCH_SIZE),   0);
+	rc = ::SQLSetStmtAttr(m_hStmt, SQL_ATTR_ROW_ARRAY_SIZE,   reinterpret_cast<SQLPOINTER>(m_nFetchSize), 0);
 	rc = ::SQLSetStmtAttr(m_hStmt, SQL_ATTR_ROW_STATUS_PTR,   reinterpret_cast<SQLPOINTER>(m_pRowStatus), 0);
 	rc = ::SQLSetStmtAttr(m_hStmt, SQL_ATTR_ROWS_FETCHED_PTR, reinterpret_cast<SQLPOINTER>(&m_nFetched),  0);
 
+	// Each batch is fetched into the buffer at the bind offset.
+	if (m_bPipelined)
+		rc = ::SQLSetStmtAttr(m_hStmt, SQL_ATTR_ROW_BIND_OFFSET_PTR, reinterpret_cast<SQLPOINTER>(&m_nBindOffset), 0);
+
 	if ( (rc != SQL_SUCCESS) && (rc != SQL_SUCCESS_WITH_INFO) )
 		throw CODBCException(CODBCException::E_FETCH_FAILED, m_strStmt, m_hStmt, SQL_HANDLE_STMT);
 
@@ -365,12 +416,39 @@ bool CODBCCursor::Fetch()
 
 	// Bound outputs yet?
 	if (!m_bDoneBind)
+	{
 		Bind();
 
+		if (m_bPipelined)
+		{
+			m_pPipeline.reset(new CFetchPipeline(*this, PIPELINE_DEPTH));
+			m_pPipeline->Start();
+		}
+	}
+
 	// Still retrieving current batch?
 	if (++m_nCurRow < m_nFetched)
 		return true;
 
+	// Only the batches are traced.
+	CTraceScope oTrace(CTraceSink::SQL_FETCH, m_strStmt.c_str());
+
+	// Wait for the fetch thread?
+	if (m_bPipelined)
+	{
+		size_t nBatch = 0;
+		bool   bMore  = m_pPipeline->NextBuffer(nBatch);
+
+		// Reset batch index.
+		m_nBatchRow = nBatch * m_nFetchSize;
+		m_nFetched  = (bMore) ? static_cast<SQLUINTEGER>(m_anFetched[nBatch]) : 0;
+		m_nCurRow   = 0;
+
+		oTrace.Size(m_nFetched);
+
+		return bMore;
+	}
+
 	// Fetch the next bulk of rows.
 	SQLRETURN rc = ::SQLFetch(m_hStmt);
 
@@ -380,6 +458,8 @@ bool CODBCCursor::Fetch()
 	// Reset batch index.
 	m_nCurRow = 0;
 
+	oTrace.Size((rc != SQL_NO_DATA) ? m_nFetched : 0);
+
 	// End Of Fetch?
 	return (rc != SQL_NO_DATA);
 }
@@ -400,14 +480,27 @@ bool CODBCCursor::Fetch()
 
 void CODBCCursor::GetRow(CRow& oRow)
 {
-	SQLRETURN rc = m_pRowStatus[m_nCurRow];
+	SQLRETURN rc = m_pRowStatus[m_nBatchRow + m_nCurRow];
 
 	// Check row status.
 	if ( (rc != SQL_SUCCESS) && (rc != SQL_SUCCESS_WITH_INFO) )
+	{
+		// The fetch thread may be using the statement, so use the diagnostics
+		// it captured for the batch.
+		if (m_bPipelined)
+		{
+			const ODBCExceptionPtr& pError = m_apRowError[m_nBatchRow / m_nFetchSize];
+
+			ASSERT(pError.get() != nullptr);
+
+			throw CODBCException(*pError);
+		}
+
 		throw CODBCException(CODBCException::E_FETCH_FAILED, m_strStmt, m_hStmt, SQL_HANDLE_STMT);
+	}
 
 	// Calculate pointer to the current row.
-	byte* pRowData = m_pRowData + (m_nCurRow * m_nRowLen);
+	byte* pRowData = m_pRowData + ((m_nBatchRow + m_nCurRow) * m_nRowLen);
 
 	// For all SQL columns.
 	for (size_t iSQLCol = 0; iSQLCol < m_nColumns; ++iSQLCol)
@@ -446,3 +539,74 @@ void CODBCCursor::GetRow(CRow& oRow)
 		}
 	}
 }
+
+/******************************************************************************
+** Method:		FetchBatch()
+**
+** Description:	Fetches the next batch of rows into a buffer when pipelined.
+**				This is invoked on the fetch thread, so the diagnostics for a
+**				failed fetch, or for any rows in error, are read here whilst
+**				they still describe this batch.
+**
+** Parameters:	nBatch	The buffer to fetch into.
+**
+** Returns:		true if rows were fetched, false if there were no more.
+**
+** Exceptions:	CODBCException on error.
+**
+*******************************************************************************
+*/
+
+bool CODBCCursor::FetchBatch(size_t nBatch)
+{
+	SQLUSMALLINT* pStatus  = m_pRowStatus + (nBatch * m_nFetchSize);
+	SQLPOINTER    pFetched = &m_anFetched[nBatch];
+
+	m_nBindOffset       = nBatch * m_nFetchSize * m_nRowLen;
+	m_anFetched[nBatch] = 0;
+	m_apRowError[nBatch].reset();
+
+	SQLRETURN rc = ::SQLSetStmtAttr(m_hStmt, SQL_ATTR_ROW_STATUS_PTR, pStatus, 0);
+
+	if ( (rc == SQL_SUCCESS) || (rc == SQL_SUCCESS_WITH_INFO) )
+		rc = ::SQLSetStmtAttr(m_hStmt, SQL_ATTR_ROWS_FETCHED_PTR, pFetched, 0);
+
+	if ( (rc == SQL_SUCCESS) || (rc == SQL_SUCCESS_WITH_INFO) )
+		rc = ::SQLFetch(m_hStmt);
+
+	// End Of Fetch?
+	if (rc == SQL_NO_DATA)
+		return false;
+
+	if ( (rc != SQL_SUCCESS) && (rc != SQL_SUCCESS_WITH_INFO) )
+		throw CODBCException(CODBCException::E_FETCH_FAILED, m_strStmt, m_hStmt, SQL_HANDLE_STMT);
+
+	// Capture the error for the first row that GetRow() will reject.
+	for (SQLULEN i = 0; i < m_anFetched[nBatch]; ++i)
+	{
+		if ( (pStatus[i] != SQL_SUCCESS) && (pStatus[i] != SQL_SUCCESS_WITH_INFO) )
+		{
+			m_apRowError[nBatch].reset(new CODBCException(CODBCException::E_FETCH_FAILED, m_strStmt, m_hStmt, SQL_HANDLE_STMT));
+			break;
+		}
+	}
+
+	return true;
+}
+
+/******************************************************************************
+** Method:		CancelFetch()
+**
+** Description:	Cancels a fetch in progress on the fetch thread.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CODBCCursor::CancelFetch()
+{
+	::SQLCancel(m_hStmt);
+}
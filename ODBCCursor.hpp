@@ -16,11 +16,14 @@
 #endif
 
 #include "SQLCursor.hpp"
+#include "FetchPipeline.hpp"
+#include <Core/UniquePtr.hpp>
 #include <sql.h>
 #include <sqlext.h>
 
 // Forward declarations.
 class CODBCSource;
+class CODBCException;
 
 /******************************************************************************
 ** 
@@ -42,7 +45,7 @@ struct ODBCColumn : public SQLColumn
 *******************************************************************************
 */
 
-class CODBCCursor : public CSQLCursor
+class CODBCCursor : public CSQLCursor, private IFetchSource
 {
 public:
 	//
@@ -58,6 +61,8 @@ public:
 	// Accessors.
 	//
 	virtual bool IsOpen() const;
+	virtual bool Pipelined() const;
+	virtual void Pipelined(bool bPipelined);
 	virtual size_t NumColumns() const;
 	virtual const SQLColumn& Column(size_t n) const;
 
@@ -68,8 +73,14 @@ public:
 	virtual void GetRow(CRow& oRow);
 
 protected:
-	// Row fetch size.
-	enum { FETCH_SIZE = 10 };
+	// Row fetch sizes.
+	enum { FETCH_SIZE = 10, PIPELINED_FETCH_SIZE = 256 };
+
+	// Number of batches buffered when pipelined.
+	enum { PIPELINE_DEPTH = 2 };
+
+	// The type used to pass a row error back from the fetch thread.
+	typedef Core::SharedPtr<CODBCException> ODBCExceptionPtr;
 
 	//
 	// Members.
@@ -87,12 +98,25 @@ protected:
 	bool			m_bDoneBind;	// Bind output buffers flag.
 	SQLUINTEGER		m_nFetched;		// Number of rows fetched.
 	SQLUINTEGER		m_nCurRow;		// Current row
+	bool			m_bPipelined;	// Fetch on a background thread?
+	size_t			m_nFetchSize;	// Rows fetched per batch.
+	size_t			m_nBatchRow;	// First row of the current batch in the buffer.
+	SQLULEN			m_nBindOffset;	// Buffer offset of the batch being fetched.
+	SQLULEN			m_anFetched[PIPELINE_DEPTH];	// Rows fetched per batch.
+	ODBCExceptionPtr m_apRowError[PIPELINE_DEPTH];	// Row error per batch, if one.
+	Core::UniquePtr<CFetchPipeline> m_pPipeline;	// The fetch thread, if pipelined.
 
 	//
 	// Internal methods.
 	//
 	virtual void Bind();
 
+	//
+	// IFetchSource methods.
+	//
+	virtual bool FetchBatch(size_t nBatch);
+	virtual void CancelFetch();
+
 private:
 	// NotCopyable.
 	CODBCCursor(const CODBCCursor&);
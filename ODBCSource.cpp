@@ -14,6 +14,7 @@
 #include "ODBCParams.hpp"
 #include "ODBCCursor.hpp"
 #include "TimeStamp.hpp"
+#include "Trace.hpp"
 #include <WCL/StrArray.hpp>
 #include <malloc.h>
 
@@ -54,6 +55,7 @@ CODBCSource::CODBCSource()
 	: m_hEnv(SQL_NULL_HENV)
 	, m_hDBC(SQL_NULL_HDBC)
 	, m_bInTrans(false)
+	, m_bPipelined(false)
 {
 }
 
@@ -64,6 +66,7 @@ CODBCSource::CODBCSource(const tstring& connection)
 	: m_hEnv(SQL_NULL_HENV)
 	, m_hDBC(SQL_NULL_HDBC)
 	, m_bInTrans(false)
+	, m_bPipelined(false)
 {
 	Open(connection);
 }
@@ -210,6 +213,8 @@ void CODBCSource::ExecStmt(const tchar* pszStmt)
 {
 	ASSERT(IsOpen() == true);
 
+	CTraceScope oTrace(CTraceSink::SQL_STMT, pszStmt);
+
 	SQLRETURN	rc;
 	SQLHSTMT	hStmt = SQL_NULL_HSTMT;
 
@@ -261,6 +266,8 @@ void CODBCSource::ExecStmt(const tchar* pszStmt, CSQLParams& oParams)
 {
 	ASSERT(IsOpen() == true);
 
+	CTraceScope oTrace(CTraceSink::SQL_STMT, pszStmt);
+
 	// Downcast to get real parameters type.
 	CODBCParams& oODBCParams = static_cast<CODBCParams&>(oParams);
 
@@ -282,7 +289,8 @@ void CODBCSource::ExecStmt(const tchar* pszStmt, CSQLParams& oParams)
 ** Method:		ExecQuery()
 **
 ** Description:	Executes the given query and returns a cursor for the result
-**				set.
+**				set. If PipelinedFetch() is set the cursor fetches the rows on
+**				a background thread whilst the caller consumes them.
 **
 ** Parameters:	pszQuery	The SQL query statement.
 **
@@ -300,6 +308,8 @@ SQLCursorPtr CODBCSource::ExecQuery(const tchar* pszQuery)
 	// Allocate a cursor for the result set.
 	ODBCCursorPtr cursor(new CODBCCursor(*this));
 
+	cursor->Pipelined(m_bPipelined);
+
 	// Execute it.
 	ExecQuery(pszQuery, cursor.getRef());
 
@@ -326,6 +336,8 @@ void CODBCSource::ExecQuery(const tchar* pszQuery, CODBCCursor& oCursor)
 {
 	ASSERT(IsOpen() == true);
 
+	CTraceScope oTrace(CTraceSink::SQL_QUERY, pszQuery);
+
 	SQLRETURN	rc;
 	SQLHSTMT	hStmt = SQL_NULL_HSTMT;
 
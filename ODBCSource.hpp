@@ -52,6 +52,12 @@ public:
 
 	virtual bool IsOpen() const;
 
+	//
+	// Fetch options.
+	//
+	bool PipelinedFetch() const;
+	void PipelinedFetch(bool bPipelined);
+
 	//
 	// Statement methods.
 	//
@@ -91,6 +97,7 @@ protected:
 	SQLHENV		m_hEnv;		// Environment handle.
 	SQLHDBC		m_hDBC;		// Connection handle.
 	bool		m_bInTrans;	// In a transaction?
+	bool		m_bPipelined;	// Fetch rows on a background thread?
 
 	//
 	// Friends.
@@ -110,4 +117,14 @@ private:
 *******************************************************************************
 */
 
+inline bool CODBCSource::PipelinedFetch() const
+{
+	return m_bPipelined;
+}
+
+inline void CODBCSource::PipelinedFetch(bool bPipelined)
+{
+	m_bPipelined = bPipelined;
+}
+
 #endif //ODBCSOURCE_HPP
@@ -0,0 +1,56 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   PartitionKeys.hpp
+//! \brief  The CPartitionKeys class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_PARTITIONKEYS_HPP
+#define MDBL_PARTITIONKEYS_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "FwdDecls.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! The set of key values that the rows of a single partition can have, see
+//! CPartitionedTable. This is what CWhere::MayMatch() is asked about to find
+//! the partitions a query can skip. The answers only need to be exact when
+//! false, if in doubt a partition must answer true.
+
+class CPartitionKeys
+{
+public:
+	//! Destructor.
+	virtual ~CPartitionKeys();
+
+	//! Query if the partition may hold the key value.
+	virtual bool Contains(const CValue& oValue) const = 0;
+
+	//! Query if the partition may hold a key less than the value.
+	virtual bool ContainsLess(const CValue& oValue) const = 0;
+
+	//! Query if the partition may hold a key greater than the value.
+	virtual bool ContainsGreater(const CValue& oValue) const = 0;
+
+protected:
+	//! Default constructor.
+	CPartitionKeys();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+inline CPartitionKeys::CPartitionKeys()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+inline CPartitionKeys::~CPartitionKeys()
+{
+}
+
+#endif // MDBL_PARTITIONKEYS_HPP
@@ -0,0 +1,550 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   PartitionedTable.cpp
+//! \brief  The CPartitionedTable class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "PartitionedTable.hpp"
+#include "PartitionKeys.hpp"
+#include "Where.hpp"
+#include "ResultSet.hpp"
+#include "WorkerPool.hpp"
+#include "MDBException.hpp"
+#include <tchar.h>
+#include <algorithm>
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the value of an integer key.
+
+int64 keyValue(const CValue& oKey)
+{
+	ASSERT( (oKey.m_eType == MDST_INT) || (oKey.m_eType == MDST_INT64) );
+
+	return (oKey.m_eType == MDST_INT) ? oKey.m_iValue : oKey.m_i64Value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Calculate the hash of a key. Strings are folded to lower case when the
+//! column ignores case so that keys which compare equal share a partition.
+
+uint hashKey(const CValue& oKey, bool bIgnoreCase)
+{
+	uint nHash = 2166136261u;
+
+	if (oKey.m_eType == MDST_STRING)
+	{
+		for (const tchar* psz = oKey.m_sValue; *psz != TXT('\0'); ++psz)
+		{
+			tchar cChar = (bIgnoreCase) ? static_cast<tchar>(_totlower(*psz)) : *psz;
+
+			nHash ^= static_cast<uint>(cChar);
+			nHash *= 16777619u;
+		}
+	}
+	else
+	{
+		uint64 nValue = static_cast<uint64>(keyValue(oKey));
+
+		for (int i = 0; i != sizeof(nValue); ++i, nValue >>= 8)
+		{
+			nHash ^= static_cast<uint>(nValue & 0xFF);
+			nHash *= 16777619u;
+		}
+	}
+
+	return nHash;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The keys held by a hash partition. Only an equality can be answered.
+
+class HashKeys : public CPartitionKeys
+{
+public:
+	//! Constructor.
+	HashKeys(const CPartitionedTable& oTable, size_t nPartition)
+		: m_oTable(oTable), m_nPartition(nPartition)
+	{ }
+
+	//! Query if the partition may hold the key value.
+	virtual bool Contains(const CValue& oValue) const
+	{
+		return (!oValue.m_bNull) && (m_oTable.FindPartition(oValue) == m_nPartition);
+	}
+
+	//! Query if the partition may hold a key less than the value.
+	virtual bool ContainsLess(const CValue& /*oValue*/) const
+	{
+		return true;
+	}
+
+	//! Query if the partition may hold a key greater than the value.
+	virtual bool ContainsGreater(const CValue& /*oValue*/) const
+	{
+		return true;
+	}
+
+private:
+	//
+	// Members.
+	//
+	const CPartitionedTable&	m_oTable;		//!< The table.
+	size_t						m_nPartition;	//!< The partition.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The keys held by a range partition, from its lower bound up to, but not
+//! including, the lower bound of the next partition, if there is one.
+
+class RangeKeys : public CPartitionKeys
+{
+public:
+	//! Constructor.
+	RangeKeys(int64 nLower, bool bUpper, int64 nUpper)
+		: m_nLower(nLower), m_bUpper(bUpper), m_nUpper(nUpper)
+	{ }
+
+	//! Query if the partition may hold the key value.
+	virtual bool Contains(const CValue& oValue) const
+	{
+		if (oValue.m_bNull)
+			return false;
+
+		int64 nKey = keyValue(oValue);
+
+		return (nKey >= m_nLower) && ( (!m_bUpper) || (nKey < m_nUpper) );
+	}
+
+	//! Query if the partition may hold a key less than the value.
+	virtual bool ContainsLess(const CValue& oValue) const
+	{
+		return (oValue.m_bNull) || (m_nLower < keyValue(oValue));
+	}
+
+	//! Query if the partition may hold a key greater than the value.
+	virtual bool ContainsGreater(const CValue& oValue) const
+	{
+		return (oValue.m_bNull) || (!m_bUpper) || ((m_nUpper-1) > keyValue(oValue));
+	}
+
+private:
+	//
+	// Members.
+	//
+	int64	m_nLower;		//!< The lowest key.
+	bool	m_bUpper;		//!< Is there an upper bound?
+	int64	m_nUpper;		//!< The upper bound, if one.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The task used to query a single partition.
+
+class SelectTask : public CWorkerTask
+{
+public:
+	//! Default constructor.
+	SelectTask()
+		: m_pTable(nullptr), m_pWhere(nullptr), m_vRows()
+	{ }
+
+	//! Query the partition.
+	virtual void Run()
+	{
+		CResultSet oRS = m_pTable->Select(*m_pWhere);
+
+		m_vRows.reserve(oRS.Count());
+
+		for (size_t i = 0; i != oRS.Count(); ++i)
+			m_vRows.push_back(&oRS[i]);
+	}
+
+	//
+	// Members.
+	//
+	const CTable*		m_pTable;		//!< The partition.
+	const CWhere*		m_pWhere;		//!< The where clause.
+	std::vector<CRow*>	m_vRows;		//!< The matching rows.
+};
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor. The table is not partitioned until either PartitionByHash()
+//! or PartitionByRange() is called, after the columns have been added.
+
+CPartitionedTable::CPartitionedTable(const tchar* pszName, uint nFlags)
+	: m_strName(pszName)
+	, m_nFlags(nFlags)
+	, m_oSchema(pszName, nFlags)
+	, m_eScheme(HASH)
+	, m_nKeyColumn(Core::npos)
+	, m_vPartitions()
+	, m_vBounds()
+	, m_nNextId(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+CPartitionedTable::~CPartitionedTable()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a column to the table. All columns must be added before the table is
+//! partitioned.
+
+size_t CPartitionedTable::AddColumn(const tchar* pszName, COLTYPE eType, size_t nLength, uint nFlags)
+{
+	ASSERT(m_nKeyColumn == Core::npos);
+
+	return m_oSchema.AddColumn(pszName, eType, nLength, nFlags);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Split the rows across a fixed number of partitions by the hash of a column,
+//! which can be an integer or string column.
+
+void CPartitionedTable::PartitionByHash(size_t nColumn, size_t nPartitions)
+{
+	ASSERT(m_nKeyColumn == Core::npos);
+	ASSERT(nPartitions > 0);
+	ASSERT(!m_oSchema.Column(nColumn).Nullable());
+	ASSERT( (m_oSchema.Column(nColumn).StgType() == MDST_INT)
+		 || (m_oSchema.Column(nColumn).StgType() == MDST_INT64)
+		 || (m_oSchema.Column(nColumn).StgType() == MDST_STRING) );
+
+	m_eScheme    = HASH;
+	m_nKeyColumn = nColumn;
+
+	for (size_t i = 0; i != nPartitions; ++i)
+		m_vPartitions.push_back(CreatePartition());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Split the rows into partitions by ranges of an integer column, which
+//! includes the DATE and DATETIME columns. The partitions are then added with
+//! AddPartition().
+
+void CPartitionedTable::PartitionByRange(size_t nColumn)
+{
+	ASSERT(m_nKeyColumn == Core::npos);
+	ASSERT(!m_oSchema.Column(nColumn).Nullable());
+	ASSERT( (m_oSchema.Column(nColumn).StgType() == MDST_INT)
+		 || (m_oSchema.Column(nColumn).StgType() == MDST_INT64) );
+
+	m_eScheme    = RANGE;
+	m_nKeyColumn = nColumn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add the partition for the range of keys that starts at the lower bound. It
+//! holds the keys up to the lower bound of the next partition. Any rows of the
+//! previous partition which fall within the new range are moved into it.
+
+size_t CPartitionedTable::AddPartition(int64 nLowerBound)
+{
+	ASSERT(m_eScheme == RANGE);
+	ASSERT(m_nKeyColumn != Core::npos);
+	ASSERT(!std::binary_search(m_vBounds.begin(), m_vBounds.end(), nLowerBound));
+
+	size_t nPartition = std::upper_bound(m_vBounds.begin(), m_vBounds.end(), nLowerBound) - m_vBounds.begin();
+
+	m_vPartitions.insert(m_vPartitions.begin() + nPartition, CreatePartition());
+	m_vBounds.insert(m_vBounds.begin() + nPartition, nLowerBound);
+
+	// Split the previous range?
+	if (nPartition != 0)
+	{
+		CTable& oPrevious = Partition(nPartition-1);
+		CTable& oNew      = Partition(nPartition);
+
+		CResultSet oRS = oPrevious.SelectAll();
+
+		for (size_t i = 0; i != oRS.Count(); ++i)
+		{
+			CRow& oRow = oRS[i];
+
+			if (keyValue(oRow[m_nKeyColumn].ToValue()) < nLowerBound)
+				continue;
+
+			CRow& oCopy = oNew.CreateRow();
+
+			for (size_t c = 0; c != m_oSchema.ColumnCount(); ++c)
+				oCopy[c] = oRow[c];
+
+			oPrevious.DeleteRow(oRow);
+			oNew.InsertRow(oCopy);
+		}
+	}
+
+	return nPartition;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Drop a range partition along with all its rows. This releases the whole
+//! partition rather than deleting its rows one at a time, the keys it held
+//! then have no partition until it is added again.
+
+void CPartitionedTable::DropPartition(size_t nPartition)
+{
+	ASSERT(m_eScheme == RANGE);
+	ASSERT(nPartition < m_vPartitions.size());
+
+	m_vPartitions.erase(m_vPartitions.begin() + nPartition);
+	m_vBounds.erase(m_vBounds.begin() + nPartition);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the total number of rows.
+
+size_t CPartitionedTable::RowCount() const
+{
+	size_t nRows = 0;
+
+	for (size_t i = 0; i != m_vPartitions.size(); ++i)
+		nRows += m_vPartitions[i]->RowCount();
+
+	return nRows;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the heap memory used by all the partitions.
+
+CMemoryUsage CPartitionedTable::MemoryUsage() const
+{
+	CMemoryUsage oUsage;
+
+	for (size_t i = 0; i != m_vPartitions.size(); ++i)
+		oUsage += m_vPartitions[i]->MemoryUsage();
+
+	return oUsage;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the partition that holds the key, or npos if no range covers it.
+
+size_t CPartitionedTable::FindPartition(const CValue& oKey) const
+{
+	ASSERT(m_nKeyColumn != Core::npos);
+	ASSERT(oKey.m_bNull == false);
+
+	if (m_eScheme == HASH)
+	{
+		bool bIgnoreCase = !(m_oSchema.Column(m_nKeyColumn).Flags() & CColumn::COMPARE_CASE);
+
+		return hashKey(oKey, bIgnoreCase) % m_vPartitions.size();
+	}
+
+	int64 nKey = keyValue(oKey);
+
+	// Find the last range starting at or below the key.
+	size_t nPartition = std::upper_bound(m_vBounds.begin(), m_vBounds.end(), nKey) - m_vBounds.begin();
+
+	return (nPartition != 0) ? (nPartition-1) : Core::npos;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create a row in the partition for the key, with the key column set. The
+//! row must be inserted with InsertRow().
+
+CRow& CPartitionedTable::CreateRow(const CValue& oKey)
+{
+	size_t nPartition = FindPartition(oKey);
+
+	if (nPartition == Core::npos)
+		throw CMDBException(CMDBException::E_NO_PARTITION, Core::fmt(TXT("The table '%s' has no partition for the key"), m_strName.c_str()).c_str());
+
+	CRow&   oRow = Partition(nPartition).CreateRow();
+	CField& oKeyField = oRow[m_nKeyColumn];
+
+	switch (oKey.m_eType)
+	{
+		case MDST_INT:		oKeyField = oKey.m_iValue;		break;
+		case MDST_INT64:	oKeyField = oKey.m_i64Value;	break;
+		case MDST_STRING:	oKeyField = oKey.m_sValue;		break;
+
+		case MDST_NULL:
+		case MDST_DOUBLE:
+		case MDST_CHAR:
+		case MDST_BOOL:
+		case MDST_TIMESTAMP:
+		case MDST_POINTER:
+		default:			ASSERT_FALSE();					break;
+	}
+
+	return oRow;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Insert a row created with CreateRow(). The key must not have been changed.
+
+void CPartitionedTable::InsertRow(CRow& oRow)
+{
+	ASSERT(&oRow.Table() == &Partition(FindPartition(oRow[m_nKeyColumn].ToValue())));
+
+	oRow.Table().InsertRow(oRow);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Delete a row.
+
+void CPartitionedTable::DeleteRow(CRow& oRow)
+{
+	oRow.Table().DeleteRow(oRow);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Delete all rows, but keep the partitions.
+
+void CPartitionedTable::Truncate()
+{
+	for (size_t i = 0; i != m_vPartitions.size(); ++i)
+		m_vPartitions[i]->Truncate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Select the row with a unique value. Only the one partition is searched if
+//! the column is the key, otherwise each partition is searched in turn.
+
+CRow* CPartitionedTable::SelectRow(size_t nColumn, const CValue& oValue) const
+{
+	ASSERT(m_nKeyColumn != Core::npos);
+
+	if (nColumn == m_nKeyColumn)
+	{
+		size_t nPartition = FindPartition(oValue);
+
+		return (nPartition != Core::npos) ? Partition(nPartition).SelectRow(nColumn, oValue) : nullptr;
+	}
+
+	for (size_t i = 0; i != m_vPartitions.size(); ++i)
+	{
+		CRow* pRow = m_vPartitions[i]->SelectRow(nColumn, oValue);
+
+		if (pRow != nullptr)
+			return pRow;
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Select all the rows, in partition order.
+
+CResultSet CPartitionedTable::SelectAll() const
+{
+	CResultSet oRS(m_oSchema);
+
+	for (size_t i = 0; i != m_vPartitions.size(); ++i)
+	{
+		CResultSet oRows = m_vPartitions[i]->SelectAll();
+
+		for (size_t r = 0; r != oRows.Count(); ++r)
+			oRS.Add(oRows[r]);
+	}
+
+	return oRS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Select the rows which match the WHERE clause. The partitions that cannot
+//! hold a match are skipped and the rest are queried in parallel on the worker
+//! pool. The rows are returned in partition order.
+//! NB: The query must be safe to call from multiple threads.
+
+CResultSet CPartitionedTable::Select(const CWhere& oWhere) const
+{
+	Partitions vPartitions;
+
+	size_t nTasks = Prune(oWhere, vPartitions);
+
+	CResultSet oRS(m_oSchema);
+
+	if (nTasks == 0)
+		return oRS;
+
+	std::vector<SelectTask>   vTasks(nTasks);
+	std::vector<CWorkerTask*> vTaskPtrs(nTasks);
+
+	for (size_t i = 0; i != nTasks; ++i)
+	{
+		vTasks[i].m_pTable = &Partition(vPartitions[i]);
+		vTasks[i].m_pWhere = &oWhere;
+		vTaskPtrs[i]       = &vTasks[i];
+	}
+
+	// Not worth the hand off?
+	if ( (nTasks == 1) || (CWorkerPool::Default().ThreadCount() < 2) )
+	{
+		for (size_t i = 0; i != nTasks; ++i)
+			vTasks[i].Run();
+	}
+	else
+	{
+		CWorkerPool::Default().Execute(&vTaskPtrs[0], nTasks);
+	}
+
+	for (size_t i = 0; i != nTasks; ++i)
+	{
+		for (size_t r = 0; r != vTasks[i].m_vRows.size(); ++r)
+			oRS.Add(*vTasks[i].m_vRows[r]);
+	}
+
+	return oRS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the partitions which may hold rows matching the WHERE clause, in
+//! partition order. Returns the number found.
+
+size_t CPartitionedTable::Prune(const CWhere& oWhere, Partitions& vPartitions) const
+{
+	ASSERT(m_nKeyColumn != Core::npos);
+
+	vPartitions.clear();
+
+	for (size_t i = 0; i != m_vPartitions.size(); ++i)
+	{
+		bool bMayMatch = true;
+
+		if (m_eScheme == HASH)
+		{
+			bMayMatch = oWhere.MayMatch(m_nKeyColumn, HashKeys(*this, i));
+		}
+		else
+		{
+			bool  bUpper = (i+1 != m_vBounds.size());
+			int64 nUpper = (bUpper) ? m_vBounds[i+1] : 0;
+
+			bMayMatch = oWhere.MayMatch(m_nKeyColumn, RangeKeys(m_vBounds[i], bUpper, nUpper));
+		}
+
+		if (bMayMatch)
+			vPartitions.push_back(i);
+	}
+
+	return vPartitions.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create an empty partition with the same columns as the schema.
+
+CTable::Ptr CPartitionedTable::CreatePartition()
+{
+	CString     strName = Core::fmt(TXT("%s.%u"), m_strName.c_str(), static_cast<uint>(m_nNextId++)).c_str();
+	CTable::Ptr pTable(new CTable(strName, m_nFlags));
+
+	for (size_t i = 0; i != m_oSchema.ColumnCount(); ++i)
+	{
+		const CColumn& oColumn = m_oSchema.Column(i);
+
+		pTable->AddColumn(oColumn.Name(), oColumn.ColType(), oColumn.Length(), oColumn.Flags());
+	}
+
+	return pTable;
+}
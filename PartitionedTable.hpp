@@ -0,0 +1,229 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   PartitionedTable.hpp
+//! \brief  The CPartitionedTable class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_PARTITIONEDTABLE_HPP
+#define MDBL_PARTITIONEDTABLE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "Table.hpp"
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A table whose rows are split across a number of partitions by the value of
+//! a key column. Each partition is a CTable in its own right with its own rows
+//! and indexes, so scans, deletes and index maintenance only touch the part of
+//! the data they need to.
+//!
+//! The rows are either spread across a fixed number of partitions by a hash of
+//! the key, or kept in partitions which each hold a range of integer keys, such
+//! as the DATE of a trade. Range partitions are added as needed and a whole
+//! range can be dropped at once without deleting its rows one at a time.
+//!
+//! Queries are pruned to the partitions which may hold matching rows, see
+//! CWhere::MayMatch(), and the remaining partitions are scanned in parallel.
+//! The key column must be NOT NULL and it is unique columns only which are
+//! unique within each partition.
+
+class CPartitionedTable /*: private NotCopyable*/
+{
+public:
+	//! The partitioning schemes.
+	enum Scheme
+	{
+		HASH,		//!< A fixed number of partitions by the hash of the key.
+		RANGE,		//!< A partition for each range of integer keys.
+	};
+
+	//! A list of partition numbers.
+	typedef std::vector<size_t> Partitions;
+
+	//! Constructor.
+	CPartitionedTable(const tchar* pszName, uint nFlags = CTable::DEFAULTS);
+
+	//! Destructor.
+	~CPartitionedTable();
+
+	//
+	// Schema methods.
+	//
+
+	//! Add a column to the table.
+	size_t AddColumn(const tchar* pszName, COLTYPE eType, size_t nLength, uint nFlags = CColumn::DEFAULTS);
+
+	//! Split the rows across a fixed number of partitions by the hash of a column.
+	void PartitionByHash(size_t nColumn, size_t nPartitions);
+
+	//! Split the rows into partitions by ranges of a column.
+	void PartitionByRange(size_t nColumn);
+
+	//! Add the partition for the range of keys that starts at the lower bound.
+	size_t AddPartition(int64 nLowerBound);
+
+	//! Drop a range partition along with all its rows.
+	void DropPartition(size_t nPartition);
+
+	//
+	// Properties.
+	//
+
+	//! Get the name of the table.
+	const CString& Name() const;
+
+	//! Get the table which describes the columns.
+	const CTable& Schema() const;
+
+	//! Get the partitioning scheme.
+	Scheme PartitionScheme() const;
+
+	//! Get the partition key column.
+	size_t KeyColumn() const;
+
+	//! Get the number of partitions.
+	size_t PartitionCount() const;
+
+	//! Get a partition.
+	CTable& Partition(size_t nPartition) const;
+
+	//! Get the lower bound of a range partition.
+	int64 LowerBound(size_t nPartition) const;
+
+	//! Get the total number of rows.
+	size_t RowCount() const;
+
+	//! Get the heap memory used by all the partitions.
+	CMemoryUsage MemoryUsage() const;
+
+	//
+	// Row methods.
+	//
+
+	//! Find the partition that holds the key.
+	size_t FindPartition(const CValue& oKey) const;
+
+	//! Create a row in the partition for the key.
+	CRow& CreateRow(const CValue& oKey);
+
+	//! Insert a row created with CreateRow().
+	void InsertRow(CRow& oRow);
+
+	//! Delete a row.
+	void DeleteRow(CRow& oRow);
+
+	//! Delete all rows.
+	void Truncate();
+
+	//
+	// Query methods.
+	//
+
+	//! Select the row with a unique value.
+	CRow* SelectRow(size_t nColumn, const CValue& oValue) const;
+
+	//! Select all the rows.
+	CResultSet SelectAll() const;
+
+	//! Select the rows which match the WHERE clause.
+	CResultSet Select(const CWhere& oWhere) const;
+
+	//! Find the partitions which may hold rows matching the WHERE clause.
+	size_t Prune(const CWhere& oWhere, Partitions& vPartitions) const;
+
+private:
+	//! The partition tables.
+	typedef std::vector<CTable::Ptr> Tables;
+
+	//! The lower bounds of the range partitions.
+	typedef std::vector<int64> Bounds;
+
+	//
+	// Members.
+	//
+	CString		m_strName;		//!< The name.
+	uint		m_nFlags;		//!< The flags for each partition.
+	CTable		m_oSchema;		//!< The columns, which never holds any rows.
+	Scheme		m_eScheme;		//!< The partitioning scheme.
+	size_t		m_nKeyColumn;	//!< The partition key column.
+	Tables		m_vPartitions;	//!< The partitions, in bound order if RANGE.
+	Bounds		m_vBounds;		//!< The lower bound of each RANGE partition.
+	size_t		m_nNextId;		//!< The number used to name the next partition.
+
+	//
+	// Internal methods.
+	//
+
+	//! Create an empty partition.
+	CTable::Ptr CreatePartition();
+
+	// NotCopyable.
+	CPartitionedTable(const CPartitionedTable&);
+	CPartitionedTable& operator=(const CPartitionedTable&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the name of the table.
+
+inline const CString& CPartitionedTable::Name() const
+{
+	return m_strName;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the table which describes the columns.
+
+inline const CTable& CPartitionedTable::Schema() const
+{
+	return m_oSchema;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the partitioning scheme.
+
+inline CPartitionedTable::Scheme CPartitionedTable::PartitionScheme() const
+{
+	return m_eScheme;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the partition key column.
+
+inline size_t CPartitionedTable::KeyColumn() const
+{
+	return m_nKeyColumn;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of partitions.
+
+inline size_t CPartitionedTable::PartitionCount() const
+{
+	return m_vPartitions.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get a partition.
+
+inline CTable& CPartitionedTable::Partition(size_t nPartition) const
+{
+	ASSERT(nPartition < m_vPartitions.size());
+
+	return *m_vPartitions[nPartition].get();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the lower bound of a range partition.
+
+inline int64 CPartitionedTable::LowerBound(size_t nPartition) const
+{
+	ASSERT(m_eScheme == RANGE);
+	ASSERT(nPartition < m_vBounds.size());
+
+	return m_vBounds[nPartition];
+}
+
+#endif // MDBL_PARTITIONEDTABLE_HPP
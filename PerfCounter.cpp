@@ -0,0 +1,27 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   PerfCounter.cpp
+//! \brief  The CPerfCounter class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "PerfCounter.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of performance counter ticks per second. The frequency is
+//! fixed at boot and so is only queried once.
+
+int64 CPerfCounter::Frequency()
+{
+	static int64 s_nFrequency = 0;
+
+	if (s_nFrequency == 0)
+	{
+		LARGE_INTEGER oFrequency;
+
+		::QueryPerformanceFrequency(&oFrequency);
+
+		s_nFrequency = oFrequency.QuadPart;
+	}
+
+	return s_nFrequency;
+}
@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   PerfCounter.hpp
+//! \brief  The CPerfCounter class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_PERFCOUNTER_HPP
+#define MDBL_PERFCOUNTER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! The helpers for timing with the high resolution performance counter.
+
+class CPerfCounter
+{
+public:
+	//! Read the performance counter.
+	static int64 Now();
+
+	//! Convert a number of performance counter ticks to microseconds.
+	static uint64 Microseconds(int64 nTicks);
+
+private:
+	//! Get the number of performance counter ticks per second.
+	static int64 Frequency();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read the performance counter.
+
+inline int64 CPerfCounter::Now()
+{
+	LARGE_INTEGER oCounter;
+
+	::QueryPerformanceCounter(&oCounter);
+
+	return oCounter.QuadPart;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a number of performance counter ticks to microseconds.
+
+inline uint64 CPerfCounter::Microseconds(int64 nTicks)
+{
+	return static_cast<uint64>((nTicks * 1000000) / Frequency());
+}
+
+#endif // MDBL_PERFCOUNTER_HPP
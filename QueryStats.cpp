@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   QueryStats.cpp
+//! \brief  The CQueryStats and CTableStats class definitions.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "QueryStats.hpp"
+#include "PerfCounter.hpp"
+
+//! The allocation counter, if set.
+CQueryStats::AllocationCounter CQueryStats::s_pfnAllocationCounter = nullptr;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+CQueryStats::CQueryStats()
+	: m_nQueries(0)
+	, m_nRowsScanned(0)
+	, m_nRowsMatched(0)
+	, m_nIndexProbes(0)
+	, m_nComparisons(0)
+	, m_nAllocations(0)
+	, m_nElapsed(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Reset the counters.
+
+void CQueryStats::Reset()
+{
+	*this = CQueryStats();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add the counters of another set of queries.
+
+CQueryStats& CQueryStats::operator+=(const CQueryStats& oRHS)
+{
+	m_nQueries     += oRHS.m_nQueries;
+	m_nRowsScanned += oRHS.m_nRowsScanned;
+	m_nRowsMatched += oRHS.m_nRowsMatched;
+	m_nIndexProbes += oRHS.m_nIndexProbes;
+	m_nComparisons += oRHS.m_nComparisons;
+	m_nAllocations += oRHS.m_nAllocations;
+	m_nElapsed     += oRHS.m_nElapsed;
+
+	return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor. This starts the timer.
+
+CQueryStats::Timer::Timer(CQueryStats& oStats)
+	: m_oStats(oStats)
+	, m_nStart(CPerfCounter::Now())
+	, m_nAllocs((s_pfnAllocationCounter != nullptr) ? s_pfnAllocationCounter() : 0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. This adds the elapsed time, and allocations, to the counters.
+
+CQueryStats::Timer::~Timer()
+{
+	m_oStats.m_nElapsed += CPerfCounter::Microseconds(CPerfCounter::Now() - m_nStart);
+
+	if (s_pfnAllocationCounter != nullptr)
+		m_oStats.m_nAllocations += s_pfnAllocationCounter() - m_nAllocs;
+
+	++m_oStats.m_nQueries;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+CTableStats::CTableStats()
+	: m_oTotals()
+{
+	::InitializeCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+CTableStats::~CTableStats()
+{
+	::DeleteCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add the counters of a query.
+
+void CTableStats::Add(const CQueryStats& oStats)
+{
+	::EnterCriticalSection(&m_oLock);
+
+	m_oTotals += oStats;
+
+	::LeaveCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get a copy of the running totals.
+
+CQueryStats CTableStats::Totals() const
+{
+	::EnterCriticalSection(&m_oLock);
+
+	CQueryStats oTotals = m_oTotals;
+
+	::LeaveCriticalSection(&m_oLock);
+
+	return oTotals;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Reset the running totals.
+
+void CTableStats::Reset()
+{
+	::EnterCriticalSection(&m_oLock);
+
+	m_oTotals.Reset();
+
+	::LeaveCriticalSection(&m_oLock);
+}
@@ -0,0 +1,135 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   QueryStats.hpp
+//! \brief  The CQueryStats and CTableStats class declarations.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_QUERYSTATS_HPP
+#define MDBL_QUERYSTATS_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! The counters for the execution of one or more queries, see
+//! CTable::Select() and CMDB::Select().
+
+class CQueryStats
+{
+public:
+	//! The function used to count the heap allocations made so far.
+	typedef size_t (*AllocationCounter)();
+
+	//! Default constructor.
+	CQueryStats();
+
+	//! Reset the counters.
+	void Reset();
+
+	//! Add the counters of another set of queries.
+	CQueryStats& operator+=(const CQueryStats& oRHS);
+
+	//! Get the function used to count heap allocations.
+	static AllocationCounter AllocationCount();
+
+	//! Set the function used to count heap allocations.
+	static void AllocationCount(AllocationCounter pfnCounter);
+
+	////////////////////////////////////////////////////////////////////////////
+	//! The helper used to time a query and count its allocations. The query is
+	//! counted when it goes out of scope.
+
+	class Timer /*: private NotCopyable*/
+	{
+	public:
+		//! Constructor.
+		Timer(CQueryStats& oStats);
+
+		//! Destructor.
+		~Timer();
+
+	private:
+		//
+		// Members.
+		//
+		CQueryStats&	m_oStats;		//!< The counters to update.
+		int64			m_nStart;		//!< The performance counter at the start.
+		size_t			m_nAllocs;		//!< The allocation count at the start.
+
+		// NotCopyable.
+		Timer(const Timer&);
+		Timer& operator=(const Timer&);
+	};
+
+	//
+	// Members.
+	//
+	size_t	m_nQueries;			//!< The number of queries.
+	size_t	m_nRowsScanned;		//!< The rows the WHERE clause was applied to.
+	size_t	m_nRowsMatched;		//!< The rows returned.
+	size_t	m_nIndexProbes;		//!< The index lookups.
+	size_t	m_nComparisons;		//!< The column comparisons made.
+	size_t	m_nAllocations;		//!< The heap allocations, if counted.
+	uint64	m_nElapsed;			//!< The elapsed time in microseconds.
+
+private:
+	//
+	// Class members.
+	//
+	static AllocationCounter s_pfnAllocationCounter;	//!< The allocation counter, if set.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The running totals of the queries made on a table. This can be updated by
+//! queries running on multiple threads.
+
+class CTableStats /*: private NotCopyable*/
+{
+public:
+	//! Default constructor.
+	CTableStats();
+
+	//! Destructor.
+	~CTableStats();
+
+	//! Add the counters of a query.
+	void Add(const CQueryStats& oStats);
+
+	//! Get a copy of the running totals.
+	CQueryStats Totals() const;
+
+	//! Reset the running totals.
+	void Reset();
+
+private:
+	//
+	// Members.
+	//
+	CQueryStats					m_oTotals;	//!< The running totals.
+	mutable CRITICAL_SECTION	m_oLock;	//!< The totals lock.
+
+	// NotCopyable.
+	CTableStats(const CTableStats&);
+	CTableStats& operator=(const CTableStats&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the function used to count heap allocations.
+
+inline CQueryStats::AllocationCounter CQueryStats::AllocationCount()
+{
+	return s_pfnAllocationCounter;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the function used to count heap allocations. The library does not
+//! replace the heap, so it is up to the application to provide one if it
+//! wants the allocations counted.
+
+inline void CQueryStats::AllocationCount(AllocationCounter pfnCounter)
+{
+	s_pfnAllocationCounter = pfnCounter;
+}
+
+#endif // MDBL_QUERYSTATS_HPP
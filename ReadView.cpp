@@ -0,0 +1,272 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ReadView.cpp
+//! \brief  The CReadView class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "ReadView.hpp"
+#include "MDB.hpp"
+#include "VersionStore.hpp"
+#include "ResultSet.hpp"
+#include "JoinedSet.hpp"
+#include "Join.hpp"
+#include "Where.hpp"
+#include "UniqIndex.hpp"
+#include <malloc.h>
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor. The view sees the latest version made visible by the writers.
+
+CReadView::CReadView(CMDB& oMDB)
+	: m_oMDB(oMDB)
+	, m_oStore(oMDB.m_oVersions)
+	, m_nVersion(m_oStore.OpenView())
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. Releases the old versions.
+
+CReadView::~CReadView()
+{
+	m_oStore.CloseView(m_nVersion);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Select all the rows of a table.
+
+CResultSet CReadView::SelectAll(const CTable& oTable) const
+{
+	Rows       vRows;
+	CResultSet oRS(oTable);
+
+	VisibleRows(oTable, vRows);
+
+	for (size_t i = 0; i != vRows.size(); ++i)
+		oRS.Add(*vRows[i]);
+
+	return oRS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Select the rows of a table which match the WHERE clause. If the query can
+//! use an index the current rows it finds are mapped to their visible versions,
+//! along with the old versions of the rows updated or deleted since the view
+//! was opened, as their indexed values may differ. Otherwise the visible rows
+//! are scanned.
+
+CResultSet CReadView::Select(const CTable& oTable, const CWhere& oWhere) const
+{
+	oTable.Load();
+
+	CResultSet oIndexed(oTable);
+	Rows       vRows;
+	bool       bIndexed;
+
+	{
+		CReadWriteLock::ReadGuard oGuard(oTable.m_oLock, oTable.Concurrent());
+
+		// Can the query use an index instead?
+		bIndexed = oWhere.SelectIndexed(oTable, oIndexed);
+
+		for (size_t i = 0; i != oIndexed.Count(); ++i)
+		{
+			CRow* pRow = VisibleRow(oIndexed[i]);
+
+			if (pRow != nullptr)
+				vRows.push_back(pRow);
+		}
+	}
+
+	if (!bIndexed)
+		return SelectAll(oTable).Select(oWhere);
+
+	m_oStore.FindUpdated(oTable, m_nVersion, vRows);
+	m_oStore.FindDeleted(oTable, m_nVersion, vRows);
+
+	// An updated row may have been found through the index as well.
+	std::sort(vRows.begin(), vRows.end());
+	vRows.erase(std::unique(vRows.begin(), vRows.end()), vRows.end());
+
+	CResultSet oRS(oTable);
+
+	for (size_t i = 0; i != vRows.size(); ++i)
+	{
+		if (oWhere.Matches(*vRows[i]))
+			oRS.Add(*vRows[i]);
+	}
+
+	return oRS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Select the row with a unique value. The current row is found with the index
+//! and otherwise the deleted rows are searched, as the row with the value may
+//! have been deleted since the view was opened.
+
+CRow* CReadView::SelectRow(const CTable& oTable, size_t nColumn, const CValue& oValue) const
+{
+	ASSERT(oValue.m_bNull == false);
+	ASSERT(oTable.Column(nColumn).Unique());
+	ASSERT(oTable.Column(nColumn).Index() != nullptr);
+
+	oTable.Load();
+
+	CRow* pRow = nullptr;
+
+	{
+		CReadWriteLock::ReadGuard oGuard(oTable.m_oLock, oTable.Concurrent());
+
+		const CUniqIndex* pIndex = static_cast<const CUniqIndex*>(oTable.Column(nColumn).Index());
+		const CRow*       pFound = pIndex->FindRow(oValue);
+
+		if (pFound != nullptr)
+			pRow = VisibleRow(*pFound);
+	}
+
+	// Deleted since the view was opened?
+	if (pRow == nullptr)
+	{
+		Rows vDeleted;
+
+		m_oStore.FindDeleted(oTable, m_nVersion, vDeleted);
+
+		for (size_t i = 0; (i != vDeleted.size()) && (pRow == nullptr); ++i)
+		{
+			if ((*vDeleted[i])[nColumn] == oValue)
+				pRow = vDeleted[i];
+		}
+	}
+
+	return pRow;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Execute a query involving a join across tables, see CMDB::Select().
+
+CJoinedSet CReadView::Select(const CJoin& oQuery) const
+{
+	ASSERT(oQuery.Count() > 1);
+
+	size_t nJoins = oQuery.Count();
+
+	// Create the table list.
+	CTable** apTables = static_cast<CTable**>(_alloca(sizeof(CTable*) * nJoins));
+
+	for (size_t i = 0; i != nJoins; ++i)
+		apTables[i] = &m_oMDB.Table(oQuery[i].m_nTable);
+
+	// Create the joined result set.
+	CJoinedSet oJS(nJoins, apTables);
+
+	// Get the rows to join on, once per table.
+	JoinRows vJoinRows(nJoins);
+
+	for (size_t i = 0; i != nJoins; ++i)
+		VisibleRows(*apTables[i], vJoinRows[i]);
+
+	// Run the query.
+	DoJoin(oQuery, vJoinRows, 0, nullptr, oJS);
+
+	return oJS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the rows of a table visible to the view. These are found afresh for each
+//! query as the current rows may have been deleted since the last one.
+
+void CReadView::VisibleRows(const CTable& oTable, Rows& vRows) const
+{
+	oTable.Load();
+
+	{
+		CReadWriteLock::ReadGuard oGuard(oTable.m_oLock, oTable.Concurrent());
+
+		size_t nRows = oTable.m_vRows.Count();
+
+		vRows.reserve(nRows);
+
+		for (size_t r = 0; r != nRows; ++r)
+		{
+			CRow* pRow = VisibleRow(oTable.m_vRows[r]);
+
+			if (pRow != nullptr)
+				vRows.push_back(pRow);
+		}
+	}
+
+	// Add the ones deleted since the view was opened.
+	m_oStore.FindDeleted(oTable, m_nVersion, vRows);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the version of a current row visible to the view, or NULL if it was
+//! inserted after the view was opened. A row unchanged since the view was
+//! opened is the version visible to it. The table lock must be held.
+
+CRow* CReadView::VisibleRow(const CRow& oRow) const
+{
+	// Changed since the view was opened?
+	if (oRow.Version() > m_nVersion)
+		return const_cast<CRow*>(m_oStore.FindRow(oRow, m_nVersion));
+
+	return const_cast<CRow*>(&oRow);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Perform a single join, see CMDB::DoJoin().
+
+size_t CReadView::DoJoin(const CJoin& oQuery, const JoinRows& vJoinRows, size_t nJoin, const CRow* pLHSRow, CJoinedSet& oJS) const
+{
+	// Get the rows to join on.
+	const Rows& vRHSRows = vJoinRows[nJoin];
+
+	// Get the columns to join on.
+	size_t nLHSColumn = oQuery[nJoin].m_nLHSColumn;
+	size_t nRHSColumn = oQuery[nJoin].m_nRHSColumn;
+
+	size_t nMatches = 0;
+
+	// For all rows in the table.
+	for (size_t r = 0; r != vRHSRows.size(); ++r)
+	{
+		CRow& oRHSRow = *vRHSRows[r];
+
+		// Scanning first table OR this row matches?
+		if ( (nJoin == 0) || (oRHSRow[nRHSColumn] == (*pLHSRow)[nLHSColumn]) )
+		{
+			size_t nRows = 1;
+
+			// More joins to process?
+			if (nJoin < (oQuery.Count()-1))
+				nRows = DoJoin(oQuery, vJoinRows, nJoin+1, &oRHSRow, oJS);
+
+			// Join succesful?
+			if (nRows > 0)
+			{
+				CResultSet& oRS = oJS[nJoin];
+
+				// Add this row 'nRows' times.
+				for (size_t i = 0; i < nRows; ++i)
+					oRS.Add(oRHSRow);
+
+				nMatches += nRows;
+			}
+			// Join failed, but OUTER join requested?
+			else if (oQuery[nJoin+1].m_eJoinType == OUTER_JOIN)
+			{
+				// Add this row.
+				oJS[nJoin].Add(oRHSRow);
+
+				// Add NULL row to all joins from here down.
+				for (size_t i = nJoin+1; i < oQuery.Count(); ++i)
+					oJS[i].Add(m_oMDB.Table(oQuery[i].m_nTable).NullRow());
+
+				++nMatches;
+			}
+		}
+	}
+
+	return nMatches;
+}
@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ReadView.hpp
+//! \brief  The CReadView class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_READVIEW_HPP
+#define MDBL_READVIEW_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "FwdDecls.hpp"
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A consistent, read-only view of a database as of the moment it was opened,
+//! see CVersionStore. Queries made through the view see neither the changes
+//! made after it was opened, nor any update still in progress, whilst the
+//! writers carry on without waiting for it.
+//!
+//! The rows returned are the current rows, when they have not changed since
+//! the view was opened, or the old versions kept by the store. Nothing is
+//! copied by the view, but it means a current row returned by a query shows a
+//! change made to it afterwards and must not be used once it is deleted. So
+//! the results should be used before the rows are changed again and a query
+//! repeated to see the view's versions once more. The tables must be
+//! CONCURRENT if written to by other threads and a view must only be used by
+//! a single thread.
+
+class CReadView /*: private NotCopyable*/
+{
+public:
+	//! Constructor.
+	CReadView(CMDB& oMDB);
+
+	//! Destructor.
+	~CReadView();
+
+	//
+	// Properties.
+	//
+
+	//! Get the version the view sees.
+	uint64 Version() const;
+
+	//
+	// Query methods.
+	//
+
+	//! Select all the rows of a table.
+	CResultSet SelectAll(const CTable& oTable) const;
+
+	//! Select the rows of a table which match the WHERE clause.
+	CResultSet Select(const CTable& oTable, const CWhere& oWhere) const;
+
+	//! Select the row with a unique value.
+	CRow* SelectRow(const CTable& oTable, size_t nColumn, const CValue& oValue) const;
+
+	//! Execute a query involving a join across tables.
+	CJoinedSet Select(const CJoin& oQuery) const;
+
+private:
+	//! The rows of a table visible to the view.
+	typedef std::vector<CRow*> Rows;
+
+	//! The visible rows of each table in a join.
+	typedef std::vector<Rows> JoinRows;
+
+	//
+	// Members.
+	//
+	CMDB&				m_oMDB;			//!< The database.
+	CVersionStore&		m_oStore;		//!< The version store.
+	uint64				m_nVersion;		//!< The version seen.
+
+	//
+	// Internal methods.
+	//
+
+	//! Get the visible rows of a table.
+	void VisibleRows(const CTable& oTable, Rows& vRows) const;
+
+	//! Get the version of a current row visible to the view.
+	CRow* VisibleRow(const CRow& oRow) const;
+
+	//! Perform a single join.
+	size_t DoJoin(const CJoin& oQuery, const JoinRows& vJoinRows, size_t nJoin, const CRow* pLHSRow, CJoinedSet& oJS) const;
+
+	// NotCopyable.
+	CReadView(const CReadView&);
+	CReadView& operator=(const CReadView&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the version the view sees.
+
+inline uint64 CReadView::Version() const
+{
+	return m_nVersion;
+}
+
+#endif // MDBL_READVIEW_HPP
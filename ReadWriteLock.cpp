@@ -0,0 +1,82 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ReadWriteLock.cpp
+//! \brief  The CReadWriteLock class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "ReadWriteLock.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+CReadWriteLock::CReadWriteLock()
+	: m_nOwner(0)
+	, m_nDepth(0)
+{
+	::InitializeSRWLock(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+CReadWriteLock::~CReadWriteLock()
+{
+	ASSERT(m_nDepth == 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Acquire the lock shared. If the calling thread already holds the lock
+//! exclusively nothing is acquired and false is returned, so that the caller
+//! knows not to release it.
+
+bool CReadWriteLock::AcquireShared()
+{
+	if (OwnedExclusive())
+		return false;
+
+	::AcquireSRWLockShared(&m_oLock);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Release the shared lock.
+
+void CReadWriteLock::ReleaseShared()
+{
+	::ReleaseSRWLockShared(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Acquire the lock exclusively. The owner can acquire it again and must then
+//! release it the same number of times.
+
+void CReadWriteLock::AcquireExclusive()
+{
+	if (OwnedExclusive())
+	{
+		++m_nDepth;
+		return;
+	}
+
+	::AcquireSRWLockExclusive(&m_oLock);
+
+	m_nOwner = ::GetCurrentThreadId();
+	m_nDepth = 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Release the exclusive lock.
+
+void CReadWriteLock::ReleaseExclusive()
+{
+	ASSERT(OwnedExclusive());
+	ASSERT(m_nDepth != 0);
+
+	if (--m_nDepth != 0)
+		return;
+
+	m_nOwner = 0;
+
+	::ReleaseSRWLockExclusive(&m_oLock);
+}
@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ReadWriteLock.hpp
+//! \brief  The CReadWriteLock class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_READWRITELOCK_HPP
+#define MDBL_READWRITELOCK_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+// The slim reader/writer lock requires Windows Vista or later.
+#if defined(_WIN32_WINNT) && (_WIN32_WINNT < 0x0600)
+#error CReadWriteLock requires _WIN32_WINNT to be 0x0600 (Windows Vista) or later
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! A reader/writer lock built on a slim reader/writer lock. Any number of
+//! threads can hold the lock shared, or one thread can hold it exclusively.
+//! The exclusive owner can re-acquire the lock either way, so that a writer
+//! can call back into the object it is modifying, e.g. from a trigger. A shared
+//! lock cannot be re-acquired by the same thread as a waiting writer would
+//! deadlock it. The slim reader/writer lock is only available from Windows
+//! Vista onwards, so _WIN32_WINNT must be at least 0x0600.
+
+class CReadWriteLock /*: private NotCopyable*/
+{
+public:
+	//! Default constructor.
+	CReadWriteLock();
+
+	//! Destructor.
+	~CReadWriteLock();
+
+	//
+	// Methods.
+	//
+
+	//! Acquire the lock shared, unless already held exclusively.
+	bool AcquireShared();
+
+	//! Release the shared lock.
+	void ReleaseShared();
+
+	//! Acquire the lock exclusively.
+	void AcquireExclusive();
+
+	//! Release the exclusive lock.
+	void ReleaseExclusive();
+
+	//! Query if the calling thread holds the lock exclusively.
+	bool OwnedExclusive() const;
+
+	//
+	// Types.
+	//
+
+	class ReadGuard;
+	class WriteGuard;
+
+private:
+	//
+	// Members.
+	//
+	SRWLOCK			m_oLock;		//!< The underlying lock.
+	volatile DWORD	m_nOwner;		//!< The exclusive owner, if one.
+	size_t			m_nDepth;		//!< The exclusive recursion depth.
+
+	// NotCopyable.
+	CReadWriteLock(const CReadWriteLock&);
+	CReadWriteLock& operator=(const CReadWriteLock&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Holds a CReadWriteLock shared for the lifetime of the guard, if enabled.
+
+class CReadWriteLock::ReadGuard /*: private NotCopyable*/
+{
+public:
+	//! Constructor.
+	ReadGuard(CReadWriteLock& oLock, bool bEnabled);
+
+	//! Destructor.
+	~ReadGuard();
+
+private:
+	CReadWriteLock&	m_oLock;		//!< The lock.
+	bool			m_bLocked;		//!< Acquired by this guard?
+
+	// NotCopyable.
+	ReadGuard(const ReadGuard&);
+	ReadGuard& operator=(const ReadGuard&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Holds a CReadWriteLock exclusively for the lifetime of the guard, if enabled.
+
+class CReadWriteLock::WriteGuard /*: private NotCopyable*/
+{
+public:
+	//! Constructor.
+	WriteGuard(CReadWriteLock& oLock, bool bEnabled);
+
+	//! Destructor.
+	~WriteGuard();
+
+private:
+	CReadWriteLock&	m_oLock;		//!< The lock.
+	bool			m_bLocked;		//!< Acquired by this guard?
+
+	// NotCopyable.
+	WriteGuard(const WriteGuard&);
+	WriteGuard& operator=(const WriteGuard&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the calling thread holds the lock exclusively. Only the owner can
+//! have set the owner to its own thread ID so the unguarded read is safe.
+
+inline bool CReadWriteLock::OwnedExclusive() const
+{
+	return (m_nOwner == ::GetCurrentThreadId());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+inline CReadWriteLock::ReadGuard::ReadGuard(CReadWriteLock& oLock, bool bEnabled)
+	: m_oLock(oLock)
+	, m_bLocked(bEnabled && oLock.AcquireShared())
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+inline CReadWriteLock::ReadGuard::~ReadGuard()
+{
+	if (m_bLocked)
+		m_oLock.ReleaseShared();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+inline CReadWriteLock::WriteGuard::WriteGuard(CReadWriteLock& oLock, bool bEnabled)
+	: m_oLock(oLock)
+	, m_bLocked(bEnabled)
+{
+	if (m_bLocked)
+		m_oLock.AcquireExclusive();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+inline CReadWriteLock::WriteGuard::~WriteGuard()
+{
+	if (m_bLocked)
+		m_oLock.ReleaseExclusive();
+}
+
+#endif // MDBL_READWRITELOCK_HPP
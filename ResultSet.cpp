@@ -15,10 +15,32 @@
 #include "ValueSet.hpp"
 #include "GroupSet.hpp"
 #include "Where.hpp"
+#include "RowCursor.hpp"
+#include "WorkerPool.hpp"
+#include "Trace.hpp"
 #include <WCL/IInputStream.hpp>
 #include <WCL/IOutputStream.hpp>
 #include <malloc.h>
 
+// The minimum number of rows before a scan is run in parallel.
+size_t CResultSet::s_nParallelThreshold = 100000;
+
+// The minimum number of rows before a sort is run in parallel.
+size_t CResultSet::s_nSortThreshold = 50000;
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the name of the table the rows belong to, if known, for tracing.
+
+const tchar* tableName(const CTable* pTable)
+{
+	return (pTable != nullptr) ? pTable->Name().c_str() : nullptr;
+}
+
+}
+
 /******************************************************************************
 ** Method:		Constructor.
 **
@@ -117,6 +139,49 @@ CResultSet::CResultSet(const CTable& oTable, const CRowSet& oRowSet)
 		Collection::push_back(&oRowSet[i]);
 }
 
+/******************************************************************************
+** Method:		Constructor.
+**
+** Description:	Constructs the result set from the rows in the RowSet that
+**				match the query.
+**
+** Parameters:	oTable		The table the rows belong to.
+**				oRowSet		The RowSet to scan.
+**				oQuery		The where clause.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CResultSet::CResultSet(const CTable& oTable, const CRowSet& oRowSet, const CWhere& oQuery)
+	: m_pTable(&oTable)
+{
+	AddMatches(oRowSet, oQuery);
+}
+
+/******************************************************************************
+** Method:		Constructor.
+**
+** Description:	Constructs the result set from the rows in the RowSet that
+**				match the query, counting the comparisons made, see
+**				CWhere::Evaluate().
+**
+** Parameters:	oRowSet			The RowSet to scan.
+**				oQuery			The where clause.
+**				nComparisons	The comparison count to add to.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CResultSet::CResultSet(const CTable& oTable, const CRowSet& oRowSet, const CWhere& oQuery, size_t& nComparisons)
+	: m_pTable(&oTable)
+{
+	AddMatches(oRowSet, oQuery, &nComparisons);
+}
+
 /******************************************************************************
 ** Method:		Destructor.
 **
@@ -164,6 +229,75 @@ CResultSet& CResultSet::operator=(const CResultSet& oRHS)
 	return *this;
 }
 
+#ifdef MDBL_HAS_RVALUE_REFS
+
+/******************************************************************************
+** Method:		Move constructor.
+**
+** Description:	Takes ownership of the rows of the existing result set, which
+**				is left empty.
+**
+** Parameters:	oResultSet	The result set to move from.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CResultSet::CResultSet(CResultSet&& oResultSet)
+	: Collection()
+	, m_pTable(oResultSet.m_pTable)
+{
+	Collection::swap(oResultSet);
+}
+
+/******************************************************************************
+** Method:		Move assignment operator.
+**
+** Description:	Takes ownership of the rows of the result set, which is left
+**				empty.
+**
+** Parameters:	oRHS	The object to move from.
+**
+** Returns:		itself.
+**
+*******************************************************************************
+*/
+
+CResultSet& CResultSet::operator=(CResultSet&& oRHS)
+{
+	ASSERT(this != &oRHS);
+
+	m_pTable = oRHS.m_pTable;
+
+	Collection::clear();
+	Collection::swap(oRHS);
+
+	return *this;
+}
+
+#endif
+
+/******************************************************************************
+** Method:		Swap()
+**
+** Description:	Exchanges the contents of the two result sets without copying
+**				the rows.
+**
+** Parameters:	oRHS	The other result set.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CResultSet::Swap(CResultSet& oRHS)
+{
+	std::swap(m_pTable, oRHS.m_pTable);
+
+	Collection::swap(oRHS);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! The comparison functor used to compare two rows when sorting.
 
@@ -209,10 +343,8 @@ int Comparator::compare(const CRow* row1, const CRow* row2)
 /******************************************************************************
 ** Method:		OrderBy()
 **
-** Description:	Sort the result by the columns specified.
-**				NB: This uses qsort() which needs a C style callback function.
-**					Consequently we need to use a static member to hold the
-**					sorting definition so this method is not thread safe.
+** Description:	Sort the result by the columns specified. Large result sets
+**				are sorted in parallel, see ParallelSortThreshold().
 **
 ** Parameters:	oColumns	The columns and orders to sort by.
 **
@@ -223,7 +355,155 @@ int Comparator::compare(const CRow* row1, const CRow* row2)
 
 void CResultSet::OrderBy(const CSortColumns& oColumns)
 {
-	std::sort(begin(), end(), Comparator(oColumns));
+	CTraceScope oTrace(CTraceSink::ORDER_BY, tableName(m_pTable), Count());
+
+	if ( (Count() >= s_nSortThreshold) && (CWorkerPool::Default().ThreadCount() > 1) )
+		ParallelSort(oColumns);
+	else
+		std::sort(begin(), end(), Comparator(oColumns));
+}
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The task used to sort a contiguous range of rows.
+
+class SortTask : public CWorkerTask
+{
+public:
+	//! Default constructor.
+	SortTask()
+		: m_ppFirst(nullptr), m_ppLast(nullptr), m_pColumns(nullptr)
+	{ }
+
+	//! Sort the range.
+	virtual void Run()
+	{
+		std::sort(m_ppFirst, m_ppLast, Comparator(*m_pColumns));
+	}
+
+	//
+	// Members.
+	//
+	CRow**				m_ppFirst;		//!< The first row in the range.
+	CRow**				m_ppLast;		//!< One past the last row in the range.
+	const CSortColumns*	m_pColumns;		//!< The sort order.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The task used to merge two adjacent sorted ranges into another buffer.
+
+class MergeTask : public CWorkerTask
+{
+public:
+	//! Default constructor.
+	MergeTask()
+		: m_ppFirst(nullptr), m_ppMiddle(nullptr), m_ppLast(nullptr), m_ppOutput(nullptr), m_pColumns(nullptr)
+	{ }
+
+	//! Merge the ranges.
+	virtual void Run()
+	{
+		std::merge(m_ppFirst, m_ppMiddle, m_ppMiddle, m_ppLast, m_ppOutput, Comparator(*m_pColumns));
+	}
+
+	//
+	// Members.
+	//
+	CRow**				m_ppFirst;		//!< The start of the 1st range.
+	CRow**				m_ppMiddle;		//!< The end of the 1st and start of the 2nd range.
+	CRow**				m_ppLast;		//!< The end of the 2nd range.
+	CRow**				m_ppOutput;		//!< The start of the output range.
+	const CSortColumns*	m_pColumns;		//!< The sort order.
+};
+
+}
+
+/******************************************************************************
+** Method:		ParallelSort()
+**
+** Description:	Sort the result set using a parallel merge sort. The rows are
+**				split into a power of two number of chunks which are sorted
+**				concurrently and then merged pairwise, also concurrently, into
+**				a scratch buffer until a single run remains. The comparison is
+**				the same one used by the serial sort so the ordering of
+**				directions and NULLs is identical.
+**
+** Parameters:	oColumns	The columns and orders to sort by.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CResultSet::ParallelSort(const CSortColumns& oColumns)
+{
+	CWorkerPool& oPool   = CWorkerPool::Default();
+	size_t       nRows   = Count();
+	size_t       nChunks = 1;
+
+	// Nothing to sort?
+	if (nRows < 2)
+		return;
+
+	// Use a power of two chunks to keep the merge tree balanced.
+	while ( (nChunks < oPool.ThreadCount()) && ((nChunks * 2) <= nRows) )
+		nChunks *= 2;
+
+	std::vector<size_t> vBounds(nChunks+1);
+
+	for (size_t i = 0; i <= nChunks; ++i)
+		vBounds[i] = (nRows * i) / nChunks;
+
+	std::vector<CWorkerTask*> vTaskPtrs(nChunks);
+
+	// Sort the chunks.
+	{
+		std::vector<SortTask> vTasks(nChunks);
+
+		for (size_t i = 0; i != nChunks; ++i)
+		{
+			vTasks[i].m_ppFirst  = &Collection::front() + vBounds[i];
+			vTasks[i].m_ppLast   = &Collection::front() + vBounds[i+1];
+			vTasks[i].m_pColumns = &oColumns;
+			vTaskPtrs[i]         = &vTasks[i];
+		}
+
+		oPool.Execute(&vTaskPtrs[0], nChunks);
+	}
+
+	Collection vScratch(nRows);
+
+	CRow** ppInput  = &Collection::front();
+	CRow** ppOutput = &vScratch.front();
+
+	// Merge adjacent runs until only one is left.
+	for (size_t nRun = 1; nRun < nChunks; nRun *= 2)
+	{
+		size_t                 nMerges = nChunks / (nRun * 2);
+		std::vector<MergeTask> vTasks(nMerges);
+
+		for (size_t i = 0; i != nMerges; ++i)
+		{
+			size_t nFirst = i * nRun * 2;
+
+			vTasks[i].m_ppFirst  = ppInput  + vBounds[nFirst];
+			vTasks[i].m_ppMiddle = ppInput  + vBounds[nFirst + nRun];
+			vTasks[i].m_ppLast   = ppInput  + vBounds[nFirst + nRun * 2];
+			vTasks[i].m_ppOutput = ppOutput + vBounds[nFirst];
+			vTasks[i].m_pColumns = &oColumns;
+			vTaskPtrs[i]         = &vTasks[i];
+		}
+
+		oPool.Execute(&vTaskPtrs[0], nMerges);
+
+		std::swap(ppInput, ppOutput);
+	}
+
+	// Result ended up in the scratch buffer?
+	if (ppInput != &Collection::front())
+		Collection::swap(vScratch);
 }
 
 /******************************************************************************
@@ -371,6 +651,8 @@ CValueSet CResultSet::Distinct(size_t nColumn) const
 
 CGroupSet CResultSet::GroupBy(size_t nColumn) const
 {
+	CTraceScope oTrace(CTraceSink::GROUP_BY, tableName(m_pTable));
+
 	CGroupSet oGS;
 
 	// Simple set?
@@ -379,6 +661,8 @@ CGroupSet CResultSet::GroupBy(size_t nColumn) const
 		if (Count() == 1)
 			oGS.Add(*this);
 
+		oTrace.Size(oGS.Count());
+
 		return oGS;
 	}
 
@@ -387,28 +671,25 @@ CGroupSet CResultSet::GroupBy(size_t nColumn) const
 	// Sort by the column.
 	oRS.OrderBy(nColumn, CSortColumns::ASC);
 
-	// Create a set for the group.
-	CResultSet oGroup(*m_pTable);
-
-	// Start the first group.
-	oGroup.Add(oRS[0]);
+	size_t nFirst = 0;
 
 	// For all subsequent rows
-	for (size_t i = 1; i < oRS.Count(); ++i)
+	for (size_t i = 1; i <= oRS.Count(); ++i)
 	{
-		// Start of new group?
-		if (oRS[i][nColumn] != oGroup[0][nColumn])
+		// End of the current group?
+		if ( (i == oRS.Count()) || (oRS[i][nColumn] != oRS[nFirst][nColumn]) )
 		{
-			// Add group to set and clear.
-			oGS.Add(oGroup);
-			oGroup.Truncate();
-		}
+			// Build the group in place and hand it to the set.
+			CResultSet oGroup(*m_pTable);
+
+			oGroup.Collection::assign(oRS.Collection::begin() + nFirst, oRS.Collection::begin() + i);
+			oGS.Adopt(oGroup);
 
-		oGroup.Add(oRS[i]);
+			nFirst = i;
+		}
 	}
 
-	// Add the final group to the set.
-	oGS.Add(oGroup);
+	oTrace.Size(oGS.Count());
 
 	return oGS;
 }
@@ -429,14 +710,7 @@ CResultSet CResultSet::Select(const CWhere& oQuery) const
 {
 	CResultSet oRS(*m_pTable);
 
-	// For all rows, apply the clause,
-	for (size_t i = 0; i < Count(); ++i)
-	{
-		CRow& oRow = Row(i);
-
-		if (oQuery.Matches(oRow))
-			oRS.Add(oRow);
-	}
+	oRS.AddMatches(*this, oQuery);
 
 	return oRS;
 }
@@ -467,6 +741,194 @@ bool CResultSet::Exists(const CWhere& oQuery) const
 	return false;
 }
 
+/******************************************************************************
+** Method:		Query()
+**
+** Description:	Creates a lazy cursor over all the rows in the result set.
+**
+** Parameters:	None.
+**
+** Returns:		The cursor.
+**
+*******************************************************************************
+*/
+
+CRowCursor CResultSet::Query() const
+{
+	return CRowCursor(*this);
+}
+
+/******************************************************************************
+** Methods:		ParallelThreshold()
+**
+** Description:	Gets/Sets the minimum number of rows a SELECT must scan before
+**				it is split across the worker pool. Use Core::npos to force all
+**				scans to be serial.
+**
+** Parameters:	nRows	The minimum number of rows.
+**
+** Returns:		The minimum number of rows.
+**
+*******************************************************************************
+*/
+
+size_t CResultSet::ParallelThreshold()
+{
+	return s_nParallelThreshold;
+}
+
+void CResultSet::ParallelThreshold(size_t nRows)
+{
+	s_nParallelThreshold = nRows;
+}
+
+/******************************************************************************
+** Methods:		ParallelSortThreshold()
+**
+** Description:	Gets/Sets the minimum number of rows an ORDER BY must sort
+**				before it is split across the worker pool. Use Core::npos to
+**				force all sorts to be serial.
+**
+** Parameters:	nRows	The minimum number of rows.
+**
+** Returns:		The minimum number of rows.
+**
+*******************************************************************************
+*/
+
+size_t CResultSet::ParallelSortThreshold()
+{
+	return s_nSortThreshold;
+}
+
+void CResultSet::ParallelSortThreshold(size_t nRows)
+{
+	s_nSortThreshold = nRows;
+}
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The task used to apply a WHERE clause to a contiguous range of rows.
+
+class ScanTask : public CWorkerTask
+{
+public:
+	//! Default constructor.
+	ScanTask()
+		: m_ppFirst(nullptr), m_ppLast(nullptr), m_pQuery(nullptr), m_vMatches(), m_bCount(false), m_nComparisons(0)
+	{ }
+
+	//! Apply the clause to the range.
+	virtual void Run()
+	{
+		for (CRow* const* ppRow = m_ppFirst; ppRow != m_ppLast; ++ppRow)
+		{
+			bool bMatches = (m_bCount) ? m_pQuery->Evaluate(**ppRow, m_nComparisons) : m_pQuery->Matches(**ppRow);
+
+			if (bMatches)
+				m_vMatches.push_back(*ppRow);
+		}
+	}
+
+	//
+	// Members.
+	//
+	CRow* const*		m_ppFirst;		//!< The first row in the range.
+	CRow* const*		m_ppLast;		//!< One past the last row in the range.
+	const CWhere*		m_pQuery;		//!< The clause to apply.
+	std::vector<CRow*>	m_vMatches;		//!< The matching rows.
+	bool				m_bCount;		//!< Count the comparisons?
+	size_t				m_nComparisons;	//!< The comparisons made.
+};
+
+//! The number of chunks to create per worker thread to balance the load.
+const size_t CHUNKS_PER_THREAD = 4;
+
+}
+
+/******************************************************************************
+** Method:		AddMatches()
+**
+** Description:	Appends the rows that match the query. Large collections are
+**				split into chunks which are scanned on the worker pool and the
+**				chunk results are then concatenated so the original row order
+**				is preserved.
+**				NB: The query must be safe to call from multiple threads.
+**
+** Parameters:	vRows			The rows to scan.
+**				oQuery			The where clause.
+**				pComparisons	The comparison count to add to, if counting.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CResultSet::AddMatches(const Collection& vRows, const CWhere& oQuery, size_t* pComparisons)
+{
+	size_t nRows = vRows.size();
+
+	// Small enough to do serially?
+	if ( (nRows < s_nParallelThreshold) || (CWorkerPool::Default().ThreadCount() < 2) )
+	{
+		// For all rows, apply the clause,
+		for (size_t i = 0; i < nRows; ++i)
+		{
+			CRow& oRow = *vRows[i];
+
+			bool bMatches = (pComparisons != nullptr) ? oQuery.Evaluate(oRow, *pComparisons) : oQuery.Matches(oRow);
+
+			if (bMatches)
+				Collection::push_back(&oRow);
+		}
+
+		return;
+	}
+
+	CWorkerPool& oPool   = CWorkerPool::Default();
+	size_t       nChunks = std::min(oPool.ThreadCount() * CHUNKS_PER_THREAD, nRows);
+	size_t       nSize   = (nRows + nChunks - 1) / nChunks;
+
+	// Drop any chunks left empty by rounding up the size.
+	nChunks = (nRows + nSize - 1) / nSize;
+
+	std::vector<ScanTask>     vTasks(nChunks);
+	std::vector<CWorkerTask*> vTaskPtrs(nChunks);
+
+	// Split the rows into chunks.
+	for (size_t i = 0, nFirst = 0; i != nChunks; ++i, nFirst += nSize)
+	{
+		size_t nLast = std::min(nFirst + nSize, nRows);
+
+		vTasks[i].m_ppFirst = &vRows[0] + nFirst;
+		vTasks[i].m_ppLast  = &vRows[0] + nLast;
+		vTasks[i].m_pQuery  = &oQuery;
+		vTasks[i].m_bCount  = (pComparisons != nullptr);
+		vTaskPtrs[i]        = &vTasks[i];
+	}
+
+	oPool.Execute(&vTaskPtrs[0], nChunks);
+
+	size_t nMatches = 0;
+
+	for (size_t i = 0; i != nChunks; ++i)
+		nMatches += vTasks[i].m_vMatches.size();
+
+	if (pComparisons != nullptr)
+	{
+		for (size_t i = 0; i != nChunks; ++i)
+			*pComparisons += vTasks[i].m_nComparisons;
+	}
+
+	Collection::reserve(Count() + nMatches);
+
+	// Concatenate in the original order.
+	for (size_t i = 0; i != nChunks; ++i)
+		Collection::insert(end(), vTasks[i].m_vMatches.begin(), vTasks[i].m_vMatches.end());
+}
+
 /******************************************************************************
 ** Method:		Dump()
 **
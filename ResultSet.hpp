@@ -36,13 +36,23 @@ public:
 	CResultSet(const CTable& oTable, CRow* pRow);
 	CResultSet(const CResultSet& oResultSet);
 	CResultSet(const CTable& oTable, const CRowSet& oRowSet);
+	CResultSet(const CTable& oTable, const CRowSet& oRowSet, const CWhere& oQuery);
+	CResultSet(const CTable& oTable, const CRowSet& oRowSet, const CWhere& oQuery, size_t& nComparisons);
 	virtual ~CResultSet();
 
 	CResultSet& operator=(const CResultSet& oRHS);
 
+#ifdef MDBL_HAS_RVALUE_REFS
+	CResultSet(CResultSet&& oResultSet);
+	CResultSet& operator=(CResultSet&& oRHS);
+#endif
+
+	void Swap(CResultSet& oRHS);
+
 	//
 	// Accessors/Mutators.
 	//
+	const CTable& Table() const;
 	size_t Count() const;
 	CRow& Row(size_t n) const;
 	CRow& operator[](size_t n) const;
@@ -70,6 +80,15 @@ public:
 	//
 	CResultSet Select(const CWhere& oQuery) const;
 	bool       Exists(const CWhere& oQuery) const;
+	CRowCursor Query() const;
+
+	//
+	// Parallel query settings.
+	//
+	static size_t ParallelThreshold();
+	static void   ParallelThreshold(size_t nRows);
+	static size_t ParallelSortThreshold();
+	static void   ParallelSortThreshold(size_t nRows);
 
 	//
 	// Debug methods.
@@ -92,9 +111,22 @@ private:
 	// Friends.
 	//
 	friend class CJoinedSet;
+	friend class CRowCursor;
 
 	//! The underlying collection type.
 	typedef std::vector<CRow*> Collection;
+
+	//
+	// Class members.
+	//
+	static size_t	s_nParallelThreshold;	// Min rows for a parallel scan.
+	static size_t	s_nSortThreshold;		// Min rows for a parallel sort.
+
+	//
+	// Internal methods.
+	//
+	void AddMatches(const Collection& vRows, const CWhere& oQuery, size_t* pComparisons = nullptr);
+	void ParallelSort(const CSortColumns& oColumns);
 };
 
 /******************************************************************************
@@ -104,6 +136,13 @@ private:
 *******************************************************************************
 */
 
+inline const CTable& CResultSet::Table() const
+{
+	ASSERT(m_pTable != nullptr);
+
+	return *m_pTable;
+}
+
 inline size_t CResultSet::Count() const
 {
 	return Collection::size();
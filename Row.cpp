@@ -31,6 +31,8 @@ CRow::CRow(CTable& oTable, bool bNull)
 	, m_aFields(nullptr)
 	, m_nColumns(oTable.m_vColumns.Count())
 	, m_eStatus(ALLOCATED)
+	, m_bMapped(false)
+	, m_nVersion(0)
 {
 	size_t i;
 	size_t nBufSize = 0;
@@ -60,6 +62,63 @@ CRow::CRow(CTable& oTable, bool bNull)
 
 		pData += oColumn.AllocSize();
 	}
+
+	// Add to the tables memory usage.
+	m_oTable.TrackMemory(MemoryUsage(), true);
+}
+
+/******************************************************************************
+** Method:		Constructor.
+**
+** Description:	Constructs a row whose data lives in a snapshot mapping. Only
+**				the fields are allocated, the values, including MDCT_VARSTR
+**				strings, are used in place and so the row must not be modified.
+**
+** Parameters:	oTable		The parent table.
+**				pNulls		The NULL flags for each field.
+**				pData		The data region for the row.
+**				apStrings	The MDCT_VARSTR values, in column order.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CRow::CRow(CTable& oTable, const bool* pNulls, const byte* pData, const tchar* const* apStrings)
+	: m_oTable(oTable)
+	, m_aFields(nullptr)
+	, m_nColumns(oTable.m_vColumns.Count())
+	, m_eStatus(ORIGINAL)
+	, m_bMapped(true)
+	, m_nVersion(0)
+{
+	// Allocate the fields only.
+	m_aFields = static_cast<CField*>(calloc(m_nColumns, sizeof(CField)));
+
+	byte*  pValue   = const_cast<byte*>(pData);
+	size_t nString  = 0;
+
+	// Initialise each field.
+	for (size_t i = 0; i < m_nColumns; ++i)
+	{
+		CColumn& oColumn = m_oTable.m_vColumns[i];
+
+#pragma push_macro("new")
+#undef new 
+
+		// Construct field using 'placement new'.
+		new(&m_aFields[i]) CField(*this, oColumn, i, pNulls[i], pValue);
+
+#pragma pop_macro("new")
+
+		if (oColumn.ColType() == MDCT_VARSTR)
+			m_aFields[i].m_pString = const_cast<tchar*>(apStrings[nString++]);
+
+		pValue += oColumn.AllocSize();
+	}
+
+	// Add to the tables memory usage.
+	m_oTable.TrackMemory(MemoryUsage(), true);
 }
 
 /******************************************************************************
@@ -76,6 +135,9 @@ CRow::CRow(CTable& oTable, bool bNull)
 
 CRow::~CRow()
 {
+	// Remove from the tables memory usage.
+	m_oTable.TrackMemory(MemoryUsage(), false);
+
 	// Destroy each field.
 	for (size_t i = 0; i < m_nColumns; ++i)
 		delete &m_aFields[i];
@@ -123,7 +185,7 @@ void CRow::Read(WCL::IInputStream& rStream)
 			size_t nBytes = Core::numBytes<tchar>(nChars+1);
 
 			// Allocate the buffer.
-			m_aFields[i].m_pString = static_cast<tchar*>(realloc(m_aFields[i].m_pString, nBytes));
+			m_aFields[i].ResizeString(nChars);
 
 			// Read the string.
 			rStream.Read(m_aFields[i].m_pString, nBytes);
@@ -135,17 +197,53 @@ void CRow::Read(WCL::IInputStream& rStream)
 }
 
 void CRow::Write(WCL::IOutputStream& rStream)
+{
+	WriteValues(rStream);
+
+	// Reset status flag.
+	m_eStatus = ORIGINAL;
+}
+
+/******************************************************************************
+** Method:		WriteValues()
+**
+** Description:	Writes the row values to a stream in the same format as Write()
+**				but without touching the status. This is used to serialise a
+**				row from a thread other than the one modifying the table, see
+**				CBackgroundSnapshot.
+**
+** Parameters:	rStream		The stream.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CRow::WriteValues(WCL::IOutputStream& rStream) const
 {
 	// Get the row data size and start address.
 	size_t nSize = m_oTable.m_vColumns.AllocSize();
-	byte* pData = reinterpret_cast<byte*>(m_aFields + m_nColumns);
+	const byte* pData = reinterpret_cast<const byte*>(m_aFields + m_nColumns);
 
 	// Write the null values.
 	for (size_t i=0; i < m_nColumns; ++i)
 		rStream.Write(&m_aFields[i].m_bNull, sizeof(bool));
 
-	// Write the data values.
-	rStream.Write(pData, nSize);
+	// Write the data values, a field at a time if in a snapshot mapping.
+	if (m_bMapped)
+	{
+		for (size_t i = 0; i < m_nColumns; ++i)
+		{
+			size_t nAllocSize = m_aFields[i].m_oColumn.AllocSize();
+
+			if (nAllocSize != 0)
+				rStream.Write(m_aFields[i].m_pVoidPtr, nAllocSize);
+		}
+	}
+	else
+	{
+		rStream.Write(pData, nSize);
+	}
 
 	// Write any MDCT_VARSTR field values.
 	for (size_t i = 0; i < m_nColumns; ++i)
@@ -162,7 +260,340 @@ void CRow::Write(WCL::IOutputStream& rStream)
 			rStream.Write(m_aFields[i].m_pString, nBytes);
 		}
 	}
+}
 
-	// Reset status flag.
+/******************************************************************************
+** Method:		Read()
+**
+** Description:	Copies the row values from a snapshot.
+**
+** Parameters:	pNulls		The NULL flags for each field.
+**				pData		The data region for the row.
+**				apStrings	The MDCT_VARSTR values, in column order.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CRow::Read(const bool* pNulls, const byte* pData, const tchar* const* apStrings)
+{
+	ASSERT(!m_bMapped);
+
+	// Get the row data size and start address.
+	size_t nSize = m_oTable.m_vColumns.AllocSize();
+	byte* pRowData = reinterpret_cast<byte*>(m_aFields + m_nColumns);
+	size_t nString = 0;
+
+	// Copy the null values.
+	for (size_t i=0; i < m_nColumns; ++i)
+		m_aFields[i].m_bNull = pNulls[i];
+
+	// Copy the data values.
+	memcpy(pRowData, pData, nSize);
+
+	// Copy any MDCT_VARSTR field values.
+	for (size_t i = 0; i < m_nColumns; ++i)
+	{
+		if (m_aFields[i].m_oColumn.ColType() == MDCT_VARSTR)
+		{
+			const tchar* pszValue = apStrings[nString++];
+			size_t       nChars   = tstrlen(pszValue);
+			size_t       nBytes   = Core::numBytes<tchar>(nChars+1);
+
+			// Allocate the buffer.
+			m_aFields[i].ResizeString(nChars);
+
+			// Copy the string.
+			memcpy(m_aFields[i].m_pString, pszValue, nBytes);
+		}
+	}
+
+	// Set status flag.
 	m_eStatus = ORIGINAL;
 }
+
+/******************************************************************************
+** Method:		Read()
+**
+** Description:	Copies the row values from another row of the same table, which
+**				may be in a snapshot mapping. This does not update any indexes,
+**				see CTable::Refresh().
+**
+** Parameters:	oRow		The source row.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CRow::Read(const CRow& oRow)
+{
+	ASSERT(!m_bMapped);
+	ASSERT(&oRow.m_oTable == &m_oTable);
+
+	// Get the row data size and start addresses.
+	size_t      nSize    = m_oTable.m_vColumns.AllocSize();
+	byte*       pRowData = reinterpret_cast<byte*>(m_aFields + m_nColumns);
+	const byte* pData    = reinterpret_cast<const byte*>(oRow.m_aFields + m_nColumns);
+
+	// Copy the null values.
+	for (size_t i=0; i < m_nColumns; ++i)
+		m_aFields[i].m_bNull = oRow.m_aFields[i].m_bNull;
+
+	// Copy the data values, a field at a time if in a snapshot mapping.
+	if (oRow.m_bMapped)
+	{
+		for (size_t i = 0; i < m_nColumns; ++i)
+		{
+			const CColumn& oColumn = m_aFields[i].m_oColumn;
+
+			if ( (oColumn.StgType() != MDST_POINTER) && (oColumn.ColType() != MDCT_VARSTR) )
+				memcpy(m_aFields[i].m_pVoidPtr, oRow.m_aFields[i].m_pVoidPtr, oColumn.AllocSize());
+		}
+	}
+	else
+	{
+		memcpy(pRowData, pData, nSize);
+	}
+
+	// Copy any MDCT_VARSTR field values.
+	for (size_t i = 0; i < m_nColumns; ++i)
+	{
+		if (m_aFields[i].m_oColumn.ColType() == MDCT_VARSTR)
+		{
+			const tchar* pszValue = oRow.m_aFields[i].m_pString;
+			size_t       nChars   = tstrlen(pszValue);
+			size_t       nBytes   = Core::numBytes<tchar>(nChars+1);
+
+			// Allocate the buffer.
+			m_aFields[i].ResizeString(nChars);
+
+			// Copy the string.
+			memcpy(m_aFields[i].m_pString, pszValue, nBytes);
+		}
+	}
+
+	// Set status flag.
+	m_eStatus = ORIGINAL;
+}
+
+/******************************************************************************
+** Method:		Unmap()
+**
+** Description:	Copies the values of a row that refers to a snapshot mapping
+**				onto the heap, so that the mapping can be released. The row
+**				itself stays where it is so that indexes, result sets and
+**				row pointers that refer to it remain valid. Any references to
+**				its fields do not.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CRow::Unmap()
+{
+	ASSERT(m_bMapped);
+
+	// Remove the fields only from the tables memory usage.
+	m_oTable.TrackMemory(MemoryUsage(), false);
+
+	CField* aMapped  = m_aFields;
+	size_t  nBufSize = (m_nColumns * sizeof(CField)) + m_oTable.m_vColumns.AllocSize();
+
+	// Allocate the full buffer.
+	m_aFields = static_cast<CField*>(calloc(1, nBufSize));
+	m_bMapped = false;
+
+	// Calculate start of data region.
+	byte* pData = reinterpret_cast<byte*>(m_aFields + m_nColumns);
+
+	// Initialise each field and copy its value.
+	for (size_t i = 0; i < m_nColumns; ++i)
+	{
+		CColumn&      oColumn = m_oTable.m_vColumns[i];
+		const CField& oMapped = aMapped[i];
+
+#pragma push_macro("new")
+#undef new 
+
+		// Construct field using 'placement new'.
+		new(&m_aFields[i]) CField(*this, oColumn, i, oMapped.m_bNull, pData);
+
+#pragma pop_macro("new")
+
+		if (oColumn.ColType() == MDCT_VARSTR)
+		{
+			size_t nChars = tstrlen(oMapped.m_pString);
+
+			m_aFields[i].ResizeString(nChars);
+			memcpy(m_aFields[i].m_pString, oMapped.m_pString, Core::numBytes<tchar>(nChars+1));
+		}
+		else if (oColumn.AllocSize() != 0)
+		{
+			memcpy(pData, oMapped.m_pVoidPtr, oColumn.AllocSize());
+		}
+
+		pData += oColumn.AllocSize();
+	}
+
+	// NB: The mapped fields own no memory, so are not destroyed.
+	free(aMapped);
+
+	// Add the values to the tables memory usage.
+	m_oTable.TrackMemory(MemoryUsage(), true);
+}
+
+/******************************************************************************
+** Method:		Clone()
+**
+** Description:	Creates a copy of the row which is not part of the table, so
+**				it is unaffected by any later changes to this one. This is
+**				used to keep the old versions of a row, see CVersionStore.
+**
+** Parameters:	None.
+**
+** Returns:		The new row, which the caller owns.
+**
+*******************************************************************************
+*/
+
+CRow* CRow::Clone() const
+{
+	CRow* pRow = new CRow(m_oTable);
+
+	pRow->Read(*this);
+	pRow->m_eStatus  = ALLOCATED;
+	pRow->m_nVersion = m_nVersion;
+
+	return pRow;
+}
+
+/******************************************************************************
+** Method:		MemoryUsage()
+**
+** Description:	Calculates the heap memory used by the row. The values of a row
+**				that refers to a snapshot mapping are not on the heap.
+**
+** Parameters:	None.
+**
+** Returns:		The usage, by category.
+**
+*******************************************************************************
+*/
+
+CMemoryUsage CRow::MemoryUsage() const
+{
+	CMemoryUsage oUsage;
+
+	oUsage.m_nFieldOverhead = sizeof(CRow) + (m_nColumns * sizeof(CField));
+
+	if (m_bMapped)
+		return oUsage;
+
+	for (size_t i = 0; i < m_nColumns; ++i)
+	{
+		const CField& oField = m_aFields[i];
+
+		oUsage.m_nFixedData += oField.m_oColumn.AllocSize();
+
+		if (oField.m_oColumn.ColType() == MDCT_VARSTR)
+			oUsage.m_nStrings += Core::numBytes<tchar>(tstrlen(oField.m_pString)+1);
+	}
+
+	return oUsage;
+}
+
+/******************************************************************************
+** Methods:		ReadModified()
+**				WriteModified()
+**
+** Description:	Operators to read/write only the modified field values from/to
+**				a stream. Used by delta snapshots, see CTable::WriteDelta().
+**
+** Parameters:	rStream		The stream.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CRow::ReadModified(WCL::IInputStream& rStream)
+{
+	ASSERT(!m_bMapped);
+
+	for (size_t i = 0; i < m_nColumns; ++i)
+	{
+		CField& oField = m_aFields[i];
+		bool    bModified;
+
+		// Read the modified flag.
+		rStream.Read(&bModified, sizeof(bool));
+
+		if (!bModified)
+			continue;
+
+		// Read the null value.
+		rStream.Read(&oField.m_bNull, sizeof(bool));
+
+		if ( (oField.m_bNull) || (oField.m_oColumn.StgType() == MDST_POINTER) )
+			continue;
+
+		// Read the data value.
+		if (oField.m_oColumn.ColType() == MDCT_VARSTR)
+		{
+			size_t nChars;
+
+			// Read the string length.
+			rStream.Read(&nChars, sizeof(size_t));
+
+			size_t nBytes = Core::numBytes<tchar>(nChars+1);
+
+			// Allocate the buffer and read the string.
+			oField.ResizeString(nChars);
+			rStream.Read(oField.m_pString, nBytes);
+		}
+		else
+		{
+			rStream.Read(oField.m_pVoidPtr, oField.m_oColumn.AllocSize());
+		}
+	}
+}
+
+void CRow::WriteModified(WCL::IOutputStream& rStream) const
+{
+	for (size_t i = 0; i < m_nColumns; ++i)
+	{
+		const CField& oField = m_aFields[i];
+
+		// Write the modified flag.
+		rStream.Write(&oField.m_bModified, sizeof(bool));
+
+		if (!oField.m_bModified)
+			continue;
+
+		// Write the null value.
+		rStream.Write(&oField.m_bNull, sizeof(bool));
+
+		if ( (oField.m_bNull) || (oField.m_oColumn.StgType() == MDST_POINTER) )
+			continue;
+
+		// Write the data value.
+		if (oField.m_oColumn.ColType() == MDCT_VARSTR)
+		{
+			size_t nChars = tstrlen(oField.m_pString);
+			size_t nBytes = Core::numBytes<tchar>(nChars+1);
+
+			// Write the string length and the string.
+			rStream.Write(&nChars, sizeof(size_t));
+			rStream.Write(oField.m_pString, nBytes);
+		}
+		else
+		{
+			rStream.Write(oField.m_pVoidPtr, oField.m_oColumn.AllocSize());
+		}
+	}
+}
@@ -16,6 +16,7 @@
 #endif
 
 #include "Field.hpp"
+#include "MemoryUsage.hpp"
 
 /******************************************************************************
 ** 
@@ -31,6 +32,7 @@ public:
 	// Constructors/Destructor.
 	//
 	CRow(CTable& oTable, bool bNull = false);
+	CRow(CTable& oTable, const bool* pNulls, const byte* pData, const tchar* const* apStrings);
 	~CRow();
 	
 	//
@@ -43,15 +45,21 @@ public:
 
 	uint Status() const;
 	bool InTable() const;
+	bool Mapped() const;
 	bool Inserted() const;
 	bool Updated() const;
 	bool Deleted() const;
+	bool Refreshed() const;
+
+	uint64 Version() const;
+	void   Version(uint64 nVersion);
 
 	void ResetStatus();
 	void MarkOriginal();
 	void MarkInserted();
 	void MarkUpdated();
 	void MarkDeleted();
+	void MarkRefreshed();
 
 	//
 	// Persistance methods.
@@ -60,6 +68,21 @@ public:
 
 	void Read (WCL::IInputStream&  rStream);
 	void Write(WCL::IOutputStream& rStream);
+	void WriteValues(WCL::IOutputStream& rStream) const;
+
+	void Read(const bool* pNulls, const byte* pData, const tchar* const* apStrings);
+	void Read(const CRow& oRow);
+
+	CRow* Clone() const;
+	void  Unmap();
+
+	//
+	// Memory accounting methods.
+	//
+	CMemoryUsage MemoryUsage() const;
+
+	void ReadModified (WCL::IInputStream&  rStream);
+	void WriteModified(WCL::IOutputStream& rStream) const;
 
 	//
 	// Row status flags.
@@ -71,6 +94,7 @@ public:
 		INSERTED  = 0x02,
 		UPDATED   = 0x04,
 		DELETED   = 0x08,
+		REFRESHED = 0x10,
 	};
 
 protected:
@@ -81,10 +105,13 @@ protected:
 	CField*	m_aFields;		// The data fields.
 	size_t	m_nColumns;		// The number of fields.
 	uint	m_eStatus;		// The status.
+	bool	m_bMapped;		// Is the data in a snapshot mapping?
+	uint64	m_nVersion;		// The version the values were written at.
 
 	//
 	// Friends.
 	//
+	friend class CSnapshot;
 
 private:
 	//
@@ -130,6 +157,11 @@ inline bool CRow::InTable() const
 	return (m_eStatus != ALLOCATED);
 }
 
+inline bool CRow::Mapped() const
+{
+	return m_bMapped;
+}
+
 inline bool CRow::Inserted() const
 {
 	return (m_eStatus & INSERTED);
@@ -145,6 +177,21 @@ inline bool CRow::Deleted() const
 	return (m_eStatus & DELETED);
 }
 
+inline bool CRow::Refreshed() const
+{
+	return (m_eStatus & REFRESHED);
+}
+
+inline uint64 CRow::Version() const
+{
+	return m_nVersion;
+}
+
+inline void CRow::Version(uint64 nVersion)
+{
+	m_nVersion = nVersion;
+}
+
 inline void CRow::ResetStatus()
 {
 	m_eStatus = ORIGINAL;
@@ -173,6 +220,11 @@ inline void CRow::MarkDeleted()
 	m_eStatus |= DELETED;
 }
 
+inline void CRow::MarkRefreshed()
+{
+	m_eStatus |= REFRESHED;
+}
+
 inline bool CRow::Modified() const
 {
 	return ( (m_eStatus != ALLOCATED) && (m_eStatus != ORIGINAL) );
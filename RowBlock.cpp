@@ -0,0 +1,782 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RowBlock.cpp
+//! \brief  The CRowBlock class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "RowBlock.hpp"
+#include "BlockCodec.hpp"
+#include "Table.hpp"
+#include "MDBException.hpp"
+#include "WorkerPool.hpp"
+#include <WCL/IInputStream.hpp>
+#include <WCL/IOutputStream.hpp>
+#include <algorithm>
+#include <map>
+
+namespace
+{
+
+//! The values of an integer column.
+typedef std::vector<uint64> Integers;
+
+//! The values of a string column.
+typedef std::vector<const tchar*> Strings;
+
+//! The map of string to dictionary index.
+typedef std::map<tstring, uint32> Dictionary;
+
+//! The shared pointer type used to pass an error between threads.
+typedef Core::SharedPtr<CMDBException> CMDBExceptionPtr;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Map a signed value onto an unsigned one so that small negative values are
+//! also small when written as a varint.
+
+inline uint64 zigZag(uint64 nValue)
+{
+	return (nValue << 1) ^ static_cast<uint64>(static_cast<int64>(nValue) >> 63);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Reverse the zig-zag mapping.
+
+inline uint64 unZigZag(uint64 nValue)
+{
+	return (nValue >> 1) ^ (0 - (nValue & 1));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of bytes needed to write a value as a varint.
+
+inline size_t varintSize(uint64 nValue)
+{
+	size_t nBytes = 1;
+
+	for (; nValue >= 0x80; nValue >>= 7)
+		++nBytes;
+
+	return nBytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of bits needed to hold a value.
+
+inline size_t bitWidth(uint64 nValue)
+{
+	size_t nBits = 0;
+
+	for (; nValue != 0; nValue >>= 1)
+		++nBits;
+
+	return nBits;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a value as a varint.
+
+void writeVarint(std::vector<byte>& vOutput, uint64 nValue)
+{
+	for (; nValue >= 0x80; nValue >>= 7)
+		vOutput.push_back(static_cast<byte>(nValue | 0x80));
+
+	vOutput.push_back(static_cast<byte>(nValue));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a string as its length followed by the characters.
+
+void writeString(std::vector<byte>& vOutput, const tchar* pszValue, size_t nChars)
+{
+	const byte* pBytes = reinterpret_cast<const byte*>(pszValue);
+
+	writeVarint(vOutput, nChars);
+	vOutput.insert(vOutput.end(), pBytes, pBytes + Core::numBytes<tchar>(nChars));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Writes values of an arbitrary number of bits, least significant bit first.
+//! Each writer starts on a byte boundary.
+
+class BitWriter
+{
+public:
+	//! Constructor.
+	BitWriter(std::vector<byte>& vOutput)
+		: m_vOutput(vOutput), m_nUsed(8)
+	{ }
+
+	//! Write the bottom bits of a value.
+	void Write(uint64 nValue, size_t nBits)
+	{
+		while (nBits != 0)
+		{
+			if (m_nUsed == 8)
+			{
+				m_vOutput.push_back(0);
+				m_nUsed = 0;
+			}
+
+			size_t nCount = std::min(nBits, 8 - m_nUsed);
+
+			m_vOutput.back() |= static_cast<byte>((nValue & ((1U << nCount) - 1)) << m_nUsed);
+
+			m_nUsed += nCount;
+			nValue >>= nCount;
+			nBits  -= nCount;
+		}
+	}
+
+private:
+	//
+	// Members.
+	//
+	std::vector<byte>&	m_vOutput;		//!< The output buffer.
+	size_t				m_nUsed;		//!< The bits used in the last byte.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Reads the encoded values, checking that they are within the block.
+
+class Reader
+{
+public:
+	//! Constructor.
+	Reader(const byte* pBegin, const byte* pEnd)
+		: m_pNext(pBegin), m_pEnd(pEnd), m_nUsed(8)
+	{ }
+
+	//! Query if all the input has been consumed.
+	bool AtEnd() const
+	{
+		return (m_pNext == m_pEnd);
+	}
+
+	//! Read the next range of bytes.
+	const byte* Bytes(size_t nBytes)
+	{
+		if (nBytes > static_cast<size_t>(m_pEnd - m_pNext))
+			throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("The encoded rows are truncated"));
+
+		const byte* pBytes = m_pNext;
+
+		m_pNext += nBytes;
+		m_nUsed  = 8;
+
+		return pBytes;
+	}
+
+	//! Read a single byte.
+	byte Byte()
+	{
+		return *Bytes(1);
+	}
+
+	//! Read a varint.
+	uint64 Varint()
+	{
+		uint64 nValue = 0;
+		byte   bValue = 0x80;
+
+		for (size_t nShift = 0; (bValue & 0x80) != 0; nShift += 7)
+		{
+			if (nShift >= 64)
+				throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("A varint is too long"));
+
+			bValue  = Byte();
+			nValue |= static_cast<uint64>(bValue & 0x7F) << nShift;
+		}
+
+		return nValue;
+	}
+
+	//! Read a length prefixed string.
+	const tchar* String(size_t& nChars)
+	{
+		nChars = static_cast<size_t>(Varint());
+
+		if (nChars > (static_cast<size_t>(m_pEnd - m_pNext) / sizeof(tchar)))
+			throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("A string is truncated"));
+
+		return reinterpret_cast<const tchar*>(Bytes(Core::numBytes<tchar>(nChars)));
+	}
+
+	//! Start reading bit-packed values from the next byte.
+	void StartBits()
+	{
+		m_nUsed = 8;
+	}
+
+	//! Read a bit-packed value.
+	uint64 Bits(size_t nBits)
+	{
+		uint64 nValue = 0;
+
+		for (size_t nShift = 0; nShift != nBits; )
+		{
+			if (m_nUsed == 8)
+			{
+				Bytes(1);
+				m_nUsed = 0;
+			}
+
+			size_t nCount = std::min(nBits - nShift, 8 - m_nUsed);
+			uint64 nPart  = (m_pNext[-1] >> m_nUsed) & ((1U << nCount) - 1);
+
+			nValue |= nPart << nShift;
+
+			m_nUsed += nCount;
+			nShift  += nCount;
+		}
+
+		return nValue;
+	}
+
+private:
+	//
+	// Members.
+	//
+	const byte*	m_pNext;		//!< The next byte.
+	const byte*	m_pEnd;			//!< The end of the input.
+	size_t		m_nUsed;		//!< The bits used in the current byte.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the integer values using the smaller of the two encodings.
+
+void writeIntegers(std::vector<byte>& vOutput, const Integers& vValues, byte bFrame, byte bDelta)
+{
+	size_t nCount = vValues.size();
+	int64  nMin   = static_cast<int64>(vValues[0]);
+	int64  nMax   = nMin;
+	size_t nDelta = 0;
+	uint64 nPrev  = 0;
+
+	for (size_t i = 0; i != nCount; ++i)
+	{
+		nMin    = std::min(nMin, static_cast<int64>(vValues[i]));
+		nMax    = std::max(nMax, static_cast<int64>(vValues[i]));
+		nDelta += varintSize(zigZag(vValues[i] - nPrev));
+		nPrev   = vValues[i];
+	}
+
+	size_t nBits  = bitWidth(static_cast<uint64>(nMax) - static_cast<uint64>(nMin));
+	size_t nFrame = varintSize(zigZag(nMin)) + 1 + (((nCount * nBits) + 7) / 8);
+
+	if (nFrame <= nDelta)
+	{
+		vOutput.push_back(bFrame);
+		writeVarint(vOutput, zigZag(nMin));
+		vOutput.push_back(static_cast<byte>(nBits));
+
+		BitWriter oWriter(vOutput);
+
+		for (size_t i = 0; i != nCount; ++i)
+			oWriter.Write(vValues[i] - static_cast<uint64>(nMin), nBits);
+	}
+	else
+	{
+		vOutput.push_back(bDelta);
+
+		nPrev = 0;
+
+		for (size_t i = 0; i != nCount; ++i)
+		{
+			writeVarint(vOutput, zigZag(vValues[i] - nPrev));
+			nPrev = vValues[i];
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the string values using the smaller of the two encodings.
+
+void writeStrings(std::vector<byte>& vOutput, const Strings& vValues, byte bDictionary, byte bPlain)
+{
+	size_t              nCount = vValues.size();
+	Dictionary          mIndexes;
+	std::vector<uint32> vIndexes(nCount);
+	Strings             vEntries;
+	size_t              nPlain = 0;
+	size_t              nDict  = 0;
+
+	for (size_t i = 0; i != nCount; ++i)
+	{
+		size_t nChars = tstrlen(vValues[i]);
+		size_t nSize  = varintSize(nChars) + Core::numBytes<tchar>(nChars);
+
+		std::pair<Dictionary::iterator, bool> oResult = mIndexes.insert(std::make_pair(tstring(vValues[i]), static_cast<uint32>(vEntries.size())));
+
+		// New entry?
+		if (oResult.second)
+		{
+			vEntries.push_back(vValues[i]);
+			nDict += nSize;
+		}
+
+		vIndexes[i] = oResult.first->second;
+		nPlain     += nSize;
+	}
+
+	size_t nBits = bitWidth(vEntries.size() - 1);
+
+	nDict += varintSize(vEntries.size()) + (((nCount * nBits) + 7) / 8);
+
+	if (nDict < nPlain)
+	{
+		vOutput.push_back(bDictionary);
+		writeVarint(vOutput, vEntries.size());
+
+		for (size_t i = 0; i != vEntries.size(); ++i)
+			writeString(vOutput, vEntries[i], tstrlen(vEntries[i]));
+
+		BitWriter oWriter(vOutput);
+
+		for (size_t i = 0; i != nCount; ++i)
+			oWriter.Write(vIndexes[i], nBits);
+	}
+	else
+	{
+		vOutput.push_back(bPlain);
+
+		for (size_t i = 0; i != nCount; ++i)
+			writeString(vOutput, vValues[i], tstrlen(vValues[i]));
+	}
+}
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The task used to encode or decode a block.
+
+class CRowBlock::Task : public CWorkerTask
+{
+public:
+	//! Default constructor.
+	Task()
+		: m_pBlock(nullptr), m_pTable(nullptr), m_nFirst(0), m_nLast(0), m_pError()
+	{ }
+
+	//! Encode or decode the block.
+	virtual void Run()
+	{
+		try
+		{
+			if (m_nFirst != m_nLast)
+				m_pBlock->EncodeRows(*m_pTable, m_nFirst, m_nLast);
+			else
+				m_pBlock->DecodeRows(*m_pTable);
+		}
+		catch (const CMDBException& e)
+		{
+			m_pError.reset(new CMDBException(e));
+		}
+	}
+
+	//
+	// Members.
+	//
+	CRowBlock*			m_pBlock;		//!< The block.
+	const CTable*		m_pTable;		//!< The table.
+	size_t				m_nFirst;		//!< The first row to encode.
+	size_t				m_nLast;		//!< One past the last row to encode.
+	CMDBExceptionPtr	m_pError;		//!< The error, if one.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+CRowBlock::CRowBlock()
+	: m_nRows(0)
+	, m_nRawSize(0)
+	, m_vPacked()
+	, m_vNulls()
+	, m_vData()
+	, m_vHeap()
+	, m_vStrings()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the encoded block to a stream. If compression did not help the block
+//! is stored, which is indicated by the packed size matching the raw size.
+
+void CRowBlock::Write(WCL::IOutputStream& rStream) const
+{
+	uint32 nPacked = static_cast<uint32>(m_vPacked.size());
+
+	rStream << m_nRows;
+	rStream << m_nRawSize;
+	rStream << nPacked;
+
+	rStream.Write(&m_vPacked[0], nPacked);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read an encoded block from a stream. It is not decoded until Decode().
+
+void CRowBlock::Read(WCL::IInputStream& rStream)
+{
+	uint32 nPacked;
+
+	rStream >> m_nRows;
+	rStream >> m_nRawSize;
+	rStream >> nPacked;
+
+	if ( (m_nRows == 0) || (m_nRows > MAX_ROWS) || (nPacked == 0) || (nPacked > m_nRawSize) )
+		throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("The block header is invalid"));
+
+	m_vPacked.resize(nPacked);
+
+	rStream.Read(&m_vPacked[0], nPacked);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy a decoded row into a table row.
+
+void CRowBlock::CopyRow(size_t nRow, CRow& oRow) const
+{
+	ASSERT(nRow < m_nRows);
+
+	size_t nColumns    = m_vNulls.size() / m_nRows;
+	size_t nRowSize    = m_vData.size() / m_nRows;
+	size_t nStrColumns = m_vStrings.size() / m_nRows;
+
+	const bool*         pNulls    = reinterpret_cast<const bool*>(&m_vNulls[0] + (nRow * nColumns));
+	const byte*         pData     = (nRowSize    != 0) ? &m_vData[nRow * nRowSize]       : nullptr;
+	const tchar* const* apStrings = (nStrColumns != 0) ? &m_vStrings[nRow * nStrColumns] : nullptr;
+
+	oRow.Read(pNulls, pData, apStrings);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Encode consecutive blocks of table rows concurrently, starting at the given
+//! row. Each block is filled with up to MAX_ROWS rows.
+
+void CRowBlock::Encode(const CTable& oTable, size_t nFirst, std::vector<CRowBlock>& vBlocks)
+{
+	std::vector<Task>         vTasks(vBlocks.size());
+	std::vector<CWorkerTask*> vTaskPtrs(vBlocks.size());
+	size_t                    nRows = oTable.RowCount();
+
+	for (size_t i = 0; i != vTasks.size(); ++i)
+	{
+		ASSERT(nFirst < nRows);
+
+		vTasks[i].m_pBlock = &vBlocks[i];
+		vTasks[i].m_pTable = &oTable;
+		vTasks[i].m_nFirst = nFirst;
+		vTasks[i].m_nLast  = nFirst = std::min(nFirst + MAX_ROWS, nRows);
+		vTaskPtrs[i]       = &vTasks[i];
+	}
+
+	if (!vTasks.empty())
+		CWorkerPool::Default().Execute(&vTaskPtrs[0], vTaskPtrs.size());
+
+	for (size_t i = 0; i != vTasks.size(); ++i)
+	{
+		if (vTasks[i].m_pError.get() != nullptr)
+			throw *vTasks[i].m_pError;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Decompress and decode the blocks concurrently.
+
+void CRowBlock::Decode(const CTable& oTable, std::vector<CRowBlock>& vBlocks)
+{
+	std::vector<Task>         vTasks(vBlocks.size());
+	std::vector<CWorkerTask*> vTaskPtrs(vBlocks.size());
+
+	for (size_t i = 0; i != vTasks.size(); ++i)
+	{
+		vTasks[i].m_pBlock = &vBlocks[i];
+		vTasks[i].m_pTable = &oTable;
+		vTaskPtrs[i]       = &vTasks[i];
+	}
+
+	if (!vTasks.empty())
+		CWorkerPool::Default().Execute(&vTaskPtrs[0], vTaskPtrs.size());
+
+	for (size_t i = 0; i != vTasks.size(); ++i)
+	{
+		if (vTasks[i].m_pError.get() != nullptr)
+			throw *vTasks[i].m_pError;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Encode a range of table rows a column at a time and then compress them.
+
+void CRowBlock::EncodeRows(const CTable& oTable, size_t nFirst, size_t nLast)
+{
+	std::vector<byte> vEncoded;
+	Integers          vIntegers;
+	Strings           vStrings;
+
+	m_nRows = static_cast<uint32>(nLast - nFirst);
+
+	// For all columns.
+	for (size_t c = 0; c != oTable.ColumnCount(); ++c)
+	{
+		const CColumn& oColumn = oTable.Column(c);
+		STGTYPE        eType   = oColumn.StgType();
+		BitWriter      oNulls(vEncoded);
+		size_t         nValues = 0;
+
+		vIntegers.clear();
+		vStrings.clear();
+
+		// Write the NULL flags and collect the values.
+		for (size_t r = nFirst; r != nLast; ++r)
+		{
+			const CField& oField = oTable[r][c];
+
+			oNulls.Write(oField.m_bNull, 1);
+
+			if (oField.m_bNull)
+				continue;
+
+			if (eType == MDST_INT)
+				vIntegers.push_back(static_cast<uint64>(static_cast<int64>(*oField.m_pInt)));
+			else if (eType == MDST_INT64)
+				vIntegers.push_back(static_cast<uint64>(*oField.m_pInt64));
+			else if (eType == MDST_STRING)
+				vStrings.push_back(oField.m_pString);
+
+			++nValues;
+		}
+
+		// Pointers are not persisted.
+		if ( (eType == MDST_POINTER) || (nValues == 0) )
+			continue;
+
+		// Write the values.
+		if ( (eType == MDST_INT) || (eType == MDST_INT64) )
+		{
+			writeIntegers(vEncoded, vIntegers, FRAME, DELTA);
+		}
+		else if (eType == MDST_STRING)
+		{
+			writeStrings(vEncoded, vStrings, DICTIONARY, PLAIN);
+		}
+		else
+		{
+			vEncoded.push_back(RAW);
+
+			for (size_t r = nFirst; r != nLast; ++r)
+			{
+				const CField& oField = oTable[r][c];
+
+				if (!oField.m_bNull)
+				{
+					const byte* pValue = static_cast<const byte*>(oField.m_pVoidPtr);
+
+					vEncoded.insert(vEncoded.end(), pValue, pValue + oColumn.AllocSize());
+				}
+			}
+		}
+	}
+
+	m_nRawSize = static_cast<uint32>(vEncoded.size());
+
+	CBlockCodec::Compress(&vEncoded[0], vEncoded.size(), m_vPacked);
+
+	// Store the block if it didn't compress.
+	if (m_vPacked.size() >= vEncoded.size())
+		m_vPacked.swap(vEncoded);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Decompress and decode the rows into the layout expected by CRow::Read().
+
+void CRowBlock::DecodeRows(const CTable& oTable)
+{
+	std::vector<byte> vEncoded;
+
+	// Decompress, unless stored.
+	if (m_vPacked.size() != m_nRawSize)
+	{
+		vEncoded.resize(m_nRawSize);
+
+		CBlockCodec::Decompress(&m_vPacked[0], m_vPacked.size(), &vEncoded[0], vEncoded.size());
+	}
+	else
+	{
+		vEncoded.swap(m_vPacked);
+	}
+
+	size_t nColumns    = oTable.ColumnCount();
+	size_t nRowSize    = 0;
+	size_t nStrColumns = 0;
+
+	for (size_t c = 0; c != nColumns; ++c)
+	{
+		nRowSize += oTable.Column(c).AllocSize();
+
+		if (oTable.Column(c).ColType() == MDCT_VARSTR)
+			++nStrColumns;
+	}
+
+	std::vector<size_t> vOffsets(m_nRows * nStrColumns, 0);
+	std::vector<size_t> vRows;
+	Reader              oReader(&vEncoded[0], &vEncoded[0] + vEncoded.size());
+	size_t              nOffset = 0;
+	size_t              nString = 0;
+
+	m_vNulls.assign(m_nRows * nColumns, false);
+	m_vData.assign(m_nRows * nRowSize, 0);
+	m_vHeap.assign(1, TXT('\0'));
+
+	// For all columns.
+	for (size_t c = 0; c != nColumns; ++c)
+	{
+		const CColumn& oColumn = oTable.Column(c);
+		STGTYPE        eType   = oColumn.StgType();
+		size_t         nSize   = oColumn.AllocSize();
+
+		vRows.clear();
+
+		// Read the NULL flags.
+		oReader.StartBits();
+
+		for (size_t r = 0; r != m_nRows; ++r)
+		{
+			m_vNulls[(r * nColumns) + c] = static_cast<byte>(oReader.Bits(1));
+
+			if (!m_vNulls[(r * nColumns) + c])
+				vRows.push_back(r);
+		}
+
+		if ( (eType == MDST_POINTER) || (vRows.empty()) )
+		{
+			if (oColumn.ColType() == MDCT_VARSTR)
+				++nString;
+
+			nOffset += nSize;
+			continue;
+		}
+
+		byte bEncoding = oReader.Byte();
+
+		// Read the values.
+		if ( ((eType == MDST_INT) || (eType == MDST_INT64)) && ((bEncoding == FRAME) || (bEncoding == DELTA)) )
+		{
+			uint64 nBase = 0;
+			size_t nBits = 0;
+
+			if (bEncoding == FRAME)
+			{
+				nBase = unZigZag(oReader.Varint());
+				nBits = oReader.Byte();
+
+				if (nBits > 64)
+					throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("A bit width is invalid"));
+
+				oReader.StartBits();
+			}
+
+			for (size_t i = 0; i != vRows.size(); ++i)
+			{
+				uint64 nValue = (bEncoding == FRAME) ? (nBase + oReader.Bits(nBits)) : (nBase += unZigZag(oReader.Varint()));
+				byte*  pValue = &m_vData[(vRows[i] * nRowSize) + nOffset];
+
+				if (eType == MDST_INT)
+				{
+					int nInt = static_cast<int>(static_cast<int64>(nValue));
+
+					memcpy(pValue, &nInt, sizeof(nInt));
+				}
+				else
+				{
+					memcpy(pValue, &nValue, sizeof(nValue));
+				}
+			}
+		}
+		else if ( (eType == MDST_STRING) && ((bEncoding == DICTIONARY) || (bEncoding == PLAIN)) )
+		{
+			std::vector<const tchar*> vEntries;
+			std::vector<size_t>       vLengths;
+			size_t                    nBits = 0;
+
+			if (bEncoding == DICTIONARY)
+			{
+				size_t nEntries = static_cast<size_t>(oReader.Varint());
+
+				if ( (nEntries == 0) || (nEntries > vRows.size()) )
+					throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("A dictionary size is invalid"));
+
+				vEntries.resize(nEntries);
+				vLengths.resize(nEntries);
+
+				for (size_t i = 0; i != nEntries; ++i)
+					vEntries[i] = oReader.String(vLengths[i]);
+
+				nBits = bitWidth(nEntries - 1);
+
+				oReader.StartBits();
+			}
+
+			for (size_t i = 0; i != vRows.size(); ++i)
+			{
+				const tchar* pszValue;
+				size_t       nChars;
+
+				if (bEncoding == DICTIONARY)
+				{
+					size_t nEntry = static_cast<size_t>(oReader.Bits(nBits));
+
+					if (nEntry >= vEntries.size())
+						throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("A dictionary index is invalid"));
+
+					pszValue = vEntries[nEntry];
+					nChars   = vLengths[nEntry];
+				}
+				else
+				{
+					pszValue = oReader.String(nChars);
+				}
+
+				if (oColumn.ColType() == MDCT_VARSTR)
+				{
+					// NB: Stored as an offset as the heap may be reallocated.
+					vOffsets[(vRows[i] * nStrColumns) + nString] = m_vHeap.size();
+
+					m_vHeap.insert(m_vHeap.end(), pszValue, pszValue + nChars);
+					m_vHeap.push_back(TXT('\0'));
+				}
+				else
+				{
+					if (Core::numBytes<tchar>(nChars+1) > nSize)
+						throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("A string is too long for its column"));
+
+					memcpy(&m_vData[(vRows[i] * nRowSize) + nOffset], pszValue, Core::numBytes<tchar>(nChars));
+				}
+			}
+		}
+		else if (bEncoding == RAW)
+		{
+			for (size_t i = 0; i != vRows.size(); ++i)
+				memcpy(&m_vData[(vRows[i] * nRowSize) + nOffset], oReader.Bytes(nSize), nSize);
+		}
+		else
+		{
+			throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("A column encoding is invalid"));
+		}
+
+		if (oColumn.ColType() == MDCT_VARSTR)
+			++nString;
+
+		nOffset += nSize;
+	}
+
+	if (!oReader.AtEnd())
+		throw CMDBException(CMDBException::E_BAD_BLOCK, TXT("The encoded rows are too long"));
+
+	m_vStrings.resize(vOffsets.size());
+
+	for (size_t i = 0; i != vOffsets.size(); ++i)
+		m_vStrings[i] = &m_vHeap[vOffsets[i]];
+
+	m_vPacked.clear();
+}
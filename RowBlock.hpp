@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RowBlock.hpp
+//! \brief  The CRowBlock class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_ROWBLOCK_HPP
+#define MDBL_ROWBLOCK_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "FwdDecls.hpp"
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A block of up to MAX_ROWS rows from a table in the compressed stream format,
+//! see CTable::WriteCompressed(). The rows are encoded a column at a time and
+//! the result is then compressed with CBlockCodec. Each column is stored as a
+//! bitmap of the NULL flags followed by the non-null values in one of these
+//! encodings:
+//!
+//!   - integers and date/times as either frame-of-reference, i.e. the minimum
+//!     value and then the bit-packed difference from it, or as the zig-zag
+//!     varint delta from the previous value, whichever is smaller,
+//!   - strings as either a dictionary of the distinct values and a bit-packed
+//!     index per row, or as the length prefixed values, whichever is smaller,
+//!   - everything else as the raw fixed-width values.
+//!
+//! Pointer values are not persisted, as with the uncompressed format. Blocks
+//! are independent of each other so that they can be encoded and decoded
+//! concurrently.
+
+class CRowBlock
+{
+public:
+	//! Default constructor.
+	CRowBlock();
+
+	//
+	// Properties.
+	//
+
+	//! Get the number of rows in the block.
+	size_t RowCount() const;
+
+	//
+	// Methods.
+	//
+
+	//! Write the encoded block to a stream.
+	void Write(WCL::IOutputStream& rStream) const;
+
+	//! Read an encoded block from a stream.
+	void Read(WCL::IInputStream& rStream);
+
+	//! Copy a decoded row into a table row.
+	void CopyRow(size_t nRow, CRow& oRow) const;
+
+	//
+	// Class methods.
+	//
+
+	//! Encode consecutive blocks of table rows concurrently.
+	static void Encode(const CTable& oTable, size_t nFirst, std::vector<CRowBlock>& vBlocks);
+
+	//! Decode the blocks concurrently.
+	static void Decode(const CTable& oTable, std::vector<CRowBlock>& vBlocks);
+
+	//! The maximum number of rows in a block.
+	static const size_t MAX_ROWS = 4096;
+
+private:
+	//! The task used to encode or decode a block.
+	class Task;
+
+	//! The column encodings.
+	enum Encoding
+	{
+		RAW,			//!< Fixed-width values.
+		FRAME,			//!< Frame-of-reference, bit-packed.
+		DELTA,			//!< Zig-zag varint deltas.
+		DICTIONARY,		//!< Dictionary and bit-packed indexes.
+		PLAIN,			//!< Length prefixed strings.
+	};
+
+	//
+	// Members.
+	//
+	uint32				m_nRows;		//!< The number of rows.
+	uint32				m_nRawSize;		//!< The size before compression.
+	std::vector<byte>	m_vPacked;		//!< The compressed encoded rows.
+	std::vector<byte>	m_vNulls;		//!< The decoded NULL flags.
+	std::vector<byte>	m_vData;		//!< The decoded data regions.
+	std::vector<tchar>	m_vHeap;		//!< The decoded MDCT_VARSTR values.
+	std::vector<const tchar*> m_vStrings;	//!< The MDCT_VARSTR values per row.
+
+	//
+	// Internal methods.
+	//
+
+	//! Encode a range of table rows.
+	void EncodeRows(const CTable& oTable, size_t nFirst, size_t nLast);
+
+	//! Decode the rows.
+	void DecodeRows(const CTable& oTable);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of rows in the block.
+
+inline size_t CRowBlock::RowCount() const
+{
+	return m_nRows;
+}
+
+#endif // MDBL_ROWBLOCK_HPP
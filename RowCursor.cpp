@@ -0,0 +1,244 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RowCursor.cpp
+//! \brief  The CRowCursor class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "RowCursor.hpp"
+#include "RowSet.hpp"
+#include "ResultSet.hpp"
+#include "Row.hpp"
+#include "Table.hpp"
+#include "Where.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construct a cursor over all the rows in a table. If a copy is requested the
+//! cursor iterates its own copy of the row pointers, which is shared by any
+//! copies of the cursor.
+
+CRowCursor::CRowCursor(const CTable& oTable, const CRowSet& oRows, bool bCopy)
+	: m_pTable(&oTable)
+	, m_pRows(&static_cast<const Collection&>(oRows))
+	, m_pCopy()
+	, m_vFilters()
+	, m_vColumns()
+	, m_nLimit(Core::npos)
+	, m_nNext(0)
+	, m_nReturned(0)
+	, m_pCurrent(nullptr)
+{
+	if (bCopy)
+	{
+		m_pCopy.reset(new Collection(*m_pRows));
+		m_pRows = m_pCopy.get();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construct a cursor over all the rows in a result set.
+
+CRowCursor::CRowCursor(const CResultSet& oRows)
+	: m_pTable(oRows.m_pTable)
+	, m_pRows(&static_cast<const Collection&>(oRows))
+	, m_pCopy()
+	, m_vFilters()
+	, m_vColumns()
+	, m_nLimit(Core::npos)
+	, m_nNext(0)
+	, m_nReturned(0)
+	, m_pCurrent(nullptr)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy constructor. The WHERE clauses are immutable and so are shared.
+
+CRowCursor::CRowCursor(const CRowCursor& oCursor)
+	: m_pTable(oCursor.m_pTable)
+	, m_pRows(oCursor.m_pRows)
+	, m_pCopy(oCursor.m_pCopy)
+	, m_vFilters(oCursor.m_vFilters)
+	, m_vColumns(oCursor.m_vColumns)
+	, m_nLimit(oCursor.m_nLimit)
+	, m_nNext(oCursor.m_nNext)
+	, m_nReturned(oCursor.m_nReturned)
+	, m_pCurrent(oCursor.m_pCurrent)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+CRowCursor::~CRowCursor()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Assignment operator.
+
+CRowCursor& CRowCursor::operator=(const CRowCursor& oCursor)
+{
+	m_pTable    = oCursor.m_pTable;
+	m_pRows     = oCursor.m_pRows;
+	m_pCopy     = oCursor.m_pCopy;
+	m_vFilters  = oCursor.m_vFilters;
+	m_vColumns  = oCursor.m_vColumns;
+	m_nLimit    = oCursor.m_nLimit;
+	m_nNext     = oCursor.m_nNext;
+	m_nReturned = oCursor.m_nReturned;
+	m_pCurrent  = oCursor.m_pCurrent;
+
+	return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Only return the rows that also match the WHERE clause. Multiple clauses are
+//! ANDed together and evaluated in the order they were added.
+
+CRowCursor& CRowCursor::Where(const CWhere& oQuery)
+{
+	ASSERT(m_nNext == 0);
+
+	m_vFilters.push_back(WherePtr(oQuery.Clone()));
+
+	return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a column to the projection. Once a projection exists Field() indexes
+//! into it rather than the table columns.
+
+CRowCursor& CRowCursor::Project(size_t nColumn)
+{
+	m_vColumns.push_back(nColumn);
+
+	return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Stop after the specified number of rows have been returned.
+
+CRowCursor& CRowCursor::Limit(size_t nRows)
+{
+	m_nLimit = nRows;
+
+	return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Move onto the next matching row. Returns false when there are no more rows
+//! or the limit has been reached.
+
+bool CRowCursor::Next()
+{
+	m_pCurrent = nullptr;
+
+	if (m_nReturned == m_nLimit)
+		return false;
+
+	while (m_nNext < m_pRows->size())
+	{
+		CRow* pRow = (*m_pRows)[m_nNext++];
+
+		if (Matches(*pRow))
+		{
+			m_pCurrent = pRow;
+			++m_nReturned;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Move back to the start of the rows.
+
+void CRowCursor::Reset()
+{
+	m_nNext     = 0;
+	m_nReturned = 0;
+	m_pCurrent  = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of columns in the projection. Without a projection this is
+//! the number of columns in the table.
+
+size_t CRowCursor::NumColumns() const
+{
+	if (m_vColumns.empty())
+		return m_pTable->ColumnCount();
+
+	return m_vColumns.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get a field from the current row using the projection.
+
+CField& CRowCursor::Field(size_t n) const
+{
+	if (m_vColumns.empty())
+		return Row().Field(n);
+
+	ASSERT(n < m_vColumns.size());
+
+	return Row().Field(m_vColumns[n]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if at least one row matches. This stops at the first match.
+
+bool CRowCursor::Exists()
+{
+	return Next();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the first matching row, if one exists.
+
+CRow* CRowCursor::First()
+{
+	return Next() ? m_pCurrent : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Count the remaining matching rows without materialising them.
+
+size_t CRowCursor::Count()
+{
+	size_t nRows = 0;
+
+	while (Next())
+		++nRows;
+
+	return nRows;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Materialise the remaining matching rows.
+
+CResultSet CRowCursor::ToResultSet()
+{
+	CResultSet oRS(*m_pTable);
+
+	while (Next())
+		oRS.Add(*m_pCurrent);
+
+	return oRS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the row matches all the filters.
+
+bool CRowCursor::Matches(const CRow& oRow) const
+{
+	for (size_t i = 0; i != m_vFilters.size(); ++i)
+	{
+		if (!m_vFilters[i]->Matches(oRow))
+			return false;
+	}
+
+	return true;
+}
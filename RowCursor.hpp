@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RowCursor.hpp
+//! \brief  The CRowCursor class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_ROWCURSOR_HPP
+#define MDBL_ROWCURSOR_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "FwdDecls.hpp"
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A lazy, forward-only cursor over the rows of a table or result set. Unlike
+//! CTable::Select() the WHERE clauses are only evaluated as the cursor is moved
+//! on and so no intermediate collection of rows is built. Filters, a column
+//! projection and a row limit can be chained onto the cursor before the first
+//! call to Next(), e.g.
+//!
+//!   CRowCursor cursor = table.Query().Where(clause1).Where(clause2).Limit(10);
+//!
+//!   while (cursor.Next())
+//!       process(cursor.Row());
+//!
+//! The cursor refers directly to the underlying rows and so the source table or
+//! result set must outlive it and must not have rows deleted while it is used.
+//! The cursor holds no lock, so for a CONCURRENT table CTable::Query() copies
+//! the row pointers whilst it holds the table lock and the cursor iterates the
+//! copy. Rows inserted after the cursor was created are not returned.
+
+class CRowCursor
+{
+public:
+	//! Construct a cursor over all the rows in a table, or a copy of them.
+	CRowCursor(const CTable& oTable, const CRowSet& oRows, bool bCopy = false);
+
+	//! Construct a cursor over all the rows in a result set.
+	explicit CRowCursor(const CResultSet& oRows);
+
+	//! Copy constructor.
+	CRowCursor(const CRowCursor& oCursor);
+
+	//! Destructor.
+	~CRowCursor();
+
+	//! Assignment operator.
+	CRowCursor& operator=(const CRowCursor& oCursor);
+
+	//
+	// Query building methods.
+	//
+
+	//! Only return the rows that also match the WHERE clause.
+	CRowCursor& Where(const CWhere& oQuery);
+
+	//! Add a column to the projection.
+	CRowCursor& Project(size_t nColumn);
+
+	//! Stop after the specified number of rows have been returned.
+	CRowCursor& Limit(size_t nRows);
+
+	//
+	// Iteration methods.
+	//
+
+	//! Move onto the next matching row.
+	bool Next();
+
+	//! Move back to the start of the rows.
+	void Reset();
+
+	//! Get the current row.
+	CRow& Row() const;
+
+	//! Get the number of columns in the projection.
+	size_t NumColumns() const;
+
+	//! Get a field from the current row using the projection.
+	CField& Field(size_t n) const;
+
+	//
+	// Terminal methods.
+	//
+
+	//! Query if at least one row matches.
+	bool Exists();
+
+	//! Get the first matching row, if one exists.
+	CRow* First();
+
+	//! Count the remaining matching rows.
+	size_t Count();
+
+	//! Materialise the remaining matching rows.
+	CResultSet ToResultSet();
+
+private:
+	//! The type used to hold a WHERE clause.
+	typedef Core::SharedPtr<CWhere> WherePtr;
+	//! The underlying collection type.
+	typedef std::vector<CRow*> Collection;
+	//! The type used to hold a copy of the rows.
+	typedef Core::SharedPtr<Collection> CollectionPtr;
+
+	//
+	// Members.
+	//
+	const CTable*			m_pTable;		//!< The table the rows belong to.
+	const Collection*		m_pRows;		//!< The rows to iterate.
+	CollectionPtr			m_pCopy;		//!< The copy of the rows, if made.
+	std::vector<WherePtr>	m_vFilters;		//!< The WHERE clauses to apply.
+	std::vector<size_t>		m_vColumns;		//!< The column projection.
+	size_t					m_nLimit;		//!< The maximum rows to return.
+	size_t					m_nNext;		//!< The next row to evaluate.
+	size_t					m_nReturned;	//!< The number of rows returned.
+	CRow*					m_pCurrent;		//!< The current row.
+
+	//
+	// Internal methods.
+	//
+
+	//! Query if the row matches all the filters.
+	bool Matches(const CRow& oRow) const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the current row.
+
+inline CRow& CRowCursor::Row() const
+{
+	ASSERT(m_pCurrent != nullptr);
+
+	return *m_pCurrent;
+}
+
+#endif // MDBL_ROWCURSOR_HPP
@@ -43,9 +43,12 @@ public:
 
 	size_t Add(CRow& oRow);
 	void  Remove(size_t nRow);
+	void  RemoveAll();
 
 	void  Delete(size_t nRow);
 	void  DeleteAll();
+	void  DeleteMarked();
+	void  RemoveMarked(std::vector<CRow*>& vRemoved);
 
 	bool  Modified() const;
 
@@ -60,6 +63,7 @@ private:
 	// Friends.
 	//
 	friend class CResultSet;
+	friend class CRowCursor;
 
 	//! The underlying collection type.
 	typedef std::vector<CRow*> Collection;
@@ -108,6 +112,11 @@ inline void CRowSet::Remove(size_t nRow)
 	Core::eraseAt(*this, nRow);
 }
 
+inline void CRowSet::RemoveAll()
+{
+	Collection::clear();
+}
+
 inline void CRowSet::Delete(size_t nRow)
 {
 	Core::deleteAt(*this, nRow);
@@ -118,6 +127,38 @@ inline void CRowSet::DeleteAll()
 	Core::deleteAll(*this);
 }
 
+inline void CRowSet::DeleteMarked()
+{
+	iterator itEnd = begin();
+
+	// Compact the rows, preserving the order.
+	for (iterator it = begin(); it != end(); ++it)
+	{
+		if ((*it)->Deleted())
+			delete *it;
+		else
+			*itEnd++ = *it;
+	}
+
+	erase(itEnd, end());
+}
+
+inline void CRowSet::RemoveMarked(std::vector<CRow*>& vRemoved)
+{
+	iterator itEnd = begin();
+
+	// Compact the rows, preserving the order.
+	for (iterator it = begin(); it != end(); ++it)
+	{
+		if ((*it)->Deleted())
+			vRemoved.push_back(*it);
+		else
+			*itEnd++ = *it;
+	}
+
+	erase(itEnd, end());
+}
+
 inline bool CRowSet::Modified() const
 {
 	for (size_t i = 0; i < Count(); ++i)
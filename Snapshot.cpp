@@ -0,0 +1,1288 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Snapshot.cpp
+//! \brief  The CSnapshot class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Snapshot.hpp"
+#include "MDBException.hpp"
+#include "TableSet.hpp"
+#include "Table.hpp"
+#include "Row.hpp"
+#include "Index.hpp"
+#include "WorkerPool.hpp"
+#include "Crc32c.hpp"
+#include <string.h>
+#include <algorithm>
+
+namespace
+{
+
+//! The file signature.
+const char SIGNATURE[8] = { 'M', 'D', 'B', 'L', 'S', 'N', 'A', 'P' };
+
+//! The size of the write buffer.
+const size_t WRITE_BUFFER_SIZE = 64 * 1024;
+
+//! The type used to pass an error back from a worker.
+typedef Core::SharedPtr<CMDBException> CMDBExceptionPtr;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Round the offset up to the start of the next section.
+
+uint64 alignUp(uint64 nOffset)
+{
+	const uint64 nAlign = CSnapshot::SECTION_ALIGN;
+
+	return (nOffset + (nAlign-1)) & ~(nAlign-1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Holds a number of reader/writer locks shared until released or destroyed.
+
+class SharedLocks /*: private NotCopyable*/
+{
+public:
+	//! Default constructor.
+	SharedLocks()
+		: m_vLocks()
+	{ }
+
+	//! Destructor.
+	~SharedLocks()
+	{
+		Release();
+	}
+
+	//! Acquire a lock shared, unless the caller already holds it exclusively.
+	bool Acquire(CReadWriteLock& oLock)
+	{
+		m_vLocks.push_back(&oLock);
+
+		if (oLock.AcquireShared())
+			return true;
+
+		m_vLocks.pop_back();
+
+		return false;
+	}
+
+	//! Release the last lock acquired.
+	void ReleaseLast()
+	{
+		ASSERT(!m_vLocks.empty());
+
+		m_vLocks.back()->ReleaseShared();
+		m_vLocks.pop_back();
+	}
+
+	//! Release all the locks.
+	void Release()
+	{
+		while (!m_vLocks.empty())
+			ReleaseLast();
+	}
+
+private:
+	//
+	// Members.
+	//
+	std::vector<CReadWriteLock*> m_vLocks;	//!< The locks held.
+
+	// NotCopyable.
+	SharedLocks(const SharedLocks&);
+	SharedLocks& operator=(const SharedLocks&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! A simple buffered writer for the snapshot file.
+
+class FileWriter /*: private NotCopyable*/
+{
+public:
+	//! Constructor.
+	FileWriter(const tchar* pszFile)
+		: m_strPath(pszFile)
+		, m_hFile(::CreateFile(pszFile, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL))
+		, m_vBuffer()
+		, m_nOffset(0)
+		, m_pChecksums(nullptr)
+		, m_nCrc(0)
+		, m_nBlockUsed(0)
+	{
+		if (m_hFile == INVALID_HANDLE_VALUE)
+			throw CMDBException(CMDBException::E_SNAPSHOT_IO, Core::fmt(TXT("Failed to create '%s'"), pszFile).c_str());
+
+		m_vBuffer.reserve(WRITE_BUFFER_SIZE);
+	}
+
+	//! Constructor for writing to an existing file, starting at an offset. The
+	//! file can be written to by other writers at the same time. If a checksum
+	//! list is provided the checksum of each CHECKSUM_BLOCK bytes written is
+	//! appended to it.
+	FileWriter(const tchar* pszFile, uint64 nOffset, std::vector<uint32>* pChecksums = nullptr)
+		: m_strPath(pszFile)
+		, m_hFile(::CreateFile(pszFile, GENERIC_WRITE, FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL))
+		, m_vBuffer()
+		, m_nOffset(nOffset)
+		, m_pChecksums(pChecksums)
+		, m_nCrc(0)
+		, m_nBlockUsed(0)
+	{
+		if (m_hFile == INVALID_HANDLE_VALUE)
+			throw CMDBException(CMDBException::E_SNAPSHOT_IO, Core::fmt(TXT("Failed to open '%s'"), pszFile).c_str());
+
+		Seek(nOffset);
+
+		m_vBuffer.reserve(WRITE_BUFFER_SIZE);
+	}
+
+	//! Destructor.
+	~FileWriter()
+	{
+		if (m_hFile != INVALID_HANDLE_VALUE)
+			::CloseHandle(m_hFile);
+	}
+
+	//! Get the current file offset.
+	uint64 Offset() const
+	{
+		return m_nOffset;
+	}
+
+	//! Append a block of data.
+	void Write(const void* pData, size_t nBytes)
+	{
+		const byte* pBytes = static_cast<const byte*>(pData);
+
+		if (m_pChecksums != nullptr)
+			Checksum(pBytes, nBytes);
+
+		if ((m_vBuffer.size() + nBytes) > WRITE_BUFFER_SIZE)
+			Flush();
+
+		if (nBytes >= WRITE_BUFFER_SIZE)
+			WriteRaw(pBytes, nBytes);
+		else
+			m_vBuffer.insert(m_vBuffer.end(), pBytes, pBytes + nBytes);
+
+		m_nOffset += nBytes;
+	}
+
+	//! Pad the file with zeroes up to the given offset.
+	void PadTo(uint64 nOffset)
+	{
+		ASSERT(nOffset >= m_nOffset);
+
+		const byte abZeroes[256] = { 0 };
+
+		while (m_nOffset < nOffset)
+		{
+			size_t nBytes = static_cast<size_t>(std::min<uint64>(nOffset - m_nOffset, sizeof(abZeroes)));
+
+			Write(abZeroes, nBytes);
+		}
+	}
+
+	//! Write any buffered data and set the size of the file. Any part of the
+	//! file that has not been written reads as zeroes.
+	void SetSize(uint64 nSize)
+	{
+		Flush();
+		Seek(nSize);
+
+		if (!::SetEndOfFile(m_hFile))
+			throw CMDBException(CMDBException::E_SNAPSHOT_IO, Core::fmt(TXT("Failed to resize '%s'"), m_strPath.c_str()).c_str());
+
+		m_nOffset = nSize;
+	}
+
+	//! Write any buffered data and close the file.
+	void Close()
+	{
+		Flush();
+
+		// Finish the last partial block.
+		if ( (m_pChecksums != nullptr) && (m_nBlockUsed != 0) )
+			m_pChecksums->push_back(m_nCrc);
+
+		::CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+
+private:
+	//
+	// Members.
+	//
+	CString				m_strPath;		//!< The file path.
+	HANDLE				m_hFile;		//!< The file handle.
+	std::vector<byte>	m_vBuffer;		//!< The write buffer.
+	uint64				m_nOffset;		//!< The logical file offset.
+	std::vector<uint32>* m_pChecksums;	//!< The block checksums, if required.
+	uint32				m_nCrc;			//!< The checksum of the current block.
+	size_t				m_nBlockUsed;	//!< The bytes written to the current block.
+
+	//! Add the data to the block checksums.
+	void Checksum(const byte* pData, size_t nBytes)
+	{
+		while (nBytes != 0)
+		{
+			size_t nChunk = std::min<size_t>(nBytes, CSnapshot::CHECKSUM_BLOCK - m_nBlockUsed);
+
+			m_nCrc        = CCrc32c::Calculate(pData, nChunk, m_nCrc);
+			m_nBlockUsed += nChunk;
+			pData        += nChunk;
+			nBytes       -= nChunk;
+
+			if (m_nBlockUsed == CSnapshot::CHECKSUM_BLOCK)
+			{
+				m_pChecksums->push_back(m_nCrc);
+
+				m_nCrc       = 0;
+				m_nBlockUsed = 0;
+			}
+		}
+	}
+
+	//! Move the file pointer.
+	void Seek(uint64 nOffset)
+	{
+		LARGE_INTEGER liOffset;
+
+		liOffset.QuadPart = nOffset;
+
+		if (!::SetFilePointerEx(m_hFile, liOffset, nullptr, FILE_BEGIN))
+			throw CMDBException(CMDBException::E_SNAPSHOT_IO, Core::fmt(TXT("Failed to seek in '%s'"), m_strPath.c_str()).c_str());
+	}
+
+	//! Write the buffered data to the file.
+	void Flush()
+	{
+		if (!m_vBuffer.empty())
+			WriteRaw(&m_vBuffer[0], m_vBuffer.size());
+
+		m_vBuffer.clear();
+	}
+
+	//! Write the data directly to the file.
+	void WriteRaw(const byte* pData, size_t nBytes)
+	{
+		while (nBytes != 0)
+		{
+			DWORD dwChunk   = static_cast<DWORD>(std::min<size_t>(nBytes, 0x10000000));
+			DWORD dwWritten = 0;
+
+			if (!::WriteFile(m_hFile, pData, dwChunk, &dwWritten, nullptr) || (dwWritten != dwChunk))
+				throw CMDBException(CMDBException::E_SNAPSHOT_IO, Core::fmt(TXT("Failed to write to '%s'"), m_strPath.c_str()).c_str());
+
+			pData  += dwChunk;
+			nBytes -= dwChunk;
+		}
+	}
+
+	// NotCopyable.
+	FileWriter(const FileWriter&);
+	FileWriter& operator=(const FileWriter&);
+};
+
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+CSnapshot::CSnapshot(const tchar* pszFile)
+	: m_strPath(pszFile)
+	, m_hFile(INVALID_HANDLE_VALUE)
+	, m_hMapping(NULL)
+	, m_pBase(nullptr)
+	, m_nSize(0)
+	, m_pHeader(nullptr)
+	, m_pTables(nullptr)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+CSnapshot::~CSnapshot()
+{
+	Close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Open and map a snapshot file. The entire file is mapped read-only and the
+//! headers are validated before it is returned.
+
+CSnapshot::Ptr CSnapshot::Open(const tchar* pszFile)
+{
+	Ptr pSnapshot(new CSnapshot(pszFile));
+
+	// NB: Allow the file to be renamed or deleted while it is mapped.
+	pSnapshot->m_hFile = ::CreateFile(pszFile, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (pSnapshot->m_hFile == INVALID_HANDLE_VALUE)
+		throw CMDBException(CMDBException::E_SNAPSHOT_IO, Core::fmt(TXT("Failed to open '%s'"), pszFile).c_str());
+
+	LARGE_INTEGER liSize;
+
+	if (!::GetFileSizeEx(pSnapshot->m_hFile, &liSize))
+		throw CMDBException(CMDBException::E_SNAPSHOT_IO, Core::fmt(TXT("Failed to query the size of '%s'"), pszFile).c_str());
+
+	if (static_cast<uint64>(liSize.QuadPart) < sizeof(FileHeader))
+		throw CMDBException(CMDBException::E_BAD_SNAPSHOT, Core::fmt(TXT("The file '%s' is truncated"), pszFile).c_str());
+
+	pSnapshot->m_nSize    = liSize.QuadPart;
+	pSnapshot->m_hMapping = ::CreateFileMapping(pSnapshot->m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (pSnapshot->m_hMapping == NULL)
+		throw CMDBException(CMDBException::E_SNAPSHOT_IO, Core::fmt(TXT("Failed to map '%s'"), pszFile).c_str());
+
+	pSnapshot->m_pBase = static_cast<const byte*>(::MapViewOfFile(pSnapshot->m_hMapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (pSnapshot->m_pBase == nullptr)
+		throw CMDBException(CMDBException::E_SNAPSHOT_IO, Core::fmt(TXT("Failed to map a view of '%s'"), pszFile).c_str());
+
+	pSnapshot->m_pHeader = reinterpret_cast<const FileHeader*>(pSnapshot->m_pBase);
+	pSnapshot->m_pTables = reinterpret_cast<const TableHeader*>(pSnapshot->m_pBase + sizeof(FileHeader));
+
+	pSnapshot->Validate();
+
+	return pSnapshot;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Validate the file and table headers. Every section must lie within the file
+//! so that the row data can be accessed without further range checks.
+
+void CSnapshot::Validate() const
+{
+	const FileHeader& oHeader = *m_pHeader;
+
+	if (memcmp(oHeader.m_achMagic, SIGNATURE, sizeof(SIGNATURE)) != 0)
+		throw CMDBException(CMDBException::E_BAD_SNAPSHOT, Core::fmt(TXT("The file '%s' is not a snapshot"), m_strPath.c_str()).c_str());
+
+	if ( (oHeader.m_nVersion != VERSION) || (oHeader.m_nCharSize != sizeof(tchar))
+	  || (oHeader.m_nAlignment != SECTION_ALIGN) || (oHeader.m_nBlockSize != CHECKSUM_BLOCK)
+	  || (oHeader.m_nFileSize != m_nSize) )
+		throw CMDBException(CMDBException::E_BAD_SNAPSHOT, Core::fmt(TXT("The snapshot '%s' is an unsupported version or is truncated"), m_strPath.c_str()).c_str());
+
+	uint64 nSchema = sizeof(FileHeader) + (static_cast<uint64>(oHeader.m_nTables) * sizeof(TableHeader));
+
+	if (nSchema > m_nSize)
+		throw CMDBException(CMDBException::E_BAD_SNAPSHOT, Core::fmt(TXT("The snapshot '%s' directory is truncated"), m_strPath.c_str()).c_str());
+
+	uint64 nSchemaEnd = nSchema;
+
+	// Find the end of the schema.
+	for (size_t i = 0; i != oHeader.m_nTables; ++i)
+	{
+		const TableHeader& oTable = m_pTables[i];
+
+		if ( (oTable.m_nSchema != nSchemaEnd) || ((oTable.m_nSchema + (static_cast<uint64>(oTable.m_nColumns) * sizeof(ColumnHeader))) > m_nSize) )
+			throw CMDBException(CMDBException::E_BAD_SNAPSHOT, Core::fmt(TXT("The snapshot '%s' schema is corrupt"), m_strPath.c_str()).c_str());
+
+		nSchemaEnd += static_cast<uint64>(oTable.m_nColumns) * sizeof(ColumnHeader);
+	}
+
+	FileHeader oCopy = oHeader;
+
+	oCopy.m_nHeaderCrc = 0;
+
+	uint32 nCrc = CCrc32c::Calculate(&oCopy, sizeof(oCopy));
+
+	nCrc = CCrc32c::Calculate(At(sizeof(FileHeader)), static_cast<size_t>(nSchemaEnd - sizeof(FileHeader)), nCrc);
+
+	if (nCrc != oHeader.m_nHeaderCrc)
+		throw CMDBException(CMDBException::E_BAD_SNAPSHOT, Core::fmt(TXT("The snapshot '%s' header failed its checksum"), m_strPath.c_str()).c_str());
+
+	for (size_t i = 0; i != oHeader.m_nTables; ++i)
+	{
+		const TableHeader& oTable = m_pTables[i];
+
+		uint64 nNullsSize   = static_cast<uint64>(oTable.m_nRows) * oTable.m_nColumns;
+		uint64 nDataSize    = static_cast<uint64>(oTable.m_nRows) * oTable.m_nRowSize;
+		uint64 nStringsSize = static_cast<uint64>(oTable.m_nRows) * oTable.m_nStrColumns * sizeof(uint64);
+
+		bool bValid = (oTable.m_szName[MAX_NAME_LEN] == TXT('\0'))
+		           && ((oTable.m_nNulls   + nNullsSize)         <= m_nSize)
+		           && ((oTable.m_nData    + nDataSize)          <= m_nSize)
+		           && ((oTable.m_nStrings + nStringsSize)       <= m_nSize)
+		           && ((oTable.m_nHeap    + oTable.m_nHeapSize) <= m_nSize)
+		           && ((oTable.m_nHeapSize % sizeof(tchar)) == 0)
+		           && ((oTable.m_nNulls   + oTable.m_nExtent)   <= m_nSize)
+		           && ((oTable.m_nHeap    + oTable.m_nHeapSize) <= (oTable.m_nNulls + oTable.m_nExtent))
+		           && ((oTable.m_nChecksums + (BlockCount(oTable) * sizeof(uint32))) <= m_nSize);
+
+		if (!bValid)
+			throw CMDBException(CMDBException::E_BAD_SNAPSHOT, Core::fmt(TXT("The snapshot '%s' table %u is corrupt"), m_strPath.c_str(), static_cast<uint>(i)).c_str());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Release the mapping and file handles.
+
+void CSnapshot::Close()
+{
+	if (m_pBase != nullptr)
+		::UnmapViewOfFile(m_pBase);
+
+	if (m_hMapping != NULL)
+		::CloseHandle(m_hMapping);
+
+	if (m_hFile != INVALID_HANDLE_VALUE)
+		::CloseHandle(m_hFile);
+
+	m_pBase    = nullptr;
+	m_hMapping = NULL;
+	m_hFile    = INVALID_HANDLE_VALUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the header for a table by name.
+
+const CSnapshot::TableHeader* CSnapshot::FindTable(const tchar* pszName) const
+{
+	for (size_t i = 0; i != TableCount(); ++i)
+	{
+		if (tstricmp(m_pTables[i].m_szName, pszName) == 0)
+			return &m_pTables[i];
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Verify the checksums of every table. This reads the entire file and throws
+//! if any part of it is corrupt.
+
+void CSnapshot::Verify() const
+{
+	for (size_t i = 0; i != TableCount(); ++i)
+		VerifyTable(m_pTables[i]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Verify the checksums of a table's sections.
+
+void CSnapshot::VerifyTable(const TableHeader& oTable) const
+{
+	const uint32* pChecksums = reinterpret_cast<const uint32*>(At(oTable.m_nChecksums));
+	size_t        nBlocks    = BlockCount(oTable);
+
+	for (size_t b = 0; b != nBlocks; ++b)
+	{
+		uint64 nOffset = static_cast<uint64>(b) * CHECKSUM_BLOCK;
+		size_t nBytes  = static_cast<size_t>(std::min<uint64>(oTable.m_nExtent - nOffset, CHECKSUM_BLOCK));
+
+		if (CCrc32c::Calculate(At(oTable.m_nNulls + nOffset), nBytes) != pChecksums[b])
+			throw CMDBException(CMDBException::E_BAD_SNAPSHOT, Core::fmt(TXT("The table '%s' in the snapshot '%s' failed its checksum"), oTable.m_szName, m_strPath.c_str()).c_str());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The task used to read tables from a shared list.
+
+class CSnapshot::ReadTask : public CWorkerTask
+{
+public:
+	//! Default constructor.
+	ReadTask()
+		: m_pSnapshot(nullptr), m_pTables(nullptr), m_pLoaded(nullptr), m_pNext(nullptr), m_pError()
+	{ }
+
+	//! Read tables until there are none left.
+	virtual void Run()
+	{
+		for (;;)
+		{
+			size_t nTable = static_cast<size_t>(::InterlockedIncrement(m_pNext) - 1);
+
+			if (nTable >= m_pTables->size())
+				break;
+
+			try
+			{
+				m_pSnapshot->ReadRows(*(*m_pTables)[nTable]);
+
+				(*m_pLoaded)[nTable] = true;
+			}
+			catch (const CMDBException& e)
+			{
+				m_pError.reset(new CMDBException(e));
+				break;
+			}
+		}
+	}
+
+	//
+	// Members.
+	//
+	const CSnapshot*			m_pSnapshot;	//!< The snapshot.
+	const CTableSet::Tables*	m_pTables;		//!< The tables to read.
+	std::vector<byte>*			m_pLoaded;		//!< The tables that were read.
+	volatile LONG*				m_pNext;		//!< The next table to read.
+	CMDBExceptionPtr			m_pError;		//!< The first error, if one.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The task used to measure or write a single table.
+
+class CSnapshot::WriteTask : public CWorkerTask
+{
+public:
+	//! Default constructor.
+	WriteTask()
+		: m_pszFile(nullptr), m_pTable(nullptr), m_pHeader(nullptr), m_pError()
+	{ }
+
+	//! Measure the table or, once the file exists, write it.
+	virtual void Run()
+	{
+		try
+		{
+			if (m_pszFile == nullptr)
+				MeasureTable(*m_pTable, *m_pHeader);
+			else
+				WriteTable(m_pszFile, *m_pTable, *m_pHeader);
+		}
+		catch (const CMDBException& e)
+		{
+			m_pError.reset(new CMDBException(e));
+		}
+	}
+
+	//
+	// Members.
+	//
+	const tchar*				m_pszFile;		//!< The file, if writing.
+	const CTable*				m_pTable;		//!< The table.
+	TableHeader*				m_pHeader;		//!< The tables directory entry.
+	CMDBExceptionPtr			m_pError;		//!< The error, if one.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Load the table from the snapshot. The table must have the same schema as the
+//! one written. A READ_ONLY table refers to the mapped data and holds on to the
+//! snapshot, other tables are given a private copy of the data.
+
+void CSnapshot::Read(const Ptr& pSnapshot, CTable& oTable)
+{
+	// Ignore if a temporary table.
+	if (oTable.Transient())
+		return;
+
+	pSnapshot->ReadRows(oTable);
+
+	Attach(pSnapshot, oTable);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Load the tables from the snapshot concurrently. The tables are loaded in
+//! order of their foreign key dependencies, see CTableSet::DependencyLevels(),
+//! as a table's rows are checked against the tables they refer to. LAZY_LOAD
+//! tables are only loaded when first accessed, see Defer(), unless a table
+//! that is being loaded now refers to them.
+
+void CSnapshot::Read(const Ptr& pSnapshot, const CTableSet& oTables)
+{
+	CTableSet::Levels vLevels;
+
+	oTables.DependencyLevels(vLevels);
+
+	std::vector<CTableSet::Tables> vDeferred(vLevels.size());
+
+	// Separate the lazy tables, starting from those that refer to the others.
+	for (size_t l = vLevels.size(); l-- != 0; )
+	{
+		CTableSet::Tables& vTables = vLevels[l];
+		CTableSet::Tables  vEager;
+
+		for (size_t t = 0; t != vTables.size(); ++t)
+		{
+			CTable* pTable = vTables[t];
+
+			if ( (!pTable->LazyLoad()) || (IsReferenced(*pTable, vLevels, l+1)) )
+				vEager.push_back(pTable);
+			else if (!pTable->Transient())
+				vDeferred[l].push_back(pTable);
+		}
+
+		vTables.swap(vEager);
+	}
+
+	CWorkerPool&              oPool = CWorkerPool::Default();
+	std::vector<ReadTask>     vTasks(oPool.ThreadCount());
+	std::vector<CWorkerTask*> vTaskPtrs(vTasks.size());
+
+	for (size_t i = 0; i != vTasks.size(); ++i)
+	{
+		vTasks[i].m_pSnapshot = pSnapshot.get();
+		vTaskPtrs[i]          = &vTasks[i];
+	}
+
+	// For all levels.
+	for (size_t l = 0; l != vLevels.size(); ++l)
+	{
+		const CTableSet::Tables& vTables = vLevels[l];
+		std::vector<byte>        vLoaded(vTables.size(), false);
+		volatile LONG            nNext  = 0;
+		size_t                   nTasks = std::min(vTasks.size(), vTables.size());
+		CMDBExceptionPtr         pError;
+
+		for (size_t i = 0; i != nTasks; ++i)
+		{
+			vTasks[i].m_pTables = &vTables;
+			vTasks[i].m_pLoaded = &vLoaded;
+			vTasks[i].m_pNext   = &nNext;
+			vTasks[i].m_pError.reset();
+		}
+
+		try
+		{
+			if (nTasks != 0)
+				oPool.Execute(&vTaskPtrs[0], nTasks);
+		}
+		catch (const CMDBException& e)
+		{
+			pError.reset(new CMDBException(e));
+		}
+
+		// NB: Done serially as the snapshot reference count isn't thread-safe.
+		for (size_t t = 0; t != vTables.size(); ++t)
+		{
+			if (vLoaded[t])
+				Attach(pSnapshot, *vTables[t]);
+		}
+
+		for (size_t i = 0; (i != nTasks) && (pError.get() == nullptr); ++i)
+			pError = vTasks[i].m_pError;
+
+		try
+		{
+			for (size_t t = 0; (t != vDeferred[l].size()) && (pError.get() == nullptr); ++t)
+				Defer(pSnapshot, *vDeferred[l][t]);
+		}
+		catch (const CMDBException& e)
+		{
+			pError.reset(new CMDBException(e));
+		}
+
+		if (pError.get() != nullptr)
+			throw CMDBException(*pError);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the header for a table and check that the schema matches the one the
+//! table was written with.
+
+const CSnapshot::TableHeader& CSnapshot::CheckSchema(const CTable& oTable) const
+{
+	const TableHeader* pHeader = FindTable(oTable.Name());
+
+	if (pHeader == nullptr)
+		throw CMDBException(CMDBException::E_BAD_SNAPSHOT, Core::fmt(TXT("The table '%s' is not in the snapshot '%s'"), oTable.Name().c_str(), m_strPath.c_str()).c_str());
+
+	size_t              nColumns    = oTable.ColumnCount();
+	size_t              nStrColumns = 0;
+	const ColumnHeader* pColumns    = Columns(*pHeader);
+
+	if (pHeader->m_nColumns != nColumns)
+		throw CMDBException(CMDBException::E_BAD_SNAPSHOT, Core::fmt(TXT("The table '%s' in the snapshot '%s' has a different number of columns"), oTable.Name().c_str(), m_strPath.c_str()).c_str());
+
+	for (size_t c = 0; c != nColumns; ++c)
+	{
+		const CColumn&      oColumn = oTable.Column(c);
+		const ColumnHeader& oSchema = pColumns[c];
+
+		if ( (oSchema.m_szName[MAX_NAME_LEN] != TXT('\0')) || (tstricmp(oSchema.m_szName, oColumn.Name()) != 0)
+		  || (oSchema.m_eType != static_cast<uint32>(oColumn.ColType())) || (oSchema.m_nLength != oColumn.Length())
+		  || (oSchema.m_nAllocSize != oColumn.AllocSize()) )
+			throw CMDBException(CMDBException::E_BAD_SNAPSHOT, Core::fmt(TXT("The column '%s.%s' in the snapshot '%s' has a different definition"), oTable.Name().c_str(), oColumn.Name().c_str(), m_strPath.c_str()).c_str());
+
+		if (oColumn.ColType() == MDCT_VARSTR)
+			++nStrColumns;
+	}
+
+	if ( (pHeader->m_nStrColumns != nStrColumns) || (pHeader->m_nRowSize != oTable.m_vColumns.AllocSize()) )
+		throw CMDBException(CMDBException::E_BAD_SNAPSHOT, Core::fmt(TXT("The table '%s' in the snapshot '%s' has a different schema"), oTable.Name().c_str(), m_strPath.c_str()).c_str());
+
+	return *pHeader;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Load the tables rows from the snapshot, replacing any existing ones. This
+//! does not hold on to the snapshot for a READ_ONLY table, see Attach().
+
+void CSnapshot::ReadRows(CTable& oTable) const
+{
+	// Ignore if a temporary table.
+	if (oTable.Transient())
+		return;
+
+	const TableHeader* pHeader     = &CheckSchema(oTable);
+	size_t             nColumns    = oTable.ColumnCount();
+	size_t             nStrColumns = pHeader->m_nStrColumns;
+
+	VerifyTable(*pHeader);
+
+	CReadWriteLock::WriteGuard oGuard(oTable.m_oLock, oTable.Concurrent());
+
+	// Remove all existing rows.
+	oTable.ReleaseRows();
+
+	size_t nRows     = pHeader->m_nRows;
+	size_t nRowSize  = pHeader->m_nRowSize;
+	size_t nHeapLen  = static_cast<size_t>(pHeader->m_nHeapSize / sizeof(tchar));
+	bool   bMapped   = oTable.ReadOnly();
+
+	const bool*   pNulls   = reinterpret_cast<const bool*>(At(pHeader->m_nNulls));
+	const byte*   pData    = At(pHeader->m_nData);
+	const uint64* pOffsets = reinterpret_cast<const uint64*>(At(pHeader->m_nStrings));
+	const tchar*  pHeap    = reinterpret_cast<const tchar*>(At(pHeader->m_nHeap));
+
+	// The heap must be terminated to be safe to use in place.
+	if ( (nHeapLen != 0) && (pHeap[nHeapLen-1] != TXT('\0')) )
+		throw CMDBException(CMDBException::E_BAD_SNAPSHOT, Core::fmt(TXT("The table '%s' in the snapshot '%s' is corrupt"), oTable.Name().c_str(), m_strPath.c_str()).c_str());
+
+	// Prepare any indexes.
+	for (size_t c = 0; c != nColumns; ++c)
+	{
+		CIndex* pIndex = oTable.m_vColumns[c].Index();
+
+		if (pIndex != nullptr)
+			pIndex->Capacity(nRows);
+	}
+
+	std::vector<const tchar*> vStrings(nStrColumns);
+
+	try
+	{
+		for (size_t r = 0; r != nRows; ++r)
+		{
+			// Resolve the string values.
+			for (size_t s = 0; s != nStrColumns; ++s)
+			{
+				uint64 nOffset = pOffsets[(r * nStrColumns) + s];
+
+				if (nOffset >= nHeapLen)
+					throw CMDBException(CMDBException::E_BAD_SNAPSHOT, Core::fmt(TXT("The table '%s' in the snapshot '%s' is corrupt"), oTable.Name().c_str(), m_strPath.c_str()).c_str());
+
+				vStrings[s] = pHeap + static_cast<size_t>(nOffset);
+			}
+
+			const bool*         pRowNulls = pNulls + (r * nColumns);
+			const byte*         pRowData  = pData  + (r * nRowSize);
+			const tchar* const* ppStrings = (nStrColumns != 0) ? &vStrings[0] : nullptr;
+
+			CRow* pRow = nullptr;
+
+			if (bMapped)
+			{
+				pRow = new CRow(oTable, pRowNulls, pRowData, ppStrings);
+			}
+			else
+			{
+				pRow = &oTable.CTable::CreateRow();
+				pRow->Read(pRowNulls, pRowData, ppStrings);
+			}
+
+#ifdef _DEBUG
+			// Check row nulls and fkeys.
+			oTable.CheckRow(*pRow, false);
+#endif //_DEBUG
+
+			oTable.m_vRows.Add(*pRow);
+			oTable.TrackVersion(*pRow);
+
+			// Update any indexes.
+			for (size_t c = 0; c != nColumns; ++c)
+			{
+				CIndex* pIndex = oTable.m_vColumns[c].Index();
+
+				if (pIndex != nullptr)
+					pIndex->AddRow(*pRow);
+			}
+		}
+	}
+	catch (...)
+	{
+		// Discard the partially loaded rows. They may have been found
+		// without the lock, so they're unlinked and retired, but first copied
+		// out of the mapping as it isn't kept alive, as Detach() does.
+		oTable.TruncateIndexes();
+
+		for (size_t r = 0; r != oTable.m_vRows.Count(); ++r)
+		{
+			CRow& oRow = oTable.m_vRows[r];
+
+			if (oRow.Mapped())
+				oRow.Unmap();
+
+			oTable.FreeRow(oRow);
+		}
+
+		oTable.m_vRows.RemoveAll();
+		throw;
+	}
+
+#ifdef _DEBUG
+	// Check index sizes.
+	oTable.CheckIndexes();
+#endif //_DEBUG
+
+	oTable.m_nIdentVal = pHeader->m_nIdentVal;
+
+	// Reset modified flags.
+	oTable.m_nInsertions = 0;
+	oTable.m_nUpdates    = 0;
+	oTable.m_nDeletions  = 0;
+	oTable.m_nRefreshes  = 0;
+	oTable.m_vDeletedKeys.DeleteAll();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//! Make a READ_ONLY table hold on to the snapshot its rows refer to and release
+//! any previous one.
+
+void CSnapshot::Attach(const Ptr& pSnapshot, CTable& oTable)
+{
+	if (oTable.ReadOnly())
+		oTable.m_pSnapshot = pSnapshot;
+	else
+		oTable.m_pSnapshot.reset();
+
+	oTable.m_pPending.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy a READ_ONLY table's rows out of the snapshot they refer to and release
+//! it. This is required before the snapshot file can be replaced.
+
+void CSnapshot::Detach(CTable& oTable)
+{
+	CReadWriteLock::WriteGuard oGuard(oTable.m_oLock, oTable.Concurrent());
+
+	for (size_t r = 0; r != oTable.m_vRows.Count(); ++r)
+	{
+		CRow& oRow = oTable.m_vRows[r];
+
+		if (oRow.Mapped())
+			oRow.Unmap();
+	}
+
+	oTable.ReleaseSnapshot();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Check if a table is referred to by a foreign key of one of the tables that
+//! will be loaded in the dependency levels from the one given onwards.
+
+bool CSnapshot::IsReferenced(const CTable& oTable, const CTableSet::Levels& vLevels, size_t nFirst)
+{
+	for (size_t l = nFirst; l < vLevels.size(); ++l)
+	{
+		const CTableSet::Tables& vTables = vLevels[l];
+
+		for (size_t t = 0; t != vTables.size(); ++t)
+		{
+			const CTable& oReferrer = *vTables[t];
+
+			for (size_t c = 0; c != oReferrer.ColumnCount(); ++c)
+			{
+				if (oReferrer.Column(c).FKTable() == &oTable)
+					return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard a LAZY_LOAD tables rows and defer reading the new ones until they
+//! are first accessed, see CTable::Load(). The schema is checked up front but
+//! the table's sections are not touched.
+
+void CSnapshot::Defer(const Ptr& pSnapshot, CTable& oTable)
+{
+	ASSERT(!oTable.Transient());
+
+	pSnapshot->CheckSchema(oTable);
+
+	CReadWriteLock::WriteGuard oGuard(oTable.m_oLock, oTable.Concurrent());
+
+	oTable.ReleaseRows();
+	oTable.m_pPending = pSnapshot;
+
+	// Reset modified flags.
+	oTable.m_nInsertions = 0;
+	oTable.m_nUpdates    = 0;
+	oTable.m_nDeletions  = 0;
+	oTable.m_nRefreshes  = 0;
+	oTable.m_vDeletedKeys.DeleteAll();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the tables to a snapshot file. Transient tables are skipped. The file
+//! is written under a temporary name and then renamed so that an existing
+//! snapshot is only replaced by a complete one. The tables are measured and
+//! then written concurrently, each to its own sections of the file. CONCURRENT
+//! tables are held shared from being measured until they have been written so
+//! that the rows and strings written are the ones measured.
+
+void CSnapshot::Write(const tchar* pszFile, const CTableSet& oTables)
+{
+	std::vector<CTable*>      vTables;
+	std::vector<TableHeader>  vHeaders;
+	std::vector<size_t>       vChanges;
+	SharedLocks               oLocks;
+
+	for (size_t t = 0; t != oTables.Count(); ++t)
+	{
+		if (!oTables[t].Transient())
+			vTables.push_back(&oTables[t]);
+	}
+
+	vChanges.resize(vTables.size());
+
+	// Load any deferred rows, serially as the snapshot reference count isn't thread-safe,
+	// and lock the tables. The rows are loaded again if reloaded before the lock was held.
+	for (size_t t = 0; t != vTables.size(); ++t)
+	{
+		CTable& oTable = *vTables[t];
+
+		oTable.Load();
+
+		while ( (oTable.Concurrent()) && (oLocks.Acquire(oTable.m_oLock)) && (oTable.m_pPending.get() != nullptr) )
+		{
+			oLocks.ReleaseLast();
+			oTable.Load();
+		}
+
+		vChanges[t] = ChangeCount(oTable);
+	}
+
+	vHeaders.resize(vTables.size());
+
+	std::vector<WriteTask>    vTasks(vTables.size());
+	std::vector<CWorkerTask*> vTaskPtrs(vTables.size());
+
+	for (size_t t = 0; t != vTables.size(); ++t)
+	{
+		vTasks[t].m_pTable  = vTables[t];
+		vTasks[t].m_pHeader = &vHeaders[t];
+		vTaskPtrs[t]        = &vTasks[t];
+	}
+
+	// Measure the tables.
+	ExecuteTasks(vTasks, vTaskPtrs);
+
+	std::vector<ColumnHeader> vColumns;
+	uint64                    nOffset = 0;
+
+	// Calculate the table layouts, relative to the end of the checksums.
+	for (size_t t = 0; t != vTables.size(); ++t)
+	{
+		TableHeader& oHeader = vHeaders[t];
+		uint64       nRows   = oHeader.m_nRows;
+
+		oHeader.m_nNulls   = nOffset;
+		oHeader.m_nData    = nOffset = alignUp(nOffset + (nRows * oHeader.m_nColumns));
+		oHeader.m_nStrings = nOffset = alignUp(nOffset + (nRows * oHeader.m_nRowSize));
+		oHeader.m_nHeap    = nOffset = alignUp(nOffset + (nRows * oHeader.m_nStrColumns * sizeof(uint64)));
+		nOffset = alignUp(nOffset + oHeader.m_nHeapSize);
+		oHeader.m_nExtent  = nOffset - oHeader.m_nNulls;
+
+		DescribeTable(*vTables[t], vColumns);
+	}
+
+	uint64 nSchema    = sizeof(FileHeader) + (vTables.size() * sizeof(TableHeader));
+	uint64 nChecksums = nSchema + (vColumns.size() * sizeof(ColumnHeader));
+
+	// Calculate the schema and checksum offsets.
+	for (size_t t = 0; t != vTables.size(); ++t)
+	{
+		TableHeader& oHeader = vHeaders[t];
+
+		oHeader.m_nSchema    = nSchema;
+		oHeader.m_nChecksums = nChecksums;
+
+		nSchema    += oHeader.m_nColumns * sizeof(ColumnHeader);
+		nChecksums += BlockCount(oHeader) * sizeof(uint32);
+	}
+
+	uint64 nBase = alignUp(nChecksums);
+
+	// Move the sections after the checksums.
+	for (size_t t = 0; t != vTables.size(); ++t)
+	{
+		TableHeader& oHeader = vHeaders[t];
+
+		oHeader.m_nNulls   += nBase;
+		oHeader.m_nData    += nBase;
+		oHeader.m_nStrings += nBase;
+		oHeader.m_nHeap    += nBase;
+	}
+
+	nOffset += nBase;
+
+	FileHeader oFileHeader;
+
+	memset(&oFileHeader, 0, sizeof(oFileHeader));
+	memcpy(oFileHeader.m_achMagic, SIGNATURE, sizeof(SIGNATURE));
+
+	oFileHeader.m_nVersion   = VERSION;
+	oFileHeader.m_nCharSize  = sizeof(tchar);
+	oFileHeader.m_nAlignment = SECTION_ALIGN;
+	oFileHeader.m_nTables    = static_cast<uint32>(vTables.size());
+	oFileHeader.m_nFileSize  = nOffset;
+	oFileHeader.m_nBlockSize = CHECKSUM_BLOCK;
+
+	uint32 nCrc = CCrc32c::Calculate(&oFileHeader, sizeof(oFileHeader));
+
+	if (!vHeaders.empty())
+		nCrc = CCrc32c::Calculate(&vHeaders[0], vHeaders.size() * sizeof(TableHeader), nCrc);
+
+	if (!vColumns.empty())
+		nCrc = CCrc32c::Calculate(&vColumns[0], vColumns.size() * sizeof(ColumnHeader), nCrc);
+
+	oFileHeader.m_nHeaderCrc = nCrc;
+
+	CString strTemp = CString(pszFile) + TXT(".tmp");
+
+	try
+	{
+		FileWriter oWriter(strTemp);
+
+		oWriter.Write(&oFileHeader, sizeof(oFileHeader));
+
+		if (!vHeaders.empty())
+			oWriter.Write(&vHeaders[0], vHeaders.size() * sizeof(TableHeader));
+
+		if (!vColumns.empty())
+			oWriter.Write(&vColumns[0], vColumns.size() * sizeof(ColumnHeader));
+
+		oWriter.SetSize(nOffset);
+		oWriter.Close();
+
+		// Write the table sections.
+		for (size_t t = 0; t != vTasks.size(); ++t)
+			vTasks[t].m_pszFile = strTemp;
+
+		ExecuteTasks(vTasks, vTaskPtrs);
+
+		oLocks.Release();
+
+		// Release the tables' mapping of the snapshot being replaced, and any
+		// kept for the rows retired since, once no reader can be using them.
+		for (size_t t = 0; t != vTables.size(); ++t)
+		{
+			CTable&    oTable  = *vTables[t];
+			const Ptr& pMapped = oTable.m_pSnapshot;
+
+			if ( (pMapped.get() != nullptr) && (tstricmp(pMapped->Path().c_str(), pszFile) == 0) )
+				Detach(oTable);
+
+			if (oTable.ReadOnly())
+				oTable.ReclaimAllRows();
+		}
+
+		// Replace any existing snapshot.
+		if (!::MoveFileEx(strTemp, pszFile, MOVEFILE_REPLACE_EXISTING))
+			throw CMDBException(CMDBException::E_SNAPSHOT_IO, Core::fmt(TXT("Failed to replace '%s'"), pszFile).c_str());
+	}
+	catch (...)
+	{
+		// Don't leave the incomplete snapshot behind.
+		::DeleteFile(strTemp);
+		throw;
+	}
+
+	// Reset modified flags, unless the table has been changed since it was written.
+	for (size_t t = 0; t != vTables.size(); ++t)
+	{
+		CTable&                    oTable = *vTables[t];
+		CReadWriteLock::WriteGuard oGuard(oTable.m_oLock, oTable.Concurrent());
+
+		if (ChangeCount(oTable) == vChanges[t])
+			oTable.ResetRowFlags();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Count the changes made to a table since its flags were last reset. The
+//! count only grows until then.
+
+size_t CSnapshot::ChangeCount(const CTable& oTable)
+{
+	return oTable.m_nInsertions + oTable.m_nUpdates + oTable.m_nDeletions + oTable.m_nRefreshes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Fill in the directory entry for a table, except for the section offsets.
+//! This runs on a worker whilst the caller holds the table lock, so the rows
+//! are accessed directly.
+
+void CSnapshot::MeasureTable(const CTable& oTable, TableHeader& oHeader)
+{
+	memset(&oHeader, 0, sizeof(oHeader));
+
+	if (oTable.Name().Length() > MAX_NAME_LEN)
+		throw CMDBException(CMDBException::E_SNAPSHOT_IO, Core::fmt(TXT("The table name '%s' is too long for a snapshot"), oTable.Name().c_str()).c_str());
+
+	tstrncpy(oHeader.m_szName, oTable.Name().c_str(), MAX_NAME_LEN);
+
+	const CRowSet& vRows    = oTable.m_vRows;
+	size_t         nColumns = oTable.ColumnCount();
+	size_t         nRows    = vRows.Count();
+	uint64         nHeap    = 0;
+
+	for (size_t c = 0; c != nColumns; ++c)
+	{
+		if (oTable.Column(c).ColType() != MDCT_VARSTR)
+			continue;
+
+		++oHeader.m_nStrColumns;
+
+		for (size_t r = 0; r != nRows; ++r)
+			nHeap += Core::numBytes<tchar>(tstrlen(vRows[r][c].m_pString) + 1);
+	}
+
+	oHeader.m_nColumns  = static_cast<uint32>(nColumns);
+	oHeader.m_nRowSize  = static_cast<uint32>(oTable.m_vColumns.AllocSize());
+	oHeader.m_nRows     = static_cast<uint32>(nRows);
+	oHeader.m_nIdentVal = oTable.m_nIdentVal;
+	oHeader.m_nHeapSize = nHeap;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append the schema entries for a table's columns.
+
+void CSnapshot::DescribeTable(const CTable& oTable, std::vector<ColumnHeader>& vColumns)
+{
+	for (size_t c = 0; c != oTable.ColumnCount(); ++c)
+	{
+		const CColumn& oColumn = oTable.Column(c);
+		ColumnHeader   oHeader;
+
+		memset(&oHeader, 0, sizeof(oHeader));
+
+		if (oColumn.Name().Length() > MAX_NAME_LEN)
+			throw CMDBException(CMDBException::E_SNAPSHOT_IO, Core::fmt(TXT("The column name '%s' is too long for a snapshot"), oColumn.Name().c_str()).c_str());
+
+		tstrncpy(oHeader.m_szName, oColumn.Name().c_str(), MAX_NAME_LEN);
+
+		oHeader.m_eType      = static_cast<uint32>(oColumn.ColType());
+		oHeader.m_nLength    = static_cast<uint32>(oColumn.Length());
+		oHeader.m_nAllocSize = static_cast<uint32>(oColumn.AllocSize());
+		oHeader.m_nFlags     = static_cast<uint32>(oColumn.Flags());
+
+		vColumns.push_back(oHeader);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a tables sections to the file, followed by their checksums. Like
+//! MeasureTable() the rows are accessed directly.
+
+void CSnapshot::WriteTable(const tchar* pszFile, const CTable& oTable, const TableHeader& oHeader)
+{
+	const CRowSet&      vRows    = oTable.m_vRows;
+	size_t              nColumns = oHeader.m_nColumns;
+	size_t              nRows    = oHeader.m_nRows;
+	std::vector<uint32> vChecksums;
+	FileWriter          oWriter(pszFile, oHeader.m_nNulls, &vChecksums);
+
+	for (size_t r = 0; r != nRows; ++r)
+	{
+		for (size_t c = 0; c != nColumns; ++c)
+			oWriter.Write(&vRows[r][c].m_bNull, sizeof(bool));
+	}
+
+	oWriter.PadTo(oHeader.m_nData);
+
+	for (size_t r = 0; r != nRows; ++r)
+	{
+		const CRow& oRow = vRows[r];
+
+		// Data in a snapshot mapping is only reachable a field at a time.
+		if (oRow.m_bMapped)
+		{
+			for (size_t c = 0; c != nColumns; ++c)
+			{
+				size_t nAllocSize = oTable.Column(c).AllocSize();
+
+				if (nAllocSize != 0)
+					oWriter.Write(oRow.m_aFields[c].m_pVoidPtr, nAllocSize);
+			}
+		}
+		else
+		{
+			oWriter.Write(oRow.m_aFields + oRow.m_nColumns, oHeader.m_nRowSize);
+		}
+	}
+
+	oWriter.PadTo(oHeader.m_nStrings);
+
+	uint64 nHeapOffset = 0;
+
+	for (size_t r = 0; r != nRows; ++r)
+	{
+		for (size_t c = 0; c != nColumns; ++c)
+		{
+			if (oTable.Column(c).ColType() != MDCT_VARSTR)
+				continue;
+
+			oWriter.Write(&nHeapOffset, sizeof(nHeapOffset));
+
+			nHeapOffset += tstrlen(vRows[r][c].m_pString) + 1;
+		}
+	}
+
+	oWriter.PadTo(oHeader.m_nHeap);
+
+	for (size_t r = 0; r != nRows; ++r)
+	{
+		for (size_t c = 0; c != nColumns; ++c)
+		{
+			if (oTable.Column(c).ColType() != MDCT_VARSTR)
+				continue;
+
+			const tchar* pszValue = vRows[r][c].m_pString;
+
+			oWriter.Write(pszValue, Core::numBytes<tchar>(tstrlen(pszValue) + 1));
+		}
+	}
+
+	oWriter.PadTo(oHeader.m_nNulls + oHeader.m_nExtent);
+	oWriter.Close();
+
+	ASSERT(vChecksums.size() == BlockCount(oHeader));
+
+	if (vChecksums.empty())
+		return;
+
+	FileWriter oChecksums(pszFile, oHeader.m_nChecksums);
+
+	oChecksums.Write(&vChecksums[0], vChecksums.size() * sizeof(uint32));
+	oChecksums.Close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Execute the write tasks and throw the first error, if any.
+
+void CSnapshot::ExecuteTasks(std::vector<WriteTask>& vTasks, std::vector<CWorkerTask*>& vTaskPtrs)
+{
+	if (vTasks.empty())
+		return;
+
+	CWorkerPool::Default().Execute(&vTaskPtrs[0], vTaskPtrs.size());
+
+	for (size_t t = 0; t != vTasks.size(); ++t)
+	{
+		if (vTasks[t].m_pError.get() != nullptr)
+			throw CMDBException(*vTasks[t].m_pError);
+	}
+}
@@ -0,0 +1,285 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Snapshot.hpp
+//! \brief  The CSnapshot class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_SNAPSHOT_HPP
+#define MDBL_SNAPSHOT_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "FwdDecls.hpp"
+#include <vector>
+
+class CTableSet;
+class CWorkerTask;
+
+////////////////////////////////////////////////////////////////////////////////
+//! A memory-mapped database snapshot file. Unlike the stream format, which is
+//! written and read row by row, each table is stored as a set of page-aligned
+//! sections that mirror the in-memory row layout:
+//!
+//!   - the NULL flags, one byte per field,
+//!   - the fixed-width data region of every row, stored contiguously,
+//!   - the offsets of each MDCT_VARSTR value within the string heap,
+//!   - the string heap itself.
+//!
+//! The file is self-describing. The header is followed by a directory entry
+//! per table, which holds the section offsets, then the column schema of each
+//! table and finally the CRC-32C checksums of each table's sections, taken in
+//! blocks of CHECKSUM_BLOCK bytes. The header, directory and schema are also
+//! covered by a checksum and are validated when the file is opened, whereas a
+//! table's blocks are only verified when it is loaded, or by Verify(). This
+//! means that a subset of the tables can be loaded, see Read(), by touching
+//! only the pages that belong to them.
+//!
+//! When a snapshot is read into a READ_ONLY table the rows refer directly to
+//! the mapped data instead of copying it and the table keeps the mapping alive
+//! until its rows are discarded. Indexes are rebuilt from the rows on load.
+//! The format is native to the build, i.e. it records the character size and
+//! a file written by an ANSI build cannot be read by a Unicode one.
+
+class CSnapshot /*: private NotCopyable*/
+{
+public:
+	//! The default smart pointer type.
+	typedef Core::SharedPtr<CSnapshot> Ptr;
+
+	//! The maximum length of a table name.
+	static const size_t MAX_NAME_LEN = 63;
+
+	//! The header at the start of the file.
+	struct FileHeader
+	{
+		char		m_achMagic[8];		//!< The file signature.
+		uint32		m_nVersion;			//!< The format version.
+		uint32		m_nCharSize;		//!< The size of a tchar.
+		uint32		m_nAlignment;		//!< The section alignment.
+		uint32		m_nTables;			//!< The number of tables.
+		uint64		m_nFileSize;		//!< The total file size.
+		uint32		m_nBlockSize;		//!< The size of a checksum block.
+		uint32		m_nHeaderCrc;		//!< The checksum of the header, directory and schema.
+	};
+
+	//! The directory entry for a table.
+	struct TableHeader
+	{
+		tchar		m_szName[MAX_NAME_LEN+1];	//!< The table name.
+		uint32		m_nColumns;			//!< The number of columns.
+		uint32		m_nStrColumns;		//!< The number of MDCT_VARSTR columns.
+		uint32		m_nRowSize;			//!< The size of a rows data region.
+		uint32		m_nRows;			//!< The number of rows.
+		int32		m_nIdentVal;		//!< The next identity value.
+		uint32		m_nReserved;		//!< Unused.
+		uint64		m_nNulls;			//!< The offset of the NULL flags.
+		uint64		m_nData;			//!< The offset of the data region.
+		uint64		m_nStrings;			//!< The offset of the string offsets.
+		uint64		m_nHeap;			//!< The offset of the string heap.
+		uint64		m_nHeapSize;		//!< The size of the string heap.
+		uint64		m_nExtent;			//!< The size of all the sections.
+		uint64		m_nSchema;			//!< The offset of the column schema.
+		uint64		m_nChecksums;		//!< The offset of the block checksums.
+	};
+
+	//! The schema entry for a column.
+	struct ColumnHeader
+	{
+		tchar		m_szName[MAX_NAME_LEN+1];	//!< The column name.
+		uint32		m_eType;			//!< The column type.
+		uint32		m_nLength;			//!< The column length.
+		uint32		m_nAllocSize;		//!< The size of the value in the data region.
+		uint32		m_nFlags;			//!< The column flags.
+	};
+
+	//! Destructor.
+	~CSnapshot();
+
+	//
+	// Properties.
+	//
+
+	//! Get the path of the file.
+	const CString& Path() const;
+
+	//! Get the number of tables in the snapshot.
+	size_t TableCount() const;
+
+	//! Get a table header by index.
+	const TableHeader& Table(size_t n) const;
+
+	//! Get the column schema for a table.
+	const ColumnHeader* Columns(const TableHeader& oTable) const;
+
+	//
+	// Methods.
+	//
+
+	//! Find the header for a table by name.
+	const TableHeader* FindTable(const tchar* pszName) const;
+
+	//! Verify the checksums of every table.
+	void Verify() const;
+
+	//! Load the table from the snapshot.
+	static void Read(const Ptr& pSnapshot, CTable& oTable);
+
+	//! Load the tables from the snapshot concurrently.
+	static void Read(const Ptr& pSnapshot, const CTableSet& oTables);
+
+	//
+	// Class methods.
+	//
+
+	//! Open and map a snapshot file.
+	static Ptr Open(const tchar* pszFile);
+
+	//! Write the tables to a snapshot file.
+	static void Write(const tchar* pszFile, const CTableSet& oTables);
+
+	//! The format version.
+	static const uint32 VERSION = 2;
+
+	//! The section alignment.
+	static const uint32 SECTION_ALIGN = 4096;
+
+	//! The size of a checksummed block of table data.
+	static const uint32 CHECKSUM_BLOCK = 64 * 1024;
+
+	//! Get the number of checksum blocks for a table.
+	static size_t BlockCount(const TableHeader& oTable);
+
+private:
+	//! The task used to read tables concurrently.
+	class ReadTask;
+
+	//! The task used to write tables concurrently.
+	class WriteTask;
+
+	//
+	// Members.
+	//
+	CString				m_strPath;		//!< The path of the file.
+	HANDLE				m_hFile;		//!< The file handle.
+	HANDLE				m_hMapping;		//!< The file mapping handle.
+	const byte*			m_pBase;		//!< The start of the mapped view.
+	uint64				m_nSize;		//!< The size of the mapped view.
+	const FileHeader*	m_pHeader;		//!< The file header.
+	const TableHeader*	m_pTables;		//!< The table directory.
+
+	//! Constructor.
+	CSnapshot(const tchar* pszFile);
+
+	//
+	// Internal methods.
+	//
+
+	//! Get a pointer to a location in the file.
+	const byte* At(uint64 nOffset) const;
+
+	//! Validate the file and table headers.
+	void Validate() const;
+
+	//! Verify the checksums of a table's sections.
+	void VerifyTable(const TableHeader& oTable) const;
+
+	//! Release the mapping and file handles.
+	void Close();
+
+	//! Find the header for a table and check its schema.
+	const TableHeader& CheckSchema(const CTable& oTable) const;
+
+	//! Load the tables rows from the snapshot.
+	void ReadRows(CTable& oTable) const;
+
+	//! Make a READ_ONLY table hold on to the snapshot.
+	static void Attach(const Ptr& pSnapshot, CTable& oTable);
+
+	//! Copy a READ_ONLY table's rows out of the snapshot and release it.
+	static void Detach(CTable& oTable);
+
+	//! Check if a table is referred to by those in the later dependency levels.
+	static bool IsReferenced(const CTable& oTable, const std::vector< std::vector<CTable*> >& vLevels, size_t nFirst);
+
+	//! Defer loading a LAZY_LOAD table until it is first accessed.
+	static void Defer(const Ptr& pSnapshot, CTable& oTable);
+
+	//! Fill in the directory entry for a table.
+	static void MeasureTable(const CTable& oTable, TableHeader& oHeader);
+
+	//! Fill in the schema entries for a table.
+	static void DescribeTable(const CTable& oTable, std::vector<ColumnHeader>& vColumns);
+
+	//! Write a tables sections to the file.
+	static void WriteTable(const tchar* pszFile, const CTable& oTable, const TableHeader& oHeader);
+
+	//! Count the changes made to a table since its flags were last reset.
+	static size_t ChangeCount(const CTable& oTable);
+
+	//! Execute the write tasks and throw the first error, if any.
+	static void ExecuteTasks(std::vector<WriteTask>& vTasks, std::vector<CWorkerTask*>& vTaskPtrs);
+
+private:
+	// NotCopyable.
+	CSnapshot(const CSnapshot&);
+	CSnapshot& operator=(const CSnapshot&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the path of the file.
+
+inline const CString& CSnapshot::Path() const
+{
+	return m_strPath;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of tables in the snapshot.
+
+inline size_t CSnapshot::TableCount() const
+{
+	return m_pHeader->m_nTables;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get a table header by index.
+
+inline const CSnapshot::TableHeader& CSnapshot::Table(size_t n) const
+{
+	ASSERT(n < TableCount());
+
+	return m_pTables[n];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the column schema for a table.
+
+inline const CSnapshot::ColumnHeader* CSnapshot::Columns(const TableHeader& oTable) const
+{
+	return reinterpret_cast<const ColumnHeader*>(At(oTable.m_nSchema));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of checksum blocks for a table.
+
+inline size_t CSnapshot::BlockCount(const TableHeader& oTable)
+{
+	return static_cast<size_t>((oTable.m_nExtent + (CHECKSUM_BLOCK-1)) / CHECKSUM_BLOCK);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get a pointer to a location in the file.
+
+inline const byte* CSnapshot::At(uint64 nOffset) const
+{
+	ASSERT(nOffset <= m_nSize);
+
+	return m_pBase + static_cast<size_t>(nOffset);
+}
+
+//! The default CSnapshot smart pointer type.
+typedef CSnapshot::Ptr CSnapshotPtr;
+
+#endif // MDBL_SNAPSHOT_HPP
@@ -26,6 +26,7 @@
 CStrMapIndex::CStrMapIndex(CTable& oTable, size_t nColumn)
 	: CUniqIndex(oTable, nColumn)
 	, m_oMap()
+	, m_nKeyBytes(0)
 {
 	ASSERT(m_oTable.Column(m_nColumn).Unique());
 }
@@ -49,6 +49,8 @@ public:
 
 	virtual void Capacity(size_t nRows);
 
+	virtual size_t MemoryUsage() const;
+
 protected:
 	//! The underlying collection type.
 	typedef std::map<CString, CRow*> StrRowMap;
@@ -57,6 +59,7 @@ protected:
 	// Members.
 	//
 	StrRowMap	m_oMap;
+	size_t		m_nKeyBytes;	// The size of the key strings.
 };
 
 /******************************************************************************
@@ -75,17 +78,24 @@ inline void CStrMapIndex::AddRow(CRow& oRow)
 {
 	ASSERT(FindRow(oRow[m_nColumn].ToValue()) == nullptr);
 
-	m_oMap[oRow[m_nColumn].GetString()] = &oRow;
+	const tchar* pszKey = oRow[m_nColumn].GetString();
+
+	m_oMap[pszKey] = &oRow;
+	m_nKeyBytes += Core::numBytes<tchar>(tstrlen(pszKey)+1);
 }
 
 inline void CStrMapIndex::RemoveRow(CRow& oRow)
 {
-	m_oMap.erase(oRow[m_nColumn].GetString());
+	const tchar* pszKey = oRow[m_nColumn].GetString();
+
+	if (m_oMap.erase(pszKey) != 0)
+		m_nKeyBytes -= Core::numBytes<tchar>(tstrlen(pszKey)+1);
 }
 
 inline void CStrMapIndex::Truncate()
 {
 	m_oMap.clear();
+	m_nKeyBytes = 0;
 }
 
 inline CRow* CStrMapIndex::FindRow(const tchar* strKey) const
@@ -117,4 +127,9 @@ inline void CStrMapIndex::Capacity(size_t /*nRows*/)
 	// std::map<> does not optimise based on expected size.
 }
 
+inline size_t CStrMapIndex::MemoryUsage() const
+{
+	return m_oMap.size() * (sizeof(StrRowMap::value_type) + MAP_NODE_SIZE) + m_nKeyBytes;
+}
+
 #endif //STRMAPINDEX_HPP
@@ -12,7 +12,16 @@
 #include "TimeStamp.hpp"
 #include "IntMapIndex.hpp"
 #include "StrMapIndex.hpp"
+#include "HashIndex.hpp"
 #include "Where.hpp"
+#include "RowCursor.hpp"
+#include "ChangeLog.hpp"
+#include "BackgroundSnapshot.hpp"
+#include "MDBException.hpp"
+#include "RowBlock.hpp"
+#include "WorkerPool.hpp"
+#include "VersionStore.hpp"
+#include "Trace.hpp"
 #include <WCL/IInputStream.hpp>
 #include <WCL/IOutputStream.hpp>
 #include "SQLSource.hpp"
@@ -21,13 +30,138 @@
 #include "SQLParams.hpp"
 #include "ODBCException.hpp"
 #include <malloc.h>
+#include <Core/UniquePtr.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+
+//! Serialises loading the deferred rows of concurrent tables, see LoadPending().
+CReadWriteLock s_oLoadLock;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a row key to a delta. Key columns are either integers or strings.
+
+void writeDeltaKey(WCL::IOutputStream& rStream, const CValue& oKey)
+{
+	if (oKey.m_eType == MDST_INT)
+	{
+		rStream.Write(&oKey.m_iValue, sizeof(oKey.m_iValue));
+	}
+	else
+	{
+		ASSERT(oKey.m_eType == MDST_STRING);
+
+		size_t nChars = tstrlen(oKey.m_sValue);
+
+		rStream.Write(&nChars, sizeof(size_t));
+		rStream.Write(oKey.m_sValue, Core::numBytes<tchar>(nChars));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a row key from a delta.
+
+CValue readDeltaKey(WCL::IInputStream& rStream, STGTYPE eType)
+{
+	if (eType == MDST_INT)
+	{
+		int nValue;
+
+		rStream.Read(&nValue, sizeof(nValue));
+
+		return CValue(nValue);
+	}
+
+	ASSERT(eType == MDST_STRING);
+
+	size_t nChars;
+
+	rStream.Read(&nChars, sizeof(size_t));
+
+	std::vector<tchar> vValue(nChars+1);
+
+	rStream.Read(&vValue[0], Core::numBytes<tchar>(nChars));
+	vValue[nChars] = TXT('\0');
+
+	return CValue(&vValue[0]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the row for a key read from a delta. The delta must have been written
+//! from the same rows and so a missing row is an error.
+
+CRow& findDeltaRow(const CTable& oTable, size_t nKey, const CValue& oKey)
+{
+	CRow* pRow = oTable.SelectRow(nKey, oKey);
+
+	if (pRow == nullptr)
+		throw CMDBException(CMDBException::E_BAD_DELTA, Core::fmt(TXT("The table '%s' has no row for a key in the delta"), oTable.Name().c_str()).c_str());
+
+	return *pRow;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove a row from all the tables indexes.
+
+void removeFromIndexes(const CTable& oTable, CRow& oRow)
+{
+	for (size_t i = 0; i < oTable.ColumnCount(); ++i)
+	{
+		CIndex* pIndex = oTable.Column(i).Index();
+
+		if (pIndex != nullptr)
+			pIndex->RemoveRow(oRow);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add to a memory usage counter, which may be updated by multiple threads.
+
+void addBytes(volatile LONG_PTR& nCounter, ptrdiff_t nBytes)
+{
+#ifdef _WIN64
+	::InterlockedExchangeAdd64(&nCounter, nBytes);
+#else
+	::InterlockedExchangeAdd(&nCounter, nBytes);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a row to all the tables indexes.
+
+void addToIndexes(const CTable& oTable, CRow& oRow)
+{
+	for (size_t i = 0; i < oTable.ColumnCount(); ++i)
+	{
+		CIndex* pIndex = oTable.Column(i).Index();
+
+		if (pIndex != nullptr)
+			pIndex->AddRow(oRow);
+	}
+}
+
+}
 
 /******************************************************************************
 ** Method:		Constructor.
 **
-** Description:	.
+** Description:	A CONCURRENT table can be queried by many threads at once,
+**				whilst insertions, deletions and field updates are serialised
+**				with them by a reader/writer lock. The lock covers the rows,
+**				indexes and counters for the duration of each call only, so
+**				rows returned must not be deleted whilst still in use, the
+**				cursor from Query() must not be iterated during a write and
+**				the schema must not change whilst the table is shared. The
+**				unique columns use a CHashIndex so that SelectRow() does not
+**				need the lock at all.
 **
-** Parameters:	None.
+**				A QUERY_STATS table keeps running totals of the queries made
+**				on it, see Statistics().
+**
+** Parameters:	pszName		The table name.
+**				nFlags		The table type flags.
 **
 ** Returns:		Nothing.
 **
@@ -37,18 +171,36 @@
 CTable::CTable(const tchar* pszName, uint nFlags)
 	: m_strName(pszName)
 	, m_nFlags(nFlags)
+	, m_nDataBytes(0)
+	, m_nFieldBytes(0)
+	, m_nStringBytes(0)
 	, m_vColumns()
 	, m_vRows()
 	, m_nInsertions(0)
 	, m_nUpdates(0)
 	, m_nDeletions(0)
+	, m_nRefreshes(0)
 	, m_nIdentCol(Core::npos)
 	, m_nIdentVal(0)
+	, m_nVersionCol(Core::npos)
+	, m_nMaxVersion(std::numeric_limits<int64>::min())
+	, m_bMaxVersion(true)
 	, m_pNullRow(nullptr)
 	, m_strSQLTable()
 	, m_strSQLWhere()
 	, m_strSQLGroup()
 	, m_strSQLOrder()
+	, m_pSnapshot()
+	, m_pPending()
+	, m_pChangeLog(nullptr)
+	, m_vDeletedKeys()
+	, m_pBackground(nullptr)
+	, m_oLock()
+	, m_pVersions(nullptr)
+	, m_oStats()
+	, m_oReaders()
+	, m_vRetired()
+	, m_vRetiredSnapshots()
 {
 	ASSERT(pszName != nullptr);
 }
@@ -67,6 +219,12 @@ CTable::CTable(const tchar* pszName, uint nFlags)
 
 CTable::~CTable()
 {
+	if (m_pVersions != nullptr)
+		m_pVersions->Detach(*this);
+
+	for (size_t i = 0; i != m_vRetired.size(); ++i)
+		delete m_vRetired[i].first;
+
 	delete m_pNullRow;
 }
 
@@ -130,6 +288,8 @@ size_t CTable::AddColumn(const tchar* pszName, COLTYPE eType, size_t nLength, ui
 	ASSERT(m_vRows.Count() == 0);
 	ASSERT(!((eType == MDCT_IDENTITY) && (m_nIdentCol != Core::npos)));
 	ASSERT(!((eType == MDCT_IDENTITY) && (nFlags & CColumn::NULLABLE)));
+	ASSERT(!((nFlags & CColumn::ROW_VERSION) && (m_nVersionCol != Core::npos)));
+	ASSERT(!((nFlags & CColumn::ROW_VERSION) && (eType != MDCT_INT) && (eType != MDCT_INT64)));
 
 	// Apply table settings to all columns.
 	if (ReadOnly())		nFlags |= CColumn::READ_ONLY;
@@ -214,6 +374,10 @@ size_t CTable::AddColumn(const tchar* pszName, COLTYPE eType, size_t nLength, ui
 	if (pColumn->ColType() == MDCT_IDENTITY)
 		m_nIdentCol = i;
 
+	// Is row version column?
+	if (pColumn->RowVersion())
+		m_nVersionCol = i;
+
 	// If unique add index.
 	if (nFlags & CColumn::UNIQUE)
 		AddIndex(i);
@@ -273,6 +437,9 @@ void CTable::DropColumn(size_t nColumn)
 {
 	ASSERT(m_vRows.Count() == 0);
 
+	// Free any retired rows that use it.
+	ReclaimAllRows();
+
 	// Drop the column.
 	m_vColumns.Delete(nColumn);
 }
@@ -295,6 +462,9 @@ void CTable::DropAllColumns()
 {
 	ASSERT(m_vRows.Count() == 0);
 
+	// Free any retired rows that use them.
+	ReclaimAllRows();
+
 	// Drop the columns.
 	m_vColumns.DeleteAll();
 }
@@ -326,6 +496,14 @@ void CTable::AddIndex(size_t nColumn)
 	COLTYPE eColType = oColumn.ColType();
 	bool    bUnique  = oColumn.Unique();
 
+	// Concurrent tables use an index that can be searched without the lock.
+	if ( (Concurrent()) && (bUnique) && ( (eColType == MDCT_INT) || (eColType == MDCT_IDENTITY)
+	  || (eColType == MDCT_FXDSTR) || (eColType == MDCT_VARSTR) ) )
+	{
+		m_vColumns[nColumn].Index(new CHashIndex(*this, nColumn));
+		return;
+	}
+
 	switch (eColType)
 	{
 		case MDCT_INT:
@@ -388,6 +566,41 @@ void CTable::DropIndex(size_t nColumn)
 	m_vColumns[nColumn].Index(nullptr);
 }
 
+/******************************************************************************
+** Method:		KeyColumn()
+**
+** Description:	Gets the column used to identify rows when persisting changes.
+**				This is the indexed primary key column, or failing that, the
+**				first indexed unique column.
+**
+** Parameters:	None.
+**
+** Returns:		The column index or Core::npos if there is none.
+**
+*******************************************************************************
+*/
+
+size_t CTable::KeyColumn() const
+{
+	size_t nUnique = Core::npos;
+
+	for (size_t i = 0; i < m_vColumns.Count(); ++i)
+	{
+		const CColumn& oColumn = m_vColumns[i];
+
+		if ( (oColumn.Index() == nullptr) || (!oColumn.Unique()) )
+			continue;
+
+		if (oColumn.PrimaryKey())
+			return i;
+
+		if (nUnique == Core::npos)
+			nUnique = i;
+	}
+
+	return nUnique;
+}
+
 /******************************************************************************
 ** Method:		CreateRow()
 **
@@ -424,6 +637,12 @@ size_t CTable::InsertRow(CRow& oRow, bool bNew)
 	ASSERT(&oRow.Table()   == this);
 	ASSERT(oRow.InTable() == false);
 
+	CTraceScope oTrace(CTraceSink::INSERT_ROW, m_strName.c_str(), 1);
+
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
+	Load();
+
 	// Call "trigger".
 	OnBeforeInsert(oRow);
 
@@ -460,9 +679,23 @@ size_t CTable::InsertRow(CRow& oRow, bool bNew)
 		oRow.MarkOriginal();
 	}
 
+	// Stamp it with the next version.
+	if (m_pVersions != nullptr)
+		m_pVersions->Inserting(oRow);
+
 	// Append it.
 	size_t nRow = m_vRows.Add(oRow);
 
+	TrackVersion(oRow);
+
+	// Not part of a background snapshot.
+	if (m_pBackground != nullptr)
+		m_pBackground->InsertedRow(oRow);
+
+	// Log it.
+	if (m_pChangeLog != nullptr)
+		m_pChangeLog->LogInsert(oRow);
+
 	// Call "trigger".
 	OnAfterInsert(oRow);
 
@@ -483,11 +716,28 @@ size_t CTable::InsertRow(CRow& oRow, bool bNew)
 
 void CTable::DeleteRow(size_t nRow)
 {
+	CTraceScope oTrace(CTraceSink::DELETE_ROW, m_strName.c_str(), 1);
+
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
+	Load();
+
 	CRow& oRow = m_vRows[nRow];
 
 	// Call "trigger".
 	OnBeforeDelete(oRow);
 
+	// Log it, whilst the key is still valid.
+	if (m_pChangeLog != nullptr)
+		m_pChangeLog->LogDelete(oRow);
+
+	// Remember it for the next delta.
+	TrackDeletion(oRow);
+
+	// Keep it for any read views.
+	if (m_pVersions != nullptr)
+		m_pVersions->Deleting(oRow);
+
 	// Update any indexes.
 	for (size_t i=0; i < m_vColumns.Count(); ++i)
 	{
@@ -505,7 +755,7 @@ void CTable::DeleteRow(size_t nRow)
 	OnAfterDelete(oRow);
 
 	// Free resources.
-	delete &oRow;
+	FreeRow(oRow);
 }
 
 /******************************************************************************
@@ -522,6 +772,10 @@ void CTable::DeleteRow(size_t nRow)
 
 void CTable::DeleteRow(CRow& oRow)
 {
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
+	Load();
+
 	for (size_t i=0; i < m_vRows.Count(); ++i)
 	{
 		if (&m_vRows[i] == &oRow)
@@ -564,113 +818,174 @@ void CTable::DeleteRows(const CResultSet& oRS)
 
 void CTable::Truncate()
 {
-	// Anything to truncate?
-	if (m_vRows.Count() > 0)
-	{
-		// Remove all.
-		m_vRows.DeleteAll();
-		TruncateIndexes();
-	}
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
+	Load();
+
+	// Remember them for the next delta.
+	for (size_t i = 0; i < m_vRows.Count(); ++i)
+		TrackDeletion(m_vRows[i]);
+
+	// Remove all.
+	ReleaseRows();
+
+	// Log it.
+	if (m_pChangeLog != nullptr)
+		m_pChangeLog->LogTruncate(*this);
 }
 
 /******************************************************************************
-** Method:		CopyTable()
+** Method:		ReleaseRows()
 **
-** Description:	Copies all the rows in the source table.
+** Description:	Removes all rows and empties the indexes, without tracking or
+**				logging the deletions. This is the part of a Truncate() that
+**				is shared with reloading the table. The rows are still handed
+**				over to any read views and background snapshot and the
+**				snapshot mapping is released.
 **
-** Parameters:	oTable	The source table.
+** Parameters:	None.
 **
 ** Returns:		Nothing.
 **
 *******************************************************************************
 */
 
-void CTable::CopyTable(const CTable& oTable)
+void CTable::ReleaseRows()
 {
-	ASSERT(ColumnCount() == oTable.ColumnCount());
-
-	// For all rows...
-	for (size_t r = 0; r < oTable.RowCount(); ++r)
+	// Anything to remove?
+	if (m_vRows.Count() > 0)
 	{
-		CRow& oSrcRow = oTable[r];
-		CRow& oDstRow = CreateRow();
+		// Keep them for any read views, as a single change.
+		if (m_pVersions != nullptr)
+		{
+			CVersionStore::UpdateGuard oUpdate(m_pVersions);
 
-		// For all columns...
-		for (size_t c = 0; c < oTable.ColumnCount(); ++c)
-			oDstRow[c] = oSrcRow[c];
+			for (size_t i = 0; i < m_vRows.Count(); ++i)
+				m_pVersions->Deleting(m_vRows[i]);
+		}
 
-		InsertRow(oDstRow);
+		// Unlink them before they're retired.
+		TruncateIndexes();
+
+		// Free resources.
+		for (size_t i = 0; i < m_vRows.Count(); ++i)
+			FreeRow(m_vRows[i]);
+
+		m_vRows.RemoveAll();
 	}
+
+	// Start the row versions afresh.
+	m_nMaxVersion = std::numeric_limits<int64>::min();
+	m_bMaxVersion = true;
+
+	// Release any snapshot mapping.
+	ReleaseSnapshot();
 }
 
 /******************************************************************************
-** Method:		NullRow()
+** Method:		ReleaseSnapshot()
 **
-** Description:	Returns the NULL row for outer joins. This is a special row
-**				where all fields are NULL.
+** Description:	Releases the snapshot mapping, but keeps it for any retired rows
+**				that may still refer to it until they are freed, see
+**				ReclaimRows().
 **
 ** Parameters:	None.
 **
-** Returns:		The NULL row.
+** Returns:		Nothing.
 **
 *******************************************************************************
 */
 
-CRow& CTable::NullRow()
+void CTable::ReleaseSnapshot()
 {
-	// Create NUll row if not already.
-	if (m_pNullRow == nullptr)
-		m_pNullRow = new CRow(*this, true);
+	if ( (m_pSnapshot.get() != nullptr) && (!m_vRetired.empty()) )
+		m_vRetiredSnapshots.push_back(RetiredSnapshot(m_pSnapshot, m_oReaders.Current()));
 
-	return *m_pNullRow;
+	m_pSnapshot.reset();
 }
 
 /******************************************************************************
-** Method:		TruncateIndexes()
+** Method:		FreeRow()
 **
-** Description:	Deletes all rows in all indexes.
+** Description:	Frees a row that has been removed from the table, unless it is
+**				still needed by a background snapshot. The rows of a CONCURRENT
+**				table may have been found by a reader without the table lock,
+**				so they are retired and only freed once those readers have
+**				finished, see ReclaimRows(). The row must already have been
+**				removed from the indexes as it is tagged with the epoch it was
+**				unlinked in.
 **
-** Parameters:	None.
+** Parameters:	oRow	The row.
 **
 ** Returns:		Nothing.
 **
 *******************************************************************************
 */
 
-void CTable::TruncateIndexes()
+void CTable::FreeRow(CRow& oRow)
 {
-	// For all indexes.
-	for (size_t i=0; i < m_vColumns.Count(); ++i)
-	{
-		CIndex* pIndex = m_vColumns[i].Index();
+	// Still needed by a background snapshot?
+	if ( (m_pBackground != nullptr) && (m_pBackground->RetainRow(oRow)) )
+		return;
 
-		if (pIndex != nullptr)
-			pIndex->Truncate();
+	// Not searched without the lock?
+	if (!Concurrent())
+	{
+		delete &oRow;
+		return;
 	}
+
+	m_vRetired.push_back(RetiredRow(&oRow, m_oReaders.Current()));
+
+	if (m_vRetired.size() >= MAX_RETIRED)
+		ReclaimRows();
 }
 
 /******************************************************************************
-** Method:		SelectAll()
+** Method:		ReclaimRows()
 **
-** Description:	Selects all rows from the table.
+** Description:	Frees the retired rows, and the snapshot mappings they may refer
+**				to, that no reader can still be using. This is invoked with the
+**				table lock held and so never waits for the readers, it only
+**				moves the epoch on if the readers of the previous one have
+**				finished, see CEpoch::TryAdvance(). Rows retired more recently
+**				are left for a later call.
 **
 ** Parameters:	None.
 **
-** Returns:		The result set.
+** Returns:		Nothing.
 **
 *******************************************************************************
 */
 
-CResultSet CTable::SelectAll() const
+void CTable::ReclaimRows()
 {
-	return CResultSet(*this, m_vRows);
+	m_oReaders.TryAdvance();
+
+	// Retired in epoch order, so free the oldest.
+	size_t nRows = 0;
+
+	while ( (nRows != m_vRetired.size()) && (m_oReaders.Expired(m_vRetired[nRows].second)) )
+		delete m_vRetired[nRows++].first;
+
+	m_vRetired.erase(m_vRetired.begin(), m_vRetired.begin() + nRows);
+
+	size_t nSnapshots = 0;
+
+	while ( (nSnapshots != m_vRetiredSnapshots.size()) && (m_oReaders.Expired(m_vRetiredSnapshots[nSnapshots].second)) )
+		++nSnapshots;
+
+	m_vRetiredSnapshots.erase(m_vRetiredSnapshots.begin(), m_vRetiredSnapshots.begin() + nSnapshots);
 }
 
 /******************************************************************************
-** Method:		SelectRow()
+** Method:		ReclaimAllRows()
 **
-** Description:	Selects the first row from the table where the column matches
-**				the given value. This method expects to use an index.
+** Description:	Frees every row and snapshot mapping retired so far, waiting
+**				for the readers that may still be using them. The table lock is
+**				only held briefly to move the epoch on, as a reader holding a
+**				CTable::RowGuard may be waiting for it, and so the caller must
+**				not hold it.
 **
 ** Parameters:	None.
 **
@@ -679,131 +994,1087 @@ CResultSet CTable::SelectAll() const
 *******************************************************************************
 */
 
-CRow* CTable::SelectRow(size_t nColumn, const CValue& oValue) const
+void CTable::ReclaimAllRows()
 {
-	ASSERT(oValue.m_bNull == false);
-	ASSERT(m_vColumns[nColumn].Unique());
-	ASSERT(m_vColumns[nColumn].Index() != nullptr);
+	// Never retired?
+	if (!Concurrent())
+		return;
 
-	// Use index, to find it.
-	CUniqIndex* pIndex = static_cast<CUniqIndex*>(m_vColumns[nColumn].Index());
+	ASSERT(!m_oLock.OwnedExclusive());
 
-	return pIndex->FindRow(oValue);
+	LONG nEpoch = 0;
+
+	{
+		CReadWriteLock::WriteGuard oGuard(m_oLock, true);
+
+		// Nothing to free?
+		if ( (m_vRetired.empty()) && (m_vRetiredSnapshots.empty()) )
+			return;
+
+		nEpoch = m_oReaders.Current();
+	}
+
+	while (!m_oReaders.Expired(nEpoch))
+	{
+		{
+			CReadWriteLock::WriteGuard oGuard(m_oLock, true);
+
+			m_oReaders.TryAdvance();
+		}
+
+		if (!m_oReaders.Expired(nEpoch))
+			::Sleep(0);
+	}
+
+	CReadWriteLock::WriteGuard oGuard(m_oLock, true);
+
+	ReclaimRows();
 }
 
 /******************************************************************************
-** Method:		Select()
+** Method:		CopyTable()
 **
-** Description:	Runs a generic SELECT query on the table.
+** Description:	Copies all the rows in the source table.
 **
-** Parameters:	oWhere	The where clause.
+** Parameters:	oTable	The source table.
 **
-** Returns:		The result set.
+** Returns:		Nothing.
 **
 *******************************************************************************
 */
 
-CResultSet CTable::Select(const CWhere& oWhere) const
+void CTable::CopyTable(const CTable& oTable)
 {
-	CResultSet oRS(*this);
+	ASSERT(ColumnCount() == oTable.ColumnCount());
 
-	// For all rows, apply the clause,
-	for (size_t i = 0; i < m_vRows.Count(); ++i)
+	// For all rows...
+	for (size_t r = 0; r < oTable.RowCount(); ++r)
 	{
-		CRow& oRow = m_vRows[i];
+		CRow& oSrcRow = oTable[r];
+		CRow& oDstRow = CreateRow();
 
-		if (oWhere.Matches(oRow))
-			oRS.Add(oRow);
-	}
+		// For all columns...
+		for (size_t c = 0; c < oTable.ColumnCount(); ++c)
+			oDstRow[c] = oSrcRow[c];
 
-	return oRS;
+		InsertRow(oDstRow);
+	}
 }
 
 /******************************************************************************
-** Method:		Exists()
+** Method:		NullRow()
 **
-** Description:	Queries if at least one row matches the WHERE clause.
+** Description:	Returns the NULL row for outer joins. This is a special row
+**				where all fields are NULL.
 **
-** Parameters:	oWhere	The where clause.
+** Parameters:	None.
 **
-** Returns:		true or false.
+** Returns:		The NULL row.
 **
 *******************************************************************************
 */
 
-bool CTable::Exists(const CWhere& oWhere) const
+CRow& CTable::NullRow()
 {
-	// For all rows, apply the clause,
-	for (size_t i = 0; i < m_vRows.Count(); ++i)
+	// Create NUll row if not already.
+	if (m_pNullRow == nullptr)
 	{
-		CRow& oRow = m_vRows[i];
+		CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
 
-		if (oWhere.Matches(oRow))
-			return true;
+		// Lost the race to create it?
+		if (m_pNullRow == nullptr)
+			m_pNullRow = new CRow(*this, true);
 	}
 
-	return false;
+	return *m_pNullRow;
 }
 
 /******************************************************************************
-** Method:		Modified()
+** Method:		TruncateIndexes()
 **
-** Description:	Checks if there have been any insertions or deletions and then
-**				if any rows have been updated.
+** Description:	Deletes all rows in all indexes.
 **
 ** Parameters:	None.
 **
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CTable::TruncateIndexes()
+{
+	// For all indexes.
+	for (size_t i=0; i < m_vColumns.Count(); ++i)
+	{
+		CIndex* pIndex = m_vColumns[i].Index();
+
+		if (pIndex != nullptr)
+			pIndex->Truncate();
+	}
+}
+
+/******************************************************************************
+** Method:		TrackDeletion()
+**
+** Description:	Remembers the key of a row being deleted so that the deletion
+**				can be written to the next delta, see WriteDelta(). Rows
+**				inserted since the flags were last reset are never in a delta
+**				and a refreshed row's key has already been remembered if it
+**				was, see Refresh().
+**
+** Parameters:	oRow	The row being deleted.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CTable::TrackDeletion(const CRow& oRow)
+{
+	// Ignore if a temporary table, a new row or a refreshed one.
+	if (Transient() || oRow.Inserted() || oRow.Refreshed())
+		return;
+
+	size_t nKey = KeyColumn();
+
+	// Delta would write the entire table?
+	if (nKey == Core::npos)
+		return;
+
+	m_vDeletedKeys.Add(oRow[nKey].ToValue());
+}
+
+/******************************************************************************
+** Method:		MemoryUsage()
+**
+** Description:	Gets the heap memory used by the table, by category. The row
+**				counters are maintained as rows are allocated and freed, so
+**				they include rows created but not yet inserted and deleted
+**				rows that are being tracked. The indexes are sized on demand.
+**
+** Parameters:	None.
+**
+** Returns:		The usage.
+**
+*******************************************************************************
+*/
+
+CMemoryUsage CTable::MemoryUsage() const
+{
+	CReadWriteLock::ReadGuard oGuard(m_oLock, Concurrent());
+
+	CMemoryUsage oUsage;
+
+	oUsage.m_nFixedData     = static_cast<size_t>(m_nDataBytes);
+	oUsage.m_nFieldOverhead = static_cast<size_t>(m_nFieldBytes) + (m_vRows.Count() * sizeof(CRow*));
+	oUsage.m_nStrings       = static_cast<size_t>(m_nStringBytes);
+
+	// Report the null row separately.
+	if (m_pNullRow != nullptr)
+	{
+		CMemoryUsage oNullRow = m_pNullRow->MemoryUsage();
+
+		oUsage.m_nFixedData     -= oNullRow.m_nFixedData;
+		oUsage.m_nFieldOverhead -= oNullRow.m_nFieldOverhead;
+		oUsage.m_nStrings       -= oNullRow.m_nStrings;
+		oUsage.m_nNullRows       = oNullRow.Total();
+	}
+
+	for (size_t i = 0; i < m_vColumns.Count(); ++i)
+	{
+		const CIndex* pIndex = m_vColumns[i].Index();
+
+		if (pIndex != nullptr)
+			oUsage.m_nIndexes += pIndex->MemoryUsage();
+	}
+
+	return oUsage;
+}
+
+/******************************************************************************
+** Methods:		TrackMemory()
+**				TrackStrings()
+**
+** Description:	Updates the memory usage counters when a row is allocated or
+**				freed, or an MDCT_VARSTR buffer is resized. Rows may be
+**				created by multiple threads, so the counters are atomic.
+**
+** Parameters:	oRow		The rows usage.
+**				bAllocated	Has the row been allocated or freed?
+**				nBytes		The change in the buffer size.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CTable::TrackMemory(const CMemoryUsage& oRow, bool bAllocated)
+{
+	ptrdiff_t nSign = (bAllocated) ? 1 : -1;
+
+	addBytes(m_nDataBytes,   nSign * static_cast<ptrdiff_t>(oRow.m_nFixedData));
+	addBytes(m_nFieldBytes,  nSign * static_cast<ptrdiff_t>(oRow.m_nFieldOverhead));
+	addBytes(m_nStringBytes, nSign * static_cast<ptrdiff_t>(oRow.m_nStrings));
+}
+
+void CTable::TrackStrings(ptrdiff_t nBytes)
+{
+	addBytes(m_nStringBytes, nBytes);
+}
+
+/******************************************************************************
+** Method:		SelectAll()
+**
+** Description:	Selects all rows from the table.
+**
+** Parameters:	None.
+**
+** Returns:		The result set.
+**
+*******************************************************************************
+*/
+
+CResultSet CTable::SelectAll() const
+{
+	Load();
+
+	CReadWriteLock::ReadGuard oGuard(m_oLock, Concurrent());
+
+	return CResultSet(*this, m_vRows);
+}
+
+/******************************************************************************
+** Method:		SelectRow()
+**
+** Description:	Selects the first row from the table where the column matches
+**				the given value. This method expects to use an index, which
+**				is searched without the table lock if it allows it.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+CRow* CTable::SelectRow(size_t nColumn, const CValue& oValue) const
+{
+	ASSERT(oValue.m_bNull == false);
+	ASSERT(m_vColumns[nColumn].Unique());
+	ASSERT(m_vColumns[nColumn].Index() != nullptr);
+
+	Load();
+
+	if (!KeepsStats())
+		return FindRow(nColumn, oValue);
+
+	CQueryStats oStats;
+	CRow*       pRow = nullptr;
+
+	// Time the lookup.
+	{
+		CQueryStats::Timer oTimer(oStats);
+
+		pRow = FindRow(nColumn, oValue);
+	}
+
+	oStats.m_nIndexProbes = 1;
+	oStats.m_nRowsMatched = (pRow != nullptr) ? 1 : 0;
+
+	m_oStats.Add(oStats);
+
+	return pRow;
+}
+
+/******************************************************************************
+** Method:		FindRow()
+**
+** Description:	Finds the row where the unique column matches the given value
+**				using its index. The table lock is only taken if the index
+**				needs it.
+**
+** Parameters:	nColumn		The unique column.
+**				oValue		The value to find.
+**
+** Returns:		The row or nullptr.
+**
+*******************************************************************************
+*/
+
+CRow* CTable::FindRow(size_t nColumn, const CValue& oValue) const
+{
+	// Use index, to find it.
+	CUniqIndex* pIndex = static_cast<CUniqIndex*>(m_vColumns[nColumn].Index());
+
+	// Lock-free index?
+	if (pIndex->Concurrent())
+	{
+		CEpoch::ReadGuard oReader(m_oReaders);
+
+		return pIndex->FindRow(oValue);
+	}
+
+	CReadWriteLock::ReadGuard oGuard(m_oLock, Concurrent());
+
+	return pIndex->FindRow(oValue);
+}
+
+/******************************************************************************
+** Method:		Select()
+**
+** Description:	Runs a generic SELECT query on the table. Queries which can be
+**				answered from an index, see CWhere::SelectIndexed(), avoid the
+**				scan. Large tables are scanned in parallel, see
+**				CResultSet::ParallelThreshold(). Either way the rows are
+**				returned in table order.
+**
+** Parameters:	oWhere	The where clause.
+**
+** Returns:		The result set.
+**
+*******************************************************************************
+*/
+
+CResultSet CTable::Select(const CWhere& oWhere) const
+{
+	// Keeping the running totals?
+	if (KeepsStats())
+	{
+		CQueryStats oStats;
+
+		return Select(oWhere, oStats);
+	}
+
+	CTraceScope oTrace(CTraceSink::SELECT, m_strName.c_str());
+
+	Load();
+
+	CReadWriteLock::ReadGuard oGuard(m_oLock, Concurrent());
+
+	CResultSet oRS(*this);
+
+	// Can the query use an index instead?
+	if (oWhere.SelectIndexed(*this, oRS))
+		TableOrder(oRS);
+	else
+		CResultSet(*this, m_vRows, oWhere).Swap(oRS);
+
+	oTrace.Size(oRS.Count());
+
+	return oRS;
+}
+
+/******************************************************************************
+** Method:		Select()
+**
+** Description:	Runs a generic SELECT query on the table, as above, and adds
+**				the rows scanned, index probes, comparisons and elapsed time
+**				to the counters. The counters are also added to the table
+**				totals if the table keeps them, see Statistics().
+**
+** Parameters:	oWhere	The where clause.
+**				oStats	The counters to add to.
+**
+** Returns:		The result set.
+**
+*******************************************************************************
+*/
+
+CResultSet CTable::Select(const CWhere& oWhere, CQueryStats& oStats) const
+{
+	CTraceScope oTrace(CTraceSink::SELECT, m_strName.c_str());
+
+	CQueryStats oQuery;
+	CResultSet  oRS(*this);
+
+	// Time the query.
+	{
+		CQueryStats::Timer oTimer(oQuery);
+
+		Load();
+
+		CReadWriteLock::ReadGuard oGuard(m_oLock, Concurrent());
+
+		// Can the query use an index instead?
+		if (oWhere.SelectIndexed(*this, oRS))
+		{
+			TableOrder(oRS);
+
+			oQuery.m_nIndexProbes = oWhere.IndexProbes(*this);
+		}
+		else
+		{
+			CResultSet(*this, m_vRows, oWhere, oQuery.m_nComparisons).Swap(oRS);
+
+			oQuery.m_nRowsScanned = m_vRows.Count();
+		}
+
+		oQuery.m_nRowsMatched = oRS.Count();
+	}
+
+	oStats += oQuery;
+
+	if (KeepsStats())
+		m_oStats.Add(oQuery);
+
+	oTrace.Size(oRS.Count());
+
+	return oRS;
+}
+
+/******************************************************************************
+** Method:		TableOrder()
+**
+** Description:	Puts the rows found through an index back into table order,
+**				as a scan would have returned them. Only the row pointers are
+**				compared and the pass ends once every row has been placed.
+**
+** Parameters:	oRS		The result set.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CTable::TableOrder(CResultSet& oRS) const
+{
+	if (oRS.Count() < 2)
+		return;
+
+	std::vector<const CRow*> vFound(oRS.Count());
+
+	for (size_t i = 0; i != oRS.Count(); ++i)
+		vFound[i] = &oRS[i];
+
+	std::sort(vFound.begin(), vFound.end());
+
+	CResultSet oOrdered(*this);
+
+	for (size_t i = 0; (i != m_vRows.Count()) && (oOrdered.Count() != vFound.size()); ++i)
+	{
+		CRow& oRow = m_vRows[i];
+
+		if (std::binary_search(vFound.begin(), vFound.end(), &oRow))
+			oOrdered.Add(oRow);
+	}
+
+	ASSERT(oOrdered.Count() == oRS.Count());
+
+	oOrdered.Swap(oRS);
+}
+
+/******************************************************************************
+** Method:		Exists()
+**
+** Description:	Queries if at least one row matches the WHERE clause.
+**
+** Parameters:	oWhere	The where clause.
+**
 ** Returns:		true or false.
 **
 *******************************************************************************
 */
 
-bool CTable::Modified() const
+bool CTable::Exists(const CWhere& oWhere) const
+{
+	Load();
+
+	CReadWriteLock::ReadGuard oGuard(m_oLock, Concurrent());
+
+	// For all rows, apply the clause,
+	for (size_t i = 0; i < m_vRows.Count(); ++i)
+	{
+		CRow& oRow = m_vRows[i];
+
+		if (oWhere.Matches(oRow))
+			return true;
+	}
+
+	return false;
+}
+
+/******************************************************************************
+** Method:		Explain()
+**
+** Description:	Describes how Select() would run the query on the table as
+**				it stands now, i.e. whether it is answered from an index or a
+**				serial or parallel scan.
+**
+** Parameters:	oWhere	The where clause.
+**
+** Returns:		The plan, one step per line.
+**
+*******************************************************************************
+*/
+
+CString CTable::Explain(const CWhere& oWhere) const
+{
+	Load();
+
+	CReadWriteLock::ReadGuard oGuard(m_oLock, Concurrent());
+
+	CString strPlan;
+	size_t  nProbes  = oWhere.IndexProbes(*this);
+	size_t  nRows    = m_vRows.Count();
+	size_t  nThreads = CWorkerPool::Default().ThreadCount();
+
+	if (nProbes != 0)
+		strPlan.Format(TXT("INDEX LOOKUP %s (%u probes)"), m_strName.c_str(), static_cast<uint>(nProbes));
+	else if ( (nRows >= CResultSet::ParallelThreshold()) && (nThreads > 1) )
+		strPlan.Format(TXT("PARALLEL SCAN %s (%u rows, %u threads)"), m_strName.c_str(), static_cast<uint>(nRows), static_cast<uint>(nThreads));
+	else
+		strPlan.Format(TXT("SCAN %s (%u rows)"), m_strName.c_str(), static_cast<uint>(nRows));
+
+	strPlan += TXT("\n  WHERE ");
+	strPlan += oWhere.Describe(*this);
+
+	return strPlan;
+}
+
+/******************************************************************************
+** Method:		Query()
+**
+** Description:	Creates a lazy cursor over all the rows in the table. Unlike
+**				Select() no rows are evaluated until the cursor is iterated.
+**				The cursor holds no lock, so for a CONCURRENT table it is
+**				given a copy of the row pointers taken under the lock, as an
+**				insert could reallocate the rows whilst it's iterated.
+**
+** Parameters:	None.
+**
+** Returns:		The cursor.
+**
+*******************************************************************************
+*/
+
+CRowCursor CTable::Query() const
+{
+	Load();
+
+	CReadWriteLock::ReadGuard oGuard(m_oLock, Concurrent());
+
+	return CRowCursor(*this, m_vRows, Concurrent());
+}
+
+/******************************************************************************
+** Method:		Modified()
+**
+** Description:	Checks if there have been any insertions or deletions and then
+**				if any rows have been updated.
+**
+** Parameters:	None.
+**
+** Returns:		true or false.
+**
+*******************************************************************************
+*/
+
+bool CTable::Modified() const
+{
+	// Ignore if table transient or read-only.
+	if (Transient() || ReadOnly())
+		return false;
+
+	CReadWriteLock::ReadGuard oGuard(m_oLock, Concurrent());
+
+	// Any insertions/updates/deletions?
+	if (m_nInsertions || m_nUpdates || m_nDeletions)
+		return true;
+
+	return false;
+}
+
+/******************************************************************************
+** Method:		Modified()
+**
+** Description:	Sets or resets the table and row modified flags.
+**
+** Parameters:	bModified	Set or Reset flags?
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CTable::Modified(bool bModified)
+{
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
+	if (bModified)
+	{
+		// Set modified flags.
+		++m_nInsertions;
+		++m_nUpdates;
+		++m_nDeletions;
+	}
+	else
+	{
+		// Reset table and row flags.
+		ResetRowFlags();
+	}
+}
+
+/******************************************************************************
+** Methods:		Read()
+**				Write()
+**
+** Description:	Operators to read/write the data from/to a stream.
+**
+** Parameters:	rStream		The stream.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CTable::Read(WCL::IInputStream& rStream)
+{
+	CTraceScope oTrace(CTraceSink::TABLE_READ, m_strName.c_str());
+
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
+	// Remove all existing rows.
+	ReleaseRows();
+	m_pPending.reset();
+
+	// Ignore if a temporary table.
+	if (Transient())
+		return;
+
+	uint32 nColumns;
+
+	// Verify the column count.
+	rStream >> nColumns;
+
+	ASSERT(m_vColumns.Count() == nColumns);
+
+	// Read the actual rows.
+	ReadRows(rStream);
+
+	oTrace.Size(m_vRows.Count());
+
+	// Read the identity value.
+	rStream.Read(&m_nIdentVal, sizeof(m_nIdentVal));
+
+	LogReload();
+
+	// Reset modified flags.
+	m_nInsertions = 0;
+	m_nUpdates    = 0;
+	m_nDeletions  = 0;
+	m_nRefreshes  = 0;
+	m_vDeletedKeys.DeleteAll();
+}
+
+void CTable::Write(WCL::IOutputStream& rStream)
+{
+	CTraceScope oTrace(CTraceSink::TABLE_WRITE, m_strName.c_str());
+
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
+	// Ignore if a temporary table.
+	if (Transient())
+		return;
+
+	Load();
+
+	uint32 nColumns = static_cast<uint32>(m_vColumns.Count());
+
+	// Write the column count.
+	rStream << nColumns;
+
+	uint32 nRows = static_cast<uint32>(m_vRows.Count());
+
+	// Write the row count.
+	rStream << nRows;
+
+	oTrace.Size(nRows);
+
+	// Write the actual rows.
+	for (size_t i = 0; i != nRows; ++i)
+		m_vRows[i].Write(rStream);
+
+	// Write the identity value.
+	rStream.Write(&m_nIdentVal, sizeof(m_nIdentVal));
+
+	// Reset modified flags.
+	m_nInsertions = 0;
+	m_nUpdates    = 0;
+	m_nDeletions  = 0;
+	m_nRefreshes  = 0;
+	m_vDeletedKeys.DeleteAll();
+}
+
+/******************************************************************************
+** Method:		ReadRows()
+**
+** Description:	Reads a row count and then the rows from a stream and appends
+**				them to the table.
+**
+** Parameters:	rStream		The stream.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CTable::ReadRows(WCL::IInputStream& rStream)
 {
-	// Ignore if table transient or read-only.
-	if (Transient() || ReadOnly())
-		return false;
+	uint32 nRows;
 
-	// Any insertions/updates/deletions?
-	if (m_nInsertions || m_nUpdates || m_nDeletions)
-		return true;
+	// Read the row count.
+	rStream >> nRows;
 
-	return false;
+	// Prepare any indexes.
+	for (size_t n = 0; n < m_vColumns.Count(); ++n)
+	{
+		CIndex* pIndex = m_vColumns[n].Index();
+
+		if (pIndex != nullptr)
+			pIndex->Capacity(m_vRows.Count() + nRows);
+	}
+
+	// Read the actual rows.
+	for (size_t i = 0; i < nRows; ++i)
+	{
+		CRow& oRow = CTable::CreateRow();
+
+		oRow.Read(rStream);
+
+#ifdef _DEBUG
+		// Check row nulls and fkeys.
+		CheckRow(oRow, false);
+#endif //_DEBUG
+
+		m_vRows.Add(oRow);
+		TrackVersion(oRow);
+
+		// Update any indexes.
+		for (size_t n = 0; n < m_vColumns.Count(); ++n)
+		{
+			CIndex* pIndex = m_vColumns[n].Index();
+
+			if (pIndex != nullptr)
+				pIndex->AddRow(oRow);
+		}
+	}
+
+#ifdef _DEBUG
+	// Check index sizes.
+	CheckIndexes();
+#endif //_DEBUG
 }
 
 /******************************************************************************
-** Method:		Modified()
+** Method:		LogReload()
 **
-** Description:	Sets or resets the table and row modified flags.
+** Description:	Records a reload of the table from a stream in the change log
+**				as a truncation followed by an insertion for every row, the
+**				same as a reload from a SQL source, so that replaying the log
+**				on top of an earlier snapshot reproduces the reloaded rows.
 **
-** Parameters:	bModified	Set or Reset flags?
+** Parameters:	None.
 **
 ** Returns:		Nothing.
 **
 *******************************************************************************
 */
 
-void CTable::Modified(bool bModified)
+void CTable::LogReload()
 {
-	if (bModified)
+	if (m_pChangeLog == nullptr)
+		return;
+
+	m_pChangeLog->LogTruncate(*this);
+
+	for (size_t i = 0; i != m_vRows.Count(); ++i)
+		m_pChangeLog->LogInsert(m_vRows[i]);
+}
+
+/******************************************************************************
+** Methods:		ReadDelta()
+**				WriteDelta()
+**
+** Description:	Operators to read/write only the changes made since the row
+**				flags were last reset from/to a stream. A delta holds the keys
+**				of the deleted rows, the inserted rows and the modified fields
+**				of the updated rows. Rows are identified by the KeyColumn() and
+**				a table without one is written in full. Rows changed by
+**				Refresh() are written as a deletion of the key, if it was in
+**				the previous stream, and an insertion. Writing a delta resets
+**				the row flags, see ResetRowFlags(), and so a series of deltas
+**				must be read back in order on top of the stream they follow.
+**				The changes are applied the same way as Refresh() does, so
+**				read views, background snapshots and the change log see them.
+**
+** Parameters:	rStream		The stream.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CTable::ReadDelta(WCL::IInputStream& rStream)
+{
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
+	// Ignore if a temporary table.
+	if (Transient())
+		return;
+
+	// A delta applies to the current rows.
+	Load();
+
+	uint32 nColumns;
+	bool   bFull;
+
+	// Verify the column count.
+	rStream >> nColumns;
+
+	ASSERT(m_vColumns.Count() == nColumns);
+
+	rStream.Read(&bFull, sizeof(bool));
+
+	// Entire table?
+	if (bFull)
 	{
-		// Set modified flags.
-		++m_nInsertions;
-		++m_nUpdates;
-		++m_nDeletions;
+		// Remove all existing rows.
+		ReleaseRows();
+
+		ReadRows(rStream);
+		LogReload();
 	}
 	else
 	{
-		// Reset table and row flags.
-		ResetRowFlags();
+		size_t  nKey  = KeyColumn();
+		STGTYPE eType = m_vColumns[nKey].StgType();
+		uint32  nDeleted;
+		uint32  nUpdated;
+
+		ASSERT(nKey != Core::npos);
+
+		// Make the changes visible to read views as a single one.
+		CVersionStore::UpdateGuard oUpdate(m_pVersions);
+
+		size_t nReplaced = 0;
+
+		// Read the deleted row keys.
+		rStream >> nDeleted;
+
+		for (size_t i = 0; i < nDeleted; ++i)
+		{
+			CRow& oRow = findDeltaRow(*this, nKey, readDeltaKey(rStream, eType));
+
+			if (m_pChangeLog != nullptr)
+				m_pChangeLog->LogDelete(oRow);
+
+			if (m_pVersions != nullptr)
+				m_pVersions->Deleting(oRow);
+
+			removeFromIndexes(*this, oRow);
+			oRow.MarkDeleted();
+		}
+
+		// Remove them in a single pass.
+		if (nDeleted > 0)
+		{
+			std::vector<CRow*> vRemoved;
+
+			m_vRows.RemoveMarked(vRemoved);
+
+			for (size_t i = 0; i != vRemoved.size(); ++i)
+				FreeRow(*vRemoved[i]);
+		}
+
+		size_t nFirst = m_vRows.Count();
+
+		// Read the inserted rows.
+		ReadRows(rStream);
+
+		// Read the updated rows.
+		rStream >> nUpdated;
+
+		for (size_t i = 0; i < nUpdated; ++i)
+		{
+			CRow& oRow = findDeltaRow(*this, nKey, readDeltaKey(rStream, eType));
+
+			if (oRow.Mapped())
+			{
+				// The data is in a snapshot mapping, so replace the row.
+				Core::UniquePtr<CRow> pCopy(&CreateRow());
+
+				pCopy->Read(oRow);
+				pCopy->ReadModified(rStream);
+
+				if (m_pChangeLog != nullptr)
+					m_pChangeLog->LogDelete(oRow);
+
+				if (m_pVersions != nullptr)
+					m_pVersions->Deleting(oRow);
+
+				removeFromIndexes(*this, oRow);
+				oRow.MarkDeleted();
+				++nReplaced;
+
+				pCopy->MarkOriginal();
+				m_vRows.Add(*pCopy);
+
+				CRow& oCopy = *pCopy.detach();
+
+				addToIndexes(*this, oCopy);
+				TrackVersion(oCopy);
+			}
+			else
+			{
+				// Keep the current values for a background snapshot.
+				if (m_pBackground != nullptr)
+					m_pBackground->PreserveRow(oRow);
+
+				// And for any read views.
+				if (m_pVersions != nullptr)
+					m_pVersions->Updating(oRow);
+
+				removeFromIndexes(*this, oRow);
+				oRow.ReadModified(rStream);
+				addToIndexes(*this, oRow);
+				TrackVersion(oRow);
+
+				// Log it.
+				if (m_pChangeLog != nullptr)
+				{
+					for (size_t c = 0; c < m_vColumns.Count(); ++c)
+					{
+						if (!m_vColumns[c].Transient())
+							m_pChangeLog->LogUpdate(oRow, c);
+					}
+				}
+			}
+		}
+
+		// Stamp, and log, the inserted and replacement rows.
+		for (size_t i = nFirst; i != m_vRows.Count(); ++i)
+		{
+			CRow& oRow = m_vRows[i];
+
+			if (m_pVersions != nullptr)
+				m_pVersions->Inserting(oRow);
+
+			if (m_pBackground != nullptr)
+				m_pBackground->InsertedRow(oRow);
+
+			if (m_pChangeLog != nullptr)
+				m_pChangeLog->LogInsert(oRow);
+		}
+
+		// Remove the replaced rows in a single pass.
+		if (nReplaced > 0)
+		{
+			std::vector<CRow*> vRemoved;
+
+			m_vRows.RemoveMarked(vRemoved);
+
+			for (size_t i = 0; i != vRemoved.size(); ++i)
+				FreeRow(*vRemoved[i]);
+		}
+	}
+
+	// Read the identity value.
+	rStream.Read(&m_nIdentVal, sizeof(m_nIdentVal));
+
+	// Reset modified flags.
+	m_nInsertions = 0;
+	m_nUpdates    = 0;
+	m_nDeletions  = 0;
+	m_nRefreshes  = 0;
+	m_vDeletedKeys.DeleteAll();
+}
+
+void CTable::WriteDelta(WCL::IOutputStream& rStream)
+{
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
+	// Ignore if a temporary table.
+	if (Transient())
+		return;
+
+	Load();
+
+	uint32 nColumns = static_cast<uint32>(m_vColumns.Count());
+	size_t nKey     = KeyColumn();
+	bool   bFull    = (nKey == Core::npos);
+
+	// Write the column count and delta type.
+	rStream << nColumns;
+	rStream.Write(&bFull, sizeof(bool));
+
+	// Entire table?
+	if (bFull)
+	{
+		uint32 nRows = static_cast<uint32>(m_vRows.Count());
+
+		rStream << nRows;
+
+		for (size_t i = 0; i != nRows; ++i)
+			m_vRows[i].Write(rStream);
+	}
+	else
+	{
+		std::vector<CRow*> vInserted;
+		std::vector<CRow*> vUpdated;
+
+		// Find the modified rows.
+		for (size_t i = 0; i != m_vRows.Count(); ++i)
+		{
+			CRow& oRow = m_vRows[i];
+
+			if (oRow.Inserted() || oRow.Refreshed())
+				vInserted.push_back(&oRow);
+			else if (oRow.Updated())
+				vUpdated.push_back(&oRow);
+		}
+
+		uint32 nDeleted  = static_cast<uint32>(m_vDeletedKeys.Count());
+		uint32 nInserted = static_cast<uint32>(vInserted.size());
+		uint32 nUpdated  = static_cast<uint32>(vUpdated.size());
+
+		// Write the deleted row keys.
+		rStream << nDeleted;
+
+		for (size_t i = 0; i != nDeleted; ++i)
+			writeDeltaKey(rStream, m_vDeletedKeys[i]);
+
+		// Write the inserted rows.
+		rStream << nInserted;
+
+		for (size_t i = 0; i != nInserted; ++i)
+			vInserted[i]->Write(rStream);
+
+		// Write the updated rows.
+		rStream << nUpdated;
+
+		for (size_t i = 0; i != nUpdated; ++i)
+		{
+			writeDeltaKey(rStream, (*vUpdated[i])[nKey].ToValue());
+			vUpdated[i]->WriteModified(rStream);
+		}
 	}
+
+	// Write the identity value.
+	rStream.Write(&m_nIdentVal, sizeof(m_nIdentVal));
+
+	// Reset modified flags.
+	ResetRowFlags();
 }
 
 /******************************************************************************
-** Methods:		Read()
-**				Write()
+** Methods:		ReadCompressed()
+**				WriteCompressed()
 **
-** Description:	Operators to read/write the data from/to a stream.
+** Description:	Operators to read/write the data from/to a stream in the
+**				compressed format. The rows are written as a series of blocks
+**				which are column encoded and compressed, see CRowBlock. A batch
+**				of blocks is encoded or decoded concurrently at a time so that
+**				the stream is still processed sequentially.
 **
 ** Parameters:	rStream		The stream.
 **
@@ -812,11 +2083,13 @@ void CTable::Modified(bool bModified)
 *******************************************************************************
 */
 
-void CTable::Read(WCL::IInputStream& rStream)
+void CTable::ReadCompressed(WCL::IInputStream& rStream)
 {
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
 	// Remove all existing rows.
-	m_vRows.DeleteAll();
-	TruncateIndexes();
+	ReleaseRows();
+	m_pPending.reset();
 
 	// Ignore if a temporary table.
 	if (Transient())
@@ -828,7 +2101,8 @@ void CTable::Read(WCL::IInputStream& rStream)
 	// Verify the column count.
 	rStream >> nColumns;
 
-	ASSERT(m_vColumns.Count() == nColumns);
+	if (m_vColumns.Count() != nColumns)
+		throw CMDBException(CMDBException::E_BAD_BLOCK, Core::fmt(TXT("The column count does not match the table '%s'"), m_strName.c_str()).c_str());
 
 	// Read the row count.
 	rStream >> nRows;
@@ -842,27 +2116,51 @@ void CTable::Read(WCL::IInputStream& rStream)
 			pIndex->Capacity(nRows);
 	}
 
-	// Read the actual rows.
-	for (size_t i = 0; i < nRows; ++i)
+	size_t                 nBatch = CWorkerPool::Default().ThreadCount() * 2;
+	std::vector<CRowBlock> vBlocks;
+
+	// Read the rows, a batch of blocks at a time.
+	for (size_t nRead = 0; nRead < nRows; )
 	{
-		CRow& oRow = CTable::CreateRow();
+		vBlocks.resize(std::min<size_t>(nBatch, ((nRows - nRead) + CRowBlock::MAX_ROWS-1) / CRowBlock::MAX_ROWS));
 
-		oRow.Read(rStream);
+		for (size_t b = 0; b != vBlocks.size(); ++b)
+			vBlocks[b].Read(rStream);
+
+		CRowBlock::Decode(*this, vBlocks);
+
+		for (size_t b = 0; b != vBlocks.size(); ++b)
+		{
+			const CRowBlock& oBlock = vBlocks[b];
+
+			if (oBlock.RowCount() > (nRows - nRead))
+				throw CMDBException(CMDBException::E_BAD_BLOCK, Core::fmt(TXT("Too many rows for the table '%s'"), m_strName.c_str()).c_str());
+
+			for (size_t r = 0; r != oBlock.RowCount(); ++r)
+			{
+				CRow& oRow = CTable::CreateRow();
+
+				oBlock.CopyRow(r, oRow);
 
 #ifdef _DEBUG
-		// Check row nulls and fkeys.
-		CheckRow(oRow, false);
+				// Check row nulls and fkeys.
+				CheckRow(oRow, false);
 #endif //_DEBUG
 
-		m_vRows.Add(oRow);
-
-		// Update any indexes.
-		for (size_t n = 0; n < m_vColumns.Count(); ++n)
-		{
-			CIndex* pIndex = m_vColumns[n].Index();
+				m_vRows.Add(oRow);
+				TrackVersion(oRow);
 
-			if (pIndex != nullptr)
-				pIndex->AddRow(oRow);
+				// Update any indexes.
+				for (size_t n = 0; n < m_vColumns.Count(); ++n)
+				{
+					CIndex* pIndex = m_vColumns[n].Index();
+
+					if (pIndex != nullptr)
+						pIndex->AddRow(oRow);
+				}
+			}
+
+			nRead += oBlock.RowCount();
 		}
 	}
 
@@ -874,39 +2172,56 @@ void CTable::Read(WCL::IInputStream& rStream)
 	// Read the identity value.
 	rStream.Read(&m_nIdentVal, sizeof(m_nIdentVal));
 
+	LogReload();
+
 	// Reset modified flags.
 	m_nInsertions = 0;
 	m_nUpdates    = 0;
 	m_nDeletions  = 0;
+	m_nRefreshes  = 0;
+	m_vDeletedKeys.DeleteAll();
 }
 
-void CTable::Write(WCL::IOutputStream& rStream)
+void CTable::WriteCompressed(WCL::IOutputStream& rStream)
 {
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
 	// Ignore if a temporary table.
 	if (Transient())
 		return;
 
+	Load();
+
 	uint32 nColumns = static_cast<uint32>(m_vColumns.Count());
+	uint32 nRows    = static_cast<uint32>(m_vRows.Count());
 
-	// Write the column count.
+	// Write the column and row counts.
 	rStream << nColumns;
+	rStream << nRows;
 
-	uint32 nRows = static_cast<uint32>(m_vRows.Count());
+	size_t                 nBatch = CWorkerPool::Default().ThreadCount() * 2;
+	std::vector<CRowBlock> vBlocks;
 
-	// Write the row count.
-	rStream << nRows;
+	// Write the rows, a batch of blocks at a time.
+	for (size_t nWritten = 0; nWritten < nRows; )
+	{
+		vBlocks.resize(std::min<size_t>(nBatch, ((nRows - nWritten) + CRowBlock::MAX_ROWS-1) / CRowBlock::MAX_ROWS));
 
-	// Write the actual rows.
-	for (size_t i = 0; i != nRows; ++i)
-		m_vRows[i].Write(rStream);
+		CRowBlock::Encode(*this, nWritten, vBlocks);
+
+		for (size_t b = 0; b != vBlocks.size(); ++b)
+		{
+			vBlocks[b].Write(rStream);
+
+			nWritten += vBlocks[b].RowCount();
+		}
+	}
 
 	// Write the identity value.
 	rStream.Write(&m_nIdentVal, sizeof(m_nIdentVal));
 
 	// Reset modified flags.
-	m_nInsertions = 0;
-	m_nUpdates    = 0;
-	m_nDeletions  = 0;
+	ResetRowFlags();
 }
 
 /******************************************************************************
@@ -944,9 +2259,10 @@ CString CTable::SQLColumnList() const
 /******************************************************************************
 ** Method:		SQLQuery()
 **
-** Description:	Gets the SQL query required to load the table,
+** Description:	Gets the SQL query required to load the table, optionally
+**				restricted by an additional filter, see Refresh().
 **
-** Parameters:	None.
+** Parameters:	strFilter	The additional WHERE clause predicate, if any.
 **
 ** Returns:		The query.
 **
@@ -954,6 +2270,11 @@ CString CTable::SQLColumnList() const
 */
 
 CString CTable::SQLQuery() const
+{
+	return SQLQuery(CString());
+}
+
+CString CTable::SQLQuery(const CString& strFilter) const
 {
 	ASSERT(Transient() == false);
 	ASSERT(m_vColumns.Count() > 0);
@@ -965,8 +2286,12 @@ CString CTable::SQLQuery() const
 	CString strQuery = TXT("SELECT ") + SQLColumnList() + TXT(" FROM ") + strTable;
 
 	// Append WHERE, if set.
-	if (m_strSQLWhere.Empty() == false)
+	if ( (m_strSQLWhere.Empty() == false) && (strFilter.Empty() == false) )
+		strQuery += TXT(" WHERE (") + m_strSQLWhere + TXT(") AND (") + strFilter + TXT(")");
+	else if (m_strSQLWhere.Empty() == false)
 		strQuery += TXT(" WHERE ") + m_strSQLWhere;
+	else if (strFilter.Empty() == false)
+		strQuery += TXT(" WHERE ") + strFilter;
 
 	// Append GROUP BY, if set.
 	if (m_strSQLGroup.Empty() == false)
@@ -995,36 +2320,27 @@ CString CTable::SQLQuery() const
 
 void CTable::Read(CSQLSource& rSource)
 {
+	CTraceScope oTrace(CTraceSink::TABLE_READ, m_strName.c_str());
+
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
 	// Remove all existing rows.
-	m_vRows.DeleteAll();
-	TruncateIndexes();
+	ReleaseRows();
+	m_pPending.reset();
 
 	// Ignore if a temporary table.
 	if (Transient())
 		return;
 
+	// The rows are logged as they are inserted.
+	if (m_pChangeLog != nullptr)
+		m_pChangeLog->LogTruncate(*this);
+
 	ASSERT(rSource.IsOpen());
 
 	SQLCursorPtr pCursor = rSource.ExecQuery(SQLQuery());
 
-	// Set the output column types.
-	for (size_t iTabCol = 0, iSQLCol = 0; iTabCol < m_vColumns.Count(); ++iTabCol)
-	{
-		CColumn& oTabColumn = m_vColumns[iTabCol];
-
-		// Ignore TRANSIENT columns.
-		if (!oTabColumn.Transient())
-		{
-#ifdef _DEBUG
-			const SQLColumn& oSQLColumn = pCursor->Column(iSQLCol);
-
-			ASSERT(oTabColumn.Name() == oSQLColumn.m_strName);
-			ASSERT(!((oTabColumn.ColType() == MDCT_FXDSTR) && (oTabColumn.Length() < oSQLColumn.m_nSize)));
-#endif
-			pCursor->MapColumn(iSQLCol, iTabCol, oTabColumn.ColType(), oTabColumn.Length());
-			++iSQLCol;
-		}
-	}
+	MapSQLColumns(*pCursor);
 
 	// For all rows.
 	while (pCursor->Fetch())
@@ -1038,10 +2354,16 @@ void CTable::Read(CSQLSource& rSource)
 		// Append to table.
 		InsertRow(oRow, false);
 	}
+
+	oTrace.Size(m_vRows.Count());
 }
 
 void CTable::Write(CSQLSource& rSource, RowTypes eRows)
 {
+	CTraceScope oTrace(CTraceSink::TABLE_WRITE, m_strName.c_str());
+
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
 	// Ignore if a temporary table.
 	if (Transient())
 		return;
@@ -1049,6 +2371,10 @@ void CTable::Write(CSQLSource& rSource, RowTypes eRows)
 	ASSERT(m_vColumns.Count() > 0);
 	ASSERT(rSource.IsOpen());
 
+	oTrace.Size( ((eRows & INSERTED) ? m_nInsertions : 0)
+			   + ((eRows & UPDATED)  ? m_nUpdates    : 0)
+			   + ((eRows & DELETED)  ? m_nDeletions  : 0) );
+
 	// Write inserted rows AND there are some?
 	if ( (eRows & INSERTED) && (m_nInsertions > 0) )
 		WriteInsertions(rSource);
@@ -1062,6 +2388,327 @@ void CTable::Write(CSQLSource& rSource, RowTypes eRows)
 		WriteDeletions(rSource);
 }
 
+/******************************************************************************
+** Method:		Refresh()
+**
+** Description:	Refreshes the table from a Database by fetching only the rows
+**				whose ROW_VERSION column is newer than any held. Changed rows
+**				are matched on the key column, see KeyColumn(), and are then
+**				either updated in place or inserted. Rows that have been
+**				deleted from the source are only removed if requested, as that
+**				requires fetching all the keys. As with Read() the rows are
+**				not marked as modified, and so are not written back to the
+**				source, but they are marked as refreshed, and the keys of the
+**				rows they replace or remove are tracked, so that the next delta
+**				holds the changes, see WriteDelta().
+**
+** Parameters:	rSource		The data source.
+**				bDeletions	Remove the rows that are no longer in the source?
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CTable::Refresh(CSQLSource& rSource, bool bDeletions)
+{
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
+	// Ignore if a temporary table.
+	if (Transient())
+		return;
+
+	ASSERT(rSource.IsOpen());
+	ASSERT(m_nVersionCol != Core::npos);
+	ASSERT(m_strSQLGroup.Empty());
+
+	size_t nKey = KeyColumn();
+
+	if (nKey == Core::npos)
+		throw CMDBException(CMDBException::E_NO_KEY_COLUMN, Core::fmt(TXT("The table '%s' has no indexed unique column"), m_strName.c_str()).c_str());
+
+	Load();
+
+	CString            strFilter;
+	std::vector<CRow*> vChanged;
+	std::vector<CRow*> vSeen;
+
+	// Only fetch the rows changed since the newest one held.
+	if (m_vRows.Count() != 0)
+		strFilter = Core::fmt(TXT("%s > %I64d"), m_vColumns[m_nVersionCol].Name().c_str(), MaxRowVersion());
+
+	// Fetch everything before touching the table.
+	try
+	{
+		SQLCursorPtr pCursor = rSource.ExecQuery(SQLQuery(strFilter));
+
+		MapSQLColumns(*pCursor);
+
+		while (pCursor->Fetch())
+		{
+			vChanged.push_back(&CreateRow());
+
+			pCursor->GetRow(*vChanged.back());
+		}
+
+		// Find the rows that still exist in the source.
+		if (bDeletions)
+		{
+			const CColumn& oKey     = m_vColumns[nKey];
+			CString        strTable = (m_strSQLTable.Empty()) ? m_strName : m_strSQLTable;
+			CString        strQuery = TXT("SELECT ") + oKey.Name() + TXT(" FROM ") + strTable;
+
+			if (m_strSQLWhere.Empty() == false)
+				strQuery += TXT(" WHERE ") + m_strSQLWhere;
+
+			SQLCursorPtr          pKeys = rSource.ExecQuery(strQuery);
+			Core::UniquePtr<CRow> pKeyRow(&CreateRow());
+
+			pKeys->MapColumn(0, nKey, oKey.ColType(), oKey.Length());
+
+			while (pKeys->Fetch())
+			{
+				pKeys->GetRow(*pKeyRow);
+
+				const CField& oValue = (*pKeyRow)[nKey];
+				CRow*         pRow   = (oValue != null) ? SelectRow(nKey, oValue.ToValue()) : nullptr;
+
+				if (pRow != nullptr)
+					vSeen.push_back(pRow);
+			}
+		}
+	}
+	catch (...)
+	{
+		for (size_t i = 0; i != vChanged.size(); ++i)
+			delete vChanged[i];
+
+		throw;
+	}
+
+	// Make the changes visible to read views as a single one.
+	CVersionStore::UpdateGuard oUpdate(m_pVersions);
+
+	std::vector<CRow*> vInserts;
+	size_t             nRemoved = 0;
+
+	// Apply the changed rows.
+	for (size_t i = 0; i != vChanged.size(); ++i)
+	{
+		CRow& oRow      = *vChanged[i];
+		CRow* pExisting = (oRow[nKey] != null) ? SelectRow(nKey, oRow[nKey].ToValue()) : nullptr;
+
+		if (pExisting == nullptr)
+		{
+			vInserts.push_back(&oRow);
+		}
+		else if (pExisting->Mapped())
+		{
+			// The data is in a snapshot mapping, so replace the row.
+			TrackDeletion(*pExisting);
+
+			if (m_pChangeLog != nullptr)
+				m_pChangeLog->LogDelete(*pExisting);
+
+			if (m_pVersions != nullptr)
+				m_pVersions->Deleting(*pExisting);
+
+			removeFromIndexes(*this, *pExisting);
+			pExisting->MarkDeleted();
+			vInserts.push_back(&oRow);
+			++nRemoved;
+		}
+		else
+		{
+			// Keep the current values for a background snapshot.
+			if (m_pBackground != nullptr)
+				m_pBackground->PreserveRow(*pExisting);
+
+			// And for any read views.
+			if (m_pVersions != nullptr)
+				m_pVersions->Updating(*pExisting);
+
+			// A delta replaces the entire row.
+			TrackDeletion(*pExisting);
+
+			removeFromIndexes(*this, *pExisting);
+			pExisting->Read(oRow);
+			pExisting->MarkRefreshed();
+			addToIndexes(*this, *pExisting);
+			TrackVersion(*pExisting);
+
+			// Log it.
+			if (m_pChangeLog != nullptr)
+			{
+				for (size_t c = 0; c < m_vColumns.Count(); ++c)
+				{
+					if (!m_vColumns[c].Transient())
+						m_pChangeLog->LogUpdate(*pExisting, c);
+				}
+			}
+
+			delete &oRow;
+		}
+	}
+
+	// Mark the rows that are no longer in the source.
+	if (bDeletions)
+	{
+		std::sort(vSeen.begin(), vSeen.end());
+
+		for (size_t i = 0; i != m_vRows.Count(); ++i)
+		{
+			CRow& oRow = m_vRows[i];
+
+			if ( (oRow.Deleted()) || (std::binary_search(vSeen.begin(), vSeen.end(), &oRow)) )
+				continue;
+
+			TrackDeletion(oRow);
+			++m_nRefreshes;
+
+			if (m_pChangeLog != nullptr)
+				m_pChangeLog->LogDelete(oRow);
+
+			if (m_pVersions != nullptr)
+				m_pVersions->Deleting(oRow);
+
+			removeFromIndexes(*this, oRow);
+			oRow.MarkDeleted();
+			++nRemoved;
+		}
+	}
+
+	// Remove them in a single pass.
+	if (nRemoved != 0)
+	{
+		std::vector<CRow*> vRemoved;
+
+		m_vRows.RemoveMarked(vRemoved);
+
+		// Free resources.
+		for (size_t i = 0; i != vRemoved.size(); ++i)
+			FreeRow(*vRemoved[i]);
+	}
+
+	// Append the new rows.
+	for (size_t i = 0; i != vInserts.size(); ++i)
+	{
+		InsertRow(*vInserts[i], false);
+		vInserts[i]->MarkRefreshed();
+	}
+
+	m_nRefreshes += vChanged.size();
+}
+
+/******************************************************************************
+** Method:		MaxRowVersion()
+**
+** Description:	Gets the highest value in the ROW_VERSION column of the rows
+**				loaded, inserted or refreshed since the table was last emptied.
+**				It is kept up to date as the rows are added, see TrackVersion(),
+**				so the rows are only scanned after a row version has been
+**				changed through a field, which could have lowered it.
+**
+** Parameters:	None.
+**
+** Returns:		The value or the lowest possible one if there are none.
+**
+*******************************************************************************
+*/
+
+int64 CTable::MaxRowVersion() const
+{
+	ASSERT(m_nVersionCol != Core::npos);
+
+	if (!m_bMaxVersion)
+	{
+		bool  bInt64   = (m_vColumns[m_nVersionCol].ColType() == MDCT_INT64);
+		int64 nVersion = std::numeric_limits<int64>::min();
+
+		for (size_t i = 0; i < m_vRows.Count(); ++i)
+		{
+			const CField& oField = m_vRows[i][m_nVersionCol];
+
+			if (oField == null)
+				continue;
+
+			int64 nValue = (bInt64) ? oField.GetInt64() : oField.GetInt();
+
+			if (nValue > nVersion)
+				nVersion = nValue;
+		}
+
+		m_nMaxVersion = nVersion;
+		m_bMaxVersion = true;
+	}
+
+	return m_nMaxVersion;
+}
+
+/******************************************************************************
+** Method:		TrackVersion()
+**
+** Description:	Raises the highest row version to that of a row just added or
+**				refreshed, if higher.
+**
+** Parameters:	oRow	The row.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CTable::TrackVersion(const CRow& oRow)
+{
+	// No version column or not known anyway?
+	if ( (m_nVersionCol == Core::npos) || (!m_bMaxVersion) )
+		return;
+
+	const CField& oField = oRow[m_nVersionCol];
+
+	if (oField == null)
+		return;
+
+	int64 nValue = (m_vColumns[m_nVersionCol].ColType() == MDCT_INT64) ? oField.GetInt64() : oField.GetInt();
+
+	if (nValue > m_nMaxVersion)
+		m_nMaxVersion = nValue;
+}
+
+/******************************************************************************
+** Method:		MapSQLColumns()
+**
+** Description:	Maps the persistent columns to the query result set columns.
+**
+** Parameters:	rCursor		The cursor for the query, see SQLQuery().
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CTable::MapSQLColumns(CSQLCursor& rCursor) const
+{
+	// Set the output column types.
+	for (size_t iTabCol = 0, iSQLCol = 0; iTabCol < m_vColumns.Count(); ++iTabCol)
+	{
+		const CColumn& oTabColumn = m_vColumns[iTabCol];
+
+		// Ignore TRANSIENT columns.
+		if (!oTabColumn.Transient())
+		{
+#ifdef _DEBUG
+			const SQLColumn& oSQLColumn = rCursor.Column(iSQLCol);
+
+			ASSERT(oTabColumn.Name() == oSQLColumn.m_strName);
+			ASSERT(!((oTabColumn.ColType() == MDCT_FXDSTR) && (oTabColumn.Length() < oSQLColumn.m_nSize)));
+#endif
+			rCursor.MapColumn(iSQLCol, iTabCol, oTabColumn.ColType(), oTabColumn.Length());
+			++iSQLCol;
+		}
+	}
+}
+
 /******************************************************************************
 ** Method:		Write*()
 **
@@ -1306,14 +2953,92 @@ void CTable::WriteDeletions(CSQLSource& /*rSource*/)
 
 void CTable::ResetRowFlags()
 {
-	// Update all rows.
-	for (size_t i = 0; i < RowCount(); ++i)
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
+	// Update all rows, without loading any deferred ones.
+	for (size_t i = 0; i < m_vRows.Count(); ++i)
 		m_vRows[i].ResetStatus();
 
 	// Update table counters.
 	m_nInsertions = 0;
 	m_nUpdates    = 0;
 	m_nDeletions  = 0;
+	m_nRefreshes  = 0;
+	m_vDeletedKeys.DeleteAll();
+}
+
+/******************************************************************************
+** Method:		LoadPending()
+**
+** Description:	Reads the rows deferred by a lazily loaded table, see
+**				CSnapshot::Read(). This is invoked by Load() the first time
+**				the rows are accessed, which must not happen concurrently on
+**				more than one thread as the snapshot reference count isn't
+**				thread-safe. For concurrent tables the loads are serialised
+**				instead and readers that raced to load it just wait.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CTable::LoadPending()
+{
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+	CReadWriteLock::WriteGuard oLoadGuard(s_oLoadLock, Concurrent());
+
+	// Loaded by another thread whilst waiting?
+	if (m_pPending.get() == nullptr)
+		return;
+
+	CSnapshotPtr pSnapshot = m_pPending;
+
+	// Avoid recursing whilst the rows are read.
+	m_pPending.reset();
+
+	try
+	{
+		CSnapshot::Read(pSnapshot, *this);
+	}
+	catch (...)
+	{
+		// Leave it to be retried.
+		m_pPending = pSnapshot;
+		throw;
+	}
+}
+
+/******************************************************************************
+** Method:		ChangeLog()
+**
+** Description:	Attaches the change log that the tables' insertions, updates
+**				and deletions are written to, or detaches it if NULL. The table
+**				must have an indexed primary key or unique column to identify
+**				the rows by, see CChangeLog::KeyColumn(). Transient tables are
+**				never logged.
+**
+** Parameters:	pLog	The change log or NULL.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CTable::ChangeLog(CChangeLog* pLog)
+{
+	CReadWriteLock::WriteGuard oGuard(m_oLock, Concurrent());
+
+	// Ignore if a temporary table.
+	if (Transient())
+		return;
+
+	// Check the rows can be identified.
+	if (pLog != nullptr)
+		CChangeLog::KeyColumn(*this);
+
+	m_pChangeLog = pLog;
 }
 
 /******************************************************************************
@@ -1456,6 +3181,10 @@ void CTable::Dump(WCL::IOutputStream& rStream) const
 	CString			strColList;
 	size_t			nRowWidth = 0;
 
+	Load();
+
+	CReadWriteLock::ReadGuard oGuard(m_oLock, Concurrent());
+
 	// Get the column widths and name list.
 	for (size_t i = 0; i < m_vColumns.Count(); ++i)
 	{
@@ -1521,8 +3250,8 @@ void CTable::Dump(WCL::IOutputStream& rStream) const
 	tchar* psPad = psUnderline;
 	std::fill(psPad, psPad+nRowWidth, TXT(' '));
 
-	// For all rows.
-	for (size_t r = 0; r < RowCount(); ++r)
+	// For all rows. The lock is already held shared and cannot be re-acquired.
+	for (size_t r = 0; r < m_vRows.Count(); ++r)
 	{
 		CRow& oRow = m_vRows[r];
 
@@ -17,6 +17,14 @@
 
 #include "ColumnSet.hpp"
 #include "RowSet.hpp"
+#include "Snapshot.hpp"
+#include "ValueSet.hpp"
+#include "ReadWriteLock.hpp"
+#include "QueryStats.hpp"
+#include "MemoryUsage.hpp"
+#include "Epoch.hpp"
+#include <vector>
+#include <utility>
 
 /******************************************************************************
 **
@@ -35,6 +43,9 @@ public:
 	//! The default smart pointer type.
 	typedef Core::SharedPtr<CTable> Ptr;
 
+	//! Keeps the rows found without the table lock from being freed.
+	class RowGuard;
+
 public:
 	//
 	// Constructors/Destructor.
@@ -54,6 +65,11 @@ public:
 	const CString& Name() const;
 	bool Transient() const;
 	bool ReadOnly() const;
+	bool LazyLoad() const;
+	bool Loaded() const;
+	bool Concurrent() const;
+	bool KeepsStats() const;
+	CChangeLog* ChangeLog() const;
 
 	//
 	// Column methods.
@@ -65,6 +81,7 @@ public:
 	virtual void DropColumn(size_t nColumn);
 	virtual void DropAllColumns();
 	virtual size_t FindColumn(const tchar* pszName);
+	virtual size_t KeyColumn() const;
 
 	//
 	// Index methods.
@@ -96,7 +113,21 @@ public:
 	virtual CResultSet SelectAll() const;
 	virtual CRow*      SelectRow(size_t nColumn, const CValue& oValue) const;
 	virtual CResultSet Select(const CWhere& oQuery) const;
+	virtual CResultSet Select(const CWhere& oQuery, CQueryStats& oStats) const;
 	virtual bool       Exists(const CWhere& oQuery) const;
+	virtual CRowCursor Query() const;
+	virtual CString    Explain(const CWhere& oQuery) const;
+
+	//
+	// Statistics methods.
+	//
+	CQueryStats Statistics() const;
+	void        ResetStatistics();
+
+	//
+	// Memory accounting methods.
+	//
+	virtual CMemoryUsage MemoryUsage() const;
 
 	//
 	// Save type flags.
@@ -119,11 +150,22 @@ public:
 	virtual void Read (WCL::IInputStream&  rStream);
 	virtual void Write(WCL::IOutputStream& rStream);
 
+	virtual void ReadDelta (WCL::IInputStream&  rStream);
+	virtual void WriteDelta(WCL::IOutputStream& rStream);
+
+	virtual void ReadCompressed (WCL::IInputStream&  rStream);
+	virtual void WriteCompressed(WCL::IOutputStream& rStream);
+
 	virtual void Read(CSQLSource& rSource);
 	virtual void Write(CSQLSource& rSource, RowTypes eRows = ALL);
+	virtual void Refresh(CSQLSource& rSource, bool bDeletions = false);
 
 	virtual void ResetRowFlags();
 
+	virtual void Load() const;
+
+	virtual void ChangeLog(CChangeLog* pLog);
+
 	//
 	// Table type flags.
 	//
@@ -135,7 +177,16 @@ public:
 		READ_WRITE = 0x00,
 		READ_ONLY  = 0x02,
 
-		DEFAULTS   = (PERSISTENT | READ_WRITE),
+		EAGER_LOAD = 0x00,
+		LAZY_LOAD  = 0x04,
+
+		SERIAL     = 0x00,
+		CONCURRENT = 0x08,
+
+		NO_STATS    = 0x00,
+		QUERY_STATS = 0x10,
+
+		DEFAULTS   = (PERSISTENT | READ_WRITE | EAGER_LOAD | SERIAL | NO_STATS),
 	};
 
 	//
@@ -144,29 +195,66 @@ public:
 	virtual void Dump(WCL::IOutputStream& rStream) const;
 
 protected:
+	//
+	// Internal types.
+	//
+
+	// A deleted row and the epoch it was retired in.
+	typedef std::pair<CRow*, LONG> RetiredRow;
+	// A released snapshot mapping and the epoch it was retired in.
+	typedef std::pair<CSnapshotPtr, LONG> RetiredSnapshot;
+
 	//
 	// Members.
 	//
 	CString		m_strName;		// The name.
 	uint		m_nFlags;		// Flags..
+	volatile LONG_PTR m_nDataBytes;		// The row buffers allocated.
+	volatile LONG_PTR m_nFieldBytes;	// The row and field headers allocated.
+	volatile LONG_PTR m_nStringBytes;	// The MDCT_VARSTR buffers allocated.
 	CColumnSet	m_vColumns;		// The set of columns.
 	CRowSet		m_vRows;		// The set of rows.
 	size_t		m_nInsertions;	// Rows inserted.
 	size_t		m_nUpdates;		// Fields updated.
 	size_t		m_nDeletions;	// Rows removed.
+	size_t		m_nRefreshes;	// Rows changed by Refresh().
 	size_t		m_nIdentCol;	// Identity column, if one.
 	int			m_nIdentVal;	// Next identity value.
+	size_t		m_nVersionCol;	// Row version column, if one.
+	mutable int64 m_nMaxVersion;	// Highest row version, if known.
+	mutable bool m_bMaxVersion;	// Is the highest row version known?
 	CRow*		m_pNullRow;		// The null row, if created.
 	CString		m_strSQLTable;	// SQL table name, if different.
 	CString		m_strSQLWhere;	// SQL WHERE clause.
 	CString		m_strSQLGroup;	// SQL GROUP BY clause.
 	CString		m_strSQLOrder;	// SQL ORDER BY clause.
+	CSnapshotPtr m_pSnapshot;	// The snapshot mapped rows refer to.
+	CSnapshotPtr m_pPending;	// The snapshot to load the rows from, if deferred.
+	CChangeLog*	m_pChangeLog;	// The change log, if attached.
+	CValueSet	m_vDeletedKeys;	// Keys of rows deleted since the flags were reset.
+	CBackgroundSnapshot* m_pBackground;	// The background snapshot, if one is running.
+	mutable CReadWriteLock m_oLock;	// The rows, indexes and counters lock, if concurrent.
+	CVersionStore* m_pVersions;	// The version store, if in a database.
+	mutable CTableStats m_oStats;	// The query statistics, if kept.
+	mutable CEpoch m_oReaders;	// The readers of rows found without the lock.
+	std::vector<RetiredRow> m_vRetired;	// Deleted rows the readers may still be using.
+	std::vector<RetiredSnapshot> m_vRetiredSnapshots;	// Mappings the retired rows may refer to.
+
+	// The number of deleted rows held before they are freed.
+	static const size_t MAX_RETIRED = 1024;
 
 	//
 	// Friends.
 	//
+	friend class CMDB;
 	friend class CRow;
 	friend class CField;
+	friend class CSnapshot;
+	friend class CChangeLog;
+	friend class CBackgroundSnapshot;
+	friend class CVersionStore;
+	friend class CReadView;
+	friend class CBulkLoader;
 
 	//
 	// Template methods. (ala Triggers).
@@ -181,7 +269,24 @@ protected:
 	//
 	virtual CString SQLColumnList() const;
 	virtual CString SQLQuery() const;
+	virtual CString SQLQuery(const CString& strFilter) const;
+	virtual int64   MaxRowVersion() const;
+	void            TrackVersion(const CRow& oRow);
+	virtual void    MapSQLColumns(CSQLCursor& rCursor) const;
 	virtual void    TruncateIndexes();
+	virtual void    ReleaseRows();
+	virtual void    FreeRow(CRow& oRow);
+	virtual void    ReclaimRows();
+	virtual void    ReclaimAllRows();
+	void            ReleaseSnapshot();
+	virtual void    ReadRows(WCL::IInputStream& rStream);
+	virtual void    LogReload();
+	virtual void    LoadPending();
+	virtual void    TrackDeletion(const CRow& oRow);
+	CRow*           FindRow(size_t nColumn, const CValue& oValue) const;
+	void            TableOrder(CResultSet& oRS) const;
+	void            TrackMemory(const CMemoryUsage& oRow, bool bAllocated);
+	void            TrackStrings(ptrdiff_t nBytes);
 	virtual void    WriteInsertions(CSQLSource& rSource);
 	virtual void    WriteUpdates(CSQLSource& rSource);
 	virtual void    WriteDeletions(CSQLSource& rSource);
@@ -199,6 +304,39 @@ private:
 	CTable& operator=(const CTable&);
 };
 
+/******************************************************************************
+**
+** Keeps the rows found by a SelectRow() on a CONCURRENT table, which searches
+** the unique column index without the table lock, from being freed whilst the
+** guard is held. A row deleted by the writer is only freed once the guards,
+** and searches, that may have found it have ended, see CEpoch.
+**
+** A deleted row is tagged with the current epoch and freed by a later change
+** once the epoch has moved on far enough, so the writer never waits for the
+** guards whilst holding the table lock. Only DropColumn() and writing a
+** snapshot of a READ_ONLY table wait for them, see ReclaimAllRows(), and so
+** the guard must not be held across those.
+**
+*******************************************************************************
+*/
+
+class CTable::RowGuard /*: private NotCopyable*/
+{
+public:
+	//! Constructor.
+	RowGuard(const CTable& oTable);
+
+	//! Destructor.
+	~RowGuard();
+
+private:
+	CEpoch::ReadGuard	m_oGuard;	// The read of the table rows.
+
+	// NotCopyable.
+	RowGuard(const RowGuard&);
+	RowGuard& operator=(const RowGuard&);
+};
+
 /******************************************************************************
 **
 ** Implementation of inline functions.
@@ -221,6 +359,41 @@ inline bool CTable::ReadOnly() const
 	return (m_nFlags & READ_ONLY);
 }
 
+inline bool CTable::LazyLoad() const
+{
+	return (m_nFlags & LAZY_LOAD);
+}
+
+inline bool CTable::Loaded() const
+{
+	return (m_pPending.get() == nullptr);
+}
+
+inline bool CTable::Concurrent() const
+{
+	return (m_nFlags & CONCURRENT);
+}
+
+inline bool CTable::KeepsStats() const
+{
+	return (m_nFlags & QUERY_STATS);
+}
+
+inline CQueryStats CTable::Statistics() const
+{
+	return m_oStats.Totals();
+}
+
+inline void CTable::ResetStatistics()
+{
+	m_oStats.Reset();
+}
+
+inline CChangeLog* CTable::ChangeLog() const
+{
+	return m_pChangeLog;
+}
+
 inline size_t CTable::ColumnCount() const
 {
 	return m_vColumns.Count();
@@ -238,22 +411,50 @@ inline size_t CTable::FindColumn(const tchar* pszName)
 
 inline size_t CTable::RowCount() const
 {
+	Load();
+
+	CReadWriteLock::ReadGuard oGuard(m_oLock, Concurrent());
+
 	return m_vRows.Count();
 }
 
 inline CRow& CTable::Row(size_t n) const
 {
+	Load();
+
+	CReadWriteLock::ReadGuard oGuard(m_oLock, Concurrent());
+
 	return m_vRows.Row(n);
 }
 
 inline CRow& CTable::operator[](size_t n) const
 {
+	Load();
+
+	CReadWriteLock::ReadGuard oGuard(m_oLock, Concurrent());
+
 	return m_vRows.Row(n);
 }
 
+inline void CTable::Load() const
+{
+	// Rows still to be read from a snapshot?
+	if (m_pPending.get() != nullptr)
+		const_cast<CTable*>(this)->LoadPending();
+}
+
 inline bool CTable::IsNullRow(CRow& oRow) const
 {
 	return (&oRow == m_pNullRow);
 }
 
+inline CTable::RowGuard::RowGuard(const CTable& oTable)
+	: m_oGuard(oTable.m_oReaders)
+{
+}
+
+inline CTable::RowGuard::~RowGuard()
+{
+}
+
 #endif //TABLE_HPP
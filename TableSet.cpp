@@ -10,7 +10,9 @@
 #include "Common.hpp"
 #include "TableSet.hpp"
 #include "Table.hpp"
+#include "Column.hpp"
 #include <Core/Algorithm.hpp>
+#include <algorithm>
 
 /******************************************************************************
 ** Method:		Constructor.
@@ -48,3 +50,72 @@ void CTableSet::Delete(size_t nTable)
 {
 	Core::deleteAt(*this, nTable);
 }
+
+/******************************************************************************
+** Method:		DependencyLevels()
+**
+** Description:	Groups the tables so that every table is in a later level than
+**				the tables its foreign key columns refer to. The tables within
+**				a level are independent and can be loaded concurrently, as long
+**				as the levels themselves are loaded in order. References to
+**				tables outside the set and to the table itself are ignored, as
+**				are any cycles.
+**
+** Parameters:	vLevels		The returned levels.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CTableSet::DependencyLevels(Levels& vLevels) const
+{
+	size_t              nTables = Count();
+	std::vector<size_t> vDepth(nTables, 0);
+
+	// Push tables below the ones they refer to, until nothing moves.
+	// NB: A cycle never settles, so stop after the longest possible chain.
+	for (size_t nPass = 0; nPass < nTables; ++nPass)
+	{
+		bool bMoved = false;
+
+		for (size_t t = 0; t != nTables; ++t)
+		{
+			const CTable& oTable = Table(t);
+
+			for (size_t c = 0; c != oTable.ColumnCount(); ++c)
+			{
+				const CTable* pFKTable = oTable.Column(c).FKTable();
+
+				if ( (pFKTable == nullptr) || (pFKTable == &oTable) )
+					continue;
+
+				Collection::const_iterator it = std::find(begin(), end(), pFKTable);
+
+				if (it == end())
+					continue;
+
+				size_t nFKDepth = vDepth[it - begin()];
+
+				if (vDepth[t] <= nFKDepth)
+				{
+					vDepth[t] = nFKDepth + 1;
+					bMoved    = true;
+				}
+			}
+		}
+
+		if (!bMoved)
+			break;
+	}
+
+	vLevels.clear();
+
+	for (size_t t = 0; t != nTables; ++t)
+	{
+		if (vDepth[t] >= vLevels.size())
+			vLevels.resize(vDepth[t] + 1);
+
+		vLevels[vDepth[t]].push_back(&Table(t));
+	}
+}
@@ -17,6 +17,7 @@
 
 #include "FwdDecls.hpp"
 #include <Core/Algorithm.hpp>
+#include <vector>
 
 /******************************************************************************
 ** 
@@ -27,6 +28,17 @@
 
 class CTableSet : private std::vector<CTable*>
 {
+public:
+	//
+	// Types.
+	//
+
+	//! A list of tables.
+	typedef std::vector<CTable*> Tables;
+
+	//! Lists of tables grouped by foreign key dependency.
+	typedef std::vector<Tables> Levels;
+
 public:
 	//
 	// Constructors/Destructor.
@@ -45,6 +57,8 @@ public:
 	void Remove(size_t nTable);
 	void Delete(size_t nTable);
 
+	void DependencyLevels(Levels& vLevels) const;
+
 protected:
 	//
 	// Members.
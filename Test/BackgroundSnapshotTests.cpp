@@ -0,0 +1,254 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   BackgroundSnapshotTests.cpp
+//! \brief  The unit tests for the BackgroundSnapshot class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/MDB.hpp>
+#include <MDBL/BackgroundSnapshot.hpp>
+#include <MDBL/LocalSource.hpp>
+#include <WCL/MemStream.hpp>
+
+namespace
+{
+
+static const int ROW_COUNT = 3000;
+
+static void createSchema(CTable& table)
+{
+	table.AddColumn(TXT("ID"),    MDCT_IDENTITY, 0,  CColumn::IDENTITY);
+	table.AddColumn(TXT("Name"),  MDCT_VARSTR,   50, CColumn::NULLABLE);
+	table.AddColumn(TXT("Price"), MDCT_DOUBLE,   0,  CColumn::DEFAULTS);
+}
+
+static void insertRow(CTable& table, const tchar* name, double price)
+{
+	CRow& row = table.CreateRow();
+	row[1] = name;
+	row[2] = price;
+	table.InsertRow(row);
+}
+
+//! A memory stream that blocks writes until it is opened.
+class GatedStream : public CMemStream
+{
+public:
+	GatedStream(CBuffer& buffer)
+		: CMemStream(buffer)
+		, m_hGate(::CreateEvent(nullptr, TRUE, FALSE, nullptr))
+	{
+	}
+
+	~GatedStream()
+	{
+		::CloseHandle(m_hGate);
+	}
+
+	void OpenGate()
+	{
+		::SetEvent(m_hGate);
+	}
+
+	virtual size_t Write(const void* buffer, size_t count)
+	{
+		::WaitForSingleObject(m_hGate, INFINITE);
+
+		return CMemStream::Write(buffer, count);
+	}
+
+private:
+	HANDLE	m_hGate;
+};
+
+}
+
+TEST_SET(BackgroundSnapshot)
+{
+
+TEST_CASE("the snapshot contains the rows as they were when it was started")
+{
+	CBuffer buffer;
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CTable other(TXT("Other"));
+		createSchema(other);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.AddTable(other);
+
+		for (int i = 1; i <= ROW_COUNT; ++i)
+			insertRow(table, TXT("Row"), i);
+
+		for (int i = 1; i <= 10; ++i)
+			insertRow(other, TXT("Other"), i);
+
+		GatedStream stream(buffer);
+		stream.Create();
+
+		CBackgroundSnapshot snapshot(mdb, stream);
+
+		TEST_TRUE(table.Modified());
+		TEST_FALSE(snapshot.Finished());
+
+		table[0][1] = TXT("Changed");
+		table[0][1] = TXT("Changed again");
+		table[1][1] = null;
+		table[ROW_COUNT-1][2] = 0.5;
+		table.DeleteRow(table[2]);
+		insertRow(table, TXT("New"), 0.0);
+		table[table.RowCount()-1][2] = 1.5;
+		other.Truncate();
+
+		TEST_TRUE(table.Modified());
+
+		stream.OpenGate();
+		snapshot.Wait();
+
+		TEST_TRUE(snapshot.Finished());
+
+		table[3][1] = TXT("After");
+
+		stream.Close();
+
+		TEST_TRUE(table.RowCount() == ROW_COUNT);
+		TEST_TRUE(table[0][1].GetString() == tstring(TXT("Changed again")));
+		TEST_TRUE(other.RowCount() == 0);
+	}
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	CTable other(TXT("Other"));
+	createSchema(other);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+	mdb.AddTable(other);
+
+	CMemStream stream(buffer);
+	stream.Open();
+	mdb.Read(stream);
+	stream.Close();
+
+	TEST_TRUE(table.RowCount() == ROW_COUNT);
+	TEST_TRUE(table[0][1].GetString() == tstring(TXT("Row")));
+	TEST_TRUE(table[1][1] != null);
+	TEST_TRUE(table[2][0] == 3);
+	TEST_TRUE(table[3][1].GetString() == tstring(TXT("Row")));
+	TEST_TRUE(table[ROW_COUNT-1][2] == static_cast<double>(ROW_COUNT));
+	TEST_TRUE(table.SelectRow(0, ROW_COUNT+1) == nullptr);
+	TEST_TRUE(other.RowCount() == 10);
+
+	insertRow(table, TXT("Next"), 0.0);
+
+	TEST_TRUE(table[ROW_COUNT][0] == ROW_COUNT+1);
+}
+TEST_CASE_END
+
+TEST_CASE("the changes pending for a SQL source are not lost by a snapshot")
+{
+	CLocalSource source(TXT(""));
+	CBuffer      buffer;
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		source.CreateTable(table);
+	}
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+
+		insertRow(table, TXT("First"), 1.0);
+		insertRow(table, TXT("Second"), 2.0);
+
+		GatedStream stream(buffer);
+		stream.Create();
+
+		CBackgroundSnapshot snapshot(mdb, stream);
+
+		table[0][1] = TXT("Changed");
+		insertRow(table, TXT("Third"), 3.0);
+
+		stream.OpenGate();
+		snapshot.Wait();
+		stream.Close();
+
+		TEST_TRUE(table.Modified());
+
+		source.BeginTrans();
+		table.Write(source);
+		source.CommitTrans();
+	}
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+
+		CMemStream stream(buffer);
+		stream.Open();
+		mdb.Read(stream);
+		stream.Close();
+
+		TEST_TRUE(table.RowCount() == 2);
+		TEST_TRUE(table[0][1].GetString() == tstring(TXT("First")));
+		TEST_TRUE(table[1][1].GetString() == tstring(TXT("Second")));
+	}
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	table.Read(source);
+
+	TEST_TRUE(table.RowCount() == 3);
+	TEST_TRUE(table[0][1].GetString() == tstring(TXT("Changed")));
+	TEST_TRUE(table[2][1].GetString() == tstring(TXT("Third")));
+}
+TEST_CASE_END
+
+TEST_CASE("a table that is modified after the snapshot has finished is not copied")
+{
+	CBuffer buffer;
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	insertRow(table, TXT("Row"), 1.0);
+
+	CMemStream stream(buffer);
+	stream.Create();
+
+	CBackgroundSnapshot snapshot(mdb, stream);
+
+	while (!snapshot.Finished())
+		::Sleep(1);
+
+	table[0][1] = TXT("Changed");
+	table.DeleteRow(0);
+
+	snapshot.Wait();
+	stream.Close();
+
+	TEST_TRUE(buffer.Size() != 0);
+	TEST_TRUE(table.RowCount() == 0);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   BlockCodecTests.cpp
+//! \brief  The unit tests for the BlockCodec class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/BlockCodec.hpp>
+#include <MDBL/MDBException.hpp>
+
+TEST_SET(BlockCodec)
+{
+
+TEST_CASE("a block decompresses to the original data")
+{
+	std::vector<byte> input;
+
+	for (size_t i = 0; i != 100000; ++i)
+		input.push_back(static_cast<byte>((i % 1000 < 500) ? (i % 7) : ((i * 2654435761U) >> 24)));
+
+	std::vector<byte> packed;
+	std::vector<byte> output(input.size());
+
+	CBlockCodec::Compress(&input[0], input.size(), packed);
+
+	TEST_TRUE(packed.size() < input.size());
+
+	CBlockCodec::Decompress(&packed[0], packed.size(), &output[0], output.size());
+
+	TEST_TRUE(output == input);
+}
+TEST_CASE_END
+
+TEST_CASE("short and empty blocks are stored as literals")
+{
+	const byte input[] = { 1, 2, 3 };
+
+	std::vector<byte> packed;
+	byte              output[3] = { 0 };
+
+	CBlockCodec::Compress(input, sizeof(input), packed);
+	CBlockCodec::Decompress(&packed[0], packed.size(), output, sizeof(output));
+
+	TEST_TRUE(memcmp(input, output, sizeof(input)) == 0);
+
+	CBlockCodec::Compress(input, 0, packed);
+
+	TEST_TRUE(packed.size() == 1);
+
+	CBlockCodec::Decompress(&packed[0], packed.size(), output, 0);
+}
+TEST_CASE_END
+
+TEST_CASE("decompressing a corrupt block throws")
+{
+	std::vector<byte> input(1000, 42);
+	std::vector<byte> packed;
+	std::vector<byte> output(input.size());
+
+	CBlockCodec::Compress(&input[0], input.size(), packed);
+
+	TEST_THROWS(CBlockCodec::Decompress(&packed[0], packed.size()-1, &output[0], output.size()));
+	TEST_THROWS(CBlockCodec::Decompress(&packed[0], packed.size(), &output[0], output.size()-1));
+
+	packed[2] = 0xFF;
+	packed[3] = 0xFF;
+
+	TEST_THROWS(CBlockCodec::Decompress(&packed[0], packed.size(), &output[0], output.size()));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,287 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   BulkLoaderTests.cpp
+//! \brief  The unit tests for the BulkLoader class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/Table.hpp>
+#include <MDBL/BulkLoader.hpp>
+#include <MDBL/MDBException.hpp>
+#include <MDBL/TimeStamp.hpp>
+#include <MDBL/MDB.hpp>
+#include <MDBL/ReadView.hpp>
+#include <MDBL/ResultSet.hpp>
+#include <MDBL/ChangeLog.hpp>
+
+namespace
+{
+
+static void createSchema(CTable& table)
+{
+	table.AddColumn(TXT("ID"),    MDCT_IDENTITY, 0,  CColumn::IDENTITY);
+	table.AddColumn(TXT("Name"),  MDCT_VARSTR,   50, CColumn::NULLABLE);
+	table.AddColumn(TXT("Code"),  MDCT_FXDSTR,   4,  CColumn::NULLABLE);
+	table.AddColumn(TXT("Price"), MDCT_DOUBLE,   0,  CColumn::DEFAULTS);
+	table.AddColumn(TXT("Valid"), MDCT_BOOL,     0,  CColumn::NULLABLE);
+	table.AddColumn(TXT("Date"),  MDCT_DATE,     0,  CColumn::NULLABLE);
+}
+
+static size_t load(const CBulkLoader& loader, const tstring& text, CTable& table)
+{
+	return loader.Load(text.c_str(), text.length(), table);
+}
+
+static tstring createText(int rows)
+{
+	tstring text;
+
+	for (int i = 1; i <= rows; ++i)
+	{
+		text += Core::fmt(TXT("%d,\"Name, %d\",C%d,%d.5,%s,2001-02-%02d\n"),
+							i, i, i % 100, i, (i % 2) ? TXT("true") : TXT("0"), (i % 28) + 1);
+	}
+
+	return text;
+}
+
+}
+
+TEST_SET(BulkLoader)
+{
+
+TEST_CASE("values are converted to the column types")
+{
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	const tstring text = TXT("1,First,AB,3.5,1,2001-02-03\n")
+						 TXT("2,,,-1e2,false,\n")
+						 TXT("\n")
+						 TXT("3,Third,,0,,2001-12-31");
+
+	TEST_TRUE(load(CBulkLoader(), text, table) == 3);
+	TEST_TRUE(table.RowCount() == 3);
+
+	TEST_TRUE(table[0][0] == 1);
+	TEST_TRUE(tstrcmp(table[0][1].GetString(), TXT("First")) == 0);
+	TEST_TRUE(tstrcmp(table[0][2].GetString(), TXT("AB")) == 0);
+	TEST_TRUE(table[0][3] == 3.5);
+	TEST_TRUE(table[0][4].GetBool() == true);
+	TEST_TRUE(table[0][5].GetTimeT() == CTimeStamp(2001, 2, 3, 0, 0, 0).ToTimeT());
+
+	TEST_TRUE(table[1][1] == null);
+	TEST_TRUE(table[1][2] == null);
+	TEST_TRUE(table[1][3] == -100.0);
+	TEST_TRUE(table[1][4].GetBool() == false);
+	TEST_TRUE(table[1][5] == null);
+
+	TEST_TRUE(table[2][0] == 3);
+	TEST_TRUE(table[2][4] == null);
+	TEST_TRUE(table.SelectRow(0, 2) == &table[1]);
+	TEST_TRUE(!table.Modified());
+}
+TEST_CASE_END
+
+TEST_CASE("quoted values can contain delimiters, quotes and line breaks")
+{
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	const tstring text = TXT("1,\"A, \"\"quoted\"\"\nvalue\",,1,,\n")
+						 TXT("2,\"\",,2,,\n");
+
+	TEST_TRUE(load(CBulkLoader(), text, table) == 2);
+	TEST_TRUE(tstrcmp(table[0][1].GetString(), TXT("A, \"quoted\"\nvalue")) == 0);
+	TEST_TRUE(table[1][1] != null);
+	TEST_TRUE(tstrcmp(table[1][1].GetString(), TXT("")) == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a header line maps the values to the named columns")
+{
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	const tstring text = TXT("price;\"id\";NAME\n")
+						 TXT("1.5;7;Seventh\n")
+						 TXT("2.5;9;Ninth\n");
+
+	TEST_TRUE(load(CBulkLoader(TXT(';'), CBulkLoader::HEADER), text, table) == 2);
+	TEST_TRUE(table[0][0] == 7);
+	TEST_TRUE(tstrcmp(table[0][1].GetString(), TXT("Seventh")) == 0);
+	TEST_TRUE(table[0][2] == null);
+	TEST_TRUE(table[1][3] == 2.5);
+
+	CRow& row = table.CreateRow();
+	row[3] = 0.0;
+	table.InsertRow(row);
+
+	TEST_TRUE(row[0] == 10);
+
+	CTable other(TXT("Test"));
+	createSchema(other);
+
+	TEST_THROWS(load(CBulkLoader(TXT(','), CBulkLoader::HEADER), TXT("ID,Missing\n1,2\n"), other));
+	TEST_THROWS(load(CBulkLoader(TXT(','), CBulkLoader::HEADER), TXT("ID,Name\n1,Name\n"), other));
+}
+TEST_CASE_END
+
+TEST_CASE("chunks parsed concurrently load the same rows as a serial load")
+{
+	const tstring text = createText(1000);
+
+	CTable serial(TXT("Test"));
+	createSchema(serial);
+
+	CTable chunked(TXT("Test"));
+	createSchema(chunked);
+
+	TEST_TRUE(load(CBulkLoader(TXT(','), CBulkLoader::SERIAL), text, serial) == 1000);
+	TEST_TRUE(load(CBulkLoader(TXT(','), CBulkLoader::DEFAULTS, 64), text, chunked) == 1000);
+
+	bool equal = true;
+
+	for (size_t r = 0; r != serial.RowCount(); ++r)
+	{
+		equal = equal && (serial[r][0] == chunked[r][0])
+					  && (tstrcmp(serial[r][1].GetString(), chunked[r][1].GetString()) == 0)
+					  && (tstrcmp(serial[r][2].GetString(), chunked[r][2].GetString()) == 0)
+					  && (serial[r][3] == chunked[r][3])
+					  && (serial[r][4] == chunked[r][4])
+					  && (serial[r][5] == chunked[r][5]);
+	}
+
+	TEST_TRUE(equal);
+	TEST_TRUE(chunked[999][0] == 1000);
+	TEST_TRUE(tstrcmp(chunked[999][1].GetString(), TXT("Name, 1000")) == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("invalid values leave the table unchanged")
+{
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	load(CBulkLoader(), TXT("1,First,,1,,\n"), table);
+
+	const tstring invalid[] =
+	{
+		TXT("1,,,1,,\n2,,,x,,\n"),
+		TXT("1,,,1,,\n2,,,,,\n"),
+		TXT("1,,TooLong,1,,\n"),
+		TXT("1,,,1,maybe,\n"),
+		TXT("1,,,1,,2001-13-01\n"),
+		TXT("1,,,1,,,\n"),
+		TXT("1,\"Unterminated,,1,,\n"),
+	};
+
+	for (size_t i = 0; i != sizeof(invalid)/sizeof(invalid[0]); ++i)
+	{
+		TEST_THROWS(load(CBulkLoader(TXT(','), CBulkLoader::DEFAULTS, 8), invalid[i], table));
+		TEST_TRUE(table.RowCount() == 1);
+	}
+
+	TEST_TRUE(tstrcmp(table[0][1].GetString(), TXT("First")) == 0);
+
+	tstring error;
+
+	try
+	{
+		load(CBulkLoader(), TXT("1,,,1,,\n2,,,1,,\n3,,,x,,\n"), table);
+	}
+	catch (const CMDBException& e)
+	{
+		error = e.twhat();
+	}
+
+	TEST_TRUE(error.find(TXT("line 3")) != tstring::npos);
+
+	TEST_THROWS(load(CBulkLoader(), TXT("1,,,1,,\n1,,,2,,\n"), table));
+	TEST_TRUE(table.RowCount() == 1);
+	TEST_TRUE(tstrcmp(table[0][1].GetString(), TXT("First")) == 0);
+	TEST_TRUE(table.SelectRow(0, 1) == &table[0]);
+
+	TEST_THROWS(load(CBulkLoader(TXT(','), CBulkLoader::DEFAULTS, 8), TXT("1,,,1,,\n2,,,2,,\n3,,,3,,\n2,,,4,,\n"), table));
+	TEST_TRUE(table.RowCount() == 1);
+	TEST_TRUE(tstrcmp(table[0][1].GetString(), TXT("First")) == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a reload replaces the rows as a truncation does")
+{
+	const tchar* snapshot = TXT("BulkLoaderTests.snp");
+	const tchar* logfile  = TXT("BulkLoaderTests.log");
+
+	::DeleteFile(snapshot);
+	::DeleteFile(logfile);
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+
+		load(CBulkLoader(), TXT("1,First,,1,,\n2,Second,,2,,\n"), table);
+		mdb.WriteSnapshot(snapshot);
+
+		CChangeLog log(logfile);
+		mdb.ChangeLog(&log);
+
+		CReadView view(mdb);
+
+		TEST_TRUE(load(CBulkLoader(), TXT("3,Third,,3,,\n"), table) == 1);
+		log.Commit();
+		mdb.ChangeLog(nullptr);
+
+		TEST_TRUE(table.RowCount() == 1);
+		TEST_TRUE(view.SelectAll(table).Count() == 2);
+		TEST_TRUE(view.SelectRow(table, 0, 1) != nullptr);
+		TEST_TRUE(view.SelectRow(table, 0, 3) == nullptr);
+	}
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	mdb.Recover(snapshot, logfile);
+
+	TEST_TRUE(table.RowCount() == 1);
+	TEST_TRUE(table[0][0] == 3);
+	TEST_TRUE(tstrcmp(table[0][1].GetString(), TXT("Third")) == 0);
+
+	::DeleteFile(snapshot);
+	::DeleteFile(logfile);
+}
+TEST_CASE_END
+
+TEST_CASE("a table can be loaded from a file")
+{
+	const tchar*  file = TXT("BulkLoaderTests.csv");
+	const tstring text = createText(100);
+
+	HANDLE handle = ::CreateFile(file, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	DWORD  written = 0;
+
+	TEST_TRUE(handle != INVALID_HANDLE_VALUE);
+	TEST_TRUE(::WriteFile(handle, text.c_str(), static_cast<DWORD>(text.length() * sizeof(tchar)), &written, nullptr));
+
+	::CloseHandle(handle);
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	TEST_TRUE(CBulkLoader().Load(file, table) == 100);
+	TEST_TRUE(table[99][3] == 100.5);
+
+	::DeleteFile(file);
+
+	TEST_THROWS(CBulkLoader().Load(file, table));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,416 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ChangeLogTests.cpp
+//! \brief  The unit tests for the ChangeLog class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/MDB.hpp>
+#include <MDBL/ChangeLog.hpp>
+#include <MDBL/MDBException.hpp>
+#include <MDBL/LocalSource.hpp>
+#include <MDBL/ReadView.hpp>
+#include <WCL/MemStream.hpp>
+
+namespace
+{
+
+static const tchar* SNAPSHOT_FILE = TXT("ChangeLogTests.snp");
+static const tchar* LOG_FILE      = TXT("ChangeLogTests.log");
+
+static void createSchema(CTable& table)
+{
+	table.AddColumn(TXT("ID"),    MDCT_IDENTITY, 0,  CColumn::IDENTITY);
+	table.AddColumn(TXT("Name"),  MDCT_VARSTR,   50, CColumn::NULLABLE);
+	table.AddColumn(TXT("Price"), MDCT_DOUBLE,   0,  CColumn::DEFAULTS);
+}
+
+static CRow& insertRow(CTable& table, const tchar* name, double price)
+{
+	CRow& row = table.CreateRow();
+	row[1] = name;
+	row[2] = price;
+	table.InsertRow(row);
+
+	return row;
+}
+
+static void deleteFiles()
+{
+	::DeleteFile(SNAPSHOT_FILE);
+	::DeleteFile(LOG_FILE);
+}
+
+}
+
+TEST_SET(ChangeLog)
+{
+
+TEST_CASE("committed changes are replayed on top of the snapshot")
+{
+	deleteFiles();
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+
+		insertRow(table, TXT("First"), 1.0);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+
+		CChangeLog log(LOG_FILE);
+		mdb.ChangeLog(&log);
+
+		insertRow(table, TXT("Second"), 2.0);
+		CRow& third = insertRow(table, TXT("Third"), 3.0);
+		table[0][1] = null;
+		table[0][2] = 1.5;
+		table.DeleteRow(third);
+		insertRow(table, TXT("Fourth"), 4.0);
+
+		log.Commit();
+		mdb.ChangeLog(nullptr);
+	}
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	TEST_TRUE(mdb.Recover(SNAPSHOT_FILE, LOG_FILE) == 6);
+
+	TEST_TRUE(table.RowCount() == 3);
+	TEST_TRUE(table[0][0] == 1);
+	TEST_TRUE(table[0][1] == null);
+	TEST_TRUE(table[0][2] == 1.5);
+	TEST_TRUE(table[1][0] == 2);
+	TEST_TRUE(table[1][1].GetString() == tstring(TXT("Second")));
+	TEST_TRUE(table[2][0] == 4);
+	TEST_TRUE(table[2][1].GetString() == tstring(TXT("Fourth")));
+	TEST_TRUE(table.SelectRow(0, 4) == &table[2]);
+	TEST_TRUE(table.Modified());
+
+	deleteFiles();
+}
+TEST_CASE_END
+
+TEST_CASE("uncommitted changes are not replayed and are discarded when the log is reopened")
+{
+	deleteFiles();
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+
+		CChangeLog log(LOG_FILE);
+		mdb.ChangeLog(&log);
+
+		insertRow(table, TXT("First"), 1.0);
+		log.Commit(false);
+		insertRow(table, TXT("Second"), 2.0);
+
+		mdb.ChangeLog(nullptr);
+	}
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+
+		TEST_TRUE(mdb.Recover(SNAPSHOT_FILE, LOG_FILE) == 1);
+		TEST_TRUE(table.RowCount() == 1);
+
+		CChangeLog log(LOG_FILE);
+		mdb.ChangeLog(&log);
+
+		insertRow(table, TXT("Third"), 3.0);
+		log.Commit();
+
+		mdb.ChangeLog(nullptr);
+	}
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	TEST_TRUE(mdb.Recover(SNAPSHOT_FILE, LOG_FILE) == 2);
+	TEST_TRUE(table.RowCount() == 2);
+	TEST_TRUE(table[1][0] == 2);
+	TEST_TRUE(table[1][1].GetString() == tstring(TXT("Third")));
+
+	deleteFiles();
+}
+TEST_CASE_END
+
+TEST_CASE("a checkpoint writes a snapshot and empties the log")
+{
+	deleteFiles();
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	{
+		CChangeLog log(LOG_FILE);
+		mdb.ChangeLog(&log);
+
+		insertRow(table, TXT("First"), 1.0);
+		log.Commit();
+
+		mdb.Checkpoint(SNAPSHOT_FILE, log);
+		mdb.ChangeLog(nullptr);
+	}
+
+	TEST_TRUE(CChangeLog::Replay(LOG_FILE, mdb) == 0);
+	TEST_TRUE(table.RowCount() == 1);
+
+	deleteFiles();
+
+	TEST_TRUE(CChangeLog::Replay(LOG_FILE, mdb) == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("updates replayed into a concurrent table keep the previous values for a read view")
+{
+	deleteFiles();
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+
+		insertRow(table, TXT("First"), 1.0);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+
+		CChangeLog log(LOG_FILE);
+		mdb.ChangeLog(&log);
+
+		table[0][1] = TXT("Changed");
+		table[0][2] = 2.0;
+
+		log.Commit();
+		mdb.ChangeLog(nullptr);
+	}
+
+	CTable table(TXT("Test"), CTable::CONCURRENT);
+	createSchema(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+	mdb.ReadSnapshot(SNAPSHOT_FILE);
+
+	CReadView view(mdb);
+
+	TEST_TRUE(CChangeLog::Replay(LOG_FILE, mdb) == 2);
+	TEST_TRUE(table[0][1].GetString() == tstring(TXT("Changed")));
+	TEST_TRUE(table[0][2] == 2.0);
+
+	CRow* row = view.SelectRow(table, 0, 1);
+
+	TEST_TRUE(row != nullptr);
+	TEST_TRUE(row->Field(1).GetString() == tstring(TXT("First")));
+	TEST_TRUE(row->Field(2) == 1.0);
+
+	table[0][2] = 3.0;
+
+	TEST_TRUE(table[0][2] == 3.0);
+
+	deleteFiles();
+}
+TEST_CASE_END
+
+TEST_CASE("reloading a table is replayed as a truncation followed by the reloaded rows")
+{
+	deleteFiles();
+
+	CLocalSource source(TXT(""));
+	CBuffer      buffer;
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		source.CreateTable(table);
+
+		insertRow(table, TXT("A"), 1.0);
+		insertRow(table, TXT("B"), 2.0);
+		insertRow(table, TXT("C"), 3.0);
+
+		source.BeginTrans();
+		table.Write(source);
+		source.CommitTrans();
+	}
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+
+		insertRow(table, TXT("First"), 1.0);
+		insertRow(table, TXT("Second"), 2.0);
+
+		CMemStream stream(buffer);
+		stream.Create();
+		mdb.Write(stream);
+		stream.Close();
+
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+
+		CChangeLog log(LOG_FILE);
+		mdb.ChangeLog(&log);
+
+		table.Read(source);
+		log.Commit();
+
+		mdb.ChangeLog(nullptr);
+	}
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+
+		TEST_TRUE(mdb.Recover(SNAPSHOT_FILE, LOG_FILE) == 4);
+		TEST_TRUE(table.RowCount() == 3);
+		TEST_TRUE(table[2][1].GetString() == tstring(TXT("C")));
+		TEST_TRUE(table.SelectRow(0, table[0][0].GetInt()) == &table[0]);
+
+		CChangeLog log(LOG_FILE);
+		mdb.ChangeLog(&log);
+
+		CMemStream stream(buffer);
+		stream.Open();
+		mdb.Read(stream);
+		stream.Close();
+		log.Commit();
+
+		mdb.ChangeLog(nullptr);
+	}
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	TEST_TRUE(mdb.Recover(SNAPSHOT_FILE, LOG_FILE) == 7);
+	TEST_TRUE(table.RowCount() == 2);
+	TEST_TRUE(table[0][1].GetString() == tstring(TXT("First")));
+	TEST_TRUE(table[1][1].GetString() == tstring(TXT("Second")));
+
+	deleteFiles();
+}
+TEST_CASE_END
+
+TEST_CASE("reading a delta logs the changes it holds and keeps the previous values for a read view")
+{
+	deleteFiles();
+
+	CBuffer delta;
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+
+		insertRow(table, TXT("First"), 1.0);
+		insertRow(table, TXT("Second"), 2.0);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+
+		table[0][1] = TXT("Changed");
+		table.DeleteRow(table[1]);
+		insertRow(table, TXT("Third"), 3.0);
+
+		CMemStream stream(delta);
+		stream.Create();
+		mdb.WriteDelta(stream);
+		stream.Close();
+	}
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.ReadSnapshot(SNAPSHOT_FILE);
+
+		CChangeLog log(LOG_FILE);
+		mdb.ChangeLog(&log);
+
+		CReadView view(mdb);
+
+		CMemStream stream(delta);
+		stream.Open();
+		mdb.ReadDelta(stream);
+		stream.Close();
+		log.Commit();
+
+		TEST_TRUE(table.SelectRow(0, 1)->Field(1).GetString() == tstring(TXT("Changed")));
+		TEST_TRUE(view.SelectRow(table, 0, 1)->Field(1).GetString() == tstring(TXT("First")));
+		TEST_TRUE(view.SelectRow(table, 0, 2) != nullptr);
+		TEST_TRUE(view.SelectRow(table, 0, 3) == nullptr);
+
+		mdb.ChangeLog(nullptr);
+	}
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	TEST_TRUE(mdb.Recover(SNAPSHOT_FILE, LOG_FILE) != 0);
+	TEST_TRUE(table.RowCount() == 2);
+	TEST_TRUE(table.SelectRow(0, 1)->Field(1).GetString() == tstring(TXT("Changed")));
+	TEST_TRUE(table.SelectRow(0, 2) == nullptr);
+	TEST_TRUE(table.SelectRow(0, 3)->Field(1).GetString() == tstring(TXT("Third")));
+
+	deleteFiles();
+}
+TEST_CASE_END
+
+TEST_CASE("attaching a log to a table without an indexed key column throws")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 50, CColumn::DEFAULTS);
+
+	CChangeLog log(LOG_FILE);
+
+	TEST_THROWS(table.ChangeLog(&log));
+	TEST_TRUE(table.ChangeLog() == nullptr);
+
+	CTable temp(TXT("Temp"), CTable::TRANSIENT);
+	temp.AddColumn(TXT("Name"), MDCT_VARSTR, 50, CColumn::DEFAULTS);
+
+	temp.ChangeLog(&log);
+
+	TEST_TRUE(temp.ChangeLog() == nullptr);
+
+	deleteFiles();
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,35 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Crc32cTests.cpp
+//! \brief  The unit tests for the Crc32c class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/Crc32c.hpp>
+
+TEST_SET(Crc32c)
+{
+
+TEST_CASE("the checksum matches the standard check value")
+{
+	const char data[] = "123456789";
+
+	TEST_TRUE(CCrc32c::Calculate(data, 9) == 0xE3069283);
+	TEST_TRUE(CCrc32c::Calculate(data, 0) == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a checksum can be calculated in several parts")
+{
+	const char data[] = "The quick brown fox jumps over the lazy dog";
+	size_t     length = sizeof(data) - 1;
+
+	uint32 crc = CCrc32c::Calculate(data, 10);
+	crc = CCrc32c::Calculate(data + 10, length - 10, crc);
+
+	TEST_TRUE(crc == CCrc32c::Calculate(data, length));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
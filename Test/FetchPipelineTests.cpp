@@ -0,0 +1,197 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   FetchPipelineTests.cpp
+//! \brief  The unit tests for the FetchPipeline class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/FetchPipeline.hpp>
+#include <MDBL/SQLException.hpp>
+#include <vector>
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! A source that numbers its batches and optionally fails or blocks.
+
+class TestSource : public IFetchSource
+{
+public:
+	TestSource(size_t nBuffers, int nBatches)
+		: m_vBuffers(nBuffers, -1), m_vInUse(nBuffers, 0), m_nBatches(nBatches), m_nNext(0),
+		  m_nFailAt(-1), m_bBlock(false), m_hCancel(::CreateEvent(nullptr, TRUE, FALSE, nullptr)),
+		  m_nOverwrites(0), m_nCancels(0)
+	{ }
+
+	~TestSource()
+	{
+		::CloseHandle(m_hCancel);
+	}
+
+	virtual bool FetchBatch(size_t nBuffer)
+	{
+		if (m_vInUse[nBuffer] != 0)
+			::InterlockedIncrement(&m_nOverwrites);
+
+		if (m_nNext == m_nFailAt)
+			throw CSQLException(CSQLException::E_FETCH_FAILED, TXT("SELECT"), TXT("Fetch failed"));
+
+		if (m_nNext == m_nBatches)
+		{
+			// Wait for a cancel, as an in-progress fetch would.
+			if (m_bBlock)
+			{
+				::WaitForSingleObject(m_hCancel, INFINITE);
+				throw CSQLException(CSQLException::E_FETCH_FAILED, TXT("SELECT"), TXT("Cancelled"));
+			}
+
+			return false;
+		}
+
+		m_vBuffers[nBuffer] = m_nNext++;
+
+		return true;
+	}
+
+	virtual void CancelFetch()
+	{
+		::InterlockedIncrement(&m_nCancels);
+		::SetEvent(m_hCancel);
+	}
+
+	std::vector<int>			m_vBuffers;
+	std::vector<LONG>			m_vInUse;
+	int							m_nBatches;
+	int							m_nNext;
+	int							m_nFailAt;
+	bool						m_bBlock;
+	HANDLE						m_hCancel;
+	volatile LONG				m_nOverwrites;
+	volatile LONG				m_nCancels;
+};
+
+//! Consume the buffers, returning the batch numbers in the order received.
+static std::vector<int> consume(CFetchPipeline& pipeline, TestSource& source)
+{
+	std::vector<int> batches;
+	size_t           buffer = 0;
+
+	while (pipeline.NextBuffer(buffer))
+	{
+		::InterlockedExchange(&source.m_vInUse[buffer], 1);
+
+		batches.push_back(source.m_vBuffers[buffer]);
+		::Sleep(1);
+
+		::InterlockedExchange(&source.m_vInUse[buffer], 0);
+	}
+
+	return batches;
+}
+
+}
+
+TEST_SET(FetchPipeline)
+{
+
+TEST_CASE("every batch is handed to the consumer in the order fetched")
+{
+	TestSource     source(2, 50);
+	CFetchPipeline pipeline(source, 2);
+
+	pipeline.Start();
+
+	TEST_TRUE(pipeline.Running());
+
+	std::vector<int> batches = consume(pipeline, source);
+
+	bool ordered = (batches.size() == 50);
+
+	for (size_t i = 0; ordered && (i != batches.size()); ++i)
+		ordered = (batches[i] == static_cast<int>(i));
+
+	TEST_TRUE(ordered);
+
+	size_t buffer = 0;
+
+	TEST_FALSE(pipeline.NextBuffer(buffer));
+
+	pipeline.Stop();
+
+	TEST_FALSE(pipeline.Running());
+}
+TEST_CASE_END
+
+TEST_CASE("a buffer is not fetched into whilst the consumer still holds it")
+{
+	TestSource     source(2, 200);
+	CFetchPipeline pipeline(source, 2);
+
+	pipeline.Start();
+
+	TEST_TRUE(consume(pipeline, source).size() == 200);
+	TEST_TRUE(source.m_nOverwrites == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a fetch error is rethrown on the consumer after the batches before it")
+{
+	TestSource     source(2, 10);
+	CFetchPipeline pipeline(source, 2);
+
+	source.m_nFailAt = 3;
+
+	pipeline.Start();
+
+	size_t  buffer = 0;
+	int     batches = 0;
+	tstring error;
+
+	try
+	{
+		while (pipeline.NextBuffer(buffer))
+			++batches;
+	}
+	catch (const CSQLException& e)
+	{
+		TEST_TRUE(e.m_eError == CSQLException::E_FETCH_FAILED);
+
+		error = e.twhat();
+	}
+
+	TEST_TRUE(batches == 3);
+	TEST_TRUE(error.find(TXT("Fetch failed")) != tstring::npos);
+	TEST_FALSE(pipeline.NextBuffer(buffer));
+
+	pipeline.Stop();
+
+	pipeline.Start();
+
+	TEST_THROWS(consume(pipeline, source));
+}
+TEST_CASE_END
+
+TEST_CASE("stopping cancels a fetch in progress")
+{
+	TestSource     source(2, 1);
+	CFetchPipeline pipeline(source, 2);
+
+	source.m_bBlock = true;
+
+	pipeline.Start();
+
+	size_t buffer = 0;
+
+	TEST_TRUE(pipeline.NextBuffer(buffer));
+	TEST_TRUE(source.m_vBuffers[buffer] == 0);
+
+	pipeline.Stop();
+
+	TEST_TRUE(source.m_nCancels == 1);
+	TEST_FALSE(pipeline.Running());
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
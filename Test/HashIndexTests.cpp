@@ -0,0 +1,307 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   HashIndexTests.cpp
+//! \brief  The unit tests for the HashIndex class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/HashIndex.hpp>
+#include <MDBL/Table.hpp>
+#include <process.h>
+
+namespace
+{
+
+//! The number of rows that are never deleted.
+static const int FIXED_ROWS = 100;
+
+//! The number of rows the writer inserts and then deletes.
+static const int WRITES = 5000;
+
+//! The shared state for the reader and writer threads.
+struct Shared
+{
+	CTable*			m_pTable;
+	volatile LONG	m_bDone;
+	volatile LONG	m_nMissing;
+};
+
+static unsigned __stdcall readerThread(void* pParam)
+{
+	Shared* pShared = static_cast<Shared*>(pParam);
+
+	while (pShared->m_bDone == 0)
+	{
+		for (int id = 0; id != FIXED_ROWS; ++id)
+		{
+			if (pShared->m_pTable->SelectRow(0, id) == nullptr)
+				::InterlockedIncrement(&pShared->m_nMissing);
+		}
+	}
+
+	return 0;
+}
+
+static unsigned __stdcall deletedReaderThread(void* pParam)
+{
+	Shared* pShared = static_cast<Shared*>(pParam);
+
+	while (pShared->m_bDone == 0)
+	{
+		for (int id = FIXED_ROWS; id != FIXED_ROWS + WRITES; ++id)
+		{
+			CTable::RowGuard guard(*pShared->m_pTable);
+
+			CRow* row = pShared->m_pTable->SelectRow(0, id);
+
+			if ( (row != nullptr) && (tstrcmp((*row)[1].GetString(), TXT("Temp")) != 0) )
+				::InterlockedIncrement(&pShared->m_nMissing);
+		}
+	}
+
+	return 0;
+}
+
+static unsigned __stdcall guardedReaderThread(void* pParam)
+{
+	Shared* pShared = static_cast<Shared*>(pParam);
+
+	while (pShared->m_bDone == 0)
+	{
+		CTable::RowGuard guard(*pShared->m_pTable);
+
+		// Takes the table lock whilst the guard is held.
+		if (pShared->m_pTable->RowCount() > static_cast<size_t>(FIXED_ROWS + WRITES))
+			::InterlockedIncrement(&pShared->m_nMissing);
+	}
+
+	return 0;
+}
+
+static unsigned __stdcall truncateWriterThread(void* pParam)
+{
+	Shared* pShared = static_cast<Shared*>(pParam);
+	CTable& table   = *pShared->m_pTable;
+
+	for (int i = 0; i != WRITES; ++i)
+	{
+		CRow& row = table.CreateRow();
+
+		row[0] = FIXED_ROWS + i;
+		row[1] = TXT("Temp");
+
+		table.InsertRow(row);
+	}
+
+	for (int i = 0; i != WRITES / 2; ++i)
+		table.DeleteRow(*table.SelectRow(0, FIXED_ROWS + i));
+
+	table.Truncate();
+
+	::InterlockedExchange(&pShared->m_bDone, 1);
+
+	return 0;
+}
+
+static unsigned __stdcall writerThread(void* pParam)
+{
+	Shared* pShared = static_cast<Shared*>(pParam);
+	CTable& table   = *pShared->m_pTable;
+
+	for (int i = 0; i != WRITES; ++i)
+	{
+		CRow& row = table.CreateRow();
+
+		row[0] = FIXED_ROWS + i;
+		row[1] = TXT("Temp");
+
+		table.InsertRow(row);
+	}
+
+	for (int i = 0; i != WRITES; ++i)
+		table.DeleteRow(*table.SelectRow(0, FIXED_ROWS + i));
+
+	::InterlockedExchange(&pShared->m_bDone, 1);
+
+	return 0;
+}
+
+}
+
+TEST_SET(HashIndex)
+{
+
+TEST_CASE("the unique columns of a concurrent table use a hash index")
+{
+	CTable table(TXT("Test"), CTable::DEFAULTS | CTable::CONCURRENT);
+	table.AddColumn(TXT("ID"),    MDCT_INT,    0,   CColumn::UNIQUE);
+	table.AddColumn(TXT("Name"),  MDCT_VARSTR, 256, CColumn::UNIQUE);
+	table.AddColumn(TXT("Value"), MDCT_INT,    0,   CColumn::DEFAULTS);
+
+	TEST_TRUE(dynamic_cast<const CHashIndex*>(table.Column(0).Index()) != nullptr);
+	TEST_TRUE(dynamic_cast<const CHashIndex*>(table.Column(1).Index()) != nullptr);
+
+	CTable serial(TXT("Test"));
+	serial.AddColumn(TXT("ID"), MDCT_INT, 0, CColumn::UNIQUE);
+
+	TEST_TRUE(dynamic_cast<const CHashIndex*>(serial.Column(0).Index()) == nullptr);
+}
+TEST_CASE_END
+
+TEST_CASE("rows can be found by an int or string key as the index grows")
+{
+	CTable table(TXT("Test"), CTable::DEFAULTS | CTable::CONCURRENT);
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,   CColumn::UNIQUE);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::UNIQUE);
+
+	const int ROWS = 1000;
+
+	for (int id = 0; id != ROWS; ++id)
+	{
+		CRow& row = table.CreateRow();
+
+		row[0] = id * 16;
+		row[1] = Core::fmt(TXT("Row %d"), id).c_str();
+
+		table.InsertRow(row);
+	}
+
+	bool found = true;
+
+	for (int id = 0; id != ROWS; ++id)
+	{
+		CRow* byInt = table.SelectRow(0, id * 16);
+		CRow* byStr = table.SelectRow(1, Core::fmt(TXT("Row %d"), id).c_str());
+
+		found = found && (byInt != nullptr) && (byInt == byStr);
+	}
+
+	TEST_TRUE(found);
+	TEST_TRUE(table.SelectRow(0, 1) == nullptr);
+	TEST_TRUE(table.SelectRow(1, TXT("row 1")) == nullptr);
+	TEST_TRUE(table.Column(0).Index()->RowCount() == ROWS);
+}
+TEST_CASE_END
+
+TEST_CASE("deleted and truncated rows are no longer found")
+{
+	CTable table(TXT("Test"), CTable::DEFAULTS | CTable::CONCURRENT);
+	table.AddColumn(TXT("ID"), MDCT_INT, 0, CColumn::UNIQUE);
+
+	for (int id = 0; id != 3; ++id)
+	{
+		CRow& row = table.CreateRow();
+
+		row[0] = id;
+
+		table.InsertRow(row);
+	}
+
+	table.DeleteRow(*table.SelectRow(0, 1));
+
+	TEST_TRUE(table.SelectRow(0, 0) != nullptr);
+	TEST_TRUE(table.SelectRow(0, 1) == nullptr);
+	TEST_TRUE(table.SelectRow(0, 2) != nullptr);
+	TEST_TRUE(table.Column(0).Index()->RowCount() == 2);
+
+	table.Truncate();
+
+	TEST_TRUE(table.SelectRow(0, 0) == nullptr);
+	TEST_TRUE(table.Column(0).Index()->RowCount() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("rows can be found by many threads whilst another inserts and deletes")
+{
+	CTable table(TXT("Test"), CTable::DEFAULTS | CTable::CONCURRENT);
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,   CColumn::UNIQUE);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+
+	for (int id = 0; id != FIXED_ROWS; ++id)
+	{
+		CRow& row = table.CreateRow();
+
+		row[0] = id;
+		row[1] = TXT("Fixed");
+
+		table.InsertRow(row);
+	}
+
+	Shared shared = { &table, 0, 0 };
+
+	const size_t THREADS = 4;
+	HANDLE       threads[THREADS];
+
+	threads[0] = reinterpret_cast<HANDLE>(::_beginthreadex(nullptr, 0, writerThread, &shared, 0, nullptr));
+
+	for (size_t i = 1; i != THREADS; ++i)
+		threads[i] = reinterpret_cast<HANDLE>(::_beginthreadex(nullptr, 0, readerThread, &shared, 0, nullptr));
+
+	for (size_t i = 0; i != THREADS; ++i)
+	{
+		::WaitForSingleObject(threads[i], INFINITE);
+		::CloseHandle(threads[i]);
+	}
+
+	TEST_TRUE(shared.m_nMissing == 0);
+	TEST_TRUE(table.RowCount() == FIXED_ROWS);
+	TEST_TRUE(table.Column(0).Index()->RowCount() == FIXED_ROWS);
+}
+TEST_CASE_END
+
+TEST_CASE("a row found under a row guard is not freed whilst another thread deletes it")
+{
+	CTable table(TXT("Test"), CTable::DEFAULTS | CTable::CONCURRENT);
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,   CColumn::UNIQUE);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+
+	Shared shared = { &table, 0, 0 };
+
+	const size_t THREADS = 3;
+	HANDLE       threads[THREADS];
+
+	threads[0] = reinterpret_cast<HANDLE>(::_beginthreadex(nullptr, 0, writerThread, &shared, 0, nullptr));
+
+	for (size_t i = 1; i != THREADS; ++i)
+		threads[i] = reinterpret_cast<HANDLE>(::_beginthreadex(nullptr, 0, deletedReaderThread, &shared, 0, nullptr));
+
+	for (size_t i = 0; i != THREADS; ++i)
+	{
+		::WaitForSingleObject(threads[i], INFINITE);
+		::CloseHandle(threads[i]);
+	}
+
+	TEST_TRUE(shared.m_nMissing == 0);
+	TEST_TRUE(table.RowCount() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a thread holding a row guard can query the table whilst another deletes and truncates it")
+{
+	CTable table(TXT("Test"), CTable::DEFAULTS | CTable::CONCURRENT);
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,   CColumn::UNIQUE);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+
+	Shared shared = { &table, 0, 0 };
+
+	const size_t THREADS = 3;
+	HANDLE       threads[THREADS];
+
+	threads[0] = reinterpret_cast<HANDLE>(::_beginthreadex(nullptr, 0, truncateWriterThread, &shared, 0, nullptr));
+
+	for (size_t i = 1; i != THREADS; ++i)
+		threads[i] = reinterpret_cast<HANDLE>(::_beginthreadex(nullptr, 0, guardedReaderThread, &shared, 0, nullptr));
+
+	for (size_t i = 0; i != THREADS; ++i)
+	{
+		::WaitForSingleObject(threads[i], INFINITE);
+		::CloseHandle(threads[i]);
+	}
+
+	TEST_TRUE(shared.m_nMissing == 0);
+	TEST_TRUE(table.RowCount() == 0);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,229 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   LocalSourceTests.cpp
+//! \brief  The unit tests for the LocalSource class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/Table.hpp>
+#include <MDBL/LocalSource.hpp>
+#include <MDBL/SQLException.hpp>
+
+namespace
+{
+
+static void createSchema(CTable& table)
+{
+	table.AddColumn(TXT("ID"),    MDCT_INT,    0,  CColumn::PRIMARY_KEY | CColumn::UNIQUE);
+	table.AddColumn(TXT("Name"),  MDCT_VARSTR, 50, CColumn::NULLABLE);
+	table.AddColumn(TXT("Price"), MDCT_DOUBLE, 0,  CColumn::DEFAULTS);
+}
+
+static CRow& insertRow(CTable& table, int id, const tchar* name, double price)
+{
+	CRow& row = table.CreateRow();
+	row[0] = id;
+	row[1] = name;
+	row[2] = price;
+	table.InsertRow(row);
+
+	return row;
+}
+
+static void createData(CLocalSource& source)
+{
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	source.CreateTable(table);
+
+	insertRow(table, 1, TXT("First"),  3.0);
+	insertRow(table, 2, TXT("Second"), 1.0);
+	insertRow(table, 3, TXT("Third"),  2.0);
+	table[1][1] = null;
+
+	source.BeginTrans();
+	table.Write(source);
+	source.CommitTrans();
+}
+
+static int queryCount(CLocalSource& source, const tchar* query)
+{
+	SQLCursorPtr cursor = source.ExecQuery(query);
+	int          count = 0;
+
+	while (cursor->Fetch())
+		++count;
+
+	return count;
+}
+
+}
+
+TEST_SET(LocalSource)
+{
+
+TEST_CASE("rows written to a table can be read back")
+{
+	CLocalSource source(TXT(""));
+	createData(source);
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+	table.Read(source);
+
+	TEST_TRUE(table.RowCount() == 3);
+	TEST_TRUE(table[0][0] == 1);
+	TEST_TRUE(tstrcmp(table[0][1].GetString(), TXT("First")) == 0);
+	TEST_TRUE(table[0][2] == 3.0);
+	TEST_TRUE(table[1][1] == null);
+}
+TEST_CASE_END
+
+TEST_CASE("modified rows are written as updates of the primary key")
+{
+	CLocalSource source(TXT(""));
+	createData(source);
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+	table.Read(source);
+
+	table[2][1] = TXT("Changed");
+	table[2][2] = 9.5;
+	table.Write(source);
+
+	CTable result(TXT("Test"));
+	createSchema(result);
+	result.Read(source);
+
+	TEST_TRUE(result.RowCount() == 3);
+	TEST_TRUE(tstrcmp(result[2][1].GetString(), TXT("Changed")) == 0);
+	TEST_TRUE(result[2][2] == 9.5);
+	TEST_TRUE(tstrcmp(result[0][1].GetString(), TXT("First")) == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("queries can filter, sort and group the rows")
+{
+	CLocalSource source(TXT(""));
+	createData(source);
+
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM Test WHERE Price >= 2.0")) == 2);
+	TEST_TRUE(queryCount(source, TXT("SELECT ID FROM Test WHERE Name IS NULL OR ID = 3")) == 2);
+	TEST_TRUE(queryCount(source, TXT("SELECT ID FROM Test WHERE (ID <> 1) AND Name = 'Third'")) == 1);
+	TEST_TRUE(queryCount(source, TXT("SELECT Price FROM Test GROUP BY Price")) == 3);
+
+	CTable::Ptr sorted = CTable::Create(TXT("Sorted"), source, TXT("SELECT ID, Price FROM Test ORDER BY Price DESC"));
+
+	TEST_TRUE(sorted->ColumnCount() == 2);
+	TEST_TRUE(sorted->Column(0).ColType() == MDCT_INT);
+	TEST_TRUE(sorted->RowCount() == 3);
+	TEST_TRUE((*sorted)[0][0] == 1);
+	TEST_TRUE((*sorted)[1][0] == 3);
+	TEST_TRUE((*sorted)[2][0] == 2);
+}
+TEST_CASE_END
+
+TEST_CASE("changes are discarded when the transaction is rolled back")
+{
+	CLocalSource source(TXT(""));
+	createData(source);
+
+	source.BeginTrans();
+	source.ExecStmt(TXT("DELETE FROM Test WHERE ID = 2"));
+	source.ExecStmt(TXT("UPDATE Test SET Name = 'Updated'"));
+	source.ExecStmt(TXT("CREATE TABLE Other (ID INT)"));
+
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM Test WHERE Name = 'Updated'")) == 2);
+
+	source.RollbackTrans();
+
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM Test")) == 3);
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM Test WHERE Name = 'Updated'")) == 0);
+	TEST_THROWS(source.ExecQuery(TXT("SELECT * FROM Other")));
+}
+TEST_CASE_END
+
+TEST_CASE("committed tables are persisted to the folder")
+{
+	const CPath file = CPath(TXT(".")) / (CString(TXT("LocalSourceTests")) + CLocalSource::FILE_EXT);
+
+	::DeleteFile(file);
+
+	{
+		CLocalSource source(TXT("."));
+
+		source.ExecStmt(TXT("CREATE TABLE LocalSourceTests (ID INT, Name VARSTR(20) NULL)"));
+		source.BeginTrans();
+		source.ExecStmt(TXT("INSERT INTO LocalSourceTests VALUES (1, 'Tab\tSeparated')"));
+		source.ExecStmt(TXT("INSERT INTO LocalSourceTests VALUES (2, NULL)"));
+		source.CommitTrans();
+	}
+
+	CLocalSource source(TXT("."));
+
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM LocalSourceTests")) == 2);
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM LocalSourceTests WHERE Name = 'Tab\tSeparated'")) == 1);
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM LocalSourceTests WHERE Name IS NULL")) == 1);
+
+	::DeleteFile(file);
+}
+TEST_CASE_END
+
+TEST_CASE("rows found by key are still found after other rows are deleted")
+{
+	CLocalSource source(TXT(""));
+	createData(source);
+
+	source.ExecStmt(TXT("INSERT INTO Test VALUES (4, 'Fourth', 4.0)"));
+	source.ExecStmt(TXT("INSERT INTO Test VALUES (5, 'Fifth', 5.0)"));
+
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM Test WHERE ID = 5")) == 1);
+
+	source.ExecStmt(TXT("DELETE FROM Test WHERE ID = 2 OR ID = 4"));
+
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM Test WHERE ID = 1")) == 1);
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM Test WHERE ID = 2")) == 0);
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM Test WHERE ID = 3 AND Name = 'Third'")) == 1);
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM Test WHERE ID = 4")) == 0);
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM Test WHERE ID = 5 AND Name = 'Fifth'")) == 1);
+
+	source.ExecStmt(TXT("INSERT INTO Test VALUES (6, 'Sixth', 6.0)"));
+	source.ExecStmt(TXT("UPDATE Test SET Price = 0.5 WHERE ID = 5"));
+
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM Test WHERE ID = 6 AND Name = 'Sixth'")) == 1);
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM Test WHERE ID = 5 AND Price = 0.5")) == 1);
+	TEST_TRUE(queryCount(source, TXT("SELECT * FROM Test")) == 4);
+}
+TEST_CASE_END
+
+TEST_CASE("invalid statements throw an exception")
+{
+	CLocalSource source(TXT(""));
+	createData(source);
+
+	TEST_THROWS(source.ExecQuery(TXT("SELECT * FROM Missing")));
+	TEST_THROWS(source.ExecQuery(TXT("SELECT Missing FROM Test")));
+	TEST_THROWS(source.ExecQuery(TXT("SELECT * FROM Test WHERE")));
+	TEST_THROWS(source.ExecStmt(TXT("INSERT INTO Test VALUES (4, 'Fourth', NULL)")));
+	TEST_THROWS(source.ExecStmt(TXT("CREATE TABLE Test (ID INT)")));
+	TEST_THROWS(CLocalSource(TXT("Missing Folder")));
+
+	int error = -1;
+
+	try
+	{
+		source.CreateParams(TXT("UPDATE Test SET Name = ? WHERE ID = ?"), 1);
+	}
+	catch (const CSQLException& e)
+	{
+		error = e.m_eError;
+	}
+
+	TEST_TRUE(error == CSQLException::E_EXEC_FAILED);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
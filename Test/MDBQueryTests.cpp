@@ -108,5 +108,60 @@ TEST_CASE("A query with an outer join returns an empty row on the right table wh
 }
 TEST_CASE_END
 
+TEST_CASE("swapping joined sets exchanges the result sets without copying them")
+{
+	CTable table(TXT("Table"));
+	table.AddColumn(TXT("1st"), MDCT_INT, 0);
+
+	{ CRow& row = table.CreateRow(); row[0] = 10; table.InsertRow(row); }
+
+	CTable* tables[] = { &table, &table };
+
+	CJoinedSet lhs(2, tables);
+	CJoinedSet rhs(1, tables);
+
+	lhs[0].Add(table[0]);
+	lhs[1].Add(table[0]);
+
+	lhs.Swap(rhs);
+
+	TEST_TRUE(rhs.Count() == 1);
+	TEST_TRUE(&rhs[1][0] == &table[0]);
+	TEST_TRUE(lhs.Count() == 0);
+	TEST_TRUE(&lhs[0].Table() == &table);
+}
+TEST_CASE_END
+
+#ifdef MDBL_HAS_RVALUE_REFS
+
+TEST_CASE("moving a joined set transfers the result sets")
+{
+	CTable table(TXT("Table"));
+	table.AddColumn(TXT("1st"), MDCT_INT, 0);
+
+	{ CRow& row = table.CreateRow(); row[0] = 10; table.InsertRow(row); }
+
+	CTable* tables[] = { &table, &table };
+
+	CJoinedSet source(2, tables);
+
+	source[0].Add(table[0]);
+	source[1].Add(table[0]);
+
+	CJoinedSet moved(std::move(source));
+
+	TEST_TRUE(moved.Count() == 1);
+	TEST_TRUE(&moved[1][0] == &table[0]);
+
+	CJoinedSet assigned(1, tables);
+	assigned = std::move(moved);
+
+	TEST_TRUE(assigned.Count() == 1);
+	TEST_TRUE(&assigned[1][0] == &table[0]);
+}
+TEST_CASE_END
+
+#endif
+
 }
 TEST_SET_END
@@ -8,9 +8,30 @@
 #include <MDBL/MDB.hpp>
 #include "Mocks/MockSQLSource.hpp"
 #include "Mocks/MockSQLCursor.hpp"
+#include <WCL/MemStream.hpp>
 
 using namespace Mocks;
 
+namespace
+{
+
+static void createSchema(CTable& table)
+{
+	table.AddColumn(TXT("ID"),   MDCT_IDENTITY, 0,  CColumn::IDENTITY);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR,   50, CColumn::NULLABLE);
+	table.AddColumn(TXT("Qty"),  MDCT_INT,      0,  CColumn::DEFAULTS);
+}
+
+static void insertRow(CTable& table, const tchar* name, int qty)
+{
+	CRow& row = table.CreateRow();
+	row[1] = name;
+	row[2] = qty;
+	table.InsertRow(row);
+}
+
+}
+
 TEST_SET(MDB)
 {
 
@@ -40,5 +61,200 @@ TEST_CASE("A table can be created from the result set of an explicit query")
 }
 TEST_CASE_END
 
+TEST_CASE("Tables can be read concurrently using a connection per table")
+{
+	const tchar* anyConnection = TXT("any SQL connection");
+
+	MockSQLCursor::Columns parentColumns;
+	parentColumns.push_back(MockSQLColumn(0, TXT("ID"),   MDCT_INT,    0,  CColumn::UNIQUE));
+	parentColumns.push_back(MockSQLColumn(1, TXT("Name"), MDCT_VARSTR, 99, CColumn::NULLABLE));
+
+	MockSQLCursor::Columns childColumns;
+	childColumns.push_back(MockSQLColumn(0, TXT("ID"),       MDCT_INT, 0, CColumn::UNIQUE));
+	childColumns.push_back(MockSQLColumn(1, TXT("ParentID"), MDCT_INT, 0, CColumn::DEFAULTS));
+
+	MockSQLCursor::Rows parentRows, childRows, otherRows;
+
+	for (int i = 1; i <= 3; ++i)
+	{
+		MockSQLCursor::Row parent;
+		parent.push_back(CValue(i));
+		parent.push_back(CValue(TXT("Parent")));
+		parentRows.push_back(parent);
+
+		MockSQLCursor::Row child;
+		child.push_back(CValue(10 + i));
+		child.push_back(CValue(i));
+		childRows.push_back(child);
+	}
+
+	MockSQLCursor::Row otherRow;
+	otherRow.push_back(CValue(42));
+	otherRow.push_back(CValue(TXT("Other")));
+	otherRows.push_back(otherRow);
+
+	volatile LONG counter = 0;
+	MockSQLSource mockSources[2];
+	CMDB::SQLSources sources;
+
+	for (size_t i = 0; i != 2; ++i)
+	{
+		mockSources[i].Open(anyConnection);
+		mockSources[i].SetCounter(&counter);
+		mockSources[i].SetResult(TXT("Parent"), parentColumns, parentRows);
+		mockSources[i].SetResult(TXT("Child"),  childColumns,  childRows);
+		mockSources[i].SetResult(TXT("Other"),  parentColumns, otherRows);
+		sources.push_back(&mockSources[i]);
+	}
+
+	CTable parent(TXT("Parent"));
+	parent.AddColumn(TXT("ID"),   MDCT_INT,    0,  CColumn::UNIQUE);
+	parent.AddColumn(TXT("Name"), MDCT_VARSTR, 99, CColumn::NULLABLE);
+
+	CTable child(TXT("Child"));
+	child.AddColumn(TXT("ID"),       MDCT_INT, 0, CColumn::UNIQUE);
+	child.AddColumn(TXT("ParentID"), parent,   0, CColumn::FOREIGNKEY);
+
+	CTable other(TXT("Other"));
+	other.AddColumn(TXT("ID"),   MDCT_INT,    0,  CColumn::UNIQUE);
+	other.AddColumn(TXT("Name"), MDCT_VARSTR, 99, CColumn::NULLABLE);
+
+	CMDB mdb;
+	mdb.AddTable(child);
+	mdb.AddTable(other);
+	mdb.AddTable(parent);
+
+	CTable* tables[] = { &parent, &other, &child };
+
+	for (size_t i = 0; i != 3; ++i)
+	{
+		CRow& row = tables[i]->CreateRow();
+		row[0] = 99;
+
+		if (tables[i] == &child)
+			row[1] = 99;
+		else
+			row[1] = TXT("stale");
+
+		tables[i]->InsertRow(row);
+	}
+
+	mdb.Read(sources);
+
+	TEST_TRUE(parent.RowCount() == 3);
+	TEST_TRUE(child.RowCount() == 3);
+	TEST_TRUE(other.RowCount() == 1);
+
+	TEST_TRUE(parent.SelectRow(0, 99) == nullptr);
+	TEST_TRUE(tstrcmp(parent.SelectRow(0, 2)->Field(1).GetString(), TXT("Parent")) == 0);
+	TEST_TRUE(child.SelectRow(0, 13)->Field(1) == 3);
+	TEST_TRUE(tstrcmp(other[0][1].GetString(), TXT("Other")) == 0);
+
+	LONG parentQuery = mockSources[0].QueryNumber(TXT("Parent")) + mockSources[1].QueryNumber(TXT("Parent"));
+	LONG childQuery  = mockSources[0].QueryNumber(TXT("Child"))  + mockSources[1].QueryNumber(TXT("Child"));
+
+	TEST_TRUE(counter == 3);
+	TEST_TRUE(parentQuery < childQuery);
+}
+TEST_CASE_END
+
+TEST_CASE("A delta only contains the changes since the last write and can be merged into the base")
+{
+	CBuffer base, delta1, delta2, merged;
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+
+		for (int i = 1; i <= 100; ++i)
+			insertRow(table, TXT("Row"), i);
+
+		CMemStream baseStream(base);
+		baseStream.Create();
+		mdb.Write(baseStream);
+		baseStream.Close();
+
+		table[0][1] = TXT("Changed");
+		table[1][1] = null;
+		table.DeleteRow(table[2]);
+		insertRow(table, TXT("New"), 101);
+
+		CMemStream delta1Stream(delta1);
+		delta1Stream.Create();
+		mdb.WriteDelta(delta1Stream);
+		delta1Stream.Close();
+
+		TEST_FALSE(table.Modified());
+		TEST_TRUE(delta1.Size() < (base.Size() / 10));
+
+		table[0][2] = 42;
+		table.Truncate();
+		insertRow(table, TXT("Last"), 102);
+
+		CMemStream delta2Stream(delta2);
+		delta2Stream.Create();
+		mdb.WriteDelta(delta2Stream);
+		delta2Stream.Close();
+	}
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+
+		CMemStream baseStream(base);
+		baseStream.Open();
+		mdb.Read(baseStream);
+
+		CMemStream delta1Stream(delta1);
+		delta1Stream.Open();
+		mdb.ReadDelta(delta1Stream);
+
+		TEST_TRUE(table.RowCount() == 100);
+		TEST_TRUE(table[0][1].GetString() == tstring(TXT("Changed")));
+		TEST_TRUE(table[0][2] == 1);
+		TEST_TRUE(table[1][1] == null);
+		TEST_TRUE(table[2][0] == 4);
+		TEST_TRUE(table[99][0] == 101);
+		TEST_TRUE(table.SelectRow(0, 3) == nullptr);
+		TEST_TRUE(table.SelectRow(0, 101) == &table[99]);
+		TEST_FALSE(table.Modified());
+	}
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	CMemStream baseStream(base), delta1Stream(delta1), delta2Stream(delta2), mergedStream(merged);
+	baseStream.Open();
+	delta1Stream.Open();
+	delta2Stream.Open();
+	mergedStream.Create();
+
+	CMDB::InputStreams deltas;
+	deltas.push_back(&delta1Stream);
+	deltas.push_back(&delta2Stream);
+
+	mdb.MergeDeltas(baseStream, deltas, mergedStream);
+	mergedStream.Close();
+
+	table.Truncate();
+
+	mergedStream.Open();
+	mdb.Read(mergedStream);
+
+	TEST_TRUE(table.RowCount() == 1);
+	TEST_TRUE(table[0][0] == 102);
+	TEST_TRUE(table[0][1].GetString() == tstring(TXT("Last")));
+}
+TEST_CASE_END
+
 }
 TEST_SET_END
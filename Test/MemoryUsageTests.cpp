@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   MemoryUsageTests.cpp
+//! \brief  The unit tests for the table memory accounting.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/MDB.hpp>
+#include <MDBL/Table.hpp>
+#include <MDBL/MemoryUsage.hpp>
+
+namespace
+{
+
+//! Create a table with an int key and a variable length string.
+static void createColumns(CTable& table, uint keyFlags)
+{
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,   keyFlags);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+}
+
+//! Add a row to the table.
+static CRow& addRow(CTable& table, int id, const tchar* name)
+{
+	CRow& row = table.CreateRow();
+
+	row[0] = id;
+	row[1] = name;
+
+	table.InsertRow(row);
+
+	return row;
+}
+
+}
+
+TEST_SET(MemoryUsage)
+{
+
+TEST_CASE("an empty table uses no memory for rows")
+{
+	CTable table(TXT("Test"));
+	createColumns(table, CColumn::DEFAULTS);
+
+	const CMemoryUsage usage = table.MemoryUsage();
+
+	TEST_TRUE(usage.m_nFixedData == 0);
+	TEST_TRUE(usage.m_nFieldOverhead == 0);
+	TEST_TRUE(usage.m_nStrings == 0);
+	TEST_TRUE(usage.m_nNullRows == 0);
+	TEST_TRUE(usage.Total() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("the usage grows as rows are inserted and shrinks as they are deleted")
+{
+	CTable table(TXT("Test"));
+	createColumns(table, CColumn::DEFAULTS);
+
+	addRow(table, 1, TXT("One"));
+
+	const CMemoryUsage one = table.MemoryUsage();
+
+	TEST_TRUE(one.m_nFixedData != 0);
+	TEST_TRUE(one.m_nFieldOverhead != 0);
+	TEST_TRUE(one.m_nStrings == Core::numBytes<tchar>(4));
+
+	addRow(table, 2, TXT("Two"));
+
+	const CMemoryUsage two = table.MemoryUsage();
+
+	TEST_TRUE(two.m_nFixedData == 2 * one.m_nFixedData);
+	TEST_TRUE(two.m_nFieldOverhead == 2 * one.m_nFieldOverhead);
+	TEST_TRUE(two.m_nStrings == 2 * one.m_nStrings);
+
+	table.DeleteRow(0);
+
+	TEST_TRUE(table.MemoryUsage().Total() == one.Total());
+
+	table.Truncate();
+
+	TEST_TRUE(table.MemoryUsage().Total() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("changing a string value updates the string usage")
+{
+	CTable table(TXT("Test"));
+	createColumns(table, CColumn::DEFAULTS);
+
+	CRow& row = addRow(table, 1, TXT("A"));
+
+	TEST_TRUE(table.MemoryUsage().m_nStrings == Core::numBytes<tchar>(2));
+
+	row[1] = TXT("ABCDEFGHI");
+
+	TEST_TRUE(table.MemoryUsage().m_nStrings == Core::numBytes<tchar>(10));
+
+	row[1] = TXT("");
+
+	TEST_TRUE(table.MemoryUsage().m_nStrings == Core::numBytes<tchar>(1));
+}
+TEST_CASE_END
+
+TEST_CASE("a unique column reports the size of its index")
+{
+	CTable table(TXT("Test"));
+	createColumns(table, CColumn::UNIQUE);
+
+	TEST_TRUE(table.MemoryUsage().m_nIndexes == 0);
+
+	addRow(table, 1, TXT("One"));
+	addRow(table, 2, TXT("Two"));
+
+	const size_t two = table.MemoryUsage().m_nIndexes;
+
+	TEST_TRUE(two != 0);
+
+	table.DeleteRow(0);
+
+	TEST_TRUE(table.MemoryUsage().m_nIndexes < two);
+}
+TEST_CASE_END
+
+TEST_CASE("the null row is reported separately from the table rows")
+{
+	CTable table(TXT("Test"));
+	createColumns(table, CColumn::DEFAULTS);
+
+	addRow(table, 1, TXT("One"));
+
+	const CMemoryUsage before = table.MemoryUsage();
+
+	table.NullRow();
+
+	const CMemoryUsage after = table.MemoryUsage();
+
+	TEST_TRUE(after.m_nNullRows != 0);
+	TEST_TRUE(after.m_nFixedData == before.m_nFixedData);
+	TEST_TRUE(after.m_nFieldOverhead == before.m_nFieldOverhead);
+	TEST_TRUE(after.m_nStrings == before.m_nStrings);
+}
+TEST_CASE_END
+
+TEST_CASE("the database usage is the sum of its tables")
+{
+	CTable first(TXT("First"));
+	createColumns(first, CColumn::UNIQUE);
+	addRow(first, 1, TXT("One"));
+
+	CTable second(TXT("Second"));
+	createColumns(second, CColumn::DEFAULTS);
+	addRow(second, 1, TXT("One"));
+	addRow(second, 2, TXT("Two"));
+
+	CMDB mdb;
+	mdb.AddTable(first);
+	mdb.AddTable(second);
+
+	const CMemoryUsage usage = mdb.MemoryUsage();
+
+	TEST_TRUE(usage.Total() == first.MemoryUsage().Total() + second.MemoryUsage().Total());
+	TEST_TRUE(usage.m_nIndexes == first.MemoryUsage().m_nIndexes);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -5,6 +5,8 @@
 
 #include "Common.hpp"
 #include "MockSQLCursor.hpp"
+#include <MDBL/Row.hpp>
+#include <MDBL/Field.hpp>
 
 namespace Mocks
 {
@@ -13,6 +15,7 @@ namespace Mocks
 //! Default constructor.
 
 MockSQLCursor::MockSQLCursor()
+	: m_next(0)
 {
 }
 
@@ -30,6 +33,15 @@ void MockSQLCursor::SetColumns(const Columns& columns)
 	m_columns = columns;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Set the rows in the result set.
+
+void MockSQLCursor::SetRows(const Rows& rows)
+{
+	m_rows = rows;
+	m_next = 0;
+}
+
 size_t MockSQLCursor::NumColumns() const
 {
 	return m_columns.size();
@@ -44,17 +56,41 @@ const SQLColumn& MockSQLCursor::Column(size_t n) const
 	return m_columns[n];
 }
 
-void MockSQLCursor::MapColumn(size_t /*sourceColumn*/, size_t /*destColumn*/, COLTYPE /*type*/, size_t /*size*/)
+void MockSQLCursor::MapColumn(size_t sourceColumn, size_t destColumn, COLTYPE /*type*/, size_t /*size*/)
 {
+	if (m_mapping.size() <= sourceColumn)
+		m_mapping.resize(sourceColumn+1);
+
+	m_mapping[sourceColumn] = destColumn;
 }
 
 bool MockSQLCursor::Fetch()
 {
-	return false;
+	if (m_next == m_rows.size())
+		return false;
+
+	++m_next;
+	return true;
 }
 
-void MockSQLCursor::GetRow(CRow& /*oRow*/)
+void MockSQLCursor::GetRow(CRow& oRow)
 {
+	const Row& row = m_rows[m_next-1];
+
+	for (size_t i = 0; i != m_mapping.size(); ++i)
+	{
+		const CValue& value = row[i];
+		CField&       field = oRow[m_mapping[i]];
+
+		switch (value.m_eType)
+		{
+			case MDST_NULL:		field = null;				break;
+			case MDST_INT:		field = value.m_iValue;		break;
+			case MDST_INT64:	field = value.m_i64Value;	break;
+			case MDST_STRING:	field = value.m_sValue;		break;
+			default:			ASSERT_FALSE();				break;
+		}
+	}
 }
 
 //namespace Mocks
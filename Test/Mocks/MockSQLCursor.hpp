@@ -12,6 +12,7 @@
 #endif
 
 #include <MDBL/SQLCursor.hpp>
+#include <MDBL/Value.hpp>
 #include <vector>
 
 namespace Mocks
@@ -40,6 +41,12 @@ public:
 	//! The collection of columns in the result set.
 	typedef std::vector<MockSQLColumn> Columns;
 
+	//! The values of a row in the result set.
+	typedef std::vector<CValue> Row;
+
+	//! The collection of rows in the result set.
+	typedef std::vector<Row> Rows;
+
 public:
 	//! Default constructor.
 	MockSQLCursor();
@@ -54,6 +61,9 @@ public:
 	//! Set the number of columsn in the result set.
 	void SetColumns(const Columns& columns);
 
+	//! Set the rows in the result set.
+	void SetRows(const Rows& rows);
+
 	//
 	// CSQLCursor interface.
 	//
@@ -68,6 +78,9 @@ private:
 	// Members.
 	//
 	Columns	m_columns;	//!< The collection of columns in the result set.
+	Rows	m_rows;		//!< The collection of rows in the result set.
+	size_t	m_next;		//!< The next row to fetch.
+	std::vector<size_t> m_mapping;	//!< The table column for each result set column.
 };
 
 //! The default MockSQLCursor smart pointer type.
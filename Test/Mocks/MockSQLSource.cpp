@@ -5,7 +5,7 @@
 
 #include "Common.hpp"
 #include "MockSQLSource.hpp"
-#include "MockSQLCursor.hpp"
+#include <tchar.h>
 
 namespace Mocks
 {
@@ -17,6 +17,7 @@ MockSQLSource::MockSQLSource()
 	: m_isOpen(false)
 	, m_inTransaction(false)
 	, m_cursor(new MockSQLCursor)
+	, m_counter(nullptr)
 {
 }
 
@@ -35,6 +36,76 @@ void MockSQLSource::SetCursor(SQLCursorPtr cursor)
 	m_cursor = cursor;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Queue a cursor to return for the next query, ahead of the default one.
+
+void MockSQLSource::QueueCursor(SQLCursorPtr cursor)
+{
+	m_queued.push_back(cursor);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the result set returned by each query on a table. A new cursor is
+//! created for each query so that the table can be read more than once.
+
+void MockSQLSource::SetResult(const tchar* pszTable, const MockSQLCursor::Columns& columns, const MockSQLCursor::Rows& rows)
+{
+	Result result;
+
+	result.m_table   = pszTable;
+	result.m_columns = columns;
+	result.m_rows    = rows;
+
+	m_results.push_back(result);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Number the queries using a counter that can be shared with other sources,
+//! so that the order of the queries across the sources can be checked.
+
+void MockSQLSource::SetCounter(volatile LONG* pCounter)
+{
+	m_counter = pCounter;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the queries executed.
+
+const std::vector<CString>& MockSQLSource::Queries() const
+{
+	return m_queries;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of the last query on a table, or 0 if there wasn't one.
+
+LONG MockSQLSource::QueryNumber(const tchar* pszTable) const
+{
+	for (size_t i = m_queries.size(); i != 0; --i)
+	{
+		if (IsQueryOn(m_queries[i-1], pszTable))
+			return m_numbers[i-1];
+	}
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a statement queries a table.
+
+bool MockSQLSource::IsQueryOn(const tchar* pszQuery, const tchar* pszTable)
+{
+	const CString from = CString(TXT(" FROM ")) + pszTable;
+	const tchar*  match = _tcsstr(pszQuery, from);
+
+	if (match == nullptr)
+		return false;
+
+	const tchar next = match[from.Length()];
+
+	return (next == TXT('\0')) || (next == TXT(' '));
+}
+
 //
 // CSQLSource interface.
 //
@@ -69,9 +140,32 @@ void MockSQLSource::ExecStmt(const tchar* /*pszStmt*/, CSQLParams& /*oParams*/)
 {
 }
 
-SQLCursorPtr MockSQLSource::ExecQuery(const tchar* /*pszQuery*/)
+SQLCursorPtr MockSQLSource::ExecQuery(const tchar* pszQuery)
 {
-	return m_cursor;
+	m_queries.push_back(pszQuery);
+	m_numbers.push_back((m_counter != nullptr) ? ::InterlockedIncrement(m_counter) : static_cast<LONG>(m_queries.size()));
+
+	for (size_t i = 0; i != m_results.size(); ++i)
+	{
+		if (IsQueryOn(pszQuery, m_results[i].m_table))
+		{
+			MockSQLCursorPtr cursor(new MockSQLCursor);
+
+			cursor->SetColumns(m_results[i].m_columns);
+			cursor->SetRows(m_results[i].m_rows);
+
+			return cursor;
+		}
+	}
+
+	if (m_queued.empty())
+		return m_cursor;
+
+	SQLCursorPtr cursor = m_queued.front();
+
+	m_queued.erase(m_queued.begin());
+
+	return cursor;
 }
 
 bool MockSQLSource::InTrans()
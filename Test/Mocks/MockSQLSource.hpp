@@ -12,6 +12,8 @@
 #endif
 
 #include <MDBL/SQLSource.hpp>
+#include "MockSQLCursor.hpp"
+#include <vector>
 
 namespace Mocks
 {
@@ -35,6 +37,21 @@ public:
 	//! Set the cursor to return for any query.
 	void SetCursor(SQLCursorPtr cursor);
 
+	//! Queue a cursor to return for the next query, ahead of the default one.
+	void QueueCursor(SQLCursorPtr cursor);
+
+	//! Set the result set returned by each query on a table.
+	void SetResult(const tchar* pszTable, const MockSQLCursor::Columns& columns, const MockSQLCursor::Rows& rows);
+
+	//! Number the queries using a counter that can be shared with other sources.
+	void SetCounter(volatile LONG* pCounter);
+
+	//! Get the queries executed.
+	const std::vector<CString>& Queries() const;
+
+	//! Get the number of the last query on a table, or 0 if there wasn't one.
+	LONG QueryNumber(const tchar* pszTable) const;
+
 	//
 	// CSQLSource interface.
 	//
@@ -54,12 +71,28 @@ public:
 	virtual void RollbackTrans();
 
 private:
+	//! A result set returned for the queries on a table.
+	struct Result
+	{
+		CString					m_table;	//!< The table queried.
+		MockSQLCursor::Columns	m_columns;	//!< The result set columns.
+		MockSQLCursor::Rows		m_rows;		//!< The result set rows.
+	};
+
 	//
 	// Members.
 	//
 	bool			m_isOpen;			//!< Is the connection open?
 	bool			m_inTransaction;	//!< Are we inside a transaction?
 	SQLCursorPtr	m_cursor;			//!< The cursor to return for any query.
+	std::vector<SQLCursorPtr> m_queued;	//!< The cursors for the next queries.
+	std::vector<CString> m_queries;		//!< The queries executed.
+	std::vector<LONG> m_numbers;		//!< The number of each query executed.
+	std::vector<Result> m_results;		//!< The result sets by table.
+	volatile LONG*	m_counter;			//!< The query counter, if shared.
+
+	//! Query if a statement queries a table.
+	static bool IsQueryOn(const tchar* pszQuery, const tchar* pszTable);
 };
 
 //namespace Mocks
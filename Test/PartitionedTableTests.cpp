@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   PartitionedTableTests.cpp
+//! \brief  The unit tests for the PartitionedTable class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/PartitionedTable.hpp>
+#include <MDBL/ResultSet.hpp>
+#include <MDBL/WhereCmp.hpp>
+#include <MDBL/WhereExp.hpp>
+#include <MDBL/WhereIn.hpp>
+#include <MDBL/ValueSet.hpp>
+#include <MDBL/MDBException.hpp>
+
+namespace
+{
+
+//! Add a row to a partitioned table.
+static void addRow(CPartitionedTable& table, int key, const tchar* name)
+{
+	CRow& row = table.CreateRow(key);
+
+	row[1] = name;
+
+	table.InsertRow(row);
+}
+
+}
+
+TEST_SET(PartitionedTable)
+{
+
+TEST_CASE("rows are spread across hash partitions and found by key")
+{
+	CPartitionedTable table(TXT("Test"));
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,   CColumn::UNIQUE);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+	table.PartitionByHash(0, 4);
+
+	const int ROWS = 100;
+
+	for (int id = 0; id != ROWS; ++id)
+		addRow(table, id, TXT("Row"));
+
+	TEST_TRUE(table.PartitionCount() == 4);
+	TEST_TRUE(table.RowCount() == ROWS);
+
+	bool spread = true;
+
+	for (size_t i = 0; i != table.PartitionCount(); ++i)
+		spread = spread && (table.Partition(i).RowCount() != 0);
+
+	TEST_TRUE(spread);
+
+	bool found = true;
+
+	for (int id = 0; id != ROWS; ++id)
+	{
+		CRow* row = table.SelectRow(0, id);
+
+		found = found && (row != nullptr) && (&row->Table() == &table.Partition(table.FindPartition(id)));
+	}
+
+	TEST_TRUE(found);
+	TEST_TRUE(table.SelectRow(0, ROWS) == nullptr);
+	TEST_TRUE(table.SelectAll().Count() == ROWS);
+}
+TEST_CASE_END
+
+TEST_CASE("queries on a hash key are pruned to a single partition")
+{
+	CPartitionedTable table(TXT("Test"));
+	table.AddColumn(TXT("Code"), MDCT_VARSTR, 256, CColumn::UNIQUE);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+	table.PartitionByHash(0, 8);
+
+	CRow& row = table.CreateRow(TXT("ABC"));
+	row[1] = TXT("Test");
+	table.InsertRow(row);
+
+	CPartitionedTable::Partitions partitions;
+
+	TEST_TRUE(table.Prune(CWhereCmp(0, CWhereCmp::EQUALS, TXT("abc")), partitions) == 1);
+	TEST_TRUE(partitions[0] == table.FindPartition(TXT("ABC")));
+	TEST_TRUE(table.Select(CWhereCmp(0, CWhereCmp::EQUALS, TXT("abc"))).Count() == 1);
+
+	TEST_TRUE(table.Prune(CWhereCmp(1, CWhereCmp::EQUALS, TXT("Test")), partitions) == 8);
+	TEST_TRUE(table.Select(CWhereCmp(1, CWhereCmp::EQUALS, TXT("Test"))).Count() == 1);
+}
+TEST_CASE_END
+
+TEST_CASE("queries on a range key are pruned to the partitions that overlap")
+{
+	CPartitionedTable table(TXT("Test"));
+	table.AddColumn(TXT("Day"),  MDCT_INT,    0,   CColumn::DEFAULTS);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+	table.PartitionByRange(0);
+
+	table.AddPartition(300);
+	table.AddPartition(100);
+	table.AddPartition(200);
+
+	TEST_TRUE(table.LowerBound(0) == 100);
+	TEST_TRUE(table.LowerBound(1) == 200);
+	TEST_TRUE(table.LowerBound(2) == 300);
+
+	for (int day = 100; day != 400; day += 10)
+		addRow(table, day, TXT("Trade"));
+
+	TEST_TRUE(table.Partition(0).RowCount() == 10);
+	TEST_TRUE(table.Partition(2).RowCount() == 10);
+
+	CPartitionedTable::Partitions partitions;
+
+	TEST_TRUE(table.Prune(CWhereCmp(0, CWhereCmp::EQUALS, 250), partitions) == 1);
+	TEST_TRUE(partitions[0] == 1);
+	TEST_TRUE(table.Prune(CWhereCmp(0, CWhereCmp::LESS, 200), partitions) == 1);
+	TEST_TRUE(table.Prune(CWhereCmp(0, CWhereCmp::GREATER, 199), partitions) == 2);
+	TEST_TRUE(table.Prune(CWhereCmp(0, CWhereCmp::GREATER, 150) && CWhereCmp(0, CWhereCmp::LESS, 250), partitions) == 2);
+	TEST_TRUE(table.Prune(CWhereCmp(0, CWhereCmp::EQUALS, 110) || CWhereCmp(0, CWhereCmp::EQUALS, 310), partitions) == 2);
+	TEST_TRUE(table.Prune(CWhereCmp(0, CWhereCmp::EQUALS, 50), partitions) == 0);
+
+	CValueSet values;
+	values.Add(120);
+	values.Add(130);
+
+	TEST_TRUE(table.Prune(CWhereIn(0, values), partitions) == 1);
+
+	TEST_TRUE(table.Select(CWhereCmp(0, CWhereCmp::GREATER, 150) && CWhereCmp(0, CWhereCmp::LESS, 250)).Count() == 9);
+	TEST_TRUE(table.Select(CWhereCmp(1, CWhereCmp::EQUALS, TXT("Trade"))).Count() == 30);
+	TEST_TRUE(table.Select(CWhereCmp(0, CWhereCmp::EQUALS, 50)).Count() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("adding a range partition moves the rows it now holds")
+{
+	CPartitionedTable table(TXT("Test"));
+	table.AddColumn(TXT("Day"),  MDCT_INT,    0,   CColumn::DEFAULTS);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+	table.PartitionByRange(0);
+	table.AddPartition(100);
+
+	addRow(table, 100, TXT("Old"));
+	addRow(table, 200, TXT("New"));
+
+	table.AddPartition(200);
+
+	TEST_TRUE(table.Partition(0).RowCount() == 1);
+	TEST_TRUE(table.Partition(1).RowCount() == 1);
+	TEST_TRUE(table.Partition(1).SelectAll()[0][1] == TXT("New"));
+}
+TEST_CASE_END
+
+TEST_CASE("dropping a range partition removes its rows and its keys")
+{
+	CPartitionedTable table(TXT("Test"));
+	table.AddColumn(TXT("Day"),  MDCT_INT,    0,   CColumn::DEFAULTS);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+	table.PartitionByRange(0);
+
+	table.AddPartition(1);
+	table.AddPartition(2);
+
+	addRow(table, 1, TXT("Monday"));
+	addRow(table, 2, TXT("Tuesday"));
+
+	table.DropPartition(0);
+
+	TEST_TRUE(table.PartitionCount() == 1);
+	TEST_TRUE(table.RowCount() == 1);
+	TEST_TRUE(table.FindPartition(1) == Core::npos);
+
+	bool thrown = false;
+
+	try
+	{
+		table.CreateRow(1);
+	}
+	catch (const CMDBException&)
+	{
+		thrown = true;
+	}
+
+	TEST_TRUE(thrown);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
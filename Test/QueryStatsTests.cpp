@@ -0,0 +1,209 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   QueryStatsTests.cpp
+//! \brief  The unit tests for the query statistics and explain plans.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/MDB.hpp>
+#include <MDBL/Table.hpp>
+#include <MDBL/ResultSet.hpp>
+#include <MDBL/Join.hpp>
+#include <MDBL/JoinedSet.hpp>
+#include <MDBL/WhereCmp.hpp>
+#include <MDBL/WhereExp.hpp>
+#include <MDBL/WhereIn.hpp>
+#include <MDBL/ValueSet.hpp>
+#include <MDBL/QueryStats.hpp>
+#include <tchar.h>
+
+namespace
+{
+
+//! Add the rows 0..count-1 to a table with a unique key and a name.
+static void addRows(CTable& table, int count)
+{
+	for (int id = 0; id != count; ++id)
+	{
+		CRow& row = table.CreateRow();
+
+		row[0] = id;
+		row[1] = (id % 2) ? TXT("Odd") : TXT("Even");
+
+		table.InsertRow(row);
+	}
+}
+
+//! Check if a string contains another.
+static bool contains(const CString& str, const tchar* text)
+{
+	return (_tcsstr(str.c_str(), text) != nullptr);
+}
+
+}
+
+TEST_SET(QueryStats)
+{
+
+TEST_CASE("a table scan counts the rows scanned, matched and compared")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,   CColumn::DEFAULTS);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+
+	addRows(table, 10);
+
+	CQueryStats stats;
+	CResultSet  results = table.Select(CWhereCmp(1, CWhereCmp::EQUALS, TXT("Odd")), stats);
+
+	TEST_TRUE(results.Count() == 5);
+	TEST_TRUE(stats.m_nQueries == 1);
+	TEST_TRUE(stats.m_nRowsScanned == 10);
+	TEST_TRUE(stats.m_nRowsMatched == 5);
+	TEST_TRUE(stats.m_nComparisons == 10);
+	TEST_TRUE(stats.m_nIndexProbes == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("an AND expression only counts the comparisons it makes")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,   CColumn::DEFAULTS);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+
+	addRows(table, 10);
+
+	CQueryStats stats;
+	CResultSet  results = table.Select(CWhereCmp(0, CWhereCmp::LESS, 4) && CWhereCmp(1, CWhereCmp::EQUALS, TXT("Even")), stats);
+
+	TEST_TRUE(results.Count() == 2);
+	TEST_TRUE(stats.m_nRowsScanned == 10);
+	TEST_TRUE(stats.m_nComparisons == 14);
+}
+TEST_CASE_END
+
+TEST_CASE("an IN query on a unique column counts the index probes instead of a scan")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,   CColumn::UNIQUE);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+
+	addRows(table, 10);
+
+	CValueSet values;
+	values.Add(2);
+	values.Add(4);
+	values.Add(20);
+
+	CWhereIn    where(0, values);
+	CQueryStats stats;
+	CResultSet  results = table.Select(where, stats);
+
+	TEST_TRUE(results.Count() == 2);
+	TEST_TRUE(stats.m_nRowsScanned == 0);
+	TEST_TRUE(stats.m_nIndexProbes == 3);
+	TEST_TRUE(stats.m_nRowsMatched == 2);
+
+	CString plan = table.Explain(where);
+
+	TEST_TRUE(contains(plan, TXT("INDEX LOOKUP Test (3 probes)")));
+	TEST_TRUE(contains(plan, TXT("WHERE ID IN (3 values)")));
+}
+TEST_CASE_END
+
+TEST_CASE("explaining a scan describes the table and where clause")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,   CColumn::DEFAULTS);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+
+	addRows(table, 10);
+
+	CString plan = table.Explain(CWhereCmp(0, CWhereCmp::GREATER, 4) || CWhereCmp(1, CWhereCmp::NOT_EQUALS, TXT("Odd")));
+
+	TEST_TRUE(contains(plan, TXT("SCAN Test (10 rows)")));
+	TEST_TRUE(contains(plan, TXT("(ID > 4 OR Name <> 'Odd')")));
+}
+TEST_CASE_END
+
+TEST_CASE("a table with QUERY_STATS keeps running totals of its queries")
+{
+	CTable table(TXT("Test"), CTable::DEFAULTS | CTable::QUERY_STATS);
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,   CColumn::UNIQUE);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+
+	addRows(table, 10);
+
+	TEST_TRUE(table.KeepsStats());
+
+	table.Select(CWhereCmp(1, CWhereCmp::EQUALS, TXT("Odd")));
+	table.Select(CWhereCmp(1, CWhereCmp::EQUALS, TXT("Even")));
+	table.SelectRow(0, 5);
+
+	CQueryStats totals = table.Statistics();
+
+	TEST_TRUE(totals.m_nQueries == 3);
+	TEST_TRUE(totals.m_nRowsScanned == 20);
+	TEST_TRUE(totals.m_nRowsMatched == 11);
+	TEST_TRUE(totals.m_nIndexProbes == 1);
+
+	table.ResetStatistics();
+
+	TEST_TRUE(table.Statistics().m_nQueries == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a table without QUERY_STATS keeps no totals")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,   CColumn::DEFAULTS);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+
+	addRows(table, 10);
+
+	table.Select(CWhereCmp(1, CWhereCmp::EQUALS, TXT("Odd")));
+
+	TEST_FALSE(table.KeepsStats());
+	TEST_TRUE(table.Statistics().m_nQueries == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a join counts the rows scanned and is explained as nested loops")
+{
+	CTable groups(TXT("Groups"));
+	groups.AddColumn(TXT("ID"),   MDCT_INT,    0,   CColumn::DEFAULTS);
+	groups.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+
+	addRows(groups, 3);
+
+	CTable items(TXT("Items"));
+	items.AddColumn(TXT("Group"), MDCT_INT,    0,   CColumn::DEFAULTS);
+	items.AddColumn(TXT("Name"),  MDCT_VARSTR, 256, CColumn::DEFAULTS);
+
+	addRows(items, 4);
+
+	CMDB mdb;
+	mdb.AddTable(groups);
+	mdb.AddTable(items);
+
+	CJoin join(0);
+	join.Add(1, 0, INNER_JOIN, 0);
+
+	CQueryStats stats;
+	CJoinedSet  results = mdb.Select(join, stats);
+
+	TEST_TRUE(results.Count() == 3);
+	TEST_TRUE(stats.m_nQueries == 1);
+	TEST_TRUE(stats.m_nRowsScanned == 3 + 3*4);
+	TEST_TRUE(stats.m_nComparisons == 3*4);
+	TEST_TRUE(stats.m_nRowsMatched == 3);
+
+	CString plan = mdb.Explain(join);
+
+	TEST_TRUE(contains(plan, TXT("SCAN Groups (3 rows)")));
+	TEST_TRUE(contains(plan, TXT("NESTED LOOP INNER JOIN Items ON Groups.ID = Items.Group (4 rows per outer row)")));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,243 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ReadViewTests.cpp
+//! \brief  The unit tests for the ReadView class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/ReadView.hpp>
+#include <MDBL/MDB.hpp>
+#include <MDBL/Table.hpp>
+#include <MDBL/ResultSet.hpp>
+#include <MDBL/WhereCmp.hpp>
+#include <MDBL/WhereIn.hpp>
+#include <MDBL/Join.hpp>
+#include <MDBL/JoinedSet.hpp>
+
+namespace
+{
+
+static void createTable(CTable& table)
+{
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,   CColumn::UNIQUE);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+
+	{ CRow& row = table.CreateRow(); row[0] = 1; row[1] = TXT("One"); table.InsertRow(row); }
+	{ CRow& row = table.CreateRow(); row[0] = 2; row[1] = TXT("Two"); table.InsertRow(row); }
+}
+
+}
+
+TEST_SET(ReadView)
+{
+
+TEST_CASE("a view does not see rows inserted after it was opened")
+{
+	CTable table(TXT("Test"));
+	createTable(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	CReadView view(mdb);
+
+	{ CRow& row = table.CreateRow(); row[0] = 3; row[1] = TXT("Three"); table.InsertRow(row); }
+
+	TEST_TRUE(table.RowCount() == 3);
+	TEST_TRUE(view.SelectAll(table).Count() == 2);
+	TEST_TRUE(view.SelectRow(table, 0, 3) == nullptr);
+	TEST_TRUE(view.SelectRow(table, 0, 2) != nullptr);
+}
+TEST_CASE_END
+
+TEST_CASE("a view sees the values of a row as they were when it was opened")
+{
+	CTable table(TXT("Test"));
+	createTable(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	{
+		CReadView view(mdb);
+
+		table.SelectRow(0, 1)->Field(1) = TXT("Uno");
+		table.SelectRow(0, 1)->Field(1) = TXT("Eins");
+
+		TEST_TRUE(mdb.Versions().VersionCount() == 1);
+
+		CRow* row = view.SelectRow(table, 0, 1);
+
+		TEST_TRUE(row != nullptr);
+		TEST_TRUE(row->Field(1) == TXT("One"));
+		TEST_TRUE(view.Select(table, CWhereCmp(1, CWhereCmp::EQUALS, TXT("One"))).Count() == 1);
+
+		CReadView later(mdb);
+
+		TEST_TRUE(later.SelectRow(table, 0, 1)->Field(1) == TXT("Eins"));
+	}
+
+	TEST_TRUE(mdb.Versions().VersionCount() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("a view returns the current row when it is unchanged")
+{
+	CTable table(TXT("Test"));
+	createTable(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	CReadView view(mdb);
+
+	table.SelectRow(0, 2)->Field(1) = TXT("Dos");
+
+	TEST_TRUE(view.SelectRow(table, 0, 1) == table.SelectRow(0, 1));
+	TEST_TRUE(view.SelectRow(table, 0, 2) != table.SelectRow(0, 2));
+	TEST_TRUE(view.SelectRow(table, 0, 2)->Field(1) == TXT("Two"));
+	TEST_TRUE(mdb.Versions().VersionCount() == 1);
+}
+TEST_CASE_END
+
+TEST_CASE("an indexed query through a view only sees the rows visible to it")
+{
+	CTable table(TXT("Test"));
+	createTable(table);
+
+	{ CRow& row = table.CreateRow(); row[0] = 3; row[1] = TXT("Three"); table.InsertRow(row); }
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	CReadView view(mdb);
+
+	{ CRow& row = table.CreateRow(); row[0] = 4; row[1] = TXT("Four"); table.InsertRow(row); }
+	table.SelectRow(0, 1)->Field(1) = TXT("Uno");
+	table.DeleteRow(*table.SelectRow(0, 2));
+
+	CValueSet values;
+	values.Add(CValue(1));
+	values.Add(CValue(2));
+	values.Add(CValue(4));
+
+	CResultSet rows = view.Select(table, CWhereIn(0, values));
+
+	TEST_TRUE(rows.Count() == 2);
+	TEST_TRUE(table.Select(CWhereIn(0, values)).Count() == 2);
+
+	bool one = false, two = false;
+
+	for (size_t i = 0; i != rows.Count(); ++i)
+	{
+		one = one || ((rows[i][0] == 1) && (rows[i][1] == TXT("One")));
+		two = two || ((rows[i][0] == 2) && (rows[i][1] == TXT("Two")));
+	}
+
+	TEST_TRUE(one && two);
+}
+TEST_CASE_END
+
+TEST_CASE("a view still sees rows deleted after it was opened")
+{
+	CTable table(TXT("Test"));
+	createTable(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	{
+		CReadView view(mdb);
+
+		table.DeleteRow(*table.SelectRow(0, 1));
+		table.SelectRow(0, 2)->Field(1) = TXT("Dos");
+		table.Truncate();
+
+		TEST_TRUE(table.RowCount() == 0);
+		TEST_TRUE(view.SelectAll(table).Count() == 2);
+		TEST_TRUE(view.SelectRow(table, 0, 1)->Field(1) == TXT("One"));
+		TEST_TRUE(view.SelectRow(table, 0, 2)->Field(1) == TXT("Two"));
+	}
+
+	TEST_TRUE(mdb.Versions().VersionCount() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("no old versions are kept when there are no views open")
+{
+	CTable table(TXT("Test"));
+	createTable(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	table.SelectRow(0, 1)->Field(1) = TXT("Uno");
+	table.DeleteRow(*table.SelectRow(0, 2));
+
+	TEST_TRUE(mdb.Versions().VersionCount() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("the changes made during an update are not visible until it ends")
+{
+	CTable table(TXT("Test"));
+	createTable(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	mdb.BeginUpdate();
+
+	table.SelectRow(0, 1)->Field(1) = TXT("Uno");
+
+	{
+		CReadView view(mdb);
+
+		{ CRow& row = table.CreateRow(); row[0] = 3; row[1] = TXT("Three"); table.InsertRow(row); }
+
+		TEST_TRUE(view.SelectAll(table).Count() == 2);
+		TEST_TRUE(view.SelectRow(table, 0, 1)->Field(1) == TXT("One"));
+	}
+
+	mdb.EndUpdate();
+
+	CReadView view(mdb);
+
+	TEST_TRUE(view.SelectAll(table).Count() == 3);
+	TEST_TRUE(view.SelectRow(table, 0, 1)->Field(1) == TXT("Uno"));
+}
+TEST_CASE_END
+
+TEST_CASE("a join through a view only sees the rows visible to it")
+{
+	CTable table1(TXT("1st-Table"));
+	createTable(table1);
+
+	CTable table2(TXT("2nd-Table"));
+	table2.AddColumn(TXT("ID"), MDCT_INT, 0, CColumn::DEFAULTS);
+
+	{ CRow& row = table2.CreateRow(); row[0] = 1; table2.InsertRow(row); }
+
+	CMDB mdb;
+	mdb.AddTable(table1);
+	mdb.AddTable(table2);
+
+	CReadView view(mdb);
+
+	{ CRow& row = table2.CreateRow(); row[0] = 2; table2.InsertRow(row); }
+
+	CJoin join(0);
+	join.Add(1, 0, OUTER_JOIN, 0);
+
+	CJoinedSet results = view.Select(join);
+
+	TEST_TRUE(results.Count() == 2);
+	TEST_TRUE(results[0][0][0] == 1 && results[1][0][0] == 1);
+	TEST_TRUE(results[0][1][0] == 2 && results[1][1][0] == null);
+	TEST_TRUE(mdb.Select(join).Count() == 2);
+	TEST_TRUE(mdb.Select(join)[1][1][0] == 2);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,155 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ReadWriteLockTests.cpp
+//! \brief  The unit tests for the ReadWriteLock class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/ReadWriteLock.hpp>
+#include <MDBL/Table.hpp>
+#include <process.h>
+
+namespace
+{
+
+//! The number of rows that are never deleted.
+static const int FIXED_ROWS = 100;
+
+//! The number of iterations each thread makes.
+static const int ITERATIONS = 200;
+
+//! The shared state for the reader and writer threads.
+struct Shared
+{
+	CTable*			m_pTable;
+	volatile LONG	m_nMissing;
+};
+
+static unsigned __stdcall readerThread(void* pParam)
+{
+	Shared* pShared = static_cast<Shared*>(pParam);
+
+	for (int i = 0; i != ITERATIONS; ++i)
+	{
+		for (int id = 0; id != FIXED_ROWS; ++id)
+		{
+			if (pShared->m_pTable->SelectRow(0, id) == nullptr)
+				::InterlockedIncrement(&pShared->m_nMissing);
+		}
+	}
+
+	return 0;
+}
+
+static unsigned __stdcall writerThread(void* pParam)
+{
+	Shared* pShared = static_cast<Shared*>(pParam);
+	CTable& table   = *pShared->m_pTable;
+
+	for (int i = 0; i != ITERATIONS; ++i)
+	{
+		CRow& row = table.CreateRow();
+
+		row[0] = FIXED_ROWS + i;
+		row[1] = i;
+
+		table.InsertRow(row);
+
+		table.SelectRow(0, i % FIXED_ROWS)->Field(1) = i;
+
+		table.DeleteRow(row);
+	}
+
+	return 0;
+}
+
+}
+
+TEST_SET(ReadWriteLock)
+{
+
+TEST_CASE("the exclusive owner can re-acquire the lock either way")
+{
+	CReadWriteLock lock;
+
+	TEST_FALSE(lock.OwnedExclusive());
+
+	lock.AcquireExclusive();
+	lock.AcquireExclusive();
+
+	TEST_TRUE(lock.OwnedExclusive());
+	TEST_FALSE(lock.AcquireShared());
+
+	lock.ReleaseExclusive();
+
+	TEST_TRUE(lock.OwnedExclusive());
+
+	lock.ReleaseExclusive();
+
+	TEST_FALSE(lock.OwnedExclusive());
+	TEST_TRUE(lock.AcquireShared());
+
+	lock.ReleaseShared();
+}
+TEST_CASE_END
+
+TEST_CASE("a guard only acquires the lock when enabled")
+{
+	CReadWriteLock lock;
+
+	{
+		CReadWriteLock::WriteGuard guard(lock, false);
+
+		TEST_FALSE(lock.OwnedExclusive());
+	}
+	{
+		CReadWriteLock::WriteGuard guard(lock, true);
+
+		TEST_TRUE(lock.OwnedExclusive());
+	}
+
+	TEST_FALSE(lock.OwnedExclusive());
+}
+TEST_CASE_END
+
+TEST_CASE("a concurrent table can be read by many threads whilst another writes to it")
+{
+	CTable table(TXT("Test"), CTable::DEFAULTS | CTable::CONCURRENT);
+	table.AddColumn(TXT("ID"),    MDCT_INT, 0, CColumn::UNIQUE);
+	table.AddColumn(TXT("Value"), MDCT_INT, 0, CColumn::DEFAULTS);
+
+	for (int id = 0; id != FIXED_ROWS; ++id)
+	{
+		CRow& row = table.CreateRow();
+
+		row[0] = id;
+		row[1] = 0;
+
+		table.InsertRow(row);
+	}
+
+	Shared shared = { &table, 0 };
+
+	const size_t THREADS = 4;
+	HANDLE       threads[THREADS];
+
+	threads[0] = reinterpret_cast<HANDLE>(::_beginthreadex(nullptr, 0, writerThread, &shared, 0, nullptr));
+
+	for (size_t i = 1; i != THREADS; ++i)
+		threads[i] = reinterpret_cast<HANDLE>(::_beginthreadex(nullptr, 0, readerThread, &shared, 0, nullptr));
+
+	for (size_t i = 0; i != THREADS; ++i)
+	{
+		::WaitForSingleObject(threads[i], INFINITE);
+		::CloseHandle(threads[i]);
+	}
+
+	TEST_TRUE(shared.m_nMissing == 0);
+	TEST_TRUE(table.RowCount() == FIXED_ROWS);
+	TEST_TRUE(table.SelectRow(0, (ITERATIONS-1) % FIXED_ROWS)->Field(1) == ITERATIONS-1);
+	TEST_TRUE(table.Modified());
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
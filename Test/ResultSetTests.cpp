@@ -7,6 +7,8 @@
 #include <Core/UnitTest.hpp>
 #include <MDBL/ResultSet.hpp>
 #include <MDBL/Table.hpp>
+#include <MDBL/WhereCmp.hpp>
+#include <MDBL/GroupSet.hpp>
 
 namespace
 {
@@ -166,5 +168,171 @@ TEST_CASE("a result set can be sorted by a nullable, case-insensitive string col
 }
 TEST_CASE_END
 
+TEST_CASE("a select that is split across the worker pool returns the matching rows in the original order")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("Value"), MDCT_INT, 0, CColumn::NULLABLE);
+	createRows(table, 1000);
+
+	for (size_t i = 0; i != table.RowCount(); ++i)
+		table[i][0] = static_cast<int>(table.RowCount() - i);
+
+	const size_t oldThreshold = CResultSet::ParallelThreshold();
+	CResultSet::ParallelThreshold(1);
+
+	CResultSet tableRows = table.Select(CWhereCmp(0, CWhereCmp::GREATER, 500));
+	CResultSet resultSetRows = table.SelectAll().Select(CWhereCmp(0, CWhereCmp::GREATER, 500));
+
+	CResultSet::ParallelThreshold(oldThreshold);
+
+	TEST_TRUE(tableRows.Count() == 500);
+	TEST_TRUE(resultSetRows.Count() == 500);
+
+	for (size_t i = 0; i != tableRows.Count(); ++i)
+	{
+		TEST_TRUE(&tableRows[i] == &table[i]);
+		TEST_TRUE(&resultSetRows[i] == &table[i]);
+	}
+}
+TEST_CASE_END
+
+TEST_CASE("a sort that is split across the worker pool orders by multiple columns with nulls first")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("Group"), MDCT_INT, 0, CColumn::NULLABLE);
+	table.AddColumn(TXT("Value"), MDCT_INT, 0, CColumn::NULLABLE);
+	createRows(table, 1000);
+
+	for (size_t i = 0; i != table.RowCount(); ++i)
+	{
+		if ((i % 10) != 0)
+			table[i][0] = static_cast<int>(i % 7);
+
+		table[i][1] = static_cast<int>(i);
+	}
+
+	CSortColumns order;
+	order.Add(0, CSortColumns::ASC);
+	order.Add(1, CSortColumns::DESC);
+
+	const size_t oldThreshold = CResultSet::ParallelSortThreshold();
+	CResultSet::ParallelSortThreshold(1);
+
+	CResultSet rows = table.SelectAll();
+	rows.OrderBy(order);
+
+	CResultSet::ParallelSortThreshold(oldThreshold);
+
+	TEST_TRUE(rows.Count() == 1000);
+	TEST_TRUE(rows[0][0] == null);
+	TEST_TRUE(rows[0][1] == 990);
+	TEST_TRUE(rows[999][0] == 6);
+
+	bool ordered = true;
+
+	for (size_t i = 1; i != rows.Count(); ++i)
+	{
+		int result = rows[i-1][0].Compare(rows[i][0]);
+
+		if ( (result > 0) || ((result == 0) && (rows[i-1][1].Compare(rows[i][1]) <= 0)) )
+			ordered = false;
+	}
+
+	TEST_TRUE(ordered);
+}
+TEST_CASE_END
+
+TEST_CASE("a parallel sort of an empty or single row result set does nothing")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("Value"), MDCT_INT, 0, CColumn::NULLABLE);
+
+	const size_t oldThreshold = CResultSet::ParallelSortThreshold();
+	CResultSet::ParallelSortThreshold(0);
+
+	CResultSet none = table.SelectAll();
+	none.OrderBy(0, CSortColumns::ASC);
+
+	createRows(table, 1);
+
+	CResultSet one = table.SelectAll();
+	one.OrderBy(0, CSortColumns::ASC);
+
+	CResultSet::ParallelSortThreshold(oldThreshold);
+
+	TEST_TRUE(none.Count() == 0);
+	TEST_TRUE(one.Count() == 1);
+}
+TEST_CASE_END
+
+TEST_CASE("grouping a result set splits the rows into groups ordered by the column value")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("Value"), MDCT_INT, 0, CColumn::NULLABLE);
+	createRows(table, 6);
+
+	table[0][0] = 2;
+	table[1][0] = 1;
+	table[2][0] = 2;
+	table[3][0] = null;
+	table[4][0] = 1;
+	table[5][0] = 2;
+
+	CGroupSet groups = table.SelectAll().GroupBy(0);
+
+	TEST_TRUE(groups.Count() == 3);
+	TEST_TRUE(groups[0].Count() == 1);
+	TEST_TRUE(groups[0][0][0] == null);
+	TEST_TRUE(groups[1].Count() == 2);
+	TEST_TRUE(groups[1][1][0] == 1);
+	TEST_TRUE(groups[2].Count() == 3);
+	TEST_TRUE(groups[2][2][0] == 2);
+	TEST_TRUE(&groups[2].Table() == &table);
+}
+TEST_CASE_END
+
+TEST_CASE("swapping result sets exchanges the rows without copying them")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("Value"), MDCT_INT, 0, CColumn::NULLABLE);
+	createRows(table, 3);
+
+	CResultSet all = table.SelectAll();
+	CResultSet none(table);
+
+	all.Swap(none);
+
+	TEST_TRUE(all.Count() == 0);
+	TEST_TRUE(none.Count() == 3);
+	TEST_TRUE(&none[0] == &table[0]);
+}
+TEST_CASE_END
+
+#ifdef MDBL_HAS_RVALUE_REFS
+
+TEST_CASE("moving a result set transfers the rows and leaves the source empty")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("Value"), MDCT_INT, 0, CColumn::NULLABLE);
+	createRows(table, 3);
+
+	CResultSet all = table.SelectAll();
+	CResultSet moved(std::move(all));
+
+	TEST_TRUE(all.Count() == 0);
+	TEST_TRUE(moved.Count() == 3);
+	TEST_TRUE(&moved.Table() == &table);
+
+	CResultSet assigned(table);
+	assigned = std::move(moved);
+
+	TEST_TRUE(moved.Count() == 0);
+	TEST_TRUE(assigned.Count() == 3);
+	TEST_TRUE(&assigned[2] == &table[2]);
+}
+TEST_CASE_END
+
+#endif
+
 }
 TEST_SET_END
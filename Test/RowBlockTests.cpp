@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RowBlockTests.cpp
+//! \brief  The unit tests for the RowBlock class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/MDB.hpp>
+#include <MDBL/RowBlock.hpp>
+#include <MDBL/MDBException.hpp>
+#include <WCL/MemStream.hpp>
+
+namespace
+{
+
+static const int ROW_COUNT = 10000;
+
+static void createSchema(CTable& table)
+{
+	table.AddColumn(TXT("ID"),      MDCT_IDENTITY, 0,  CColumn::IDENTITY);
+	table.AddColumn(TXT("Name"),    MDCT_VARSTR,   50, CColumn::NULLABLE);
+	table.AddColumn(TXT("Code"),    MDCT_FXDSTR,   10, CColumn::DEFAULTS);
+	table.AddColumn(TXT("Price"),   MDCT_DOUBLE,   0,  CColumn::NULLABLE);
+	table.AddColumn(TXT("Count"),   MDCT_INT64,    0,  CColumn::NULLABLE);
+	table.AddColumn(TXT("Flag"),    MDCT_BOOL,     0,  CColumn::DEFAULTS);
+	table.AddColumn(TXT("Comment"), MDCT_VARSTR,   50, CColumn::NULLABLE);
+}
+
+static void createRows(CTable& table)
+{
+	const tchar* names[] = { TXT("Apple"), TXT("Banana"), TXT("Cherry") };
+
+	for (int i = 0; i != ROW_COUNT; ++i)
+	{
+		CRow& row = table.CreateRow();
+
+		if (i % 10 != 0)
+			row[1] = names[i % 3];
+		else
+			row[1] = null;
+
+		row[2] = Core::fmt(TXT("C%d"), i).c_str();
+		row[3] = i * 0.25;
+
+		if (i % 5 != 0)
+			row[4] = static_cast<int64>(i) * -1000000000;
+		else
+			row[4] = null;
+
+		row[5] = (i % 2 == 0);
+		row[6] = null;
+
+		table.InsertRow(row);
+	}
+}
+
+}
+
+TEST_SET(RowBlock)
+{
+
+TEST_CASE("a table written in the compressed format can be read back")
+{
+	CBuffer rawBuffer;
+	CBuffer buffer;
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+		createRows(table);
+
+		CMemStream rawStream(rawBuffer);
+		rawStream.Create();
+		table.Write(rawStream);
+		rawStream.Close();
+
+		createRows(table);
+
+		CMemStream stream(buffer);
+		stream.Create();
+		table.WriteCompressed(stream);
+		stream.Close();
+
+		TEST_FALSE(table.Modified());
+	}
+
+	TEST_TRUE(buffer.Size() < (rawBuffer.Size() / 2));
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	CMemStream stream(buffer);
+	stream.Open();
+	table.ReadCompressed(stream);
+	stream.Close();
+
+	TEST_TRUE(table.RowCount() == (ROW_COUNT * 2));
+	TEST_TRUE(table[0][0] == 1);
+	TEST_TRUE(table[0][1] == null);
+	TEST_TRUE(table[1][1].GetString() == tstring(TXT("Banana")));
+	TEST_TRUE(table[9999][2].GetString() == tstring(TXT("C9999")));
+	TEST_TRUE(table[9999][3] == 9999 * 0.25);
+	TEST_TRUE(table[5][4] == null);
+	TEST_TRUE(table[9999][4].GetInt64() == -9999000000000LL);
+	TEST_TRUE(table[9999][5] == false);
+	TEST_TRUE(table[9999][6] == null);
+	TEST_TRUE(table[ROW_COUNT*2-1][0] == (ROW_COUNT*2));
+	TEST_TRUE(table.SelectRow(0, ROW_COUNT+1) == &table[ROW_COUNT]);
+	TEST_FALSE(table.Modified());
+
+	CRow& row = table.CreateRow();
+	table.InsertRow(row);
+
+	TEST_TRUE(row[0] == (ROW_COUNT*2+1));
+}
+TEST_CASE_END
+
+TEST_CASE("reading a corrupt block throws")
+{
+	CBuffer buffer;
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+		createRows(table);
+
+		CMemStream stream(buffer);
+		stream.Create();
+		table.WriteCompressed(stream);
+		stream.Close();
+	}
+
+	// Corrupt the packed size of the first block.
+	static_cast<byte*>(buffer.Buffer())[19] = 0x7F;
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	CMemStream stream(buffer);
+	stream.Open();
+
+	TEST_THROWS(table.ReadCompressed(stream));
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,155 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   RowCursorTests.cpp
+//! \brief  The unit tests for the RowCursor class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/RowCursor.hpp>
+#include <MDBL/ResultSet.hpp>
+#include <MDBL/Table.hpp>
+#include <MDBL/WhereCmp.hpp>
+
+namespace
+{
+
+static void createRows(CTable& table, size_t count)
+{
+	for (size_t i = 0; i != count; ++i)
+	{
+		CRow& row = table.CreateRow();
+
+		row[0] = static_cast<int>(i);
+		row[1] = static_cast<int>(i % 2);
+
+		table.InsertRow(row);
+	}
+}
+
+}
+
+TEST_SET(RowCursor)
+{
+
+TEST_CASE("a cursor over a table returns every row in order")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("ID"),  MDCT_INT, 0, CColumn::DEFAULTS);
+	table.AddColumn(TXT("Odd"), MDCT_INT, 0, CColumn::DEFAULTS);
+	createRows(table, 5);
+
+	CRowCursor cursor = table.Query();
+	size_t count = 0;
+
+	while (cursor.Next())
+	{
+		TEST_TRUE(&cursor.Row() == &table[count]);
+		++count;
+	}
+
+	TEST_TRUE(count == 5);
+	TEST_FALSE(cursor.Next());
+}
+TEST_CASE_END
+
+TEST_CASE("chained where clauses are combined and only evaluated as the cursor moves")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("ID"),  MDCT_INT, 0, CColumn::DEFAULTS);
+	table.AddColumn(TXT("Odd"), MDCT_INT, 0, CColumn::DEFAULTS);
+	createRows(table, 10);
+
+	CRowCursor cursor = table.Query().Where(CWhereCmp(1, CWhereCmp::EQUALS, 1))
+	                                 .Where(CWhereCmp(0, CWhereCmp::GREATER, 4));
+
+	TEST_TRUE(cursor.Next());
+	TEST_TRUE(cursor.Row()[0] == 5);
+	TEST_TRUE(cursor.Count() == 2);
+}
+TEST_CASE_END
+
+TEST_CASE("a limit stops the cursor after the specified number of rows")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("ID"),  MDCT_INT, 0, CColumn::DEFAULTS);
+	table.AddColumn(TXT("Odd"), MDCT_INT, 0, CColumn::DEFAULTS);
+	createRows(table, 10);
+
+	CResultSet rows = table.Query().Where(CWhereCmp(1, CWhereCmp::EQUALS, 0)).Limit(3).ToResultSet();
+
+	TEST_TRUE(rows.Count() == 3);
+	TEST_TRUE(rows[0][0] == 0);
+	TEST_TRUE(rows[2][0] == 4);
+}
+TEST_CASE_END
+
+TEST_CASE("a projection maps the field index onto the selected columns")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("ID"),  MDCT_INT, 0, CColumn::DEFAULTS);
+	table.AddColumn(TXT("Odd"), MDCT_INT, 0, CColumn::DEFAULTS);
+	createRows(table, 4);
+
+	CResultSet rows = table.SelectAll();
+	CRowCursor cursor = rows.Query().Project(1).Project(0);
+
+	TEST_TRUE(cursor.NumColumns() == 2);
+	TEST_TRUE(cursor.Next() && cursor.Next());
+	TEST_TRUE(cursor.Field(0) == 1);
+	TEST_TRUE(cursor.Field(1) == 1);
+}
+TEST_CASE_END
+
+TEST_CASE("exists and first stop at the first matching row")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("ID"),  MDCT_INT, 0, CColumn::DEFAULTS);
+	table.AddColumn(TXT("Odd"), MDCT_INT, 0, CColumn::DEFAULTS);
+	createRows(table, 10);
+
+	TEST_TRUE(table.Query().Where(CWhereCmp(0, CWhereCmp::EQUALS, 7)).Exists());
+	TEST_FALSE(table.Query().Where(CWhereCmp(0, CWhereCmp::EQUALS, 70)).Exists());
+
+	CRowCursor cursor = table.Query().Where(CWhereCmp(1, CWhereCmp::EQUALS, 1));
+
+	TEST_TRUE(cursor.First() == &table[1]);
+	TEST_TRUE(cursor.Next());
+	TEST_TRUE(&cursor.Row() == &table[3]);
+
+	cursor.Reset();
+
+	TEST_TRUE(cursor.First() == &table[1]);
+}
+TEST_CASE_END
+
+TEST_CASE("a cursor over a concurrent table is unaffected by rows inserted whilst it is used")
+{
+	CTable table(TXT("Test"), CTable::DEFAULTS | CTable::CONCURRENT);
+	table.AddColumn(TXT("ID"),  MDCT_INT, 0, CColumn::DEFAULTS);
+	table.AddColumn(TXT("Odd"), MDCT_INT, 0, CColumn::DEFAULTS);
+	createRows(table, 5);
+
+	CRowCursor cursor = table.Query();
+	CRowCursor copy   = cursor;
+	size_t     count  = 0;
+
+	TEST_TRUE(cursor.Next());
+
+	// Force the rows to be reallocated.
+	createRows(table, 1000);
+
+	do
+	{
+		TEST_TRUE(&cursor.Row() == &table[count]);
+		++count;
+	}
+	while (cursor.Next());
+
+	TEST_TRUE(count == 5);
+	TEST_TRUE(copy.Count() == 5);
+	TEST_TRUE(table.Query().Count() == 1005);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,651 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   SnapshotTests.cpp
+//! \brief  The unit tests for the Snapshot class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/MDB.hpp>
+#include <MDBL/Snapshot.hpp>
+#include <MDBL/MDBException.hpp>
+#include <MDBL/TableSet.hpp>
+#include <MDBL/LocalSource.hpp>
+#include <WCL/MemStream.hpp>
+#include <process.h>
+
+namespace
+{
+
+static const tchar* SNAPSHOT_FILE = TXT("SnapshotTests.snp");
+
+static void createSchema(CTable& table)
+{
+	table.AddColumn(TXT("ID"),    MDCT_INT,    0,  CColumn::UNIQUE);
+	table.AddColumn(TXT("Name"),  MDCT_VARSTR, 50, CColumn::NULLABLE);
+	table.AddColumn(TXT("Code"),  MDCT_FXDSTR, 10, CColumn::DEFAULTS);
+	table.AddColumn(TXT("Price"), MDCT_DOUBLE, 0,  CColumn::NULLABLE);
+}
+
+static void corruptFile(const tchar* file, uint64 offset)
+{
+	HANDLE        handle = ::CreateFile(file, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	LARGE_INTEGER position;
+	byte          value = 0xFF;
+	DWORD         written = 0;
+
+	position.QuadPart = offset;
+
+	::SetFilePointerEx(handle, position, nullptr, FILE_BEGIN);
+	::WriteFile(handle, &value, sizeof(value), &written, nullptr);
+	::CloseHandle(handle);
+}
+
+static void createRows(CTable& table)
+{
+	{ CRow& row = table.CreateRow(); row[0] = 1; row[1] = TXT("First");  row[2] = TXT("A"); row[3] = 1.5;  table.InsertRow(row); }
+	{ CRow& row = table.CreateRow(); row[0] = 2; row[1] = null;          row[2] = TXT("B"); row[3] = null; table.InsertRow(row); }
+	{ CRow& row = table.CreateRow(); row[0] = 3; row[1] = TXT("");       row[2] = TXT("C"); row[3] = 3.0;  table.InsertRow(row); }
+}
+
+//! The number of rows inserted whilst the snapshots are written.
+static const int WRITES = 2000;
+
+struct Shared
+{
+	CTable*			m_pTable;
+	volatile LONG	m_bDone;
+};
+
+static unsigned __stdcall writerThread(void* pParam)
+{
+	Shared* pShared = static_cast<Shared*>(pParam);
+	CTable& table   = *pShared->m_pTable;
+
+	for (int i = 0; i != WRITES; ++i)
+	{
+		CRow& row = table.CreateRow();
+
+		row[0] = 10 + i;
+		row[1] = TXT("Inserted");
+		row[2] = TXT("W");
+
+		table.InsertRow(row);
+
+		// Change the size of the string heap.
+		table.SelectRow(0, 1)->Field(1) = tstring(i % 50, TXT('x')).c_str();
+	}
+
+	::InterlockedExchange(&pShared->m_bDone, 1);
+
+	return 0;
+}
+
+}
+
+TEST_SET(Snapshot)
+{
+
+TEST_CASE("a database written to a snapshot can be read back into the same schema")
+{
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+		createRows(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+
+		TEST_FALSE(table.Modified());
+	}
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+	mdb.ReadSnapshot(SNAPSHOT_FILE);
+
+	TEST_TRUE(table.RowCount() == 3);
+	TEST_FALSE(table[0].Mapped());
+	TEST_TRUE(table[0][1].GetString() == tstring(TXT("First")));
+	TEST_TRUE(table[1][1] == null);
+	TEST_TRUE(table[1][3] == null);
+	TEST_TRUE(table[2][1].GetString() == tstring(TXT("")));
+	TEST_TRUE(table[2][2].GetString() == tstring(TXT("C")));
+	TEST_TRUE(table[2][3] == 3.0);
+	TEST_TRUE(table.SelectRow(0, 2) == &table[1]);
+	TEST_FALSE(table.Modified());
+
+	table[0][1] = TXT("Changed");
+
+	TEST_TRUE(table[0][1].GetString() == tstring(TXT("Changed")));
+
+	::DeleteFile(SNAPSHOT_FILE);
+}
+TEST_CASE_END
+
+TEST_CASE("a read-only table uses the snapshot data in place")
+{
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+		createRows(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+	}
+
+	{
+		CTable table(TXT("Test"), CTable::READ_ONLY);
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.ReadSnapshot(SNAPSHOT_FILE);
+
+		TEST_TRUE(table.RowCount() == 3);
+		TEST_TRUE(table[0].Mapped());
+		TEST_TRUE(table[0][0] == 1);
+		TEST_TRUE(table[0][1].GetString() == tstring(TXT("First")));
+		TEST_TRUE(table[1][1] == null);
+		TEST_TRUE(table[0][3] == 1.5);
+		TEST_TRUE(table.SelectRow(0, 3) == &table[2]);
+
+		table.Truncate();
+
+		TEST_TRUE(table.RowCount() == 0);
+	}
+
+	::DeleteFile(SNAPSHOT_FILE);
+}
+TEST_CASE_END
+
+TEST_CASE("a read-only table loaded from a snapshot can be written back to the same file")
+{
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+		createRows(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+	}
+
+	{
+		CTable table(TXT("Test"), CTable::READ_ONLY);
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.ReadSnapshot(SNAPSHOT_FILE);
+
+		TEST_TRUE(table[0].Mapped());
+
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+
+		TEST_FALSE(table[0].Mapped());
+		TEST_TRUE(table[0][1].GetString() == tstring(TXT("First")));
+		TEST_TRUE(table.SelectRow(0, 3) == &table[2]);
+	}
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.ReadSnapshot(SNAPSHOT_FILE);
+
+		TEST_TRUE(table.RowCount() == 3);
+		TEST_TRUE(table[0][0] == 1);
+		TEST_TRUE(table[0][1].GetString() == tstring(TXT("First")));
+		TEST_TRUE(tstrcmp(table[0][2].GetString(), TXT("A")) == 0);
+		TEST_TRUE(table[0][3] == 1.5);
+		TEST_TRUE(table[1][1] == null);
+		TEST_TRUE(table[1][3] == null);
+		TEST_TRUE(table[2][1].GetString() == tstring(TXT("")));
+		TEST_TRUE(tstrcmp(table[2][2].GetString(), TXT("C")) == 0);
+		TEST_TRUE(table[2][3] == 3.0);
+	}
+
+	TEST_TRUE(::DeleteFile(SNAPSHOT_FILE));
+}
+TEST_CASE_END
+
+TEST_CASE("reloading a read-only table from a SQL source releases the snapshot")
+{
+	CTable source(TXT("Test"));
+	createSchema(source);
+	createRows(source);
+
+	{
+		CMDB mdb;
+		mdb.AddTable(source);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+	}
+
+	CLocalSource sql(TXT(""));
+	sql.CreateTable(source);
+
+	CTable table(TXT("Test"), CTable::READ_ONLY);
+	createSchema(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+	mdb.ReadSnapshot(SNAPSHOT_FILE);
+
+	TEST_TRUE(table[0].Mapped());
+
+	table.Read(sql);
+
+	TEST_TRUE(table.RowCount() == 0);
+	TEST_TRUE(::DeleteFile(SNAPSHOT_FILE));
+}
+TEST_CASE_END
+
+TEST_CASE("tables are read back after the tables their foreign keys refer to")
+{
+	{
+		CTable parent(TXT("Parent"));
+		createSchema(parent);
+		createRows(parent);
+
+		CTable child(TXT("Child"));
+		child.AddColumn(TXT("ID"),       MDCT_INT, 0, CColumn::UNIQUE);
+		child.AddColumn(TXT("ParentID"), parent,   0);
+
+		for (int i = 1; i <= 100; ++i)
+		{
+			CRow& row = child.CreateRow();
+			row[0] = i;
+			row[1] = (i % 3) + 1;
+			child.InsertRow(row);
+		}
+
+		CTable other(TXT("Other"));
+		createSchema(other);
+		createRows(other);
+
+		CMDB mdb;
+		mdb.AddTable(child);
+		mdb.AddTable(other);
+		mdb.AddTable(parent);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+
+		TEST_FALSE(child.Modified());
+	}
+
+	CTable parent(TXT("Parent"), CTable::READ_ONLY);
+	createSchema(parent);
+
+	CTable child(TXT("Child"));
+	child.AddColumn(TXT("ID"),       MDCT_INT, 0, CColumn::UNIQUE);
+	child.AddColumn(TXT("ParentID"), parent,   0);
+
+	CTable other(TXT("Other"));
+	createSchema(other);
+
+	CMDB mdb;
+	mdb.AddTable(child);
+	mdb.AddTable(other);
+	mdb.AddTable(parent);
+	mdb.ReadSnapshot(SNAPSHOT_FILE);
+
+	TEST_TRUE(parent.RowCount() == 3);
+	TEST_TRUE(parent[0].Mapped());
+	TEST_TRUE(other.RowCount() == 3);
+	TEST_TRUE(other[2][3] == 3.0);
+	TEST_TRUE(child.RowCount() == 100);
+	TEST_TRUE(child[99][0] == 100);
+	TEST_TRUE(child[99][1] == 2);
+	TEST_TRUE(child.SelectRow(0, 50) == &child[49]);
+
+	::DeleteFile(SNAPSHOT_FILE);
+}
+TEST_CASE_END
+
+TEST_CASE("reading a snapshot into a different schema or from a missing file throws")
+{
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+		createRows(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+	}
+
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("ID"), MDCT_INT, 0, CColumn::UNIQUE);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	TEST_THROWS(mdb.ReadSnapshot(SNAPSHOT_FILE));
+
+	::DeleteFile(SNAPSHOT_FILE);
+
+	TEST_THROWS(mdb.ReadSnapshot(SNAPSHOT_FILE));
+}
+TEST_CASE_END
+
+TEST_CASE("a snapshot describes the schema of its tables")
+{
+	CTable table(TXT("Test"));
+	createSchema(table);
+	createRows(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+	mdb.WriteSnapshot(SNAPSHOT_FILE);
+
+	{
+		CSnapshotPtr snapshot = CSnapshot::Open(SNAPSHOT_FILE);
+
+		const CSnapshot::TableHeader&  header  = snapshot->Table(0);
+		const CSnapshot::ColumnHeader* columns = snapshot->Columns(header);
+
+		TEST_TRUE(header.m_nColumns == 4);
+		TEST_TRUE(tstring(columns[1].m_szName) == TXT("Name"));
+		TEST_TRUE(columns[1].m_eType == MDCT_VARSTR);
+		TEST_TRUE(columns[2].m_nLength == 10);
+
+		snapshot->Verify();
+	}
+
+	::DeleteFile(SNAPSHOT_FILE);
+}
+TEST_CASE_END
+
+TEST_CASE("a subset of the tables can be read from a snapshot")
+{
+	{
+		CTable first(TXT("First"));
+		createSchema(first);
+		createRows(first);
+
+		CTable second(TXT("Second"));
+		createSchema(second);
+		createRows(second);
+
+		CMDB mdb;
+		mdb.AddTable(first);
+		mdb.AddTable(second);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+	}
+
+	CTable second(TXT("Second"));
+	createSchema(second);
+
+	CTableSet tables;
+	tables.Add(second);
+
+	{
+		CSnapshotPtr snapshot = CSnapshot::Open(SNAPSHOT_FILE);
+
+		CSnapshot::Read(snapshot, tables);
+	}
+
+	TEST_TRUE(second.RowCount() == 3);
+	TEST_TRUE(second[0][1].GetString() == tstring(TXT("First")));
+
+	::DeleteFile(SNAPSHOT_FILE);
+}
+TEST_CASE_END
+
+TEST_CASE("a lazily loaded table is only read when its rows are first accessed")
+{
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+		createRows(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+	}
+
+	{
+		CTable table(TXT("Test"), CTable::LAZY_LOAD);
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.ReadSnapshot(SNAPSHOT_FILE);
+
+		TEST_FALSE(table.Loaded());
+		TEST_TRUE(table.RowCount() == 3);
+		TEST_TRUE(table.Loaded());
+		TEST_TRUE(table[2][2].GetString() == tstring(TXT("C")));
+	}
+
+	::DeleteFile(SNAPSHOT_FILE);
+}
+TEST_CASE_END
+
+TEST_CASE("a named subset of the tables can be read from a snapshot")
+{
+	{
+		CTable first(TXT("First"));
+		createSchema(first);
+		createRows(first);
+
+		CTable second(TXT("Second"));
+		createSchema(second);
+		createRows(second);
+
+		CMDB mdb;
+		mdb.AddTable(first);
+		mdb.AddTable(second);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+	}
+
+	CTable first(TXT("First"));
+	createSchema(first);
+
+	CTable second(TXT("Second"));
+	createSchema(second);
+
+	CMDB mdb;
+	mdb.AddTable(first);
+	mdb.AddTable(second);
+
+	CStrArray names;
+	names.Add(TXT("Second"));
+
+	mdb.ReadSnapshot(SNAPSHOT_FILE, names);
+
+	TEST_TRUE(first.RowCount() == 0);
+	TEST_TRUE(second.RowCount() == 3);
+
+	::DeleteFile(SNAPSHOT_FILE);
+}
+TEST_CASE_END
+
+TEST_CASE("a corrupt header or table is detected by its checksum")
+{
+	uint64 schema = 0;
+	uint64 data   = 0;
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+		createRows(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+
+		CSnapshotPtr snapshot = CSnapshot::Open(SNAPSHOT_FILE);
+
+		schema = snapshot->Table(0).m_nSchema;
+		data   = snapshot->Table(0).m_nData;
+	}
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	corruptFile(SNAPSHOT_FILE, data);
+
+	{
+		CSnapshotPtr snapshot = CSnapshot::Open(SNAPSHOT_FILE);
+
+		TEST_THROWS(snapshot->Verify());
+	}
+
+	TEST_THROWS(mdb.ReadSnapshot(SNAPSHOT_FILE));
+	TEST_TRUE(table.RowCount() == 0);
+
+	corruptFile(SNAPSHOT_FILE, schema);
+
+	TEST_THROWS(CSnapshot::Open(SNAPSHOT_FILE));
+
+	::DeleteFile(SNAPSHOT_FILE);
+}
+TEST_CASE_END
+
+TEST_CASE("a snapshot that fails to be written leaves no temporary file behind")
+{
+	const tstring temp = tstring(SNAPSHOT_FILE) + TXT(".tmp");
+
+	CTable table(TXT("Test"));
+	createSchema(table);
+	createRows(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+	mdb.WriteSnapshot(SNAPSHOT_FILE);
+
+	{
+		// A mapped file can't be replaced.
+		CSnapshotPtr snapshot = CSnapshot::Open(SNAPSHOT_FILE);
+
+		TEST_THROWS(mdb.WriteSnapshot(SNAPSHOT_FILE));
+		TEST_TRUE(::GetFileAttributes(temp.c_str()) == INVALID_FILE_ATTRIBUTES);
+	}
+
+	::DeleteFile(SNAPSHOT_FILE);
+}
+TEST_CASE_END
+
+TEST_CASE("a delta read into a read-only table replaces the mapped rows it updates")
+{
+	CBuffer delta;
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+		createRows(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+
+		table[0][1] = TXT("Changed");
+		table[0][3] = 9.5;
+
+		CMemStream stream(delta);
+		stream.Create();
+		mdb.WriteDelta(stream);
+		stream.Close();
+	}
+
+	{
+		CTable table(TXT("Test"), CTable::READ_ONLY);
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.ReadSnapshot(SNAPSHOT_FILE);
+
+		CMemStream stream(delta);
+		stream.Open();
+		mdb.ReadDelta(stream);
+		stream.Close();
+
+		CRow* row = table.SelectRow(0, 1);
+
+		TEST_TRUE(table.RowCount() == 3);
+		TEST_TRUE(row != nullptr);
+		TEST_FALSE(row->Mapped());
+		TEST_TRUE(row->Field(1).GetString() == tstring(TXT("Changed")));
+		TEST_TRUE(row->Field(2).GetString() == tstring(TXT("A")));
+		TEST_TRUE(row->Field(3) == 9.5);
+		TEST_TRUE(table.SelectRow(0, 2)->Mapped());
+		TEST_FALSE(table.Modified());
+	}
+
+	{
+		CTable table(TXT("Test"));
+		createSchema(table);
+
+		CMDB mdb;
+		mdb.AddTable(table);
+		mdb.ReadSnapshot(SNAPSHOT_FILE);
+
+		TEST_TRUE(table.SelectRow(0, 1)->Field(1).GetString() == tstring(TXT("First")));
+		TEST_TRUE(table.SelectRow(0, 1)->Field(3) == 1.5);
+	}
+
+	::DeleteFile(SNAPSHOT_FILE);
+}
+TEST_CASE_END
+
+TEST_CASE("a concurrent table can be written to a snapshot whilst another thread changes it")
+{
+	CTable table(TXT("Test"), CTable::DEFAULTS | CTable::CONCURRENT);
+	createSchema(table);
+	createRows(table);
+
+	CMDB mdb;
+	mdb.AddTable(table);
+
+	Shared shared = { &table, 0 };
+	bool   valid  = true;
+	bool   done   = false;
+
+	HANDLE thread = reinterpret_cast<HANDLE>(::_beginthreadex(nullptr, 0, writerThread, &shared, 0, nullptr));
+
+	while (!done && valid)
+	{
+		done = (shared.m_bDone != 0);
+
+		mdb.WriteSnapshot(SNAPSHOT_FILE);
+
+		CTable copy(TXT("Test"));
+		createSchema(copy);
+
+		CMDB other;
+		other.AddTable(copy);
+
+		try
+		{
+			CSnapshot::Open(SNAPSHOT_FILE)->Verify();
+			other.ReadSnapshot(SNAPSHOT_FILE);
+		}
+		catch (const CMDBException&)
+		{
+			valid = false;
+		}
+	}
+
+	::WaitForSingleObject(thread, INFINITE);
+	::CloseHandle(thread);
+
+	TEST_TRUE(valid);
+	TEST_TRUE(table.RowCount() == 3 + WRITES);
+	TEST_FALSE(table.Modified());
+
+	::DeleteFile(SNAPSHOT_FILE);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -11,6 +11,7 @@
 #include <MDBL/TimeStamp.hpp>
 #include "Mocks/MockSQLSource.hpp"
 #include "Mocks/MockSQLCursor.hpp"
+#include <WCL/MemStream.hpp>
 
 using namespace Mocks;
 
@@ -105,5 +106,246 @@ TEST_CASE("A table can be created from the result set of an explicit query")
 }
 TEST_CASE_END
 
+TEST_CASE("Refreshing a table fetches only the newer rows and updates existing ones in place")
+{
+	CTable table(TXT("Versioned"));
+
+	table.AddColumn(TXT("ID"),      MDCT_INT,     0, CColumn::UNIQUE);
+	table.AddColumn(TXT("Name"),    MDCT_VARSTR, 50, CColumn::NULLABLE);
+	table.AddColumn(TXT("Version"), MDCT_INT64,   0, CColumn::ROW_VERSION);
+
+	MockSQLCursor::Columns columns;
+	columns.push_back(MockSQLColumn(0, TXT("ID"),      MDCT_INT,    0, CColumn::DEFAULTS));
+	columns.push_back(MockSQLColumn(1, TXT("Name"),    MDCT_VARSTR, 50, CColumn::NULLABLE));
+	columns.push_back(MockSQLColumn(2, TXT("Version"), MDCT_INT64,  0, CColumn::DEFAULTS));
+
+	MockSQLCursor::Rows rows(2, MockSQLCursor::Row(3, null));
+	rows[0][0] = 1; rows[0][1] = TXT("one"); rows[0][2] = int64(10);
+	rows[1][0] = 2; rows[1][1] = TXT("two"); rows[1][2] = int64(20);
+
+	MockSQLCursorPtr initial(new MockSQLCursor);
+	initial->SetColumns(columns);
+	initial->SetRows(rows);
+
+	MockSQLCursor::Rows changes(2, MockSQLCursor::Row(3, null));
+	changes[0][0] = 2; changes[0][1] = TXT("TWO");   changes[0][2] = int64(30);
+	changes[1][0] = 3; changes[1][1] = TXT("three"); changes[1][2] = int64(30);
+
+	MockSQLCursorPtr refresh(new MockSQLCursor);
+	refresh->SetColumns(columns);
+	refresh->SetRows(changes);
+
+	MockSQLSource mockSource;
+	mockSource.Open(TXT("any SQL connection"));
+	mockSource.QueueCursor(initial);
+	mockSource.QueueCursor(refresh);
+
+	table.Read(mockSource);
+
+	CRow* existing = table.SelectRow(0, 2);
+
+	table.Refresh(mockSource);
+
+	TEST_TRUE(mockSource.Queries().back() == TXT("SELECT ID,Name,Version FROM Versioned WHERE Version > 20"));
+	TEST_TRUE(table.RowCount() == 3);
+	TEST_TRUE(table.SelectRow(0, 2) == existing);
+	TEST_TRUE(existing->Field(1).GetString() == tstring(TXT("TWO")));
+	TEST_TRUE(table.SelectRow(0, 3)->Field(1).GetString() == tstring(TXT("three")));
+	TEST_FALSE(table.Modified());
+}
+TEST_CASE_END
+
+TEST_CASE("The highest row version follows the rows inserted, refreshed and updated")
+{
+	CTable table(TXT("Versioned"));
+
+	table.AddColumn(TXT("ID"),      MDCT_INT, 0, CColumn::UNIQUE);
+	table.AddColumn(TXT("Version"), MDCT_INT, 0, CColumn::ROW_VERSION);
+
+	MockSQLCursor::Columns columns;
+	columns.push_back(MockSQLColumn(0, TXT("ID"),      MDCT_INT, 0, CColumn::DEFAULTS));
+	columns.push_back(MockSQLColumn(1, TXT("Version"), MDCT_INT, 0, CColumn::DEFAULTS));
+
+	MockSQLCursor::Rows changes(1, MockSQLCursor::Row(2, null));
+	changes[0][0] = 1; changes[0][1] = 50;
+
+	MockSQLCursorPtr first(new MockSQLCursor);
+	first->SetColumns(columns);
+	first->SetRows(changes);
+
+	MockSQLCursorPtr second(new MockSQLCursor);
+	second->SetColumns(columns);
+
+	MockSQLCursorPtr third(new MockSQLCursor);
+	third->SetColumns(columns);
+
+	MockSQLSource mockSource;
+	mockSource.Open(TXT("any SQL connection"));
+	mockSource.QueueCursor(first);
+	mockSource.QueueCursor(second);
+	mockSource.QueueCursor(third);
+
+	CRow& row = table.CreateRow();
+	row[0] = 1; row[1] = 10;
+	table.InsertRow(row);
+
+	table.Refresh(mockSource);
+
+	TEST_TRUE(mockSource.Queries().back() == TXT("SELECT ID,Version FROM Versioned WHERE Version > 10"));
+	TEST_TRUE(table[0][1] == 50);
+
+	table.Refresh(mockSource);
+
+	TEST_TRUE(mockSource.Queries().back() == TXT("SELECT ID,Version FROM Versioned WHERE Version > 50"));
+
+	table[0][1] = 20;
+	table.Refresh(mockSource);
+
+	TEST_TRUE(mockSource.Queries().back() == TXT("SELECT ID,Version FROM Versioned WHERE Version > 20"));
+}
+TEST_CASE_END
+
+TEST_CASE("Refreshing a table can remove the rows that were deleted from the source")
+{
+	CTable table(TXT("Versioned"));
+
+	table.AddColumn(TXT("ID"),      MDCT_INT, 0, CColumn::UNIQUE);
+	table.AddColumn(TXT("Version"), MDCT_INT, 0, CColumn::ROW_VERSION);
+
+	MockSQLCursor::Columns columns;
+	columns.push_back(MockSQLColumn(0, TXT("ID"),      MDCT_INT, 0, CColumn::DEFAULTS));
+	columns.push_back(MockSQLColumn(1, TXT("Version"), MDCT_INT, 0, CColumn::DEFAULTS));
+
+	MockSQLCursor::Rows rows(3, MockSQLCursor::Row(2, null));
+	rows[0][0] = 1; rows[0][1] = 1;
+	rows[1][0] = 2; rows[1][1] = 2;
+	rows[2][0] = 3; rows[2][1] = 3;
+
+	MockSQLCursorPtr initial(new MockSQLCursor);
+	initial->SetColumns(columns);
+	initial->SetRows(rows);
+
+	MockSQLCursorPtr refresh(new MockSQLCursor);
+	refresh->SetColumns(columns);
+
+	MockSQLCursor::Columns keyColumns(1, columns[0]);
+	MockSQLCursor::Rows    keys(2, MockSQLCursor::Row(1, null));
+	keys[0][0] = 1;
+	keys[1][0] = 3;
+
+	MockSQLCursorPtr remaining(new MockSQLCursor);
+	remaining->SetColumns(keyColumns);
+	remaining->SetRows(keys);
+
+	MockSQLSource mockSource;
+	mockSource.Open(TXT("any SQL connection"));
+	mockSource.QueueCursor(initial);
+	mockSource.QueueCursor(refresh);
+	mockSource.QueueCursor(remaining);
+
+	table.Read(mockSource);
+	table.Refresh(mockSource, true);
+
+	TEST_TRUE(mockSource.Queries().back() == TXT("SELECT ID FROM Versioned"));
+	TEST_TRUE(table.RowCount() == 2);
+	TEST_TRUE(table.SelectRow(0, 2) == nullptr);
+	TEST_TRUE(table.SelectRow(0, 3) != nullptr);
+}
+TEST_CASE_END
+
+TEST_CASE("Refreshing a table is written to the next delta but not back to the source")
+{
+	CTable table(TXT("Versioned"));
+
+	table.AddColumn(TXT("ID"),      MDCT_INT, 0, CColumn::UNIQUE);
+	table.AddColumn(TXT("Qty"),     MDCT_INT, 0, CColumn::DEFAULTS);
+	table.AddColumn(TXT("Version"), MDCT_INT, 0, CColumn::ROW_VERSION);
+
+	MockSQLCursor::Columns columns;
+	columns.push_back(MockSQLColumn(0, TXT("ID"),      MDCT_INT, 0, CColumn::DEFAULTS));
+	columns.push_back(MockSQLColumn(1, TXT("Qty"),     MDCT_INT, 0, CColumn::DEFAULTS));
+	columns.push_back(MockSQLColumn(2, TXT("Version"), MDCT_INT, 0, CColumn::DEFAULTS));
+
+	MockSQLCursor::Rows rows(3, MockSQLCursor::Row(3, null));
+	rows[0][0] = 1; rows[0][1] = 10; rows[0][2] = 1;
+	rows[1][0] = 2; rows[1][1] = 20; rows[1][2] = 2;
+	rows[2][0] = 3; rows[2][1] = 30; rows[2][2] = 3;
+
+	MockSQLCursor::Rows changed(2, MockSQLCursor::Row(3, null));
+	changed[0][0] = 2; changed[0][1] = 21; changed[0][2] = 4;
+	changed[1][0] = 4; changed[1][1] = 40; changed[1][2] = 5;
+
+	MockSQLCursor::Rows changedAgain(1, MockSQLCursor::Row(3, null));
+	changedAgain[0][0] = 2; changedAgain[0][1] = 22; changedAgain[0][2] = 6;
+
+	MockSQLCursor::Columns keyColumns(1, columns[0]);
+	MockSQLCursor::Rows    keys(2, MockSQLCursor::Row(1, null));
+	keys[0][0] = 2;
+	keys[1][0] = 3;
+
+	MockSQLCursorPtr initial(new MockSQLCursor);
+	initial->SetColumns(columns);
+	initial->SetRows(rows);
+
+	MockSQLCursorPtr refresh(new MockSQLCursor);
+	refresh->SetColumns(columns);
+	refresh->SetRows(changed);
+
+	MockSQLCursorPtr remaining(new MockSQLCursor);
+	remaining->SetColumns(keyColumns);
+	remaining->SetRows(keys);
+
+	MockSQLCursorPtr refreshAgain(new MockSQLCursor);
+	refreshAgain->SetColumns(columns);
+	refreshAgain->SetRows(changedAgain);
+
+	MockSQLSource mockSource;
+	mockSource.Open(TXT("any SQL connection"));
+	mockSource.QueueCursor(initial);
+	mockSource.QueueCursor(refresh);
+	mockSource.QueueCursor(remaining);
+	mockSource.QueueCursor(refreshAgain);
+
+	table.Read(mockSource);
+
+	CBuffer    base, delta;
+	CMemStream baseStream(base), deltaStream(delta);
+
+	baseStream.Create();
+	table.Write(baseStream);
+	baseStream.Close();
+
+	table.Refresh(mockSource, true);
+	table.Refresh(mockSource, false);
+
+	TEST_TRUE(table.RowCount() == 3);
+	TEST_FALSE(table.Modified());
+
+	deltaStream.Create();
+	table.WriteDelta(deltaStream);
+	deltaStream.Close();
+
+	CTable copy(TXT("Versioned"));
+
+	copy.AddColumn(TXT("ID"),      MDCT_INT, 0, CColumn::UNIQUE);
+	copy.AddColumn(TXT("Qty"),     MDCT_INT, 0, CColumn::DEFAULTS);
+	copy.AddColumn(TXT("Version"), MDCT_INT, 0, CColumn::ROW_VERSION);
+
+	baseStream.Open();
+	copy.Read(baseStream);
+	baseStream.Close();
+
+	deltaStream.Open();
+	copy.ReadDelta(deltaStream);
+	deltaStream.Close();
+
+	TEST_TRUE(copy.RowCount() == 3);
+	TEST_TRUE(copy.SelectRow(0, 1) == nullptr);
+	TEST_TRUE(copy.SelectRow(0, 2)->Field(1) == 22);
+	TEST_TRUE(copy.SelectRow(0, 3)->Field(1) == 30);
+	TEST_TRUE(copy.SelectRow(0, 4)->Field(1) == 40);
+}
+TEST_CASE_END
+
 }
 TEST_SET_END
@@ -0,0 +1,225 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   TraceTests.cpp
+//! \brief  The unit tests for the tracing hooks.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/MDB.hpp>
+#include <MDBL/Table.hpp>
+#include <MDBL/ResultSet.hpp>
+#include <MDBL/GroupSet.hpp>
+#include <MDBL/Join.hpp>
+#include <MDBL/JoinedSet.hpp>
+#include <MDBL/WhereCmp.hpp>
+#include <MDBL/Trace.hpp>
+#include <WCL/MemStream.hpp>
+#include <vector>
+#include <algorithm>
+
+namespace
+{
+
+//! A sink which records the operations traced.
+class RecordingSink : public CTraceSink
+{
+public:
+	//! An operation traced.
+	struct Record
+	{
+		Event	m_eEvent;
+		tstring	m_strName;
+		size_t	m_nSize;
+	};
+
+	RecordingSink()
+		: m_nDepth(0), m_nMaxDepth(0), m_vRecords()
+	{
+		CTraceSink::Install(this);
+	}
+
+	virtual ~RecordingSink()
+	{
+		CTraceSink::Install(nullptr);
+	}
+
+	virtual void OnBegin(Event /*eEvent*/, const tchar* /*pszName*/)
+	{
+		m_nMaxDepth = std::max(m_nMaxDepth, ++m_nDepth);
+	}
+
+	virtual void OnEnd(Event eEvent, const tchar* pszName, size_t nSize, uint64 /*nElapsed*/)
+	{
+		Record record = { eEvent, (pszName != nullptr) ? pszName : TXT(""), nSize };
+
+		m_vRecords.push_back(record);
+		--m_nDepth;
+	}
+
+	//! Count the operations of a type.
+	size_t Count(Event eEvent) const
+	{
+		size_t count = 0;
+
+		for (size_t i = 0; i != m_vRecords.size(); ++i)
+			count += (m_vRecords[i].m_eEvent == eEvent) ? 1 : 0;
+
+		return count;
+	}
+
+	//! Find the last operation of a type.
+	const Record* Last(Event eEvent) const
+	{
+		for (size_t i = m_vRecords.size(); i != 0; --i)
+		{
+			if (m_vRecords[i-1].m_eEvent == eEvent)
+				return &m_vRecords[i-1];
+		}
+
+		return nullptr;
+	}
+
+	size_t				m_nDepth;
+	size_t				m_nMaxDepth;
+	std::vector<Record>	m_vRecords;
+};
+
+//! Create a table with an int key and a name.
+static void createTable(CTable& table, int rows)
+{
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,   CColumn::DEFAULTS);
+	table.AddColumn(TXT("Name"), MDCT_VARSTR, 256, CColumn::DEFAULTS);
+
+	for (int id = 0; id != rows; ++id)
+	{
+		CRow& row = table.CreateRow();
+
+		row[0] = id;
+		row[1] = (id % 2) ? TXT("Odd") : TXT("Even");
+
+		table.InsertRow(row);
+	}
+}
+
+}
+
+TEST_SET(Trace)
+{
+
+TEST_CASE("no sink is installed by default")
+{
+	TEST_TRUE(CTraceSink::Installed() == nullptr);
+}
+TEST_CASE_END
+
+TEST_CASE("row insertions and deletions are traced with the table name")
+{
+	RecordingSink sink;
+
+	CTable table(TXT("Test"));
+	createTable(table, 3);
+
+	table.DeleteRow(0);
+
+	TEST_TRUE(sink.Count(CTraceSink::INSERT_ROW) == 3);
+	TEST_TRUE(sink.Count(CTraceSink::DELETE_ROW) == 1);
+	TEST_TRUE(sink.Last(CTraceSink::INSERT_ROW)->m_strName == TXT("Test"));
+	TEST_TRUE(sink.Last(CTraceSink::DELETE_ROW)->m_nSize == 1);
+	TEST_TRUE(sink.m_nDepth == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("queries are traced with the number of rows they return")
+{
+	RecordingSink sink;
+
+	CTable table(TXT("Test"));
+	createTable(table, 10);
+
+	CResultSet results = table.Select(CWhereCmp(1, CWhereCmp::EQUALS, TXT("Odd")));
+
+	TEST_TRUE(sink.Count(CTraceSink::SELECT) == 1);
+	TEST_TRUE(sink.Last(CTraceSink::SELECT)->m_nSize == 5);
+
+	results.OrderBy(0, CSortColumns::DESC);
+
+	TEST_TRUE(sink.Last(CTraceSink::ORDER_BY)->m_nSize == 5);
+	TEST_TRUE(sink.Last(CTraceSink::ORDER_BY)->m_strName == TXT("Test"));
+
+	CGroupSet groups = table.SelectAll().GroupBy(1);
+
+	TEST_TRUE(sink.Last(CTraceSink::GROUP_BY)->m_nSize == 2);
+	TEST_TRUE(sink.m_nMaxDepth == 2);
+}
+TEST_CASE_END
+
+TEST_CASE("joins are traced with the number of rows joined")
+{
+	RecordingSink sink;
+
+	CTable first(TXT("First"));
+	createTable(first, 3);
+
+	CTable second(TXT("Second"));
+	createTable(second, 4);
+
+	CMDB mdb;
+	mdb.AddTable(first);
+	mdb.AddTable(second);
+
+	CJoin join(0);
+	join.Add(1, 0, INNER_JOIN, 0);
+
+	CJoinedSet results = mdb.Select(join);
+
+	TEST_TRUE(sink.Count(CTraceSink::JOIN) == 1);
+	TEST_TRUE(sink.Last(CTraceSink::JOIN)->m_strName == TXT("First"));
+	TEST_TRUE(sink.Last(CTraceSink::JOIN)->m_nSize == 3);
+}
+TEST_CASE_END
+
+TEST_CASE("writing and reading a table is traced with the number of rows")
+{
+	CBuffer buffer;
+
+	CTable table(TXT("Test"));
+	createTable(table, 4);
+
+	RecordingSink sink;
+
+	{
+		CMemStream stream(buffer);
+		stream.Create();
+		table.Write(stream);
+		stream.Close();
+	}
+
+	{
+		CMemStream stream(buffer);
+		stream.Open();
+		table.Read(stream);
+		stream.Close();
+	}
+
+	TEST_TRUE(sink.Last(CTraceSink::TABLE_WRITE)->m_nSize == 4);
+	TEST_TRUE(sink.Last(CTraceSink::TABLE_READ)->m_nSize == 4);
+	TEST_TRUE(sink.m_nDepth == 0);
+}
+TEST_CASE_END
+
+TEST_CASE("nothing is traced once the sink is removed")
+{
+	RecordingSink sink;
+
+	CTraceSink::Install(nullptr);
+
+	CTable table(TXT("Test"));
+	createTable(table, 1);
+
+	TEST_TRUE(CTraceSink::Installed() == nullptr);
+	TEST_TRUE(sink.m_vRecords.empty());
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,142 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   WhereInTests.cpp
+//! \brief  The unit tests for the WhereIn class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/WhereIn.hpp>
+#include <MDBL/ResultSet.hpp>
+#include <MDBL/Table.hpp>
+
+TEST_SET(WhereIn)
+{
+
+TEST_CASE("an integer IN clause matches only the rows whose value is in the set")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("Value"), MDCT_INT, 0, CColumn::NULLABLE);
+
+	for (int i = 0; i != 100; ++i)
+	{
+		CRow& row = table.CreateRow(true);
+
+		if (i != 0)
+			row[0] = i;
+
+		table.InsertRow(row);
+	}
+
+	CValueSet values;
+	values.Add(CValue(75));
+	values.Add(CValue(3));
+	values.Add(CValue(3));
+	values.Add(CValue(500));
+
+	CResultSet rows = table.Select(CWhereIn(0, values));
+
+	TEST_TRUE(rows.Count() == 2);
+	TEST_TRUE(rows[0][0] == 3);
+	TEST_TRUE(rows[1][0] == 75);
+
+	values.Add(CValue(null));
+
+	TEST_TRUE(table.Select(CWhereIn(0, values)).Count() == 3);
+}
+TEST_CASE_END
+
+TEST_CASE("a string IN clause honours the case sensitivity of the column")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("Exact"),  MDCT_VARSTR, 10, CColumn::COMPARE_CASE);
+	table.AddColumn(TXT("Ignore"), MDCT_VARSTR, 10, CColumn::IGNORE_CASE);
+
+	{ CRow& row = table.CreateRow(); row[0] = TXT("abc"); row[1] = TXT("abc"); table.InsertRow(row); }
+	{ CRow& row = table.CreateRow(); row[0] = TXT("XYZ"); row[1] = TXT("XYZ"); table.InsertRow(row); }
+
+	CValueSet values;
+	values.Add(CValue(TXT("ABC")));
+	values.Add(CValue(TXT("XYZ")));
+
+	TEST_TRUE(table.Select(CWhereIn(0, values)).Count() == 1);
+	TEST_TRUE(table.Select(CWhereIn(1, values)).Count() == 2);
+}
+TEST_CASE_END
+
+TEST_CASE("an IN clause on a unique indexed column finds the rows via the index")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("ID"), MDCT_INT, 0, CColumn::UNIQUE);
+
+	for (int i = 0; i != 10; ++i)
+	{
+		CRow& row = table.CreateRow();
+		row[0] = i;
+		table.InsertRow(row);
+	}
+
+	CValueSet values;
+	values.Add(CValue(7));
+	values.Add(CValue(42));
+	values.Add(CValue(2));
+
+	CWhereIn where(0, values);
+	CResultSet indexed(table);
+
+	TEST_TRUE(where.SelectIndexed(table, indexed));
+	TEST_TRUE(indexed.Count() == 2);
+
+	CResultSet rows = table.Select(where);
+
+	TEST_TRUE(rows.Count() == 2);
+	TEST_TRUE(&rows[0] == &table[2]);
+	TEST_TRUE(&rows[1] == &table[7]);
+}
+TEST_CASE_END
+
+TEST_CASE("an IN clause returns the rows in table order whether or not it uses an index")
+{
+	CTable table(TXT("Test"));
+	table.AddColumn(TXT("ID"),   MDCT_INT,    0,  CColumn::UNIQUE);
+	table.AddColumn(TXT("Code"), MDCT_VARSTR, 10, CColumn::UNIQUE | CColumn::COMPARE_CASE);
+	table.AddColumn(TXT("Copy"), MDCT_INT,    0,  CColumn::DEFAULTS);
+
+	for (int i = 9; i >= 0; --i)
+	{
+		CRow& row = table.CreateRow();
+		row[0] = i;
+		row[1] = Core::fmt(TXT("C%d"), i).c_str();
+		row[2] = i;
+		table.InsertRow(row);
+	}
+
+	CValueSet ints;
+	ints.Add(CValue(2));
+	ints.Add(CValue(7));
+	ints.Add(CValue(5));
+
+	CValueSet strings;
+	strings.Add(CValue(TXT("C2")));
+	strings.Add(CValue(TXT("C7")));
+	strings.Add(CValue(TXT("C5")));
+
+	CResultSet indexed = table.Select(CWhereIn(0, ints));
+	CResultSet byCode  = table.Select(CWhereIn(1, strings));
+	CResultSet scanned = table.Select(CWhereIn(2, ints));
+
+	TEST_TRUE(indexed.Count() == 3);
+	TEST_TRUE(&indexed[0] == &table[2]);
+	TEST_TRUE(&indexed[1] == &table[4]);
+	TEST_TRUE(&indexed[2] == &table[7]);
+
+	bool same = (byCode.Count() == 3) && (scanned.Count() == 3);
+
+	for (size_t i = 0; same && (i != 3); ++i)
+		same = (&byCode[i] == &indexed[i]) && (&scanned[i] == &indexed[i]);
+
+	TEST_TRUE(same);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
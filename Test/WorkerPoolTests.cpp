@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   WorkerPoolTests.cpp
+//! \brief  The unit tests for the WorkerPool class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include <Core/UnitTest.hpp>
+#include <MDBL/WorkerPool.hpp>
+#include <MDBL/MDBException.hpp>
+#include <MDBL/SQLException.hpp>
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! A task that counts its runs and optionally throws.
+
+class TestTask : public CWorkerTask
+{
+public:
+	TestTask()
+		: m_nRuns(0), m_nThrow(0)
+	{ }
+
+	virtual void Run()
+	{
+		::InterlockedIncrement(&m_nRuns);
+
+		if (m_nThrow == 1)
+			throw CMDBException(CMDBException::E_BAD_LOAD, TXT("Task failed"));
+
+		if (m_nThrow == 2)
+			throw CSQLException(CSQLException::E_EXEC_FAILED, TXT("SELECT"), TXT("Task failed"));
+
+		if (m_nThrow == 3)
+			throw 42;
+	}
+
+	volatile LONG	m_nRuns;
+	int				m_nThrow;
+};
+
+static int execute(CWorkerPool& pool, std::vector<TestTask>& tasks)
+{
+	std::vector<CWorkerTask*> ptrs;
+
+	for (size_t i = 0; i != tasks.size(); ++i)
+		ptrs.push_back(&tasks[i]);
+
+	try
+	{
+		pool.Execute(&ptrs[0], ptrs.size());
+	}
+	catch (const CMDBException& e)
+	{
+		return e.m_eError;
+	}
+	catch (const CSQLException& e)
+	{
+		return 100 + e.m_eError;
+	}
+
+	return -1;
+}
+
+}
+
+TEST_SET(WorkerPool)
+{
+
+TEST_CASE("all tasks in a batch are run")
+{
+	CWorkerPool pool(2);
+
+	std::vector<TestTask> tasks(50);
+
+	TEST_TRUE(execute(pool, tasks) == -1);
+
+	bool all = true;
+
+	for (size_t i = 0; i != tasks.size(); ++i)
+		all = all && (tasks[i].m_nRuns == 1);
+
+	TEST_TRUE(all);
+}
+TEST_CASE_END
+
+TEST_CASE("the exception thrown by a failing task is rethrown on the calling thread")
+{
+	CWorkerPool pool(2);
+
+	std::vector<TestTask> tasks(10);
+
+	tasks[5].m_nThrow = 1;
+
+	TEST_TRUE(execute(pool, tasks) == CMDBException::E_BAD_LOAD);
+	TEST_TRUE(tasks[9].m_nRuns == 1);
+
+	tasks[5].m_nThrow = 2;
+
+	TEST_TRUE(execute(pool, tasks) == 100 + CSQLException::E_EXEC_FAILED);
+
+	tasks[5].m_nThrow = 3;
+
+	TEST_TRUE(execute(pool, tasks) == CMDBException::E_TASK_FAILED);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
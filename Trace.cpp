@@ -0,0 +1,48 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Trace.cpp
+//! \brief  The CTraceSink and CTraceScope class definitions.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Trace.hpp"
+#include "PerfCounter.hpp"
+
+//! The installed sink, if any.
+CTraceSink* CTraceSink::s_pSink = nullptr;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+CTraceSink::~CTraceSink()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Install the sink, or remove it with nullptr. This is not synchronised with
+//! the operations being traced, so it should be done whilst none are running.
+
+void CTraceSink::Install(CTraceSink* pSink)
+{
+	s_pSink = pSink;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Call the sink at the start of the operation. The clock is read afterwards
+//! so that the time spent in the sink is not included.
+
+void CTraceScope::Begin()
+{
+	m_pSink->OnBegin(m_eEvent, m_pszName);
+
+	m_nStart = CPerfCounter::Now();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Call the sink at the end of the operation.
+
+void CTraceScope::End()
+{
+	uint64 nElapsed = CPerfCounter::Microseconds(CPerfCounter::Now() - m_nStart);
+
+	m_pSink->OnEnd(m_eEvent, m_pszName, m_nSize, nElapsed);
+}
@@ -0,0 +1,152 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Trace.hpp
+//! \brief  The CTraceSink and CTraceScope class declarations.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_TRACE_HPP
+#define MDBL_TRACE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! The interface used to observe the main table, query and ODBC operations,
+//! e.g. to feed latency histograms or tracing spans. The sink is called at the
+//! start and end of each operation on the thread that runs it, and operations
+//! may be nested, e.g. a table read inserts each row it fetches.
+//!
+//! The sink is installed once for the whole process, before the tables are
+//! used, and must not throw. When no sink is installed the cost of each hook
+//! is a single test, and defining MDBL_NO_TRACING removes the hooks entirely.
+
+class CTraceSink
+{
+public:
+	//! The operations traced.
+	enum Event
+	{
+		TABLE_READ,		//!< CTable::Read(), size is the rows read.
+		TABLE_WRITE,	//!< CTable::Write(), size is the rows or changes written.
+		INSERT_ROW,		//!< CTable::InsertRow(), size is 1.
+		DELETE_ROW,		//!< CTable::DeleteRow(), size is 1.
+		SELECT,			//!< CTable::Select(), size is the rows matched.
+		ORDER_BY,		//!< CResultSet::OrderBy(), size is the rows sorted.
+		GROUP_BY,		//!< CResultSet::GroupBy(), size is the groups.
+		JOIN,			//!< CMDB::Select(), size is the rows joined.
+		SQL_QUERY,		//!< CSQLSource::ExecQuery(), size is 0.
+		SQL_STMT,		//!< CSQLSource::ExecStmt(), size is 0.
+		SQL_FETCH,		//!< CODBCCursor::Fetch() of a batch, size is the rows fetched.
+	};
+
+	//! Called at the start of an operation.
+	virtual void OnBegin(Event eEvent, const tchar* pszName) = 0;
+
+	//! Called at the end of an operation, including one that throws.
+	virtual void OnEnd(Event eEvent, const tchar* pszName, size_t nSize, uint64 nElapsed) = 0;
+
+	//! Get the installed sink, if any.
+	static CTraceSink* Installed();
+
+	//! Install the sink, or remove it with nullptr.
+	static void Install(CTraceSink* pSink);
+
+protected:
+	//! Destructor.
+	virtual ~CTraceSink();
+
+private:
+	//
+	// Class members.
+	//
+	static CTraceSink* s_pSink;		//!< The installed sink, if any.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The helper used to call the installed sink at the start and end of an
+//! operation. The name is the table name or SQL statement and must outlive the
+//! scope. The elapsed time is in microseconds.
+
+class CTraceScope /*: private NotCopyable*/
+{
+public:
+	//! Constructor.
+	CTraceScope(CTraceSink::Event eEvent, const tchar* pszName, size_t nSize = 0);
+
+	//! Destructor.
+	~CTraceScope();
+
+	//! Set the size of the operation, once known.
+	void Size(size_t nSize);
+
+private:
+	//
+	// Members.
+	//
+	CTraceSink*			m_pSink;		//!< The sink, if installed.
+	CTraceSink::Event	m_eEvent;		//!< The operation.
+	const tchar*		m_pszName;		//!< The table name or statement.
+	size_t				m_nSize;		//!< The size of the operation.
+	int64				m_nStart;		//!< The performance counter at the start.
+
+	//
+	// Internal methods.
+	//
+
+	//! Call the sink at the start of the operation.
+	void Begin();
+
+	//! Call the sink at the end of the operation.
+	void End();
+
+	// NotCopyable.
+	CTraceScope(const CTraceScope&);
+	CTraceScope& operator=(const CTraceScope&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the installed sink, if any.
+
+inline CTraceSink* CTraceSink::Installed()
+{
+#ifdef MDBL_NO_TRACING
+	return nullptr;
+#else
+	return s_pSink;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor. The sink is only called, and the clock read, if one is
+//! installed.
+
+inline CTraceScope::CTraceScope(CTraceSink::Event eEvent, const tchar* pszName, size_t nSize)
+	: m_pSink(CTraceSink::Installed())
+	, m_eEvent(eEvent)
+	, m_pszName(pszName)
+	, m_nSize(nSize)
+	, m_nStart(0)
+{
+	if (m_pSink != nullptr)
+		Begin();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+inline CTraceScope::~CTraceScope()
+{
+	if (m_pSink != nullptr)
+		End();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the size of the operation, once known.
+
+inline void CTraceScope::Size(size_t nSize)
+{
+	m_nSize = nSize;
+}
+
+#endif // MDBL_TRACE_HPP
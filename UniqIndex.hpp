@@ -32,6 +32,8 @@ public:
 	//
 	virtual CRow* FindRow(const CValue& oValue) const = 0;
 
+	virtual bool Concurrent() const;
+
 protected:
 	//
 	// Constructors/Destructor.
@@ -56,4 +58,9 @@ inline CUniqIndex::~CUniqIndex()
 {
 }
 
+inline bool CUniqIndex::Concurrent() const
+{
+	return false;
+}
+
 #endif //UNIQINDEX_HPP
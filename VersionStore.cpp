@@ -0,0 +1,410 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   VersionStore.cpp
+//! \brief  The CVersionStore class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "VersionStore.hpp"
+#include "Table.hpp"
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+CVersionStore::CVersionStore()
+	: m_vTables()
+	, m_nWrite(0)
+	, m_nVisible(0)
+	, m_nUpdates(0)
+	, m_sViews()
+	, m_mRows()
+	, m_mDeleted()
+	, m_nVersions(0)
+{
+	::InitializeCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. Any tables still attached are detached.
+
+CVersionStore::~CVersionStore()
+{
+	ASSERT(m_sViews.empty());
+
+	for (size_t i = 0; i != m_vTables.size(); ++i)
+		m_vTables[i]->m_pVersions = nullptr;
+
+	for (RowVersions::iterator it = m_mRows.begin(); it != m_mRows.end(); ++it)
+		delete it->second.m_pRow;
+
+	for (DeletedRows::iterator it = m_mDeleted.begin(); it != m_mDeleted.end(); ++it)
+	{
+		for (size_t i = 0; i != it->second.size(); ++i)
+			delete it->second[i].m_pRow;
+	}
+
+	::DeleteCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Attach a table so that its changes are versioned.
+
+void CVersionStore::Attach(CTable& oTable)
+{
+	ASSERT(oTable.m_pVersions == nullptr);
+
+	::EnterCriticalSection(&m_oLock);
+
+	m_vTables.push_back(&oTable);
+	oTable.m_pVersions = this;
+
+	::LeaveCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Detach a table and discard its old versions. This is called when the table
+//! is destroyed, as the copies of its rows refer to it.
+
+void CVersionStore::Detach(CTable& oTable)
+{
+	ASSERT(oTable.m_pVersions == this);
+
+	::EnterCriticalSection(&m_oLock);
+
+	for (RowVersions::iterator it = m_mRows.begin(); it != m_mRows.end(); )
+	{
+		if (&it->second.m_pRow->Table() == &oTable)
+		{
+			delete it->second.m_pRow;
+			m_mRows.erase(it++);
+			--m_nVersions;
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	DeletedRows::iterator itDeleted = m_mDeleted.find(&oTable);
+
+	if (itDeleted != m_mDeleted.end())
+	{
+		for (size_t i = 0; i != itDeleted->second.size(); ++i)
+			delete itDeleted->second[i].m_pRow;
+
+		m_nVersions -= itDeleted->second.size();
+		m_mDeleted.erase(itDeleted);
+	}
+
+	m_vTables.erase(std::remove(m_vTables.begin(), m_vTables.end(), &oTable), m_vTables.end());
+	oTable.m_pVersions = nullptr;
+
+	::LeaveCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start a group of writes that share a version. Views opened before the
+//! matching EndUpdate() see none of the writes. Groups can be nested.
+
+void CVersionStore::BeginUpdate()
+{
+	::EnterCriticalSection(&m_oLock);
+
+	if (m_nUpdates++ == 0)
+		++m_nWrite;
+
+	::LeaveCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! End a group of writes and make them visible to new views. The versions kept
+//! only for the views that might have been opened during it are reclaimed.
+
+void CVersionStore::EndUpdate()
+{
+	::EnterCriticalSection(&m_oLock);
+
+	ASSERT(m_nUpdates != 0);
+
+	if (--m_nUpdates == 0)
+	{
+		m_nVisible = m_nWrite;
+
+		Reclaim();
+	}
+
+	::LeaveCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Stamp a row that is being inserted with the next version.
+
+void CVersionStore::Inserting(CRow& oRow)
+{
+	::EnterCriticalSection(&m_oLock);
+
+	oRow.Version(NextVersion());
+
+	::LeaveCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Keep the current version of a row that is about to be updated, if a view
+//! may need it, and then stamp it with the next version.
+
+void CVersionStore::Updating(CRow& oRow)
+{
+	::EnterCriticalSection(&m_oLock);
+
+	uint64 nVersion = NextVersion();
+
+	try
+	{
+		if (IsVisible(oRow.Version(), nVersion))
+		{
+			Version oVersion = { oRow.Clone(), oRow.Version(), nVersion };
+
+			m_mRows.insert(std::make_pair(&oRow, oVersion));
+			++m_nVersions;
+		}
+	}
+	catch (...)
+	{
+		::LeaveCriticalSection(&m_oLock);
+		throw;
+	}
+
+	oRow.Version(nVersion);
+
+	::LeaveCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Keep the current version of a row that is about to be deleted, if a view
+//! may need it. Any older versions move with it to the tables deleted rows as
+//! the row itself is about to be freed.
+
+void CVersionStore::Deleting(CRow& oRow)
+{
+	::EnterCriticalSection(&m_oLock);
+
+	uint64 nVersion = NextVersion();
+
+	try
+	{
+		std::pair<RowVersions::iterator, RowVersions::iterator> itRange = m_mRows.equal_range(&oRow);
+		std::vector<Version>& vDeleted = m_mDeleted[&oRow.Table()];
+
+		for (RowVersions::iterator it = itRange.first; it != itRange.second; ++it)
+			vDeleted.push_back(it->second);
+
+		m_mRows.erase(itRange.first, itRange.second);
+
+		if (IsVisible(oRow.Version(), nVersion))
+		{
+			Version oVersion = { oRow.Clone(), oRow.Version(), nVersion };
+
+			vDeleted.push_back(oVersion);
+			++m_nVersions;
+		}
+	}
+	catch (...)
+	{
+		::LeaveCriticalSection(&m_oLock);
+		throw;
+	}
+
+	::LeaveCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Open a view at the latest visible version.
+
+uint64 CVersionStore::OpenView()
+{
+	::EnterCriticalSection(&m_oLock);
+
+	uint64 nVersion = m_nVisible;
+
+	m_sViews.insert(nVersion);
+
+	::LeaveCriticalSection(&m_oLock);
+
+	return nVersion;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Close a view and reclaim the versions no longer needed by the others.
+
+void CVersionStore::CloseView(uint64 nVersion)
+{
+	::EnterCriticalSection(&m_oLock);
+
+	Views::iterator it = m_sViews.find(nVersion);
+
+	ASSERT(it != m_sViews.end());
+
+	m_sViews.erase(it);
+
+	Reclaim();
+
+	::LeaveCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the old version of a current row visible to a view. The row must be
+//! newer than the view.
+
+const CRow* CVersionStore::FindRow(const CRow& oRow, uint64 nVersion) const
+{
+	ASSERT(oRow.Version() > nVersion);
+
+	const CRow* pRow = nullptr;
+
+	::EnterCriticalSection(&m_oLock);
+
+	std::pair<RowVersions::const_iterator, RowVersions::const_iterator> itRange = m_mRows.equal_range(&oRow);
+
+	for (RowVersions::const_iterator it = itRange.first; it != itRange.second; ++it)
+	{
+		if ( (it->second.m_nFrom <= nVersion) && (nVersion < it->second.m_nUntil) )
+		{
+			pRow = it->second.m_pRow;
+			break;
+		}
+	}
+
+	::LeaveCriticalSection(&m_oLock);
+
+	return pRow;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the deleted rows of a table visible to a view.
+
+void CVersionStore::FindDeleted(const CTable& oTable, uint64 nVersion, std::vector<CRow*>& vRows) const
+{
+	::EnterCriticalSection(&m_oLock);
+
+	DeletedRows::const_iterator itDeleted = m_mDeleted.find(&oTable);
+
+	if (itDeleted != m_mDeleted.end())
+	{
+		const std::vector<Version>& vDeleted = itDeleted->second;
+
+		for (size_t i = 0; i != vDeleted.size(); ++i)
+		{
+			if ( (vDeleted[i].m_nFrom <= nVersion) && (nVersion < vDeleted[i].m_nUntil) )
+				vRows.push_back(vDeleted[i].m_pRow);
+		}
+	}
+
+	::LeaveCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the old versions of the current rows of a table that have been updated
+//! since a view was opened and are visible to it.
+
+void CVersionStore::FindUpdated(const CTable& oTable, uint64 nVersion, std::vector<CRow*>& vRows) const
+{
+	::EnterCriticalSection(&m_oLock);
+
+	for (RowVersions::const_iterator it = m_mRows.begin(); it != m_mRows.end(); ++it)
+	{
+		if ( (&it->first->Table() == &oTable) && (it->second.m_nFrom <= nVersion) && (nVersion < it->second.m_nUntil) )
+			vRows.push_back(it->second.m_pRow);
+	}
+
+	::LeaveCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of old row versions held.
+
+size_t CVersionStore::VersionCount() const
+{
+	::EnterCriticalSection(&m_oLock);
+
+	size_t nVersions = m_nVersions;
+
+	::LeaveCriticalSection(&m_oLock);
+
+	return nVersions;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the version for the next write. Inside an update this is the version
+//! reserved by BeginUpdate(), otherwise a new one which is visible at once as
+//! the table is locked until the write is complete. The lock must be held.
+
+uint64 CVersionStore::NextVersion()
+{
+	if (m_nUpdates != 0)
+		return m_nWrite;
+
+	m_nVisible = ++m_nWrite;
+
+	return m_nWrite;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if any view lies within the range of versions a row version was
+//! current for. Whilst an update is in progress new views are still opened at
+//! the version before it, so that counts too. The lock must be held.
+
+bool CVersionStore::IsVisible(uint64 nFrom, uint64 nUntil) const
+{
+	if ( (m_nUpdates != 0) && (nFrom <= m_nVisible) && (m_nVisible < nUntil) )
+		return true;
+
+	Views::const_iterator it = m_sViews.lower_bound(nFrom);
+
+	return (it != m_sViews.end()) && (*it < nUntil);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Reclaim the versions which no open view can see. The lock must be held.
+
+void CVersionStore::Reclaim()
+{
+	for (RowVersions::iterator it = m_mRows.begin(); it != m_mRows.end(); )
+	{
+		if (!IsVisible(it->second.m_nFrom, it->second.m_nUntil))
+		{
+			delete it->second.m_pRow;
+			m_mRows.erase(it++);
+			--m_nVersions;
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	for (DeletedRows::iterator it = m_mDeleted.begin(); it != m_mDeleted.end(); )
+	{
+		std::vector<Version>& vDeleted = it->second;
+		size_t                nKept    = 0;
+
+		for (size_t i = 0; i != vDeleted.size(); ++i)
+		{
+			if (IsVisible(vDeleted[i].m_nFrom, vDeleted[i].m_nUntil))
+			{
+				vDeleted[nKept++] = vDeleted[i];
+			}
+			else
+			{
+				delete vDeleted[i].m_pRow;
+				--m_nVersions;
+			}
+		}
+
+		vDeleted.resize(nKept);
+
+		if (vDeleted.empty())
+			m_mDeleted.erase(it++);
+		else
+			++it;
+	}
+}
@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   VersionStore.hpp
+//! \brief  The CVersionStore class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_VERSIONSTORE_HPP
+#define MDBL_VERSIONSTORE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "FwdDecls.hpp"
+#include <vector>
+#include <map>
+#include <set>
+
+////////////////////////////////////////////////////////////////////////////////
+//! The multi-version store for the tables of a database, see CReadView. Every
+//! insertion, update and deletion is given the next version number, which is
+//! stamped on the row. A read view sees the database as of the latest version
+//! when it was opened.
+//!
+//! The current row values are the newest version and the older ones are only
+//! kept whilst a view might need them. When a row is about to be modified or
+//! deleted and a view open at or after its version exists, a copy of the row
+//! is kept along with the range of versions it was current for. Once no view
+//! falls within that range the copy is reclaimed.
+//!
+//! Writes can be grouped with BeginUpdate() and EndUpdate() so that they share
+//! a single version which is only visible to views opened after the update.
+
+class CVersionStore /*: private NotCopyable*/
+{
+public:
+	//! Default constructor.
+	CVersionStore();
+
+	//! Destructor.
+	~CVersionStore();
+
+	//
+	// Table methods.
+	//
+
+	//! Attach a table so that its changes are versioned.
+	void Attach(CTable& oTable);
+
+	//! Detach a table and discard its old versions.
+	void Detach(CTable& oTable);
+
+	//
+	// Write methods.
+	//
+
+	//! Start a group of writes that share a version.
+	void BeginUpdate();
+
+	//! End a group of writes and make them visible.
+	void EndUpdate();
+
+	//! Stamp a row that is being inserted.
+	void Inserting(CRow& oRow);
+
+	//! Keep the current version of a row that is about to be updated.
+	void Updating(CRow& oRow);
+
+	//! Keep the current version of a row that is about to be deleted.
+	void Deleting(CRow& oRow);
+
+	//
+	// View methods.
+	//
+
+	//! Open a view at the latest visible version.
+	uint64 OpenView();
+
+	//! Close a view and reclaim the versions no longer needed.
+	void CloseView(uint64 nVersion);
+
+	//! Find the version of a row visible to a view.
+	const CRow* FindRow(const CRow& oRow, uint64 nVersion) const;
+
+	//! Find the deleted rows of a table visible to a view.
+	void FindDeleted(const CTable& oTable, uint64 nVersion, std::vector<CRow*>& vRows) const;
+
+	//! Find the old versions of the updated rows of a table visible to a view.
+	void FindUpdated(const CTable& oTable, uint64 nVersion, std::vector<CRow*>& vRows) const;
+
+	//
+	// Properties.
+	//
+
+	//! Get the number of old row versions held.
+	size_t VersionCount() const;
+
+	//
+	// Guards.
+	//
+	class UpdateGuard;
+
+private:
+	//! An old version of a row.
+	struct Version
+	{
+		CRow*		m_pRow;			//!< The copy of the row.
+		uint64		m_nFrom;		//!< The version it was written at.
+		uint64		m_nUntil;		//!< The version it was replaced at.
+	};
+
+	//! The old versions of the current rows.
+	typedef std::multimap<const CRow*, Version> RowVersions;
+
+	//! The old versions of the deleted rows of each table.
+	typedef std::map<const CTable*, std::vector<Version> > DeletedRows;
+
+	//! The versions of the open views.
+	typedef std::multiset<uint64> Views;
+
+	//
+	// Members.
+	//
+	mutable CRITICAL_SECTION m_oLock;	//!< The lock for the members below.
+	std::vector<CTable*> m_vTables;		//!< The attached tables.
+	uint64			m_nWrite;		//!< The version of the last write.
+	uint64			m_nVisible;		//!< The version new views are opened at.
+	size_t			m_nUpdates;		//!< The BeginUpdate() nesting depth.
+	Views			m_sViews;		//!< The open views.
+	RowVersions		m_mRows;		//!< The old versions of the current rows.
+	DeletedRows		m_mDeleted;		//!< The old versions of the deleted rows.
+	size_t			m_nVersions;	//!< The number of old versions.
+
+	//
+	// Internal methods.
+	//
+
+	//! Get the version for the next write.
+	uint64 NextVersion();
+
+	//! Query if any view may still see the row version.
+	bool IsVisible(uint64 nFrom, uint64 nUntil) const;
+
+	//! Reclaim the versions which no view can see.
+	void Reclaim();
+
+	// NotCopyable.
+	CVersionStore(const CVersionStore&);
+	CVersionStore& operator=(const CVersionStore&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Groups the writes made during the lifetime of the guard into a single
+//! update, if there is a store.
+
+class CVersionStore::UpdateGuard /*: private NotCopyable*/
+{
+public:
+	//! Constructor.
+	UpdateGuard(CVersionStore* pStore);
+
+	//! Destructor.
+	~UpdateGuard();
+
+private:
+	CVersionStore*	m_pStore;		//!< The store, if one.
+
+	// NotCopyable.
+	UpdateGuard(const UpdateGuard&);
+	UpdateGuard& operator=(const UpdateGuard&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+inline CVersionStore::UpdateGuard::UpdateGuard(CVersionStore* pStore)
+	: m_pStore(pStore)
+{
+	if (m_pStore != nullptr)
+		m_pStore->BeginUpdate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+inline CVersionStore::UpdateGuard::~UpdateGuard()
+{
+	if (m_pStore != nullptr)
+		m_pStore->EndUpdate();
+}
+
+#endif // MDBL_VERSIONSTORE_HPP
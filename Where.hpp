@@ -37,6 +37,16 @@ public:
 
 	virtual CWhere* Clone() const = 0;
 
+	virtual bool SelectIndexed(const CTable& oTable, CResultSet& oRS) const;
+
+	virtual bool MayMatch(size_t nColumn, const CPartitionKeys& oKeys) const;
+
+	virtual bool Evaluate(const CRow& oRow, size_t& nComparisons) const;
+
+	virtual size_t IndexProbes(const CTable& oTable) const;
+
+	virtual CString Describe(const CTable& oTable) const;
+
 protected:
 	//
 	// Make abstract.
@@ -61,4 +71,31 @@ inline CWhere::~CWhere()
 {
 }
 
+inline bool CWhere::SelectIndexed(const CTable& /*oTable*/, CResultSet& /*oRS*/) const
+{
+	return false;
+}
+
+inline bool CWhere::MayMatch(size_t /*nColumn*/, const CPartitionKeys& /*oKeys*/) const
+{
+	return true;
+}
+
+inline bool CWhere::Evaluate(const CRow& oRow, size_t& nComparisons) const
+{
+	++nComparisons;
+
+	return Matches(oRow);
+}
+
+inline size_t CWhere::IndexProbes(const CTable& /*oTable*/) const
+{
+	return 0;
+}
+
+inline CString CWhere::Describe(const CTable& /*oTable*/) const
+{
+	return TXT("<custom>");
+}
+
 #endif //WHERE_HPP
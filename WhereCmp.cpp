@@ -10,6 +10,41 @@
 #include "Common.hpp"
 #include "WhereCmp.hpp"
 #include "Row.hpp"
+#include "PartitionKeys.hpp"
+#include "Table.hpp"
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! Format a value as it would be written in a query.
+
+CString formatValue(const CValue& oValue)
+{
+	if (oValue.m_bNull)
+		return TXT("NULL");
+
+	CString str;
+
+	switch (oValue.m_eType)
+	{
+		case MDST_INT:		str.Format(TXT("%d"),    oValue.m_iValue);						break;
+		case MDST_INT64:	str.Format(TXT("%I64d"), oValue.m_i64Value);					break;
+		case MDST_DOUBLE:	str.Format(TXT("%g"),    oValue.m_dValue);						break;
+		case MDST_CHAR:		str.Format(TXT("'%c'"),  oValue.m_cValue);						break;
+		case MDST_STRING:	str.Format(TXT("'%s'"),  oValue.m_sValue);						break;
+		case MDST_BOOL:		str = (oValue.m_bValue) ? TXT("true") : TXT("false");			break;
+		case MDST_POINTER:	str.Format(TXT("%p"),    oValue.m_pValue);						break;
+
+		case MDST_NULL:
+		case MDST_TIMESTAMP:
+		default:			str = TXT("?");													break;
+	}
+
+	return str;
+}
+
+}
 
 /******************************************************************************
 ** Method:		Constructor.
@@ -125,3 +160,69 @@ CWhere* CWhereCmp::Clone() const
 {
 	return new CWhereCmp(*this);
 }
+
+/******************************************************************************
+** Method:		MayMatch()
+**
+** Description:	Queries if any row of a partition may match, see
+**				CPartitionedTable::Select(). Only a comparison on the key
+**				column can rule a partition out.
+**
+** Parameters:	nColumn	The partition key column.
+**				oKeys	The key values the partition can hold.
+**
+** Returns:		false if no row in the partition can match, otherwise true.
+**
+*******************************************************************************
+*/
+
+bool CWhereCmp::MayMatch(size_t nColumn, const CPartitionKeys& oKeys) const
+{
+	if (nColumn != m_nColumn)
+		return true;
+
+	bool bMayMatch = true;
+
+	switch (m_eOp)
+	{
+		case EQUALS:
+			bMayMatch = oKeys.Contains(m_oValue);
+			break;
+
+		case GREATER:
+			bMayMatch = oKeys.ContainsGreater(m_oValue);
+			break;
+
+		case LESS:
+			bMayMatch = oKeys.ContainsLess(m_oValue);
+			break;
+
+		case NOT_EQUALS:
+			break;
+
+		default:
+			ASSERT_FALSE();
+			break;
+	};
+
+	return bMayMatch;
+}
+
+/******************************************************************************
+** Method:		Describe()
+**
+** Description:	Formats the comparison as text, see CTable::Explain().
+**
+** Parameters:	oTable	The table the query is on.
+**
+** Returns:		The comparison.
+**
+*******************************************************************************
+*/
+
+CString CWhereCmp::Describe(const CTable& oTable) const
+{
+	static const tchar* apszOps[] = { TXT("="), TXT("<>"), TXT(">"), TXT("<") };
+
+	return Core::fmt(TXT("%s %s %s"), oTable.Column(m_nColumn).Name().c_str(), apszOps[m_eOp], formatValue(m_oValue).c_str()).c_str();
+}
@@ -51,6 +51,10 @@ public:
 
 	virtual CWhere* Clone() const;
 
+	virtual bool MayMatch(size_t nColumn, const CPartitionKeys& oKeys) const;
+
+	virtual CString Describe(const CTable& oTable) const;
+
 private:
 	//
 	// Members.
@@ -117,3 +117,95 @@ CWhere* CWhereExp::Clone() const
 {
 	return new CWhereExp(*this);
 }
+
+/******************************************************************************
+** Method:		MayMatch()
+**
+** Description:	Queries if any row of a partition may match, see
+**				CPartitionedTable::Select().
+**
+** Parameters:	nColumn	The partition key column.
+**				oKeys	The key values the partition can hold.
+**
+** Returns:		false if no row in the partition can match, otherwise true.
+**
+*******************************************************************************
+*/
+
+bool CWhereExp::MayMatch(size_t nColumn, const CPartitionKeys& oKeys) const
+{
+	bool bMayMatch = true;
+
+	switch (m_eOp)
+	{
+		case AND:
+			bMayMatch = (m_pLHSWhere->MayMatch(nColumn, oKeys) && m_pRHSWhere->MayMatch(nColumn, oKeys));
+			break;
+
+		case OR:
+			bMayMatch = (m_pLHSWhere->MayMatch(nColumn, oKeys) || m_pRHSWhere->MayMatch(nColumn, oKeys));
+			break;
+
+		default:
+			ASSERT_FALSE();
+			break;
+	};
+
+	return bMayMatch;
+}
+
+/******************************************************************************
+** Method:		Evaluate()
+**
+** Description:	Performs the comparisons, counting those made by each side,
+**				see CTable::Select(). Only the left hand side is evaluated when
+**				it decides the result.
+**
+** Parameters:	oRow			The row to compare to.
+**				nComparisons	The comparison count to add to.
+**
+** Returns:		true or false.
+**
+*******************************************************************************
+*/
+
+bool CWhereExp::Evaluate(const CRow& oRow, size_t& nComparisons) const
+{
+	bool bMatches = false;
+
+	switch (m_eOp)
+	{
+		case AND:
+			bMatches = (m_pLHSWhere->Evaluate(oRow, nComparisons) && m_pRHSWhere->Evaluate(oRow, nComparisons));
+			break;
+
+		case OR:
+			bMatches = (m_pLHSWhere->Evaluate(oRow, nComparisons) || m_pRHSWhere->Evaluate(oRow, nComparisons));
+			break;
+
+		default:
+			ASSERT_FALSE();
+			break;
+	};
+
+	return bMatches;
+}
+
+/******************************************************************************
+** Method:		Describe()
+**
+** Description:	Formats the expression as text, see CTable::Explain().
+**
+** Parameters:	oTable	The table the query is on.
+**
+** Returns:		The expression.
+**
+*******************************************************************************
+*/
+
+CString CWhereExp::Describe(const CTable& oTable) const
+{
+	const tchar* pszOp = (m_eOp == AND) ? TXT("AND") : TXT("OR");
+
+	return Core::fmt(TXT("(%s %s %s)"), m_pLHSWhere->Describe(oTable).c_str(), pszOp, m_pRHSWhere->Describe(oTable).c_str()).c_str();
+}
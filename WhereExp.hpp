@@ -49,6 +49,12 @@ public:
 
 	virtual CWhere* Clone() const;
 
+	virtual bool MayMatch(size_t nColumn, const CPartitionKeys& oKeys) const;
+
+	virtual bool Evaluate(const CRow& oRow, size_t& nComparisons) const;
+
+	virtual CString Describe(const CTable& oTable) const;
+
 private:
 	//
 	// Members.
@@ -11,6 +11,66 @@
 #include "Common.hpp"
 #include "WhereIn.hpp"
 #include "Row.hpp"
+#include "Table.hpp"
+#include "ResultSet.hpp"
+#include "UniqIndex.hpp"
+#include "PartitionKeys.hpp"
+#include <algorithm>
+
+namespace
+{
+
+////////////////////////////////////////////////////////////////////////////////
+//! The case-sensitive string ordering.
+
+struct StrLess
+{
+	bool operator()(const tchar* lhs, const tchar* rhs) const
+	{
+		return (tstrcmp(lhs, rhs) < 0);
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The case-insensitive string ordering.
+
+struct StrILess
+{
+	bool operator()(const tchar* lhs, const tchar* rhs) const
+	{
+		return (tstricmp(lhs, rhs) < 0);
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Sort the values and remove any duplicates.
+
+template<typename T, typename L>
+void sortUnique(std::vector<T>& values, L less)
+{
+	std::sort(values.begin(), values.end(), less);
+
+	size_t count = 0;
+
+	for (size_t i = 0; i != values.size(); ++i)
+	{
+		if ( (count == 0) || less(values[count-1], values[i]) )
+			values[count++] = values[i];
+	}
+
+	values.resize(count);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Sort the values and remove any duplicates.
+
+template<typename T>
+void sortUnique(std::vector<T>& values)
+{
+	sortUnique(values, std::less<T>());
+}
+
+}
 
 /******************************************************************************
 ** Method:		Constructor.
@@ -27,7 +87,17 @@
 CWhereIn::CWhereIn(size_t nColumn, const CValueSet& oValueSet)
 	: m_nColumn(nColumn)
 	, m_oValueSet(oValueSet)
+	, m_bHasNull(false)
+	, m_vInts()
+	, m_vInt64s()
+	, m_vDoubles()
+	, m_vChars()
+	, m_vStrings()
+	, m_vIStrings()
+	, m_vIntKeys()
+	, m_vStrKeys()
 {
+	Compile();
 }
 
 /******************************************************************************
@@ -46,7 +116,18 @@ CWhereIn::CWhereIn(const CWhereIn& oSrc)
 	: CWhere()
 	, m_nColumn(oSrc.m_nColumn)
 	, m_oValueSet(oSrc.m_oValueSet)
+	, m_bHasNull(false)
+	, m_vInts()
+	, m_vInt64s()
+	, m_vDoubles()
+	, m_vChars()
+	, m_vStrings()
+	, m_vIStrings()
+	, m_vIntKeys()
+	, m_vStrKeys()
 {
+	// NB: The strings refer to our copy of the values.
+	Compile();
 }
 
 /******************************************************************************
@@ -65,6 +146,63 @@ CWhereIn::~CWhereIn()
 {
 }
 
+/******************************************************************************
+** Method:		Compile()
+**
+** Description:	Splits the values by storage type into sorted arrays so that
+**				Matches() can use a binary search instead of a linear scan.
+**				Strings are sorted twice as the column decides at match time
+**				whether the comparison is case-sensitive. The values used to
+**				probe a unique index are also built once here.
+**
+** Parameters:	None.
+**
+** Returns:		Nothing.
+**
+*******************************************************************************
+*/
+
+void CWhereIn::Compile()
+{
+	for (size_t i = 0; i < m_oValueSet.Count(); ++i)
+	{
+		const CValue& oValue = m_oValueSet[i];
+
+		if (oValue.m_bNull)
+		{
+			m_bHasNull = true;
+			continue;
+		}
+
+		switch (oValue.m_eType)
+		{
+			case MDST_INT:		m_vInts.push_back(oValue.m_iValue);			break;
+			case MDST_INT64:	m_vInt64s.push_back(oValue.m_i64Value);		break;
+			case MDST_DOUBLE:	m_vDoubles.push_back(oValue.m_dValue);		break;
+			case MDST_CHAR:		m_vChars.push_back(oValue.m_cValue);		break;
+			case MDST_STRING:	m_vStrings.push_back(oValue.m_sValue);		break;
+
+			case MDST_NULL:
+			case MDST_BOOL:
+			case MDST_TIMESTAMP:
+			case MDST_POINTER:
+			default:													break;
+		}
+	}
+
+	m_vIStrings = m_vStrings;
+
+	sortUnique(m_vInts);
+	sortUnique(m_vInt64s);
+	sortUnique(m_vDoubles);
+	sortUnique(m_vChars);
+	sortUnique(m_vStrings,  StrLess());
+	sortUnique(m_vIStrings, StrILess());
+
+	m_vIntKeys.assign(m_vInts.begin(), m_vInts.end());
+	m_vStrKeys.assign(m_vStrings.begin(), m_vStrings.end());
+}
+
 /******************************************************************************
 ** Method:		Matches()
 **
@@ -79,10 +217,46 @@ CWhereIn::~CWhereIn()
 
 bool CWhereIn::Matches(const CRow& oRow) const
 {
+	const CField& oField = oRow[m_nColumn];
+
+	if (oField == null)
+		return m_bHasNull;
+
+	const CColumn& oColumn = oField.Column();
+
+	// Search according to storage type.
+	switch (oColumn.StgType())
+	{
+		case MDST_INT:
+			return std::binary_search(m_vInts.begin(), m_vInts.end(), oField.GetInt());
+
+		case MDST_INT64:
+			return std::binary_search(m_vInt64s.begin(), m_vInt64s.end(), oField.GetInt64());
+
+		case MDST_DOUBLE:
+			return std::binary_search(m_vDoubles.begin(), m_vDoubles.end(), oField.GetDouble());
+
+		case MDST_CHAR:
+			return std::binary_search(m_vChars.begin(), m_vChars.end(), oField.GetChar());
+
+		case MDST_STRING:
+			if (oColumn.Flags() & CColumn::COMPARE_CASE)
+				return std::binary_search(m_vStrings.begin(), m_vStrings.end(), oField.GetString(), StrLess());
+			else
+				return std::binary_search(m_vIStrings.begin(), m_vIStrings.end(), oField.GetString(), StrILess());
+
+		case MDST_NULL:
+		case MDST_BOOL:
+		case MDST_TIMESTAMP:
+		case MDST_POINTER:
+		default:
+			break;
+	}
+
 	// For all values...
 	for (size_t i = 0; i < m_oValueSet.Count(); ++i)
 	{
-		if (oRow[m_nColumn] == m_oValueSet[i])
+		if (oField == m_oValueSet[i])
 			return true;
 	}
 
@@ -105,3 +279,140 @@ CWhere* CWhereIn::Clone() const
 {
 	return new CWhereIn(*this);
 }
+
+/******************************************************************************
+** Method:		SelectIndexed()
+**
+** Description:	Finds the matching rows using one index probe per value. This
+**				is only possible when the column has a unique index that uses
+**				the same string comparison as Matches() and NULL is not in
+**				the set. The rows are returned in value order, which
+**				CTable::Select() puts back into table order.
+**
+** Parameters:	oTable	The table to query.
+**				oRS		The result set to add the rows to.
+**
+** Returns:		true if the index was used, false if a scan is required.
+**
+*******************************************************************************
+*/
+
+bool CWhereIn::SelectIndexed(const CTable& oTable, CResultSet& oRS) const
+{
+	const CUniqIndex* pIndex = UsableIndex(oTable);
+
+	if (pIndex == nullptr)
+		return false;
+
+	const Values& vKeys = (oTable.Column(m_nColumn).StgType() == MDST_INT) ? m_vIntKeys : m_vStrKeys;
+
+	// Probe the index for each value.
+	for (size_t i = 0; i != vKeys.size(); ++i)
+	{
+		CRow* pRow = pIndex->FindRow(vKeys[i]);
+
+		if (pRow != nullptr)
+			oRS.Add(*pRow);
+	}
+
+	return true;
+}
+
+/******************************************************************************
+** Method:		IndexProbes()
+**
+** Description:	Gets the number of index probes SelectIndexed() would make,
+**				see CTable::Explain().
+**
+** Parameters:	oTable	The table to query.
+**
+** Returns:		The number of probes, or 0 if a scan is required.
+**
+*******************************************************************************
+*/
+
+size_t CWhereIn::IndexProbes(const CTable& oTable) const
+{
+	if (UsableIndex(oTable) == nullptr)
+		return 0;
+
+	return (oTable.Column(m_nColumn).StgType() == MDST_INT) ? m_vInts.size() : m_vStrings.size();
+}
+
+/******************************************************************************
+** Method:		Describe()
+**
+** Description:	Formats the comparison as text, see CTable::Explain().
+**
+** Parameters:	oTable	The table the query is on.
+**
+** Returns:		The comparison.
+**
+*******************************************************************************
+*/
+
+CString CWhereIn::Describe(const CTable& oTable) const
+{
+	return Core::fmt(TXT("%s IN (%u values)"), oTable.Column(m_nColumn).Name().c_str(), static_cast<uint>(m_oValueSet.Count())).c_str();
+}
+
+/******************************************************************************
+** Method:		UsableIndex()
+**
+** Description:	Gets the index SelectIndexed() can use. This is only possible
+**				when the column has a unique index on an int or string column
+**				that uses the same string comparison as Matches() and NULL is
+**				not in the set.
+**
+** Parameters:	oTable	The table to query.
+**
+** Returns:		The index, or nullptr if a scan is required.
+**
+*******************************************************************************
+*/
+
+const CUniqIndex* CWhereIn::UsableIndex(const CTable& oTable) const
+{
+	const CColumn& oColumn = oTable.Column(m_nColumn);
+
+	if ( (oColumn.Index() == nullptr) || (!oColumn.Unique()) || (m_bHasNull) )
+		return nullptr;
+
+	if ( (oColumn.StgType() != MDST_INT) && (oColumn.StgType() != MDST_STRING) )
+		return nullptr;
+
+	// The string index is always case-sensitive.
+	if ( (oColumn.StgType() == MDST_STRING) && !(oColumn.Flags() & CColumn::COMPARE_CASE) )
+		return nullptr;
+
+	return static_cast<const CUniqIndex*>(oColumn.Index());
+}
+
+/******************************************************************************
+** Method:		MayMatch()
+**
+** Description:	Queries if any row of a partition may match, see
+**				CPartitionedTable::Select(). A set on the key column rules
+**				out the partitions which hold none of the values.
+**
+** Parameters:	nColumn	The partition key column.
+**				oKeys	The key values the partition can hold.
+**
+** Returns:		false if no row in the partition can match, otherwise true.
+**
+*******************************************************************************
+*/
+
+bool CWhereIn::MayMatch(size_t nColumn, const CPartitionKeys& oKeys) const
+{
+	if (nColumn != m_nColumn)
+		return true;
+
+	for (size_t i = 0; i != m_oValueSet.Count(); ++i)
+	{
+		if (oKeys.Contains(m_oValueSet[i]))
+			return true;
+	}
+
+	return false;
+}
@@ -18,6 +18,7 @@
 
 #include "Where.hpp"
 #include "ValueSet.hpp"
+#include <vector>
 
 /******************************************************************************
 ** 
@@ -43,12 +44,46 @@ public:
 
 	virtual CWhere* Clone() const;
 
+	virtual bool MayMatch(size_t nColumn, const CPartitionKeys& oKeys) const;
+
+	virtual bool SelectIndexed(const CTable& oTable, CResultSet& oRS) const;
+
+	virtual size_t IndexProbes(const CTable& oTable) const;
+
+	virtual CString Describe(const CTable& oTable) const;
+
 private:
+	// Template shorthands.
+	typedef std::vector<int>			Ints;
+	typedef std::vector<int64>			Int64s;
+	typedef std::vector<double>			Doubles;
+	typedef std::vector<tchar>			Chars;
+	typedef std::vector<const tchar*>	Strings;
+	typedef std::vector<CValue>			Values;
+
 	//
 	// Members.
 	//
 	size_t		m_nColumn;		// The column to check.
 	CValueSet	m_oValueSet;	// The values to match.
+	bool		m_bHasNull;		// Does the set contain NULL?
+	Ints		m_vInts;		// The sorted MDST_INT values.
+	Int64s		m_vInt64s;		// The sorted MDST_INT64 values.
+	Doubles		m_vDoubles;		// The sorted MDST_DOUBLE values.
+	Chars		m_vChars;		// The sorted MDST_CHAR values.
+	Strings		m_vStrings;		// The MDST_STRING values, sorted by case.
+	Strings		m_vIStrings;	// The MDST_STRING values, sorted ignoring case.
+	Values		m_vIntKeys;		// The MDST_INT index probe values.
+	Values		m_vStrKeys;		// The MDST_STRING index probe values.
+
+	//
+	// Internal methods.
+	//
+	void Compile();
+	const CUniqIndex* UsableIndex(const CTable& oTable) const;
+
+	// Disallow assignment.
+	void operator=(const CWhereIn& oWhere);
 };
 
 /******************************************************************************
@@ -96,3 +96,39 @@ CWhere* CWhereNot::Clone() const
 {
 	return new CWhereNot(*this);
 }
+
+/******************************************************************************
+** Method:		Evaluate()
+**
+** Description:	Performs the comparisons, counting those made, see
+**				CTable::Select().
+**
+** Parameters:	oRow			The row to compare to.
+**				nComparisons	The comparison count to add to.
+**
+** Returns:		true or false.
+**
+*******************************************************************************
+*/
+
+bool CWhereNot::Evaluate(const CRow& oRow, size_t& nComparisons) const
+{
+	return !m_pWhere->Evaluate(oRow, nComparisons);
+}
+
+/******************************************************************************
+** Method:		Describe()
+**
+** Description:	Formats the expression as text, see CTable::Explain().
+**
+** Parameters:	oTable	The table the query is on.
+**
+** Returns:		The expression.
+**
+*******************************************************************************
+*/
+
+CString CWhereNot::Describe(const CTable& oTable) const
+{
+	return Core::fmt(TXT("NOT %s"), m_pWhere->Describe(oTable).c_str()).c_str();
+}
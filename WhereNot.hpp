@@ -42,6 +42,10 @@ public:
 
 	virtual CWhere* Clone() const;
 
+	virtual bool Evaluate(const CRow& oRow, size_t& nComparisons) const;
+
+	virtual CString Describe(const CTable& oTable) const;
+
 private:
 	//
 	// Members.
@@ -0,0 +1,290 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   WorkerPool.cpp
+//! \brief  The CWorkerPool class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "WorkerPool.hpp"
+#include "MDBException.hpp"
+#include "SQLException.hpp"
+#include <process.h>
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor. If the number of threads is zero, one thread is created for
+//! each logical processor.
+
+CWorkerPool::CWorkerPool(size_t nThreads)
+	: m_nThreads((nThreads != 0) ? nThreads : ProcessorCount())
+	, m_vQueues()
+	, m_vWorkers()
+	, m_vThreads()
+	, m_hWork(::CreateSemaphore(nullptr, 0, LONG_MAX, nullptr))
+	, m_nStop(FALSE)
+	, m_nNext(0)
+{
+	ASSERT(m_nThreads != 0);
+	ASSERT(m_hWork != NULL);
+
+	m_vQueues.reserve(m_nThreads);
+	m_vWorkers.resize(m_nThreads);
+	m_vThreads.reserve(m_nThreads);
+
+	// Create the queues.
+	for (size_t i = 0; i != m_nThreads; ++i)
+	{
+		Queue* pQueue = new Queue;
+
+		::InitializeCriticalSection(&pQueue->m_oLock);
+
+		m_vQueues.push_back(pQueue);
+	}
+
+	// Start the workers.
+	for (size_t i = 0; i != m_nThreads; ++i)
+	{
+		m_vWorkers[i].m_pPool  = this;
+		m_vWorkers[i].m_nQueue = i;
+
+		uintptr_t hThread = ::_beginthreadex(nullptr, 0, ThreadFn, &m_vWorkers[i], 0, nullptr);
+
+		ASSERT(hThread != 0);
+
+		m_vThreads.push_back(reinterpret_cast<HANDLE>(hThread));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+CWorkerPool::~CWorkerPool()
+{
+	// Signal the workers to stop and wake them all.
+	::InterlockedExchange(&m_nStop, TRUE);
+	::ReleaseSemaphore(m_hWork, static_cast<LONG>(m_nThreads), nullptr);
+
+	for (size_t i = 0; i != m_vThreads.size(); ++i)
+	{
+		::WaitForSingleObject(m_vThreads[i], INFINITE);
+		::CloseHandle(m_vThreads[i]);
+	}
+
+	for (size_t i = 0; i != m_vQueues.size(); ++i)
+	{
+		ASSERT(m_vQueues[i]->m_oJobs.empty());
+
+		::DeleteCriticalSection(&m_vQueues[i]->m_oLock);
+		delete m_vQueues[i];
+	}
+
+	::CloseHandle(m_hWork);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Execute the batch of tasks and wait for them all to complete. The tasks are
+//! dealt out across the worker queues and the calling thread then helps to
+//! drain them. If any task throws, the first exception is rethrown on the
+//! calling thread once the entire batch has finished.
+
+void CWorkerPool::Execute(CWorkerTask* apTasks[], size_t nTasks)
+{
+	// Nothing to do?
+	if (nTasks == 0)
+		return;
+
+	Batch oBatch;
+
+	oBatch.m_nPending  = static_cast<LONG>(nTasks);
+	oBatch.m_nFailed   = 0;
+	oBatch.m_pMDBError = nullptr;
+	oBatch.m_pSQLError = nullptr;
+	oBatch.m_hDone     = ::CreateEvent(nullptr, TRUE, FALSE, nullptr);
+
+	ASSERT(oBatch.m_hDone != NULL);
+
+	// Deal the tasks out across the queues.
+	size_t nFirst = static_cast<size_t>(::InterlockedIncrement(&m_nNext));
+
+	for (size_t i = 0; i != nTasks; ++i)
+	{
+		Queue& oQueue = *m_vQueues[(nFirst + i) % m_nThreads];
+		Job    oJob   = { apTasks[i], &oBatch };
+
+		::EnterCriticalSection(&oQueue.m_oLock);
+		oQueue.m_oJobs.push_back(oJob);
+		::LeaveCriticalSection(&oQueue.m_oLock);
+	}
+
+	::ReleaseSemaphore(m_hWork, static_cast<LONG>(nTasks), nullptr);
+
+	Job oJob;
+
+	// Help out until there is nothing left to steal.
+	while ( (oBatch.m_nPending != 0) && PopJob(nFirst % m_nThreads, oJob) )
+		RunJob(oJob);
+
+	::WaitForSingleObject(oBatch.m_hDone, INFINITE);
+	::CloseHandle(oBatch.m_hDone);
+
+	if (oBatch.m_nFailed != 0)
+		ThrowError(oBatch);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the process wide pool. This is created on first use and sized to the
+//! number of logical processors.
+
+CWorkerPool& CWorkerPool::Default()
+{
+	static CWorkerPool* volatile s_pPool = nullptr;
+
+	if (s_pPool == nullptr)
+	{
+		CWorkerPool* pPool = new CWorkerPool();
+
+		// Lost the race to create it?
+		if (::InterlockedCompareExchangePointer(reinterpret_cast<PVOID volatile*>(&s_pPool), pPool, nullptr) != nullptr)
+			delete pPool;
+	}
+
+	return *s_pPool;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of logical processors.
+
+size_t CWorkerPool::ProcessorCount()
+{
+	SYSTEM_INFO oInfo;
+
+	memset(&oInfo, 0, sizeof(oInfo));
+
+	::GetSystemInfo(&oInfo);
+
+	return (oInfo.dwNumberOfProcessors != 0) ? oInfo.dwNumberOfProcessors : 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Try and dequeue a job. The front of the given queue is tried first and then
+//! the back of each of the others in turn.
+
+bool CWorkerPool::PopJob(size_t nQueue, Job& oJob)
+{
+	for (size_t i = 0; i != m_nThreads; ++i)
+	{
+		Queue& oQueue = *m_vQueues[(nQueue + i) % m_nThreads];
+		bool   bFound = false;
+
+		::EnterCriticalSection(&oQueue.m_oLock);
+
+		if (!oQueue.m_oJobs.empty())
+		{
+			// Own queue?
+			if (i == 0)
+			{
+				oJob = oQueue.m_oJobs.front();
+				oQueue.m_oJobs.pop_front();
+			}
+			// Steal.
+			else
+			{
+				oJob = oQueue.m_oJobs.back();
+				oQueue.m_oJobs.pop_back();
+			}
+
+			bFound = true;
+		}
+
+		::LeaveCriticalSection(&oQueue.m_oLock);
+
+		if (bFound)
+			return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Run the job and signal its batch if it was the last one.
+
+void CWorkerPool::RunJob(const Job& oJob)
+{
+	Batch* pBatch = oJob.m_pBatch;
+
+	try
+	{
+		oJob.m_pTask->Run();
+	}
+	catch (const CMDBException& e)
+	{
+		// First failure?
+		if (::InterlockedIncrement(&pBatch->m_nFailed) == 1)
+			pBatch->m_pMDBError = new CMDBException(e);
+	}
+	catch (const CSQLException& e)
+	{
+		// First failure?
+		if (::InterlockedIncrement(&pBatch->m_nFailed) == 1)
+			pBatch->m_pSQLError = new CSQLException(e);
+	}
+	catch (...)
+	{
+		::InterlockedIncrement(&pBatch->m_nFailed);
+	}
+
+	if (::InterlockedDecrement(&pBatch->m_nPending) == 0)
+		::SetEvent(pBatch->m_hDone);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Rethrow the first exception thrown by a task in the batch. An exception of
+//! any other type is reported as a generic task failure.
+
+void CWorkerPool::ThrowError(Batch& oBatch)
+{
+	ASSERT(oBatch.m_nFailed != 0);
+
+	if (oBatch.m_pMDBError != nullptr)
+	{
+		CMDBException e(*oBatch.m_pMDBError);
+
+		delete oBatch.m_pMDBError;
+
+		throw e;
+	}
+
+	if (oBatch.m_pSQLError != nullptr)
+	{
+		CSQLException e(*oBatch.m_pSQLError);
+
+		delete oBatch.m_pSQLError;
+
+		throw e;
+	}
+
+	throw CMDBException(CMDBException::E_TASK_FAILED, TXT("One or more tasks threw an exception"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The worker thread entry point.
+
+unsigned __stdcall CWorkerPool::ThreadFn(void* pParam)
+{
+	Worker&      oWorker = *static_cast<Worker*>(pParam);
+	CWorkerPool& oPool   = *oWorker.m_pPool;
+
+	for (;;)
+	{
+		::WaitForSingleObject(oPool.m_hWork, INFINITE);
+
+		if (oPool.m_nStop)
+			break;
+
+		Job oJob;
+
+		// NB: The job may already have been taken by a submitting thread.
+		if (oPool.PopJob(oWorker.m_nQueue, oJob))
+			RunJob(oJob);
+	}
+
+	return 0;
+}
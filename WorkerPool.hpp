@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   WorkerPool.hpp
+//! \brief  The CWorkerPool class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef MDBL_WORKERPOOL_HPP
+#define MDBL_WORKERPOOL_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <vector>
+#include <deque>
+
+// Forward declarations.
+class CMDBException;
+class CSQLException;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The base class for a unit of work that can be executed by the worker pool.
+
+class CWorkerTask
+{
+public:
+	//! Destructor.
+	virtual ~CWorkerTask();
+
+	//! Execute the task.
+	virtual void Run() = 0;
+
+protected:
+	//! Default constructor.
+	CWorkerTask();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! A fixed size pool of worker threads which execute batches of tasks. Each
+//! worker owns a queue of tasks and when it runs dry it steals from the back
+//! of the other workers queues so that uneven chunks are balanced out. The
+//! thread that submits a batch also helps execute it, which means that a task
+//! can itself submit a nested batch without deadlocking the pool.
+
+class CWorkerPool /*: private NotCopyable*/
+{
+public:
+	//! Constructor.
+	CWorkerPool(size_t nThreads = 0);
+
+	//! Destructor.
+	~CWorkerPool();
+
+	//
+	// Properties.
+	//
+
+	//! Get the number of worker threads.
+	size_t ThreadCount() const;
+
+	//
+	// Methods.
+	//
+
+	//! Execute the batch of tasks and wait for them all to complete.
+	void Execute(CWorkerTask* apTasks[], size_t nTasks);
+
+	//
+	// Class methods.
+	//
+
+	//! Get the process wide pool.
+	static CWorkerPool& Default();
+
+	//! Get the number of logical processors.
+	static size_t ProcessorCount();
+
+private:
+	//! The shared state for a batch of tasks.
+	struct Batch
+	{
+		volatile LONG	m_nPending;		//!< The number of tasks still to complete.
+		volatile LONG	m_nFailed;		//!< The number of tasks that threw.
+		CMDBException*	m_pMDBError;	//!< The first task exception, if a CMDBException.
+		CSQLException*	m_pSQLError;	//!< The first task exception, if a CSQLException.
+		HANDLE			m_hDone;		//!< Signalled when all tasks are complete.
+	};
+
+	//! A task queued for execution.
+	struct Job
+	{
+		CWorkerTask*	m_pTask;		//!< The task to run.
+		Batch*			m_pBatch;		//!< The batch it belongs to.
+	};
+
+	//! A single workers queue of jobs.
+	struct Queue
+	{
+		CRITICAL_SECTION	m_oLock;	//!< The queue lock.
+		std::deque<Job>		m_oJobs;	//!< The queued jobs.
+	};
+
+	//! The parameters passed to a worker thread.
+	struct Worker
+	{
+		CWorkerPool*	m_pPool;		//!< The owning pool.
+		size_t			m_nQueue;		//!< The workers own queue.
+	};
+
+	//
+	// Members.
+	//
+	size_t				m_nThreads;		//!< The number of worker threads.
+	std::vector<Queue*>	m_vQueues;		//!< The per-worker queues.
+	std::vector<Worker>	m_vWorkers;		//!< The per-worker parameters.
+	std::vector<HANDLE>	m_vThreads;		//!< The worker thread handles.
+	HANDLE				m_hWork;		//!< Counts the number of queued jobs.
+	volatile LONG		m_nStop;		//!< Flag to stop the workers.
+	volatile LONG		m_nNext;		//!< The next queue to submit to.
+
+	//
+	// Internal methods.
+	//
+
+	//! Try and dequeue a job, starting with the given queue.
+	bool PopJob(size_t nQueue, Job& oJob);
+
+	//! Run the job and signal its batch if it was the last one.
+	static void RunJob(const Job& oJob);
+
+	//! Rethrow the first exception thrown by a task in the batch.
+	static void ThrowError(Batch& oBatch);
+
+	//! The worker thread entry point.
+	static unsigned __stdcall ThreadFn(void* pParam);
+
+private:
+	// NotCopyable.
+	CWorkerPool(const CWorkerPool&);
+	CWorkerPool& operator=(const CWorkerPool&);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+inline CWorkerTask::CWorkerTask()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+inline CWorkerTask::~CWorkerTask()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of worker threads.
+
+inline size_t CWorkerPool::ThreadCount() const
+{
+	return m_nThreads;
+}
+
+#endif // MDBL_WORKERPOOL_HPP